@@ -0,0 +1,390 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+Arena::Arena(size_t block_size, std::pmr::memory_resource *upstream)
+    : block_size_(block_size), upstream_(upstream)
+{
+    if (block_size == 0)
+    {
+        throw std::invalid_argument("Arena block size must be positive");
+    }
+}
+
+Arena::~Arena()
+{
+    release();
+}
+
+Arena::Block *Arena::newBlock(size_t size)
+{
+    void *memory = upstream_->allocate(sizeof(Block) + size, alignof(std::max_align_t));
+    memory_usage_ += sizeof(Block) + size;
+    return new (memory) Block{nullptr, size};
+}
+
+void Arena::startBlock(Block *block) noexcept
+{
+    block->next = blocks_;
+    blocks_ = block;
+    cursor_ = blockData(block);
+    limit_ = cursor_ + block->size;
+}
+
+void Arena::freeBlocks(Block *blocks) noexcept
+{
+    while (blocks)
+    {
+        Block *next = blocks->next;
+        memory_usage_ -= sizeof(Block) + blocks->size;
+        upstream_->deallocate(blocks, sizeof(Block) + blocks->size, alignof(std::max_align_t));
+        blocks = next;
+    }
+}
+
+void *Arena::allocateSlow(size_t bytes, size_t alignment)
+{
+    // The fast path leaves exact fits to here
+    uintptr_t aligned = alignUp(reinterpret_cast<uintptr_t>(cursor_), alignment);
+    if (blocks_ && aligned <= reinterpret_cast<uintptr_t>(limit_) &&
+        bytes <= reinterpret_cast<uintptr_t>(limit_) - aligned)
+    {
+        cursor_ = reinterpret_cast<std::byte *>(aligned + bytes);
+        return reinterpret_cast<void *>(aligned);
+    }
+    if (bytes > std::numeric_limits<size_t>::max() - sizeof(Block) - alignment)
+    {
+        throw std::bad_alloc();
+    }
+
+    // Large allocations get a block of their own, so the current block is not abandoned
+    // with much of it unused
+    if (bytes + alignment > block_size_ / 4)
+    {
+        Block *block = newBlock(bytes + alignment);
+        block->next = large_;
+        large_ = block;
+        retired_ += bytes + alignment;
+        return reinterpret_cast<void *>(alignUp(reinterpret_cast<uintptr_t>(blockData(block)), alignment));
+    }
+
+    if (blocks_)
+    {
+        retired_ += static_cast<size_t>(cursor_ - blockData(blocks_));
+    }
+    startBlock(newBlock(block_size_));
+    aligned = alignUp(reinterpret_cast<uintptr_t>(cursor_), alignment);
+    cursor_ = reinterpret_cast<std::byte *>(aligned + bytes);
+    return reinterpret_cast<void *>(aligned);
+}
+
+void Arena::reset() noexcept
+{
+    size_t used = bytesAllocated();
+    if (blocks_ && !blocks_->next && !large_)
+    {
+        cursor_ = blockData(blocks_);
+    }
+    else if (used > 0)
+    {
+        // Replace the blocks of this cycle by one the whole cycle fits in. If the upstream
+        // resource cannot provide it, the arena starts over with no blocks at all.
+        release();
+        size_t size = (used + block_size_ - 1) / block_size_ * block_size_;
+        try
+        {
+            startBlock(newBlock(size));
+        }
+        catch (...)
+        {
+        }
+    }
+    retired_ = 0;
+}
+
+void Arena::release() noexcept
+{
+    freeBlocks(blocks_);
+    freeBlocks(large_);
+    blocks_ = nullptr;
+    large_ = nullptr;
+    cursor_ = nullptr;
+    limit_ = nullptr;
+    retired_ = 0;
+}
+
+size_t Arena::bytesAllocated() const noexcept
+{
+    return retired_ + (blocks_ ? static_cast<size_t>(cursor_ - blockData(blocks_)) : 0);
+}
+
+namespace
+{
+    struct FreeObject
+    {
+        FreeObject *next;
+    };
+
+    /**
+     * @brief An intrusive list of free objects of one size class.
+     */
+    struct FreeList
+    {
+        FreeObject *head = nullptr;
+        size_t count = 0;
+
+        void push(void *pointer) noexcept
+        {
+            auto *object = static_cast<FreeObject *>(pointer);
+            object->next = head;
+            head = object;
+            ++count;
+        }
+
+        void *pop() noexcept
+        {
+            FreeObject *object = head;
+            head = object->next;
+            --count;
+            return object;
+        }
+    };
+
+    /// Slabs are aligned to the largest size class, so every object is aligned to its size
+    constexpr size_t kSlabAlignment = PoolAllocator::kMaxPooledSize;
+
+    size_t sizeClass(size_t size) noexcept
+    {
+        return static_cast<size_t>(std::bit_width(size - 1)) - 4;
+    }
+
+    size_t classSize(size_t size_class) noexcept
+    {
+        return PoolAllocator::kMinPooledSize << size_class;
+    }
+
+    /**
+     * @brief Objects a thread cache takes from or gives back to the pool at once: about
+     * 16KB worth, between 4 and 128 objects.
+     */
+    size_t batchSize(size_t size_class) noexcept
+    {
+        return std::clamp<size_t>(16 * 1024 / classSize(size_class), 4, 128);
+    }
+
+    std::atomic<uint64_t> next_pool_id{1};
+} // namespace
+
+namespace arena_detail
+{
+    struct PoolShared
+    {
+        explicit PoolShared(std::pmr::memory_resource *upstream)
+            : upstream(upstream), id(next_pool_id.fetch_add(1, std::memory_order_relaxed))
+        {
+        }
+
+        ~PoolShared()
+        {
+            for (void *slab : slabs)
+            {
+                upstream->deallocate(slab, PoolAllocator::kSlabSize, kSlabAlignment);
+            }
+        }
+
+        /**
+         * @brief Moves `count` objects of a size class to `list`, from the objects given
+         * back by other threads first, then from the unused part of the newest slab.
+         */
+        void refill(size_t size_class, FreeList &list, size_t count)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            FreeList &free = lists[size_class];
+            for (; count > 0 && free.head; --count)
+            {
+                list.push(free.pop());
+            }
+            size_t size = classSize(size_class);
+            for (; count > 0; --count)
+            {
+                if (carve[size_class] == carve_end[size_class])
+                {
+                    slabs.reserve(slabs.size() + 1);
+                    auto *slab = static_cast<std::byte *>(upstream->allocate(PoolAllocator::kSlabSize, kSlabAlignment));
+                    slabs.push_back(slab);
+                    memory_usage.fetch_add(PoolAllocator::kSlabSize, std::memory_order_relaxed);
+                    carve[size_class] = slab;
+                    carve_end[size_class] = slab + PoolAllocator::kSlabSize;
+                }
+                list.push(carve[size_class]);
+                carve[size_class] += size;
+            }
+        }
+
+        /**
+         * @brief Moves `count` objects from the front of `list` to the shared list.
+         */
+        void release(size_t size_class, FreeList &list, size_t count) noexcept
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (; count > 0; --count)
+            {
+                lists[size_class].push(list.pop());
+            }
+        }
+
+        std::pmr::memory_resource *upstream;
+        uint64_t id;
+        std::atomic<size_t> memory_usage{0};
+
+        std::mutex mutex;
+        FreeList lists[PoolAllocator::kNumClasses];
+        std::byte *carve[PoolAllocator::kNumClasses] = {};
+        std::byte *carve_end[PoolAllocator::kNumClasses] = {};
+        std::vector<void *> slabs;
+    };
+} // namespace arena_detail
+
+using arena_detail::PoolShared;
+
+namespace
+{
+    /**
+     * @brief The free lists of one thread for one pool.
+     */
+    struct ThreadCache
+    {
+        uint64_t id;
+        std::weak_ptr<PoolShared> shared;
+        FreeList lists[PoolAllocator::kNumClasses];
+    };
+
+    /**
+     * @brief The caches of one thread, for every pool it used. On thread exit the objects
+     * go back to the pools that still exist.
+     */
+    class ThreadCaches
+    {
+    public:
+        ~ThreadCaches();
+
+        ThreadCache &find(const std::shared_ptr<PoolShared> &shared)
+        {
+            if (last_ && last_->id == shared->id)
+            {
+                return *last_;
+            }
+            for (auto &cache : caches_)
+            {
+                if (cache->id == shared->id)
+                {
+                    last_ = cache.get();
+                    return *last_;
+                }
+            }
+            // The objects in the caches of destroyed pools went with the pools' slabs
+            std::erase_if(caches_, [](const auto &cache)
+                          { return cache->shared.expired(); });
+            caches_.push_back(std::make_unique<ThreadCache>());
+            last_ = caches_.back().get();
+            last_->id = shared->id;
+            last_->shared = shared;
+            return *last_;
+        }
+
+    private:
+        std::vector<std::unique_ptr<ThreadCache>> caches_;
+        ThreadCache *last_ = nullptr;
+    };
+
+    thread_local ThreadCaches thread_caches;
+
+    /// Set once the thread's caches are destroyed; later calls on the thread, from the
+    /// destructors of other thread locals, go to the shared lists directly
+    thread_local bool thread_caches_destroyed = false;
+
+    ThreadCaches::~ThreadCaches()
+    {
+        thread_caches_destroyed = true;
+        for (auto &cache : caches_)
+        {
+            if (std::shared_ptr<PoolShared> shared = cache->shared.lock())
+            {
+                for (size_t size_class = 0; size_class < PoolAllocator::kNumClasses; ++size_class)
+                {
+                    shared->release(size_class, cache->lists[size_class], cache->lists[size_class].count);
+                }
+            }
+        }
+    }
+} // namespace
+
+PoolAllocator::PoolAllocator(std::pmr::memory_resource *upstream)
+    : shared_(std::make_shared<PoolShared>(upstream))
+{
+}
+
+PoolAllocator::~PoolAllocator() = default;
+
+size_t PoolAllocator::memoryUsage() const noexcept
+{
+    return shared_->memory_usage.load(std::memory_order_relaxed);
+}
+
+std::pmr::memory_resource *PoolAllocator::upstream() const noexcept
+{
+    return shared_->upstream;
+}
+
+void *PoolAllocator::do_allocate(size_t bytes, size_t alignment)
+{
+    size_t size = std::max({bytes, alignment, kMinPooledSize});
+    if (size > kMaxPooledSize)
+    {
+        return shared_->upstream->allocate(bytes, alignment);
+    }
+    size_t size_class = sizeClass(size);
+    if (thread_caches_destroyed)
+    {
+        FreeList list;
+        shared_->refill(size_class, list, 1);
+        return list.pop();
+    }
+    FreeList &list = thread_caches.find(shared_).lists[size_class];
+    if (!list.head)
+    {
+        shared_->refill(size_class, list, batchSize(size_class));
+    }
+    return list.pop();
+}
+
+void PoolAllocator::do_deallocate(void *pointer, size_t bytes, size_t alignment)
+{
+    size_t size = std::max({bytes, alignment, kMinPooledSize});
+    if (size > kMaxPooledSize)
+    {
+        shared_->upstream->deallocate(pointer, bytes, alignment);
+        return;
+    }
+    size_t size_class = sizeClass(size);
+    if (thread_caches_destroyed)
+    {
+        FreeList list;
+        list.push(pointer);
+        shared_->release(size_class, list, 1);
+        return;
+    }
+    FreeList &list = thread_caches.find(shared_).lists[size_class];
+    list.push(pointer);
+    // Past two batches, one batch goes back for other threads to use
+    size_t batch = batchSize(size_class);
+    if (list.count > 2 * batch)
+    {
+        shared_->release(size_class, list, batch);
+    }
+}
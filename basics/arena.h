@@ -0,0 +1,222 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <new>
+
+namespace arena_detail
+{
+    struct PoolShared;
+} // namespace arena_detail
+
+/**
+ * @brief A monotonic memory resource: allocations bump a pointer through large blocks and
+ * are only given back all at once, by reset() or by destroying the arena.
+ *
+ * Meant for memory whose lifetime ends at a known point, like everything decoded for one
+ * batch or row group: allocate freely while working on it, then reset() before the next
+ * one. A cycle that needed more than one block leaves the arena with a single block big
+ * enough for all of it, so once the cycles reach their steady state size an allocation
+ * is a pointer bump and reset() is an assignment.
+ *
+ * Usable as a std::pmr::memory_resource (e.g. with std::pmr containers) and, through
+ * ResourceAllocator, as an STL allocator that inlines the bump. Not thread-safe.
+ */
+class Arena final : public std::pmr::memory_resource
+{
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+    /**
+     * @param block_size Bytes of the blocks taken from `upstream`; allocations above a
+     * quarter of it get a block of their own
+     */
+    explicit Arena(size_t block_size = kDefaultBlockSize,
+                   std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+    ~Arena() override;
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @param alignment A power of two
+     * @return `bytes` bytes aligned to `alignment`, valid until the next reset()
+     */
+    void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))
+    {
+        auto limit = reinterpret_cast<uintptr_t>(limit_);
+        uintptr_t aligned = alignUp(reinterpret_cast<uintptr_t>(cursor_), alignment);
+        // Strict, so that an arena without blocks (both pointers null) takes the slow path
+        if (aligned < limit && bytes < limit - aligned)
+        {
+            cursor_ = reinterpret_cast<std::byte *>(aligned + bytes);
+            return reinterpret_cast<void *>(aligned);
+        }
+        return allocateSlow(bytes, alignment);
+    }
+
+    /**
+     * @brief Does nothing: the memory is reclaimed by reset().
+     */
+    void deallocate(void *, size_t, size_t = alignof(std::max_align_t)) noexcept {}
+
+    /**
+     * @brief Gives back every allocation at once. Keeps the memory for the next cycle.
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief Returns all memory to the upstream resource.
+     */
+    void release() noexcept;
+
+    /**
+     * @brief Bytes handed out since the last reset(), alignment padding included.
+     */
+    size_t bytesAllocated() const noexcept;
+
+    /**
+     * @brief Bytes held from the upstream resource.
+     */
+    size_t memoryUsage() const noexcept { return memory_usage_; }
+
+    size_t blockSize() const noexcept { return block_size_; }
+    std::pmr::memory_resource *upstream() const noexcept { return upstream_; }
+
+private:
+    struct Block
+    {
+        Block *next;
+        size_t size;
+    };
+
+    void *do_allocate(size_t bytes, size_t alignment) override { return allocate(bytes, alignment); }
+    void do_deallocate(void *, size_t, size_t) override {}
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    static uintptr_t alignUp(uintptr_t address, size_t alignment) noexcept
+    {
+        return (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    }
+
+    static std::byte *blockData(Block *block) noexcept { return reinterpret_cast<std::byte *>(block + 1); }
+
+    void *allocateSlow(size_t bytes, size_t alignment);
+    Block *newBlock(size_t size);
+    void startBlock(Block *block) noexcept;
+    void freeBlocks(Block *blocks) noexcept;
+
+    size_t block_size_;
+    std::pmr::memory_resource *upstream_;
+
+    /// The blocks allocations bump through, the current one first
+    Block *blocks_ = nullptr;
+    /// Blocks of a single large allocation each
+    Block *large_ = nullptr;
+    std::byte *cursor_ = nullptr;
+    std::byte *limit_ = nullptr;
+
+    /// Bytes handed out from blocks other than the current one since the last reset(), and
+    /// the sizes of the large allocations
+    size_t retired_ = 0;
+    size_t memory_usage_ = 0;
+};
+
+/**
+ * @brief A memory resource for many small allocations of varying lifetimes, like the
+ * nodes of a container, made cheap by size classes and per-thread caches.
+ *
+ * Sizes up to kMaxPooledSize are rounded up to a power of two, each size class carving
+ * its objects out of slabs taken from the upstream resource. Every thread keeps a short
+ * free list per class, so most allocations and deallocations touch no lock and no memory
+ * shared with other threads; the lists move objects to and from the pool's shared lists
+ * in batches. Larger sizes go straight to the upstream resource.
+ *
+ * Memory may be deallocated by a different thread than the one that allocated it. Slabs
+ * are only returned to the upstream resource when the pool is destroyed, which must not
+ * happen while other threads are still using it.
+ */
+class PoolAllocator final : public std::pmr::memory_resource
+{
+public:
+    static constexpr size_t kMinPooledSize = 16;
+    static constexpr size_t kMaxPooledSize = 4096;
+    static constexpr size_t kNumClasses = 9;
+    static constexpr size_t kSlabSize = 64 * 1024;
+
+    explicit PoolAllocator(std::pmr::memory_resource *upstream = std::pmr::new_delete_resource());
+    ~PoolAllocator() override;
+
+    PoolAllocator(const PoolAllocator &) = delete;
+    PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+    /**
+     * @brief Bytes held from the upstream resource by the size classes, not counting the
+     * allocations above kMaxPooledSize.
+     */
+    size_t memoryUsage() const noexcept;
+
+    std::pmr::memory_resource *upstream() const noexcept;
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+
+    /// Shared with the thread caches, which may outlive the pool
+    std::shared_ptr<arena_detail::PoolShared> shared_;
+};
+
+/**
+ * @brief An STL allocator drawing from a memory resource.
+ *
+ * Works like std::pmr::polymorphic_allocator, except that with a concrete `Resource` such
+ * as Arena the calls are not virtual, so an arena allocation inlines to a pointer bump.
+ * Copies and rebound copies share the resource, which must outlive them; allocators
+ * compare equal when their resources are the same object.
+ */
+template <typename T, typename Resource = std::pmr::memory_resource>
+class ResourceAllocator
+{
+public:
+    using value_type = T;
+
+    ResourceAllocator(Resource *resource) noexcept : resource_(resource) {}
+
+    template <typename U>
+    ResourceAllocator(const ResourceAllocator<U, Resource> &other) noexcept : resource_(other.resource()) {}
+
+    T *allocate(size_t n)
+    {
+        if (n > std::numeric_limits<size_t>::max() / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *pointer, size_t n) noexcept
+    {
+        resource_->deallocate(pointer, n * sizeof(T), alignof(T));
+    }
+
+    Resource *resource() const noexcept { return resource_; }
+
+    template <typename U>
+    bool operator==(const ResourceAllocator<U, Resource> &other) const noexcept
+    {
+        return resource_ == other.resource();
+    }
+
+private:
+    Resource *resource_;
+};
+
+/**
+ * @brief STL allocator bumping through an Arena.
+ */
+template <typename T>
+using ArenaAllocator = ResourceAllocator<T, Arena>;
@@ -0,0 +1,161 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "arena.h"
+#include "benchmark_data.h"
+#include "flat_hash_map.h"
+#include "simple_list.h"
+
+// Allocation cost of the basics containers with the global heap, an Arena (reset after
+// every container) and a PoolAllocator: building and destroying a SimpleList of 1024
+// elements, one node allocation each, and a FlatHashMap of 1024 entries, a growing table.
+// The "Churn" benchmarks allocate and free objects of 16 to 512 bytes from 1 to 8
+// threads, keeping 1024 of them alive per thread, with the heap and with one shared pool.
+
+namespace
+{
+    constexpr int kElements = 1024;
+
+    template <typename Allocator>
+    void buildList(const Allocator &allocator)
+    {
+        SimpleList<int, Allocator> list(allocator);
+        for (int i = 0; i < kElements; ++i)
+        {
+            list.pushFront(i);
+        }
+        benchmark::DoNotOptimize(list.front());
+    }
+
+    template <typename Allocator>
+    void buildMap(const Allocator &allocator)
+    {
+        FlatHashMap<int, int, std::hash<int>, std::equal_to<int>, Allocator> map(allocator);
+        for (int i = 0; i < kElements; ++i)
+        {
+            map.tryEmplace(i, i);
+        }
+        benchmark::DoNotOptimize(map.size());
+    }
+
+    template <typename Allocate, typename Deallocate>
+    void churn(benchmark::State &state, Allocate allocate, Deallocate deallocate)
+    {
+        DataGenerator random(static_cast<uint64_t>(state.thread_index()) + 1);
+        std::vector<std::pair<void *, size_t>> live(kElements, {nullptr, 0});
+        for (auto _ : state)
+        {
+            auto &slot = live[random.uniform(kElements)];
+            if (slot.first)
+            {
+                deallocate(slot.first, slot.second);
+            }
+            slot.second = size_t{16} << random.uniform(6);
+            slot.first = allocate(slot.second);
+            benchmark::DoNotOptimize(slot.first);
+        }
+        for (auto &[pointer, size] : live)
+        {
+            if (pointer)
+            {
+                deallocate(pointer, size);
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    PoolAllocator shared_pool;
+} // namespace
+
+static void BM_ListHeap(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        buildList(std::allocator<int>());
+    }
+    state.SetItemsProcessed(kElements * state.iterations());
+}
+BENCHMARK(BM_ListHeap);
+
+static void BM_ListArena(benchmark::State &state)
+{
+    Arena arena;
+    for (auto _ : state)
+    {
+        buildList(ArenaAllocator<int>(&arena));
+        arena.reset();
+    }
+    state.SetItemsProcessed(kElements * state.iterations());
+}
+BENCHMARK(BM_ListArena);
+
+static void BM_ListPool(benchmark::State &state)
+{
+    PoolAllocator pool;
+    for (auto _ : state)
+    {
+        buildList(ResourceAllocator<int>(&pool));
+    }
+    state.SetItemsProcessed(kElements * state.iterations());
+}
+BENCHMARK(BM_ListPool);
+
+static void BM_MapHeap(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        buildMap(std::allocator<std::pair<const int, int>>());
+    }
+    state.SetItemsProcessed(kElements * state.iterations());
+}
+BENCHMARK(BM_MapHeap);
+
+static void BM_MapArena(benchmark::State &state)
+{
+    Arena arena;
+    for (auto _ : state)
+    {
+        buildMap(ArenaAllocator<std::pair<const int, int>>(&arena));
+        arena.reset();
+    }
+    state.SetItemsProcessed(kElements * state.iterations());
+}
+BENCHMARK(BM_MapArena);
+
+static void BM_MapPool(benchmark::State &state)
+{
+    PoolAllocator pool;
+    for (auto _ : state)
+    {
+        buildMap(ResourceAllocator<std::pair<const int, int>>(&pool));
+    }
+    state.SetItemsProcessed(kElements * state.iterations());
+}
+BENCHMARK(BM_MapPool);
+
+static void BM_ChurnHeap(benchmark::State &state)
+{
+    churn(
+        state, [](size_t size)
+        { return ::operator new(size); },
+        [](void *pointer, size_t size)
+        { ::operator delete(pointer, size); });
+}
+BENCHMARK(BM_ChurnHeap)->ThreadRange(1, 8)->UseRealTime();
+
+static void BM_ChurnPool(benchmark::State &state)
+{
+    churn(
+        state, [](size_t size)
+        { return shared_pool.allocate(size); },
+        [](void *pointer, size_t size)
+        { shared_pool.deallocate(pointer, size); });
+}
+BENCHMARK(BM_ChurnPool)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
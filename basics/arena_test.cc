@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arena.h"
+#include "bplus_tree.h"
+#include "chunked_vector.h"
+#include "flat_hash_map.h"
+#include "simple_list.h"
+
+namespace
+{
+    /**
+     * @brief Forwards to the default resource and counts the calls and the bytes in use.
+     */
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t bytes = 0;
+
+    private:
+        void *do_allocate(size_t size, size_t alignment) override
+        {
+            ++allocations;
+            bytes += size;
+            return std::pmr::new_delete_resource()->allocate(size, alignment);
+        }
+
+        void do_deallocate(void *pointer, size_t size, size_t alignment) override
+        {
+            ++deallocations;
+            bytes -= size;
+            std::pmr::new_delete_resource()->deallocate(pointer, size, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+    };
+
+    bool isAligned(const void *pointer, size_t alignment)
+    {
+        return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+    }
+} // namespace
+
+TEST(ArenaTest, BumpsThroughBlocksAndReusesThemAfterReset)
+{
+    CountingResource upstream;
+    {
+        Arena arena(1024, &upstream);
+        EXPECT_EQ(arena.memoryUsage(), 0u);
+        std::set<void *> seen;
+        for (size_t i = 0; i < 100; ++i)
+        {
+            void *pointer = arena.allocate(24, 8);
+            EXPECT_TRUE(isAligned(pointer, 8));
+            EXPECT_TRUE(seen.insert(pointer).second);
+        }
+        EXPECT_GE(arena.bytesAllocated(), 2400u);
+        EXPECT_GT(upstream.allocations, 1u);
+
+        void *over_aligned = arena.allocate(10, 64);
+        EXPECT_TRUE(isAligned(over_aligned, 64));
+
+        // The cycle needed several blocks: the next ones fit in the single block that replaces them
+        arena.reset();
+        EXPECT_EQ(arena.bytesAllocated(), 0u);
+        size_t calls = upstream.allocations;
+        for (int cycle = 0; cycle < 3; ++cycle)
+        {
+            for (size_t i = 0; i < 100; ++i)
+            {
+                arena.allocate(24, 8);
+            }
+            arena.reset();
+        }
+        EXPECT_EQ(upstream.allocations, calls);
+        EXPECT_EQ(upstream.bytes, arena.memoryUsage());
+
+        arena.release();
+        EXPECT_EQ(arena.memoryUsage(), 0u);
+        EXPECT_EQ(upstream.bytes, 0u);
+        EXPECT_NE(arena.allocate(8), nullptr);
+    }
+    EXPECT_EQ(upstream.bytes, 0u);
+    EXPECT_EQ(upstream.allocations, upstream.deallocations);
+}
+
+TEST(ArenaTest, LargeAllocationsGetTheirOwnBlock)
+{
+    CountingResource upstream;
+    Arena arena(1024, &upstream);
+    auto *small = static_cast<char *>(arena.allocate(16));
+    auto *large = static_cast<char *>(arena.allocate(4000, 128));
+    EXPECT_TRUE(isAligned(large, 128));
+    std::fill(large, large + 4000, 'x');
+    // The current block keeps serving small allocations
+    auto *next = static_cast<char *>(arena.allocate(16));
+    EXPECT_EQ(next, small + 16);
+    EXPECT_GE(arena.bytesAllocated(), 4032u);
+    EXPECT_THROW(arena.allocate(SIZE_MAX - 8), std::bad_alloc);
+    EXPECT_THROW(Arena(0), std::invalid_argument);
+}
+
+TEST(ArenaTest, WorksAsMemoryResourceAndAllocator)
+{
+    Arena arena(4096);
+    std::pmr::vector<std::pmr::string> strings(&arena);
+    for (int i = 0; i < 100; ++i)
+    {
+        strings.emplace_back("a string too long for the small string optimization " + std::to_string(i));
+    }
+    EXPECT_EQ(strings[42].get_allocator().resource(), &arena);
+    EXPECT_EQ(strings[99].back(), '9');
+
+    using PairAllocator = ArenaAllocator<std::pair<const int, int>>;
+    PairAllocator pairs(&arena);
+    FlatHashMap<int, int, std::hash<int>, std::equal_to<int>, PairAllocator> map(pairs);
+    BPlusTree<int, int, std::less<int>, 256, PairAllocator> tree(std::less<int>(), pairs);
+    ArenaAllocator<int> ints(&arena);
+    ChunkedVector<int, ArenaAllocator<int>> chunked(16, ints);
+    SimpleList<int, ArenaAllocator<int>> list(ints);
+    for (int i = 0; i < 1000; ++i)
+    {
+        map.tryEmplace(i, i * 2);
+        tree.insert(i, i * 3);
+        chunked.pushBack(i * 4);
+        list.pushBack(i * 5);
+    }
+    EXPECT_EQ(map.at(500), 1000);
+    EXPECT_EQ(tree.at(500), 1500);
+    EXPECT_EQ(chunked[500], 2000);
+    chunked.pack();
+    EXPECT_EQ(chunked[999], 3996);
+    chunked.split(64);
+    EXPECT_EQ(chunked[500], 2000);
+    EXPECT_THROW(chunked[1000], std::out_of_range);
+    EXPECT_EQ(list.back(), 4995);
+    EXPECT_GT(arena.bytesAllocated(), 1000 * 4 * sizeof(int));
+
+    ArenaAllocator<double> doubles(ints);
+    EXPECT_TRUE(ints == doubles);
+    Arena other;
+    EXPECT_FALSE(ints == ArenaAllocator<int>(&other));
+    EXPECT_FALSE(arena.is_equal(other));
+}
+
+TEST(PoolAllocatorTest, ReusesFreedObjectsOfTheSameSizeClass)
+{
+    CountingResource upstream;
+    {
+        PoolAllocator pool(&upstream);
+        std::vector<std::pair<void *, size_t>> live;
+        for (size_t size : {1, 8, 16, 17, 100, 512, 4096})
+        {
+            for (int i = 0; i < 50; ++i)
+            {
+                void *pointer = pool.allocate(size, alignof(std::max_align_t));
+                EXPECT_TRUE(isAligned(pointer, alignof(std::max_align_t)));
+                std::memset(pointer, 0xab, size);
+                live.emplace_back(pointer, size);
+            }
+        }
+        EXPECT_GT(pool.memoryUsage(), 0u);
+        void *aligned = pool.allocate(100, 256);
+        EXPECT_TRUE(isAligned(aligned, 256));
+        pool.deallocate(aligned, 100, 256);
+
+        // The most recently freed object of a size class is handed out first
+        void *freed = live.back().first;
+        pool.deallocate(freed, 4096);
+        live.pop_back();
+        EXPECT_EQ(pool.allocate(4000), freed);
+        pool.deallocate(freed, 4000);
+        for (auto [pointer, size] : live)
+        {
+            pool.deallocate(pointer, size);
+        }
+
+        // Large sizes bypass the pool
+        size_t slabs = upstream.allocations;
+        void *large = pool.allocate(100000);
+        EXPECT_EQ(upstream.allocations, slabs + 1);
+        pool.deallocate(large, 100000);
+        EXPECT_EQ(upstream.bytes, pool.memoryUsage());
+    }
+    EXPECT_EQ(upstream.bytes, 0u);
+}
+
+TEST(PoolAllocatorTest, IsSafeAcrossThreads)
+{
+    PoolAllocator pool;
+    {
+        // Nodes allocated by one thread and freed by another end up in both threads' caches
+        std::pmr::vector<std::pmr::string> strings(&pool);
+        std::thread producer([&]()
+                             {
+                                 for (int i = 0; i < 10000; ++i)
+                                 {
+                                     strings.emplace_back(std::string(40 + i % 200, 'p'));
+                                 } });
+        producer.join();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&pool, t]()
+                                 {
+                                     using PairAllocator = ResourceAllocator<std::pair<const int, std::pmr::string>>;
+                                     PairAllocator pairs(&pool);
+                                     FlatHashMap<int, std::pmr::string, std::hash<int>, std::equal_to<int>, PairAllocator>
+                                         map(pairs);
+                                     for (int i = 0; i < 5000; ++i)
+                                     {
+                                         map.tryEmplace(i, std::pmr::string(std::string(50 + t, 'x'), &pool));
+                                         if (i % 3 == 0)
+                                         {
+                                             map.erase(i / 2);
+                                         }
+                                     }
+                                     for (const auto &[key, value] : map)
+                                     {
+                                         ASSERT_EQ(value.size(), static_cast<size_t>(50 + t)) << key;
+                                     } });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        EXPECT_EQ(strings[9999].size(), 40u + 9999 % 200);
+    }
+
+    // A pool destroyed while another thread still caches its objects
+    auto doomed = std::make_unique<PoolAllocator>();
+    void *pointer = nullptr;
+    std::thread user([&]()
+                     { doomed->deallocate(doomed->allocate(64), 64); });
+    user.join();
+    pointer = doomed->allocate(32);
+    doomed->deallocate(pointer, 32);
+    doomed.reset();
+    PoolAllocator fresh;
+    fresh.deallocate(fresh.allocate(32), 32);
+}
@@ -0,0 +1,149 @@
+#include "benchmark_data.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+uint64_t DataGenerator::uniform(uint64_t bound) noexcept
+{
+    auto product = static_cast<unsigned __int128>(next()) * bound;
+    auto low = static_cast<uint64_t>(product);
+    if (low < bound)
+    {
+        uint64_t threshold = -bound % bound;
+        while (low < threshold)
+        {
+            product = static_cast<unsigned __int128>(next()) * bound;
+            low = static_cast<uint64_t>(product);
+        }
+    }
+    return static_cast<uint64_t>(product >> 64);
+}
+
+ZipfianGenerator::ZipfianGenerator(size_t keys, double s) : cdf_(keys)
+{
+    double sum = 0;
+    for (size_t i = 0; i < keys; ++i)
+    {
+        sum += 1.0 / std::pow(static_cast<double>(i + 1), s);
+        cdf_[i] = sum;
+    }
+    for (double &value : cdf_)
+    {
+        value /= sum;
+    }
+}
+
+uint64_t ZipfianGenerator::operator()(DataGenerator &random) const noexcept
+{
+    auto rank = static_cast<size_t>(std::lower_bound(cdf_.begin(), cdf_.end(), random.unit()) - cdf_.begin());
+    // Rounding can leave the last sum a hair below 1
+    return std::min(rank, cdf_.size() - 1);
+}
+
+std::vector<int64_t> benchmarkSizes(int64_t default_max)
+{
+    const char *max = std::getenv("BENCHMARK_MAX_SIZE");
+    int64_t limit = max ? std::strtoll(max, nullptr, 10) : default_max;
+    std::vector<int64_t> sizes;
+    for (int64_t n = 1000; n <= limit; n *= 10)
+    {
+        sizes.push_back(n);
+    }
+    return sizes;
+}
+
+std::vector<uint64_t> uniformIntegers(size_t count, uint64_t bound, uint64_t seed)
+{
+    DataGenerator random(seed);
+    std::vector<uint64_t> values(count);
+    for (uint64_t &value : values)
+    {
+        value = random.uniform(bound);
+    }
+    return values;
+}
+
+std::vector<uint64_t> zipfianIntegers(size_t count, size_t keys, double s, uint64_t seed)
+{
+    ZipfianGenerator zipfian(keys, s);
+    DataGenerator random(seed);
+    std::vector<uint64_t> values(count);
+    for (uint64_t &value : values)
+    {
+        value = zipfian(random);
+    }
+    return values;
+}
+
+std::vector<int64_t> ascendingIntegers(size_t count, uint64_t max_step, uint64_t seed)
+{
+    DataGenerator random(seed);
+    std::vector<int64_t> values(count);
+    int64_t value = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        values[i] = value;
+        value += static_cast<int64_t>(random.uniform(max_step + 1));
+    }
+    return values;
+}
+
+std::vector<uint64_t> runIntegers(size_t count, uint64_t distinct, size_t mean_run, uint64_t seed)
+{
+    DataGenerator random(seed);
+    std::vector<uint64_t> values;
+    values.reserve(count);
+    while (values.size() < count)
+    {
+        uint64_t value = random.uniform(distinct);
+        size_t run = 1 + random.uniform(2 * mean_run - 1);
+        values.insert(values.end(), std::min(run, count - values.size()), value);
+    }
+    return values;
+}
+
+std::vector<double> uniformDoubles(size_t count, uint64_t seed)
+{
+    DataGenerator random(seed);
+    std::vector<double> values(count);
+    for (double &value : values)
+    {
+        value = random.unit();
+    }
+    return values;
+}
+
+std::vector<std::string> randomStrings(size_t count, size_t cardinality, size_t min_length, size_t max_length,
+                                       uint64_t seed)
+{
+    DataGenerator random(seed);
+    std::vector<std::string> dictionary(cardinality);
+    for (std::string &value : dictionary)
+    {
+        value.resize(min_length + random.uniform(max_length - min_length + 1));
+        for (char &c : value)
+        {
+            c = static_cast<char>(' ' + random.uniform(95));
+        }
+    }
+    std::vector<std::string> values(count);
+    for (std::string &value : values)
+    {
+        value = dictionary[random.uniform(cardinality)];
+    }
+    return values;
+}
+
+std::vector<std::string> urlStrings(size_t count)
+{
+    std::vector<std::string> values(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        char url[64];
+        int length = std::snprintf(url, sizeof(url), "https://example.com/catalog/items/%09zu", i * 7);
+        values[i].assign(url, static_cast<size_t>(length));
+    }
+    return values;
+}
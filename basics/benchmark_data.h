@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Synthetic data for the benchmarks. Everything is derived from a seed with SplitMix64 and
+// integer arithmetic only, so a seed yields the same data with every compiler and standard
+// library (the std:: distributions are free to differ between implementations), and runs
+// on different builds are comparable.
+
+/**
+ * @brief SplitMix64, the generator used to seed xoshiro: one 64-bit state, every seed
+ * (zero included) gives a full period sequence.
+ */
+class DataGenerator
+{
+public:
+    explicit DataGenerator(uint64_t seed) noexcept : state_(seed) {}
+
+    uint64_t next() noexcept
+    {
+        uint64_t z = (state_ += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+    /**
+     * @brief Uniform in [0, bound), by Lemire's multiply and reject; `bound` must not be 0.
+     */
+    uint64_t uniform(uint64_t bound) noexcept;
+
+    /// Uniform in [0, 1) with 53 bits of precision
+    double unit() noexcept { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+private:
+    uint64_t state_;
+};
+
+/**
+ * @brief Draws ranks in [0, keys) from a Zipfian distribution with exponent `s`, by binary
+ * search over the cumulative distribution (built once, 8 bytes per key).
+ */
+class ZipfianGenerator
+{
+public:
+    ZipfianGenerator(size_t keys, double s);
+
+    uint64_t operator()(DataGenerator &random) const noexcept;
+
+private:
+    std::vector<double> cdf_;
+};
+
+/**
+ * @brief Fisher-Yates shuffle with DataGenerator: unlike std::shuffle, whose algorithm is
+ * up to the standard library, the same seed gives the same order everywhere.
+ */
+template <typename T>
+void shuffleValues(std::vector<T> &values, uint64_t seed)
+{
+    DataGenerator random(seed);
+    for (size_t i = values.size(); i > 1; --i)
+    {
+        std::swap(values[i - 1], values[random.uniform(i)]);
+    }
+}
+
+/**
+ * @brief Sizes from 1K up to `default_max` in steps of 10, or up to the BENCHMARK_MAX_SIZE
+ * environment variable where set (e.g. 100000000 on machines with the memory for it).
+ */
+std::vector<int64_t> benchmarkSizes(int64_t default_max);
+
+/// `count` values uniform in [0, bound)
+std::vector<uint64_t> uniformIntegers(size_t count, uint64_t bound, uint64_t seed);
+
+/// `count` Zipfian ranks over `keys` keys with exponent `s`
+std::vector<uint64_t> zipfianIntegers(size_t count, size_t keys, double s, uint64_t seed);
+
+/**
+ * @brief An ascending sequence starting at 0 whose steps are uniform in [0, max_step]:
+ * timestamps, sequence numbers, sorted keys.
+ */
+std::vector<int64_t> ascendingIntegers(size_t count, uint64_t max_step, uint64_t seed);
+
+/**
+ * @brief Runs of equal values from [0, distinct), run lengths uniform in
+ * [1, 2 * mean_run - 1]: status codes, sorted categories.
+ */
+std::vector<uint64_t> runIntegers(size_t count, uint64_t distinct, size_t mean_run, uint64_t seed);
+
+/// `count` doubles uniform in [0, 1)
+std::vector<double> uniformDoubles(size_t count, uint64_t seed);
+
+/**
+ * @brief `count` strings drawn uniformly from `cardinality` distinct strings of printable
+ * ASCII, each of length uniform in [min_length, max_length].
+ */
+std::vector<std::string> randomStrings(size_t count, size_t cardinality, size_t min_length, size_t max_length,
+                                       uint64_t seed);
+
+/**
+ * @brief `count` ascending URLs sharing a 34 character prefix, the item number
+ * (`7 * i`, zero padded to 9 digits) following it: sorted keys, file paths.
+ */
+std::vector<std::string> urlStrings(size_t count);
@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "benchmark_data.h"
+
+TEST(BenchmarkDataTest, GeneratorMatchesTheReferenceSequence)
+{
+    // The first outputs of the reference SplitMix64 seeded with 0
+    DataGenerator random(0);
+    EXPECT_EQ(random.next(), 0xe220a8397b1dcdafULL);
+    EXPECT_EQ(random.next(), 0x6e789e6aa1b965f4ULL);
+    EXPECT_EQ(random.next(), 0x06c45d188009454fULL);
+
+    for (uint64_t bound : {1ULL, 3ULL, 1000ULL, (1ULL << 63) + 1})
+    {
+        for (int i = 0; i < 1000; ++i)
+        {
+            ASSERT_LT(random.uniform(bound), bound);
+        }
+    }
+    for (int i = 0; i < 1000; ++i)
+    {
+        double value = random.unit();
+        ASSERT_GE(value, 0.0);
+        ASSERT_LT(value, 1.0);
+    }
+}
+
+TEST(BenchmarkDataTest, GeneratesDeterministicData)
+{
+    EXPECT_EQ(uniformIntegers(1000, 100, 1), uniformIntegers(1000, 100, 1));
+    EXPECT_NE(uniformIntegers(1000, 100, 1), uniformIntegers(1000, 100, 2));
+    std::vector<uint64_t> uniform = uniformIntegers(100000, 10, 1);
+    EXPECT_EQ(*std::max_element(uniform.begin(), uniform.end()), 9u);
+    EXPECT_NEAR(std::count(uniform.begin(), uniform.end(), 3), 10000, 500);
+
+    // Rank 0 is the most frequent by far
+    std::vector<uint64_t> zipfian = zipfianIntegers(100000, 1000, 0.99, 1);
+    EXPECT_EQ(zipfian, zipfianIntegers(100000, 1000, 0.99, 1));
+    EXPECT_LT(*std::max_element(zipfian.begin(), zipfian.end()), 1000u);
+    EXPECT_GT(std::count(zipfian.begin(), zipfian.end(), 0), 10 * std::count(zipfian.begin(), zipfian.end(), 100));
+
+    std::vector<int64_t> ascending = ascendingIntegers(1000, 5, 1);
+    EXPECT_EQ(ascending[0], 0);
+    for (size_t i = 1; i < ascending.size(); ++i)
+    {
+        ASSERT_GE(ascending[i] - ascending[i - 1], 0);
+        ASSERT_LE(ascending[i] - ascending[i - 1], 5);
+    }
+
+    std::vector<uint64_t> runs = runIntegers(100000, 4, 50, 1);
+    ASSERT_EQ(runs.size(), 100000u);
+    size_t changes = 0;
+    for (size_t i = 1; i < runs.size(); ++i)
+    {
+        changes += runs[i] != runs[i - 1];
+    }
+    // Mean run of 50, and a quarter of the new runs repeat the previous value
+    EXPECT_NEAR(changes, 1500, 200);
+
+    std::vector<std::string> strings = randomStrings(10000, 100, 4, 8, 1);
+    EXPECT_EQ(strings, randomStrings(10000, 100, 4, 8, 1));
+    EXPECT_EQ(std::set<std::string>(strings.begin(), strings.end()).size(), 100u);
+    for (const std::string &value : strings)
+    {
+        ASSERT_GE(value.size(), 4u);
+        ASSERT_LE(value.size(), 8u);
+    }
+}
+
+TEST(BenchmarkDataTest, SizesHonorTheEnvironment)
+{
+    EXPECT_EQ(benchmarkSizes(100000), (std::vector<int64_t>{1000, 10000, 100000}));
+    setenv("BENCHMARK_MAX_SIZE", "10000", 1);
+    EXPECT_EQ(benchmarkSizes(100000), (std::vector<int64_t>{1000, 10000}));
+    unsetenv("BENCHMARK_MAX_SIZE");
+}
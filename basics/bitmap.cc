@@ -0,0 +1,952 @@
+#include "bitmap.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    struct And
+    {
+        uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a & b; }
+#if defined(__SSE2__)
+        __m128i operator()(__m128i a, __m128i b) const noexcept { return _mm_and_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+        __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_and_si256(a, b); }
+#endif
+    };
+
+    struct Or
+    {
+        uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a | b; }
+#if defined(__SSE2__)
+        __m128i operator()(__m128i a, __m128i b) const noexcept { return _mm_or_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+        __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_or_si256(a, b); }
+#endif
+    };
+
+    struct Xor
+    {
+        uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a ^ b; }
+#if defined(__SSE2__)
+        __m128i operator()(__m128i a, __m128i b) const noexcept { return _mm_xor_si128(a, b); }
+#endif
+#if defined(__AVX2__)
+        __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_xor_si256(a, b); }
+#endif
+    };
+
+    struct AndNot
+    {
+        uint64_t operator()(uint64_t a, uint64_t b) const noexcept { return a & ~b; }
+#if defined(__SSE2__)
+        __m128i operator()(__m128i a, __m128i b) const noexcept { return _mm_andnot_si128(b, a); }
+#endif
+#if defined(__AVX2__)
+        __m256i operator()(__m256i a, __m256i b) const noexcept { return _mm256_andnot_si256(b, a); }
+#endif
+    };
+
+    /**
+     * @brief out[i] = op(a[i], b[i]), two registers per iteration. `out` may be `a` or `b`.
+     */
+    template <typename Op>
+    void binaryWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count, Op op) noexcept
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (size_t end = count - count % 8; i < end; i += 8)
+        {
+            __m256i a0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i a1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i + 4));
+            __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i + 4));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), op(a0, b0));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i + 4), op(a1, b1));
+        }
+#elif defined(__SSE2__)
+        for (size_t end = count - count % 4; i < end; i += 4)
+        {
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i + 2));
+            __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i + 2));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), op(a0, b0));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i + 2), op(a1, b1));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            out[i] = op(a[i], b[i]);
+        }
+    }
+
+    /**
+     * @brief popcount(a[i]) summed over the words, or popcount(a[i] & b[i]) when `b` is given.
+     *
+     * AVX2 looks up the count of every nibble with a byte shuffle (Mula's method). Without
+     * it, the popcnt instruction if the build enables it, else the SWAR count on SSE2
+     * registers: both avoid the library call __builtin_popcountll turns into otherwise.
+     */
+    template <bool kAnd>
+    size_t popcount(const uint64_t *a, const uint64_t *b, size_t count) noexcept
+    {
+        size_t i = 0;
+        size_t total = 0;
+#if defined(__AVX2__)
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2,
+                                                3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i low = _mm256_set1_epi8(0x0f);
+        __m256i sums = _mm256_setzero_si256();
+        for (size_t end = count - count % 4; i < end; i += 4)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            if constexpr (kAnd)
+            {
+                v = _mm256_and_si256(v, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i)));
+            }
+            __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low)),
+                                             _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low)));
+            sums = _mm256_add_epi64(sums, _mm256_sad_epu8(counts, _mm256_setzero_si256()));
+        }
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), sums);
+        total = static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+#elif defined(__POPCNT__)
+        size_t partial[4] = {};
+        for (size_t end = count - count % 4; i < end; i += 4)
+        {
+            for (size_t j = 0; j < 4; ++j)
+            {
+                partial[j] += static_cast<size_t>(__builtin_popcountll(kAnd ? a[i + j] & b[i + j] : a[i + j]));
+            }
+        }
+        total = partial[0] + partial[1] + partial[2] + partial[3];
+#elif defined(__SSE2__)
+        const __m128i m1 = _mm_set1_epi8(0x55);
+        const __m128i m2 = _mm_set1_epi8(0x33);
+        const __m128i m4 = _mm_set1_epi8(0x0f);
+        __m128i sums = _mm_setzero_si128();
+        for (size_t end = count - count % 2; i < end; i += 2)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            if constexpr (kAnd)
+            {
+                v = _mm_and_si128(v, _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i)));
+            }
+            v = _mm_sub_epi8(v, _mm_and_si128(_mm_srli_epi16(v, 1), m1));
+            v = _mm_add_epi8(_mm_and_si128(v, m2), _mm_and_si128(_mm_srli_epi16(v, 2), m2));
+            v = _mm_and_si128(_mm_add_epi8(v, _mm_srli_epi16(v, 4)), m4);
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(v, _mm_setzero_si128()));
+        }
+        total = static_cast<size_t>(_mm_cvtsi128_si64(sums)) +
+                static_cast<size_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums)));
+#endif
+        for (; i < count; ++i)
+        {
+            total += static_cast<size_t>(__builtin_popcountll(kAnd ? a[i] & b[i] : a[i]));
+        }
+        return total;
+    }
+
+    /**
+     * @brief Loads up to 8 bytes as a little endian word without reading past `available`.
+     */
+    uint64_t loadBytes(const uint8_t *data, size_t available) noexcept
+    {
+        uint64_t word = 0;
+        std::memcpy(&word, data, std::min<size_t>(available, 8));
+        return word;
+    }
+} // namespace
+
+namespace bitmap_detail
+{
+    void andWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept
+    {
+        binaryWords(out, a, b, count, And());
+    }
+
+    void orWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept
+    {
+        binaryWords(out, a, b, count, Or());
+    }
+
+    void xorWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept
+    {
+        binaryWords(out, a, b, count, Xor());
+    }
+
+    void andNotWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept
+    {
+        binaryWords(out, a, b, count, AndNot());
+    }
+
+    size_t popcountWords(const uint64_t *words, size_t count) noexcept
+    {
+        return popcount<false>(words, nullptr, count);
+    }
+
+    size_t popcountAndWords(const uint64_t *a, const uint64_t *b, size_t count) noexcept
+    {
+        return popcount<true>(a, b, count);
+    }
+
+    unsigned selectInWord(uint64_t word, unsigned rank) noexcept
+    {
+#if defined(__BMI2__)
+        return static_cast<unsigned>(__builtin_ctzll(_pdep_u64(uint64_t(1) << rank, word)));
+#else
+        unsigned position = 0;
+        for (;; position += 8, word >>= 8)
+        {
+            unsigned in_byte = static_cast<unsigned>(__builtin_popcount(static_cast<unsigned>(word & 0xff)));
+            if (rank < in_byte)
+            {
+                break;
+            }
+            rank -= in_byte;
+        }
+        for (; rank > 0; --rank)
+        {
+            word &= word - 1;
+        }
+        return position + static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+    }
+} // namespace bitmap_detail
+
+Bitmap::Bitmap(size_t size, bool value)
+    : size_(size), words_((size + kWordBits - 1) / kWordBits, value ? ~uint64_t(0) : 0)
+{
+    trim();
+}
+
+Bitmap Bitmap::fromBits(const uint8_t *bits, size_t bit_offset, size_t size)
+{
+    Bitmap bitmap(size);
+    const uint8_t *first = bits + bit_offset / 8;
+    size_t available = (bit_offset % 8 + size + 7) / 8;
+    unsigned shift = static_cast<unsigned>(bit_offset % 8);
+    for (size_t w = 0; w < bitmap.words_.size(); ++w)
+    {
+        size_t byte = w * 8;
+        uint64_t word = loadBytes(first + byte, available - byte) >> shift;
+        if (shift > 0 && byte + 8 < available)
+        {
+            word |= static_cast<uint64_t>(first[byte + 8]) << (64 - shift);
+        }
+        bitmap.words_[w] = word;
+    }
+    bitmap.trim();
+    return bitmap;
+}
+
+void Bitmap::setRange(size_t begin, size_t end, bool value) noexcept
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    size_t first = begin / kWordBits;
+    size_t last = (end - 1) / kWordBits;
+    uint64_t first_mask = ~uint64_t(0) << (begin % kWordBits);
+    uint64_t last_mask = ~uint64_t(0) >> (kWordBits - 1 - (end - 1) % kWordBits);
+    if (first == last)
+    {
+        first_mask &= last_mask;
+    }
+    auto apply = [value](uint64_t &word, uint64_t mask)
+    {
+        word = value ? word | mask : word & ~mask;
+    };
+    apply(words_[first], first_mask);
+    if (first != last)
+    {
+        std::fill(words_.begin() + static_cast<std::ptrdiff_t>(first) + 1,
+                  words_.begin() + static_cast<std::ptrdiff_t>(last), value ? ~uint64_t(0) : 0);
+        apply(words_[last], last_mask);
+    }
+}
+
+void Bitmap::resize(size_t size, bool value)
+{
+    size_t old_size = size_;
+    words_.resize((size + kWordBits - 1) / kWordBits, 0);
+    size_ = size;
+    if (value && size > old_size)
+    {
+        setRange(old_size, size, true);
+    }
+    trim();
+}
+
+Bitmap &Bitmap::operator&=(const Bitmap &other)
+{
+    checkSameSize(other);
+    bitmap_detail::andWords(words_.data(), words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+Bitmap &Bitmap::operator|=(const Bitmap &other)
+{
+    checkSameSize(other);
+    bitmap_detail::orWords(words_.data(), words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+Bitmap &Bitmap::operator^=(const Bitmap &other)
+{
+    checkSameSize(other);
+    bitmap_detail::xorWords(words_.data(), words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+Bitmap &Bitmap::andNot(const Bitmap &other)
+{
+    checkSameSize(other);
+    bitmap_detail::andNotWords(words_.data(), words_.data(), other.words_.data(), words_.size());
+    return *this;
+}
+
+Bitmap &Bitmap::flip() noexcept
+{
+    for (uint64_t &word : words_)
+    {
+        word = ~word;
+    }
+    trim();
+    return *this;
+}
+
+size_t Bitmap::count() const noexcept
+{
+    return bitmap_detail::popcountWords(words_.data(), words_.size());
+}
+
+size_t Bitmap::countAnd(const Bitmap &other) const
+{
+    checkSameSize(other);
+    return bitmap_detail::popcountAndWords(words_.data(), other.words_.data(), words_.size());
+}
+
+size_t Bitmap::findNext(size_t from, bool value) const noexcept
+{
+    if (from >= size_)
+    {
+        return size_;
+    }
+    // Searching for a clear bit is searching for a set bit of the inverted words; the
+    // inverted bits past size_ are caught by the final clamp
+    uint64_t flip = value ? 0 : ~uint64_t(0);
+    size_t w = from / kWordBits;
+    uint64_t word = (words_[w] ^ flip) & (~uint64_t(0) << (from % kWordBits));
+    while (word == 0)
+    {
+        if (++w == words_.size())
+        {
+            return size_;
+        }
+        word = words_[w] ^ flip;
+    }
+    return std::min(size_, w * kWordBits + static_cast<size_t>(__builtin_ctzll(word)));
+}
+
+std::vector<uint32_t> Bitmap::toIndices() const
+{
+    if (size_ > (size_t(1) << 32))
+    {
+        throw std::length_error("Bitmap positions do not fit in 32 bits");
+    }
+    std::vector<uint32_t> indices(count());
+    toIndices(indices.data());
+    return indices;
+}
+
+void Bitmap::checkSameSize(const Bitmap &other) const
+{
+    if (size_ != other.size_)
+    {
+        throw std::invalid_argument("Bitmap sizes differ");
+    }
+}
+
+void Bitmap::trim() noexcept
+{
+    if (size_t bits = size_ % kWordBits)
+    {
+        words_.back() &= (uint64_t(1) << bits) - 1;
+    }
+}
+
+RankSelect::RankSelect(const Bitmap &bitmap) : bitmap_(&bitmap)
+{
+    const uint64_t *words = bitmap.words();
+    size_t word_count = bitmap.wordCount();
+    // One more block than the words fill, so rank(size()) always has a block to read
+    size_t blocks = word_count / kBlockWords + 1;
+    counts_.assign(2 * blocks, 0);
+    size_t total = 0;
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        counts_[2 * block] = total;
+        uint64_t packed = 0;
+        size_t in_block = 0;
+        for (size_t w = 0; w < kBlockWords; ++w)
+        {
+            if (w > 0)
+            {
+                packed |= static_cast<uint64_t>(in_block) << (9 * (w - 1));
+            }
+            size_t index = block * kBlockWords + w;
+            if (index < word_count)
+            {
+                in_block += static_cast<size_t>(__builtin_popcountll(words[index]));
+            }
+        }
+        counts_[2 * block + 1] = packed;
+        total += in_block;
+        while (samples_.size() * kSampleRate < total)
+        {
+            samples_.push_back(block);
+        }
+    }
+    samples_.shrink_to_fit();
+    count_ = total;
+}
+
+size_t RankSelect::select(size_t k) const
+{
+    if (k >= count_)
+    {
+        throw std::out_of_range("RankSelect::select beyond the set bits");
+    }
+    // The block holding bit k is the last one with fewer than k set bits before it, between
+    // the blocks of the samples around k
+    size_t sample = k / kSampleRate;
+    size_t low = samples_[sample];
+    size_t high = sample + 1 < samples_.size() ? samples_[sample + 1] + 1 : counts_.size() / 2;
+    while (high - low > 1)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (counts_[2 * middle] <= k)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    size_t rank = k - counts_[2 * low];
+    uint64_t packed = counts_[2 * low + 1];
+    size_t word = 0;
+    size_t before = 0;
+    for (size_t w = 1; w < kBlockWords; ++w)
+    {
+        size_t count = (packed >> (9 * (w - 1))) & 0x1ff;
+        if (count > rank)
+        {
+            break;
+        }
+        word = w;
+        before = count;
+    }
+    size_t index = low * kBlockWords + word;
+    return index * Bitmap::kWordBits +
+           bitmap_detail::selectInWord(bitmap_->words()[index], static_cast<unsigned>(rank - before));
+}
+
+namespace
+{
+    using bitmap_detail::RoaringContainer;
+
+    constexpr size_t kContainerWords = 65536 / 64;
+
+    bool containerContains(const RoaringContainer &container, uint16_t low) noexcept
+    {
+        if (container.isBitmap())
+        {
+            return (container.bits[low / 64] >> (low % 64)) & 1;
+        }
+        return std::binary_search(container.array.begin(), container.array.end(), low);
+    }
+
+    /**
+     * @brief Appends the positions of the set bits of `words` to `out`.
+     */
+    void wordsToArray(const uint64_t *words, std::vector<uint16_t> &out)
+    {
+        for (size_t w = 0; w < kContainerWords; ++w)
+        {
+            for (uint64_t word = words[w]; word != 0; word &= word - 1)
+            {
+                out.push_back(static_cast<uint16_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word))));
+            }
+        }
+    }
+
+    /**
+     * @brief Switches the container to the kind its cardinality calls for.
+     */
+    void normalize(RoaringContainer &container)
+    {
+        if (container.isBitmap() && container.cardinality <= RoaringBitmap::kArrayLimit)
+        {
+            container.array.clear();
+            container.array.reserve(container.cardinality);
+            wordsToArray(container.bits.data(), container.array);
+            container.bits = std::vector<uint64_t>();
+        }
+        else if (!container.isBitmap() && container.cardinality > RoaringBitmap::kArrayLimit)
+        {
+            container.bits.assign(kContainerWords, 0);
+            for (uint16_t low : container.array)
+            {
+                container.bits[low / 64] |= uint64_t(1) << (low % 64);
+            }
+            container.array = std::vector<uint16_t>();
+        }
+    }
+
+    /**
+     * @brief A container of the given key from bitmap words and their popcount.
+     */
+    RoaringContainer fromWords(uint16_t key, std::vector<uint64_t> words, size_t cardinality)
+    {
+        RoaringContainer container;
+        container.key = key;
+        container.cardinality = static_cast<uint32_t>(cardinality);
+        container.bits = std::move(words);
+        normalize(container);
+        return container;
+    }
+
+    RoaringContainer fromArray(uint16_t key, std::vector<uint16_t> array)
+    {
+        RoaringContainer container;
+        container.key = key;
+        container.cardinality = static_cast<uint32_t>(array.size());
+        container.array = std::move(array);
+        normalize(container);
+        return container;
+    }
+
+    /**
+     * @brief The values of `small` that are in `large`, both sorted. Binary searches
+     * `large` from the last match when it is much bigger, merges otherwise.
+     */
+    std::vector<uint16_t> intersectArrays(const std::vector<uint16_t> &small, const std::vector<uint16_t> &large)
+    {
+        std::vector<uint16_t> result;
+        result.reserve(std::min(small.size(), large.size()));
+        if (small.size() * 32 < large.size())
+        {
+            auto from = large.begin();
+            for (uint16_t value : small)
+            {
+                from = std::lower_bound(from, large.end(), value);
+                if (from == large.end())
+                {
+                    break;
+                }
+                if (*from == value)
+                {
+                    result.push_back(value);
+                }
+            }
+        }
+        else
+        {
+            std::set_intersection(small.begin(), small.end(), large.begin(), large.end(), std::back_inserter(result));
+        }
+        return result;
+    }
+
+    RoaringContainer intersect(const RoaringContainer &a, const RoaringContainer &b)
+    {
+        if (a.isBitmap() && b.isBitmap())
+        {
+            size_t cardinality = bitmap_detail::popcountAndWords(a.bits.data(), b.bits.data(), kContainerWords);
+            if (cardinality > RoaringBitmap::kArrayLimit)
+            {
+                std::vector<uint64_t> words(kContainerWords);
+                bitmap_detail::andWords(words.data(), a.bits.data(), b.bits.data(), kContainerWords);
+                return fromWords(a.key, std::move(words), cardinality);
+            }
+            // Small enough for an array: extract it without materializing the words
+            std::vector<uint16_t> array;
+            array.reserve(cardinality);
+            for (size_t w = 0; w < kContainerWords; ++w)
+            {
+                for (uint64_t word = a.bits[w] & b.bits[w]; word != 0; word &= word - 1)
+                {
+                    array.push_back(static_cast<uint16_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word))));
+                }
+            }
+            return fromArray(a.key, std::move(array));
+        }
+        if (a.isBitmap() || b.isBitmap())
+        {
+            const RoaringContainer &array = a.isBitmap() ? b : a;
+            const RoaringContainer &bitmap = a.isBitmap() ? a : b;
+            std::vector<uint16_t> result;
+            result.reserve(array.array.size());
+            for (uint16_t low : array.array)
+            {
+                if ((bitmap.bits[low / 64] >> (low % 64)) & 1)
+                {
+                    result.push_back(low);
+                }
+            }
+            return fromArray(a.key, std::move(result));
+        }
+        return fromArray(a.key, a.array.size() <= b.array.size() ? intersectArrays(a.array, b.array)
+                                                                 : intersectArrays(b.array, a.array));
+    }
+
+    RoaringContainer unite(const RoaringContainer &a, const RoaringContainer &b)
+    {
+        if (a.isBitmap() && b.isBitmap())
+        {
+            std::vector<uint64_t> words(kContainerWords);
+            bitmap_detail::orWords(words.data(), a.bits.data(), b.bits.data(), kContainerWords);
+            size_t cardinality = bitmap_detail::popcountWords(words.data(), kContainerWords);
+            return fromWords(a.key, std::move(words), cardinality);
+        }
+        if (a.isBitmap() || b.isBitmap())
+        {
+            const RoaringContainer &array = a.isBitmap() ? b : a;
+            const RoaringContainer &bitmap = a.isBitmap() ? a : b;
+            std::vector<uint64_t> words = bitmap.bits;
+            size_t cardinality = bitmap.cardinality;
+            for (uint16_t low : array.array)
+            {
+                uint64_t bit = uint64_t(1) << (low % 64);
+                cardinality += (words[low / 64] & bit) == 0;
+                words[low / 64] |= bit;
+            }
+            return fromWords(a.key, std::move(words), cardinality);
+        }
+        std::vector<uint16_t> result;
+        result.reserve(a.array.size() + b.array.size());
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(result));
+        return fromArray(a.key, std::move(result));
+    }
+
+    /// The values of `a` that are not in `b`
+    RoaringContainer subtract(const RoaringContainer &a, const RoaringContainer &b)
+    {
+        if (a.isBitmap())
+        {
+            std::vector<uint64_t> words(kContainerWords);
+            size_t cardinality;
+            if (b.isBitmap())
+            {
+                bitmap_detail::andNotWords(words.data(), a.bits.data(), b.bits.data(), kContainerWords);
+                cardinality = bitmap_detail::popcountWords(words.data(), kContainerWords);
+            }
+            else
+            {
+                words = a.bits;
+                cardinality = a.cardinality;
+                for (uint16_t low : b.array)
+                {
+                    uint64_t bit = uint64_t(1) << (low % 64);
+                    cardinality -= (words[low / 64] & bit) != 0;
+                    words[low / 64] &= ~bit;
+                }
+            }
+            return fromWords(a.key, std::move(words), cardinality);
+        }
+        std::vector<uint16_t> result;
+        result.reserve(a.array.size());
+        if (b.isBitmap())
+        {
+            for (uint16_t low : a.array)
+            {
+                if (((b.bits[low / 64] >> (low % 64)) & 1) == 0)
+                {
+                    result.push_back(low);
+                }
+            }
+        }
+        else
+        {
+            std::set_difference(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                                std::back_inserter(result));
+        }
+        return fromArray(a.key, std::move(result));
+    }
+
+    bool sameContainer(const RoaringContainer &a, const RoaringContainer &b) noexcept
+    {
+        return a.key == b.key && a.cardinality == b.cardinality && a.array == b.array && a.bits == b.bits;
+    }
+
+    auto findContainer(std::vector<RoaringContainer> &containers, uint16_t key)
+    {
+        // Values appended in increasing order land in the last container
+        if (!containers.empty() && containers.back().key <= key)
+        {
+            return containers.back().key == key ? containers.end() - 1 : containers.end();
+        }
+        return std::lower_bound(containers.begin(), containers.end(), key,
+                                [](const RoaringContainer &container, uint16_t key)
+                                { return container.key < key; });
+    }
+} // namespace
+
+RoaringBitmap RoaringBitmap::fromIndices(const uint32_t *values, size_t count)
+{
+    RoaringBitmap result;
+    for (size_t i = 0; i < count; ++i)
+    {
+        result.add(values[i]);
+    }
+    return result;
+}
+
+RoaringBitmap RoaringBitmap::fromBitmap(const Bitmap &bitmap)
+{
+    if (bitmap.size() > (size_t(1) << 32))
+    {
+        throw std::length_error("RoaringBitmap values are 32 bits");
+    }
+    RoaringBitmap result;
+    const uint64_t *words = bitmap.words();
+    for (size_t first = 0; first < bitmap.wordCount(); first += kContainerWords)
+    {
+        size_t count = std::min(kContainerWords, bitmap.wordCount() - first);
+        size_t cardinality = bitmap_detail::popcountWords(words + first, count);
+        if (cardinality == 0)
+        {
+            continue;
+        }
+        std::vector<uint64_t> chunk(kContainerWords, 0);
+        std::copy_n(words + first, count, chunk.begin());
+        result.containers_.push_back(
+            fromWords(static_cast<uint16_t>(first / kContainerWords), std::move(chunk), cardinality));
+    }
+    return result;
+}
+
+Bitmap RoaringBitmap::toBitmap(size_t size) const
+{
+    Bitmap bitmap(size);
+    for (const auto &container : containers_)
+    {
+        size_t base = static_cast<size_t>(container.key) << 16;
+        if (container.isBitmap() && base + 65536 <= size)
+        {
+            std::copy(container.bits.begin(), container.bits.end(), bitmap.words() + base / 64);
+            continue;
+        }
+        // The container reaches past `size`: check its values one by one
+        auto set = [&](uint32_t value)
+        {
+            if (value >= size)
+            {
+                throw std::out_of_range("RoaringBitmap value beyond the bitmap size");
+            }
+            bitmap.set(value);
+        };
+        forEachIn(container, set);
+    }
+    return bitmap;
+}
+
+void RoaringBitmap::add(uint32_t value)
+{
+    auto key = static_cast<uint16_t>(value >> 16);
+    auto low = static_cast<uint16_t>(value);
+    auto it = findContainer(containers_, key);
+    if (it == containers_.end() || it->key != key)
+    {
+        it = containers_.insert(it, Container());
+        it->key = key;
+    }
+    if (it->isBitmap())
+    {
+        uint64_t bit = uint64_t(1) << (low % 64);
+        it->cardinality += (it->bits[low / 64] & bit) == 0;
+        it->bits[low / 64] |= bit;
+        return;
+    }
+    auto position = it->array.empty() || it->array.back() < low
+                        ? it->array.end()
+                        : std::lower_bound(it->array.begin(), it->array.end(), low);
+    if (position != it->array.end() && *position == low)
+    {
+        return;
+    }
+    it->array.insert(position, low);
+    ++it->cardinality;
+    normalize(*it);
+}
+
+bool RoaringBitmap::remove(uint32_t value)
+{
+    auto key = static_cast<uint16_t>(value >> 16);
+    auto low = static_cast<uint16_t>(value);
+    auto it = findContainer(containers_, key);
+    if (it == containers_.end() || it->key != key || !containerContains(*it, low))
+    {
+        return false;
+    }
+    if (it->isBitmap())
+    {
+        it->bits[low / 64] &= ~(uint64_t(1) << (low % 64));
+    }
+    else
+    {
+        it->array.erase(std::lower_bound(it->array.begin(), it->array.end(), low));
+    }
+    if (--it->cardinality == 0)
+    {
+        containers_.erase(it);
+    }
+    else
+    {
+        normalize(*it);
+    }
+    return true;
+}
+
+const RoaringBitmap::Container *RoaringBitmap::find(uint16_t key) const noexcept
+{
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                               [](const Container &container, uint16_t key)
+                               { return container.key < key; });
+    return it != containers_.end() && it->key == key ? &*it : nullptr;
+}
+
+bool RoaringBitmap::contains(uint32_t value) const noexcept
+{
+    const Container *container = find(static_cast<uint16_t>(value >> 16));
+    return container && containerContains(*container, static_cast<uint16_t>(value));
+}
+
+size_t RoaringBitmap::cardinality() const noexcept
+{
+    size_t total = 0;
+    for (const auto &container : containers_)
+    {
+        total += container.cardinality;
+    }
+    return total;
+}
+
+size_t RoaringBitmap::memoryUsage() const noexcept
+{
+    size_t bytes = containers_.capacity() * sizeof(Container);
+    for (const auto &container : containers_)
+    {
+        bytes += container.array.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+RoaringBitmap &RoaringBitmap::operator&=(const RoaringBitmap &other)
+{
+    return *this = *this & other;
+}
+
+RoaringBitmap operator&(const RoaringBitmap &a, const RoaringBitmap &b)
+{
+    RoaringBitmap result;
+    auto i = a.containers_.begin();
+    auto j = b.containers_.begin();
+    while (i != a.containers_.end() && j != b.containers_.end())
+    {
+        if (i->key < j->key)
+        {
+            ++i;
+        }
+        else if (j->key < i->key)
+        {
+            ++j;
+        }
+        else
+        {
+            RoaringContainer container = intersect(*i++, *j++);
+            if (container.cardinality > 0)
+            {
+                result.containers_.push_back(std::move(container));
+            }
+        }
+    }
+    return result;
+}
+
+RoaringBitmap &RoaringBitmap::operator|=(const RoaringBitmap &other)
+{
+    std::vector<Container> result;
+    result.reserve(containers_.size() + other.containers_.size());
+    auto i = containers_.begin();
+    auto j = other.containers_.begin();
+    while (i != containers_.end() || j != other.containers_.end())
+    {
+        if (j == other.containers_.end() || (i != containers_.end() && i->key < j->key))
+        {
+            result.push_back(std::move(*i++));
+        }
+        else if (i == containers_.end() || j->key < i->key)
+        {
+            result.push_back(*j++);
+        }
+        else
+        {
+            result.push_back(unite(*i++, *j++));
+        }
+    }
+    containers_ = std::move(result);
+    return *this;
+}
+
+RoaringBitmap &RoaringBitmap::andNot(const RoaringBitmap &other)
+{
+    std::vector<Container> result;
+    result.reserve(containers_.size());
+    auto j = other.containers_.begin();
+    for (auto &container : containers_)
+    {
+        while (j != other.containers_.end() && j->key < container.key)
+        {
+            ++j;
+        }
+        if (j == other.containers_.end() || j->key != container.key)
+        {
+            result.push_back(std::move(container));
+            continue;
+        }
+        Container difference = subtract(container, *j);
+        if (difference.cardinality > 0)
+        {
+            result.push_back(std::move(difference));
+        }
+    }
+    containers_ = std::move(result);
+    return *this;
+}
+
+bool RoaringBitmap::operator==(const RoaringBitmap &other) const noexcept
+{
+    return std::equal(containers_.begin(), containers_.end(), other.containers_.begin(), other.containers_.end(),
+                      sameContainer);
+}
+
+std::vector<uint32_t> RoaringBitmap::toIndices() const
+{
+    std::vector<uint32_t> values;
+    values.reserve(cardinality());
+    forEach([&](uint32_t value)
+            { values.push_back(value); });
+    return values;
+}
@@ -0,0 +1,375 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace bitmap_detail
+{
+    // Word kernels shared by Bitmap, RankSelect and RoaringBitmap: SSE2 (AVX2 when the
+    // build enables it) over whole words, scalar for the rest.
+
+    void andWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept;
+    void orWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept;
+    void xorWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept;
+
+    /// out = a & ~b
+    void andNotWords(uint64_t *out, const uint64_t *a, const uint64_t *b, size_t count) noexcept;
+
+    size_t popcountWords(const uint64_t *words, size_t count) noexcept;
+
+    /// popcount(a & b) without materializing it
+    size_t popcountAndWords(const uint64_t *a, const uint64_t *b, size_t count) noexcept;
+
+    /**
+     * @brief The position of the set bit of `word` with `rank` set bits below it.
+     * `word` must have more than `rank` set bits.
+     */
+    unsigned selectInWord(uint64_t word, unsigned rank) noexcept;
+
+    /**
+     * @brief The values of a RoaringBitmap that share their 16 high bits (`key`): a sorted
+     * array of the 16 low bits while there are at most RoaringBitmap::kArrayLimit of them,
+     * a bitmap of 1024 words beyond.
+     */
+    struct RoaringContainer
+    {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array;
+        std::vector<uint64_t> bits;
+
+        bool isBitmap() const noexcept { return !bits.empty(); }
+    };
+} // namespace bitmap_detail
+
+/**
+ * @brief A fixed-size sequence of bits packed into 64-bit words, for validity bitmaps and
+ * selection vectors.
+ *
+ * Bit i lives in word i / 64 at position i % 64, so on little endian machines bytes()
+ * is laid out like an Arrow validity bitmap (and the bitmaps of formats/bit_util.hpp).
+ * The bits past size() in the last word are always zero.
+ *
+ * The boolean operations work a word (or a SIMD register of words) at a time and require
+ * both operands to have the same size.
+ */
+class Bitmap
+{
+public:
+    static constexpr size_t kWordBits = 64;
+
+    Bitmap() = default;
+
+    explicit Bitmap(size_t size, bool value = false);
+
+    /**
+     * @brief A bitmap of `size` bits with the bits at `indices` set.
+     * @throws std::out_of_range if an index is not below `size`
+     */
+    template <typename Index>
+    static Bitmap fromIndices(const Index *indices, size_t count, size_t size)
+    {
+        Bitmap bitmap(size);
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (static_cast<size_t>(indices[i]) >= size)
+            {
+                throw std::out_of_range("Bitmap index out of range");
+            }
+            bitmap.set(static_cast<size_t>(indices[i]));
+        }
+        return bitmap;
+    }
+
+    /**
+     * @brief Copies `size` bits of a byte addressed, least significant bit first bitmap
+     * (e.g. ColumnBatch::validity()), starting at bit `bit_offset`.
+     */
+    static Bitmap fromBits(const uint8_t *bits, size_t bit_offset, size_t size);
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    size_t wordCount() const noexcept { return words_.size(); }
+    const uint64_t *words() const noexcept { return words_.data(); }
+
+    /// Callers writing words directly must keep the bits past size() zero
+    uint64_t *words() noexcept { return words_.data(); }
+
+    const uint8_t *bytes() const noexcept { return reinterpret_cast<const uint8_t *>(words_.data()); }
+
+    bool get(size_t i) const noexcept { return (words_[i / kWordBits] >> (i % kWordBits)) & 1; }
+    bool operator[](size_t i) const noexcept { return get(i); }
+
+    void set(size_t i) noexcept { words_[i / kWordBits] |= uint64_t(1) << (i % kWordBits); }
+    void clear(size_t i) noexcept { words_[i / kWordBits] &= ~(uint64_t(1) << (i % kWordBits)); }
+
+    void setTo(size_t i, bool value) noexcept
+    {
+        uint64_t bit = uint64_t(1) << (i % kWordBits);
+        uint64_t &word = words_[i / kWordBits];
+        word = (word & ~bit) | (value ? bit : 0);
+    }
+
+    /**
+     * @brief Sets the bits in [begin, end) to `value`.
+     */
+    void setRange(size_t begin, size_t end, bool value) noexcept;
+
+    /**
+     * @brief Changes the size; new bits are set to `value`.
+     */
+    void resize(size_t size, bool value = false);
+
+    Bitmap &operator&=(const Bitmap &other);
+    Bitmap &operator|=(const Bitmap &other);
+    Bitmap &operator^=(const Bitmap &other);
+
+    /**
+     * @brief Clears the bits set in `other`.
+     */
+    Bitmap &andNot(const Bitmap &other);
+
+    /**
+     * @brief Inverts every bit.
+     */
+    Bitmap &flip() noexcept;
+
+    friend Bitmap operator&(Bitmap a, const Bitmap &b) { return a &= b; }
+    friend Bitmap operator|(Bitmap a, const Bitmap &b) { return a |= b; }
+    friend Bitmap operator^(Bitmap a, const Bitmap &b) { return a ^= b; }
+
+    /**
+     * @brief The number of set bits.
+     */
+    size_t count() const noexcept;
+
+    /**
+     * @brief The number of bits set in both bitmaps, e.g. the selected rows that are not null.
+     */
+    size_t countAnd(const Bitmap &other) const;
+
+    /**
+     * @brief The position of the first bit at or after `from` that equals `value`, size()
+     * if there is none, e.g. the end of a run of selected rows. Scans a word at a time.
+     */
+    size_t findNext(size_t from, bool value = true) const noexcept;
+
+    bool operator==(const Bitmap &other) const noexcept { return size_ == other.size_ && words_ == other.words_; }
+
+    /**
+     * @brief Calls `f(i)` for every set bit i, in increasing order.
+     */
+    template <typename F>
+    void forEach(F f) const
+    {
+        for (size_t w = 0; w < words_.size(); ++w)
+        {
+            for (uint64_t word = words_[w]; word != 0; word &= word - 1)
+            {
+                f(w * kWordBits + static_cast<size_t>(__builtin_ctzll(word)));
+            }
+        }
+    }
+
+    /**
+     * @brief Writes the positions of the set bits to `out` in increasing order. `out` must
+     * have room for count() indices, each of which must fit in an `Index`.
+     * @return The number of indices written
+     */
+    template <typename Index>
+    size_t toIndices(Index *out) const noexcept
+    {
+        Index *begin = out;
+        forEach([&](size_t i)
+                { *out++ = static_cast<Index>(i); });
+        return static_cast<size_t>(out - begin);
+    }
+
+    std::vector<uint32_t> toIndices() const;
+
+private:
+    void checkSameSize(const Bitmap &other) const;
+
+    /// Clears the bits past size_ in the last word
+    void trim() noexcept;
+
+    size_t size_ = 0;
+    std::vector<uint64_t> words_;
+};
+
+/**
+ * @brief Constant time rank and select over a Bitmap (the "rank9" layout).
+ *
+ * For every 512 bits (8 words) it keeps the number of set bits before them and, packed
+ * into a second word, 9 bit counts of the set bits before each of words 1 to 7 within
+ * them: a rank is two counter loads and one popcount. Select samples the block of every
+ * 512th set bit, searches the blocks between two samples, then the counters of the block
+ * and the word. The index takes 25% of the bitmap's size, plus the samples.
+ *
+ * The bitmap must outlive the index and not change while it is in use.
+ */
+class RankSelect
+{
+public:
+    explicit RankSelect(const Bitmap &bitmap);
+
+    /**
+     * @brief The number of set bits in [0, i), for i up to the size of the bitmap.
+     */
+    size_t rank(size_t i) const noexcept
+    {
+        size_t block = i / kBlockBits;
+        size_t word = (i / Bitmap::kWordBits) % kBlockWords;
+        size_t result = counts_[2 * block];
+        if (word > 0)
+        {
+            result += (counts_[2 * block + 1] >> (9 * (word - 1))) & 0x1ff;
+        }
+        if (size_t bit = i % Bitmap::kWordBits)
+        {
+            result += static_cast<size_t>(
+                __builtin_popcountll(bitmap_->words()[i / Bitmap::kWordBits] & ((uint64_t(1) << bit) - 1)));
+        }
+        return result;
+    }
+
+    /**
+     * @brief The position of the set bit with `k` set bits before it.
+     * @throws std::out_of_range if `k` is not below count()
+     */
+    size_t select(size_t k) const;
+
+    /**
+     * @brief The number of set bits in the bitmap.
+     */
+    size_t count() const noexcept { return count_; }
+
+    size_t memoryUsage() const noexcept
+    {
+        return counts_.capacity() * sizeof(uint64_t) + samples_.capacity() * sizeof(size_t);
+    }
+
+private:
+    static constexpr size_t kBlockWords = 8;
+    static constexpr size_t kBlockBits = kBlockWords * Bitmap::kWordBits;
+    static constexpr size_t kSampleRate = 512;
+
+    const Bitmap *bitmap_;
+    size_t count_ = 0;
+
+    // Two words per block (and one extra block holding the total): the set bits before
+    // the block, then 7 packed 9 bit counts
+    std::vector<uint64_t> counts_;
+
+    // The block holding set bit j * kSampleRate, for every j
+    std::vector<size_t> samples_;
+};
+
+/**
+ * @brief A compressed set of 32-bit values (Roaring bitmap) for sparse selections.
+ *
+ * Values are grouped by their 16 high bits into containers kept sorted by key. A container
+ * holds a sorted array of the low bits while it has at most kArrayLimit values (2 bytes per
+ * value) and a 8KB bitmap beyond, so a selection costs at most about 2 bytes per value,
+ * and much less than a Bitmap of the whole range while it is sparse. The boolean
+ * operations merge the containers key by key, with a specialized kernel per pair of
+ * container kinds. Run length encoded containers are not implemented.
+ */
+class RoaringBitmap
+{
+public:
+    /// Containers with more values than this are bitmaps: the size where both take 8KB
+    static constexpr size_t kArrayLimit = 4096;
+
+    RoaringBitmap() = default;
+
+    static RoaringBitmap fromIndices(const uint32_t *values, size_t count);
+
+    /**
+     * @brief The positions of the set bits of `bitmap`, which must have at most 2^32 bits.
+     */
+    static RoaringBitmap fromBitmap(const Bitmap &bitmap);
+
+    /**
+     * @brief A Bitmap of `size` bits with the bits at the values set.
+     * @throws std::out_of_range if a value is not below `size`
+     */
+    Bitmap toBitmap(size_t size) const;
+
+    /**
+     * @brief Adds `value`. Appending values in increasing order is fastest.
+     */
+    void add(uint32_t value);
+
+    /**
+     * @brief Removes `value`.
+     * @return false if it was not there
+     */
+    bool remove(uint32_t value);
+
+    bool contains(uint32_t value) const noexcept;
+
+    size_t cardinality() const noexcept;
+    bool empty() const noexcept { return containers_.empty(); }
+
+    size_t memoryUsage() const noexcept;
+
+    RoaringBitmap &operator&=(const RoaringBitmap &other);
+    RoaringBitmap &operator|=(const RoaringBitmap &other);
+
+    /**
+     * @brief Removes the values of `other`.
+     */
+    RoaringBitmap &andNot(const RoaringBitmap &other);
+
+    friend RoaringBitmap operator&(const RoaringBitmap &a, const RoaringBitmap &b);
+    friend RoaringBitmap operator|(RoaringBitmap a, const RoaringBitmap &b) { return a |= b; }
+
+    bool operator==(const RoaringBitmap &other) const noexcept;
+
+    /**
+     * @brief Calls `f(value)` for every value, in increasing order.
+     */
+    template <typename F>
+    void forEach(F f) const
+    {
+        for (const auto &container : containers_)
+        {
+            forEachIn(container, f);
+        }
+    }
+
+    std::vector<uint32_t> toIndices() const;
+
+private:
+    using Container = bitmap_detail::RoaringContainer;
+
+    template <typename F>
+    static void forEachIn(const Container &container, F &f)
+    {
+        uint32_t base = static_cast<uint32_t>(container.key) << 16;
+        if (!container.isBitmap())
+        {
+            for (uint16_t low : container.array)
+            {
+                f(base | low);
+            }
+            return;
+        }
+        for (size_t w = 0; w < container.bits.size(); ++w)
+        {
+            for (uint64_t word = container.bits[w]; word != 0; word &= word - 1)
+            {
+                f(base + static_cast<uint32_t>(w * 64 + static_cast<size_t>(__builtin_ctzll(word))));
+            }
+        }
+    }
+
+    /// The container for `key`, if there is one
+    const Container *find(uint16_t key) const noexcept;
+
+    std::vector<Container> containers_;
+};
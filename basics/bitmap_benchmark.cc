@@ -0,0 +1,217 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "bitmap.h"
+
+// Bulk boolean operations over bitmaps of 1K bits (in L1) to 1B bits (125MB each, from
+// memory; BENCHMARK_MAX_SIZE raises the limit), reported in bytes of bitmap read and
+// written per second, against the same loop over words compiled without vectorization.
+// Then rank and select at random positions, conversion to indices, and AND of sparse
+// selections as Bitmaps and as RoaringBitmaps.
+
+namespace
+{
+    void bulkSizes(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(1000000000))
+        {
+            benchmark->Arg(n);
+        }
+        benchmark->Unit(benchmark::kMillisecond);
+    }
+
+    Bitmap randomWords(size_t size, uint64_t seed)
+    {
+        DataGenerator random(seed);
+        Bitmap bitmap(size);
+        for (size_t i = 0; i < bitmap.wordCount(); ++i)
+        {
+            bitmap.words()[i] = random.next();
+        }
+        return bitmap;
+    }
+
+    // Each bit set with probability `density`, drawing the gaps between set bits from the
+    // geometric distribution by inversion
+    Bitmap randomBits(size_t size, double density, uint64_t seed)
+    {
+        DataGenerator random(seed);
+        double scale = 1 / std::log1p(-density);
+        auto gap = [&]()
+        { return static_cast<size_t>(std::log1p(-random.unit()) * scale); };
+        Bitmap bitmap(size);
+        for (size_t i = gap(); i < size; i += gap() + 1)
+        {
+            bitmap.set(i);
+        }
+        return bitmap;
+    }
+
+    __attribute__((optimize("no-tree-vectorize"))) void andScalar(uint64_t *out, const uint64_t *b, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] &= b[i];
+        }
+    }
+
+    __attribute__((optimize("no-tree-vectorize"))) size_t countScalar(const uint64_t *words, size_t count)
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            total += static_cast<size_t>(__builtin_popcountll(words[i]));
+        }
+        return total;
+    }
+
+    /**
+     * @brief Runs `op(a, b)` and reports `streams` bitmaps' worth of bytes per iteration.
+     */
+    template <typename Op>
+    void bulk(benchmark::State &state, int streams, Op op)
+    {
+        auto size = static_cast<size_t>(state.range(0));
+        Bitmap a = randomWords(size, 1);
+        Bitmap b = randomWords(size, 2);
+        for (auto _ : state)
+        {
+            op(a, b);
+            benchmark::DoNotOptimize(a.words());
+            benchmark::ClobberMemory();
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(size / 8 * streams) * state.iterations());
+    }
+} // namespace
+
+static void BM_And(benchmark::State &state)
+{
+    bulk(state, 3, [](Bitmap &a, const Bitmap &b)
+         { a &= b; });
+}
+BENCHMARK(BM_And)->Apply(bulkSizes);
+
+static void BM_AndScalar(benchmark::State &state)
+{
+    bulk(state, 3, [](Bitmap &a, const Bitmap &b)
+         { andScalar(a.words(), b.words(), a.wordCount()); });
+}
+BENCHMARK(BM_AndScalar)->Apply(bulkSizes);
+
+static void BM_Or(benchmark::State &state)
+{
+    bulk(state, 3, [](Bitmap &a, const Bitmap &b)
+         { a |= b; });
+}
+BENCHMARK(BM_Or)->Apply(bulkSizes);
+
+static void BM_AndNot(benchmark::State &state)
+{
+    bulk(state, 3, [](Bitmap &a, const Bitmap &b)
+         { a.andNot(b); });
+}
+BENCHMARK(BM_AndNot)->Apply(bulkSizes);
+
+static void BM_Count(benchmark::State &state)
+{
+    bulk(state, 1, [](Bitmap &a, const Bitmap &)
+         { benchmark::DoNotOptimize(a.count()); });
+}
+BENCHMARK(BM_Count)->Apply(bulkSizes);
+
+static void BM_CountScalar(benchmark::State &state)
+{
+    bulk(state, 1, [](Bitmap &a, const Bitmap &)
+         { benchmark::DoNotOptimize(countScalar(a.words(), a.wordCount())); });
+}
+BENCHMARK(BM_CountScalar)->Apply(bulkSizes);
+
+static void BM_CountAnd(benchmark::State &state)
+{
+    bulk(state, 2, [](Bitmap &a, const Bitmap &b)
+         { benchmark::DoNotOptimize(a.countAnd(b)); });
+}
+BENCHMARK(BM_CountAnd)->Apply(bulkSizes);
+
+static void BM_Rank(benchmark::State &state)
+{
+    constexpr size_t kSize = size_t(1) << 28;
+    Bitmap bitmap = randomWords(kSize, 3);
+    RankSelect index(bitmap);
+    DataGenerator random(4);
+    size_t sum = 0;
+    for (auto _ : state)
+    {
+        sum += index.rank(random.uniform(kSize));
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Rank);
+
+static void BM_Select(benchmark::State &state)
+{
+    constexpr size_t kSize = size_t(1) << 28;
+    Bitmap bitmap = randomWords(kSize, 3);
+    RankSelect index(bitmap);
+    DataGenerator random(4);
+    size_t sum = 0;
+    for (auto _ : state)
+    {
+        sum += index.select(random.uniform(index.count()));
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+    state.counters["index_overhead"] = static_cast<double>(index.memoryUsage()) / static_cast<double>(kSize / 8);
+}
+BENCHMARK(BM_Select);
+
+static void BM_ToIndices(benchmark::State &state)
+{
+    constexpr size_t kSize = size_t(1) << 24;
+    Bitmap bitmap = randomBits(kSize, static_cast<double>(state.range(0)) / 100, 5);
+    std::vector<uint32_t> indices(bitmap.count());
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(bitmap.toIndices(indices.data()));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(kSize) * state.iterations());
+}
+BENCHMARK(BM_ToIndices)->ArgName("percent")->Arg(1)->Arg(10)->Arg(50)->Arg(90);
+
+static void BM_SparseAndBitmap(benchmark::State &state)
+{
+    constexpr size_t kSize = size_t(1) << 28;
+    double density = 1.0 / static_cast<double>(state.range(0));
+    Bitmap a = randomBits(kSize, density, 6);
+    Bitmap b = randomBits(kSize, density * 10, 7);
+    for (auto _ : state)
+    {
+        Bitmap both = a & b;
+        benchmark::DoNotOptimize(both.words());
+    }
+    state.counters["bytes"] = static_cast<double>(a.wordCount() * 8);
+}
+BENCHMARK(BM_SparseAndBitmap)->ArgName("one_in")->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+static void BM_SparseAndRoaring(benchmark::State &state)
+{
+    constexpr size_t kSize = size_t(1) << 28;
+    double density = 1.0 / static_cast<double>(state.range(0));
+    RoaringBitmap a = RoaringBitmap::fromBitmap(randomBits(kSize, density, 6));
+    RoaringBitmap b = RoaringBitmap::fromBitmap(randomBits(kSize, density * 10, 7));
+    for (auto _ : state)
+    {
+        RoaringBitmap both = a & b;
+        benchmark::DoNotOptimize(both.cardinality());
+    }
+    state.counters["bytes"] = static_cast<double>(a.memoryUsage());
+}
+BENCHMARK(BM_SparseAndRoaring)->ArgName("one_in")->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,255 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include "bitmap.h"
+
+namespace
+{
+    Bitmap randomBitmap(size_t size, double density, std::mt19937_64 &rng)
+    {
+        std::bernoulli_distribution bit(density);
+        Bitmap bitmap(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            bitmap.setTo(i, bit(rng));
+        }
+        return bitmap;
+    }
+
+    std::vector<bool> bools(const Bitmap &bitmap)
+    {
+        std::vector<bool> result(bitmap.size());
+        for (size_t i = 0; i < bitmap.size(); ++i)
+        {
+            result[i] = bitmap[i];
+        }
+        return result;
+    }
+} // namespace
+
+TEST(BitmapTest, BooleanOperationsMatchBitByBit)
+{
+    std::mt19937_64 rng(7);
+    for (size_t size : {0, 1, 63, 64, 65, 1000, 4099})
+    {
+        Bitmap a = randomBitmap(size, 0.5, rng);
+        Bitmap b = randomBitmap(size, 0.3, rng);
+        std::vector<bool> x = bools(a);
+        std::vector<bool> y = bools(b);
+
+        Bitmap both = a & b;
+        Bitmap either = a | b;
+        Bitmap one = a ^ b;
+        Bitmap only_a = a;
+        only_a.andNot(b);
+        Bitmap not_a = a;
+        not_a.flip();
+        size_t set = 0;
+        size_t set_both = 0;
+        for (size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(both[i], x[i] && y[i]);
+            ASSERT_EQ(either[i], x[i] || y[i]);
+            ASSERT_EQ(one[i], x[i] != y[i]);
+            ASSERT_EQ(only_a[i], x[i] && !y[i]);
+            ASSERT_EQ(not_a[i], !x[i]);
+            set += x[i];
+            set_both += x[i] && y[i];
+        }
+        EXPECT_EQ(a.count(), set);
+        EXPECT_EQ(a.countAnd(b), set_both);
+        EXPECT_EQ(both.count(), set_both);
+        // The bits past the size stay clear
+        EXPECT_EQ(not_a.count(), size - set);
+    }
+    EXPECT_THROW(Bitmap(10) & Bitmap(11), std::invalid_argument);
+}
+
+TEST(BitmapTest, FindNextMatchesBitByBit)
+{
+    std::mt19937_64 rng(13);
+    for (double density : {0.0, 0.01, 0.5, 0.99, 1.0})
+    {
+        for (size_t size : {0, 1, 64, 65, 1000})
+        {
+            Bitmap bitmap = randomBitmap(size, density, rng);
+            for (bool value : {false, true})
+            {
+                size_t expected = size;
+                for (size_t from = size + 1; from-- > 0;)
+                {
+                    ASSERT_EQ(bitmap.findNext(from, value), expected) << size << " " << from << " " << value;
+                    if (from > 0 && bitmap[from - 1] == value)
+                    {
+                        expected = from - 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST(BitmapTest, ConvertsToAndFromIndicesAndBytes)
+{
+    std::vector<uint32_t> indices = {0, 5, 63, 64, 200, 999};
+    Bitmap bitmap = Bitmap::fromIndices(indices.data(), indices.size(), 1000);
+    EXPECT_EQ(bitmap.count(), indices.size());
+    EXPECT_EQ(bitmap.toIndices(), indices);
+    uint16_t narrow[8];
+    ASSERT_EQ(bitmap.toIndices(narrow), indices.size());
+    EXPECT_EQ(narrow[4], 200);
+    EXPECT_THROW(Bitmap::fromIndices(indices.data(), indices.size(), 999), std::out_of_range);
+
+    // Byte bitmaps at every bit offset
+    std::mt19937_64 rng(3);
+    std::vector<uint8_t> bytes(40);
+    for (auto &byte : bytes)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+    for (size_t offset = 0; offset < 16; ++offset)
+    {
+        Bitmap copy = Bitmap::fromBits(bytes.data(), offset, 300);
+        for (size_t i = 0; i < 300; ++i)
+        {
+            ASSERT_EQ(copy[i], ((bytes[(offset + i) / 8] >> ((offset + i) % 8)) & 1) != 0) << offset << " " << i;
+        }
+        EXPECT_EQ(Bitmap::fromBits(copy.bytes(), 0, 300), copy);
+    }
+
+    Bitmap ranges(300);
+    ranges.setRange(10, 20, true);
+    ranges.setRange(60, 250, true);
+    ranges.setRange(100, 130, false);
+    ranges.setRange(5, 5, true);
+    EXPECT_EQ(ranges.count(), 10u + 190 - 30);
+    EXPECT_TRUE(ranges[64] && ranges[99] && !ranges[100] && ranges[130] && !ranges[250]);
+    ranges.resize(400, true);
+    EXPECT_EQ(ranges.count(), 170u + 100);
+    ranges.resize(70);
+    EXPECT_EQ(ranges.count(), 20u);
+    ranges.resize(200);
+    EXPECT_EQ(ranges.count(), 20u);
+}
+
+TEST(BitmapTest, RankAndSelect)
+{
+    std::mt19937_64 rng(11);
+    for (double density : {0.0001, 0.01, 0.5, 0.99})
+    {
+        for (size_t size : {size_t(0), size_t(511), size_t(512), size_t(100000)})
+        {
+            Bitmap bitmap = randomBitmap(size, density, rng);
+            RankSelect index(bitmap);
+            EXPECT_EQ(index.count(), bitmap.count());
+            std::vector<uint32_t> positions = bitmap.toIndices();
+            size_t rank = 0;
+            for (size_t i = 0; i <= size; ++i)
+            {
+                ASSERT_EQ(index.rank(i), rank) << i;
+                if (i < size && bitmap[i])
+                {
+                    ASSERT_EQ(index.select(rank), i);
+                    ++rank;
+                }
+            }
+            EXPECT_THROW(index.select(positions.size()), std::out_of_range);
+        }
+    }
+
+    // A long gap between the sampled bits
+    Bitmap sparse(1 << 20);
+    for (size_t i = 0; i < 600; ++i)
+    {
+        sparse.set(i);
+    }
+    sparse.set((1 << 20) - 1);
+    RankSelect index(sparse);
+    EXPECT_EQ(index.select(600), (1u << 20) - 1);
+    EXPECT_EQ(index.rank(1 << 20), 601u);
+}
+
+TEST(RoaringBitmapTest, MatchesASet)
+{
+    std::mt19937 rng(5);
+    RoaringBitmap roaring;
+    std::set<uint32_t> reference;
+    // Sparse values everywhere, a dense range that needs a bitmap container, and a range
+    // that crosses container boundaries
+    for (int i = 0; i < 20000; ++i)
+    {
+        uint32_t value = rng();
+        roaring.add(value);
+        reference.insert(value);
+    }
+    size_t memory = roaring.memoryUsage();
+    for (uint32_t value = 70000; value < 70000 + 10000; ++value)
+    {
+        roaring.add(value);
+        reference.insert(value);
+    }
+    // An 8KB bitmap rather than 20KB of array
+    EXPECT_LT(roaring.memoryUsage() - memory, 10000u * 2);
+    for (uint32_t value = 131000; value < 132000; value += 2)
+    {
+        roaring.add(value);
+        reference.insert(value);
+    }
+    EXPECT_EQ(roaring.cardinality(), reference.size());
+    EXPECT_EQ(roaring.toIndices(), std::vector<uint32_t>(reference.begin(), reference.end()));
+    EXPECT_TRUE(roaring.contains(75000));
+    EXPECT_FALSE(roaring.contains(131001));
+
+    // Removing values turns the bitmap container back into an array
+    for (uint32_t value = 70000; value < 70000 + 8000; ++value)
+    {
+        ASSERT_TRUE(roaring.remove(value));
+        reference.erase(value);
+    }
+    EXPECT_FALSE(roaring.remove(70000));
+    EXPECT_EQ(roaring.toIndices(), std::vector<uint32_t>(reference.begin(), reference.end()));
+}
+
+TEST(RoaringBitmapTest, BooleanOperationsMatchBitmaps)
+{
+    std::mt19937_64 rng(9);
+    constexpr size_t kSize = 5 * 65536 + 123;
+    // Every pair of container kinds: sparse and dense chunks in both operands
+    Bitmap a(kSize);
+    Bitmap b(kSize);
+    for (size_t chunk = 0; chunk * 65536 < kSize; ++chunk)
+    {
+        double density_a = chunk % 2 == 0 ? 0.01 : 0.4;
+        double density_b = chunk % 3 == 0 ? 0.01 : 0.3;
+        std::bernoulli_distribution bit_a(density_a), bit_b(density_b);
+        for (size_t i = chunk * 65536; i < std::min(kSize, (chunk + 1) * 65536); ++i)
+        {
+            a.setTo(i, bit_a(rng));
+            b.setTo(i, bit_b(rng));
+        }
+    }
+    RoaringBitmap x = RoaringBitmap::fromBitmap(a);
+    RoaringBitmap y = RoaringBitmap::fromBitmap(b);
+    EXPECT_EQ(x.cardinality(), a.count());
+    EXPECT_EQ(x.toBitmap(kSize), a);
+
+    EXPECT_EQ((x & y).toBitmap(kSize), a & b);
+    EXPECT_EQ((x | y).toBitmap(kSize), a | b);
+    RoaringBitmap difference = x;
+    difference.andNot(y);
+    Bitmap expected = a;
+    expected.andNot(b);
+    EXPECT_EQ(difference.toBitmap(kSize), expected);
+    EXPECT_EQ(RoaringBitmap::fromBitmap(a & b), x & y);
+
+    EXPECT_THROW(x.toBitmap(kSize - 200), std::out_of_range);
+    RoaringBitmap empty;
+    EXPECT_TRUE((x & empty).empty());
+    EXPECT_EQ(x | empty, x);
+}
@@ -0,0 +1,835 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+namespace bplus_tree_detail
+{
+    /// Keys the SIMD search handles: arithmetic types in their natural order
+    template <typename K, typename Compare>
+    constexpr bool kNativeOrder =
+        std::is_arithmetic_v<K> && (std::is_same_v<Compare, std::less<K>> || std::is_same_v<Compare, std::less<>>);
+
+    /**
+     * @brief Number of the sorted `keys[0, n)` ordered before `key` (Strict, the lower bound)
+     * or not after it (the upper bound).
+     *
+     * Nodes hold a few dozen keys, so a linear scan that compares 4 (32 bit) or 2 (64 bit,
+     * SSE4.2) keys per instruction beats a binary search and its mispredicted branches.
+     * Other arithmetic keys use a branchless loop the compiler vectorizes, and all other
+     * keys a binary search with `comp`.
+     */
+    template <bool Strict, typename K, typename Compare>
+    size_t rank(const K *keys, size_t n, const K &key, const Compare &comp)
+    {
+        if constexpr (kNativeOrder<K, Compare>)
+        {
+            size_t count = 0;
+            size_t i = 0;
+#if defined(__SSE2__)
+            if constexpr (std::is_integral_v<K> && sizeof(K) == 4)
+            {
+                // Flipping the sign bit orders unsigned keys as signed ones
+                const __m128i flip = _mm_set1_epi32(std::is_signed_v<K> ? 0 : INT32_MIN);
+                const __m128i needle = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(key)), flip);
+                for (; i + 4 <= n; i += 4)
+                {
+                    __m128i block = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)), flip);
+                    __m128i mask = Strict ? _mm_cmpgt_epi32(needle, block) : _mm_cmpgt_epi32(block, needle);
+                    size_t bits = static_cast<size_t>(__builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(mask))));
+                    count += Strict ? bits : 4 - bits;
+                }
+            }
+#endif
+#if defined(__SSE4_2__)
+            if constexpr (std::is_integral_v<K> && sizeof(K) == 8)
+            {
+                const __m128i flip = _mm_set1_epi64x(std::is_signed_v<K> ? 0 : INT64_MIN);
+                const __m128i needle = _mm_xor_si128(_mm_set1_epi64x(static_cast<int64_t>(key)), flip);
+                for (; i + 2 <= n; i += 2)
+                {
+                    __m128i block = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(keys + i)), flip);
+                    __m128i mask = Strict ? _mm_cmpgt_epi64(needle, block) : _mm_cmpgt_epi64(block, needle);
+                    size_t bits = static_cast<size_t>(__builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(mask))));
+                    count += Strict ? bits : 2 - bits;
+                }
+            }
+#endif
+            for (; i < n; ++i)
+            {
+                count += Strict ? keys[i] < key : !(key < keys[i]);
+            }
+            return count;
+        }
+        else if constexpr (Strict)
+        {
+            return static_cast<size_t>(std::lower_bound(keys, keys + n, key, comp) - keys);
+        }
+        else
+        {
+            return static_cast<size_t>(std::upper_bound(keys, keys + n, key, comp) - keys);
+        }
+    }
+} // namespace bplus_tree_detail
+
+/**
+ * @brief An in-memory B+-tree: an ordered map whose elements all live in the leaves, with
+ * inner nodes holding separator keys only.
+ *
+ * Nodes are sized to `NodeBytes` (a few cache lines by default, and aligned to them) and
+ * keep keys apart from values and child pointers, so a search step reads one contiguous
+ * run of keys, scanned with SIMD for integer keys (see bplus_tree_detail::rank). Leaves are
+ * linked in key order, so a range scan walks leaves without going back up the tree.
+ * bulkLoad() builds the tree bottom-up from sorted input in O(n) with full nodes, which
+ * suits read-mostly indexes.
+ *
+ * Every node but the root stays at least half full: inserts split full nodes, and erases
+ * refill underfull ones from a sibling or merge them with it. Inserting and erasing
+ * invalidate iterators. Not thread-safe.
+ *
+ * @tparam K Key type, default constructible and movable
+ * @tparam V Mapped type, default constructible and movable
+ * @tparam NodeBytes Target size of a node in bytes
+ */
+template <typename K, typename V, typename Compare = std::less<K>, size_t NodeBytes = 512,
+          typename Allocator = std::allocator<std::pair<const K, V>>>
+class BPlusTree
+{
+    static_assert(NodeBytes >= 64, "nodes must hold at least a cache line");
+
+    struct Node
+    {
+        bool leaf;
+        uint32_t count = 0; // Keys in the node
+    };
+
+public:
+    /// Elements a leaf holds
+    static constexpr size_t kLeafCapacity =
+        std::max<size_t>(4, (NodeBytes - 2 * sizeof(void *)) / (sizeof(K) + sizeof(V)));
+    /// Separator keys an inner node holds, one fewer than its children
+    static constexpr size_t kInnerCapacity =
+        std::max<size_t>(4, (NodeBytes - 2 * sizeof(void *)) / (sizeof(K) + sizeof(void *)));
+
+private:
+    static constexpr size_t kMinLeaf = kLeafCapacity / 2;
+    static constexpr size_t kMinInner = kInnerCapacity / 2;
+    // With at least 3 children per inner node, 64 levels hold more elements than memory can
+    static constexpr size_t kMaxHeight = 64;
+
+    struct alignas(64) Leaf : Node
+    {
+        Leaf() : Node{true} {}
+
+        Leaf *next = nullptr;
+        K keys[kLeafCapacity];
+        V values[kLeafCapacity];
+    };
+
+    struct alignas(64) Inner : Node
+    {
+        Inner() : Node{false} {}
+
+        K keys[kInnerCapacity];
+        // Child i holds the keys in [keys[i - 1], keys[i])
+        Node *children[kInnerCapacity + 1];
+    };
+
+    using LeafAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Leaf>;
+    using LeafTraits = std::allocator_traits<LeafAllocator>;
+    using InnerAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Inner>;
+    using InnerTraits = std::allocator_traits<InnerAllocator>;
+
+    // The inner nodes from the root down to a leaf, with the child taken in each
+    struct Path
+    {
+        Inner *nodes[kMaxHeight];
+        size_t children[kMaxHeight];
+        size_t depth = 0;
+    };
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using size_type = size_t;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+
+    template <bool Const>
+    class IteratorBase
+    {
+        using ValueRef = std::conditional_t<Const, const V &, V &>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const K &, ValueRef>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        IteratorBase() = default;
+        IteratorBase(Leaf *leaf, size_t index) : leaf_(leaf), index_(index) {}
+
+        // Mutable iterators convert to const ones
+        template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        IteratorBase(const IteratorBase<OtherConst> &other) : leaf_(other.leaf_), index_(other.index_)
+        {
+        }
+
+        const K &key() const { return leaf_->keys[index_]; }
+        ValueRef value() const { return leaf_->values[index_]; }
+        reference operator*() const { return {key(), value()}; }
+
+        IteratorBase &operator++()
+        {
+            if (++index_ == leaf_->count)
+            {
+                leaf_ = leaf_->next;
+                index_ = 0;
+            }
+            return *this;
+        }
+
+        IteratorBase operator++(int)
+        {
+            IteratorBase previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const IteratorBase &other) const noexcept
+        {
+            return leaf_ == other.leaf_ && index_ == other.index_;
+        }
+        bool operator!=(const IteratorBase &other) const noexcept { return !(*this == other); }
+
+    private:
+        friend class BPlusTree;
+        template <bool>
+        friend class IteratorBase;
+
+        Leaf *leaf_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    using iterator = IteratorBase<false>;
+    using const_iterator = IteratorBase<true>;
+
+    BPlusTree() = default;
+
+    explicit BPlusTree(const Compare &comp, const Allocator &allocator = Allocator())
+        : comp_(comp), leaf_allocator_(allocator), inner_allocator_(allocator)
+    {
+    }
+
+    ~BPlusTree() { clear(); }
+
+    BPlusTree(const BPlusTree &other)
+        : comp_(other.comp_),
+          leaf_allocator_(LeafTraits::select_on_container_copy_construction(other.leaf_allocator_)),
+          inner_allocator_(InnerTraits::select_on_container_copy_construction(other.inner_allocator_))
+    {
+        build(other.begin(), other.size_);
+    }
+
+    BPlusTree &operator=(const BPlusTree &other)
+    {
+        if (this != &other)
+        {
+            BPlusTree copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    BPlusTree(BPlusTree &&other) noexcept
+        : comp_(std::move(other.comp_)), leaf_allocator_(std::move(other.leaf_allocator_)),
+          inner_allocator_(std::move(other.inner_allocator_)), root_(std::exchange(other.root_, nullptr)),
+          height_(std::exchange(other.height_, 0)), size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    BPlusTree &operator=(BPlusTree &&other) noexcept
+    {
+        if (this != &other)
+        {
+            BPlusTree moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    void swap(BPlusTree &other) noexcept
+    {
+        using std::swap;
+        swap(comp_, other.comp_);
+        swap(leaf_allocator_, other.leaf_allocator_);
+        swap(inner_allocator_, other.inner_allocator_);
+        swap(root_, other.root_);
+        swap(height_, other.height_);
+        swap(size_, other.size_);
+    }
+
+    iterator begin() { return iterator(firstLeaf(), 0); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return const_iterator(firstLeaf(), 0); }
+    const_iterator end() const { return const_iterator(); }
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /**
+     * @brief Levels from the root to the leaves, 0 when empty.
+     */
+    size_t height() const noexcept { return height_; }
+
+    Allocator getAllocator() const { return Allocator(leaf_allocator_); }
+
+    void clear() noexcept
+    {
+        if (root_)
+        {
+            release(root_);
+        }
+        root_ = nullptr;
+        height_ = 0;
+        size_ = 0;
+    }
+
+    /**
+     * @brief Replaces the contents with the (key, value) pairs of `[first, last)`, which must
+     * be sorted by strictly increasing key, in O(n).
+     * @throws std::invalid_argument if the keys are not strictly increasing
+     */
+    template <typename ForwardIt>
+    void bulkLoad(ForwardIt first, ForwardIt last)
+    {
+        size_t count = 0;
+        ForwardIt previous = first;
+        for (ForwardIt it = first; it != last; ++it, ++count)
+        {
+            if (count > 0 && !comp_((*previous++).first, (*it).first))
+            {
+                throw std::invalid_argument("BPlusTree::bulkLoad: keys are not strictly increasing");
+            }
+        }
+        clear();
+        build(first, count);
+    }
+
+    /**
+     * @brief Inserts the key with `value` unless the key is present.
+     * @return The element with the key, and whether it was inserted
+     */
+    std::pair<iterator, bool> insert(const K &key, const V &value) { return tryEmplace(key, value); }
+    std::pair<iterator, bool> insert(const K &key, V &&value) { return tryEmplace(key, std::move(value)); }
+
+    /**
+     * @brief Sets the mapped value from `args` unless the key is present, in which case the
+     * arguments are left untouched.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> tryEmplace(const K &key, Args &&...args)
+    {
+        if (!root_)
+        {
+            root_ = newLeaf();
+            height_ = 1;
+        }
+        Path path;
+        Leaf *leaf = descend(key, &path);
+        size_t pos = bplus_tree_detail::rank<true>(leaf->keys, leaf->count, key, comp_);
+        if (pos < leaf->count && !comp_(key, leaf->keys[pos]))
+        {
+            return {iterator(leaf, pos), false};
+        }
+        if (leaf->count < kLeafCapacity)
+        {
+            insertInto(leaf, pos, key, std::forward<Args>(args)...);
+            return {iterator(leaf, pos), true};
+        }
+
+        // Split the full leaf in halves, insert into the half the key belongs to and hand the
+        // new right leaf and its first key to the parent
+        Leaf *right = newLeaf();
+        size_t half = (kLeafCapacity + 1) / 2;
+        std::move(leaf->keys + half, leaf->keys + kLeafCapacity, right->keys);
+        std::move(leaf->values + half, leaf->values + kLeafCapacity, right->values);
+        right->count = static_cast<uint32_t>(kLeafCapacity - half);
+        leaf->count = static_cast<uint32_t>(half);
+        right->next = leaf->next;
+        leaf->next = right;
+        Leaf *target = pos < half ? leaf : right;
+        pos = pos < half ? pos : pos - half;
+        insertInto(target, pos, key, std::forward<Args>(args)...);
+        insertSeparator(path, right->keys[0], right);
+        return {iterator(target, pos), true};
+    }
+
+    /**
+     * @brief Inserts the key with `value`, or assigns `value` to the present key.
+     * @return The element, and whether it was inserted
+     */
+    template <typename M>
+    std::pair<iterator, bool> insertOrAssign(const K &key, M &&value)
+    {
+        auto result = tryEmplace(key, std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first.value() = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    V &operator[](const K &key) { return tryEmplace(key).first.value(); }
+
+    /**
+     * @throws std::out_of_range if the key is not present
+     */
+    V &at(const K &key)
+    {
+        iterator it = find(key);
+        if (it == end())
+        {
+            throw std::out_of_range("BPlusTree::at: key not found");
+        }
+        return it.value();
+    }
+
+    const V &at(const K &key) const { return const_cast<BPlusTree *>(this)->at(key); }
+
+    iterator find(const K &key) { return findImpl(key); }
+    const_iterator find(const K &key) const { return findImpl(key); }
+    bool contains(const K &key) const { return findImpl(key) != end(); }
+    size_t count(const K &key) const { return contains(key) ? 1 : 0; }
+
+    /**
+     * @brief The first element whose key is not before `key`.
+     */
+    iterator lowerBound(const K &key) { return bound<true>(key); }
+    const_iterator lowerBound(const K &key) const { return bound<true>(key); }
+
+    /**
+     * @brief The first element whose key is after `key`.
+     */
+    iterator upperBound(const K &key) { return bound<false>(key); }
+    const_iterator upperBound(const K &key) const { return bound<false>(key); }
+
+    /**
+     * @brief Calls `visit(key, value)` for every element with a key in [low, high), in order.
+     * @return The number of elements visited
+     */
+    template <typename Visitor>
+    size_t forEachInRange(const K &low, const K &high, Visitor visit) const
+    {
+        size_t visited = 0;
+        const_iterator it = lowerBound(low);
+        for (Leaf *leaf = it.leaf_, *first = it.leaf_; leaf; leaf = leaf->next)
+        {
+            // Whole leaves below `high` skip the per element comparison
+            size_t start = leaf == first ? it.index_ : 0;
+            size_t stop = comp_(leaf->keys[leaf->count - 1], high)
+                              ? leaf->count
+                              : bplus_tree_detail::rank<true>(leaf->keys, leaf->count, high, comp_);
+            for (size_t i = start; i < stop; ++i)
+            {
+                visit(static_cast<const K &>(leaf->keys[i]), static_cast<const V &>(leaf->values[i]));
+            }
+            visited += stop > start ? stop - start : 0;
+            if (stop < leaf->count)
+            {
+                break;
+            }
+        }
+        return visited;
+    }
+
+    /**
+     * @return The number of elements removed, 0 or 1
+     */
+    size_t erase(const K &key)
+    {
+        if (!root_)
+        {
+            return 0;
+        }
+        Path path;
+        Leaf *leaf = descend(key, &path);
+        size_t pos = bplus_tree_detail::rank<true>(leaf->keys, leaf->count, key, comp_);
+        if (pos == leaf->count || comp_(key, leaf->keys[pos]))
+        {
+            return 0;
+        }
+        std::move(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+        std::move(leaf->values + pos + 1, leaf->values + leaf->count, leaf->values + pos);
+        --leaf->count;
+        --size_;
+
+        // Refill or merge underfull nodes on the way up; the root may go down to one child
+        Node *node = leaf;
+        for (size_t d = path.depth; d-- > 0 && node->count < (node->leaf ? kMinLeaf : kMinInner);)
+        {
+            rebalance(path.nodes[d], path.children[d]);
+            node = path.nodes[d];
+        }
+        if (root_->count == 0)
+        {
+            Node *old = root_;
+            root_ = root_->leaf ? nullptr : static_cast<Inner *>(root_)->children[0];
+            --height_;
+            if (old->leaf)
+            {
+                deleteNode(static_cast<Leaf *>(old));
+            }
+            else
+            {
+                deleteNode(static_cast<Inner *>(old));
+            }
+        }
+        return 1;
+    }
+
+private:
+    Leaf *firstLeaf() const
+    {
+        Node *node = root_;
+        while (node && !node->leaf)
+        {
+            node = static_cast<Inner *>(node)->children[0];
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    // The leaf that holds `key` if present, recording the inner nodes on the way
+    Leaf *descend(const K &key, Path *path) const
+    {
+        Node *node = root_;
+        while (!node->leaf)
+        {
+            Inner *inner = static_cast<Inner *>(node);
+            size_t child = bplus_tree_detail::rank<false>(inner->keys, inner->count, key, comp_);
+            if (path)
+            {
+                path->nodes[path->depth] = inner;
+                path->children[path->depth++] = child;
+            }
+            node = inner->children[child];
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    iterator findImpl(const K &key) const
+    {
+        if (!root_)
+        {
+            return iterator();
+        }
+        Leaf *leaf = descend(key, nullptr);
+        size_t pos = bplus_tree_detail::rank<true>(leaf->keys, leaf->count, key, comp_);
+        return pos < leaf->count && !comp_(key, leaf->keys[pos]) ? iterator(leaf, pos) : iterator();
+    }
+
+    template <bool Strict>
+    iterator bound(const K &key) const
+    {
+        if (!root_)
+        {
+            return iterator();
+        }
+        Leaf *leaf = descend(key, nullptr);
+        size_t pos = bplus_tree_detail::rank<Strict>(leaf->keys, leaf->count, key, comp_);
+        return pos < leaf->count ? iterator(leaf, pos) : iterator(leaf->next, 0);
+    }
+
+    template <typename... Args>
+    void insertInto(Leaf *leaf, size_t pos, const K &key, Args &&...args)
+    {
+        std::move_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+        std::move_backward(leaf->values + pos, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+        leaf->keys[pos] = key;
+        leaf->values[pos] = V(std::forward<Args>(args)...);
+        ++leaf->count;
+        ++size_;
+    }
+
+    // Adds `child`, whose keys start at `separator`, right of the child the path went
+    // through at each level, splitting full inner nodes up to a new root if need be
+    void insertSeparator(Path &path, K separator, Node *child)
+    {
+        while (path.depth > 0)
+        {
+            --path.depth;
+            Inner *inner = path.nodes[path.depth];
+            size_t pos = path.children[path.depth];
+            if (inner->count < kInnerCapacity)
+            {
+                std::move_backward(inner->keys + pos, inner->keys + inner->count, inner->keys + inner->count + 1);
+                std::move_backward(inner->children + pos + 1, inner->children + inner->count + 1,
+                                   inner->children + inner->count + 2);
+                inner->keys[pos] = std::move(separator);
+                inner->children[pos + 1] = child;
+                ++inner->count;
+                return;
+            }
+
+            // Lay out the kInnerCapacity + 1 keys in order, keep the lower half, push the
+            // middle key up and move the upper half to a new node
+            K keys[kInnerCapacity + 1];
+            Node *children[kInnerCapacity + 2];
+            std::move(inner->keys, inner->keys + pos, keys);
+            keys[pos] = std::move(separator);
+            std::move(inner->keys + pos, inner->keys + kInnerCapacity, keys + pos + 1);
+            std::copy(inner->children, inner->children + pos + 1, children);
+            children[pos + 1] = child;
+            std::copy(inner->children + pos + 1, inner->children + kInnerCapacity + 1, children + pos + 2);
+
+            size_t mid = (kInnerCapacity + 1) / 2;
+            Inner *right = newInner();
+            std::move(keys, keys + mid, inner->keys);
+            std::copy(children, children + mid + 1, inner->children);
+            inner->count = static_cast<uint32_t>(mid);
+            std::move(keys + mid + 1, keys + kInnerCapacity + 1, right->keys);
+            std::copy(children + mid + 1, children + kInnerCapacity + 2, right->children);
+            right->count = static_cast<uint32_t>(kInnerCapacity - mid);
+            separator = std::move(keys[mid]);
+            child = right;
+        }
+        Inner *root = newInner();
+        root->keys[0] = std::move(separator);
+        root->children[0] = root_;
+        root->children[1] = child;
+        root->count = 1;
+        root_ = root;
+        ++height_;
+    }
+
+    // Brings the underfull child `index` of `parent` back to half full, by taking one
+    // element from a sibling with some to spare or by merging with a sibling
+    void rebalance(Inner *parent, size_t index)
+    {
+        Node *child = parent->children[index];
+        Node *left = index > 0 ? parent->children[index - 1] : nullptr;
+        Node *right = index < parent->count ? parent->children[index + 1] : nullptr;
+        size_t min = child->leaf ? kMinLeaf : kMinInner;
+        if (left && left->count > min)
+        {
+            borrowFromLeft(parent, index);
+        }
+        else if (right && right->count > min)
+        {
+            borrowFromRight(parent, index);
+        }
+        else if (left)
+        {
+            merge(parent, index - 1);
+        }
+        else
+        {
+            merge(parent, index);
+        }
+    }
+
+    void borrowFromLeft(Inner *parent, size_t index)
+    {
+        if (parent->children[index]->leaf)
+        {
+            Leaf *child = static_cast<Leaf *>(parent->children[index]);
+            Leaf *left = static_cast<Leaf *>(parent->children[index - 1]);
+            std::move_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
+            std::move_backward(child->values, child->values + child->count, child->values + child->count + 1);
+            child->keys[0] = std::move(left->keys[left->count - 1]);
+            child->values[0] = std::move(left->values[left->count - 1]);
+            parent->keys[index - 1] = child->keys[0];
+            ++child->count;
+            --left->count;
+            return;
+        }
+        Inner *child = static_cast<Inner *>(parent->children[index]);
+        Inner *left = static_cast<Inner *>(parent->children[index - 1]);
+        std::move_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
+        std::move_backward(child->children, child->children + child->count + 1, child->children + child->count + 2);
+        child->keys[0] = std::move(parent->keys[index - 1]);
+        child->children[0] = left->children[left->count];
+        parent->keys[index - 1] = std::move(left->keys[left->count - 1]);
+        ++child->count;
+        --left->count;
+    }
+
+    void borrowFromRight(Inner *parent, size_t index)
+    {
+        if (parent->children[index]->leaf)
+        {
+            Leaf *child = static_cast<Leaf *>(parent->children[index]);
+            Leaf *right = static_cast<Leaf *>(parent->children[index + 1]);
+            child->keys[child->count] = std::move(right->keys[0]);
+            child->values[child->count] = std::move(right->values[0]);
+            std::move(right->keys + 1, right->keys + right->count, right->keys);
+            std::move(right->values + 1, right->values + right->count, right->values);
+            ++child->count;
+            --right->count;
+            parent->keys[index] = right->keys[0];
+            return;
+        }
+        Inner *child = static_cast<Inner *>(parent->children[index]);
+        Inner *right = static_cast<Inner *>(parent->children[index + 1]);
+        child->keys[child->count] = std::move(parent->keys[index]);
+        child->children[child->count + 1] = right->children[0];
+        parent->keys[index] = std::move(right->keys[0]);
+        std::move(right->keys + 1, right->keys + right->count, right->keys);
+        std::copy(right->children + 1, right->children + right->count + 1, right->children);
+        ++child->count;
+        --right->count;
+    }
+
+    // Moves child `index + 1` of `parent` into child `index` and drops it
+    void merge(Inner *parent, size_t index)
+    {
+        if (parent->children[index]->leaf)
+        {
+            Leaf *left = static_cast<Leaf *>(parent->children[index]);
+            Leaf *right = static_cast<Leaf *>(parent->children[index + 1]);
+            std::move(right->keys, right->keys + right->count, left->keys + left->count);
+            std::move(right->values, right->values + right->count, left->values + left->count);
+            left->count += right->count;
+            left->next = right->next;
+            deleteNode(right);
+        }
+        else
+        {
+            Inner *left = static_cast<Inner *>(parent->children[index]);
+            Inner *right = static_cast<Inner *>(parent->children[index + 1]);
+            left->keys[left->count] = std::move(parent->keys[index]);
+            std::move(right->keys, right->keys + right->count, left->keys + left->count + 1);
+            std::copy(right->children, right->children + right->count + 1, left->children + left->count + 1);
+            left->count += right->count + 1;
+            deleteNode(right);
+        }
+        std::move(parent->keys + index + 1, parent->keys + parent->count, parent->keys + index);
+        std::copy(parent->children + index + 2, parent->children + parent->count + 1, parent->children + index + 1);
+        --parent->count;
+    }
+
+    // Builds the tree from `count` sorted elements starting at `first`, level by level:
+    // elements are spread evenly over the fewest leaves that hold them, so every node is
+    // at least half full, and each level above gets the first key of every node below.
+    template <typename ForwardIt>
+    void build(ForwardIt first, size_t count)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        std::vector<std::pair<Node *, K>> level;
+        size_t leaves = (count + kLeafCapacity - 1) / kLeafCapacity;
+        level.reserve(leaves);
+        Leaf *previous = nullptr;
+        for (size_t l = 0; l < leaves; ++l)
+        {
+            Leaf *leaf = newLeaf();
+            size_t n = count / leaves + (l < count % leaves ? 1 : 0);
+            for (size_t i = 0; i < n; ++i, ++first)
+            {
+                auto &&element = *first;
+                leaf->keys[i] = element.first;
+                leaf->values[i] = element.second;
+            }
+            leaf->count = static_cast<uint32_t>(n);
+            if (previous)
+            {
+                previous->next = leaf;
+            }
+            previous = leaf;
+            level.emplace_back(leaf, leaf->keys[0]);
+        }
+        size_ = count;
+        height_ = 1;
+        while (level.size() > 1)
+        {
+            std::vector<std::pair<Node *, K>> parents;
+            size_t nodes = (level.size() + kInnerCapacity) / (kInnerCapacity + 1);
+            parents.reserve(nodes);
+            size_t next = 0;
+            for (size_t p = 0; p < nodes; ++p)
+            {
+                Inner *inner = newInner();
+                size_t n = level.size() / nodes + (p < level.size() % nodes ? 1 : 0);
+                for (size_t i = 0; i < n; ++i, ++next)
+                {
+                    inner->children[i] = level[next].first;
+                    if (i > 0)
+                    {
+                        inner->keys[i - 1] = std::move(level[next].second);
+                    }
+                }
+                inner->count = static_cast<uint32_t>(n - 1);
+                parents.emplace_back(inner, std::move(level[next - n].second));
+            }
+            level = std::move(parents);
+            ++height_;
+        }
+        root_ = level[0].first;
+    }
+
+    Leaf *newLeaf()
+    {
+        Leaf *leaf = LeafTraits::allocate(leaf_allocator_, 1);
+        LeafTraits::construct(leaf_allocator_, leaf);
+        return leaf;
+    }
+
+    Inner *newInner()
+    {
+        Inner *inner = InnerTraits::allocate(inner_allocator_, 1);
+        InnerTraits::construct(inner_allocator_, inner);
+        return inner;
+    }
+
+    void deleteNode(Leaf *leaf) noexcept
+    {
+        LeafTraits::destroy(leaf_allocator_, leaf);
+        LeafTraits::deallocate(leaf_allocator_, leaf, 1);
+    }
+
+    void deleteNode(Inner *inner) noexcept
+    {
+        InnerTraits::destroy(inner_allocator_, inner);
+        InnerTraits::deallocate(inner_allocator_, inner, 1);
+    }
+
+    void release(Node *node) noexcept
+    {
+        if (node->leaf)
+        {
+            deleteNode(static_cast<Leaf *>(node));
+            return;
+        }
+        Inner *inner = static_cast<Inner *>(node);
+        for (size_t i = 0; i <= inner->count; ++i)
+        {
+            release(inner->children[i]);
+        }
+        deleteNode(inner);
+    }
+
+    [[no_unique_address]] Compare comp_;
+    [[no_unique_address]] LeafAllocator leaf_allocator_;
+    [[no_unique_address]] InnerAllocator inner_allocator_;
+    Node *root_ = nullptr;
+    size_t height_ = 0;
+    size_t size_ = 0;
+};
@@ -0,0 +1,184 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "bplus_tree.h"
+
+// BPlusTree against std::map with n random 64 bit keys (even numbers, so odd keys miss):
+// building by bulk load or by inserts, point lookups in random order, and range scans of
+// 100 and 10000 elements from random start keys, summing the values. n runs from 1K to 10M
+// (1M for inserts); BENCHMARK_MAX_SIZE raises the limit.
+
+namespace
+{
+    using Tree = BPlusTree<int64_t, int64_t>;
+    using Map = std::map<int64_t, int64_t>;
+
+    void treeSizes(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(10000000))
+        {
+            benchmark->Arg(n);
+        }
+        benchmark->Unit(benchmark::kMicrosecond);
+    }
+
+    // Building by inserts is slower by an order of magnitude
+    void insertSizes(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(1000000))
+        {
+            benchmark->Arg(n);
+        }
+        benchmark->Unit(benchmark::kMicrosecond);
+    }
+
+    std::vector<std::pair<int64_t, int64_t>> sortedPairs(size_t n)
+    {
+        std::vector<uint64_t> keys = uniformIntegers(n, uint64_t{1} << 62, 1);
+        std::vector<std::pair<int64_t, int64_t>> pairs(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            pairs[i].first = static_cast<int64_t>(keys[i]) * 2;
+            pairs[i].second = pairs[i].first / 2;
+        }
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+        return pairs;
+    }
+
+    template <typename Container>
+    Container build(const std::vector<std::pair<int64_t, int64_t>> &pairs)
+    {
+        if constexpr (std::is_same_v<Container, Tree>)
+        {
+            Tree tree;
+            tree.bulkLoad(pairs.begin(), pairs.end());
+            return tree;
+        }
+        else
+        {
+            return Map(pairs.begin(), pairs.end());
+        }
+    }
+
+    int64_t lookup(const Tree &tree, int64_t key)
+    {
+        auto it = tree.find(key);
+        return it == tree.end() ? 0 : it.value();
+    }
+
+    int64_t lookup(const Map &map, int64_t key)
+    {
+        auto it = map.find(key);
+        return it == map.end() ? 0 : it->second;
+    }
+
+    int64_t sumRange(const Tree &tree, int64_t start, size_t count)
+    {
+        int64_t sum = 0;
+        size_t i = 0;
+        for (auto it = tree.lowerBound(start); it != tree.end() && i < count; ++it, ++i)
+        {
+            sum += it.value();
+        }
+        return sum;
+    }
+
+    int64_t sumRange(const Map &map, int64_t start, size_t count)
+    {
+        int64_t sum = 0;
+        size_t i = 0;
+        for (auto it = map.lower_bound(start); it != map.end() && i < count; ++it, ++i)
+        {
+            sum += it->second;
+        }
+        return sum;
+    }
+} // namespace
+
+template <typename Container>
+static void BM_BulkBuild(benchmark::State &state)
+{
+    auto pairs = sortedPairs(static_cast<size_t>(state.range(0)));
+    for (auto _ : state)
+    {
+        Container container = build<Container>(pairs);
+        benchmark::DoNotOptimize(container.size());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(pairs.size()));
+}
+
+template <typename Container>
+static void BM_RandomInsert(benchmark::State &state)
+{
+    auto pairs = sortedPairs(static_cast<size_t>(state.range(0)));
+    shuffleValues(pairs, 2);
+    for (auto _ : state)
+    {
+        Container container;
+        for (const auto &[key, value] : pairs)
+        {
+            container[key] = value;
+        }
+        benchmark::DoNotOptimize(container.size());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(pairs.size()));
+}
+
+template <typename Container>
+static void BM_PointLookup(benchmark::State &state)
+{
+    auto pairs = sortedPairs(static_cast<size_t>(state.range(0)));
+    Container container = build<Container>(pairs);
+    // Half hits, half misses
+    std::vector<int64_t> probes;
+    for (size_t i = 0; i < pairs.size(); ++i)
+    {
+        probes.push_back(pairs[i].first + static_cast<int64_t>(i % 2));
+    }
+    shuffleValues(probes, 3);
+    for (auto _ : state)
+    {
+        int64_t sum = 0;
+        for (int64_t key : probes)
+        {
+            sum += lookup(container, key);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(probes.size()));
+}
+
+template <typename Container>
+static void BM_RangeScan(benchmark::State &state)
+{
+    auto pairs = sortedPairs(static_cast<size_t>(state.range(0)));
+    Container container = build<Container>(pairs);
+    size_t length = static_cast<size_t>(state.range(1));
+    DataGenerator random(4);
+    int64_t scanned = 0;
+    for (auto _ : state)
+    {
+        int64_t start = pairs[random.uniform(pairs.size())].first;
+        benchmark::DoNotOptimize(sumRange(container, start, length));
+        scanned += static_cast<int64_t>(length);
+    }
+    state.SetItemsProcessed(scanned);
+}
+
+BENCHMARK_TEMPLATE(BM_BulkBuild, Tree)->Apply(treeSizes);
+BENCHMARK_TEMPLATE(BM_BulkBuild, Map)->Apply(treeSizes);
+BENCHMARK_TEMPLATE(BM_RandomInsert, Tree)->Apply(insertSizes);
+BENCHMARK_TEMPLATE(BM_RandomInsert, Map)->Apply(insertSizes);
+BENCHMARK_TEMPLATE(BM_PointLookup, Tree)->Apply(treeSizes);
+BENCHMARK_TEMPLATE(BM_PointLookup, Map)->Apply(treeSizes);
+BENCHMARK_TEMPLATE(BM_RangeScan, Tree)->ArgsProduct({{1000000}, {100, 10000}});
+BENCHMARK_TEMPLATE(BM_RangeScan, Map)->ArgsProduct({{1000000}, {100, 10000}});
+
+BENCHMARK_MAIN();
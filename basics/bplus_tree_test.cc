@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bplus_tree.h"
+
+namespace
+{
+    /**
+     * @brief Checks that the tree holds exactly the elements of `expected`, in order, both
+     * by iteration and by lookup.
+     */
+    template <typename Tree, typename Map>
+    void expectSameContents(const Tree &tree, const Map &expected)
+    {
+        ASSERT_EQ(tree.size(), expected.size());
+        auto it = expected.begin();
+        for (auto [key, value] : tree)
+        {
+            ASSERT_NE(it, expected.end());
+            ASSERT_EQ(key, it->first);
+            ASSERT_EQ(value, it->second);
+            ++it;
+        }
+        EXPECT_EQ(it, expected.end());
+        for (const auto &[key, value] : expected)
+        {
+            ASSERT_EQ(tree.at(key), value);
+        }
+    }
+} // namespace
+
+TEST(BPlusTreeTest, InsertFindErase)
+{
+    BPlusTree<int, std::string> tree;
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.height(), 0u);
+    EXPECT_EQ(tree.find(1), tree.end());
+    EXPECT_EQ(tree.begin(), tree.end());
+
+    EXPECT_TRUE(tree.insert(2, "two").second);
+    EXPECT_FALSE(tree.insert(2, "deux").second);
+    EXPECT_TRUE(tree.insertOrAssign(1, "one").second);
+    EXPECT_FALSE(tree.insertOrAssign(1, "un").second);
+    tree[3] = "three";
+    EXPECT_EQ(tree.size(), 3u);
+    EXPECT_EQ(tree.at(1), "un");
+    EXPECT_EQ(tree.find(2).value(), "two");
+    EXPECT_TRUE(tree.contains(3));
+    EXPECT_EQ(tree.count(4), 0u);
+    EXPECT_THROW(tree.at(4), std::out_of_range);
+    EXPECT_EQ(tree.lowerBound(2).key(), 2);
+    EXPECT_EQ(tree.upperBound(2).key(), 3);
+    EXPECT_EQ(tree.upperBound(3), tree.end());
+
+    EXPECT_EQ(tree.erase(2), 1u);
+    EXPECT_EQ(tree.erase(2), 0u);
+    EXPECT_EQ(tree.erase(1), 1u);
+    EXPECT_EQ(tree.erase(3), 1u);
+    EXPECT_TRUE(tree.empty());
+    EXPECT_EQ(tree.height(), 0u);
+}
+
+TEST(BPlusTreeTest, MatchesStdMapUnderRandomOperations)
+{
+    // Small nodes give deep trees, so splits, borrows and merges happen at every level
+    BPlusTree<int32_t, int32_t, std::less<int32_t>, 64> small;
+    BPlusTree<int32_t, int32_t> large;
+    std::map<int32_t, int32_t> expected;
+    std::mt19937 rng(11);
+    for (int step = 0; step < 60000; ++step)
+    {
+        // Negative keys check that the SIMD search orders signed keys
+        int32_t key = static_cast<int32_t>(rng() % 4000) - 2000;
+        // Grow, then shrink to empty, then grow again
+        bool grow = step < 25000 || step > 45000;
+        switch (rng() % 4)
+        {
+        case 0:
+        case 1:
+            if (grow)
+            {
+                expected[key] = step;
+                small.insertOrAssign(key, step);
+                large.insertOrAssign(key, step);
+                break;
+            }
+            [[fallthrough]];
+        case 2:
+            ASSERT_EQ(small.erase(key), expected.count(key));
+            ASSERT_EQ(large.erase(key), expected.erase(key));
+            break;
+        default:
+            auto found = expected.lower_bound(key);
+            auto small_found = small.lowerBound(key);
+            ASSERT_EQ(small_found == small.end(), found == expected.end());
+            ASSERT_TRUE(found == expected.end() || small_found.key() == found->first);
+            ASSERT_EQ(large.contains(key), expected.count(key) == 1);
+        }
+    }
+    expectSameContents(small, expected);
+    expectSameContents(large, expected);
+    EXPECT_GE(small.height(), 4u);
+}
+
+TEST(BPlusTreeTest, OrdersUnsignedAndSixtyFourBitKeys)
+{
+    BPlusTree<uint32_t, int, std::less<uint32_t>, 128> narrow;
+    BPlusTree<uint64_t, int, std::less<uint64_t>, 128> wide;
+    std::map<uint32_t, int> expected_narrow;
+    std::map<uint64_t, int> expected_wide;
+    std::mt19937_64 rng(5);
+    for (int i = 0; i < 5000; ++i)
+    {
+        // Keys above the signed range check the sign flip of the unsigned search
+        uint64_t key = rng();
+        narrow[static_cast<uint32_t>(key)] = i;
+        expected_narrow[static_cast<uint32_t>(key)] = i;
+        wide[key] = i;
+        expected_wide[key] = i;
+    }
+    expectSameContents(narrow, expected_narrow);
+    expectSameContents(wide, expected_wide);
+    EXPECT_EQ(wide.upperBound(UINT64_MAX), wide.end());
+    EXPECT_EQ(wide.lowerBound(0).key(), expected_wide.begin()->first);
+}
+
+TEST(BPlusTreeTest, BulkLoad)
+{
+    for (size_t count : {0u, 1u, 7u, 100u, 12345u})
+    {
+        std::vector<std::pair<int64_t, int64_t>> sorted;
+        std::map<int64_t, int64_t> expected;
+        for (size_t i = 0; i < count; ++i)
+        {
+            sorted.emplace_back(static_cast<int64_t>(i * 3), static_cast<int64_t>(i));
+            expected[static_cast<int64_t>(i * 3)] = static_cast<int64_t>(i);
+        }
+        BPlusTree<int64_t, int64_t, std::less<int64_t>, 128> tree;
+        tree[-1] = -1;
+        tree.bulkLoad(sorted.begin(), sorted.end());
+        expectSameContents(tree, expected);
+
+        // The bulk loaded tree keeps working as an ordinary one
+        for (size_t i = 0; i < count; i += 2)
+        {
+            tree.erase(static_cast<int64_t>(i * 3));
+            expected.erase(static_cast<int64_t>(i * 3));
+            tree[static_cast<int64_t>(i * 3 + 1)] = 1;
+            expected[static_cast<int64_t>(i * 3 + 1)] = 1;
+        }
+        expectSameContents(tree, expected);
+    }
+
+    std::vector<std::pair<int, int>> unsorted = {{1, 1}, {3, 3}, {3, 4}};
+    BPlusTree<int, int> tree;
+    tree[7] = 7;
+    EXPECT_THROW(tree.bulkLoad(unsorted.begin(), unsorted.end()), std::invalid_argument);
+    EXPECT_EQ(tree.at(7), 7);
+}
+
+TEST(BPlusTreeTest, RangeScans)
+{
+    std::vector<std::pair<int, int>> sorted;
+    for (int i = 0; i < 10000; ++i)
+    {
+        sorted.emplace_back(i * 2, i);
+    }
+    BPlusTree<int, int, std::less<int>, 128> tree;
+    tree.bulkLoad(sorted.begin(), sorted.end());
+
+    std::vector<int> keys;
+    EXPECT_EQ(tree.forEachInRange(101, 141, [&](int key, int) { keys.push_back(key); }), 20u);
+    ASSERT_EQ(keys.size(), 20u);
+    EXPECT_EQ(keys.front(), 102);
+    EXPECT_EQ(keys.back(), 140);
+    EXPECT_EQ(tree.forEachInRange(100, 100, [](int, int) {}), 0u);
+    EXPECT_EQ(tree.forEachInRange(-50, 1000000, [](int, int) {}), 10000u);
+    EXPECT_EQ(tree.forEachInRange(19999, 30000, [](int, int) {}), 0u);
+
+    size_t visited = 0;
+    for (auto it = tree.lowerBound(5000); it != tree.end() && it.key() < 6000; ++it)
+    {
+        EXPECT_EQ(it.value(), it.key() / 2);
+        ++visited;
+    }
+    EXPECT_EQ(visited, 500u);
+}
+
+TEST(BPlusTreeTest, StringKeysCopiesAndMoves)
+{
+    BPlusTree<std::string, int, std::less<std::string>, 256> tree;
+    std::map<std::string, int> expected;
+    for (int i = 0; i < 2000; ++i)
+    {
+        std::string key = "key-";
+        key += std::to_string(i * 7919 % 2000);
+        tree[key] = i;
+        expected[key] = i;
+    }
+    BPlusTree<std::string, int, std::less<std::string>, 256> copy = tree;
+    for (int i = 0; i < 2000; i += 3)
+    {
+        std::string key = "key-";
+        key += std::to_string(i);
+        copy.erase(key);
+    }
+    expectSameContents(tree, expected);
+
+    BPlusTree<std::string, int, std::less<std::string>, 256> moved = std::move(tree);
+    EXPECT_TRUE(tree.empty());
+    expectSameContents(moved, expected);
+    copy = moved;
+    expectSameContents(copy, expected);
+}
@@ -1,19 +1,27 @@
 #pragma once
 
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 /**
  * Similar to std::vector, but with a chunk size. Adding elements to the end of the vector will
  * create a new chunk if the current chunk is full and add the element to the new chunk.
+ *
+ * The chunks and the list of chunks are allocated with `Allocator` (e.g. an ArenaAllocator).
  */
-template <typename T>
+template <typename T, typename Allocator = std::allocator<T>>
 class ChunkedVector
 {
 public:
-    ChunkedVector(size_t chunk_size) : chunk_size_(chunk_size) 
+    using Chunk = std::vector<T, Allocator>;
+
+    ChunkedVector(size_t chunk_size, const Allocator &allocator = Allocator())
+        : chunk_size_(chunk_size), allocator_(allocator), chunks_(ChunkAllocator(allocator))
     {
         // Start with one chunk
-        chunks_.push_back(std::vector<T>());
+        chunks_.push_back(Chunk(allocator_));
         chunks_.back().reserve(chunk_size);
     }
 
@@ -22,7 +30,7 @@ public:
         // If current chunk is full, create a new one
         if (chunks_.back().size() == chunk_size_)
         {
-            chunks_.push_back(std::vector<T>());
+            chunks_.push_back(Chunk(allocator_));
             chunks_.back().reserve(chunk_size_);
         }
         
@@ -32,11 +40,8 @@ public:
 
     T &operator[](size_t index)
     {
-        size_t total_size = 0;
-        for (const auto& chunk : chunks_) {
-            total_size += chunk.size();
-        }
-        
+        // Every chunk but the last one is full
+        size_t total_size = (chunks_.size() - 1) * chunk_size_ + chunks_.back().size();
         if (index >= total_size) {
             throw std::out_of_range("Index out of bounds");
         }
@@ -74,8 +79,9 @@ public:
                 chunks_[i].shrink_to_fit();
             }
 
-            // Remove the cleared chunks
-            chunks_.resize(1);
+            // Remove the cleared chunks; erase, as resize() needs a default constructible
+            // allocator
+            chunks_.erase(chunks_.begin() + 1, chunks_.end());
 
             chunk_size_ = total_size;
         }
@@ -104,10 +110,14 @@ public:
     void clear()
     {
         chunks_.clear();
-        chunks_.push_back(std::vector<T>(0, T(), chunk_size_));
+        chunks_.push_back(Chunk(allocator_));
+        chunks_.back().reserve(chunk_size_);
     }
 
 private:
+    using ChunkAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Chunk>;
+
     size_t chunk_size_;
-    std::vector<std::vector<T>> chunks_;
+    [[no_unique_address]] Allocator allocator_;
+    std::vector<Chunk, ChunkAllocator> chunks_;
 };
@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "chunked_vector.h"
+
+// ChunkedVector (4096 element chunks) against std::vector and std::deque with n from 1K to
+// 10M uint64_t (BENCHMARK_MAX_SIZE raises the limit): appending n values to an empty
+// container, reading them back in order and reading n uniformly random positions.
+
+namespace
+{
+    constexpr size_t kChunkSize = 4096;
+
+    struct Chunked
+    {
+        ChunkedVector<uint64_t> values{kChunkSize};
+
+        void pushBack(uint64_t value) { values.pushBack(value); }
+        uint64_t at(size_t i) { return values[i]; }
+    };
+
+    struct Vector
+    {
+        std::vector<uint64_t> values;
+
+        void pushBack(uint64_t value) { values.push_back(value); }
+        uint64_t at(size_t i) { return values[i]; }
+    };
+
+    struct Deque
+    {
+        std::deque<uint64_t> values;
+
+        void pushBack(uint64_t value) { values.push_back(value); }
+        uint64_t at(size_t i) { return values[i]; }
+    };
+
+    void containerSizes(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(10000000))
+        {
+            benchmark->Arg(n);
+        }
+        benchmark->Unit(benchmark::kMicrosecond);
+    }
+
+    template <typename Container>
+    void fill(Container &container, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+        {
+            container.pushBack(i);
+        }
+    }
+} // namespace
+
+template <typename Container>
+static void BM_PushBack(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    for (auto _ : state)
+    {
+        Container container;
+        fill(container, n);
+        benchmark::DoNotOptimize(container.values);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Container>
+static void BM_SequentialRead(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    Container container;
+    fill(container, n);
+    for (auto _ : state)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < n; ++i)
+        {
+            sum += container.at(i);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Container>
+static void BM_RandomRead(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    Container container;
+    fill(container, n);
+    std::vector<uint64_t> positions = uniformIntegers(n, n, 1);
+    for (auto _ : state)
+    {
+        uint64_t sum = 0;
+        for (uint64_t position : positions)
+        {
+            sum += container.at(position);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_PushBack, Chunked)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_PushBack, Vector)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_PushBack, Deque)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_SequentialRead, Chunked)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_SequentialRead, Vector)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_SequentialRead, Deque)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_RandomRead, Chunked)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_RandomRead, Vector)->Apply(containerSizes);
+BENCHMARK_TEMPLATE(BM_RandomRead, Deque)->Apply(containerSizes);
+
+BENCHMARK_MAIN();
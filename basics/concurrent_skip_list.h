@@ -0,0 +1,366 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace skip_list_detail
+{
+    /**
+     * @brief A bump allocator many threads allocate from at once. Memory is only returned
+     * when the arena is destroyed.
+     *
+     * Threads claim space in the current block with one fetch_add; the thread that runs
+     * past the end takes a lock to install the next block, which is the only blocking step.
+     */
+    class ConcurrentArena
+    {
+    public:
+        explicit ConcurrentArena(size_t block_size) : block_size_(block_size) {}
+
+        ~ConcurrentArena()
+        {
+            for (Block *block : blocks_)
+            {
+                ::operator delete(block, std::align_val_t(kAlignment));
+            }
+        }
+
+        ConcurrentArena(const ConcurrentArena &) = delete;
+        ConcurrentArena &operator=(const ConcurrentArena &) = delete;
+
+        /**
+         * @return `size` bytes aligned to `kAlignment`
+         */
+        void *allocate(size_t size)
+        {
+            size = (size + kAlignment - 1) & ~(kAlignment - 1);
+            while (true)
+            {
+                Block *block = current_.load(std::memory_order_acquire);
+                if (block)
+                {
+                    size_t offset = block->used.fetch_add(size, std::memory_order_relaxed);
+                    if (offset + size <= block->capacity)
+                    {
+                        return block->data() + offset;
+                    }
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (current_.load(std::memory_order_relaxed) == block)
+                {
+                    size_t capacity = std::max(block_size_, size);
+                    void *memory = ::operator new(sizeof(Block) + capacity, std::align_val_t(kAlignment));
+                    Block *next = new (memory) Block{{0}, capacity};
+                    blocks_.push_back(next);
+                    bytes_.fetch_add(sizeof(Block) + capacity, std::memory_order_relaxed);
+                    current_.store(next, std::memory_order_release);
+                }
+            }
+        }
+
+        /**
+         * @brief Bytes of memory held, including the unused ends of blocks.
+         */
+        size_t memoryUsage() const noexcept { return bytes_.load(std::memory_order_relaxed); }
+
+        static constexpr size_t kAlignment = 16;
+
+    private:
+        struct alignas(kAlignment) Block
+        {
+            std::atomic<size_t> used;
+            size_t capacity;
+
+            uint8_t *data() { return reinterpret_cast<uint8_t *>(this + 1); }
+        };
+
+        const size_t block_size_;
+        std::atomic<Block *> current_{nullptr};
+        std::atomic<size_t> bytes_{0};
+        std::mutex mutex_;
+        std::vector<Block *> blocks_;
+    };
+} // namespace skip_list_detail
+
+/**
+ * @brief An ordered set of (key, value) pairs that many threads insert into and read from
+ * at once without locks, meant as the in-memory write buffer in front of a file writer.
+ *
+ * The structure is a skip list whose links are atomic pointers. An insert finds the
+ * neighbours of its key on every level and links the new node bottom-up, each link with
+ * a single compare-and-swap; when another writer got there first the insert searches
+ * that level again from its old predecessor, so writers never wait for each other.
+ * Elements are never removed or changed once inserted, which makes reads plain acquire
+ * loads: lookups and iteration neither lock nor retry, and run alongside writers.
+ *
+ * An iterator walks the bottom level in key order. It sees every element inserted
+ * before it was created, never sees an element twice or out of order, and may or may
+ * not see elements inserted while it runs, so a scan started after a batch of writes
+ * returned is a consistent view of at least that batch.
+ *
+ * Nodes come from an arena owned by the list and are freed all at once with it.
+ *
+ * @tparam K Key type, copy or move constructible
+ * @tparam V Value type, copy or move constructible
+ */
+template <typename K, typename V, typename Compare = std::less<K>>
+class ConcurrentSkipList
+{
+public:
+    /// Levels of the tallest node; with a branching factor of 4 this suits up to 4^12 (16M)
+    /// elements, and larger lists only get slightly longer searches
+    static constexpr int kMaxHeight = 12;
+
+private:
+    struct Node
+    {
+        template <typename Key, typename... Args>
+        Node(int height, Key &&key, Args &&...args)
+            : key(std::forward<Key>(key)), value(std::forward<Args>(args)...), height(height)
+        {
+        }
+
+        const K key;
+        const V value;
+        const int height;
+        // `height` links, the rest allocated past the end of the node
+        std::atomic<Node *> next[1];
+
+        std::atomic<Node *> &link(int level) { return next[level]; }
+    };
+
+    static_assert(alignof(Node) <= skip_list_detail::ConcurrentArena::kAlignment, "over-aligned keys or values");
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using size_type = size_t;
+    using key_compare = Compare;
+
+    /**
+     * @brief Forward iterator over the elements in key order. Safe to use while other
+     * threads insert.
+     */
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<const K &, const V &>;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_type;
+        using pointer = void;
+
+        Iterator() = default;
+        explicit Iterator(Node *node) : node_(node) {}
+
+        const K &key() const { return node_->key; }
+        const V &value() const { return node_->value; }
+        reference operator*() const { return {node_->key, node_->value}; }
+
+        Iterator &operator++()
+        {
+            node_ = node_->link(0).load(std::memory_order_acquire);
+            return *this;
+        }
+
+        Iterator operator++(int)
+        {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const Iterator &other) const noexcept { return node_ == other.node_; }
+        bool operator!=(const Iterator &other) const noexcept { return node_ != other.node_; }
+
+    private:
+        Node *node_ = nullptr;
+    };
+
+    using iterator = Iterator;
+    using const_iterator = Iterator;
+
+    /**
+     * @param block_size Bytes the arena allocates at a time
+     */
+    explicit ConcurrentSkipList(const Compare &comp = Compare(), size_t block_size = 1 << 20)
+        : comp_(comp), arena_(block_size)
+    {
+        for (std::atomic<Node *> &link : head_)
+        {
+            link.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~ConcurrentSkipList()
+    {
+        if constexpr (!std::is_trivially_destructible_v<Node>)
+        {
+            for (Node *node = head_[0].load(std::memory_order_relaxed); node;)
+            {
+                Node *next = node->link(0).load(std::memory_order_relaxed);
+                node->~Node();
+                node = next;
+            }
+        }
+    }
+
+    ConcurrentSkipList(const ConcurrentSkipList &) = delete;
+    ConcurrentSkipList &operator=(const ConcurrentSkipList &) = delete;
+
+    /**
+     * @brief Inserts the key with a value built from `args` unless the key is present.
+     * Safe to call from many threads at once.
+     * @return Whether the element was inserted
+     */
+    template <typename Key, typename... Args>
+    bool emplace(Key &&key, Args &&...args)
+    {
+        Node *prev[kMaxHeight];
+        Node *next[kMaxHeight];
+        int height = randomHeight();
+        int list_height = height_.load(std::memory_order_relaxed);
+        while (height > list_height &&
+               !height_.compare_exchange_weak(list_height, height, std::memory_order_relaxed))
+        {
+        }
+        int top = std::max(height, list_height);
+
+        Node *before = nullptr;
+        for (int level = top - 1; level >= 0; --level)
+        {
+            findSplice(key, before, level, &prev[level], &next[level]);
+            before = prev[level];
+        }
+        if (next[0] && !comp_(key, next[0]->key))
+        {
+            return false;
+        }
+
+        void *memory = arena_.allocate(sizeof(Node) + static_cast<size_t>(height - 1) * sizeof(std::atomic<Node *>));
+        Node *node = new (memory) Node(height, std::forward<Key>(key), std::forward<Args>(args)...);
+        for (int level = 1; level < height; ++level)
+        {
+            new (&node->link(level)) std::atomic<Node *>(nullptr);
+        }
+        for (int level = 0; level < height; ++level)
+        {
+            while (true)
+            {
+                node->link(level).store(next[level], std::memory_order_relaxed);
+                if (linkOf(prev[level], level).compare_exchange_strong(next[level], node, std::memory_order_release,
+                                                                       std::memory_order_relaxed))
+                {
+                    break;
+                }
+                // Another writer linked a node in between: search this level again from
+                // the old predecessor, which still precedes the key
+                findSplice(node->key, prev[level], level, &prev[level], &next[level]);
+                if (level == 0 && next[0] && !comp_(node->key, next[0]->key))
+                {
+                    // It inserted the same key; the arena keeps the unused memory
+                    node->~Node();
+                    return false;
+                }
+            }
+        }
+        size_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    bool insert(const K &key, const V &value) { return emplace(key, value); }
+
+    /**
+     * @return The element with the key, or end()
+     */
+    Iterator find(const K &key) const
+    {
+        Iterator it = lowerBound(key);
+        return it != end() && !comp_(key, it.key()) ? it : end();
+    }
+
+    bool contains(const K &key) const { return find(key) != end(); }
+
+    /**
+     * @brief The first element whose key is not before `key`.
+     */
+    Iterator lowerBound(const K &key) const
+    {
+        Node *before = nullptr;
+        Node *after = nullptr;
+        for (int level = height_.load(std::memory_order_relaxed) - 1; level >= 0; --level)
+        {
+            findSplice(key, before, level, &before, &after);
+        }
+        return Iterator(after);
+    }
+
+    Iterator begin() const { return Iterator(head_[0].load(std::memory_order_acquire)); }
+    Iterator end() const { return Iterator(); }
+
+    /**
+     * @brief Elements inserted so far; exact once concurrent inserts have returned.
+     */
+    size_t size() const noexcept { return size_.load(std::memory_order_relaxed); }
+    bool empty() const noexcept { return size() == 0; }
+
+    /**
+     * @brief Bytes held by the node arena.
+     */
+    size_t memoryUsage() const noexcept { return arena_.memoryUsage(); }
+
+private:
+    // The list head is a node without key or value
+    std::atomic<Node *> &linkOf(Node *node, int level) const
+    {
+        return node ? node->link(level) : head_[level];
+    }
+
+    // Walks `level` from `start` (nullptr for the head) to the last node before `key` and
+    // the node after it
+    void findSplice(const K &key, Node *start, int level, Node **prev, Node **next) const
+    {
+        Node *node = start;
+        Node *after = linkOf(node, level).load(std::memory_order_acquire);
+        while (after && comp_(after->key, key))
+        {
+            node = after;
+            after = node->link(level).load(std::memory_order_acquire);
+        }
+        *prev = node;
+        *next = after;
+    }
+
+    // 1 with probability 3/4, 2 with 3/16, ... up to kMaxHeight
+    static int randomHeight()
+    {
+        thread_local uint64_t state =
+            std::hash<std::thread::id>()(std::this_thread::get_id()) * 0x9E3779B97F4A7C15ull | 1;
+        // xorshift64
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int height = 1;
+        for (uint64_t bits = state; height < kMaxHeight && (bits & 3) == 0; bits >>= 2)
+        {
+            ++height;
+        }
+        return height;
+    }
+
+    [[no_unique_address]] Compare comp_;
+    mutable std::atomic<Node *> head_[kMaxHeight];
+    std::atomic<int> height_{1};
+    std::atomic<size_t> size_{0};
+    skip_list_detail::ConcurrentArena arena_;
+};
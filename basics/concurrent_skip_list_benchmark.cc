@@ -0,0 +1,143 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "benchmark_data.h"
+#include "concurrent_skip_list.h"
+
+// ConcurrentSkipList from 1 to 32 threads: inserts of random 64 bit keys by every thread
+// into one shared list (against a std::map behind a mutex), and scans of up to 1000
+// elements from random start keys over lists of 1K to 1M elements (BENCHMARK_MAX_SIZE
+// raises the limit), with and without a writer inserting into them at the same time.
+
+namespace
+{
+    using List = ConcurrentSkipList<uint64_t, uint64_t>;
+
+    constexpr size_t kScanLength = 1000;
+
+    std::unique_ptr<List> shared_list;
+    std::map<uint64_t, uint64_t> locked_map;
+    std::mutex locked_map_mutex;
+
+    void scanArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(1000000))
+        {
+            benchmark->Arg(n);
+        }
+        benchmark->ArgName("size");
+    }
+
+    // A list of `size` even keys, so writers have room to insert odd keys between them.
+    // Built by the first thread to ask and kept for the next runs.
+    List &scanList(size_t size)
+    {
+        static std::map<size_t, std::unique_ptr<List>> lists;
+        static std::mutex lists_mutex;
+        std::lock_guard<std::mutex> lock(lists_mutex);
+        std::unique_ptr<List> &list = lists[size];
+        if (!list)
+        {
+            list = std::make_unique<List>();
+            for (uint64_t key : uniformIntegers(size, UINT64_MAX, 1))
+            {
+                list->insert(key & ~uint64_t(1), key & ~uint64_t(1));
+            }
+        }
+        return *list;
+    }
+
+    // Sums the values of up to kScanLength elements from the first key at or after `start`
+    // and returns how many it read
+    int64_t scan(List &list, uint64_t start)
+    {
+        uint64_t sum = 0;
+        size_t i = 0;
+        for (auto it = list.lowerBound(start); it != list.end() && i < kScanLength; ++it, ++i)
+        {
+            sum += it.value();
+        }
+        benchmark::DoNotOptimize(sum);
+        return static_cast<int64_t>(i);
+    }
+} // namespace
+
+static void BM_ConcurrentInsert(benchmark::State &state)
+{
+    if (state.thread_index() == 0)
+    {
+        shared_list = std::make_unique<List>();
+    }
+    DataGenerator random(static_cast<uint64_t>(state.thread_index()) + 1);
+    for (auto _ : state)
+    {
+        uint64_t key = random.next();
+        benchmark::DoNotOptimize(shared_list->insert(key, key));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        shared_list.reset();
+    }
+}
+BENCHMARK(BM_ConcurrentInsert)->ThreadRange(1, 32)->UseRealTime();
+
+static void BM_LockedMapInsert(benchmark::State &state)
+{
+    if (state.thread_index() == 0)
+    {
+        locked_map.clear();
+    }
+    DataGenerator random(static_cast<uint64_t>(state.thread_index()) + 1);
+    for (auto _ : state)
+    {
+        uint64_t key = random.next();
+        std::lock_guard<std::mutex> lock(locked_map_mutex);
+        benchmark::DoNotOptimize(locked_map.emplace(key, key));
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0)
+    {
+        locked_map.clear();
+    }
+}
+BENCHMARK(BM_LockedMapInsert)->ThreadRange(1, 32)->UseRealTime();
+
+static void BM_Scan(benchmark::State &state)
+{
+    List &list = scanList(static_cast<size_t>(state.range(0)));
+    DataGenerator random(static_cast<uint64_t>(state.thread_index()) + 1);
+    int64_t scanned = 0;
+    for (auto _ : state)
+    {
+        scanned += scan(list, random.next());
+    }
+    state.SetItemsProcessed(scanned);
+}
+BENCHMARK(BM_Scan)->Apply(scanArgs)->ThreadRange(1, 32)->UseRealTime();
+
+// Thread 0 inserts odd keys while the other threads scan; reports the scan throughput
+static void BM_ScanWithWriter(benchmark::State &state)
+{
+    List &list = scanList(static_cast<size_t>(state.range(0)));
+    DataGenerator random(static_cast<uint64_t>(state.thread_index()) + 1);
+    int64_t scanned = 0;
+    for (auto _ : state)
+    {
+        if (state.thread_index() == 0)
+        {
+            benchmark::DoNotOptimize(list.insert(random.next() | 1, 0));
+            continue;
+        }
+        scanned += scan(list, random.next());
+    }
+    state.SetItemsProcessed(scanned);
+}
+BENCHMARK(BM_ScanWithWriter)->Apply(scanArgs)->ThreadRange(2, 32)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "concurrent_skip_list.h"
+
+TEST(ConcurrentSkipListTest, InsertFindAndIterateInOrder)
+{
+    ConcurrentSkipList<int, std::string> list;
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.begin(), list.end());
+    EXPECT_EQ(list.find(3), list.end());
+
+    std::map<int, std::string> expected;
+    std::mt19937 rng(3);
+    for (int i = 0; i < 5000; ++i)
+    {
+        int key = static_cast<int>(rng() % 10000);
+        std::string value = std::to_string(i);
+        EXPECT_EQ(list.insert(key, value), expected.emplace(key, value).second);
+    }
+    EXPECT_EQ(list.size(), expected.size());
+
+    auto it = expected.begin();
+    for (auto [key, value] : list)
+    {
+        ASSERT_NE(it, expected.end());
+        ASSERT_EQ(key, it->first);
+        ASSERT_EQ(value, it->second);
+        ++it;
+    }
+    EXPECT_EQ(it, expected.end());
+
+    for (int key = -1; key <= 10000; ++key)
+    {
+        auto found = expected.lower_bound(key);
+        auto bound = list.lowerBound(key);
+        ASSERT_EQ(bound == list.end(), found == expected.end()) << key;
+        if (found != expected.end())
+        {
+            ASSERT_EQ(bound.key(), found->first);
+        }
+        ASSERT_EQ(list.contains(key), expected.count(key) == 1);
+    }
+    EXPECT_GT(list.memoryUsage(), expected.size() * sizeof(std::string));
+}
+
+TEST(ConcurrentSkipListTest, ConcurrentWritersInsertEveryKeyOnce)
+{
+    constexpr int kThreads = 8;
+    constexpr int kKeysPerThread = 20000;
+    ConcurrentSkipList<uint64_t, int> list(std::less<uint64_t>(), 4096);
+    std::atomic<int> inserted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back([&, t] {
+            // Neighbouring threads insert the same keys, racing for each of them
+            std::mt19937_64 rng(static_cast<uint64_t>(t / 2));
+            for (int i = 0; i < kKeysPerThread; ++i)
+            {
+                inserted += list.emplace(rng() % 1000000, t) ? 1 : 0;
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    std::set<uint64_t> expected;
+    for (int t = 0; t < kThreads; t += 2)
+    {
+        std::mt19937_64 rng(static_cast<uint64_t>(t / 2));
+        for (int i = 0; i < kKeysPerThread; ++i)
+        {
+            expected.insert(rng() % 1000000);
+        }
+    }
+    EXPECT_EQ(static_cast<size_t>(inserted.load()), expected.size());
+    EXPECT_EQ(list.size(), expected.size());
+    auto it = expected.begin();
+    for (auto [key, value] : list)
+    {
+        ASSERT_NE(it, expected.end());
+        ASSERT_EQ(key, *it);
+        ++it;
+    }
+    EXPECT_EQ(it, expected.end());
+}
+
+TEST(ConcurrentSkipListTest, ReadersSeeOrderedConsistentViewsWhileWritersRun)
+{
+    ConcurrentSkipList<int64_t, int64_t> list;
+    // Even keys are in the list before the readers start, odd keys arrive while they run
+    for (int64_t key = 0; key < 20000; key += 2)
+    {
+        list.insert(key, key * 10);
+    }
+    std::atomic<bool> done{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; ++t)
+    {
+        writers.emplace_back([&, t] {
+            for (int64_t key = 1 + 2 * t; key < 20000; key += 4)
+            {
+                list.insert(key, key * 10);
+            }
+        });
+    }
+    std::atomic<int> failures{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t)
+    {
+        readers.emplace_back([&] {
+            do
+            {
+                int64_t previous = -1;
+                size_t evens = 0;
+                for (auto [key, value] : list)
+                {
+                    failures += key <= previous || value != key * 10;
+                    evens += key % 2 == 0;
+                    previous = key;
+                }
+                failures += evens != 10000;
+                failures += list.find(5000) == list.end();
+            } while (!done.load());
+        });
+    }
+    for (std::thread &writer : writers)
+    {
+        writer.join();
+    }
+    done = true;
+    for (std::thread &reader : readers)
+    {
+        reader.join();
+    }
+    EXPECT_EQ(failures.load(), 0);
+    EXPECT_EQ(list.size(), 20000u);
+}
@@ -0,0 +1,707 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace flat_hash_detail
+{
+    /// Slots probed per step: one SSE2 register of control bytes
+    constexpr size_t kGroupWidth = 16;
+
+    /// Control byte of an empty slot; full slots hold the 7 low bits of their hash (H2)
+    constexpr uint8_t kEmpty = 0x80;
+
+    /**
+     * @brief Spreads the bits of a hash over all 64 bits, so identity hashes such as
+     * std::hash<int> still give well distributed positions and H2 bytes.
+     */
+    inline uint64_t mix(uint64_t hash)
+    {
+        __uint128_t product = static_cast<__uint128_t>(hash) * 0x9E3779B97F4A7C15ull;
+        return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+    }
+
+    /**
+     * @brief The control bytes of kGroupWidth consecutive slots, compared all at once.
+     */
+    class Group
+    {
+    public:
+        explicit Group(const uint8_t *control)
+        {
+#if defined(__SSE2__)
+            bytes_ = _mm_loadu_si128(reinterpret_cast<const __m128i *>(control));
+#else
+            std::memcpy(bytes_, control, kGroupWidth);
+#endif
+        }
+
+        /// Bit i is set if slot i holds `h2`
+        uint32_t match(uint8_t h2) const
+        {
+#if defined(__SSE2__)
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes_, _mm_set1_epi8(static_cast<char>(h2)))));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < kGroupWidth; ++i)
+            {
+                mask |= static_cast<uint32_t>(bytes_[i] == h2) << i;
+            }
+            return mask;
+#endif
+        }
+
+        /// Bit i is set if slot i is empty
+        uint32_t matchEmpty() const
+        {
+#if defined(__SSE2__)
+            return static_cast<uint32_t>(_mm_movemask_epi8(bytes_));
+#else
+            uint32_t mask = 0;
+            for (size_t i = 0; i < kGroupWidth; ++i)
+            {
+                mask |= static_cast<uint32_t>(bytes_[i] >> 7) << i;
+            }
+            return mask;
+#endif
+        }
+
+    private:
+#if defined(__SSE2__)
+        __m128i bytes_;
+#else
+        uint8_t bytes_[kGroupWidth];
+#endif
+    };
+
+    template <typename T, typename = void>
+    struct IsTransparent : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type
+    {
+    };
+} // namespace flat_hash_detail
+
+/**
+ * @brief Transparent string hash, so maps keyed by std::string can be searched with a
+ * std::string_view or a C string without building a std::string.
+ */
+struct StringHash
+{
+    using is_transparent = void;
+
+    size_t operator()(std::string_view value) const noexcept { return std::hash<std::string_view>()(value); }
+};
+
+/**
+ * @brief An open addressing hash map in the style of Swiss tables.
+ *
+ * Keys and values live in one flat array of slots, next to an array of one control byte
+ * per slot: 0x80 for an empty slot, or 7 bits of the key's hash for a full one. Lookups
+ * compare 16 control bytes at once with SSE2 (a portable loop elsewhere), so a probe
+ * touches the slots of likely matches only, and stops at the first group with an empty
+ * slot. Slots are probed linearly from the key's home slot, which lets erase() shift the
+ * following keys back instead of leaving tombstones: the table never degrades with
+ * erasures and never needs a cleanup rehash.
+ *
+ * With transparent Hash and KeyEqual (see StringHash and std::equal_to<>), find(),
+ * contains(), count() and erase() accept any type the two accept. Memory comes from
+ * `Allocator`, rebound to the slot and control byte types.
+ *
+ * Inserting may rehash and erasing may move other elements, so both invalidate iterators
+ * and references. Not thread-safe.
+ *
+ * @tparam K Key type, move constructible
+ * @tparam V Mapped type, move constructible
+ */
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>,
+          typename Allocator = std::allocator<std::pair<const K, V>>>
+class FlatHashMap
+{
+    // The slot holds the pair as the const key pair users see, and as a mutable pair the
+    // map moves around
+    union Slot
+    {
+        Slot() {}
+        ~Slot() {}
+
+        std::pair<const K, V> value;
+        std::pair<K, V> mutable_value;
+    };
+
+    using SlotAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Slot>;
+    using SlotTraits = std::allocator_traits<SlotAllocator>;
+    using ControlAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<uint8_t>;
+    using ControlTraits = std::allocator_traits<ControlAllocator>;
+
+    static constexpr bool kTransparent =
+        flat_hash_detail::IsTransparent<Hash>::value && flat_hash_detail::IsTransparent<KeyEqual>::value;
+
+public:
+    using key_type = K;
+    using mapped_type = V;
+    using value_type = std::pair<const K, V>;
+    using size_type = size_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+
+    template <bool Const>
+    class IteratorBase
+    {
+        using Map = std::conditional_t<Const, const FlatHashMap, FlatHashMap>;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = FlatHashMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+        IteratorBase() = default;
+        IteratorBase(Map *map, size_t index) : map_(map), index_(index) { skipEmpty(); }
+
+        // Mutable iterators convert to const ones
+        template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        IteratorBase(const IteratorBase<OtherConst> &other) : map_(other.map_), index_(other.index_)
+        {
+        }
+
+        reference operator*() const { return map_->slots_[index_].value; }
+        pointer operator->() const { return &map_->slots_[index_].value; }
+
+        IteratorBase &operator++()
+        {
+            ++index_;
+            skipEmpty();
+            return *this;
+        }
+
+        IteratorBase operator++(int)
+        {
+            IteratorBase previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const IteratorBase &other) const noexcept { return index_ == other.index_; }
+        bool operator!=(const IteratorBase &other) const noexcept { return index_ != other.index_; }
+
+    private:
+        friend class FlatHashMap;
+        template <bool>
+        friend class IteratorBase;
+
+        void skipEmpty()
+        {
+            while (index_ < map_->capacity_ && map_->control_[index_] == flat_hash_detail::kEmpty)
+            {
+                ++index_;
+            }
+        }
+
+        Map *map_ = nullptr;
+        size_t index_ = 0;
+    };
+
+    using iterator = IteratorBase<false>;
+    using const_iterator = IteratorBase<true>;
+
+    FlatHashMap() = default;
+
+    explicit FlatHashMap(const Allocator &allocator) : slot_allocator_(allocator), control_allocator_(allocator) {}
+
+    /**
+     * @param capacity Elements the map holds without rehashing
+     */
+    explicit FlatHashMap(size_t capacity, const Hash &hash = Hash(), const KeyEqual &equal = KeyEqual(),
+                         const Allocator &allocator = Allocator())
+        : hash_(hash), equal_(equal), slot_allocator_(allocator), control_allocator_(allocator)
+    {
+        reserve(capacity);
+    }
+
+    FlatHashMap(std::initializer_list<value_type> values) : FlatHashMap(values.size())
+    {
+        for (const value_type &value : values)
+        {
+            insert(value);
+        }
+    }
+
+    ~FlatHashMap() { release(); }
+
+    FlatHashMap(const FlatHashMap &other)
+        : hash_(other.hash_), equal_(other.equal_),
+          slot_allocator_(SlotTraits::select_on_container_copy_construction(other.slot_allocator_)),
+          control_allocator_(ControlTraits::select_on_container_copy_construction(other.control_allocator_))
+    {
+        reserve(other.size_);
+        for (const value_type &value : other)
+        {
+            insertUnique(value.first, value.second);
+        }
+    }
+
+    FlatHashMap &operator=(const FlatHashMap &other)
+    {
+        if (this != &other)
+        {
+            FlatHashMap copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    FlatHashMap(FlatHashMap &&other) noexcept
+        : hash_(std::move(other.hash_)), equal_(std::move(other.equal_)),
+          slot_allocator_(std::move(other.slot_allocator_)), control_allocator_(std::move(other.control_allocator_)),
+          control_(std::exchange(other.control_, nullptr)), slots_(std::exchange(other.slots_, nullptr)),
+          capacity_(std::exchange(other.capacity_, 0)), size_(std::exchange(other.size_, 0))
+    {
+    }
+
+    FlatHashMap &operator=(FlatHashMap &&other) noexcept
+    {
+        if (this != &other)
+        {
+            FlatHashMap moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    void swap(FlatHashMap &other) noexcept
+    {
+        using std::swap;
+        swap(hash_, other.hash_);
+        swap(equal_, other.equal_);
+        swap(slot_allocator_, other.slot_allocator_);
+        swap(control_allocator_, other.control_allocator_);
+        swap(control_, other.control_);
+        swap(slots_, other.slots_);
+        swap(capacity_, other.capacity_);
+        swap(size_, other.size_);
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, capacity_); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, capacity_); }
+
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    /**
+     * @brief Number of slots; the map holds up to 7/8 of them before it grows.
+     */
+    size_t capacity() const noexcept { return capacity_; }
+
+    double loadFactor() const noexcept { return capacity_ == 0 ? 0 : static_cast<double>(size_) / capacity_; }
+
+    Allocator getAllocator() const { return Allocator(slot_allocator_); }
+
+    /**
+     * @brief Grows the table so that it holds `count` elements without rehashing.
+     */
+    void reserve(size_t count)
+    {
+        size_t capacity = flat_hash_detail::kGroupWidth;
+        while (maxSize(capacity) < count)
+        {
+            capacity *= 2;
+        }
+        if (capacity > capacity_)
+        {
+            rehash(capacity);
+        }
+    }
+
+    /**
+     * @brief Removes all elements and keeps the allocation.
+     */
+    void clear() noexcept
+    {
+        for (size_t i = 0; i < capacity_ && size_ > 0; ++i)
+        {
+            if (control_[i] != flat_hash_detail::kEmpty)
+            {
+                destroy(i);
+                --size_;
+            }
+        }
+        if (control_)
+        {
+            std::memset(control_, flat_hash_detail::kEmpty, capacity_ + flat_hash_detail::kGroupWidth);
+        }
+    }
+
+    /**
+     * @brief Inserts the value unless its key is present.
+     * @return The element with the key, and whether it was inserted
+     */
+    std::pair<iterator, bool> insert(const value_type &value) { return tryEmplace(value.first, value.second); }
+    std::pair<iterator, bool> insert(value_type &&value)
+    {
+        return tryEmplace(std::move(const_cast<K &>(value.first)), std::move(value.second));
+    }
+
+    /**
+     * @brief Constructs the mapped value from `args` unless the key is present, in which
+     * case the arguments are left untouched.
+     */
+    template <typename Key, typename... Args>
+    std::pair<iterator, bool> tryEmplace(Key &&key, Args &&...args)
+    {
+        uint64_t hash = hashOf(key);
+        size_t index = findIndex(key, hash);
+        if (index != capacity_)
+        {
+            return {iterator(this, index), false};
+        }
+        if (size_ + 1 > maxSize(capacity_))
+        {
+            rehash(capacity_ == 0 ? flat_hash_detail::kGroupWidth : capacity_ * 2);
+        }
+        index = emptyIndex(hash);
+        construct(index, hash, std::piecewise_construct, std::forward_as_tuple(std::forward<Key>(key)),
+                  std::forward_as_tuple(std::forward<Args>(args)...));
+        return {iterator(this, index), true};
+    }
+
+    template <typename... Args>
+    std::pair<iterator, bool> emplace(Args &&...args)
+    {
+        value_type value(std::forward<Args>(args)...);
+        return insert(std::move(value));
+    }
+
+    /**
+     * @brief Inserts the key with `value`, or assigns `value` to the present key.
+     * @return The element, and whether it was inserted
+     */
+    template <typename Key, typename M>
+    std::pair<iterator, bool> insertOrAssign(Key &&key, M &&value)
+    {
+        auto result = tryEmplace(std::forward<Key>(key), std::forward<M>(value));
+        if (!result.second)
+        {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    V &operator[](const K &key) { return tryEmplace(key).first->second; }
+    V &operator[](K &&key) { return tryEmplace(std::move(key)).first->second; }
+
+    /**
+     * @throws std::out_of_range if the key is not present
+     */
+    V &at(const K &key) { return atImpl(key); }
+    const V &at(const K &key) const { return const_cast<FlatHashMap *>(this)->atImpl(key); }
+    iterator find(const K &key) { return iterator(this, findIndex(key, hashOf(key))); }
+    const_iterator find(const K &key) const { return const_iterator(this, findIndex(key, hashOf(key))); }
+    bool contains(const K &key) const { return findIndex(key, hashOf(key)) != capacity_; }
+    size_t count(const K &key) const { return contains(key) ? 1 : 0; }
+
+    /**
+     * @return The number of elements removed, 0 or 1
+     */
+    size_t erase(const K &key) { return eraseImpl(key); }
+
+    // Heterogeneous lookup, for transparent Hash and KeyEqual only
+
+    template <typename Q>
+        requires kTransparent
+    V &at(const Q &key)
+    {
+        return atImpl(key);
+    }
+
+    template <typename Q>
+        requires kTransparent
+    const V &at(const Q &key) const
+    {
+        return const_cast<FlatHashMap *>(this)->atImpl(key);
+    }
+
+    template <typename Q>
+        requires kTransparent
+    iterator find(const Q &key)
+    {
+        return iterator(this, findIndex(key, hashOf(key)));
+    }
+
+    template <typename Q>
+        requires kTransparent
+    const_iterator find(const Q &key) const
+    {
+        return const_iterator(this, findIndex(key, hashOf(key)));
+    }
+
+    template <typename Q>
+        requires kTransparent
+    bool contains(const Q &key) const
+    {
+        return findIndex(key, hashOf(key)) != capacity_;
+    }
+
+    template <typename Q>
+        requires kTransparent
+    size_t count(const Q &key) const
+    {
+        return contains(key) ? 1 : 0;
+    }
+
+    template <typename Q>
+        requires kTransparent
+    size_t erase(const Q &key)
+    {
+        return eraseImpl(key);
+    }
+
+    /**
+     * @brief Removes the element; the iterator and all others are invalidated.
+     */
+    void erase(const_iterator position) { eraseIndex(position.index_); }
+    void erase(iterator position) { eraseIndex(position.index_); }
+
+    /**
+     * @brief Removes every element for which `predicate(key, value)` is true.
+     * @return The number of elements removed
+     */
+    template <typename Predicate>
+    size_t eraseIf(Predicate predicate)
+    {
+        size_t removed = 0;
+        // Erasing shifts later elements back into the slot, so it is checked again. Elements
+        // that wrap around from the start of the table were already kept once.
+        for (size_t i = 0; i < capacity_;)
+        {
+            Slot &slot = slots_[i];
+            if (control_[i] != flat_hash_detail::kEmpty && predicate(slot.value.first, slot.value.second))
+            {
+                eraseIndex(i);
+                ++removed;
+            }
+            else
+            {
+                ++i;
+            }
+        }
+        return removed;
+    }
+
+private:
+    static size_t maxSize(size_t capacity) noexcept { return capacity - capacity / 8; }
+
+    template <typename Q>
+    V &atImpl(const Q &key)
+    {
+        size_t index = findIndex(key, hashOf(key));
+        if (index == capacity_)
+        {
+            throw std::out_of_range("Key not found");
+        }
+        return slots_[index].value.second;
+    }
+
+    template <typename Q>
+    size_t eraseImpl(const Q &key)
+    {
+        size_t index = findIndex(key, hashOf(key));
+        if (index == capacity_)
+        {
+            return 0;
+        }
+        eraseIndex(index);
+        return 1;
+    }
+
+    template <typename Q>
+    uint64_t hashOf(const Q &key) const
+    {
+        return flat_hash_detail::mix(static_cast<uint64_t>(hash_(key)));
+    }
+
+    static uint8_t h2(uint64_t hash) noexcept { return static_cast<uint8_t>(hash & 0x7F); }
+    size_t home(uint64_t hash) const noexcept { return static_cast<size_t>(hash >> 7) & (capacity_ - 1); }
+
+    template <typename Q>
+    size_t findIndex(const Q &key, uint64_t hash) const
+    {
+        if (capacity_ == 0)
+        {
+            return 0;
+        }
+        size_t mask = capacity_ - 1;
+        size_t position = home(hash);
+        uint8_t tag = h2(hash);
+        for (size_t probed = 0; probed < capacity_; probed += flat_hash_detail::kGroupWidth)
+        {
+            flat_hash_detail::Group group(control_ + position);
+            for (uint32_t matches = group.match(tag); matches != 0; matches &= matches - 1)
+            {
+                size_t index = (position + static_cast<size_t>(__builtin_ctz(matches))) & mask;
+                if (equal_(slots_[index].value.first, key))
+                {
+                    return index;
+                }
+            }
+            // Linear probing never leaves an empty slot between a key's home and the key
+            if (group.matchEmpty() != 0)
+            {
+                break;
+            }
+            position = (position + flat_hash_detail::kGroupWidth) & mask;
+        }
+        return capacity_;
+    }
+
+    size_t emptyIndex(uint64_t hash) const
+    {
+        size_t mask = capacity_ - 1;
+        size_t position = home(hash);
+        while (true)
+        {
+            uint32_t empty = flat_hash_detail::Group(control_ + position).matchEmpty();
+            if (empty != 0)
+            {
+                return (position + static_cast<size_t>(__builtin_ctz(empty))) & mask;
+            }
+            position = (position + flat_hash_detail::kGroupWidth) & mask;
+        }
+    }
+
+    void setControl(size_t index, uint8_t value) noexcept
+    {
+        control_[index] = value;
+        // The first group is mirrored behind the last slot, so groups can be loaded from any
+        // position without wrapping
+        if (index < flat_hash_detail::kGroupWidth)
+        {
+            control_[capacity_ + index] = value;
+        }
+    }
+
+    template <typename... Args>
+    void construct(size_t index, uint64_t hash, Args &&...args)
+    {
+        SlotTraits::construct(slot_allocator_, &slots_[index].mutable_value, std::forward<Args>(args)...);
+        setControl(index, h2(hash));
+        ++size_;
+    }
+
+    void destroy(size_t index) noexcept { SlotTraits::destroy(slot_allocator_, &slots_[index].mutable_value); }
+
+    void moveSlot(size_t from, size_t to)
+    {
+        SlotTraits::construct(slot_allocator_, &slots_[to].mutable_value, std::move(slots_[from].mutable_value));
+        destroy(from);
+        setControl(to, control_[from]);
+    }
+
+    void eraseIndex(size_t index)
+    {
+        destroy(index);
+        --size_;
+        // Backward shift deletion: move later elements of the cluster into the hole when
+        // their home slot lies at or before it, until the cluster ends
+        size_t mask = capacity_ - 1;
+        size_t hole = index;
+        for (size_t next = (index + 1) & mask; control_[next] != flat_hash_detail::kEmpty; next = (next + 1) & mask)
+        {
+            size_t next_home = home(hashOf(slots_[next].value.first));
+            if (((next - next_home) & mask) >= ((next - hole) & mask))
+            {
+                moveSlot(next, hole);
+                hole = next;
+            }
+        }
+        setControl(hole, flat_hash_detail::kEmpty);
+    }
+
+    void rehash(size_t capacity)
+    {
+        uint8_t *old_control = control_;
+        Slot *old_slots = slots_;
+        size_t old_capacity = capacity_;
+
+        control_ = ControlTraits::allocate(control_allocator_, capacity + flat_hash_detail::kGroupWidth);
+        try
+        {
+            slots_ = SlotTraits::allocate(slot_allocator_, capacity);
+        }
+        catch (...)
+        {
+            ControlTraits::deallocate(control_allocator_, control_, capacity + flat_hash_detail::kGroupWidth);
+            control_ = old_control;
+            throw;
+        }
+        std::memset(control_, flat_hash_detail::kEmpty, capacity + flat_hash_detail::kGroupWidth);
+        capacity_ = capacity;
+        size_ = 0;
+        for (size_t i = 0; i < old_capacity; ++i)
+        {
+            if (old_control[i] != flat_hash_detail::kEmpty)
+            {
+                uint64_t hash = hashOf(old_slots[i].value.first);
+                construct(emptyIndex(hash), hash, std::move(old_slots[i].mutable_value));
+                SlotTraits::destroy(slot_allocator_, &old_slots[i].mutable_value);
+            }
+        }
+        if (old_control)
+        {
+            ControlTraits::deallocate(control_allocator_, old_control, old_capacity + flat_hash_detail::kGroupWidth);
+            SlotTraits::deallocate(slot_allocator_, old_slots, old_capacity);
+        }
+    }
+
+    template <typename... Args>
+    void insertUnique(Args &&...args)
+    {
+        uint64_t hash = hashOf(std::get<0>(std::forward_as_tuple(args...)));
+        construct(emptyIndex(hash), hash, std::forward<Args>(args)...);
+    }
+
+    void release() noexcept
+    {
+        if (!control_)
+        {
+            return;
+        }
+        clear();
+        ControlTraits::deallocate(control_allocator_, control_, capacity_ + flat_hash_detail::kGroupWidth);
+        SlotTraits::deallocate(slot_allocator_, slots_, capacity_);
+        control_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+    }
+
+    [[no_unique_address]] Hash hash_;
+    [[no_unique_address]] KeyEqual equal_;
+    [[no_unique_address]] SlotAllocator slot_allocator_;
+    [[no_unique_address]] ControlAllocator control_allocator_;
+    uint8_t *control_ = nullptr;
+    Slot *slots_ = nullptr;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+};
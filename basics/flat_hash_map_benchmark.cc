@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "flat_hash_map.h"
+
+// FlatHashMap against std::unordered_map with random 64 bit keys and values: inserting n
+// keys into an empty map, looking up n present keys in random order, looking up n absent
+// keys, and erasing all n keys. n runs from 1K to 10M; BENCHMARK_MAX_SIZE raises the limit,
+// e.g. to 100000000 on machines with the ~10GB std::unordered_map needs.
+
+namespace
+{
+    using Flat = FlatHashMap<uint64_t, uint64_t>;
+    using Std = std::unordered_map<uint64_t, uint64_t>;
+
+    void keyCounts(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(10000000))
+        {
+            benchmark->Arg(n);
+        }
+    }
+
+    template <typename Map>
+    Map buildMap(const std::vector<uint64_t> &keys)
+    {
+        Map map;
+        for (uint64_t key : keys)
+        {
+            map[key] = key;
+        }
+        return map;
+    }
+} // namespace
+
+template <typename Map>
+static void BM_Insert(benchmark::State &state)
+{
+    std::vector<uint64_t> keys = uniformIntegers(static_cast<size_t>(state.range(0)), UINT64_MAX, 1);
+    for (auto _ : state)
+    {
+        Map map = buildMap<Map>(keys);
+        benchmark::DoNotOptimize(map.size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+static void BM_LookupHit(benchmark::State &state)
+{
+    std::vector<uint64_t> keys = uniformIntegers(static_cast<size_t>(state.range(0)), UINT64_MAX, 1);
+    Map map = buildMap<Map>(keys);
+    shuffleValues(keys, 2);
+    for (auto _ : state)
+    {
+        uint64_t sum = 0;
+        for (uint64_t key : keys)
+        {
+            sum += map.find(key)->second;
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+static void BM_LookupMiss(benchmark::State &state)
+{
+    Map map = buildMap<Map>(uniformIntegers(static_cast<size_t>(state.range(0)), UINT64_MAX, 1));
+    std::vector<uint64_t> absent = uniformIntegers(static_cast<size_t>(state.range(0)), UINT64_MAX, 3);
+    for (auto _ : state)
+    {
+        size_t found = 0;
+        for (uint64_t key : absent)
+        {
+            found += map.find(key) != map.end();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template <typename Map>
+static void BM_Erase(benchmark::State &state)
+{
+    std::vector<uint64_t> keys = uniformIntegers(static_cast<size_t>(state.range(0)), UINT64_MAX, 1);
+    std::vector<uint64_t> order = keys;
+    shuffleValues(order, 2);
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        Map map = buildMap<Map>(keys);
+        state.ResumeTiming();
+        for (uint64_t key : order)
+        {
+            map.erase(key);
+        }
+        benchmark::DoNotOptimize(map.size());
+        state.PauseTiming();
+        map = Map();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_TEMPLATE(BM_Insert, Flat)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_Insert, Std)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_LookupHit, Flat)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_LookupHit, Std)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_LookupMiss, Flat)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_LookupMiss, Std)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_Erase, Flat)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+BENCHMARK_TEMPLATE(BM_Erase, Std)->Apply(keyCounts)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
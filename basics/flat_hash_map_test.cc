@@ -0,0 +1,252 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "flat_hash_map.h"
+
+namespace
+{
+    /**
+     * @brief Sends every key to the same few home slots, to exercise long probe chains,
+     * wrap-around and backward shifting.
+     */
+    struct CollidingHash
+    {
+        size_t operator()(int key) const noexcept { return static_cast<size_t>(key % 3); }
+    };
+
+    /**
+     * @brief Counts the bytes it hands out.
+     */
+    template <typename T>
+    struct CountingAllocator
+    {
+        using value_type = T;
+
+        explicit CountingAllocator(std::shared_ptr<long> live) : live(std::move(live)) {}
+
+        template <typename U>
+        CountingAllocator(const CountingAllocator<U> &other) : live(other.live)
+        {
+        }
+
+        T *allocate(size_t n)
+        {
+            *live += static_cast<long>(n * sizeof(T));
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T *p, size_t n)
+        {
+            *live -= static_cast<long>(n * sizeof(T));
+            std::allocator<T>().deallocate(p, n);
+        }
+
+        bool operator==(const CountingAllocator &other) const { return live == other.live; }
+
+        std::shared_ptr<long> live;
+    };
+} // namespace
+
+TEST(FlatHashMapTest, InsertFindErase)
+{
+    FlatHashMap<int, std::string> map;
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.find(1), map.end());
+
+    EXPECT_TRUE(map.insert({1, "one"}).second);
+    EXPECT_FALSE(map.insert({1, "uno"}).second);
+    EXPECT_EQ(map.at(1), "one");
+    EXPECT_TRUE(map.tryEmplace(2, "two").second);
+    EXPECT_FALSE(map.insertOrAssign(2, "deux").second);
+    EXPECT_EQ(map[2], "deux");
+    map[3] = "three";
+    EXPECT_EQ(map.size(), 3u);
+    EXPECT_TRUE(map.contains(3));
+    EXPECT_EQ(map.count(4), 0u);
+    EXPECT_THROW(map.at(4), std::out_of_range);
+
+    EXPECT_EQ(map.erase(2), 1u);
+    EXPECT_EQ(map.erase(2), 0u);
+    map.erase(map.find(1));
+    EXPECT_EQ(map.size(), 1u);
+    EXPECT_EQ(map.begin()->first, 3);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.begin(), map.end());
+}
+
+TEST(FlatHashMapTest, MatchesStdMapUnderRandomOperations)
+{
+    for (bool colliding : {false, true})
+    {
+        FlatHashMap<int, int, CollidingHash> bad_hash;
+        FlatHashMap<int, int> good_hash;
+        std::map<int, int> expected;
+        std::mt19937 rng(7);
+        int key_range = colliding ? 200 : 5000;
+        for (int step = 0; step < 20000; ++step)
+        {
+            int key = static_cast<int>(rng() % static_cast<unsigned>(key_range));
+            switch (rng() % 3)
+            {
+            case 0:
+                expected[key] = step;
+                if (colliding)
+                {
+                    bad_hash.insertOrAssign(key, step);
+                }
+                else
+                {
+                    good_hash.insertOrAssign(key, step);
+                }
+                break;
+            case 1:
+                ASSERT_EQ(colliding ? bad_hash.erase(key) : good_hash.erase(key), expected.erase(key));
+                break;
+            default:
+                auto it = expected.find(key);
+                if (colliding)
+                {
+                    auto found = bad_hash.find(key);
+                    ASSERT_EQ(found != bad_hash.end(), it != expected.end()) << key;
+                    ASSERT_TRUE(found == bad_hash.end() || found->second == it->second);
+                }
+                else
+                {
+                    auto found = good_hash.find(key);
+                    ASSERT_EQ(found != good_hash.end(), it != expected.end()) << key;
+                    ASSERT_TRUE(found == good_hash.end() || found->second == it->second);
+                }
+            }
+        }
+        std::map<int, int> contents;
+        if (colliding)
+        {
+            contents.insert(bad_hash.begin(), bad_hash.end());
+            EXPECT_EQ(bad_hash.size(), expected.size());
+        }
+        else
+        {
+            contents.insert(good_hash.begin(), good_hash.end());
+            EXPECT_EQ(good_hash.size(), expected.size());
+        }
+        EXPECT_EQ(contents, expected);
+    }
+}
+
+TEST(FlatHashMapTest, GrowsAndKeepsLoadFactorBelowSevenEighths)
+{
+    FlatHashMap<uint64_t, uint64_t> map;
+    for (uint64_t i = 0; i < 100000; ++i)
+    {
+        map[i * 7919] = i;
+        ASSERT_LE(map.loadFactor(), 0.875);
+    }
+    for (uint64_t i = 0; i < 100000; ++i)
+    {
+        ASSERT_EQ(map.at(i * 7919), i);
+    }
+    size_t capacity = map.capacity();
+    // Erasing leaves no tombstones behind: refilling does not grow the table
+    for (int round = 0; round < 3; ++round)
+    {
+        for (uint64_t i = 0; i < 100000; ++i)
+        {
+            ASSERT_EQ(map.erase(i * 7919), 1u);
+        }
+        for (uint64_t i = 0; i < 100000; ++i)
+        {
+            map[i * 7919 + 1] = i;
+        }
+        map.clear();
+        for (uint64_t i = 0; i < 100000; ++i)
+        {
+            map[i * 7919] = i;
+        }
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+
+    FlatHashMap<int, int> reserved(1000);
+    size_t reserved_capacity = reserved.capacity();
+    for (int i = 0; i < 1000; ++i)
+    {
+        reserved[i] = i;
+    }
+    EXPECT_EQ(reserved.capacity(), reserved_capacity);
+}
+
+TEST(FlatHashMapTest, EraseIf)
+{
+    FlatHashMap<int, int, CollidingHash> map;
+    for (int i = 0; i < 300; ++i)
+    {
+        map[i] = i * 2;
+    }
+    EXPECT_EQ(map.eraseIf([](int key, int) { return key % 3 != 1; }), 200u);
+    EXPECT_EQ(map.size(), 100u);
+    for (int i = 0; i < 300; ++i)
+    {
+        EXPECT_EQ(map.contains(i), i % 3 == 1) << i;
+    }
+}
+
+TEST(FlatHashMapTest, HeterogeneousLookup)
+{
+    FlatHashMap<std::string, int, StringHash, std::equal_to<>> map;
+    map["apple"] = 1;
+    map[std::string(100, 'x')] = 2;
+    std::string_view key = "apple";
+    EXPECT_EQ(map.find(key)->second, 1);
+    EXPECT_TRUE(map.contains("apple"));
+    EXPECT_EQ(map.at(std::string_view(std::string(100, 'x'))), 2);
+    EXPECT_EQ(map.count(std::string_view("pear")), 0u);
+    EXPECT_EQ(map.erase(key), 1u);
+    EXPECT_FALSE(map.contains(std::string("apple")));
+}
+
+TEST(FlatHashMapTest, CopiesMovesAndOwnsItsValues)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        FlatHashMap<std::string, std::shared_ptr<int>> map;
+        for (int i = 0; i < 100; ++i)
+        {
+            map[std::to_string(i)] = counter;
+        }
+        EXPECT_EQ(counter.use_count(), 101);
+        FlatHashMap<std::string, std::shared_ptr<int>> copy = map;
+        EXPECT_EQ(counter.use_count(), 201);
+        FlatHashMap<std::string, std::shared_ptr<int>> moved = std::move(map);
+        EXPECT_EQ(counter.use_count(), 201);
+        EXPECT_TRUE(map.empty());
+        EXPECT_EQ(moved.size(), 100u);
+        copy.erase("5");
+        copy = moved;
+        EXPECT_EQ(copy.size(), 100u);
+        EXPECT_EQ(counter.use_count(), 201);
+        moved.clear();
+        EXPECT_EQ(counter.use_count(), 101);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(FlatHashMapTest, UsesTheGivenAllocator)
+{
+    auto live = std::make_shared<long>(0);
+    using Allocator = CountingAllocator<std::pair<const int, int>>;
+    {
+        FlatHashMap<int, int, std::hash<int>, std::equal_to<int>, Allocator> map(Allocator{live});
+        for (int i = 0; i < 1000; ++i)
+        {
+            map[i] = i;
+        }
+        EXPECT_GE(*live, static_cast<long>(map.capacity() * (2 * sizeof(int) + 1)));
+    }
+    EXPECT_EQ(*live, 0);
+}
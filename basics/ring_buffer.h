@@ -0,0 +1,677 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace ring_detail
+{
+    constexpr size_t kCacheLine = 64;
+
+    /// Attempts a blocking call makes, pausing in between, before it falls back to its wait
+    /// strategy; a hand-off between two running threads usually completes within them
+    constexpr int kSpinLimit = 128;
+
+    /// Attempts after the spin that yield the core in between before parking, for when the
+    /// other side has no core of its own to run on
+    constexpr int kYieldLimit = kSpinLimit + 16;
+
+    inline void pause() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    /**
+     * @brief Uninitialized storage for one element.
+     */
+    template <typename T>
+    struct Storage
+    {
+        alignas(T) unsigned char bytes[sizeof(T)];
+
+        T *get() noexcept { return std::launder(reinterpret_cast<T *>(bytes)); }
+
+        template <typename... Args>
+        void construct(Args &&...args) { ::new (static_cast<void *>(bytes)) T(std::forward<Args>(args)...); }
+
+        /// Moves the element to `out` and destroys it
+        void moveTo(T &out)
+        {
+            T *value = get();
+            out = std::move(*value);
+            value->~T();
+        }
+    };
+
+    inline size_t roundCapacity(size_t capacity, size_t minimum)
+    {
+        if (capacity == 0 || capacity > (size_t(1) << (sizeof(size_t) * 8 - 2)))
+        {
+            throw std::invalid_argument("Ring capacity must be positive");
+        }
+        return std::bit_ceil(std::max(capacity, minimum));
+    }
+} // namespace ring_detail
+
+/**
+ * @brief Wait strategy that keeps a waiting thread on its core: it spins, then yields.
+ * Lowest hand-off latency when every thread has a core of its own, wasted cycles otherwise.
+ */
+struct SpinWait
+{
+    class Event
+    {
+    public:
+        uint32_t prepare() noexcept { return 0; }
+        void cancel() noexcept {}
+        void wait(uint32_t) noexcept { std::this_thread::yield(); }
+        void notify() noexcept {}
+    };
+};
+
+/**
+ * @brief Wait strategy that parks a waiting thread in the kernel (a futex on Linux) after
+ * the initial spin. The other side pays a fence and a load per operation to check for
+ * parked threads, and a wake-up only when there is one.
+ */
+struct BlockingWait
+{
+    /**
+     * @brief An event count: a waiter announces itself with prepare(), re-checks its
+     * condition, then waits for the epoch to move past the one it saw, so a notify()
+     * between the check and the wait is not lost.
+     */
+    class Event
+    {
+    public:
+        uint32_t prepare() noexcept
+        {
+            waiters_.fetch_add(1, std::memory_order_seq_cst);
+            // The caller re-checks its condition next, which must not move before the increment
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return epoch_.load(std::memory_order_seq_cst);
+        }
+
+        void cancel() noexcept { waiters_.fetch_sub(1, std::memory_order_relaxed); }
+
+        void wait(uint32_t key) noexcept
+        {
+            epoch_.wait(key, std::memory_order_seq_cst);
+            waiters_.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void notify() noexcept
+        {
+            // Orders the caller's publication before the check for waiters, pairing with the
+            // increment in prepare()
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters_.load(std::memory_order_relaxed) > 0)
+            {
+                epoch_.fetch_add(1, std::memory_order_seq_cst);
+                epoch_.notify_all();
+            }
+        }
+
+    private:
+        std::atomic<uint32_t> epoch_{0};
+        std::atomic<uint32_t> waiters_{0};
+    };
+};
+
+/**
+ * @brief A bounded single-producer single-consumer queue in a ring of slots.
+ *
+ * The producer and the consumer each own an index on a cache line of its own and keep a
+ * private copy of the other's index, refreshed only when the ring looks full (or empty),
+ * so in the steady state a hand-off moves no cache line but the slot's. Batch calls
+ * publish any number of elements with one store.
+ *
+ * The try* calls never wait. The blocking calls spin briefly, then wait according to
+ * `Wait` (SpinWait or BlockingWait) until they can proceed or the ring is closed. At
+ * most one thread may push and one thread may pop at any time.
+ *
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T, typename Wait = BlockingWait>
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity)
+        : capacity_(ring_detail::roundCapacity(capacity, 1)), mask_(capacity_ - 1),
+          slots_(std::make_unique<ring_detail::Storage<T>[]>(capacity_))
+    {
+    }
+
+    ~SpscRing()
+    {
+        for (size_t i = tail_.load(std::memory_order_relaxed); i != head_.load(std::memory_order_relaxed); ++i)
+        {
+            slots_[i & mask_].get()->~T();
+        }
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    /**
+     * @brief The number of elements, exact only while neither side is running.
+     */
+    size_t size() const noexcept
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    template <typename... Args>
+    bool tryEmplace(Args &&...args)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - cached_tail_ == capacity_)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+            if (head - cached_tail_ == capacity_)
+            {
+                return false;
+            }
+        }
+        slots_[head & mask_].construct(std::forward<Args>(args)...);
+        head_.store(head + 1, std::memory_order_release);
+        not_empty_.notify();
+        return true;
+    }
+
+    bool tryPush(const T &value) { return tryEmplace(value); }
+    bool tryPush(T &&value) { return tryEmplace(std::move(value)); }
+
+    bool tryPop(T &out)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == cached_head_)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+            if (tail == cached_head_)
+            {
+                return false;
+            }
+        }
+        slots_[tail & mask_].moveTo(out);
+        tail_.store(tail + 1, std::memory_order_release);
+        not_full_.notify();
+        return true;
+    }
+
+    /**
+     * @brief Moves as many of the `count` values as fit into the ring.
+     * @return The number of values pushed, a prefix of `values`
+     */
+    size_t tryPushBatch(T *values, size_t count)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (capacity_ - (head - cached_tail_) < count)
+        {
+            cached_tail_ = tail_.load(std::memory_order_acquire);
+        }
+        size_t n = std::min(count, capacity_ - (head - cached_tail_));
+        for (size_t i = 0; i < n; ++i)
+        {
+            slots_[(head + i) & mask_].construct(std::move(values[i]));
+        }
+        if (n > 0)
+        {
+            head_.store(head + n, std::memory_order_release);
+            not_empty_.notify();
+        }
+        return n;
+    }
+
+    /**
+     * @brief Moves up to `max` elements to `out`.
+     * @return The number of elements popped
+     */
+    size_t tryPopBatch(T *out, size_t max)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (cached_head_ - tail < max)
+        {
+            cached_head_ = head_.load(std::memory_order_acquire);
+        }
+        size_t n = std::min(max, cached_head_ - tail);
+        for (size_t i = 0; i < n; ++i)
+        {
+            slots_[(tail + i) & mask_].moveTo(out[i]);
+        }
+        if (n > 0)
+        {
+            tail_.store(tail + n, std::memory_order_release);
+            not_full_.notify();
+        }
+        return n;
+    }
+
+    /**
+     * @brief Pushes `value`, waiting while the ring is full.
+     * @return false if the ring was closed; `value` is left untouched then
+     */
+    bool push(T value)
+    {
+        return waitFor(not_full_, [&]()
+                       { return tryPush(std::move(value)); });
+    }
+
+    /**
+     * @brief Pops an element, waiting while the ring is empty.
+     * @return false once the ring is closed and empty
+     */
+    bool pop(T &out)
+    {
+        return waitFor(not_empty_, [&]()
+                       { return tryPop(out); }) ||
+               tryPop(out);
+    }
+
+    /**
+     * @brief Pushes all `count` values, waiting for room as needed.
+     * @return The number of values pushed, less than `count` only if the ring was closed
+     */
+    size_t pushBatch(T *values, size_t count)
+    {
+        size_t pushed = 0;
+        waitFor(not_full_, [&]()
+                { return (pushed += tryPushBatch(values + pushed, count - pushed)) == count; });
+        return pushed;
+    }
+
+    /**
+     * @brief Pops between 1 and `max` elements, waiting while the ring is empty.
+     * @return The number of elements popped, 0 once the ring is closed and empty
+     */
+    size_t popBatch(T *out, size_t max)
+    {
+        size_t popped = 0;
+        if (!waitFor(not_empty_, [&]()
+                     { return (popped = tryPopBatch(out, max)) > 0; }))
+        {
+            popped = tryPopBatch(out, max);
+        }
+        return popped;
+    }
+
+    /**
+     * @brief Makes waiting and future blocking pushes fail, and blocking pops fail once
+     * the ring is drained. Wakes up all waiting threads.
+     */
+    void close() noexcept
+    {
+        closed_.store(true, std::memory_order_seq_cst);
+        not_empty_.notify();
+        not_full_.notify();
+    }
+
+    bool closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+
+private:
+    /**
+     * @brief Calls `attempt` until it succeeds or the ring is closed, spinning first, then
+     * yielding, then waiting on `event`.
+     */
+    template <typename Attempt>
+    bool waitFor(typename Wait::Event &event, Attempt attempt)
+    {
+        for (int spins = 0;; ++spins)
+        {
+            if (closed_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            if (attempt())
+            {
+                return true;
+            }
+            if (spins < ring_detail::kSpinLimit)
+            {
+                ring_detail::pause();
+                continue;
+            }
+            if (spins < ring_detail::kYieldLimit)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t key = event.prepare();
+            if (closed_.load(std::memory_order_seq_cst))
+            {
+                event.cancel();
+                return false;
+            }
+            if (attempt())
+            {
+                event.cancel();
+                return true;
+            }
+            event.wait(key);
+        }
+    }
+
+    // Producer side
+    alignas(ring_detail::kCacheLine) std::atomic<size_t> head_{0};
+    size_t cached_tail_ = 0;
+
+    // Consumer side
+    alignas(ring_detail::kCacheLine) std::atomic<size_t> tail_{0};
+    size_t cached_head_ = 0;
+
+    alignas(ring_detail::kCacheLine) typename Wait::Event not_empty_;
+    alignas(ring_detail::kCacheLine) typename Wait::Event not_full_;
+    std::atomic<bool> closed_{false};
+
+    alignas(ring_detail::kCacheLine) const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<ring_detail::Storage<T>[]> slots_;
+};
+
+/**
+ * @brief A bounded multi-producer multi-consumer queue (Dmitry Vyukov's design).
+ *
+ * Every cell carries a sequence number that says whose turn it is: the producer of
+ * position p may fill the cell once its sequence is p, the consumer of p may empty it
+ * once its sequence is p + 1. Producers and consumers claim positions with a CAS on their
+ * own index, each on a cache line of its own, and then only touch the claimed cell, so
+ * producers do not wait for consumers (or each other) beyond the CAS. Batch calls claim a
+ * run of consecutive cells with one CAS.
+ *
+ * The try* calls never wait. The blocking calls spin briefly, then wait according to
+ * `Wait` (SpinWait or BlockingWait) until they can proceed or the ring is closed.
+ *
+ * The capacity is rounded up to a power of two, at least 2.
+ */
+template <typename T, typename Wait = BlockingWait>
+class MpmcRing
+{
+public:
+    explicit MpmcRing(size_t capacity)
+        : capacity_(ring_detail::roundCapacity(capacity, 2)), mask_(capacity_ - 1),
+          cells_(std::make_unique<Cell[]>(capacity_))
+    {
+        for (size_t i = 0; i < capacity_; ++i)
+        {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpmcRing()
+    {
+        size_t end = enqueue_pos_.load(std::memory_order_relaxed);
+        for (size_t i = dequeue_pos_.load(std::memory_order_relaxed); i != end; ++i)
+        {
+            cells_[i & mask_].storage.get()->~T();
+        }
+    }
+
+    MpmcRing(const MpmcRing &) = delete;
+    MpmcRing &operator=(const MpmcRing &) = delete;
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    /**
+     * @brief The number of claimed positions, exact only while no thread is running.
+     */
+    size_t size() const noexcept
+    {
+        size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+        size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+        return enqueued > dequeued ? enqueued - dequeued : 0;
+    }
+
+    bool empty() const noexcept { return size() == 0; }
+
+    template <typename... Args>
+    bool tryEmplace(Args &&...args)
+    {
+        size_t position;
+        if (claim(enqueue_pos_, 0, 1, position) == 0)
+        {
+            return false;
+        }
+        Cell &cell = cells_[position & mask_];
+        cell.storage.construct(std::forward<Args>(args)...);
+        cell.sequence.store(position + 1, std::memory_order_release);
+        not_empty_.notify();
+        return true;
+    }
+
+    bool tryPush(const T &value) { return tryEmplace(value); }
+    bool tryPush(T &&value) { return tryEmplace(std::move(value)); }
+
+    bool tryPop(T &out)
+    {
+        size_t position;
+        if (claim(dequeue_pos_, 1, 1, position) == 0)
+        {
+            return false;
+        }
+        Cell &cell = cells_[position & mask_];
+        cell.storage.moveTo(out);
+        cell.sequence.store(position + capacity_, std::memory_order_release);
+        not_full_.notify();
+        return true;
+    }
+
+    /**
+     * @brief Moves as many of the `count` values as there are free consecutive cells.
+     * @return The number of values pushed, a prefix of `values`
+     */
+    size_t tryPushBatch(T *values, size_t count)
+    {
+        size_t position;
+        size_t n = claim(enqueue_pos_, 0, count, position);
+        for (size_t i = 0; i < n; ++i)
+        {
+            Cell &cell = cells_[(position + i) & mask_];
+            cell.storage.construct(std::move(values[i]));
+            cell.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        if (n > 0)
+        {
+            not_empty_.notify();
+        }
+        return n;
+    }
+
+    /**
+     * @brief Moves up to `max` elements from consecutive cells to `out`.
+     * @return The number of elements popped
+     */
+    size_t tryPopBatch(T *out, size_t max)
+    {
+        size_t position;
+        size_t n = claim(dequeue_pos_, 1, max, position);
+        for (size_t i = 0; i < n; ++i)
+        {
+            Cell &cell = cells_[(position + i) & mask_];
+            cell.storage.moveTo(out[i]);
+            cell.sequence.store(position + i + capacity_, std::memory_order_release);
+        }
+        if (n > 0)
+        {
+            not_full_.notify();
+        }
+        return n;
+    }
+
+    /**
+     * @brief Pushes `value`, waiting while the ring is full.
+     * @return false if the ring was closed; `value` is left untouched then
+     */
+    bool push(T value)
+    {
+        return waitFor(not_full_, [&]()
+                       { return tryPush(std::move(value)); });
+    }
+
+    /**
+     * @brief Pops an element, waiting while the ring is empty.
+     * @return false once the ring is closed and empty
+     */
+    bool pop(T &out)
+    {
+        return waitFor(not_empty_, [&]()
+                       { return tryPop(out); }) ||
+               tryPop(out);
+    }
+
+    /**
+     * @brief Pushes all `count` values, waiting for room as needed.
+     * @return The number of values pushed, less than `count` only if the ring was closed
+     */
+    size_t pushBatch(T *values, size_t count)
+    {
+        size_t pushed = 0;
+        waitFor(not_full_, [&]()
+                { return (pushed += tryPushBatch(values + pushed, count - pushed)) == count; });
+        return pushed;
+    }
+
+    /**
+     * @brief Pops between 1 and `max` elements, waiting while the ring is empty.
+     * @return The number of elements popped, 0 once the ring is closed and empty
+     */
+    size_t popBatch(T *out, size_t max)
+    {
+        size_t popped = 0;
+        if (!waitFor(not_empty_, [&]()
+                     { return (popped = tryPopBatch(out, max)) > 0; }))
+        {
+            popped = tryPopBatch(out, max);
+        }
+        return popped;
+    }
+
+    /**
+     * @brief Makes waiting and future blocking pushes fail, and blocking pops fail once
+     * the ring is drained. Wakes up all waiting threads.
+     */
+    void close() noexcept
+    {
+        closed_.store(true, std::memory_order_seq_cst);
+        not_empty_.notify();
+        not_full_.notify();
+    }
+
+    bool closed() const noexcept { return closed_.load(std::memory_order_acquire); }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        ring_detail::Storage<T> storage;
+    };
+
+    /**
+     * @brief Claims up to `max` consecutive positions on `index` whose cells have the
+     * sequence `position + lag`: free cells for producers (lag 0), full cells for
+     * consumers (lag 1).
+     * @return The number of positions claimed, starting at `position`
+     */
+    size_t claim(std::atomic<size_t> &index, size_t lag, size_t max, size_t &position)
+    {
+        max = std::min(max, capacity_);
+        position = index.load(std::memory_order_relaxed);
+        while (max > 0)
+        {
+            size_t ready = 0;
+            while (ready < max)
+            {
+                size_t sequence = cells_[(position + ready) & mask_].sequence.load(std::memory_order_acquire);
+                if (sequence != position + ready + lag)
+                {
+                    break;
+                }
+                ++ready;
+            }
+            if (ready > 0)
+            {
+                if (index.compare_exchange_weak(position, position + ready, std::memory_order_relaxed))
+                {
+                    return ready;
+                }
+                continue;
+            }
+            // The first cell is a lap behind: the ring is full (or empty). Otherwise another
+            // thread claimed the position first.
+            size_t sequence = cells_[position & mask_].sequence.load(std::memory_order_acquire);
+            if (static_cast<intptr_t>(sequence - (position + lag)) < 0)
+            {
+                return 0;
+            }
+            position = index.load(std::memory_order_relaxed);
+        }
+        return 0;
+    }
+
+    template <typename Attempt>
+    bool waitFor(typename Wait::Event &event, Attempt attempt)
+    {
+        for (int spins = 0;; ++spins)
+        {
+            if (closed_.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            if (attempt())
+            {
+                return true;
+            }
+            if (spins < ring_detail::kSpinLimit)
+            {
+                ring_detail::pause();
+                continue;
+            }
+            if (spins < ring_detail::kYieldLimit)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            uint32_t key = event.prepare();
+            if (closed_.load(std::memory_order_seq_cst))
+            {
+                event.cancel();
+                return false;
+            }
+            if (attempt())
+            {
+                event.cancel();
+                return true;
+            }
+            event.wait(key);
+        }
+    }
+
+    alignas(ring_detail::kCacheLine) std::atomic<size_t> enqueue_pos_{0};
+    alignas(ring_detail::kCacheLine) std::atomic<size_t> dequeue_pos_{0};
+    alignas(ring_detail::kCacheLine) typename Wait::Event not_empty_;
+    alignas(ring_detail::kCacheLine) typename Wait::Event not_full_;
+    std::atomic<bool> closed_{false};
+
+    alignas(ring_detail::kCacheLine) const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<Cell[]> cells_;
+};
@@ -0,0 +1,266 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "ring_buffer.h"
+
+// Hand-off cost of SpscRing and MpmcRing, with both wait strategies, against a bounded
+// deque guarded by a mutex and two condition variables. "Transfer" moves 1K to 1M
+// integers (BENCHMARK_MAX_SIZE raises the limit) from the producers to the consumers
+// through a queue of 1024, one at a time or in batches of 64, and reports items per second.
+// "PingPong" bounces one integer between two threads through two queues and reports the
+// p50 and p99 round trip.
+
+namespace
+{
+    constexpr size_t kCapacity = 1024;
+    constexpr size_t kBatch = 64;
+    constexpr int kRoundTrips = 20000;
+
+    /**
+     * @brief The baseline: a bounded deque guarded by a mutex, with the same blocking calls
+     * as the rings.
+     */
+    class MutexQueue
+    {
+    public:
+        explicit MutexQueue(size_t capacity) : capacity_(capacity) {}
+
+        bool push(int64_t value)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [&]()
+                           { return closed_ || queue_.size() < capacity_; });
+            if (closed_)
+            {
+                return false;
+            }
+            queue_.push_back(value);
+            not_empty_.notify_one();
+            return true;
+        }
+
+        bool pop(int64_t &out)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [&]()
+                            { return closed_ || !queue_.empty(); });
+            if (queue_.empty())
+            {
+                return false;
+            }
+            out = queue_.front();
+            queue_.pop_front();
+            not_full_.notify_one();
+            return true;
+        }
+
+        size_t pushBatch(int64_t *values, size_t count)
+        {
+            size_t pushed = 0;
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (pushed < count)
+            {
+                not_full_.wait(lock, [&]()
+                               { return closed_ || queue_.size() < capacity_; });
+                if (closed_)
+                {
+                    break;
+                }
+                size_t n = std::min(count - pushed, capacity_ - queue_.size());
+                queue_.insert(queue_.end(), values + pushed, values + pushed + n);
+                pushed += n;
+                not_empty_.notify_all();
+            }
+            return pushed;
+        }
+
+        size_t popBatch(int64_t *out, size_t max)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [&]()
+                            { return closed_ || !queue_.empty(); });
+            size_t n = std::min(max, queue_.size());
+            std::copy_n(queue_.begin(), n, out);
+            queue_.erase(queue_.begin(), queue_.begin() + static_cast<std::ptrdiff_t>(n));
+            if (n > 0)
+            {
+                not_full_.notify_all();
+            }
+            return n;
+        }
+
+        void close()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+            not_empty_.notify_all();
+            not_full_.notify_all();
+        }
+
+    private:
+        const size_t capacity_;
+        std::mutex mutex_;
+        std::condition_variable not_empty_;
+        std::condition_variable not_full_;
+        std::deque<int64_t> queue_;
+        bool closed_ = false;
+    };
+
+    /**
+     * @brief Moves `items` integers from `producers` threads to `consumers` threads through
+     * a fresh queue.
+     */
+    template <typename Queue>
+    void transfer(int64_t items, int producers, int consumers, bool batch)
+    {
+        Queue queue(kCapacity);
+        std::vector<std::thread> threads;
+        std::atomic<int> producers_left{producers};
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+                                 {
+                                     int64_t values[kBatch];
+                                     for (int64_t i = p; i < items;)
+                                     {
+                                         if (!batch)
+                                         {
+                                             queue.push(i);
+                                             i += producers;
+                                             continue;
+                                         }
+                                         size_t n = 0;
+                                         for (; n < kBatch && i < items; ++n, i += producers)
+                                         {
+                                             values[n] = i;
+                                         }
+                                         queue.pushBatch(values, n);
+                                     }
+                                     if (--producers_left == 0)
+                                     {
+                                         queue.close();
+                                     } });
+        }
+        for (int c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&]()
+                                 {
+                                     int64_t values[kBatch];
+                                     int64_t sum = 0;
+                                     if (batch)
+                                     {
+                                         while (size_t n = queue.popBatch(values, kBatch))
+                                         {
+                                             sum += values[n - 1];
+                                         }
+                                     }
+                                     else
+                                     {
+                                         while (queue.pop(values[0]))
+                                         {
+                                             sum += values[0];
+                                         }
+                                     }
+                                     benchmark::DoNotOptimize(sum); });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    /**
+     * @brief Bounces an integer between two threads through two queues and reports the
+     * round trip percentiles.
+     */
+    template <typename Queue>
+    void pingPong(benchmark::State &state)
+    {
+        std::vector<double> round_trips;
+        round_trips.reserve(static_cast<size_t>(kRoundTrips) * 4);
+        for (auto _ : state)
+        {
+            Queue ping(kCapacity);
+            Queue pong(kCapacity);
+            std::thread echo([&]()
+                             {
+                                 int64_t value;
+                                 while (ping.pop(value))
+                                 {
+                                     pong.push(value);
+                                 } });
+            for (int i = 0; i < kRoundTrips; ++i)
+            {
+                auto start = std::chrono::steady_clock::now();
+                int64_t value = i;
+                ping.push(value);
+                pong.pop(value);
+                round_trips.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+            }
+            ping.close();
+            echo.join();
+        }
+        std::sort(round_trips.begin(), round_trips.end());
+        state.counters["p50_ns"] = round_trips[round_trips.size() / 2];
+        state.counters["p99_ns"] = round_trips[round_trips.size() * 99 / 100];
+        state.SetItemsProcessed(kRoundTrips * state.iterations());
+    }
+
+    void singlePairArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"items", "producers", "consumers", "batch"});
+        benchmark->ArgsProduct({benchmarkSizes(1000000), {1}, {1}, {0, 1}});
+        benchmark->UseRealTime();
+        benchmark->Unit(benchmark::kMillisecond);
+    }
+
+    void manyPairsArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"items", "producers", "consumers", "batch"});
+        for (int64_t pairs : {1, 4})
+        {
+            benchmark->ArgsProduct({benchmarkSizes(1000000), {pairs}, {pairs}, {0, 1}});
+        }
+        benchmark->UseRealTime();
+        benchmark->Unit(benchmark::kMillisecond);
+    }
+} // namespace
+
+template <typename Queue>
+static void BM_Transfer(benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        transfer<Queue>(state.range(0), static_cast<int>(state.range(1)), static_cast<int>(state.range(2)),
+                        state.range(3) != 0);
+    }
+    state.SetItemsProcessed(state.range(0) * state.iterations());
+}
+
+BENCHMARK_TEMPLATE(BM_Transfer, MutexQueue)->Apply(manyPairsArgs);
+BENCHMARK_TEMPLATE(BM_Transfer, SpscRing<int64_t, BlockingWait>)->Apply(singlePairArgs);
+BENCHMARK_TEMPLATE(BM_Transfer, SpscRing<int64_t, SpinWait>)->Apply(singlePairArgs);
+BENCHMARK_TEMPLATE(BM_Transfer, MpmcRing<int64_t, BlockingWait>)->Apply(manyPairsArgs);
+BENCHMARK_TEMPLATE(BM_Transfer, MpmcRing<int64_t, SpinWait>)->Apply(manyPairsArgs);
+
+template <typename Queue>
+static void BM_PingPong(benchmark::State &state)
+{
+    pingPong<Queue>(state);
+}
+BENCHMARK_TEMPLATE(BM_PingPong, MutexQueue)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PingPong, SpscRing<int64_t, BlockingWait>)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PingPong, SpscRing<int64_t, SpinWait>)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PingPong, MpmcRing<int64_t, BlockingWait>)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PingPong, MpmcRing<int64_t, SpinWait>)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
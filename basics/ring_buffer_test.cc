@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ring_buffer.h"
+
+namespace
+{
+    template <typename Ring>
+    class RingTest : public testing::Test
+    {
+    };
+
+    using Rings = testing::Types<SpscRing<std::unique_ptr<int>, BlockingWait>, SpscRing<std::unique_ptr<int>, SpinWait>,
+                                 MpmcRing<std::unique_ptr<int>, BlockingWait>, MpmcRing<std::unique_ptr<int>, SpinWait>>;
+    TYPED_TEST_SUITE(RingTest, Rings);
+
+    /**
+     * @brief Sends 0..count-1 from `producers` threads to `consumers` threads through `ring`,
+     * alternating between single and batch calls, and checks every value arrives once.
+     * With one producer and one consumer, also checks the order.
+     */
+    template <typename Ring>
+    void transfer(Ring &ring, int producers, int consumers, int count)
+    {
+        std::vector<std::atomic<int>> received(static_cast<size_t>(count));
+        std::atomic<int> producers_left{producers};
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+                                 {
+                                     std::vector<std::unique_ptr<int>> batch;
+                                     for (int i = p; i < count; i += producers)
+                                     {
+                                         if (i % 3 == 0)
+                                         {
+                                             ASSERT_EQ(ring.pushBatch(batch.data(), batch.size()), batch.size());
+                                             batch.clear();
+                                             ASSERT_TRUE(ring.push(std::make_unique<int>(i)));
+                                             continue;
+                                         }
+                                         batch.push_back(std::make_unique<int>(i));
+                                         if (batch.size() == 5)
+                                         {
+                                             ASSERT_EQ(ring.pushBatch(batch.data(), batch.size()), batch.size());
+                                             batch.clear();
+                                         }
+                                     }
+                                     ASSERT_EQ(ring.pushBatch(batch.data(), batch.size()), batch.size());
+                                     if (--producers_left == 0)
+                                     {
+                                         ring.close();
+                                     } });
+        }
+        for (int c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&, c]()
+                                 {
+                                     std::unique_ptr<int> values[7];
+                                     int last = -1;
+                                     while (true)
+                                     {
+                                         size_t n = c % 2 == 0 ? ring.popBatch(values, 7) : ring.pop(values[0]) ? 1 : 0;
+                                         if (n == 0)
+                                         {
+                                             break;
+                                         }
+                                         for (size_t i = 0; i < n; ++i)
+                                         {
+                                             if (producers == 1 && consumers == 1)
+                                             {
+                                                 ASSERT_GT(*values[i], last);
+                                             }
+                                             last = *values[i];
+                                             received[static_cast<size_t>(*values[i])]++;
+                                         }
+                                     } });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(received[static_cast<size_t>(i)].load(), 1) << i;
+        }
+    }
+} // namespace
+
+TYPED_TEST(RingTest, RespectsCapacityAndOrder)
+{
+    TypeParam ring(3);
+    EXPECT_EQ(ring.capacity(), 4u);
+    EXPECT_TRUE(ring.empty());
+    std::unique_ptr<int> out;
+    EXPECT_FALSE(ring.tryPop(out));
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(ring.tryPush(std::make_unique<int>(i)));
+    }
+    auto extra = std::make_unique<int>(4);
+    EXPECT_FALSE(ring.tryPush(std::move(extra)));
+    EXPECT_NE(extra, nullptr);
+    EXPECT_EQ(ring.size(), 4u);
+
+    ASSERT_TRUE(ring.tryPop(out));
+    EXPECT_EQ(*out, 0);
+    std::unique_ptr<int> batch[4] = {std::make_unique<int>(10), std::make_unique<int>(11), std::make_unique<int>(12)};
+    EXPECT_EQ(ring.tryPushBatch(batch, 3), 1u);
+    EXPECT_EQ(batch[0], nullptr);
+    EXPECT_NE(batch[1], nullptr);
+
+    std::unique_ptr<int> popped[8];
+    ASSERT_EQ(ring.tryPopBatch(popped, 8), 4u);
+    EXPECT_EQ(*popped[0], 1);
+    EXPECT_EQ(*popped[3], 10);
+    EXPECT_EQ(ring.tryPopBatch(popped, 8), 0u);
+
+    // Wrapping around many times
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(ring.tryEmplace(new int(i)));
+        ASSERT_TRUE(ring.tryPop(out));
+        ASSERT_EQ(*out, i);
+    }
+    EXPECT_THROW(TypeParam(0), std::invalid_argument);
+}
+
+TYPED_TEST(RingTest, CloseWakesWaitersAndDrains)
+{
+    TypeParam ring(2);
+    std::unique_ptr<int> out;
+    std::thread waiter([&]()
+                       { EXPECT_FALSE(ring.pop(out)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ring.close();
+    waiter.join();
+
+    TypeParam full(2);
+    full.push(std::make_unique<int>(1));
+    full.push(std::make_unique<int>(2));
+    std::thread pusher([&]()
+                       { EXPECT_FALSE(full.push(std::make_unique<int>(3))); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    full.close();
+    pusher.join();
+    // What was pushed before closing can still be popped
+    ASSERT_TRUE(full.pop(out));
+    EXPECT_EQ(*out, 1);
+    std::unique_ptr<int> rest[2];
+    EXPECT_EQ(full.popBatch(rest, 2), 1u);
+    EXPECT_FALSE(full.pop(out));
+    EXPECT_EQ(full.popBatch(rest, 2), 0u);
+}
+
+TYPED_TEST(RingTest, HandsOffBetweenThreads)
+{
+    TypeParam ring(16);
+    transfer(ring, 1, 1, 20000);
+}
+
+TEST(MpmcRingTest, HandsOffBetweenManyThreads)
+{
+    MpmcRing<std::unique_ptr<int>, BlockingWait> blocking(8);
+    transfer(blocking, 3, 3, 30000);
+    MpmcRing<std::unique_ptr<int>, SpinWait> spinning(64);
+    transfer(spinning, 2, 4, 30000);
+}
+
+TEST(RingBufferTest, DestroysWhatIsLeft)
+{
+    auto counter = std::make_shared<int>(0);
+    {
+        MpmcRing<std::shared_ptr<int>> mpmc(8);
+        SpscRing<std::shared_ptr<int>> spsc(8);
+        for (int i = 0; i < 5; ++i)
+        {
+            mpmc.push(counter);
+            spsc.push(counter);
+        }
+        EXPECT_EQ(counter.use_count(), 11);
+    }
+    EXPECT_EQ(counter.use_count(), 1);
+}
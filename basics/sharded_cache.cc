@@ -0,0 +1,337 @@
+#include "sharded_cache.h"
+
+#include <algorithm>
+
+namespace cache_detail
+{
+    void EntryList::pushFront(EntryBase *entry) noexcept
+    {
+        entry->prev = nullptr;
+        entry->next = front_;
+        if (front_)
+        {
+            front_->prev = entry;
+        }
+        else
+        {
+            back_ = entry;
+        }
+        front_ = entry;
+        bytes_ += entry->charge;
+        ++size_;
+    }
+
+    void EntryList::remove(EntryBase *entry) noexcept
+    {
+        if (entry->prev)
+        {
+            entry->prev->next = entry->next;
+        }
+        else
+        {
+            front_ = entry->next;
+        }
+        if (entry->next)
+        {
+            entry->next->prev = entry->prev;
+        }
+        else
+        {
+            back_ = entry->prev;
+        }
+        entry->prev = nullptr;
+        entry->next = nullptr;
+        bytes_ -= entry->charge;
+        --size_;
+    }
+
+    EntryBase *EntryList::unpinnedBack() const noexcept
+    {
+        for (EntryBase *entry = back_; entry; entry = entry->prev)
+        {
+            if (!entry->pinned())
+            {
+                return entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void GhostList::add(uint64_t hash, size_t charge)
+    {
+        take(hash);
+        order_.emplace_back(hash, charge);
+        index_[hash] = std::prev(order_.end());
+        bytes_ += charge;
+    }
+
+    bool GhostList::take(uint64_t hash)
+    {
+        auto it = index_.find(hash);
+        if (it == index_.end())
+        {
+            return false;
+        }
+        bytes_ -= it->second->second;
+        order_.erase(it->second);
+        index_.erase(it);
+        return true;
+    }
+
+    void GhostList::dropOldest()
+    {
+        bytes_ -= order_.front().second;
+        index_.erase(order_.front().first);
+        order_.pop_front();
+    }
+
+    void FrequencySketch::resize(size_t counters)
+    {
+        counters_.assign(counters, 0);
+        mask_ = counters - 1;
+        additions_ = 0;
+        // Halving after ten increments per counter keeps the counts recent
+        sample_size_ = 10 * counters;
+    }
+
+    void FrequencySketch::ensureCapacity(size_t entries)
+    {
+        size_t counters = counters_.size();
+        while (counters < entries * 4)
+        {
+            counters *= 2;
+        }
+        if (counters != counters_.size())
+        {
+            resize(counters);
+        }
+    }
+
+    size_t FrequencySketch::index(uint64_t hash, int row) const noexcept
+    {
+        static constexpr uint64_t kSeeds[] = {0x97CB3127ull, 0xB15D4E3Bull, 0xC6B2F11Dull, 0x8E4C3A2Full};
+        uint64_t h = (hash + kSeeds[row]) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(h >> 32) & mask_;
+    }
+
+    void FrequencySketch::increment(uint64_t hash) noexcept
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            uint8_t &counter = counters_[index(hash, row)];
+            counter += counter < 15;
+        }
+        if (++additions_ >= sample_size_)
+        {
+            for (uint8_t &counter : counters_)
+            {
+                counter >>= 1;
+            }
+            additions_ /= 2;
+        }
+    }
+
+    uint32_t FrequencySketch::frequency(uint64_t hash) const noexcept
+    {
+        uint32_t frequency = 15;
+        for (int row = 0; row < 4; ++row)
+        {
+            frequency = std::min<uint32_t>(frequency, counters_[index(hash, row)]);
+        }
+        return frequency;
+    }
+} // namespace cache_detail
+
+using cache_detail::EntryBase;
+
+void LruPolicy::access(EntryBase *entry)
+{
+    list_.remove(entry);
+    list_.pushFront(entry);
+}
+
+void ClockPolicy::insert(EntryBase *entry)
+{
+    entry->referenced.store(false, std::memory_order_relaxed);
+    list_.pushFront(entry);
+}
+
+EntryBase *ClockPolicy::victim()
+{
+    // Every entry is passed at most twice: once to clear its bit, once to evict it. Pinned
+    // entries are passed over, up to a full sweep of only pinned entries.
+    for (size_t passed = 0; passed <= 2 * list_.size(); ++passed)
+    {
+        EntryBase *entry = list_.back();
+        if (!entry)
+        {
+            return nullptr;
+        }
+        if (!entry->pinned() && !entry->referenced.exchange(false, std::memory_order_relaxed))
+        {
+            return entry;
+        }
+        list_.remove(entry);
+        list_.pushFront(entry);
+    }
+    return nullptr;
+}
+
+namespace
+{
+    constexpr uint8_t kT1 = 1;
+    constexpr uint8_t kT2 = 2;
+
+    constexpr uint8_t kWindow = 1;
+    constexpr uint8_t kProbation = 2;
+    constexpr uint8_t kProtected = 3;
+} // namespace
+
+void ArcPolicy::insert(EntryBase *entry)
+{
+    size_t b1 = b1_.bytes();
+    size_t b2 = b2_.bytes();
+    if (b1_.take(entry->hash))
+    {
+        // Recently evicted from T1: T1 was too small
+        size_t delta = std::max(entry->charge, b1 > 0 ? entry->charge * b2 / b1 : 0);
+        target_ = std::min(capacity_, target_ + delta);
+        entry->list = kT2;
+        t2_.pushFront(entry);
+    }
+    else if (b2_.take(entry->hash))
+    {
+        size_t delta = std::max(entry->charge, b2 > 0 ? entry->charge * b1 / b2 : 0);
+        target_ = target_ > delta ? target_ - delta : 0;
+        entry->list = kT2;
+        t2_.pushFront(entry);
+    }
+    else
+    {
+        entry->list = kT1;
+        t1_.pushFront(entry);
+    }
+    trimGhosts();
+}
+
+void ArcPolicy::access(EntryBase *entry)
+{
+    (entry->list == kT1 ? t1_ : t2_).remove(entry);
+    entry->list = kT2;
+    t2_.pushFront(entry);
+}
+
+void ArcPolicy::remove(EntryBase *entry, bool evicted)
+{
+    (entry->list == kT1 ? t1_ : t2_).remove(entry);
+    if (evicted)
+    {
+        (entry->list == kT1 ? b1_ : b2_).add(entry->hash, entry->charge);
+        trimGhosts();
+    }
+}
+
+EntryBase *ArcPolicy::victim()
+{
+    EntryBase *from_t1 = t1_.unpinnedBack();
+    EntryBase *from_t2 = t2_.unpinnedBack();
+    if (from_t1 && (t1_.bytes() > target_ || !from_t2))
+    {
+        return from_t1;
+    }
+    return from_t2 ? from_t2 : from_t1;
+}
+
+void ArcPolicy::trimGhosts()
+{
+    // T1 and B1 together stay within the capacity, all four lists within twice of it
+    while (!b1_.empty() && t1_.bytes() + b1_.bytes() > capacity_)
+    {
+        b1_.dropOldest();
+    }
+    while (t1_.bytes() + t2_.bytes() + b1_.bytes() + b2_.bytes() > 2 * capacity_ && !(b1_.empty() && b2_.empty()))
+    {
+        (b2_.empty() ? b1_ : b2_).dropOldest();
+    }
+}
+
+TinyLfuPolicy::TinyLfuPolicy(size_t capacity)
+    : capacity_(capacity), window_capacity_(std::max<size_t>(capacity / 100, 1)),
+      protected_capacity_((capacity - std::min(capacity, window_capacity_)) / 10 * 8)
+{
+}
+
+cache_detail::EntryList &TinyLfuPolicy::listOf(const EntryBase *entry)
+{
+    return entry->list == kWindow ? window_ : entry->list == kProbation ? probation_ : protected_;
+}
+
+void TinyLfuPolicy::insert(EntryBase *entry)
+{
+    sketch_.ensureCapacity(++entries_);
+    sketch_.increment(entry->hash);
+    entry->list = kWindow;
+    window_.pushFront(entry);
+    // Until the main cache is full, entries leave the window for it unfiltered
+    size_t main_capacity = capacity_ - std::min(capacity_, window_capacity_);
+    while (window_.bytes() > window_capacity_ &&
+           probation_.bytes() + protected_.bytes() + window_.back()->charge <= main_capacity)
+    {
+        EntryBase *oldest = window_.back();
+        window_.remove(oldest);
+        oldest->list = kProbation;
+        probation_.pushFront(oldest);
+    }
+}
+
+void TinyLfuPolicy::access(EntryBase *entry)
+{
+    sketch_.increment(entry->hash);
+    listOf(entry).remove(entry);
+    if (entry->list == kProbation)
+    {
+        entry->list = kProtected;
+    }
+    listOf(entry).pushFront(entry);
+    // Protected entries beyond its share go back on probation
+    while (protected_.bytes() > protected_capacity_)
+    {
+        EntryBase *demoted = protected_.back();
+        protected_.remove(demoted);
+        demoted->list = kProbation;
+        probation_.pushFront(demoted);
+    }
+}
+
+void TinyLfuPolicy::remove(EntryBase *entry, bool)
+{
+    --entries_;
+    listOf(entry).remove(entry);
+}
+
+EntryBase *TinyLfuPolicy::victim()
+{
+    EntryBase *candidate = window_.bytes() > window_capacity_ ? window_.unpinnedBack() : nullptr;
+    EntryBase *main = probation_.unpinnedBack();
+    if (!main)
+    {
+        main = protected_.unpinnedBack();
+    }
+    if (!candidate)
+    {
+        return main ? main : window_.unpinnedBack();
+    }
+    if (!main)
+    {
+        return candidate;
+    }
+    // The window's oldest entry replaces the main victim only if it is used more often
+    if (sketch_.frequency(candidate->hash) > sketch_.frequency(main->hash))
+    {
+        window_.remove(candidate);
+        candidate->list = kProbation;
+        probation_.pushFront(candidate);
+        return main;
+    }
+    return candidate;
+}
@@ -0,0 +1,538 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "flat_hash_map.h"
+
+namespace cache_detail
+{
+    /**
+     * @brief The part of a cache entry the eviction policies see: its hash and charge, its
+     * pin count, and the links of the policy list it is on.
+     */
+    struct EntryBase
+    {
+        EntryBase(uint64_t hash, size_t charge) : hash(hash), charge(charge) {}
+
+        /// Pinned entries are in use by a Handle and must not be evicted
+        bool pinned() const noexcept { return refs.load(std::memory_order_relaxed) > 1; }
+
+        const uint64_t hash;
+        const size_t charge;
+
+        // One reference for the cache while the entry is in it, one per Handle
+        std::atomic<uint32_t> refs{1};
+
+        // Policy state: the list the entry is on, its neighbours there (prev towards the
+        // front, the most recently used end) and the CLOCK reference bit
+        EntryBase *prev = nullptr;
+        EntryBase *next = nullptr;
+        uint8_t list = 0;
+        std::atomic<bool> referenced{false};
+    };
+
+    /**
+     * @brief An intrusive doubly linked list of entries that sums their charges.
+     */
+    class EntryList
+    {
+    public:
+        void pushFront(EntryBase *entry) noexcept;
+        void remove(EntryBase *entry) noexcept;
+
+        EntryBase *back() const noexcept { return back_; }
+
+        /// The entry nearest the back that is not pinned, or null
+        EntryBase *unpinnedBack() const noexcept;
+
+        size_t bytes() const noexcept { return bytes_; }
+        size_t size() const noexcept { return size_; }
+        bool empty() const noexcept { return size_ == 0; }
+
+    private:
+        EntryBase *front_ = nullptr;
+        EntryBase *back_ = nullptr;
+        size_t bytes_ = 0;
+        size_t size_ = 0;
+    };
+
+    /**
+     * @brief Hashes of recently evicted entries and their charges, oldest dropped first.
+     */
+    class GhostList
+    {
+    public:
+        void add(uint64_t hash, size_t charge);
+
+        /// Removes the hash if present
+        bool take(uint64_t hash);
+
+        void dropOldest();
+
+        size_t bytes() const noexcept { return bytes_; }
+        bool empty() const noexcept { return order_.empty(); }
+
+    private:
+        std::list<std::pair<uint64_t, size_t>> order_;
+        std::unordered_map<uint64_t, std::list<std::pair<uint64_t, size_t>>::iterator> index_;
+        size_t bytes_ = 0;
+    };
+
+    /**
+     * @brief A count-min sketch of 4 bit access counters, halved periodically so that old
+     * popularity fades.
+     */
+    class FrequencySketch
+    {
+    public:
+        FrequencySketch() { resize(1024); }
+
+        void increment(uint64_t hash) noexcept;
+        uint32_t frequency(uint64_t hash) const noexcept;
+
+        /// Grows the sketch to track about `entries` distinct keys
+        void ensureCapacity(size_t entries);
+
+    private:
+        void resize(size_t counters);
+        size_t index(uint64_t hash, int row) const noexcept;
+
+        std::vector<uint8_t> counters_;
+        size_t mask_ = 0;
+        size_t additions_ = 0;
+        size_t sample_size_ = 0;
+    };
+
+    inline uint64_t mix(uint64_t hash)
+    {
+        return flat_hash_detail::mix(hash);
+    }
+} // namespace cache_detail
+
+/**
+ * @brief Least recently used eviction: hits move an entry to the front, the back goes.
+ */
+class LruPolicy
+{
+public:
+    /// Whether access() may run concurrently under a shared lock
+    static constexpr bool kConcurrentHits = false;
+
+    explicit LruPolicy(size_t) {}
+
+    void insert(cache_detail::EntryBase *entry) { list_.pushFront(entry); }
+    void access(cache_detail::EntryBase *entry);
+    void remove(cache_detail::EntryBase *entry, bool) { list_.remove(entry); }
+
+    /// The next entry to evict, null when every entry is pinned
+    cache_detail::EntryBase *victim() { return list_.unpinnedBack(); }
+
+private:
+    cache_detail::EntryList list_;
+};
+
+/**
+ * @brief CLOCK (second chance) eviction. A hit only sets the entry's reference bit, so hits
+ * run in parallel under the shard's shared lock; eviction passes over referenced entries
+ * once, clearing their bit.
+ */
+class ClockPolicy
+{
+public:
+    static constexpr bool kConcurrentHits = true;
+
+    explicit ClockPolicy(size_t) {}
+
+    void insert(cache_detail::EntryBase *entry);
+    void access(cache_detail::EntryBase *entry) { entry->referenced.store(true, std::memory_order_relaxed); }
+    void remove(cache_detail::EntryBase *entry, bool) { list_.remove(entry); }
+    cache_detail::EntryBase *victim();
+
+private:
+    // The back is where the hand points; passed entries move to the front
+    cache_detail::EntryList list_;
+};
+
+/**
+ * @brief Adaptive replacement (ARC), weighted by charge. Entries seen once (T1) and seen
+ * again (T2) are kept apart, and the share of T1 adapts to hits on recently evicted keys:
+ * a miss on a key evicted from T1 grows T1's target, one on a key evicted from T2 shrinks
+ * it. Resists scans, which only ever reach T1.
+ */
+class ArcPolicy
+{
+public:
+    static constexpr bool kConcurrentHits = false;
+
+    explicit ArcPolicy(size_t capacity) : capacity_(capacity) {}
+
+    void insert(cache_detail::EntryBase *entry);
+    void access(cache_detail::EntryBase *entry);
+    void remove(cache_detail::EntryBase *entry, bool evicted);
+    cache_detail::EntryBase *victim();
+
+private:
+    void trimGhosts();
+
+    size_t capacity_;
+    // Target bytes of T1
+    size_t target_ = 0;
+    cache_detail::EntryList t1_;
+    cache_detail::EntryList t2_;
+    cache_detail::GhostList b1_;
+    cache_detail::GhostList b2_;
+};
+
+/**
+ * @brief W-TinyLFU: new entries enter a small LRU window (1% of the capacity). Once the
+ * cache is full, an entry leaving the window only stays if a frequency sketch says it is
+ * used more often than the main cache's eviction victim. The main cache is a segmented
+ * LRU whose protected segment (80%) holds entries hit while on probation. Keeps
+ * frequently used entries through scans and bursts of one-off keys.
+ */
+class TinyLfuPolicy
+{
+public:
+    static constexpr bool kConcurrentHits = false;
+
+    explicit TinyLfuPolicy(size_t capacity);
+
+    void insert(cache_detail::EntryBase *entry);
+    void access(cache_detail::EntryBase *entry);
+    void remove(cache_detail::EntryBase *entry, bool evicted);
+    cache_detail::EntryBase *victim();
+
+private:
+    cache_detail::EntryList &listOf(const cache_detail::EntryBase *entry);
+
+    size_t capacity_;
+    size_t window_capacity_;
+    size_t protected_capacity_;
+    size_t entries_ = 0;
+    cache_detail::EntryList window_;
+    cache_detail::EntryList probation_;
+    cache_detail::EntryList protected_;
+    cache_detail::FrequencySketch sketch_;
+};
+
+struct CacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+
+    /// Sum of the charges of the cached entries
+    size_t bytes = 0;
+};
+
+/**
+ * @brief A thread-safe cache bounded by the summed charges (usually the bytes) of its
+ * entries, with the eviction policy as a template parameter: LruPolicy, ClockPolicy,
+ * ArcPolicy or TinyLfuPolicy.
+ *
+ * Keys are spread over shards by hash, each with its own lock, index and policy state, and
+ * an even share of the capacity. Lookups take the shard's lock exclusively, except with
+ * policies whose hits only touch atomics (ClockPolicy), where they share it.
+ *
+ * lookup() and insert() return a Handle that pins the entry: while any handle to it
+ * lives, the entry is neither evicted nor freed, and stays valid even if it is replaced or
+ * erased. Pinned entries still count towards the capacity; when only pinned entries are
+ * left, an insert goes over the capacity rather than fail. Entries charged more than a
+ * shard holds are never cached, but insert() still returns a handle to them.
+ *
+ * @tparam K Key type, copy constructible
+ * @tparam V Value type, copy or move constructible
+ */
+template <typename K, typename V, typename Policy = LruPolicy, typename Hash = std::hash<K>,
+          typename KeyEqual = std::equal_to<K>>
+class ShardedCache
+{
+    struct Entry : cache_detail::EntryBase
+    {
+        Entry(K key, V value, uint64_t hash, size_t charge)
+            : EntryBase(hash, charge), key(std::move(key)), value(std::move(value))
+        {
+        }
+
+        const K key;
+        const V value;
+    };
+
+    static void release(Entry *entry) noexcept
+    {
+        if (entry->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            delete entry;
+        }
+    }
+
+public:
+    /**
+     * @brief A pinned reference to a cached value. Move-only; empty after a miss.
+     */
+    class Handle
+    {
+    public:
+        Handle() = default;
+        explicit Handle(Entry *entry) : entry_(entry) {}
+        ~Handle() { reset(); }
+
+        Handle(Handle &&other) noexcept : entry_(std::exchange(other.entry_, nullptr)) {}
+
+        Handle &operator=(Handle &&other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                entry_ = std::exchange(other.entry_, nullptr);
+            }
+            return *this;
+        }
+
+        Handle(const Handle &) = delete;
+        Handle &operator=(const Handle &) = delete;
+
+        explicit operator bool() const noexcept { return entry_ != nullptr; }
+
+        const K &key() const { return entry_->key; }
+        const V &value() const { return entry_->value; }
+        const V &operator*() const { return entry_->value; }
+        const V *operator->() const { return &entry_->value; }
+        size_t charge() const { return entry_->charge; }
+
+        /// Unpins the entry
+        void reset() noexcept
+        {
+            if (entry_)
+            {
+                release(entry_);
+                entry_ = nullptr;
+            }
+        }
+
+    private:
+        Entry *entry_ = nullptr;
+    };
+
+    /**
+     * @param capacity Upper bound of the summed charges, split evenly between the shards
+     * @throws std::invalid_argument for zero shards
+     */
+    explicit ShardedCache(size_t capacity, size_t num_shards = 16, const Hash &hash = Hash(),
+                          const KeyEqual &equal = KeyEqual())
+        : capacity_(capacity), hash_(hash)
+    {
+        if (num_shards == 0)
+        {
+            throw std::invalid_argument("A cache needs at least one shard");
+        }
+        shard_capacity_ = capacity / num_shards;
+        for (size_t i = 0; i < num_shards; ++i)
+        {
+            shards_.push_back(std::make_unique<Shard>(shard_capacity_, hash, equal));
+        }
+    }
+
+    ~ShardedCache()
+    {
+        for (auto &shard : shards_)
+        {
+            for (const auto &slot : shard->index)
+            {
+                release(slot.second);
+            }
+        }
+    }
+
+    ShardedCache(const ShardedCache &) = delete;
+    ShardedCache &operator=(const ShardedCache &) = delete;
+
+    size_t capacity() const noexcept { return capacity_; }
+    size_t numShards() const noexcept { return shards_.size(); }
+
+    /**
+     * @return A handle pinning the entry, empty on a miss
+     */
+    Handle lookup(const K &key)
+    {
+        Shard &shard = shardFor(hashOf(key));
+        if constexpr (Policy::kConcurrentHits)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            return lookupLocked(shard, key);
+        }
+        else
+        {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            return lookupLocked(shard, key);
+        }
+    }
+
+    /**
+     * @brief Inserts the value, replacing any entry with the key, and evicts entries to
+     * make room.
+     * @param charge The entry's share of the capacity, typically the bytes it holds
+     * @return A handle pinning the new entry
+     */
+    Handle insert(const K &key, V value, size_t charge) { return insertImpl(key, std::move(value), charge, true); }
+
+    /**
+     * @brief Inserts the value unless the key is present.
+     * @return A handle pinning the cached entry, the present one if any
+     */
+    Handle tryInsert(const K &key, V value, size_t charge) { return insertImpl(key, std::move(value), charge, false); }
+
+    /**
+     * @brief Returns the cached value, or calls `load(size_t &charge)` and caches the value
+     * it returns. The load runs without locks, so concurrent misses of one key may load it
+     * more than once; the first insert wins and the others get its value. Exceptions of
+     * `load` propagate and nothing is cached.
+     */
+    template <typename Load>
+    Handle getOrLoad(const K &key, Load &&load)
+    {
+        if (Handle handle = lookup(key))
+        {
+            return handle;
+        }
+        size_t charge = 0;
+        V value = load(charge);
+        return tryInsert(key, std::move(value), charge);
+    }
+
+    /**
+     * @return Whether the key was cached. Handles to the entry stay valid.
+     */
+    bool erase(const K &key)
+    {
+        Shard &shard = shardFor(hashOf(key));
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.index.find(key);
+        if (it == shard.index.end())
+        {
+            return false;
+        }
+        detach(shard, it->second, false);
+        return true;
+    }
+
+    CacheStats stats() const
+    {
+        CacheStats stats;
+        for (const auto &shard : shards_)
+        {
+            std::shared_lock<std::shared_mutex> lock(shard->mutex);
+            stats.hits += shard->hits.load(std::memory_order_relaxed);
+            stats.misses += shard->misses.load(std::memory_order_relaxed);
+            stats.evictions += shard->evictions;
+            stats.entries += shard->index.size();
+            stats.bytes += shard->bytes;
+        }
+        return stats;
+    }
+
+private:
+    struct Shard
+    {
+        Shard(size_t capacity, const Hash &hash, const KeyEqual &equal)
+            : capacity(capacity), policy(capacity), index(0, hash, equal)
+        {
+        }
+
+        mutable std::shared_mutex mutex;
+        const size_t capacity;
+        Policy policy;
+        FlatHashMap<K, Entry *, Hash, KeyEqual> index;
+        size_t bytes = 0;
+
+        std::atomic<uint64_t> hits{0};
+        std::atomic<uint64_t> misses{0};
+        uint64_t evictions = 0;
+    };
+
+    uint64_t hashOf(const K &key) const { return cache_detail::mix(static_cast<uint64_t>(hash_(key))); }
+
+    Shard &shardFor(uint64_t hash) { return *shards_[(hash >> 32) % shards_.size()]; }
+
+    Handle lookupLocked(Shard &shard, const K &key)
+    {
+        auto it = shard.index.find(key);
+        if (it == shard.index.end())
+        {
+            shard.misses.fetch_add(1, std::memory_order_relaxed);
+            return Handle();
+        }
+        Entry *entry = it->second;
+        entry->refs.fetch_add(1, std::memory_order_relaxed);
+        shard.policy.access(entry);
+        shard.hits.fetch_add(1, std::memory_order_relaxed);
+        return Handle(entry);
+    }
+
+    Handle insertImpl(const K &key, V value, size_t charge, bool replace)
+    {
+        uint64_t hash = hashOf(key);
+        Entry *entry = new Entry(key, std::move(value), hash, charge);
+        Shard &shard = shardFor(hash);
+        if (charge > shard.capacity)
+        {
+            return Handle(entry);
+        }
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.index.find(entry->key);
+        if (it != shard.index.end())
+        {
+            if (!replace)
+            {
+                Entry *existing = it->second;
+                existing->refs.fetch_add(1, std::memory_order_relaxed);
+                lock.unlock();
+                delete entry;
+                return Handle(existing);
+            }
+            detach(shard, it->second, false);
+        }
+        while (shard.bytes + charge > shard.capacity)
+        {
+            cache_detail::EntryBase *victim = shard.policy.victim();
+            if (!victim)
+            {
+                break;
+            }
+            detach(shard, static_cast<Entry *>(victim), true);
+            ++shard.evictions;
+        }
+        entry->refs.fetch_add(1, std::memory_order_relaxed);
+        shard.policy.insert(entry);
+        shard.index.insertOrAssign(entry->key, entry);
+        shard.bytes += charge;
+        return Handle(entry);
+    }
+
+    // Takes the entry out of the shard and drops the cache's reference to it
+    void detach(Shard &shard, Entry *entry, bool evicted)
+    {
+        shard.policy.remove(entry, evicted);
+        shard.index.erase(entry->key);
+        shard.bytes -= entry->charge;
+        release(entry);
+    }
+
+    size_t capacity_;
+    size_t shard_capacity_;
+    [[no_unique_address]] Hash hash_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+};
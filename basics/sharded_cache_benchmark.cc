@@ -0,0 +1,106 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "benchmark_data.h"
+#include "sharded_cache.h"
+
+// ShardedCache with each policy under a Zipfian workload (s = 0.99 over 1M keys, the cache
+// holding 10% of them) from 1 to 32 threads: every operation looks a key up and inserts it
+// on a miss. Reports operations per second and the hit rate. The "Scan" variants replace
+// every fourth operation with the next key of a sequential scan over keys never reused.
+
+namespace
+{
+    constexpr size_t kKeys = 1000000;
+    constexpr size_t kCapacity = kKeys / 10;
+    constexpr size_t kOpsPerThread = 1 << 20;
+
+    std::vector<uint64_t> zipfianKeys(size_t count, uint64_t seed)
+    {
+        static const ZipfianGenerator zipfian(kKeys, 0.99);
+        DataGenerator random(seed);
+        std::vector<uint64_t> keys(count);
+        for (uint64_t &key : keys)
+        {
+            key = zipfian(random);
+        }
+        return keys;
+    }
+
+    template <typename Policy>
+    struct Workload
+    {
+        static inline std::unique_ptr<ShardedCache<uint64_t, uint64_t, Policy>> cache;
+    };
+
+    template <typename Policy>
+    void run(benchmark::State &state, bool scans)
+    {
+        auto &cache = Workload<Policy>::cache;
+        if (state.thread_index() == 0)
+        {
+            cache = std::make_unique<ShardedCache<uint64_t, uint64_t, Policy>>(kCapacity);
+            // Warm up so the hit rate is the steady state one
+            for (uint64_t key : zipfianKeys(kKeys, 99))
+            {
+                if (!cache->lookup(key))
+                {
+                    cache->insert(key, key, 1);
+                }
+            }
+        }
+        std::vector<uint64_t> keys = zipfianKeys(kOpsPerThread, static_cast<uint64_t>(state.thread_index()) + 1);
+        // Scan keys are above the Zipfian ones and distinct per thread
+        uint64_t scan_key = kKeys + (static_cast<uint64_t>(state.thread_index()) << 40);
+        size_t i = 0;
+        CacheStats before;
+        if (state.thread_index() == 0)
+        {
+            before = cache->stats();
+        }
+        for (auto _ : state)
+        {
+            uint64_t key = scans && i % 4 == 3 ? scan_key++ : keys[i % kOpsPerThread];
+            ++i;
+            if (!cache->lookup(key))
+            {
+                cache->insert(key, key, 1);
+            }
+        }
+        state.SetItemsProcessed(state.iterations());
+        if (state.thread_index() == 0)
+        {
+            CacheStats after = cache->stats();
+            uint64_t hits = after.hits - before.hits;
+            uint64_t lookups = hits + after.misses - before.misses;
+            state.counters["hit_rate"] = lookups ? static_cast<double>(hits) / static_cast<double>(lookups) : 0;
+            cache.reset();
+        }
+    }
+} // namespace
+
+template <typename Policy>
+static void BM_Zipf(benchmark::State &state)
+{
+    run<Policy>(state, false);
+}
+
+template <typename Policy>
+static void BM_ZipfScan(benchmark::State &state)
+{
+    run<Policy>(state, true);
+}
+
+BENCHMARK_TEMPLATE(BM_Zipf, LruPolicy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Zipf, ClockPolicy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Zipf, ArcPolicy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Zipf, TinyLfuPolicy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ZipfScan, LruPolicy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ZipfScan, ClockPolicy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ZipfScan, ArcPolicy)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ZipfScan, TinyLfuPolicy)->ThreadRange(1, 32)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "sharded_cache.h"
+
+namespace
+{
+    template <typename Policy>
+    class ShardedCachePolicyTest : public testing::Test
+    {
+    };
+
+    using Policies = testing::Types<LruPolicy, ClockPolicy, ArcPolicy, TinyLfuPolicy>;
+    TYPED_TEST_SUITE(ShardedCachePolicyTest, Policies);
+
+    /**
+     * @brief Hit rate on a hot set of 50 keys, read in rounds after a scan of 1000 keys
+     * read once each.
+     */
+    template <typename Policy>
+    double hotSetHitRateAcrossScan()
+    {
+        ShardedCache<int, int, Policy> cache(100, 1);
+        auto read = [&](int key)
+        {
+            bool hit = static_cast<bool>(cache.lookup(key));
+            if (!hit)
+            {
+                cache.insert(key, key, 1);
+            }
+            return hit;
+        };
+        for (int round = 0; round < 5; ++round)
+        {
+            for (int key = 0; key < 50; ++key)
+            {
+                read(key);
+            }
+        }
+        int hits = 0;
+        for (int key = 1000; key < 2000; ++key)
+        {
+            read(key);
+            // The hot set keeps being used during the scan, at a lower rate
+            if (key % 10 == 0)
+            {
+                hits += read((key / 10) % 50);
+            }
+        }
+        return hits / 100.0;
+    }
+} // namespace
+
+TEST(ShardedCacheTest, EvictsLeastRecentlyUsedAndCountsStats)
+{
+    ShardedCache<std::string, int> cache(300, 1);
+    EXPECT_EQ(cache.numShards(), 1u);
+    cache.insert("a", 1, 100);
+    cache.insert("b", 2, 100);
+    cache.insert("c", 3, 100);
+    EXPECT_EQ(*cache.lookup("a"), 1);
+    cache.insert("d", 4, 100);
+    EXPECT_FALSE(cache.lookup("b"));
+    EXPECT_TRUE(cache.lookup("c"));
+
+    // Replacing charges the new size and makes room from the back
+    cache.insert("c", 30, 200);
+    EXPECT_EQ(*cache.lookup("c"), 30);
+    EXPECT_FALSE(cache.lookup("a"));
+    EXPECT_TRUE(cache.lookup("d"));
+
+    // Larger than the shard: handed back, not cached
+    auto big = cache.insert("e", 5, 301);
+    EXPECT_EQ(*big, 5);
+    EXPECT_FALSE(cache.lookup("e"));
+
+    EXPECT_TRUE(cache.erase("c"));
+    EXPECT_FALSE(cache.erase("c"));
+
+    CacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 4u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.evictions, 2u);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.bytes, 100u);
+}
+
+TEST(ShardedCacheTest, PinnedEntriesAreNotEvicted)
+{
+    ShardedCache<int, std::shared_ptr<int>> cache(200, 1);
+    auto value = std::make_shared<int>(7);
+    auto pinned = cache.insert(1, value, 100);
+    cache.insert(2, std::make_shared<int>(8), 100);
+    // Key 1 is the least recently used but pinned, so 2 goes
+    cache.insert(3, std::make_shared<int>(9), 100);
+    EXPECT_TRUE(cache.lookup(1));
+    EXPECT_FALSE(cache.lookup(2));
+
+    // With every entry pinned the cache goes over its capacity instead of failing
+    auto also_pinned = cache.lookup(3);
+    cache.insert(4, std::make_shared<int>(10), 100);
+    EXPECT_EQ(cache.stats().bytes, 300u);
+    also_pinned.reset();
+    cache.insert(5, std::make_shared<int>(11), 100);
+    EXPECT_EQ(cache.stats().bytes, 200u);
+
+    // Erased and replaced entries stay valid while pinned
+    cache.erase(1);
+    EXPECT_FALSE(cache.lookup(1));
+    EXPECT_EQ(**pinned, 7);
+    EXPECT_EQ(value.use_count(), 2);
+    pinned.reset();
+    EXPECT_EQ(value.use_count(), 1);
+}
+
+TEST(ShardedCacheTest, GetOrLoadKeepsTheFirstValue)
+{
+    ShardedCache<std::string, int, ClockPolicy> cache(1000, 4);
+    auto first = cache.getOrLoad("k", [](size_t &charge)
+                                 {
+                                     charge = 10;
+                                     return 1; });
+    auto second = cache.getOrLoad("k", [](size_t &) -> int
+                                  { throw std::logic_error("not called on a hit"); });
+    EXPECT_EQ(*first, 1);
+    EXPECT_EQ(*second, 1);
+    EXPECT_THROW(cache.getOrLoad("x", [](size_t &) -> int
+                                 { throw std::runtime_error("load failed"); }),
+                 std::runtime_error);
+    EXPECT_FALSE(cache.lookup("x"));
+    EXPECT_THROW((ShardedCache<int, int>(100, 0)), std::invalid_argument);
+}
+
+TEST(ShardedCacheTest, ScanResistantPoliciesKeepTheHotSet)
+{
+    double lru = hotSetHitRateAcrossScan<LruPolicy>();
+    double arc = hotSetHitRateAcrossScan<ArcPolicy>();
+    double tiny_lfu = hotSetHitRateAcrossScan<TinyLfuPolicy>();
+    EXPECT_GT(arc, lru + 0.3) << lru;
+    EXPECT_GT(tiny_lfu, lru + 0.3) << lru;
+}
+
+TYPED_TEST(ShardedCachePolicyTest, StaysWithinCapacityAndReturnsWhatWasInserted)
+{
+    ShardedCache<int, int, TypeParam> cache(10000, 4);
+    std::mt19937 rng(9);
+    for (int i = 0; i < 20000; ++i)
+    {
+        int key = static_cast<int>(rng() % 2000);
+        if (auto handle = cache.lookup(key))
+        {
+            ASSERT_EQ(*handle, key * 3);
+        }
+        else
+        {
+            cache.insert(key, key * 3, 10 + key % 20);
+        }
+        ASSERT_LE(cache.stats().bytes, cache.capacity());
+    }
+    CacheStats stats = cache.stats();
+    EXPECT_GT(stats.hits, 0u);
+    EXPECT_GT(stats.evictions, 0u);
+    EXPECT_EQ(stats.hits + stats.misses, 20000u);
+}
+
+TYPED_TEST(ShardedCachePolicyTest, IsSafeUnderConcurrentUse)
+{
+    ShardedCache<int, std::shared_ptr<const int>, TypeParam> cache(64 * 100, 4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&cache, t]()
+                             {
+                                 std::mt19937 rng(static_cast<unsigned>(t));
+                                 for (int i = 0; i < 5000; ++i)
+                                 {
+                                     int key = static_cast<int>(rng() % 300);
+                                     auto handle = cache.getOrLoad(key, [key](size_t &charge)
+                                                                   {
+                                                                       charge = 100;
+                                                                       return std::make_shared<const int>(key); });
+                                     ASSERT_EQ(**handle, key);
+                                     if (i % 100 == 0)
+                                     {
+                                         cache.erase(key);
+                                     }
+                                 } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    CacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 20000u);
+    EXPECT_LE(stats.bytes, cache.capacity());
+}
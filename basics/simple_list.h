@@ -1,5 +1,11 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
 /**
  * @brief A simple node implementation
  * @tparam T The type of the value in the node
@@ -26,32 +32,42 @@ public:
  * @brief A simple list implementation
  * @tparam T The type of the values in the list
  * 
+ * Nodes are allocated with `Allocator`, rebound to the node type (e.g. an ArenaAllocator).
+ *
  * This class is not thread-safe. In debug builds, it will actively detect and
  * report any access from multiple threads by throwing an exception.
  */
-template <typename T>
+template <typename T, typename Allocator = std::allocator<T>>
 class SimpleList
 {
 public:
     SimpleList() = default;
-    ~SimpleList() = default;
+    explicit SimpleList(const Allocator &allocator) : allocator_(allocator) {}
+    ~SimpleList() { _release_nodes(); }
 
     // Delete copy constructor and copy assignment operator
     SimpleList(const SimpleList &) = delete;
     SimpleList &operator=(const SimpleList &) = delete;
 
     SimpleList(SimpleList &&other) noexcept
-        : head_(other.head_), tail_(other.tail_), size_(other.size_), sorted_ascending_(other.sorted_ascending_)
+        : head_(other.head_), tail_(other.tail_), size_(other.size_), sorted_ascending_(other.sorted_ascending_),
+          allocator_(other.allocator_)
     {
         other.clear();
     }
 
     SimpleList &operator=(SimpleList &&other) noexcept
     {
+        if (this == &other)
+        {
+            return *this;
+        }
+        _release_nodes();
         head_ = other.head_;
         tail_ = other.tail_;
         size_ = other.size_;
         sorted_ascending_ = other.sorted_ascending_;
+        allocator_ = other.allocator_;
         other.clear();
         return *this;
     }
@@ -62,6 +78,12 @@ public:
     class Iterator
     {
     public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = T const *;
+        using reference = T const &;
+
         Iterator(SimpleNode<T> *node) : current_(node) {}
 
         T const &operator*() const { return current_->value; }
@@ -72,6 +94,11 @@ public:
             return *this;
         }
 
+        bool operator==(Iterator const &other) const noexcept
+        {
+            return current_ == other.current_;
+        }
+
         bool operator!=(Iterator const &other) const noexcept
         {
             return current_ != other.current_;
@@ -97,7 +124,7 @@ public:
     void pushBack(T value) noexcept;
 
     void insertSorted(T value);
-    void merge(SimpleList<T> &other);
+    void merge(SimpleList &other);
 
     T const &front() const;
     T const &back() const;
@@ -131,7 +158,22 @@ private:
     int size_ = 0;
     bool sorted_ascending_ = true;
 
-    void _merge_sorted(SimpleList<T> &other);
+    // Each node shares one allocation with its shared_ptr control block
+    [[no_unique_address]] Allocator allocator_;
+
+    void _merge_sorted(SimpleList &other);
+
+    // Frees the nodes front to back; letting the head go would free the chain recursively,
+    // one stack frame per node, and overflow the stack on long lists
+    void _release_nodes() noexcept
+    {
+        tail_ = nullptr;
+        while (head_ != nullptr && head_.use_count() == 1)
+        {
+            head_ = std::move(head_->next);
+        }
+        head_ = nullptr;
+    }
 
 #ifdef _DEBUG
     mutable std::atomic<int> thread_id_;
@@ -154,15 +196,15 @@ private:
     }
 };
 
-template <typename T>
-void SimpleList<T>::pushFront(T value) noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::pushFront(T value) noexcept
 {
     _check_thread_safety();
     if (head_ != nullptr)
     {
         sorted_ascending_ &= (head_->value >= value);
     }
-    head_ = std::make_shared<SimpleNode<T>>(value, head_);
+    head_ = std::allocate_shared<SimpleNode<T>>(allocator_, value, head_);
     if (tail_ == nullptr)
     {
         tail_ = head_;
@@ -170,8 +212,8 @@ void SimpleList<T>::pushFront(T value) noexcept
     ++size_;
 }
 
-template <typename T>
-void SimpleList<T>::pushBack(T value) noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::pushBack(T value) noexcept
 {
     _check_thread_safety();
     if (head_ == nullptr)
@@ -180,13 +222,13 @@ void SimpleList<T>::pushBack(T value) noexcept
         return;
     }
     sorted_ascending_ &= (tail_->value <= value);
-    tail_->next = std::make_shared<SimpleNode<T>>(value, nullptr);
+    tail_->next = std::allocate_shared<SimpleNode<T>>(allocator_, value, nullptr);
     tail_ = tail_->next;
     ++size_;
 }
 
-template <typename T>
-T const &SimpleList<T>::front() const
+template <typename T, typename Allocator>
+T const &SimpleList<T, Allocator>::front() const
 {
     _check_thread_safety();
     if (head_ == nullptr)
@@ -196,8 +238,8 @@ T const &SimpleList<T>::front() const
     return head_->value;
 }
 
-template <typename T>
-T const &SimpleList<T>::back() const
+template <typename T, typename Allocator>
+T const &SimpleList<T, Allocator>::back() const
 {
     _check_thread_safety();
     if (tail_ == nullptr)
@@ -207,18 +249,17 @@ T const &SimpleList<T>::back() const
     return tail_->value;
 }
 
-template <typename T>
-void SimpleList<T>::clear() noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::clear() noexcept
 {
     _check_thread_safety();
-    head_ = nullptr;
-    tail_ = nullptr;
+    _release_nodes();
     size_ = 0;
     sorted_ascending_ = true;
 }
 
-template <typename T>
-void SimpleList<T>::reverse() noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::reverse() noexcept
 {
     _check_thread_safety();
     if (size_ <= 1)
@@ -256,8 +297,8 @@ void SimpleList<T>::reverse() noexcept
     sorted_ascending_ = !found_unsorted_pair;
 }
 
-template <typename T>
-void SimpleList<T>::insertSorted(T value)
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::insertSorted(T value)
 {
     _check_thread_safety();
     if (!sorted_ascending_)
@@ -274,7 +315,7 @@ void SimpleList<T>::insertSorted(T value)
     {
         current = current->next.get();
     }
-    current->next = std::make_shared<SimpleNode<T>>(value, current->next);
+    current->next = std::allocate_shared<SimpleNode<T>>(allocator_, value, current->next);
     if (current->next->next == nullptr)
     {
         tail_ = current->next;
@@ -282,8 +323,8 @@ void SimpleList<T>::insertSorted(T value)
     ++size_;
 }
 
-template <typename T>
-void SimpleList<T>::sort() noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::sort() noexcept
 {
     _check_thread_safety();
     if (sorted_ascending_)
@@ -299,8 +340,8 @@ void SimpleList<T>::sort() noexcept
     }
 }
 
-template <typename T>
-void SimpleList<T>::keepIf(std::function<bool(T)> const &func) noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::keepIf(std::function<bool(T)> const &func) noexcept
 {
     _check_thread_safety();
     // Remove elements from the head that don't satisfy the predicate
@@ -348,22 +389,22 @@ void SimpleList<T>::keepIf(std::function<bool(T)> const &func) noexcept
     sorted_ascending_ = sorted_after_filter;
 }
 
-template <typename T>
-void SimpleList<T>::removeIf(std::function<bool(T)> const &func) noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::removeIf(std::function<bool(T)> const &func) noexcept
 {
     keepIf([&func](T x)
             { return !func(x); });
 }
 
-template <typename T>
-void SimpleList<T>::remove(T const &value) noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::remove(T const &value) noexcept
 {
     removeIf([&value](T x)
               { return x == value; });
 }
 
-template <typename T>
-void SimpleList<T>::transform(std::function<T(T)> const &func) noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::transform(std::function<T(T)> const &func) noexcept
 {
     _check_thread_safety();
     auto current = head_;
@@ -382,8 +423,8 @@ void SimpleList<T>::transform(std::function<T(T)> const &func) noexcept
     sorted_ascending_ = sorted_after_transform;
 }
 
-template <typename T>
-T SimpleList<T>::popFront()
+template <typename T, typename Allocator>
+T SimpleList<T, Allocator>::popFront()
 {
     _check_thread_safety();
     if (head_ == nullptr)
@@ -403,15 +444,15 @@ T SimpleList<T>::popFront()
     return value;
 }
 
-template <typename T>
-bool SimpleList<T>::contains(T const &value) const noexcept
+template <typename T, typename Allocator>
+bool SimpleList<T, Allocator>::contains(T const &value) const noexcept
 {
     _check_thread_safety();
     return std::find(begin(), end(), value) != end();
 }
 
-template <typename T>
-int SimpleList<T>::countIf(std::function<bool(T)> const &func) const noexcept
+template <typename T, typename Allocator>
+int SimpleList<T, Allocator>::countIf(std::function<bool(T)> const &func) const noexcept
 {
     _check_thread_safety();
     int count = 0;
@@ -425,16 +466,16 @@ int SimpleList<T>::countIf(std::function<bool(T)> const &func) const noexcept
     return count;
 }
 
-template <typename T>
-int SimpleList<T>::count(T const &value) const noexcept
+template <typename T, typename Allocator>
+int SimpleList<T, Allocator>::count(T const &value) const noexcept
 {
     _check_thread_safety();
     return countIf([&value](T x)
                     { return x == value; });
 }
 
-template <typename T>
-void SimpleList<T>::unique() noexcept
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::unique() noexcept
 {
     _check_thread_safety();
     if (size_ <= 1)
@@ -458,8 +499,8 @@ void SimpleList<T>::unique() noexcept
     tail_ = current;
 }
 
-template <typename T>
-void SimpleList<T>::merge(SimpleList<T> &other)
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::merge(SimpleList &other)
 {
     _check_thread_safety();
     if (sorted_ascending_ && other.sorted_ascending_)
@@ -490,8 +531,8 @@ void SimpleList<T>::merge(SimpleList<T> &other)
     other.clear();
 }
 
-template <typename T>
-void SimpleList<T>::_merge_sorted(SimpleList<T> &other)
+template <typename T, typename Allocator>
+void SimpleList<T, Allocator>::_merge_sorted(SimpleList &other)
 {
     if (other.empty())
     {
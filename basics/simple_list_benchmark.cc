@@ -1,6 +1,24 @@
 #include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "benchmark_data.h"
 #include "simple_list.h"
 
+// SimpleList operations on lists of 1K to 1M ints (BENCHMARK_MAX_SIZE raises the limit).
+
+namespace
+{
+    void listSizes(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(1000000))
+        {
+            benchmark->Arg(n);
+        }
+        benchmark->Unit(benchmark::kMicrosecond);
+    }
+} // namespace
+
 static void BM_SimpleListPushFront(benchmark::State &state)
 {
     for (auto _ : state)
@@ -11,8 +29,9 @@ static void BM_SimpleListPushFront(benchmark::State &state)
             list.pushFront(i);
         }
     }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_SimpleListPushFront)->Range(8, 2 << 10);
+BENCHMARK(BM_SimpleListPushFront)->Apply(listSizes);
 
 static void BM_SimpleListPushBack(benchmark::State &state)
 {
@@ -24,8 +43,9 @@ static void BM_SimpleListPushBack(benchmark::State &state)
             list.pushBack(i);
         }
     }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_SimpleListPushBack)->Range(8, 2 << 10);
+BENCHMARK(BM_SimpleListPushBack)->Apply(listSizes);
 
 static void BM_SimpleListPopFront(benchmark::State &state)
 {
@@ -44,8 +64,9 @@ static void BM_SimpleListPopFront(benchmark::State &state)
             list.popFront();
         }
     }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_SimpleListPopFront)->Range(8, 2 << 10);
+BENCHMARK(BM_SimpleListPopFront)->Apply(listSizes);
 
 static void BM_SimpleListTransform(benchmark::State &state)
 {
@@ -62,8 +83,9 @@ static void BM_SimpleListTransform(benchmark::State &state)
         list.transform([](int x)
                        { return x * 2; });
     }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_SimpleListTransform)->Range(8, 2 << 10);
+BENCHMARK(BM_SimpleListTransform)->Apply(listSizes);
 
 static void BM_SimpleListKeepIf(benchmark::State &state)
 {
@@ -80,7 +102,8 @@ static void BM_SimpleListKeepIf(benchmark::State &state)
         list.keepIf([](int x)
                     { return x % 2 == 0; });
     }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
 }
-BENCHMARK(BM_SimpleListKeepIf)->Range(8, 2 << 10);
+BENCHMARK(BM_SimpleListKeepIf)->Apply(listSizes);
 
 BENCHMARK_MAIN();
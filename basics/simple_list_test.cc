@@ -121,6 +121,26 @@ TEST(SimpleListTest, Clear)
     EXPECT_TRUE(list.empty());
 }
 
+TEST(SimpleListTest, ReleasesLongLists)
+{
+    // Long enough to overflow the stack if the nodes were freed recursively
+    SimpleList<int> list;
+    for (int i = 0; i < 1000000; ++i)
+    {
+        list.pushBack(i);
+    }
+    SimpleList<int> other;
+    other.pushFront(1);
+    other = std::move(list);
+    EXPECT_EQ(other.count(), 1000000);
+    other.clear();
+    EXPECT_TRUE(other.empty());
+    for (int i = 0; i < 1000000; ++i)
+    {
+        other.pushFront(i);
+    }
+}
+
 TEST(SimpleListTest, Reverse)
 {
     SimpleList<int> list;
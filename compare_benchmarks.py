@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Compares two sets of Google Benchmark JSON reports and flags regressions.
+
+    ./compare_benchmarks.py BASELINE CONTENDER [--threshold 0.05] [--metric real_time]
+
+BASELINE and CONTENDER are JSON reports (--benchmark_out_format=json) or directories of
+them, as written by run_benchmarks.sh; directories are matched by file name. Runs with
+repetitions are compared by their median. A benchmark regressed when the contender is
+slower by more than the threshold and, where both runs report a coefficient of variation,
+by more than the larger of the two (so noisy benchmarks need a clearer change).
+
+Exits with 1 if any benchmark regressed, 0 otherwise.
+"""
+
+import argparse
+import json
+import os
+import re
+import statistics
+import sys
+
+NANOS_PER_UNIT = {"ns": 1, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_reports(path):
+    """Maps report names (file names for directories) to parsed reports."""
+    if os.path.isdir(path):
+        return {
+            name: load_report(os.path.join(path, name))
+            for name in sorted(os.listdir(path))
+            if name.endswith(".json")
+        }
+    return {os.path.basename(path): load_report(path)}
+
+
+def load_report(path):
+    with open(path) as f:
+        return json.load(f)
+
+
+def benchmark_times(report, metric):
+    """Maps benchmark names to (time in ns, coefficient of variation or None)."""
+    medians = {}
+    cvs = {}
+    samples = {}
+    for benchmark in report.get("benchmarks", []):
+        if benchmark.get("error_occurred"):
+            continue
+        name = benchmark.get("run_name", benchmark["name"])
+        if benchmark.get("run_type") == "aggregate":
+            aggregate = benchmark.get("aggregate_name")
+            if aggregate == "median":
+                medians[name] = benchmark[metric] * NANOS_PER_UNIT[benchmark["time_unit"]]
+            elif aggregate == "cv":
+                # cv aggregates hold the ratio in the time fields
+                cvs[name] = benchmark[metric]
+        else:
+            samples.setdefault(name, []).append(benchmark[metric] * NANOS_PER_UNIT[benchmark["time_unit"]])
+    for name, values in samples.items():
+        medians.setdefault(name, statistics.median(values))
+    return {name: (time, cvs.get(name)) for name, time in medians.items()}
+
+
+def format_time(nanos):
+    for unit in ("s", "ms", "us"):
+        if nanos >= NANOS_PER_UNIT[unit]:
+            return "%.3g %s" % (nanos / NANOS_PER_UNIT[unit], unit)
+    return "%.3g ns" % nanos
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline")
+    parser.add_argument("contender")
+    parser.add_argument("--threshold", type=float, default=0.05,
+                        help="relative slowdown flagged as a regression (default 0.05)")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="real_time",
+                        help="time compared (default real_time)")
+    parser.add_argument("--filter", default="", help="only compare benchmarks matching this regex")
+    parser.add_argument("--all", action="store_true", help="also list unchanged benchmarks")
+    args = parser.parse_args()
+
+    baseline = load_reports(args.baseline)
+    contender = load_reports(args.contender)
+    pattern = re.compile(args.filter)
+    regressions = improvements = unchanged = 0
+    missing = []
+    for report in sorted(set(baseline) | set(contender)):
+        if report not in baseline or report not in contender:
+            missing.append(report)
+            continue
+        before = benchmark_times(baseline[report], args.metric)
+        after = benchmark_times(contender[report], args.metric)
+        rows = []
+        for name in before:
+            if not pattern.search(name):
+                continue
+            if name not in after:
+                missing.append(report + ": " + name)
+                continue
+            (old, old_cv), (new, new_cv) = before[name], after[name]
+            change = new / old - 1 if old > 0 else 0.0
+            noise = max(cv for cv in (old_cv, new_cv, 0.0) if cv is not None)
+            limit = max(args.threshold, noise)
+            if change > limit:
+                status = "REGRESSION"
+                regressions += 1
+            elif change < -limit:
+                status = "improved"
+                improvements += 1
+            else:
+                status = ""
+                unchanged += 1
+            if status or args.all:
+                rows.append((name, old, new, change, status))
+        if rows:
+            print(report)
+            width = max(len(row[0]) for row in rows)
+            for name, old, new, change, status in rows:
+                print("  %-*s %10s -> %10s %+7.1f%%  %s" % (width, name, format_time(old), format_time(new),
+                                                           100 * change, status))
+    for name in missing:
+        print("only in one run: " + name)
+    print("%d regressed, %d improved, %d unchanged (threshold %.1f%%, %s)" %
+          (regressions, improvements, unchanged, 100 * args.threshold, args.metric))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
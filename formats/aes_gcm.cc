@@ -0,0 +1,818 @@
+#include "aes_gcm.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    constexpr uint8_t rotl8(uint8_t x, int shift)
+    {
+        return static_cast<uint8_t>((x << shift) | (x >> (8 - shift)));
+    }
+
+    constexpr uint8_t xtime(uint8_t x)
+    {
+        return static_cast<uint8_t>((x << 1) ^ (x & 0x80 ? 0x1B : 0));
+    }
+
+    constexpr std::array<uint8_t, 256> makeSbox()
+    {
+        std::array<uint8_t, 256> sbox{};
+        uint8_t p = 1;
+        uint8_t q = 1;
+        do
+        {
+            // Multiplying p by 3 and dividing q by 3 walks the multiplicative group of
+            // GF(2^8) with q = 1 / p all along; the S-box is the affine map of the inverse
+            p = static_cast<uint8_t>(p ^ xtime(p));
+            q = static_cast<uint8_t>(q ^ (q << 1));
+            q = static_cast<uint8_t>(q ^ (q << 2));
+            q = static_cast<uint8_t>(q ^ (q << 4));
+            q = static_cast<uint8_t>(q ^ (q & 0x80 ? 0x09 : 0));
+            sbox[p] = static_cast<uint8_t>(q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^ rotl8(q, 4) ^ 0x63);
+        } while (p != 1);
+        sbox[0] = 0x63;
+        return sbox;
+    }
+
+    constexpr std::array<uint8_t, 256> kSbox = makeSbox();
+
+    // SubBytes, ShiftRows' byte and MixColumns of one input byte: the column
+    // (2s, s, s, 3s), rotated for the other rows
+    constexpr std::array<uint32_t, 256> makeRoundTable()
+    {
+        std::array<uint32_t, 256> table{};
+        for (size_t x = 0; x < 256; ++x)
+        {
+            uint8_t s = kSbox[x];
+            uint8_t s2 = xtime(s);
+            table[x] = (uint32_t{s2} << 24) | (uint32_t{s} << 16) | (uint32_t{s} << 8) | uint32_t{uint8_t(s2 ^ s)};
+        }
+        return table;
+    }
+
+    constexpr std::array<uint32_t, 256> kRoundTable = makeRoundTable();
+
+    // Reduction of the four bits shifted out of the portable GHASH accumulator
+    constexpr uint64_t kGhashReduction[16] = {0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+                                              0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+
+    inline uint32_t rotr(uint32_t x, int n)
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    inline uint32_t loadBigEndian32(const uint8_t *p)
+    {
+        return (uint32_t{p[0]} << 24) | (uint32_t{p[1]} << 16) | (uint32_t{p[2]} << 8) | uint32_t{p[3]};
+    }
+
+    inline void storeBigEndian32(uint8_t *p, uint32_t value)
+    {
+        p[0] = static_cast<uint8_t>(value >> 24);
+        p[1] = static_cast<uint8_t>(value >> 16);
+        p[2] = static_cast<uint8_t>(value >> 8);
+        p[3] = static_cast<uint8_t>(value);
+    }
+
+    inline uint64_t loadBigEndian64(const uint8_t *p)
+    {
+        return (uint64_t{loadBigEndian32(p)} << 32) | loadBigEndian32(p + 4);
+    }
+
+    inline void storeBigEndian64(uint8_t *p, uint64_t value)
+    {
+        storeBigEndian32(p, static_cast<uint32_t>(value >> 32));
+        storeBigEndian32(p + 4, static_cast<uint32_t>(value));
+    }
+
+    uint32_t subWord(uint32_t word)
+    {
+        return (uint32_t{kSbox[word >> 24]} << 24) | (uint32_t{kSbox[(word >> 16) & 0xFF]} << 16) |
+               (uint32_t{kSbox[(word >> 8) & 0xFF]} << 8) | uint32_t{kSbox[word & 0xFF]};
+    }
+
+    // The 16 byte length block that ends the GHASH input
+    void lengthBlock(size_t aad_size, size_t size, uint8_t *block)
+    {
+        storeBigEndian64(block, uint64_t{aad_size} * 8);
+        storeBigEndian64(block + 8, uint64_t{size} * 8);
+    }
+
+    bool cpuHasAesNi()
+    {
+#if defined(__x86_64__)
+        static const bool supported = __builtin_cpu_supports("aes") && __builtin_cpu_supports("pclmul") &&
+                                      __builtin_cpu_supports("sse4.1");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    bool cpuHasVaes()
+    {
+#if defined(__x86_64__)
+        static const bool supported = cpuHasAesNi() && __builtin_cpu_supports("avx2") &&
+                                      __builtin_cpu_supports("vaes") && __builtin_cpu_supports("vpclmulqdq");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+#if defined(__x86_64__)
+    // The AES-NI code. GHASH works on byte reflected blocks, where a carry-less
+    // multiplication followed by a one bit shift is the GF(2^128) product; the reduction
+    // is linear, so the products of eight blocks are summed before reducing once
+    // (Intel, "Carry-Less Multiplication Instruction and its Usage for Computing the GCM
+    // Mode"). Products take three multiplications (Karatsuba), the XOR of the two halves
+    // of each power of H being computed with the powers.
+
+    // Blocks per AES-NI round and per reduction of GHASH, and the same with VAES and
+    // VPCLMULQDQ, which work on two blocks per 256 bit register
+    constexpr size_t kLanes = 8;
+    constexpr size_t kWideLanes = 16;
+
+    struct Product
+    {
+        __m128i low;
+        __m128i middle;
+        __m128i high;
+    };
+
+    __attribute__((target("pclmul,sse4.1"))) inline __m128i byteReflect(__m128i x)
+    {
+        return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    }
+
+    // The XOR of the two 64 bit halves, in both halves
+    __attribute__((target("pclmul,sse4.1"))) inline __m128i halves(__m128i x)
+    {
+        return _mm_xor_si128(x, _mm_shuffle_epi32(x, 0x4E));
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) inline Product multiply(__m128i a, __m128i b, __m128i b_halves)
+    {
+        return {_mm_clmulepi64_si128(a, b, 0x00), _mm_clmulepi64_si128(halves(a), b_halves, 0x00),
+                _mm_clmulepi64_si128(a, b, 0x11)};
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) inline void accumulate(Product &sum, Product product)
+    {
+        sum.low = _mm_xor_si128(sum.low, product.low);
+        sum.middle = _mm_xor_si128(sum.middle, product.middle);
+        sum.high = _mm_xor_si128(sum.high, product.high);
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) inline __m128i reduce(Product product)
+    {
+        __m128i middle = _mm_xor_si128(product.middle, _mm_xor_si128(product.low, product.high));
+        __m128i low = _mm_xor_si128(product.low, _mm_slli_si128(middle, 8));
+        __m128i high = _mm_xor_si128(product.high, _mm_srli_si128(middle, 8));
+
+        // Shift the 256 bit product left by one
+        __m128i low_carry = _mm_srli_epi32(low, 31);
+        __m128i high_carry = _mm_srli_epi32(high, 31);
+        low = _mm_slli_epi32(low, 1);
+        high = _mm_slli_epi32(high, 1);
+        __m128i cross = _mm_srli_si128(low_carry, 12);
+        high_carry = _mm_slli_si128(high_carry, 4);
+        low_carry = _mm_slli_si128(low_carry, 4);
+        low = _mm_or_si128(low, low_carry);
+        high = _mm_or_si128(_mm_or_si128(high, high_carry), cross);
+
+        // Reduce modulo x^128 + x^7 + x^2 + x + 1
+        __m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)),
+                                  _mm_slli_epi32(low, 25));
+        __m128i b = _mm_srli_si128(a, 4);
+        low = _mm_xor_si128(low, _mm_slli_si128(a, 12));
+        __m128i c = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)),
+                                  _mm_srli_epi32(low, 7));
+        c = _mm_xor_si128(c, b);
+        low = _mm_xor_si128(low, c);
+        return _mm_xor_si128(high, low);
+    }
+
+    // Powers of H are stored from H^16 down to H, then the halves() of each, so that a
+    // 256 bit load gets the powers of two consecutive blocks
+    __attribute__((target("pclmul,sse4.1"))) inline __m128i power(const uint8_t *powers, size_t exponent)
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i *>(powers) + kWideLanes - exponent);
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) inline __m128i powerHalves(const uint8_t *powers, size_t exponent)
+    {
+        return _mm_load_si128(reinterpret_cast<const __m128i *>(powers) + 2 * kWideLanes - exponent);
+    }
+
+    // state' = (state + b0) H^8 + b1 H^7 + ... + b7 H, for blocks as they are in memory
+    __attribute__((target("pclmul,sse4.1"))) inline __m128i absorbLanes(const uint8_t *powers, __m128i state,
+                                                                         const __m128i *blocks)
+    {
+        Product sum = multiply(_mm_xor_si128(state, byteReflect(blocks[0])), power(powers, kLanes),
+                               powerHalves(powers, kLanes));
+        for (size_t lane = 1; lane < kLanes; ++lane)
+        {
+            accumulate(sum, multiply(byteReflect(blocks[lane]), power(powers, kLanes - lane),
+                                     powerHalves(powers, kLanes - lane)));
+        }
+        return reduce(sum);
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) inline __m128i absorb(const uint8_t *powers, __m128i state,
+                                                                    __m128i block)
+    {
+        return reduce(multiply(_mm_xor_si128(state, byteReflect(block)), power(powers, 1), powerHalves(powers, 1)));
+    }
+
+    __attribute__((target("aes,pclmul,sse4.1"))) __m128i encryptBlockHardware(const uint8_t *round_keys, int rounds,
+                                                                              __m128i block)
+    {
+        const auto *keys = reinterpret_cast<const __m128i *>(round_keys);
+        block = _mm_xor_si128(block, _mm_load_si128(keys));
+        for (int round = 1; round < rounds; ++round)
+        {
+            block = _mm_aesenc_si128(block, _mm_load_si128(keys + round));
+        }
+        return _mm_aesenclast_si128(block, _mm_load_si128(keys + rounds));
+    }
+
+    __attribute__((target("aes,pclmul,sse4.1"))) void powersHardware(const uint8_t *round_keys, int rounds,
+                                                                     uint8_t *powers)
+    {
+        __m128i h = byteReflect(encryptBlockHardware(round_keys, rounds, _mm_setzero_si128()));
+        __m128i power = h;
+        auto *out = reinterpret_cast<__m128i *>(powers);
+        for (size_t exponent = 1; exponent <= kWideLanes; ++exponent)
+        {
+            _mm_store_si128(out + kWideLanes - exponent, power);
+            _mm_store_si128(out + 2 * kWideLanes - exponent, halves(power));
+            power = reduce(multiply(power, h, halves(h)));
+        }
+    }
+
+    // Encrypts the counter blocks of eight lanes in place
+    __attribute__((target("aes,pclmul,sse4.1"))) inline void encryptLanes(const __m128i *keys, int rounds,
+                                                                           __m128i *blocks)
+    {
+        for (int round = 1; round < rounds; ++round)
+        {
+            const __m128i key = _mm_load_si128(keys + round);
+            for (size_t lane = 0; lane < kLanes; ++lane)
+            {
+                blocks[lane] = _mm_aesenc_si128(blocks[lane], key);
+            }
+        }
+        const __m128i last_key = _mm_load_si128(keys + rounds);
+        for (size_t lane = 0; lane < kLanes; ++lane)
+        {
+            blocks[lane] = _mm_aesenclast_si128(blocks[lane], last_key);
+        }
+    }
+
+    // The first round key XORed into the counter blocks of eight lanes, from `counter` on
+    __attribute__((target("aes,pclmul,sse4.1"))) inline void counterLanes(const __m128i *keys, __m128i base,
+                                                                           uint32_t counter, __m128i *blocks)
+    {
+        const __m128i first_key = _mm_load_si128(keys);
+        for (size_t lane = 0; lane < kLanes; ++lane)
+        {
+            blocks[lane] = _mm_xor_si128(
+                _mm_insert_epi32(base, static_cast<int>(__builtin_bswap32(counter + static_cast<uint32_t>(lane))), 3),
+                first_key);
+        }
+    }
+
+    __attribute__((target("aes,pclmul,sse4.1"))) __m128i counterBase(const uint8_t *nonce)
+    {
+        uint8_t iv[kAesBlockSize] = {};
+        std::memcpy(iv, nonce, kGcmNonceSize);
+        return _mm_loadu_si128(reinterpret_cast<const __m128i *>(iv));
+    }
+
+    struct WideProduct
+    {
+        __m256i low;
+        __m256i middle;
+        __m256i high;
+    };
+
+    __attribute__((target("aes,pclmul,avx2,vaes,vpclmulqdq"))) inline __m256i byteReflect(__m256i x)
+    {
+        return _mm256_shuffle_epi8(
+            x, _mm256_broadcastsi128_si256(_mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)));
+    }
+
+    __attribute__((target("aes,pclmul,avx2,vaes,vpclmulqdq"))) inline __m256i halves(__m256i x)
+    {
+        return _mm256_xor_si256(x, _mm256_shuffle_epi32(x, 0x4E));
+    }
+
+    __attribute__((target("aes,pclmul,avx2,vaes,vpclmulqdq"))) inline WideProduct multiply(__m256i a, __m256i b,
+                                                                                           __m256i b_halves)
+    {
+        return {_mm256_clmulepi64_epi128(a, b, 0x00), _mm256_clmulepi64_epi128(halves(a), b_halves, 0x00),
+                _mm256_clmulepi64_epi128(a, b, 0x11)};
+    }
+
+    __attribute__((target("aes,pclmul,avx2,vaes,vpclmulqdq"))) inline __m128i fold(__m256i x)
+    {
+        return _mm_xor_si128(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+    }
+
+    // state' = (state + b0) H^16 + b1 H^15 + ... + b15 H, for blocks as they are in memory,
+    // two per register
+    __attribute__((target("aes,pclmul,avx2,vaes,vpclmulqdq"))) inline __m128i absorbWide(const uint8_t *powers,
+                                                                                         __m128i state,
+                                                                                         const __m256i *blocks)
+    {
+        const auto *h = reinterpret_cast<const __m256i *>(powers);
+        const __m256i *h_halves = h + kWideLanes / 2;
+        __m256i first = _mm256_xor_si256(byteReflect(blocks[0]), _mm256_zextsi128_si256(state));
+        WideProduct sum = multiply(first, _mm256_loadu_si256(h), _mm256_loadu_si256(h_halves));
+        for (size_t pair = 1; pair < kWideLanes / 2; ++pair)
+        {
+            WideProduct product =
+                multiply(byteReflect(blocks[pair]), _mm256_loadu_si256(h + pair), _mm256_loadu_si256(h_halves + pair));
+            sum.low = _mm256_xor_si256(sum.low, product.low);
+            sum.middle = _mm256_xor_si256(sum.middle, product.middle);
+            sum.high = _mm256_xor_si256(sum.high, product.high);
+        }
+        return reduce({fold(sum.low), fold(sum.middle), fold(sum.high)});
+    }
+
+    // The counter blocks of sixteen lanes, from `counter` on, with the first round key
+    // XORed in, and then encrypted in place
+    __attribute__((target("aes,pclmul,avx2,vaes,vpclmulqdq"))) inline void encryptWide(const __m128i *keys, int rounds,
+                                                                                       __m128i base, uint32_t counter,
+                                                                                       __m256i *blocks)
+    {
+        // Counters are added in native order and byte swapped into the last word of
+        // the nonce
+        const __m256i swap = _mm256_broadcastsi128_si256(
+            _mm_set_epi8(12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+        const __m256i nonce = _mm256_xor_si256(_mm256_broadcastsi128_si256(base),
+                                               _mm256_broadcastsi128_si256(_mm_load_si128(keys)));
+        const __m256i first = _mm256_set_epi32(static_cast<int>(counter + 1), 0, 0, 0, static_cast<int>(counter), 0,
+                                               0, 0);
+        for (size_t pair = 0; pair < kWideLanes / 2; ++pair)
+        {
+            __m256i counters = _mm256_add_epi32(first, _mm256_set1_epi32(static_cast<int>(2 * pair)));
+            blocks[pair] = _mm256_xor_si256(nonce, _mm256_shuffle_epi8(counters, swap));
+        }
+        for (int round = 1; round < rounds; ++round)
+        {
+            const __m256i key = _mm256_broadcastsi128_si256(_mm_load_si128(keys + round));
+            for (size_t pair = 0; pair < kWideLanes / 2; ++pair)
+            {
+                blocks[pair] = _mm256_aesenc_epi128(blocks[pair], key);
+            }
+        }
+        const __m256i last_key = _mm256_broadcastsi128_si256(_mm_load_si128(keys + rounds));
+        for (size_t pair = 0; pair < kWideLanes / 2; ++pair)
+        {
+            blocks[pair] = _mm256_aesenclast_epi128(blocks[pair], last_key);
+        }
+    }
+
+    // GCM (see gcmHardware()) or, without `state`, CTR mode over the whole groups of
+    // sixteen blocks of the data; returns the number of bytes done
+    __attribute__((target("aes,pclmul,avx2,vaes,vpclmulqdq"))) size_t cryptWide(const uint8_t *round_keys, int rounds,
+                                                                                const uint8_t *powers, __m128i base,
+                                                                                uint32_t counter, const uint8_t *in,
+                                                                                size_t size, uint8_t *out,
+                                                                                bool decrypting, __m128i *state)
+    {
+        const auto *keys = reinterpret_cast<const __m128i *>(round_keys);
+        size_t i = 0;
+        for (; i + kWideLanes * kAesBlockSize <= size; i += kWideLanes * kAesBlockSize, counter += kWideLanes)
+        {
+            __m256i blocks[kWideLanes / 2];
+            __m256i data[kWideLanes / 2];
+            for (size_t pair = 0; pair < kWideLanes / 2; ++pair)
+            {
+                data[pair] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i) + pair);
+            }
+            if (state && decrypting)
+            {
+                *state = absorbWide(powers, *state, data);
+            }
+            encryptWide(keys, rounds, base, counter, blocks);
+            for (size_t pair = 0; pair < kWideLanes / 2; ++pair)
+            {
+                data[pair] = _mm256_xor_si256(data[pair], blocks[pair]);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i) + pair, data[pair]);
+            }
+            if (state && !decrypting)
+            {
+                *state = absorbWide(powers, *state, data);
+            }
+        }
+        return i;
+    }
+
+    // CTR mode over the blocks that do not fill eight lanes
+    __attribute__((target("aes,pclmul,sse4.1"))) void ctrTail(const uint8_t *round_keys, int rounds, __m128i base,
+                                                              uint32_t counter, const uint8_t *in, size_t size,
+                                                              uint8_t *out)
+    {
+        for (size_t i = 0; i < size; i += kAesBlockSize)
+        {
+            __m128i block = _mm_insert_epi32(base, static_cast<int>(__builtin_bswap32(counter++)), 3);
+            block = encryptBlockHardware(round_keys, rounds, block);
+            size_t n = std::min(kAesBlockSize, size - i);
+            uint8_t buffer[kAesBlockSize] = {};
+            std::memcpy(buffer, in + i, n);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(buffer),
+                             _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(buffer)), block));
+            std::memcpy(out + i, buffer, n);
+        }
+    }
+
+    __attribute__((target("aes,pclmul,sse4.1"))) void ctrHardware(const uint8_t *round_keys, int rounds,
+                                                                  const uint8_t *nonce, uint32_t counter,
+                                                                  const uint8_t *in, size_t size, uint8_t *out)
+    {
+        const auto *keys = reinterpret_cast<const __m128i *>(round_keys);
+        const __m128i base = counterBase(nonce);
+        size_t i = 0;
+        if (cpuHasVaes())
+        {
+            i = cryptWide(round_keys, rounds, nullptr, base, counter, in, size, out, false, nullptr);
+            counter += static_cast<uint32_t>(i / kAesBlockSize);
+        }
+        for (; i + kLanes * kAesBlockSize <= size; i += kLanes * kAesBlockSize, counter += kLanes)
+        {
+            __m128i blocks[kLanes];
+            counterLanes(keys, base, counter, blocks);
+            encryptLanes(keys, rounds, blocks);
+            for (size_t lane = 0; lane < kLanes; ++lane)
+            {
+                const auto *source = reinterpret_cast<const __m128i *>(in + i) + lane;
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i) + lane,
+                                 _mm_xor_si128(_mm_loadu_si128(source), blocks[lane]));
+            }
+        }
+        ctrTail(round_keys, rounds, base, counter, in + i, size - i, out + i);
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) __m128i ghashHardware(const uint8_t *powers, __m128i state,
+                                                                   const uint8_t *data, size_t size)
+    {
+        const auto *blocks = reinterpret_cast<const __m128i *>(data);
+        size_t count = size / kAesBlockSize;
+        size_t i = 0;
+        for (; i + kLanes <= count; i += kLanes)
+        {
+            __m128i lanes[kLanes];
+            for (size_t lane = 0; lane < kLanes; ++lane)
+            {
+                lanes[lane] = _mm_loadu_si128(blocks + i + lane);
+            }
+            state = absorbLanes(powers, state, lanes);
+        }
+        for (; i < count; ++i)
+        {
+            state = absorb(powers, state, _mm_loadu_si128(blocks + i));
+        }
+        if (size % kAesBlockSize != 0)
+        {
+            uint8_t last[kAesBlockSize] = {};
+            std::memcpy(last, data + count * kAesBlockSize, size % kAesBlockSize);
+            state = absorb(powers, state, _mm_loadu_si128(reinterpret_cast<const __m128i *>(last)));
+        }
+        return state;
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) void finishGhash(const uint8_t *powers, __m128i state, size_t aad_size,
+                                                              size_t size, uint8_t *out)
+    {
+        uint8_t lengths[kAesBlockSize];
+        lengthBlock(aad_size, size, lengths);
+        state = absorb(powers, state, _mm_loadu_si128(reinterpret_cast<const __m128i *>(lengths)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out), byteReflect(state));
+    }
+
+    __attribute__((target("pclmul,sse4.1"))) void ghashHardware(const uint8_t *powers, const uint8_t *aad,
+                                                                size_t aad_size, const uint8_t *data, size_t size,
+                                                                uint8_t *out)
+    {
+        __m128i state = ghashHardware(powers, _mm_setzero_si128(), aad, aad_size);
+        state = ghashHardware(powers, state, data, size);
+        finishGhash(powers, state, aad_size, size, out);
+    }
+
+    // GCM in a single pass over the data, eight blocks at a time (sixteen with VAES). The GHASH of a group of
+    // blocks does not depend on the AES rounds of the same group (decrypting) or of the
+    // next one (encrypting), so the AES and the carry-less multiplications run side by
+    // side. Writes the GHASH of `aad` and of the ciphertext, which is `in` when decrypting
+    // and `out` when encrypting.
+    __attribute__((target("aes,pclmul,sse4.1"))) void gcmHardware(const uint8_t *round_keys, int rounds,
+                                                                  const uint8_t *powers, const uint8_t *nonce,
+                                                                  const uint8_t *aad, size_t aad_size,
+                                                                  const uint8_t *in, size_t size, uint8_t *out,
+                                                                  bool decrypting, uint8_t *hash)
+    {
+        const auto *keys = reinterpret_cast<const __m128i *>(round_keys);
+        const __m128i base = counterBase(nonce);
+        __m128i state = ghashHardware(powers, _mm_setzero_si128(), aad, aad_size);
+        // The first counter block masks the tag, the data starts at counter 2
+        uint32_t counter = 2;
+        size_t i = 0;
+        if (cpuHasVaes())
+        {
+            i = cryptWide(round_keys, rounds, powers, base, counter, in, size, out, decrypting, &state);
+            counter += static_cast<uint32_t>(i / kAesBlockSize);
+        }
+        for (; i + kLanes * kAesBlockSize <= size; i += kLanes * kAesBlockSize, counter += kLanes)
+        {
+            __m128i blocks[kLanes];
+            __m128i data[kLanes];
+            for (size_t lane = 0; lane < kLanes; ++lane)
+            {
+                data[lane] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i) + lane);
+            }
+            counterLanes(keys, base, counter, blocks);
+            if (decrypting)
+            {
+                state = absorbLanes(powers, state, data);
+            }
+            encryptLanes(keys, rounds, blocks);
+            for (size_t lane = 0; lane < kLanes; ++lane)
+            {
+                data[lane] = _mm_xor_si128(data[lane], blocks[lane]);
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i) + lane, data[lane]);
+            }
+            if (!decrypting)
+            {
+                state = absorbLanes(powers, state, data);
+            }
+        }
+        if (decrypting)
+        {
+            state = ghashHardware(powers, state, in + i, size - i);
+            ctrTail(round_keys, rounds, base, counter, in + i, size - i, out + i);
+        }
+        else
+        {
+            ctrTail(round_keys, rounds, base, counter, in + i, size - i, out + i);
+            state = ghashHardware(powers, state, out + i, size - i);
+        }
+        finishGhash(powers, state, aad_size, size, hash);
+    }
+#endif
+} // namespace
+
+AesGcm::AesGcm(const uint8_t *key, size_t key_size, bool use_hardware)
+{
+    if (key_size != 16 && key_size != 24 && key_size != 32)
+    {
+        throw std::invalid_argument("AES keys have 16, 24 or 32 bytes, not " + std::to_string(key_size));
+    }
+    auto key_words = static_cast<int>(key_size / 4);
+    rounds_ = key_words + 6;
+    hardware_ = use_hardware && cpuHasAesNi();
+
+    for (int i = 0; i < key_words; ++i)
+    {
+        words_[i] = loadBigEndian32(key + 4 * i);
+    }
+    uint8_t round_constant = 1;
+    for (int i = key_words; i < 4 * (rounds_ + 1); ++i)
+    {
+        uint32_t word = words_[i - 1];
+        if (i % key_words == 0)
+        {
+            word = subWord((word << 8) | (word >> 24)) ^ (uint32_t{round_constant} << 24);
+            round_constant = xtime(round_constant);
+        }
+        else if (key_words > 6 && i % key_words == 4)
+        {
+            word = subWord(word);
+        }
+        words_[i] = words_[i - key_words] ^ word;
+    }
+    for (int i = 0; i < 4 * (rounds_ + 1); ++i)
+    {
+        storeBigEndian32(round_keys_ + 4 * i, words_[i]);
+    }
+
+    // The hash key H = E(0), expanded into the multiples of the portable GHASH: entry i
+    // holds the product of H with the 4 bit polynomial i
+    uint8_t h[kAesBlockSize] = {};
+    encryptBlock(h, h);
+    uint64_t high = loadBigEndian64(h);
+    uint64_t low = loadBigEndian64(h + 8);
+    h_high_[0] = 0;
+    h_low_[0] = 0;
+    h_high_[8] = high;
+    h_low_[8] = low;
+    for (int i = 4; i > 0; i >>= 1)
+    {
+        uint64_t carry = (low & 1) * 0xE100000000000000;
+        low = (high << 63) | (low >> 1);
+        high = (high >> 1) ^ carry;
+        h_high_[i] = high;
+        h_low_[i] = low;
+    }
+    for (int i = 2; i <= 8; i *= 2)
+    {
+        for (int j = 1; j < i; ++j)
+        {
+            h_high_[i + j] = h_high_[i] ^ h_high_[j];
+            h_low_[i + j] = h_low_[i] ^ h_low_[j];
+        }
+    }
+#if defined(__x86_64__)
+    if (hardware_)
+    {
+        powersHardware(round_keys_, rounds_, h_powers_);
+    }
+#endif
+}
+
+void AesGcm::encryptBlock(const uint8_t *in, uint8_t *out) const
+{
+    uint32_t s0 = loadBigEndian32(in) ^ words_[0];
+    uint32_t s1 = loadBigEndian32(in + 4) ^ words_[1];
+    uint32_t s2 = loadBigEndian32(in + 8) ^ words_[2];
+    uint32_t s3 = loadBigEndian32(in + 12) ^ words_[3];
+    const uint32_t *key = words_ + 4;
+    for (int round = 1; round < rounds_; ++round, key += 4)
+    {
+        uint32_t t0 = kRoundTable[s0 >> 24] ^ rotr(kRoundTable[(s1 >> 16) & 0xFF], 8) ^
+                      rotr(kRoundTable[(s2 >> 8) & 0xFF], 16) ^ rotr(kRoundTable[s3 & 0xFF], 24) ^ key[0];
+        uint32_t t1 = kRoundTable[s1 >> 24] ^ rotr(kRoundTable[(s2 >> 16) & 0xFF], 8) ^
+                      rotr(kRoundTable[(s3 >> 8) & 0xFF], 16) ^ rotr(kRoundTable[s0 & 0xFF], 24) ^ key[1];
+        uint32_t t2 = kRoundTable[s2 >> 24] ^ rotr(kRoundTable[(s3 >> 16) & 0xFF], 8) ^
+                      rotr(kRoundTable[(s0 >> 8) & 0xFF], 16) ^ rotr(kRoundTable[s1 & 0xFF], 24) ^ key[2];
+        uint32_t t3 = kRoundTable[s3 >> 24] ^ rotr(kRoundTable[(s0 >> 16) & 0xFF], 8) ^
+                      rotr(kRoundTable[(s1 >> 8) & 0xFF], 16) ^ rotr(kRoundTable[s2 & 0xFF], 24) ^ key[3];
+        s0 = t0;
+        s1 = t1;
+        s2 = t2;
+        s3 = t3;
+    }
+    // The last round has no MixColumns
+    const uint32_t state[4] = {s0, s1, s2, s3};
+    for (int column = 0; column < 4; ++column)
+    {
+        uint32_t word = (uint32_t{kSbox[state[column] >> 24]} << 24) |
+                        (uint32_t{kSbox[(state[(column + 1) % 4] >> 16) & 0xFF]} << 16) |
+                        (uint32_t{kSbox[(state[(column + 2) % 4] >> 8) & 0xFF]} << 8) |
+                        uint32_t{kSbox[state[(column + 3) % 4] & 0xFF]};
+        storeBigEndian32(out + 4 * column, word ^ key[column]);
+    }
+}
+
+void AesGcm::ctr(const uint8_t *nonce, uint32_t counter, const uint8_t *in, size_t size, uint8_t *out) const
+{
+#if defined(__x86_64__)
+    if (hardware_)
+    {
+        ctrHardware(round_keys_, rounds_, nonce, counter, in, size, out);
+        return;
+    }
+#endif
+    uint8_t block[kAesBlockSize];
+    uint8_t stream[kAesBlockSize];
+    std::memcpy(block, nonce, kGcmNonceSize);
+    for (size_t i = 0; i < size; i += kAesBlockSize)
+    {
+        storeBigEndian32(block + kGcmNonceSize, counter++);
+        encryptBlock(block, stream);
+        size_t n = std::min(kAesBlockSize, size - i);
+        for (size_t j = 0; j < n; ++j)
+        {
+            out[i + j] = in[i + j] ^ stream[j];
+        }
+    }
+}
+
+void AesGcm::ghash(const uint8_t *aad, size_t aad_size, const uint8_t *data, size_t size, uint8_t *out) const
+{
+#if defined(__x86_64__)
+    if (hardware_)
+    {
+        ghashHardware(h_powers_, aad, aad_size, data, size, out);
+        return;
+    }
+#endif
+    uint64_t state_high = 0;
+    uint64_t state_low = 0;
+    auto absorb = [&](const uint8_t *block)
+    {
+        uint8_t x[kAesBlockSize];
+        storeBigEndian64(x, state_high ^ loadBigEndian64(block));
+        storeBigEndian64(x + 8, state_low ^ loadBigEndian64(block + 8));
+
+        // Multiply by H four bits at a time, from the last byte to the first (the shifts
+        // of the first step only move zeros)
+        uint64_t high = 0;
+        uint64_t low = 0;
+        for (int i = kAesBlockSize - 1; i >= 0; --i)
+        {
+            for (int nibble : {x[i] & 0xF, x[i] >> 4})
+            {
+                uint64_t rest = low & 0xF;
+                low = (high << 60) | (low >> 4);
+                high = (high >> 4) ^ (kGhashReduction[rest] << 48);
+                high ^= h_high_[nibble];
+                low ^= h_low_[nibble];
+            }
+        }
+        state_high = high;
+        state_low = low;
+    };
+    auto absorbAll = [&](const uint8_t *bytes, size_t n)
+    {
+        size_t i = 0;
+        for (; i + kAesBlockSize <= n; i += kAesBlockSize)
+        {
+            absorb(bytes + i);
+        }
+        if (i < n)
+        {
+            uint8_t last[kAesBlockSize] = {};
+            std::memcpy(last, bytes + i, n - i);
+            absorb(last);
+        }
+    };
+    uint8_t lengths[kAesBlockSize];
+    lengthBlock(aad_size, size, lengths);
+    absorbAll(aad, aad_size);
+    absorbAll(data, size);
+    absorb(lengths);
+    storeBigEndian64(out, state_high);
+    storeBigEndian64(out + 8, state_low);
+}
+
+void AesGcm::encrypt(const uint8_t *nonce, const uint8_t *aad, size_t aad_size, const uint8_t *in, size_t size,
+                     uint8_t *out, uint8_t *tag) const
+{
+    uint8_t hash[kAesBlockSize];
+#if defined(__x86_64__)
+    if (hardware_)
+    {
+        gcmHardware(round_keys_, rounds_, h_powers_, nonce, aad, aad_size, in, size, out, false, hash);
+        ctr(nonce, 1, hash, kGcmTagSize, tag);
+        return;
+    }
+#endif
+    // The first counter block (counter 1) masks the tag, the data starts at counter 2
+    ctr(nonce, 2, in, size, out);
+    ghash(aad, aad_size, out, size, hash);
+    ctr(nonce, 1, hash, kGcmTagSize, tag);
+}
+
+bool AesGcm::decrypt(const uint8_t *nonce, const uint8_t *aad, size_t aad_size, const uint8_t *in, size_t size,
+                     uint8_t *out, const uint8_t *tag) const
+{
+    uint8_t hash[kAesBlockSize];
+    uint8_t expected[kGcmTagSize];
+    bool decrypted = false;
+#if defined(__x86_64__)
+    if (hardware_)
+    {
+        // Decrypting as the ciphertext is hashed saves a pass over the data; the plaintext
+        // is taken back below if the tag does not match
+        gcmHardware(round_keys_, rounds_, h_powers_, nonce, aad, aad_size, in, size, out, true, hash);
+        decrypted = true;
+    }
+#endif
+    if (!decrypted)
+    {
+        ghash(aad, aad_size, in, size, hash);
+    }
+    ctr(nonce, 1, hash, kGcmTagSize, expected);
+    uint8_t difference = 0;
+    for (size_t i = 0; i < kGcmTagSize; ++i)
+    {
+        difference |= static_cast<uint8_t>(expected[i] ^ tag[i]);
+    }
+    if (difference != 0)
+    {
+        if (out == in && decrypted)
+        {
+            ctr(nonce, 2, out, size, out);
+        }
+        else if (out != in && size > 0)
+        {
+            std::memset(out, 0, size);
+        }
+        return false;
+    }
+    if (!decrypted)
+    {
+        ctr(nonce, 2, in, size, out);
+    }
+    return true;
+}
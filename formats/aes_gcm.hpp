@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+constexpr size_t kAesBlockSize = 16;
+constexpr size_t kGcmNonceSize = 12;
+constexpr size_t kGcmTagSize = 16;
+
+/**
+ * @brief AES (FIPS 197) in GCM (NIST SP 800-38D) and CTR mode, for 128, 192 and 256 bit
+ * keys and 12 byte nonces.
+ *
+ * Runs on AES-NI and PCLMULQDQ when the CPU has them, checked once at run time, with
+ * VAES and VPCLMULQDQ (two blocks per instruction) for the bulk of the data when it has
+ * those too, and on a portable table based implementation otherwise. The portable code
+ * is not constant time: its table lookups depend on the key and the data.
+ *
+ * An AesGcm holds nothing but the expanded key, so one instance can be used by any number
+ * of threads at once.
+ */
+class AesGcm
+{
+public:
+    /**
+     * @param use_hardware Whether AES-NI may be used; false forces the portable code
+     * @throws std::invalid_argument unless the key has 16, 24 or 32 bytes
+     */
+    AesGcm(const uint8_t *key, size_t key_size, bool use_hardware = true);
+
+    bool hardwareAccelerated() const noexcept { return hardware_; }
+
+    /**
+     * @brief Encrypts `size` bytes from `in` to `out`, which may be the same buffer, and
+     * writes the authentication tag of the ciphertext and `aad`.
+     */
+    void encrypt(const uint8_t *nonce, const uint8_t *aad, size_t aad_size, const uint8_t *in, size_t size,
+                 uint8_t *out, uint8_t *tag) const;
+
+    /**
+     * @brief Decrypts `size` bytes from `in` to `out`, which may be the same buffer, and
+     * checks the tag.
+     * @return false if the tag does not match, in which case `out` holds no plaintext: it
+     * is zero filled, or holds the ciphertext again when it is `in`
+     */
+    bool decrypt(const uint8_t *nonce, const uint8_t *aad, size_t aad_size, const uint8_t *in, size_t size,
+                 uint8_t *out, const uint8_t *tag) const;
+
+    /**
+     * @brief CTR mode without authentication: XORs `in` with the key stream of the
+     * counter blocks `nonce || counter`, `nonce || counter + 1`, ... (big endian counter).
+     */
+    void ctr(const uint8_t *nonce, uint32_t counter, const uint8_t *in, size_t size, uint8_t *out) const;
+
+private:
+    void encryptBlock(const uint8_t *in, uint8_t *out) const;
+    void ghash(const uint8_t *aad, size_t aad_size, const uint8_t *data, size_t size, uint8_t *out) const;
+
+    int rounds_;
+    bool hardware_;
+
+    /// Round keys as big endian words for the portable code, and as bytes for AES-NI
+    uint32_t words_[60];
+    alignas(16) uint8_t round_keys_[15 * kAesBlockSize];
+
+    /// Multiples of the hash key H for the portable GHASH (4 bit tables), and H^16 down to
+    /// H in the byte reflected form the carry-less multiplication works on, followed by the
+    /// XOR of the two halves of each
+    uint64_t h_high_[16];
+    uint64_t h_low_[16];
+    alignas(16) uint8_t h_powers_[32 * kAesBlockSize];
+};
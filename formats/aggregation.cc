@@ -0,0 +1,659 @@
+#include "aggregation.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "bit_util.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    // Rows whose groups are looked up before the accumulators are updated
+    constexpr size_t kBlockRows = 1024;
+
+    template <typename T>
+    constexpr AtomicType parquetType()
+    {
+        if constexpr (std::is_same_v<T, int32_t>)
+        {
+            return AtomicType::INT32;
+        }
+        else if constexpr (std::is_same_v<T, int64_t>)
+        {
+            return AtomicType::INT64;
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            return AtomicType::FLOAT;
+        }
+        else
+        {
+            return AtomicType::DOUBLE;
+        }
+    }
+
+    template <typename T>
+    void checkValueType(const ColumnBatch &batch)
+    {
+        if (batch.type() != parquetType<T>())
+        {
+            throw std::invalid_argument("Aggregating a batch of type " +
+                                        std::to_string(static_cast<int>(batch.type())) + " as type " +
+                                        std::to_string(static_cast<int>(parquetType<T>())));
+        }
+    }
+
+    // Integer sums wrap around instead of overflowing
+    template <typename Sum>
+    Sum addSums(Sum a, Sum b) noexcept
+    {
+        if constexpr (std::is_integral_v<Sum>)
+        {
+            return static_cast<Sum>(static_cast<uint64_t>(a) + static_cast<uint64_t>(b));
+        }
+        else
+        {
+            return a + b;
+        }
+    }
+
+    template <typename T>
+    void addValue(Aggregate<T> &into, T value) noexcept
+    {
+        ++into.count;
+        into.sum = addSums<typename Aggregate<T>::Sum>(into.sum, value);
+        // Comparisons with NaN are false, so NaN never becomes the minimum or maximum
+        into.min = value < into.min ? value : into.min;
+        into.max = value > into.max ? value : into.max;
+    }
+
+    // Adds `value` `count` times
+    template <typename T>
+    void addValue(Aggregate<T> &into, T value, uint32_t count) noexcept
+    {
+        using Sum = typename Aggregate<T>::Sum;
+        into.count += count;
+        if constexpr (std::is_integral_v<Sum>)
+        {
+            into.sum = addSums<Sum>(into.sum, static_cast<Sum>(static_cast<uint64_t>(value) * count));
+        }
+        else
+        {
+            into.sum += static_cast<Sum>(value) * count;
+        }
+        into.min = value < into.min ? value : into.min;
+        into.max = value > into.max ? value : into.max;
+    }
+
+    template <typename T>
+    void reduceScalar(const T *values, const uint8_t *validity, size_t first, size_t end, Aggregate<T> &into)
+    {
+        for (size_t i = first; i < end; ++i)
+        {
+            if (validity == nullptr || bit_util::getBit(validity, i))
+            {
+                addValue(into, values[i]);
+            }
+        }
+    }
+
+    // The bytes of the value in slot i of a plain batch
+    std::string_view valueBytes(const ColumnBatch &batch, size_t i) noexcept
+    {
+        if (batch.type() == AtomicType::BYTE_ARRAY)
+        {
+            return batch.byteArray(i);
+        }
+        size_t width = batch.valueWidth();
+        return {reinterpret_cast<const char *>(batch.values<uint8_t>() + i * width), width};
+    }
+
+    template <typename T>
+    struct PlainValues
+    {
+        const T *values;
+
+        T operator[](size_t i) const noexcept { return values[i]; }
+    };
+
+    template <typename T>
+    struct NullValues
+    {
+        T operator[](size_t) const noexcept { return T{0}; }
+    };
+
+    template <typename T>
+    struct DictionaryValues
+    {
+        const T *dictionary;
+        const int32_t *indices;
+
+        T operator[](size_t i) const noexcept { return dictionary[indices[i]]; }
+    };
+
+#if defined(__x86_64__)
+    bool cpuHasAvx2()
+    {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    // The AVX2 kernels reduce blocks of eight values, the values of one validity byte.
+    // With nulls, the null lanes are replaced by the identity of every reduction (zero for
+    // SUM, the largest value for MIN...) before they are folded in, so the loop has no
+    // branches. The accumulators are folded into `into` once at the end. min_ps/pd and
+    // max_ps/pd return their second operand when either one is NaN; passing the
+    // accumulator second skips NaN lanes like the scalar code does.
+
+    template <bool kNullable>
+    __attribute__((target("avx2"))) void reduceAvx2(const int32_t *values, const uint8_t *validity, size_t blocks,
+                                                    Aggregate<int32_t> &into)
+    {
+        const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256i min_identity = _mm256_set1_epi32(Aggregate<int32_t>::kMinIdentity);
+        const __m256i max_identity = _mm256_set1_epi32(Aggregate<int32_t>::kMaxIdentity);
+        __m256i sum_low = _mm256_setzero_si256();
+        __m256i sum_high = _mm256_setzero_si256();
+        __m256i min = min_identity;
+        __m256i max = max_identity;
+        int64_t count = 0;
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + block * 8));
+            __m256i v_min = v;
+            __m256i v_max = v;
+            if constexpr (kNullable)
+            {
+                __m256i bits = _mm256_and_si256(_mm256_set1_epi32(validity[block]), lane_bits);
+                __m256i mask = _mm256_cmpeq_epi32(bits, lane_bits);
+                count += std::popcount(validity[block]);
+                v_min = _mm256_blendv_epi8(min_identity, v, mask);
+                v_max = _mm256_blendv_epi8(max_identity, v, mask);
+                v = _mm256_and_si256(v, mask);
+            }
+            min = _mm256_min_epi32(min, v_min);
+            max = _mm256_max_epi32(max, v_max);
+            sum_low = _mm256_add_epi64(sum_low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+            sum_high = _mm256_add_epi64(sum_high, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+        }
+        alignas(32) int64_t sums[4];
+        alignas(32) int32_t mins[8];
+        alignas(32) int32_t maxs[8];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(sums), _mm256_add_epi64(sum_low, sum_high));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(mins), min);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(maxs), max);
+        into.count += kNullable ? count : static_cast<int64_t>(blocks * 8);
+        for (int64_t sum : sums)
+        {
+            into.sum = addSums(into.sum, sum);
+        }
+        into.min = std::min(into.min, *std::min_element(mins, mins + 8));
+        into.max = std::max(into.max, *std::max_element(maxs, maxs + 8));
+    }
+
+    template <bool kNullable>
+    __attribute__((target("avx2"))) void reduceAvx2(const int64_t *values, const uint8_t *validity, size_t blocks,
+                                                    Aggregate<int64_t> &into)
+    {
+        const __m256i lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+        const __m256i min_identity = _mm256_set1_epi64x(Aggregate<int64_t>::kMinIdentity);
+        const __m256i max_identity = _mm256_set1_epi64x(Aggregate<int64_t>::kMaxIdentity);
+        // One set of accumulators per half block, for two independent dependency chains
+        __m256i sum[2] = {_mm256_setzero_si256(), _mm256_setzero_si256()};
+        __m256i min[2] = {min_identity, min_identity};
+        __m256i max[2] = {max_identity, max_identity};
+        int64_t count = 0;
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            if constexpr (kNullable)
+            {
+                count += std::popcount(validity[block]);
+            }
+            for (int half = 0; half < 2; ++half)
+            {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(values + block * 8 + half * 4));
+                __m256i v_min = v;
+                __m256i v_max = v;
+                if constexpr (kNullable)
+                {
+                    __m256i bits = _mm256_and_si256(_mm256_set1_epi64x(validity[block] >> (half * 4)), lane_bits);
+                    __m256i mask = _mm256_cmpeq_epi64(bits, lane_bits);
+                    v_min = _mm256_blendv_epi8(min_identity, v, mask);
+                    v_max = _mm256_blendv_epi8(max_identity, v, mask);
+                    v = _mm256_and_si256(v, mask);
+                }
+                sum[half] = _mm256_add_epi64(sum[half], v);
+                min[half] = _mm256_blendv_epi8(min[half], v_min, _mm256_cmpgt_epi64(min[half], v_min));
+                max[half] = _mm256_blendv_epi8(max[half], v_max, _mm256_cmpgt_epi64(v_max, max[half]));
+            }
+        }
+        alignas(32) int64_t lanes[3][8];
+        for (int half = 0; half < 2; ++half)
+        {
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes[0] + half * 4), sum[half]);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes[1] + half * 4), min[half]);
+            _mm256_store_si256(reinterpret_cast<__m256i *>(lanes[2] + half * 4), max[half]);
+        }
+        into.count += kNullable ? count : static_cast<int64_t>(blocks * 8);
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            into.sum = addSums(into.sum, lanes[0][lane]);
+            into.min = std::min(into.min, lanes[1][lane]);
+            into.max = std::max(into.max, lanes[2][lane]);
+        }
+    }
+
+    template <bool kNullable>
+    __attribute__((target("avx2"))) void reduceAvx2(const float *values, const uint8_t *validity, size_t blocks,
+                                                    Aggregate<float> &into)
+    {
+        const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        const __m256 min_identity = _mm256_set1_ps(Aggregate<float>::kMinIdentity);
+        const __m256 max_identity = _mm256_set1_ps(Aggregate<float>::kMaxIdentity);
+        __m256d sum_low = _mm256_setzero_pd();
+        __m256d sum_high = _mm256_setzero_pd();
+        __m256 min = min_identity;
+        __m256 max = max_identity;
+        int64_t count = 0;
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            __m256 v = _mm256_loadu_ps(values + block * 8);
+            __m256 v_min = v;
+            __m256 v_max = v;
+            if constexpr (kNullable)
+            {
+                __m256i bits = _mm256_and_si256(_mm256_set1_epi32(validity[block]), lane_bits);
+                __m256 mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(bits, lane_bits));
+                count += std::popcount(validity[block]);
+                v_min = _mm256_blendv_ps(min_identity, v, mask);
+                v_max = _mm256_blendv_ps(max_identity, v, mask);
+                v = _mm256_and_ps(v, mask);
+            }
+            min = _mm256_min_ps(v_min, min);
+            max = _mm256_max_ps(v_max, max);
+            sum_low = _mm256_add_pd(sum_low, _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+            sum_high = _mm256_add_pd(sum_high, _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+        }
+        alignas(32) double sums[4];
+        alignas(32) float mins[8];
+        alignas(32) float maxs[8];
+        _mm256_store_pd(sums, _mm256_add_pd(sum_low, sum_high));
+        _mm256_store_ps(mins, min);
+        _mm256_store_ps(maxs, max);
+        into.count += kNullable ? count : static_cast<int64_t>(blocks * 8);
+        into.sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        into.min = std::min(into.min, *std::min_element(mins, mins + 8));
+        into.max = std::max(into.max, *std::max_element(maxs, maxs + 8));
+    }
+
+    template <bool kNullable>
+    __attribute__((target("avx2"))) void reduceAvx2(const double *values, const uint8_t *validity, size_t blocks,
+                                                    Aggregate<double> &into)
+    {
+        const __m256i lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+        const __m256d min_identity = _mm256_set1_pd(Aggregate<double>::kMinIdentity);
+        const __m256d max_identity = _mm256_set1_pd(Aggregate<double>::kMaxIdentity);
+        __m256d sum[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+        __m256d min[2] = {min_identity, min_identity};
+        __m256d max[2] = {max_identity, max_identity};
+        int64_t count = 0;
+        for (size_t block = 0; block < blocks; ++block)
+        {
+            if constexpr (kNullable)
+            {
+                count += std::popcount(validity[block]);
+            }
+            for (int half = 0; half < 2; ++half)
+            {
+                __m256d v = _mm256_loadu_pd(values + block * 8 + half * 4);
+                __m256d v_min = v;
+                __m256d v_max = v;
+                if constexpr (kNullable)
+                {
+                    __m256i bits = _mm256_and_si256(_mm256_set1_epi64x(validity[block] >> (half * 4)), lane_bits);
+                    __m256d mask = _mm256_castsi256_pd(_mm256_cmpeq_epi64(bits, lane_bits));
+                    v_min = _mm256_blendv_pd(min_identity, v, mask);
+                    v_max = _mm256_blendv_pd(max_identity, v, mask);
+                    v = _mm256_and_pd(v, mask);
+                }
+                sum[half] = _mm256_add_pd(sum[half], v);
+                min[half] = _mm256_min_pd(v_min, min[half]);
+                max[half] = _mm256_max_pd(v_max, max[half]);
+            }
+        }
+        alignas(32) double lanes[3][8];
+        for (int half = 0; half < 2; ++half)
+        {
+            _mm256_store_pd(lanes[0] + half * 4, sum[half]);
+            _mm256_store_pd(lanes[1] + half * 4, min[half]);
+            _mm256_store_pd(lanes[2] + half * 4, max[half]);
+        }
+        into.count += kNullable ? count : static_cast<int64_t>(blocks * 8);
+        double total = 0;
+        for (int lane = 0; lane < 8; ++lane)
+        {
+            total += lanes[0][lane];
+            into.min = std::min(into.min, lanes[1][lane]);
+            into.max = std::max(into.max, lanes[2][lane]);
+        }
+        into.sum += total;
+    }
+#endif
+
+    template <typename T>
+    void reducePlain(const ColumnBatch &batch, Aggregate<T> &into, bool use_simd)
+    {
+        const T *values = batch.values<T>();
+        const uint8_t *validity = batch.nullCount() > 0 ? batch.validity() : nullptr;
+        size_t first = 0;
+#if defined(__x86_64__)
+        if (use_simd && cpuHasAvx2())
+        {
+            size_t blocks = batch.length() / 8;
+            if (validity != nullptr)
+            {
+                reduceAvx2<true>(values, validity, blocks, into);
+            }
+            else
+            {
+                reduceAvx2<false>(values, validity, blocks, into);
+            }
+            first = blocks * 8;
+        }
+#else
+        (void)use_simd;
+#endif
+        reduceScalar(values, validity, first, batch.length(), into);
+    }
+
+    template <typename T>
+    void reduceDictionary(const ColumnBatch &batch, Aggregate<T> &into)
+    {
+        const ColumnBatch &dictionary = *batch.dictionary();
+        const T *entries = dictionary.values<T>();
+        const int32_t *indices = batch.indices();
+        const uint8_t *validity = batch.nullCount() > 0 ? batch.validity() : nullptr;
+        if (dictionary.length() > batch.length())
+        {
+            // Counting would touch more entries than the batch has rows
+            for (size_t i = 0; i < batch.length(); ++i)
+            {
+                if (validity == nullptr || bit_util::getBit(validity, i))
+                {
+                    addValue(into, entries[indices[i]]);
+                }
+            }
+            return;
+        }
+        std::vector<uint32_t> counts(dictionary.length());
+        for (size_t i = 0; i < batch.length(); ++i)
+        {
+            if (validity == nullptr || bit_util::getBit(validity, i))
+            {
+                ++counts[static_cast<size_t>(indices[i])];
+            }
+        }
+        for (size_t entry = 0; entry < counts.size(); ++entry)
+        {
+            if (counts[entry] > 0)
+            {
+                addValue(into, entries[entry], counts[entry]);
+            }
+        }
+    }
+} // namespace
+
+template <typename T>
+void Aggregate<T>::merge(const Aggregate &other) noexcept
+{
+    count += other.count;
+    sum = addSums(sum, other.sum);
+    min = other.min < min ? other.min : min;
+    max = other.max > max ? other.max : max;
+}
+
+template <typename T>
+void aggregate(const ColumnBatch &batch, Aggregate<T> &into, bool use_simd)
+{
+    checkValueType<T>(batch);
+    if (batch.nullCount() == batch.length())
+    {
+        return;
+    }
+    if (batch.isDictionaryEncoded())
+    {
+        reduceDictionary(batch, into);
+    }
+    else
+    {
+        reducePlain(batch, into, use_simd);
+    }
+}
+
+template <typename T>
+GroupByAggregator<T>::GroupByAggregator(AtomicType key_type, int32_t key_type_length)
+    : keys_(key_type, key_type_length)
+{
+}
+
+template <typename T>
+void GroupByAggregator<T>::add(const ColumnBatch &keys, const ColumnBatch &values)
+{
+    if (keys.length() != values.length())
+    {
+        throw std::invalid_argument("Grouping " + std::to_string(values.length()) + " values by " +
+                                    std::to_string(keys.length()) + " keys");
+    }
+    if (keys.type() != keys_.type() || keys.typeLength() != keys_.typeLength())
+    {
+        throw std::invalid_argument("Grouping by keys of another type than the aggregator's");
+    }
+    checkValueType<T>(values);
+    if (keys.isDictionaryEncoded() && keys.dictionary() != dictionary_)
+    {
+        mapDictionary(keys.dictionary());
+    }
+    const uint8_t *key_validity = keys.nullCount() > 0 ? keys.validity() : nullptr;
+    const uint8_t *value_validity = values.nullCount() > 0 ? values.validity() : nullptr;
+    row_groups_.resize(kBlockRows);
+    uint32_t *groups = row_groups_.data();
+    for (size_t first = 0; first < keys.length(); first += kBlockRows)
+    {
+        size_t count = std::min(kBlockRows, keys.length() - first);
+        if (keys.isDictionaryEncoded() && key_validity == nullptr)
+        {
+            const int32_t *indices = keys.indices() + first;
+            for (size_t i = 0; i < count; ++i)
+            {
+                groups[i] = dictionary_groups_[static_cast<size_t>(indices[i])];
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (key_validity != nullptr && !bit_util::getBit(key_validity, first + i))
+                {
+                    groups[i] = nullGroup();
+                }
+                else if (keys.isDictionaryEncoded())
+                {
+                    groups[i] = dictionary_groups_[static_cast<size_t>(keys.indices()[first + i])];
+                }
+                else
+                {
+                    groups[i] = group(valueBytes(keys, first + i));
+                }
+            }
+        }
+        if (values.nullCount() == values.length())
+        {
+            // Also covers dictionary encoded values with an empty dictionary
+            update(groups, NullValues<T>{}, value_validity, first, count);
+        }
+        else if (values.isDictionaryEncoded())
+        {
+            update(groups, DictionaryValues<T>{values.dictionary()->values<T>(), values.indices()}, value_validity,
+                   first, count);
+        }
+        else
+        {
+            update(groups, PlainValues<T>{values.values<T>()}, value_validity, first, count);
+        }
+    }
+}
+
+template <typename T>
+template <typename Values>
+void GroupByAggregator<T>::update(const uint32_t *groups, const Values &values, const uint8_t *validity,
+                                  size_t first, size_t count)
+{
+    Accumulator *accumulators = groups_.data();
+    if (validity == nullptr)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            Accumulator &accumulator = accumulators[groups[i] * kStripes + i % kStripes];
+            T value = values[first + i];
+            ++accumulator.rows;
+            ++accumulator.values;
+            accumulator.sum = addSums<Sum>(accumulator.sum, value);
+            accumulator.min = value < accumulator.min ? value : accumulator.min;
+            accumulator.max = value > accumulator.max ? value : accumulator.max;
+        }
+        return;
+    }
+    // Null values go to an accumulator that is thrown away, which selects an address
+    // instead of taking a branch the predictor misses on every other null
+    Accumulator discarded;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Accumulator &accumulator = accumulators[groups[i] * kStripes + i % kStripes];
+        ++accumulator.rows;
+        Accumulator &target = bit_util::getBit(validity, first + i) ? accumulator : discarded;
+        T value = values[first + i];
+        ++target.values;
+        target.sum = addSums<Sum>(target.sum, value);
+        target.min = value < target.min ? value : target.min;
+        target.max = value > target.max ? value : target.max;
+    }
+}
+
+template <typename T>
+void GroupByAggregator<T>::combine(Accumulator &into, const Accumulator &other) noexcept
+{
+    into.rows += other.rows;
+    into.values += other.values;
+    into.sum = addSums(into.sum, other.sum);
+    into.min = other.min < into.min ? other.min : into.min;
+    into.max = other.max > into.max ? other.max : into.max;
+}
+
+template <typename T>
+typename GroupByAggregator<T>::Accumulator GroupByAggregator<T>::combined(size_t group) const noexcept
+{
+    Accumulator result;
+    for (size_t stripe = 0; stripe < kStripes; ++stripe)
+    {
+        combine(result, groups_[group * kStripes + stripe]);
+    }
+    return result;
+}
+
+template <typename T>
+void GroupByAggregator<T>::merge(const GroupByAggregator &other)
+{
+    if (other.keys_.type() != keys_.type() || other.keys_.typeLength() != keys_.typeLength())
+    {
+        throw std::invalid_argument("Merging aggregators grouping by different key types");
+    }
+    for (size_t g = 0; g < other.numGroups(); ++g)
+    {
+        uint32_t mine = other.keys_.isValid(g) ? group(valueBytes(other.keys_, g)) : nullGroup();
+        combine(groups_[mine * kStripes], other.combined(g));
+    }
+}
+
+template <typename T>
+int64_t GroupByAggregator<T>::rows(size_t group) const noexcept
+{
+    return combined(group).rows;
+}
+
+template <typename T>
+Aggregate<T> GroupByAggregator<T>::aggregate(size_t group) const noexcept
+{
+    Accumulator accumulator = combined(group);
+    Aggregate<T> result;
+    result.count = accumulator.values;
+    result.sum = accumulator.sum;
+    result.min = accumulator.min;
+    result.max = accumulator.max;
+    return result;
+}
+
+template <typename T>
+uint32_t GroupByAggregator<T>::group(std::string_view key)
+{
+    auto it = key_groups_.find(key);
+    if (it != key_groups_.end())
+    {
+        return it->second;
+    }
+    auto id = static_cast<uint32_t>(numGroups());
+    key_groups_.tryEmplace(std::string(key), id);
+    if (keys_.type() == AtomicType::BYTE_ARRAY)
+    {
+        keys_.appendByteArray(reinterpret_cast<const uint8_t *>(key.data()), key.size());
+    }
+    else
+    {
+        std::memcpy(keys_.appendValues<uint8_t>(1), key.data(), key.size());
+    }
+    groups_.resize(groups_.size() + kStripes);
+    return id;
+}
+
+template <typename T>
+uint32_t GroupByAggregator<T>::nullGroup()
+{
+    if (!null_group_)
+    {
+        null_group_ = static_cast<uint32_t>(numGroups());
+        keys_.appendNulls(1);
+        groups_.resize(groups_.size() + kStripes);
+    }
+    return *null_group_;
+}
+
+template <typename T>
+void GroupByAggregator<T>::mapDictionary(const std::shared_ptr<const ColumnBatch> &dictionary)
+{
+    dictionary_ = dictionary;
+    dictionary_groups_.resize(dictionary->length());
+    for (size_t entry = 0; entry < dictionary->length(); ++entry)
+    {
+        dictionary_groups_[entry] = group(valueBytes(*dictionary, entry));
+    }
+}
+
+template struct Aggregate<int32_t>;
+template struct Aggregate<int64_t>;
+template struct Aggregate<float>;
+template struct Aggregate<double>;
+
+template void aggregate<int32_t>(const ColumnBatch &, Aggregate<int32_t> &, bool);
+template void aggregate<int64_t>(const ColumnBatch &, Aggregate<int64_t> &, bool);
+template void aggregate<float>(const ColumnBatch &, Aggregate<float> &, bool);
+template void aggregate<double>(const ColumnBatch &, Aggregate<double> &, bool);
+
+template class GroupByAggregator<int32_t>;
+template class GroupByAggregator<int64_t>;
+template class GroupByAggregator<float>;
+template class GroupByAggregator<double>;
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "basics/flat_hash_map.h"
+#include "column_batch.hpp"
+
+/**
+ * @brief COUNT, SUM, MIN and MAX of the non-null values of an INT32, INT64, FLOAT or
+ * DOUBLE column, with T = int32_t, int64_t, float or double.
+ *
+ * Integer sums are int64_t and wrap around on overflow; floating point sums are double.
+ * MIN and MAX skip NaN values, as Parquet statistics do, while SUM propagates them. Until
+ * a value is added min and max hold the identities of MIN and MAX (the largest and the
+ * lowest T, infinities for floating point).
+ */
+template <typename T>
+struct Aggregate
+{
+    static_assert(std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t> || std::is_same_v<T, float> ||
+                  std::is_same_v<T, double>);
+
+    using Sum = std::conditional_t<std::is_floating_point_v<T>, double, int64_t>;
+
+    static constexpr T kMinIdentity =
+        std::is_floating_point_v<T> ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    static constexpr T kMaxIdentity =
+        std::is_floating_point_v<T> ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+
+    /// Non-null values
+    int64_t count = 0;
+    Sum sum = 0;
+    T min = kMinIdentity;
+    T max = kMaxIdentity;
+
+    void merge(const Aggregate &other) noexcept;
+};
+
+/**
+ * @brief Adds the non-null values of `batch` to `into`.
+ *
+ * Plain batches are reduced eight values (one validity byte) at a time with AVX2 when the
+ * CPU has it and `use_simd` is set, and value by value otherwise. Dictionary encoded
+ * batches (see ColumnChunkReader::keepDictionaryIndices()) are reduced on their indices:
+ * the kernel counts how often each dictionary entry occurs and aggregates every entry
+ * once, weighted by its count. Floating point sums may therefore round differently
+ * depending on the path.
+ *
+ * @throws std::invalid_argument if the type of `batch` is not the Parquet type of T
+ */
+template <typename T>
+void aggregate(const ColumnBatch &batch, Aggregate<T> &into, bool use_simd = true);
+
+/**
+ * @brief SUM, MIN, MAX and COUNT of an INT32, INT64, FLOAT or DOUBLE value column grouped
+ * by a key column of any type, meant for keys of low cardinality.
+ *
+ * Groups get dense ids in the order their keys are first seen; all null keys form one
+ * group. The accumulators of the groups sit in a vector indexed by group id. Dictionary
+ * encoded key batches are grouped on their indices: the first batch of every dictionary
+ * maps the dictionary entries to group ids, after which a row costs a lookup in that
+ * mapping and the update of its group's accumulator. Plain key batches (e.g. from chunks
+ * whose writer fell back to PLAIN pages) hash the key of every row instead. Value batches
+ * may be plain or dictionary encoded.
+ *
+ * An aggregator is not thread safe. To aggregate on several threads, give every thread
+ * its own aggregator and merge() them at the end; the group ids of the merged aggregator
+ * follow the order its keys were first seen in.
+ */
+template <typename T>
+class GroupByAggregator
+{
+public:
+    explicit GroupByAggregator(AtomicType key_type, int32_t key_type_length = 0);
+
+    /**
+     * @brief Adds the rows of `keys` and `values`, which hold the same rows.
+     * @throws std::invalid_argument if the batches differ in length or in type from the
+     * aggregator
+     */
+    void add(const ColumnBatch &keys, const ColumnBatch &values);
+
+    /**
+     * @brief Adds the groups of `other` to this aggregator.
+     * @throws std::invalid_argument if `other` groups by another key type
+     */
+    void merge(const GroupByAggregator &other);
+
+    size_t numGroups() const noexcept { return groups_.size() / kStripes; }
+
+    /// The key of every group, indexed by group id; null for the group of the null keys
+    const ColumnBatch &keys() const noexcept { return keys_; }
+
+    /// Rows of the group, null values included (COUNT(*))
+    int64_t rows(size_t group) const noexcept;
+
+    /// COUNT, SUM, MIN and MAX of the non-null values of the group
+    Aggregate<T> aggregate(size_t group) const noexcept;
+
+private:
+    using Sum = typename Aggregate<T>::Sum;
+
+    // Accumulators per group. Consecutive rows update different ones, so a run of rows of
+    // the same group does not wait for the update of the previous row.
+    static constexpr size_t kStripes = 4;
+
+    struct Accumulator
+    {
+        int64_t rows = 0;
+        int64_t values = 0;
+        Sum sum = 0;
+        T min = Aggregate<T>::kMinIdentity;
+        T max = Aggregate<T>::kMaxIdentity;
+    };
+
+    // The group of a non-null key given by its bytes (the value bytes of fixed width
+    // types), created if the key is new
+    uint32_t group(std::string_view key);
+    uint32_t nullGroup();
+    static void combine(Accumulator &into, const Accumulator &other) noexcept;
+    Accumulator combined(size_t group) const noexcept;
+    void mapDictionary(const std::shared_ptr<const ColumnBatch> &dictionary);
+    template <typename Values>
+    void update(const uint32_t *groups, const Values &values, const uint8_t *validity, size_t first, size_t count);
+
+    ColumnBatch keys_;
+    FlatHashMap<std::string, uint32_t, StringHash, std::equal_to<>> key_groups_;
+    std::optional<uint32_t> null_group_;
+    // kStripes accumulators per group id
+    std::vector<Accumulator> groups_;
+
+    // The dictionary of the last dictionary encoded key batch and the group of each of its
+    // entries
+    std::shared_ptr<const ColumnBatch> dictionary_;
+    std::vector<uint32_t> dictionary_groups_;
+
+    // Group of every row of the block of rows being added
+    std::vector<uint32_t> row_groups_;
+};
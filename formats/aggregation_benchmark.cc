@@ -0,0 +1,229 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "aggregation.hpp"
+#include "basics/benchmark_data.h"
+#include "thread_pool.hpp"
+
+// Aggregation kernels over decoded batches.
+//
+// BM_Reduce: COUNT, SUM, MIN and MAX of 1M uniform values per type, without nulls and
+// with 10% nulls, with the AVX2 kernels and value by value. BM_ReduceDictionary does the
+// same for INT32 values drawn from 100 values and kept as dictionary indices.
+//
+// BM_GroupBy: SELECT key, COUNT(*), SUM(price), MIN(price), MAX(price) GROUP BY key over
+// 1B rows, with key a dictionary encoded BYTE_ARRAY column of 16 or 256 distinct strings
+// drawn from a Zipfian distribution and price a DOUBLE column with 5% nulls. The rows are
+// 16 batches of 64K rows visited over and over; each thread aggregates every threads-th
+// visit into its own aggregator and the aggregators are merged at the end.
+// BM_GroupByHashed is the baseline of grouping materialized keys, which hashes every row;
+// it runs over 100M rows, compare the rows per second. Work runs on pool threads, hence
+// wall times.
+
+namespace
+{
+    constexpr size_t kReduceRows = 1000000;
+    constexpr size_t kBatchRows = 64 * 1024;
+    constexpr size_t kBatches = 16;
+
+    template <typename T>
+    AtomicType parquetType()
+    {
+        if constexpr (std::is_same_v<T, int32_t>)
+        {
+            return AtomicType::INT32;
+        }
+        else if constexpr (std::is_same_v<T, int64_t>)
+        {
+            return AtomicType::INT64;
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            return AtomicType::FLOAT;
+        }
+        else
+        {
+            return AtomicType::DOUBLE;
+        }
+    }
+
+    template <typename T>
+    ColumnBatch reduceBatch(bool nulls)
+    {
+        std::vector<uint64_t> values = uniformIntegers(kReduceRows, 1000000, 1);
+        std::vector<uint64_t> validity = uniformIntegers(kReduceRows, 10, 2);
+        ColumnBatch batch(parquetType<T>());
+        for (size_t i = 0; i < kReduceRows; ++i)
+        {
+            if (nulls && validity[i] == 0)
+            {
+                batch.appendNulls(1);
+            }
+            else
+            {
+                *batch.appendValues<T>(1) = static_cast<T>(values[i]);
+            }
+        }
+        return batch;
+    }
+
+    struct GroupByData
+    {
+        std::vector<ColumnBatch> keys;
+        std::vector<ColumnBatch> prices;
+    };
+
+    GroupByData groupByData(size_t groups, bool materialized)
+    {
+        auto dictionary = std::make_shared<ColumnBatch>(AtomicType::BYTE_ARRAY);
+        for (size_t group = 0; group < groups; ++group)
+        {
+            std::string name = "category-" + std::to_string(group);
+            dictionary->appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+        }
+        GroupByData data;
+        for (size_t b = 0; b < kBatches; ++b)
+        {
+            std::vector<uint64_t> keys = zipfianIntegers(kBatchRows, groups, 1.0, 10 + b);
+            std::vector<uint64_t> cents = uniformIntegers(kBatchRows, 100000, 100 + b);
+            std::vector<uint64_t> nulls = uniformIntegers(kBatchRows, 20, 200 + b);
+            ColumnBatch &key_batch = data.keys.emplace_back(AtomicType::BYTE_ARRAY);
+            ColumnBatch &price_batch = data.prices.emplace_back(AtomicType::DOUBLE);
+            if (!materialized)
+            {
+                key_batch.setDictionary(dictionary);
+            }
+            for (size_t i = 0; i < kBatchRows; ++i)
+            {
+                if (materialized)
+                {
+                    std::string_view name = dictionary->byteArray(keys[i]);
+                    key_batch.appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+                }
+                else
+                {
+                    *key_batch.appendValues<int32_t>(1) = static_cast<int32_t>(keys[i]);
+                }
+                if (nulls[i] == 0)
+                {
+                    price_batch.appendNulls(1);
+                }
+                else
+                {
+                    *price_batch.appendValues<double>(1) = static_cast<double>(cents[i]) / 100;
+                }
+            }
+        }
+        return data;
+    }
+
+    size_t groupBy(ThreadPool &pool, size_t threads, const GroupByData &data, size_t rows)
+    {
+        size_t visits = rows / kBatchRows;
+        std::vector<GroupByAggregator<double>> partials = parallelMap<GroupByAggregator<double>>(
+            pool, threads,
+            [&](size_t thread)
+            {
+                GroupByAggregator<double> aggregator(AtomicType::BYTE_ARRAY);
+                for (size_t visit = thread; visit < visits; visit += threads)
+                {
+                    aggregator.add(data.keys[visit % kBatches], data.prices[visit % kBatches]);
+                }
+                return aggregator;
+            });
+        GroupByAggregator<double> result(AtomicType::BYTE_ARRAY);
+        for (const GroupByAggregator<double> &partial : partials)
+        {
+            result.merge(partial);
+        }
+        benchmark::DoNotOptimize(result.aggregate(0));
+        return visits * kBatchRows;
+    }
+
+    void groupByArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"groups", "threads"});
+        benchmark->ArgsProduct({{16, 256}, {1, 4, 8}});
+        benchmark->UseRealTime();
+        benchmark->Unit(benchmark::kMillisecond);
+    }
+} // namespace
+
+template <typename T>
+static void BM_Reduce(benchmark::State &state)
+{
+    ColumnBatch batch = reduceBatch<T>(state.range(0) != 0);
+    bool use_simd = state.range(1) != 0;
+    for (auto _ : state)
+    {
+        Aggregate<T> result;
+        aggregate(batch, result, use_simd);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kReduceRows));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * kReduceRows * sizeof(T)));
+}
+
+static void BM_ReduceDictionary(benchmark::State &state)
+{
+    auto dictionary = std::make_shared<ColumnBatch>(AtomicType::INT32);
+    std::vector<uint64_t> entries = uniformIntegers(100, 1000000, 1);
+    for (uint64_t entry : entries)
+    {
+        *dictionary->appendValues<int32_t>(1) = static_cast<int32_t>(entry);
+    }
+    std::vector<uint64_t> indices = uniformIntegers(kReduceRows, entries.size(), 2);
+    ColumnBatch batch(AtomicType::INT32);
+    batch.setDictionary(dictionary);
+    for (uint64_t index : indices)
+    {
+        *batch.appendValues<int32_t>(1) = static_cast<int32_t>(index);
+    }
+    for (auto _ : state)
+    {
+        Aggregate<int32_t> result;
+        aggregate(batch, result);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kReduceRows));
+}
+
+static void BM_GroupBy(benchmark::State &state)
+{
+    GroupByData data = groupByData(static_cast<size_t>(state.range(0)), false);
+    auto threads = static_cast<size_t>(state.range(1));
+    ThreadPool pool(threads);
+    size_t rows = 0;
+    for (auto _ : state)
+    {
+        rows = groupBy(pool, threads, data, 1000000000);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rows));
+}
+
+static void BM_GroupByHashed(benchmark::State &state)
+{
+    GroupByData data = groupByData(static_cast<size_t>(state.range(0)), true);
+    auto threads = static_cast<size_t>(state.range(1));
+    ThreadPool pool(threads);
+    size_t rows = 0;
+    for (auto _ : state)
+    {
+        rows = groupBy(pool, threads, data, 100000000);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rows));
+}
+
+BENCHMARK_TEMPLATE(BM_Reduce, int32_t)->ArgNames({"nulls", "simd"})->ArgsProduct({{0, 1}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Reduce, int64_t)->ArgNames({"nulls", "simd"})->ArgsProduct({{0, 1}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Reduce, float)->ArgNames({"nulls", "simd"})->ArgsProduct({{0, 1}, {0, 1}});
+BENCHMARK_TEMPLATE(BM_Reduce, double)->ArgNames({"nulls", "simd"})->ArgsProduct({{0, 1}, {0, 1}});
+BENCHMARK(BM_ReduceDictionary);
+BENCHMARK(BM_GroupBy)->Apply(groupByArgs);
+BENCHMARK(BM_GroupByHashed)->Apply(groupByArgs);
+
+BENCHMARK_MAIN();
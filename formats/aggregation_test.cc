@@ -0,0 +1,326 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "aggregation.hpp"
+
+namespace
+{
+    // Integer valued so that floating point sums are exact in any order
+    template <typename T>
+    ColumnBatch randomBatch(AtomicType type, size_t length, size_t null_every, uint32_t seed)
+    {
+        std::mt19937 rng(seed);
+        ColumnBatch batch(type);
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (null_every > 0 && rng() % null_every == 0)
+            {
+                batch.appendNulls(1);
+            }
+            else
+            {
+                *batch.appendValues<T>(1) = static_cast<T>(static_cast<int32_t>(rng() % 2000001) - 1000000);
+            }
+        }
+        return batch;
+    }
+
+    template <typename T>
+    Aggregate<T> expectedAggregate(const ColumnBatch &batch)
+    {
+        Aggregate<T> expected;
+        for (size_t i = 0; i < batch.length(); ++i)
+        {
+            if (batch.isValid(i))
+            {
+                T value = batch.value<T>(i);
+                ++expected.count;
+                expected.sum += value;
+                expected.min = std::min(expected.min, value);
+                expected.max = std::max(expected.max, value);
+            }
+        }
+        return expected;
+    }
+
+    template <typename T>
+    void expectSameAggregate(const Aggregate<T> &actual, const Aggregate<T> &expected)
+    {
+        EXPECT_EQ(actual.count, expected.count);
+        EXPECT_EQ(actual.sum, expected.sum);
+        EXPECT_EQ(actual.min, expected.min);
+        EXPECT_EQ(actual.max, expected.max);
+    }
+
+    template <typename T>
+    void checkReductions(AtomicType type)
+    {
+        for (size_t length : {0, 1, 7, 8, 9, 64, 1001})
+        {
+            for (size_t null_every : {0, 2, 5})
+            {
+                ColumnBatch batch = randomBatch<T>(type, length, null_every, static_cast<uint32_t>(length));
+                Aggregate<T> expected = expectedAggregate<T>(batch);
+                for (bool use_simd : {true, false})
+                {
+                    SCOPED_TRACE(std::to_string(length) + " " + std::to_string(null_every) + " " +
+                                 std::to_string(use_simd));
+                    Aggregate<T> actual;
+                    aggregate(batch, actual, use_simd);
+                    expectSameAggregate(actual, expected);
+                }
+            }
+        }
+    }
+
+    // A dictionary encoded BYTE_ARRAY batch; nullopt keys are nulls
+    ColumnBatch dictionaryKeys(const std::vector<std::string> &entries, const std::vector<std::optional<int>> &keys)
+    {
+        auto dictionary = std::make_shared<ColumnBatch>(AtomicType::BYTE_ARRAY);
+        for (const std::string &entry : entries)
+        {
+            dictionary->appendByteArray(reinterpret_cast<const uint8_t *>(entry.data()), entry.size());
+        }
+        ColumnBatch batch(AtomicType::BYTE_ARRAY);
+        batch.setDictionary(dictionary);
+        for (const std::optional<int> &key : keys)
+        {
+            if (key)
+            {
+                *batch.appendValues<int32_t>(1) = *key;
+            }
+            else
+            {
+                batch.appendNulls(1);
+            }
+        }
+        return batch;
+    }
+
+    ColumnBatch int64Values(const std::vector<std::optional<int64_t>> &values)
+    {
+        ColumnBatch batch(AtomicType::INT64);
+        for (const std::optional<int64_t> &value : values)
+        {
+            if (value)
+            {
+                *batch.appendValues<int64_t>(1) = *value;
+            }
+            else
+            {
+                batch.appendNulls(1);
+            }
+        }
+        return batch;
+    }
+
+    // "key: rows count sum min max" of every group, keyed by "null" for null keys
+    std::map<std::string, std::string> groups(const GroupByAggregator<int64_t> &aggregator)
+    {
+        std::map<std::string, std::string> out;
+        for (size_t g = 0; g < aggregator.numGroups(); ++g)
+        {
+            Aggregate<int64_t> result = aggregator.aggregate(g);
+            std::string key = aggregator.keys().isValid(g) ? std::string(aggregator.keys().byteArray(g)) : "null";
+            out[key] = std::to_string(aggregator.rows(g)) + " " + std::to_string(result.count) + " " +
+                       std::to_string(result.sum) + " " + std::to_string(result.min) + " " +
+                       std::to_string(result.max);
+        }
+        return out;
+    }
+} // namespace
+
+TEST(AggregationTest, SimdMatchesScalar)
+{
+    checkReductions<int32_t>(AtomicType::INT32);
+    checkReductions<int64_t>(AtomicType::INT64);
+    checkReductions<float>(AtomicType::FLOAT);
+    checkReductions<double>(AtomicType::DOUBLE);
+}
+
+TEST(AggregationTest, SkipsNaNAndWrapsIntegerSums)
+{
+    ColumnBatch doubles(AtomicType::DOUBLE);
+    for (size_t i = 0; i < 20; ++i)
+    {
+        if (i == 3)
+        {
+            doubles.appendNulls(1);
+        }
+        else
+        {
+            *doubles.appendValues<double>(1) = i == 5 || i == 17 ? std::nan("") : static_cast<double>(i) - 10;
+        }
+    }
+    for (bool use_simd : {true, false})
+    {
+        Aggregate<double> result;
+        aggregate(doubles, result, use_simd);
+        EXPECT_EQ(result.count, 19);
+        EXPECT_TRUE(std::isnan(result.sum));
+        EXPECT_EQ(result.min, -10);
+        EXPECT_EQ(result.max, 9);
+
+        Aggregate<double> empty;
+        ColumnBatch nulls(AtomicType::DOUBLE);
+        nulls.appendNulls(10);
+        aggregate(nulls, empty, use_simd);
+        EXPECT_EQ(empty.count, 0);
+        EXPECT_EQ(empty.min, std::numeric_limits<double>::infinity());
+
+        ColumnBatch large(AtomicType::INT64);
+        int64_t *values = large.appendValues<int64_t>(9);
+        std::fill(values, values + 9, std::numeric_limits<int64_t>::max());
+        Aggregate<int64_t> wrapped;
+        aggregate(large, wrapped, use_simd);
+        EXPECT_EQ(wrapped.sum, std::numeric_limits<int64_t>::max() - 8);
+    }
+
+    Aggregate<int32_t> wrong_type;
+    EXPECT_THROW(aggregate(doubles, wrong_type), std::invalid_argument);
+}
+
+TEST(AggregationTest, ReducesDictionaryIndices)
+{
+    auto dictionary = std::make_shared<ColumnBatch>(AtomicType::INT32);
+    int32_t *entries = dictionary->appendValues<int32_t>(4);
+    entries[0] = 10;
+    entries[1] = -7;
+    entries[2] = 3;
+    entries[3] = 100;
+
+    ColumnBatch plain(AtomicType::INT32);
+    ColumnBatch encoded(AtomicType::INT32);
+    encoded.setDictionary(dictionary);
+    for (size_t i = 0; i < 50; ++i)
+    {
+        if (i % 9 == 4)
+        {
+            plain.appendNulls(1);
+            encoded.appendNulls(1);
+            continue;
+        }
+        // Entry 3 never shows up
+        int32_t index = static_cast<int32_t>(i * 7 % 3);
+        *encoded.appendValues<int32_t>(1) = index;
+        *plain.appendValues<int32_t>(1) = entries[index];
+    }
+    Aggregate<int32_t> expected = expectedAggregate<int32_t>(plain);
+    Aggregate<int32_t> actual;
+    aggregate(encoded, actual);
+    expectSameAggregate(actual, expected);
+    EXPECT_EQ(actual.max, 10);
+
+    // More entries than rows
+    ColumnBatch few(AtomicType::INT32);
+    few.setDictionary(dictionary);
+    *few.appendValues<int32_t>(1) = 3;
+    Aggregate<int32_t> single;
+    aggregate(few, single);
+    EXPECT_EQ(single.count, 1);
+    EXPECT_EQ(single.sum, 100);
+
+    actual.merge(single);
+    EXPECT_EQ(actual.count, expected.count + 1);
+    EXPECT_EQ(actual.max, 100);
+}
+
+TEST(GroupByAggregatorTest, GroupsDictionaryAndPlainKeys)
+{
+    GroupByAggregator<int64_t> aggregator(AtomicType::BYTE_ARRAY);
+    aggregator.add(dictionaryKeys({"red", "green", "blue"}, {0, 1, 0, std::nullopt, 2, 0}),
+                   int64Values({1, 2, 3, 4, std::nullopt, -5}));
+    // A new dictionary with the keys in another order
+    aggregator.add(dictionaryKeys({"blue", "red", "cyan"}, {1, 0, 2, std::nullopt}), int64Values({10, 20, 30, 40}));
+    ColumnBatch plain_keys(AtomicType::BYTE_ARRAY);
+    for (const char *key : {"green", "cyan", "red"})
+    {
+        plain_keys.appendByteArray(reinterpret_cast<const uint8_t *>(key), std::strlen(key));
+    }
+    aggregator.add(plain_keys, int64Values({std::nullopt, 7, 100}));
+
+    EXPECT_EQ(aggregator.numGroups(), 5u);
+    EXPECT_EQ(aggregator.keys().byteArray(0), "red");
+    std::map<std::string, std::string> expected = {
+        {"red", "5 5 109 -5 100"}, {"green", "2 1 2 2 2"}, {"blue", "2 1 20 20 20"},
+        {"cyan", "2 2 37 7 30"},   {"null", "2 2 44 4 40"},
+    };
+    EXPECT_EQ(groups(aggregator), expected);
+
+    EXPECT_THROW(aggregator.add(plain_keys, int64Values({1})), std::invalid_argument);
+    EXPECT_THROW(aggregator.add(int64Values({1}), int64Values({1})), std::invalid_argument);
+    GroupByAggregator<int64_t> by_int(AtomicType::INT64);
+    EXPECT_THROW(aggregator.merge(by_int), std::invalid_argument);
+}
+
+TEST(GroupByAggregatorTest, MergesPerThreadAggregators)
+{
+    const std::vector<std::string> entries = {"a", "b", "c", "d", "e", "f", "g"};
+    std::mt19937 rng(7);
+    GroupByAggregator<int64_t> single(AtomicType::BYTE_ARRAY);
+    std::vector<GroupByAggregator<int64_t>> partials;
+    for (size_t thread = 0; thread < 3; ++thread)
+    {
+        partials.emplace_back(AtomicType::BYTE_ARRAY);
+    }
+    for (size_t batch = 0; batch < 12; ++batch)
+    {
+        std::vector<std::optional<int>> keys;
+        std::vector<std::optional<int64_t>> values;
+        for (size_t i = 0; i < 3000; ++i)
+        {
+            auto key = static_cast<int>(rng() % entries.size());
+            keys.push_back(rng() % 50 == 0 ? std::nullopt : std::optional<int>(key));
+            values.push_back(rng() % 10 == 0 ? std::nullopt : std::optional<int64_t>(rng() % 1000));
+        }
+        ColumnBatch key_batch = dictionaryKeys(entries, keys);
+        ColumnBatch value_batch = int64Values(values);
+        single.add(key_batch, value_batch);
+        partials[batch % partials.size()].add(key_batch, value_batch);
+    }
+    GroupByAggregator<int64_t> merged(AtomicType::BYTE_ARRAY);
+    for (const GroupByAggregator<int64_t> &partial : partials)
+    {
+        merged.merge(partial);
+    }
+    EXPECT_EQ(merged.numGroups(), entries.size() + 1);
+    EXPECT_EQ(groups(merged), groups(single));
+}
+
+TEST(GroupByAggregatorTest, GroupsFixedWidthKeysWithDictionaryValues)
+{
+    auto dictionary = std::make_shared<ColumnBatch>(AtomicType::DOUBLE);
+    double *entries = dictionary->appendValues<double>(2);
+    entries[0] = 0.5;
+    entries[1] = std::nan("");
+    ColumnBatch values(AtomicType::DOUBLE);
+    values.setDictionary(dictionary);
+    ColumnBatch keys(AtomicType::INT32);
+    for (int32_t i = 0; i < 10; ++i)
+    {
+        *keys.appendValues<int32_t>(1) = i % 2;
+        *values.appendValues<int32_t>(1) = i == 3 ? 1 : 0;
+    }
+    GroupByAggregator<double> aggregator(AtomicType::INT32);
+    aggregator.add(keys, values);
+    ASSERT_EQ(aggregator.numGroups(), 2u);
+    EXPECT_EQ(aggregator.keys().value<int32_t>(1), 1);
+    Aggregate<double> even = aggregator.aggregate(0);
+    Aggregate<double> odd = aggregator.aggregate(1);
+    EXPECT_EQ(even.count, 5);
+    EXPECT_EQ(even.sum, 2.5);
+    EXPECT_EQ(odd.count, 5);
+    EXPECT_TRUE(std::isnan(odd.sum));
+    EXPECT_EQ(odd.min, 0.5);
+    EXPECT_EQ(odd.max, 0.5);
+}
@@ -0,0 +1,179 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <memory>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "basics/arena.h"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+// Allocation cost of decoding one row group: 256K rows of 8 Snappy compressed columns
+// (INT64, DOUBLE, optional BYTE_ARRAY), every column chunk through a fresh
+// ColumnChunkReader into a fresh ColumnBatch per 4096 values, the way the scanner hands
+// out batches, all of which live until the row group is done. "Heap" allocates the
+// decompressed pages, the scratch space and the batches from the global heap, "Arena"
+// from an Arena reset after the row group. Reports the allocations that reached the heap
+// per row group, after a first row group to warm up.
+
+namespace
+{
+    constexpr size_t kRowsPerGroup = 256 * 1024;
+    constexpr size_t kColumns = 8;
+
+    /**
+     * @brief Forwards to the global heap and counts the allocations.
+     */
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+        size_t allocations = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *pointer, size_t bytes, size_t alignment) override
+        {
+            std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override { return this == &other; }
+    };
+
+    struct LoadedRowGroup
+    {
+        std::shared_ptr<const ParquetFileReader> file;
+        std::vector<Slice> chunks;
+    };
+
+    // One row group, written once per process; its column chunks are read into memory so
+    // the benchmark measures decoding only
+    const LoadedRowGroup &benchmarkRowGroup()
+    {
+        static LoadedRowGroup row_group = []()
+        {
+            std::string path = std::string("/tmp/arena_decode_benchmark_") + std::to_string(::getpid()) + ".parquet";
+            std::vector<ColumnDescriptor> columns(kColumns);
+            for (size_t c = 0; c < kColumns; ++c)
+            {
+                columns[c].path = {std::string("c") + std::to_string(c)};
+                columns[c].type = c % 3 == 0 ? AtomicType::INT64 : c % 3 == 1 ? AtomicType::DOUBLE
+                                                                              : AtomicType::BYTE_ARRAY;
+                columns[c].max_definition_level = columns[c].type == AtomicType::BYTE_ARRAY ? 1 : 0;
+            }
+            WriterOptions options;
+            options.codec = CompressionCodec::SNAPPY;
+            ParquetFileWriter writer(path, columns, options);
+
+            std::mt19937_64 rng(42);
+            std::vector<ColumnBatch> batches;
+            for (const auto &column : columns)
+            {
+                ColumnBatch batch(column.type);
+                for (size_t i = 0; i < kRowsPerGroup; ++i)
+                {
+                    switch (column.type)
+                    {
+                    case AtomicType::INT64:
+                        *batch.appendValues<int64_t>(1) = static_cast<int64_t>(i);
+                        break;
+                    case AtomicType::DOUBLE:
+                        *batch.appendValues<double>(1) = static_cast<double>(rng() % 10000) / 100;
+                        break;
+                    default:
+                        if (rng() % 10 == 0)
+                        {
+                            batch.appendNulls(1);
+                        }
+                        else
+                        {
+                            std::string value = "value-";
+                            value += std::to_string(rng() % 1000);
+                            batch.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+                        }
+                    }
+                }
+                batches.push_back(std::move(batch));
+            }
+            std::vector<const ColumnBatch *> pointers;
+            for (const auto &batch : batches)
+            {
+                pointers.push_back(&batch);
+            }
+            writer.writeRowGroup(pointers);
+            writer.close();
+
+            LoadedRowGroup result;
+            result.file = std::make_shared<ParquetFileReader>(path);
+            std::remove(path.c_str());
+            for (size_t c = 0; c < kColumns; ++c)
+            {
+                result.chunks.push_back(result.file->readColumnChunk(0, c));
+            }
+            return result;
+        }();
+        return row_group;
+    }
+
+    void decodeRowGroup(const LoadedRowGroup &row_group, std::pmr::memory_resource *resource)
+    {
+        std::pmr::vector<ColumnBatch> batches(resource);
+        for (size_t c = 0; c < kColumns; ++c)
+        {
+            ColumnChunkReader reader = row_group.file->columnChunk(0, c, row_group.chunks[c], resource);
+            const ColumnDescriptor &column = reader.column();
+            while (reader.hasNext())
+            {
+                batches.emplace_back(column.type, column.type_length, resource);
+                reader.readBatch(batches.back(), kDefaultBatchSize);
+                benchmark::DoNotOptimize(batches.back().data());
+            }
+        }
+    }
+} // namespace
+
+static void BM_DecodeRowGroupHeap(benchmark::State &state)
+{
+    const LoadedRowGroup &row_group = benchmarkRowGroup();
+    CountingResource heap;
+    decodeRowGroup(row_group, &heap);
+    heap.allocations = 0;
+    for (auto _ : state)
+    {
+        decodeRowGroup(row_group, &heap);
+    }
+    state.counters["allocations"] =
+        benchmark::Counter(static_cast<double>(heap.allocations), benchmark::Counter::kAvgIterations);
+    state.SetItemsProcessed(static_cast<int64_t>(kRowsPerGroup * kColumns) * state.iterations());
+}
+BENCHMARK(BM_DecodeRowGroupHeap)->Unit(benchmark::kMillisecond);
+
+static void BM_DecodeRowGroupArena(benchmark::State &state)
+{
+    const LoadedRowGroup &row_group = benchmarkRowGroup();
+    CountingResource heap;
+    Arena arena(Arena::kDefaultBlockSize, &heap);
+    decodeRowGroup(row_group, &arena);
+    arena.reset();
+    heap.allocations = 0;
+    for (auto _ : state)
+    {
+        decodeRowGroup(row_group, &arena);
+        arena.reset();
+    }
+    state.counters["allocations"] =
+        benchmark::Counter(static_cast<double>(heap.allocations), benchmark::Counter::kAvgIterations);
+    state.counters["arena_bytes"] = static_cast<double>(arena.memoryUsage());
+    state.SetItemsProcessed(static_cast<int64_t>(kRowsPerGroup * kColumns) * state.iterations());
+}
+BENCHMARK(BM_DecodeRowGroupArena)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,657 @@
+#include "avro.hpp"
+
+#include <array>
+#include <cerrno>
+#include <fcntl.h>
+#include <random>
+#include <system_error>
+#include <unistd.h>
+
+#include "compression.hpp"
+
+namespace
+{
+    constexpr uint8_t kMagic[4] = {'O', 'b', 'j', 1};
+
+    constexpr std::array<uint32_t, 256> crcTable()
+    {
+        std::array<uint32_t, 256> table{};
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                crc = crc & 1 ? (crc >> 1) ^ 0xedb88320 : crc >> 1;
+            }
+            table[i] = crc;
+        }
+        return table;
+    }
+
+    /**
+     * @brief The CRC-32 (IEEE) the snappy codec appends to every block.
+     */
+    uint32_t crc32(const uint8_t *data, size_t size)
+    {
+        static constexpr std::array<uint32_t, 256> kTable = crcTable();
+        uint32_t crc = 0xffffffff;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = kTable[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+        return crc ^ 0xffffffff;
+    }
+
+    /**
+     * @brief The uncompressed length at the start of a Snappy stream.
+     */
+    size_t snappyLength(const uint8_t *data, size_t size)
+    {
+        size_t length = 0;
+        for (size_t i = 0, shift = 0; i < size && shift < 35; ++i, shift += 7)
+        {
+            length |= static_cast<size_t>(data[i] & 0x7f) << shift;
+            if ((data[i] & 0x80) == 0)
+            {
+                return length;
+            }
+        }
+        throw AvroException("Corrupt snappy block in Avro file");
+    }
+
+    std::string qualify(const std::string &name, const std::string &namespace_name)
+    {
+        if (name.find('.') != std::string::npos || namespace_name.empty())
+        {
+            return name;
+        }
+        return namespace_name + "." + name;
+    }
+
+    std::optional<AvroType> primitiveType(std::string_view name)
+    {
+        static const std::pair<std::string_view, AvroType> kPrimitives[] = {
+            {"null", AvroType::NULL_TYPE}, {"boolean", AvroType::BOOLEAN}, {"int", AvroType::INT},
+            {"long", AvroType::LONG},      {"float", AvroType::FLOAT},     {"double", AvroType::DOUBLE},
+            {"bytes", AvroType::BYTES},    {"string", AvroType::STRING},
+        };
+        for (const auto &[primitive, type] : kPrimitives)
+        {
+            if (primitive == name)
+            {
+                return type;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::string stringField(const VariantView &json, std::string_view key)
+    {
+        std::optional<VariantView> value = json.field(key);
+        if (!value || value->type() != VariantType::STRING)
+        {
+            throw AvroException("Avro schema without a \"" + std::string(key) + "\" string");
+        }
+        return std::string(value->getString());
+    }
+} // namespace
+
+std::optional<size_t> AvroNode::findField(std::string_view name) const
+{
+    for (size_t i = 0; i < fields.size(); ++i)
+    {
+        if (fields[i].name == name)
+        {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+const AvroNode &AvroNode::nonNull() const
+{
+    if (type == AvroType::UNION && branches.size() == 2)
+    {
+        if (branches[0]->type == AvroType::NULL_TYPE)
+        {
+            return *branches[1];
+        }
+        if (branches[1]->type == AvroType::NULL_TYPE)
+        {
+            return *branches[0];
+        }
+    }
+    return *this;
+}
+
+AvroSchema AvroSchema::parse(std::string_view json)
+{
+    AvroSchema schema;
+    schema.json_ = json;
+    try
+    {
+        Variant parsed = variantFromJson(json);
+        schema.root_ = schema.parseNode(parsed.view(), "");
+    }
+    catch (const std::logic_error &e)
+    {
+        throw AvroException(std::string("Invalid Avro schema: ") + e.what());
+    }
+    return schema;
+}
+
+AvroNode *AvroSchema::addNode(AvroType type)
+{
+    nodes_.push_back(std::make_unique<AvroNode>());
+    nodes_.back()->type = type;
+    return nodes_.back().get();
+}
+
+AvroNode *AvroSchema::addNamed(AvroType type, const VariantView &json, const std::string &namespace_name)
+{
+    std::string name = stringField(json, "name");
+    std::string space = namespace_name;
+    if (std::optional<VariantView> value = json.field("namespace"); value && value->type() == VariantType::STRING)
+    {
+        space = std::string(value->getString());
+    }
+    AvroNode *node = addNode(type);
+    node->name = qualify(name, space);
+    names_.emplace_back(node->name, node);
+    return node;
+}
+
+const AvroNode *AvroSchema::parseNode(const VariantView &json, const std::string &namespace_name)
+{
+    if (json.type() == VariantType::STRING)
+    {
+        std::string_view name = json.getString();
+        if (std::optional<AvroType> type = primitiveType(name))
+        {
+            return addNode(*type);
+        }
+        std::string full_name = qualify(std::string(name), namespace_name);
+        for (const auto &[known, node] : names_)
+        {
+            if (known == full_name || known == name)
+            {
+                return node;
+            }
+        }
+        throw AvroException("Unknown Avro type " + std::string(name));
+    }
+    if (json.type() == VariantType::ARRAY)
+    {
+        AvroNode *node = addNode(AvroType::UNION);
+        for (size_t i = 0; i < json.numElements(); ++i)
+        {
+            node->branches.push_back(parseNode(json.element(i), namespace_name));
+        }
+        return node;
+    }
+    if (json.type() != VariantType::OBJECT)
+    {
+        throw AvroException("Invalid Avro type " + json.toJson());
+    }
+
+    std::optional<VariantView> type_value = json.field("type");
+    if (!type_value)
+    {
+        throw AvroException("Avro schema without a type");
+    }
+    if (type_value->type() != VariantType::STRING)
+    {
+        return parseNode(*type_value, namespace_name);
+    }
+    std::string_view type = type_value->getString();
+    AvroNode *node = nullptr;
+    if (type == "record" || type == "error")
+    {
+        node = addNamed(AvroType::RECORD, json, namespace_name);
+        std::string space = node->name.substr(0, node->name.rfind('.') == std::string::npos ? 0 : node->name.rfind('.'));
+        std::optional<VariantView> fields = json.field("fields");
+        if (!fields || fields->type() != VariantType::ARRAY)
+        {
+            throw AvroException("Avro record " + node->name + " without fields");
+        }
+        for (size_t i = 0; i < fields->numElements(); ++i)
+        {
+            VariantView field = fields->element(i);
+            AvroField &out = node->fields.emplace_back();
+            out.name = stringField(field, "name");
+            std::optional<VariantView> field_type = field.field("type");
+            if (!field_type)
+            {
+                throw AvroException("Avro field " + out.name + " without a type");
+            }
+            out.type = parseNode(*field_type, space);
+            if (std::optional<VariantView> id = field.field("field-id"))
+            {
+                out.field_id = static_cast<int32_t>(id->getInt());
+            }
+        }
+    }
+    else if (type == "enum")
+    {
+        node = addNamed(AvroType::ENUM, json, namespace_name);
+        std::optional<VariantView> symbols = json.field("symbols");
+        for (size_t i = 0; symbols && i < symbols->numElements(); ++i)
+        {
+            node->symbols.emplace_back(symbols->element(i).getString());
+        }
+    }
+    else if (type == "array" || type == "map")
+    {
+        node = addNode(type == "array" ? AvroType::ARRAY : AvroType::MAP);
+        std::optional<VariantView> items = json.field(type == "array" ? "items" : "values");
+        if (!items)
+        {
+            throw AvroException("Avro " + std::string(type) + " without an item type");
+        }
+        node->items = parseNode(*items, namespace_name);
+    }
+    else if (type == "fixed")
+    {
+        node = addNamed(AvroType::FIXED, json, namespace_name);
+        std::optional<VariantView> size = json.field("size");
+        if (!size || size->getInt() < 0)
+        {
+            throw AvroException("Avro fixed " + node->name + " without a size");
+        }
+        node->size = static_cast<size_t>(size->getInt());
+    }
+    else if (std::optional<AvroType> primitive = primitiveType(type))
+    {
+        node = addNode(*primitive);
+    }
+    else
+    {
+        return parseNode(*type_value, namespace_name);
+    }
+    if (std::optional<VariantView> logical = json.field("logicalType"); logical && logical->type() == VariantType::STRING)
+    {
+        node->logical_type = logical->getString();
+    }
+    return node;
+}
+
+void AvroDecoder::skip(const AvroNode &node)
+{
+    switch (node.type)
+    {
+    case AvroType::NULL_TYPE:
+        break;
+    case AvroType::BOOLEAN:
+        readFixed(1);
+        break;
+    case AvroType::INT:
+    case AvroType::LONG:
+    case AvroType::ENUM:
+        readLong();
+        break;
+    case AvroType::FLOAT:
+        readFixed(4);
+        break;
+    case AvroType::DOUBLE:
+        readFixed(8);
+        break;
+    case AvroType::BYTES:
+    case AvroType::STRING:
+        readBytes();
+        break;
+    case AvroType::FIXED:
+        readFixed(node.size);
+        break;
+    case AvroType::RECORD:
+        for (const AvroField &field : node.fields)
+        {
+            skip(*field.type);
+        }
+        break;
+    case AvroType::ARRAY:
+    case AvroType::MAP:
+        for (int64_t count = readLong(); count != 0; count = readLong())
+        {
+            if (count < 0)
+            {
+                // Blocks with a negative count carry their size and are skipped whole
+                int64_t size = readLong();
+                if (size < 0)
+                {
+                    throw AvroException("Negative Avro block size");
+                }
+                readFixed(static_cast<size_t>(size));
+                continue;
+            }
+            for (int64_t i = 0; i < count; ++i)
+            {
+                if (node.type == AvroType::MAP)
+                {
+                    readBytes();
+                }
+                skip(*node.items);
+            }
+        }
+        break;
+    case AvroType::UNION:
+        skip(*node.branches[readUnionIndex(node)]);
+        break;
+    }
+}
+
+void appendAvroValue(const AvroNode &node, AvroDecoder &decoder, VariantBuilder &out)
+{
+    switch (node.type)
+    {
+    case AvroType::NULL_TYPE:
+        out.appendNull();
+        break;
+    case AvroType::BOOLEAN:
+        out.appendBool(decoder.readBool());
+        break;
+    case AvroType::INT:
+        if (node.logical_type == "date")
+        {
+            out.appendDate(decoder.readInt());
+        }
+        else
+        {
+            out.appendInt(decoder.readInt());
+        }
+        break;
+    case AvroType::LONG:
+        if (node.logical_type == "timestamp-micros")
+        {
+            out.appendTimestamp(decoder.readLong());
+        }
+        else
+        {
+            out.appendInt(decoder.readLong());
+        }
+        break;
+    case AvroType::FLOAT:
+        out.appendFloat(decoder.readFloat());
+        break;
+    case AvroType::DOUBLE:
+        out.appendDouble(decoder.readDouble());
+        break;
+    case AvroType::BYTES:
+        out.appendBinary(decoder.readBytes());
+        break;
+    case AvroType::STRING:
+        out.appendString(decoder.readString());
+        break;
+    case AvroType::FIXED:
+        out.appendBinary(decoder.readFixed(node.size));
+        break;
+    case AvroType::ENUM:
+    {
+        int64_t index = decoder.readLong();
+        if (index < 0 || static_cast<size_t>(index) >= node.symbols.size())
+        {
+            throw AvroException("Avro enum symbol out of range");
+        }
+        out.appendString(node.symbols[static_cast<size_t>(index)]);
+        break;
+    }
+    case AvroType::RECORD:
+        out.beginObject();
+        for (const AvroField &field : node.fields)
+        {
+            out.key(field.name);
+            appendAvroValue(*field.type, decoder, out);
+        }
+        out.endObject();
+        break;
+    case AvroType::ARRAY:
+        out.beginArray();
+        for (size_t count = decoder.readBlockCount(); count != 0; count = decoder.readBlockCount())
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                appendAvroValue(*node.items, decoder, out);
+            }
+        }
+        out.endArray();
+        break;
+    case AvroType::MAP:
+        out.beginObject();
+        for (size_t count = decoder.readBlockCount(); count != 0; count = decoder.readBlockCount())
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                out.key(decoder.readString());
+                appendAvroValue(*node.items, decoder, out);
+            }
+        }
+        out.endObject();
+        break;
+    case AvroType::UNION:
+        appendAvroValue(*node.branches[decoder.readUnionIndex(node)], decoder, out);
+        break;
+    }
+}
+
+AvroFileReader::AvroFileReader(const RandomAccessFile &file)
+    : data_(file.size())
+{
+    file.readAt(0, data_.size(), data_.data());
+    readHeader();
+}
+
+AvroFileReader::AvroFileReader(std::vector<uint8_t> data)
+    : data_(std::move(data))
+{
+    readHeader();
+}
+
+std::optional<std::string_view> AvroFileReader::metadata(std::string_view key) const
+{
+    for (const auto &[name, value] : metadata_)
+    {
+        if (name == key)
+        {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+void AvroFileReader::readHeader()
+{
+    if (data_.size() < sizeof(kMagic) || std::memcmp(data_.data(), kMagic, sizeof(kMagic)) != 0)
+    {
+        throw AvroException("Not an Avro object container file");
+    }
+    AvroDecoder decoder(data_.data() + sizeof(kMagic), data_.size() - sizeof(kMagic));
+    for (size_t count = decoder.readBlockCount(); count != 0; count = decoder.readBlockCount())
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            std::string_view key = decoder.readString();
+            metadata_.emplace_back(key, decoder.readBytes());
+        }
+    }
+    std::memcpy(sync_, decoder.readFixed(sizeof(sync_)).data(), sizeof(sync_));
+    offset_ = data_.size() - decoder.remaining();
+
+    std::optional<std::string_view> schema = metadata("avro.schema");
+    if (!schema)
+    {
+        throw AvroException("Avro file without a schema");
+    }
+    schema_ = AvroSchema::parse(*schema);
+    codec_ = metadata("avro.codec").value_or("null");
+    if (codec_ != "null" && codec_ != "snappy")
+    {
+        throw AvroException("Unsupported Avro codec " + codec_);
+    }
+}
+
+bool AvroFileReader::nextBlock(AvroDecoder &records, size_t &count)
+{
+    if (offset_ == data_.size())
+    {
+        return false;
+    }
+    AvroDecoder decoder(data_.data() + offset_, data_.size() - offset_);
+    int64_t records_in_block = decoder.readLong();
+    int64_t size = decoder.readLong();
+    if (records_in_block < 0 || size < 0)
+    {
+        throw AvroException("Corrupt Avro block header");
+    }
+    std::string_view bytes = decoder.readFixed(static_cast<size_t>(size));
+    if (std::memcmp(decoder.readFixed(sizeof(sync_)).data(), sync_, sizeof(sync_)) != 0)
+    {
+        throw AvroException("Avro block does not end with the sync marker");
+    }
+    offset_ = data_.size() - decoder.remaining();
+    count = static_cast<size_t>(records_in_block);
+
+    auto *data = reinterpret_cast<const uint8_t *>(bytes.data());
+    if (codec_ == "null")
+    {
+        records = AvroDecoder(data, bytes.size());
+        return true;
+    }
+    if (bytes.size() < 4)
+    {
+        throw AvroException("Corrupt snappy block in Avro file");
+    }
+    size_t compressed = bytes.size() - 4;
+    block_.resize(snappyLength(data, compressed));
+    try
+    {
+        decompress(CompressionCodec::SNAPPY, data, compressed, block_.data(), block_.size());
+    }
+    catch (const ParquetException &e)
+    {
+        throw AvroException(e.what());
+    }
+    const uint8_t *checksum = data + compressed;
+    uint32_t expected = static_cast<uint32_t>(checksum[0]) << 24 | static_cast<uint32_t>(checksum[1]) << 16 |
+                        static_cast<uint32_t>(checksum[2]) << 8 | checksum[3];
+    if (crc32(block_.data(), block_.size()) != expected)
+    {
+        throw AvroException("Checksum mismatch in Avro block");
+    }
+    records = AvroDecoder(block_.data(), block_.size());
+    return true;
+}
+
+AvroFileWriter::AvroFileWriter(const std::string &path, std::string_view schema,
+                               const std::vector<std::pair<std::string, std::string>> &metadata, AvroCodec codec,
+                               size_t block_size)
+    : path_(path), schema_(AvroSchema::parse(schema)), codec_(codec), block_size_(block_size)
+{
+    std::random_device random;
+    for (uint8_t &byte : sync_)
+    {
+        byte = static_cast<uint8_t>(random());
+    }
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot create " + path);
+    }
+
+    AvroEncoder header;
+    header.writeFixed(std::string_view(reinterpret_cast<const char *>(kMagic), sizeof(kMagic)));
+    header.writeBlockCount(metadata.size() + 2);
+    header.writeString("avro.schema");
+    header.writeBytes(schema);
+    header.writeString("avro.codec");
+    header.writeBytes(codec == AvroCodec::SNAPPY ? "snappy" : "null");
+    for (const auto &[key, value] : metadata)
+    {
+        header.writeString(key);
+        header.writeBytes(value);
+    }
+    header.writeBlockCount(0);
+    header.writeFixed(std::string_view(reinterpret_cast<const char *>(sync_), sizeof(sync_)));
+    write(header.data().data(), header.data().size());
+}
+
+AvroFileWriter::~AvroFileWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+void AvroFileWriter::endRecord()
+{
+    ++block_records_;
+    if (records_.data().size() >= block_size_)
+    {
+        writeBlock();
+    }
+}
+
+void AvroFileWriter::close()
+{
+    if (fd_ < 0)
+    {
+        return;
+    }
+    if (block_records_ > 0)
+    {
+        writeBlock();
+    }
+    int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot close " + path_);
+    }
+}
+
+void AvroFileWriter::writeBlock()
+{
+    const std::vector<uint8_t> &records = records_.data();
+    std::string_view payload(reinterpret_cast<const char *>(records.data()), records.size());
+    if (codec_ == AvroCodec::SNAPPY)
+    {
+        compressed_.resize(maxCompressedLength(CompressionCodec::SNAPPY, records.size()) + 4);
+        size_t size = compress(CompressionCodec::SNAPPY, records.data(), records.size(), compressed_.data());
+        uint32_t crc = crc32(records.data(), records.size());
+        for (int i = 0; i < 4; ++i)
+        {
+            compressed_[size + static_cast<size_t>(i)] = static_cast<uint8_t>(crc >> (24 - 8 * i));
+        }
+        payload = std::string_view(reinterpret_cast<const char *>(compressed_.data()), size + 4);
+    }
+    AvroEncoder header;
+    header.writeLong(static_cast<int64_t>(block_records_));
+    header.writeLong(static_cast<int64_t>(payload.size()));
+    write(header.data().data(), header.data().size());
+    write(reinterpret_cast<const uint8_t *>(payload.data()), payload.size());
+    write(sync_, sizeof(sync_));
+    records_written_ += block_records_;
+    block_records_ = 0;
+    records_.clear();
+}
+
+void AvroFileWriter::write(const uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = ::write(fd_, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + path_);
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset_ += static_cast<uint64_t>(n);
+    }
+}
@@ -0,0 +1,405 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "io.hpp"
+#include "variant.hpp"
+
+// Avro object container files, the format of Iceberg manifests and manifest lists:
+// https://avro.apache.org/docs/1.11.1/specification/
+//
+//   "Obj" 1, metadata map (avro.schema, avro.codec, ...), 16 byte sync marker
+//   blocks: Long record count, Long byte size, the records, the sync marker
+//
+// Records use the binary encoding: zigzag varint ints and longs, little endian floats and
+// doubles, length prefixed bytes and strings, arrays and maps in blocks of items ended by
+// an empty block, and unions as the index of the branch followed by its value. The
+// "null" and "snappy" codecs are supported.
+
+class AvroException : public std::runtime_error
+{
+public:
+    explicit AvroException(const std::string &message)
+        : std::runtime_error(message) {}
+};
+
+enum class AvroType
+{
+    NULL_TYPE,
+    BOOLEAN,
+    INT,
+    LONG,
+    FLOAT,
+    DOUBLE,
+    BYTES,
+    STRING,
+    RECORD,
+    ENUM,
+    ARRAY,
+    MAP,
+    UNION,
+    FIXED
+};
+
+struct AvroNode;
+
+struct AvroField
+{
+    std::string name;
+    const AvroNode *type = nullptr;
+    /// The "field-id" attribute Iceberg puts on every field
+    std::optional<int32_t> field_id;
+};
+
+/**
+ * @brief One type of a schema. Named types (records, enums, fixed) may be referenced from
+ * several places, so nodes point to each other and are owned by their AvroSchema.
+ */
+struct AvroNode
+{
+    AvroType type = AvroType::NULL_TYPE;
+    /// Full name of records, enums and fixed
+    std::string name;
+    /// The "logicalType" attribute, e.g. "date" or "timestamp-micros"
+    std::string logical_type;
+    std::vector<AvroField> fields;
+    std::vector<std::string> symbols;
+    std::vector<const AvroNode *> branches;
+    /// Items of an array, values of a map
+    const AvroNode *items = nullptr;
+    /// Size of a fixed
+    size_t size = 0;
+
+    /**
+     * @brief The index of a record's field.
+     */
+    std::optional<size_t> findField(std::string_view name) const;
+
+    /**
+     * @brief The non-null branch of a ["null", T] or [T, "null"] union, or this node.
+     */
+    const AvroNode &nonNull() const;
+};
+
+class AvroSchema
+{
+public:
+    /**
+     * @throws AvroException for malformed schemas and unknown type names
+     */
+    static AvroSchema parse(std::string_view json);
+
+    const AvroNode &root() const noexcept { return *root_; }
+    const std::string &json() const noexcept { return json_; }
+
+private:
+    const AvroNode *parseNode(const VariantView &json, const std::string &namespace_name);
+    AvroNode *addNode(AvroType type);
+    AvroNode *addNamed(AvroType type, const VariantView &json, const std::string &namespace_name);
+
+    std::string json_;
+    std::vector<std::unique_ptr<AvroNode>> nodes_;
+    std::vector<std::pair<std::string, const AvroNode *>> names_;
+    const AvroNode *root_ = nullptr;
+};
+
+/**
+ * @brief Reads binary encoded values from a buffer that must outlive it. Strings and
+ * bytes are returned as views into the buffer.
+ * @throws AvroException when a value runs past the end or is malformed
+ */
+class AvroDecoder
+{
+public:
+    AvroDecoder() = default;
+    AvroDecoder(const uint8_t *data, size_t size) : data_(data), end_(data + size) {}
+
+    size_t remaining() const noexcept { return static_cast<size_t>(end_ - data_); }
+
+    bool readBool()
+    {
+        need(1);
+        return *data_++ != 0;
+    }
+
+    int64_t readLong()
+    {
+        uint64_t value = 0;
+        for (int shift = 0;; shift += 7)
+        {
+            if (shift > 63)
+            {
+                throw AvroException("Avro varint is too long");
+            }
+            need(1);
+            uint8_t byte = *data_++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                break;
+            }
+        }
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    int32_t readInt()
+    {
+        int64_t value = readLong();
+        if (value < INT32_MIN || value > INT32_MAX)
+        {
+            throw AvroException("Avro int out of range");
+        }
+        return static_cast<int32_t>(value);
+    }
+
+    float readFloat()
+    {
+        float value;
+        std::memcpy(&value, readFixed(4).data(), 4);
+        return value;
+    }
+
+    double readDouble()
+    {
+        double value;
+        std::memcpy(&value, readFixed(8).data(), 8);
+        return value;
+    }
+
+    std::string_view readBytes()
+    {
+        int64_t size = readLong();
+        if (size < 0)
+        {
+            throw AvroException("Negative Avro length");
+        }
+        return readFixed(static_cast<size_t>(size));
+    }
+
+    std::string_view readString() { return readBytes(); }
+
+    std::string_view readFixed(size_t size)
+    {
+        need(size);
+        std::string_view value(reinterpret_cast<const char *>(data_), size);
+        data_ += size;
+        return value;
+    }
+
+    /**
+     * @brief The index of a union's branch.
+     */
+    size_t readUnionIndex(const AvroNode &node)
+    {
+        int64_t index = readLong();
+        if (index < 0 || static_cast<size_t>(index) >= node.branches.size())
+        {
+            throw AvroException("Avro union branch out of range");
+        }
+        return static_cast<size_t>(index);
+    }
+
+    /**
+     * @brief The number of items in the next block of an array or map, 0 after the last.
+     */
+    size_t readBlockCount()
+    {
+        int64_t count = readLong();
+        if (count < 0)
+        {
+            readLong(); // byte size of the block
+            count = -count;
+        }
+        return static_cast<size_t>(count);
+    }
+
+    /**
+     * @brief Skips a value of type `node`.
+     */
+    void skip(const AvroNode &node);
+
+private:
+    void need(size_t size) const
+    {
+        if (static_cast<size_t>(end_ - data_) < size)
+        {
+            throw AvroException("Truncated Avro data");
+        }
+    }
+
+    const uint8_t *data_ = nullptr;
+    const uint8_t *end_ = nullptr;
+};
+
+/**
+ * @brief Appends binary encoded values to a buffer. Arrays and maps are written as one
+ * block: writeBlockCount(n), the n items, writeBlockCount(0).
+ */
+class AvroEncoder
+{
+public:
+    void writeBool(bool value) { data_.push_back(value ? 1 : 0); }
+
+    void writeLong(int64_t value)
+    {
+        uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        while (zigzag >= 0x80)
+        {
+            data_.push_back(static_cast<uint8_t>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        data_.push_back(static_cast<uint8_t>(zigzag));
+    }
+
+    void writeInt(int32_t value) { writeLong(value); }
+
+    void writeFloat(float value)
+    {
+        auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+        data_.insert(data_.end(), bytes, bytes + 4);
+    }
+
+    void writeDouble(double value)
+    {
+        auto *bytes = reinterpret_cast<const uint8_t *>(&value);
+        data_.insert(data_.end(), bytes, bytes + 8);
+    }
+
+    void writeBytes(std::string_view value)
+    {
+        writeLong(static_cast<int64_t>(value.size()));
+        writeFixed(value);
+    }
+
+    void writeString(std::string_view value) { writeBytes(value); }
+    void writeFixed(std::string_view value) { data_.insert(data_.end(), value.begin(), value.end()); }
+    void writeUnionIndex(size_t index) { writeLong(static_cast<int64_t>(index)); }
+    void writeBlockCount(size_t count) { writeLong(static_cast<int64_t>(count)); }
+
+    std::vector<uint8_t> &data() noexcept { return data_; }
+    const std::vector<uint8_t> &data() const noexcept { return data_; }
+    void clear() noexcept { data_.clear(); }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+/**
+ * @brief Decodes a value of type `node` into `out`: records and maps become objects, arrays
+ * arrays, enums strings, bytes and fixed binary, unions the value of their branch, and
+ * the "date" and "timestamp-micros" logical types dates and timestamps.
+ */
+void appendAvroValue(const AvroNode &node, AvroDecoder &decoder, VariantBuilder &out);
+
+/**
+ * @brief Reads the blocks of an object container file, which is read into memory whole.
+ */
+class AvroFileReader
+{
+public:
+    /**
+     * @throws AvroException if the file is not an Avro file, or uses an unsupported codec
+     * @throws std::system_error on I/O errors
+     */
+    explicit AvroFileReader(const RandomAccessFile &file);
+    explicit AvroFileReader(std::vector<uint8_t> data);
+
+    const AvroSchema &schema() const noexcept { return schema_; }
+
+    /**
+     * @brief The value of a file metadata entry, e.g. "avro.codec".
+     */
+    std::optional<std::string_view> metadata(std::string_view key) const;
+
+    /**
+     * @brief Points `records` at the records of the next block.
+     * @param count Receives the number of records in the block
+     * @return false after the last block
+     * @throws AvroException for corrupt blocks
+     */
+    bool nextBlock(AvroDecoder &records, size_t &count);
+
+private:
+    void readHeader();
+
+    std::vector<uint8_t> data_;
+    size_t offset_ = 0;
+    std::vector<std::pair<std::string, std::string>> metadata_;
+    AvroSchema schema_;
+    std::string codec_;
+    uint8_t sync_[16] = {};
+    std::vector<uint8_t> block_;
+};
+
+enum class AvroCodec
+{
+    NULL_CODEC,
+    SNAPPY
+};
+
+/**
+ * @brief Writes an object container file. Each record is encoded into encoder() by the
+ * caller, in schema order, and ended with endRecord(); blocks are written once they
+ * reach block_size bytes.
+ */
+class AvroFileWriter
+{
+public:
+    /**
+     * @param metadata Extra file metadata entries
+     * @throws AvroException if the schema is malformed
+     * @throws std::system_error if the file cannot be created
+     */
+    AvroFileWriter(const std::string &path, std::string_view schema,
+                   const std::vector<std::pair<std::string, std::string>> &metadata = {},
+                   AvroCodec codec = AvroCodec::NULL_CODEC, size_t block_size = 64 * 1024);
+
+    /**
+     * @brief Closes the file if close() was not called; errors are ignored.
+     */
+    ~AvroFileWriter();
+
+    AvroFileWriter(const AvroFileWriter &) = delete;
+    AvroFileWriter &operator=(const AvroFileWriter &) = delete;
+
+    const AvroSchema &schema() const noexcept { return schema_; }
+    AvroEncoder &encoder() noexcept { return records_; }
+
+    void endRecord();
+
+    /**
+     * @brief Writes the last block and closes the file.
+     * @throws std::system_error on I/O errors
+     */
+    void close();
+
+    /// Bytes written so far, the file size after close()
+    uint64_t size() const noexcept { return offset_; }
+
+    uint64_t recordCount() const noexcept { return records_written_ + block_records_; }
+
+private:
+    void writeBlock();
+    void write(const uint8_t *data, size_t size);
+
+    std::string path_;
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    AvroSchema schema_;
+    AvroCodec codec_;
+    size_t block_size_;
+    uint8_t sync_[16] = {};
+    AvroEncoder records_;
+    std::vector<uint8_t> compressed_;
+    size_t block_records_ = 0;
+    uint64_t records_written_ = 0;
+};
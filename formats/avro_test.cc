@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "avro.hpp"
+
+namespace
+{
+    std::string tempPath(const std::string &name)
+    {
+        return testing::TempDir() + "/" + name;
+    }
+
+    constexpr std::string_view kSchema = R"({
+        "type": "record", "name": "event", "namespace": "test",
+        "fields": [
+            {"name": "id", "type": "long", "field-id": 1},
+            {"name": "name", "type": ["null", "string"], "default": null, "field-id": 2},
+            {"name": "day", "type": {"type": "int", "logicalType": "date"}, "field-id": 3},
+            {"name": "kind", "type": {"type": "enum", "name": "kind", "symbols": ["A", "B"]}},
+            {"name": "tags", "type": {"type": "array", "items": "string"}},
+            {"name": "attributes", "type": {"type": "map", "values": "double"}},
+            {"name": "point", "type": {"type": "record", "name": "point",
+                                       "fields": [{"name": "x", "type": "float"}, {"name": "y", "type": "float"}]}},
+            {"name": "origin", "type": ["null", "test.point"]},
+            {"name": "ok", "type": "boolean"}
+        ]
+    })";
+
+    void writeEvent(AvroEncoder &out, int64_t id)
+    {
+        out.writeLong(id);
+        if (id % 2 == 0)
+        {
+            out.writeUnionIndex(1);
+            out.writeString("event " + std::to_string(id));
+        }
+        else
+        {
+            out.writeUnionIndex(0);
+        }
+        out.writeInt(19000 + static_cast<int32_t>(id));
+        out.writeLong(id % 2);
+        out.writeBlockCount(2);
+        out.writeString("a");
+        out.writeString("b");
+        out.writeBlockCount(0);
+        out.writeBlockCount(1);
+        out.writeString("weight");
+        out.writeDouble(0.5);
+        out.writeBlockCount(0);
+        out.writeFloat(1);
+        out.writeFloat(-2);
+        out.writeUnionIndex(0);
+        out.writeBool(id == 0);
+    }
+} // namespace
+
+TEST(AvroTest, EncodesPrimitives)
+{
+    AvroEncoder out;
+    const int64_t longs[] = {0, -1, 1, -64, 64, std::numeric_limits<int64_t>::min(),
+                             std::numeric_limits<int64_t>::max()};
+    for (int64_t value : longs)
+    {
+        out.writeLong(value);
+    }
+    out.writeDouble(-0.25);
+    out.writeString("héllo");
+    out.writeBool(true);
+    // Zigzag: 0 -> 00, -1 -> 01, 1 -> 02, -64 -> 7f, 64 -> 80 01
+    EXPECT_EQ(std::vector<uint8_t>(out.data().begin(), out.data().begin() + 6),
+              (std::vector<uint8_t>{0x00, 0x01, 0x02, 0x7f, 0x80, 0x01}));
+
+    AvroDecoder in(out.data().data(), out.data().size());
+    for (int64_t value : longs)
+    {
+        EXPECT_EQ(in.readLong(), value);
+    }
+    EXPECT_EQ(in.readDouble(), -0.25);
+    EXPECT_EQ(in.readString(), "héllo");
+    EXPECT_TRUE(in.readBool());
+    EXPECT_EQ(in.remaining(), 0u);
+    EXPECT_THROW(in.readLong(), AvroException);
+
+    AvroEncoder big;
+    big.writeLong(int64_t{1} << 40);
+    AvroDecoder narrow(big.data().data(), big.data().size());
+    EXPECT_THROW(narrow.readInt(), AvroException);
+}
+
+TEST(AvroTest, ParsesSchemas)
+{
+    AvroSchema schema = AvroSchema::parse(kSchema);
+    const AvroNode &root = schema.root();
+    EXPECT_EQ(root.type, AvroType::RECORD);
+    EXPECT_EQ(root.name, "test.event");
+    ASSERT_EQ(root.fields.size(), 9u);
+    EXPECT_EQ(root.fields[0].field_id, 1);
+    EXPECT_FALSE(root.fields[3].field_id);
+    EXPECT_EQ(root.fields[1].type->type, AvroType::UNION);
+    EXPECT_EQ(root.fields[1].type->nonNull().type, AvroType::STRING);
+    EXPECT_EQ(root.fields[2].type->logical_type, "date");
+    EXPECT_EQ(root.fields[3].type->symbols, (std::vector<std::string>{"A", "B"}));
+    // The named record is shared by its reference
+    EXPECT_EQ(&root.fields[7].type->nonNull(), root.fields[6].type);
+    EXPECT_EQ(root.findField("ok"), 8u);
+    EXPECT_FALSE(root.findField("missing"));
+
+    EXPECT_THROW(AvroSchema::parse(R"({"type": "record", "name": "r", "fields": [{"name": "a", "type": "nope"}]})"),
+                 AvroException);
+    EXPECT_THROW(AvroSchema::parse(R"({"type": "fixed", "name": "f"})"), AvroException);
+    EXPECT_THROW(AvroSchema::parse("{"), AvroException);
+}
+
+TEST(AvroTest, RoundTripsContainerFiles)
+{
+    for (AvroCodec codec : {AvroCodec::NULL_CODEC, AvroCodec::SNAPPY})
+    {
+        std::string path = tempPath("events.avro");
+        {
+            // Small blocks, so the records span several of them
+            AvroFileWriter writer(path, kSchema, {{"iceberg.schema", "{}"}}, codec, 256);
+            for (int64_t id = 0; id < 100; ++id)
+            {
+                writeEvent(writer.encoder(), id);
+                writer.endRecord();
+            }
+            EXPECT_EQ(writer.recordCount(), 100u);
+            writer.close();
+        }
+
+        LocalFile file(path);
+        AvroFileReader reader(file);
+        EXPECT_EQ(reader.metadata("avro.codec"), codec == AvroCodec::SNAPPY ? "snappy" : "null");
+        EXPECT_EQ(reader.metadata("iceberg.schema"), "{}");
+        EXPECT_FALSE(reader.metadata("missing"));
+
+        AvroDecoder records;
+        size_t count = 0;
+        size_t blocks = 0;
+        int64_t next = 0;
+        while (reader.nextBlock(records, count))
+        {
+            ++blocks;
+            for (size_t i = 0; i < count; ++i, ++next)
+            {
+                if (next == 2)
+                {
+                    VariantBuilder builder;
+                    appendAvroValue(reader.schema().root(), records, builder);
+                    EXPECT_EQ(builder.finish().view().toJson(),
+                              R"({"attributes":{"weight":0.5},"day":"2022-01-10","id":2,"kind":"A","name":"event 2",)"
+                              R"("ok":false,"origin":null,"point":{"x":1.0,"y":-2.0},"tags":["a","b"]})");
+                    continue;
+                }
+                // Skipping must land on the next record
+                for (const AvroField &field : reader.schema().root().fields)
+                {
+                    if (field.name == "id")
+                    {
+                        EXPECT_EQ(records.readLong(), next);
+                    }
+                    else
+                    {
+                        records.skip(*field.type);
+                    }
+                }
+            }
+            EXPECT_EQ(records.remaining(), 0u);
+        }
+        EXPECT_EQ(next, 100);
+        EXPECT_GT(blocks, 1u);
+    }
+}
+
+TEST(AvroTest, RejectsCorruptFiles)
+{
+    std::string path = tempPath("corrupt.avro");
+    {
+        AvroFileWriter writer(path, R"("long")", {}, AvroCodec::SNAPPY);
+        writer.encoder().writeLong(42);
+        writer.endRecord();
+        writer.close();
+    }
+    LocalFile file(path);
+    std::vector<uint8_t> data(file.size());
+    file.readAt(0, data.size(), data.data());
+
+    AvroDecoder records;
+    size_t count = 0;
+    AvroFileReader valid(data);
+    ASSERT_TRUE(valid.nextBlock(records, count));
+    EXPECT_EQ(records.readLong(), 42);
+    EXPECT_FALSE(valid.nextBlock(records, count));
+
+    std::vector<uint8_t> bad_magic = data;
+    bad_magic[0] = 'X';
+    EXPECT_THROW(AvroFileReader{bad_magic}, AvroException);
+
+    std::vector<uint8_t> bad_sync = data;
+    bad_sync.back() ^= 1;
+    AvroFileReader sync_reader(bad_sync);
+    EXPECT_THROW(sync_reader.nextBlock(records, count), AvroException);
+
+    std::vector<uint8_t> truncated(data.begin(), data.end() - 20);
+    AvroFileReader truncated_reader(truncated);
+    EXPECT_THROW(truncated_reader.nextBlock(records, count), AvroException);
+}
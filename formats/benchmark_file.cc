@@ -0,0 +1,79 @@
+#include "benchmark_file.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+#include <utility>
+
+#include "basics/benchmark_data.h"
+#include "parquet_writer.hpp"
+
+BenchmarkFile::BenchmarkFile(const std::string &name, size_t rows)
+    : path_("/tmp/" + name + "_" + std::to_string(::getpid()) + ".parquet")
+{
+    constexpr size_t kRowGroupRows = 128 * 1024;
+    std::vector<ColumnDescriptor> columns(6);
+    const std::pair<const char *, AtomicType> fields[] = {
+        {"id", AtomicType::INT64},       {"key", AtomicType::INT64},       {"price", AtomicType::DOUBLE},
+        {"quantity", AtomicType::INT32}, {"name", AtomicType::BYTE_ARRAY}, {"url", AtomicType::BYTE_ARRAY},
+    };
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        columns[i].path = {fields[i].first};
+        columns[i].type = fields[i].second;
+    }
+    columns[4].max_definition_level = 1;
+    WriterOptions options;
+    options.codec = CompressionCodec::SNAPPY;
+    options.column_encodings = {{"quantity", Encoding::RLE_DICTIONARY}, {"name", Encoding::RLE_DICTIONARY}};
+    ParquetFileWriter writer(path_, columns, options);
+
+    ids_ = ascendingIntegers(rows, 10, 1);
+    std::vector<uint64_t> keys = uniformIntegers(rows, rows, 2);
+    std::vector<uint64_t> cents = uniformIntegers(rows, 100000, 3);
+    std::vector<uint64_t> quantities = uniformIntegers(rows, 100, 4);
+    std::vector<std::string> names = randomStrings(rows, 1000, 8, 24, 5);
+    std::vector<uint64_t> nulls = uniformIntegers(rows, 10, 6);
+    std::vector<std::string> urls = urlStrings(rows);
+    for (size_t first = 0; first < rows; first += kRowGroupRows)
+    {
+        size_t count = std::min(kRowGroupRows, rows - first);
+        std::vector<ColumnBatch> batches;
+        for (const ColumnDescriptor &column : columns)
+        {
+            batches.emplace_back(column.type);
+        }
+        std::copy_n(ids_.begin() + first, count, batches[0].appendValues<int64_t>(count));
+        int64_t *key = batches[1].appendValues<int64_t>(count);
+        double *price = batches[2].appendValues<double>(count);
+        int32_t *quantity = batches[3].appendValues<int32_t>(count);
+        for (size_t i = first; i < first + count; ++i)
+        {
+            key[i - first] = static_cast<int64_t>(keys[i]);
+            price[i - first] = static_cast<double>(cents[i]) / 100;
+            quantity[i - first] = static_cast<int32_t>(quantities[i]);
+            if (nulls[i] == 0)
+            {
+                batches[4].appendNulls(1);
+            }
+            else
+            {
+                batches[4].appendByteArray(reinterpret_cast<const uint8_t *>(names[i].data()), names[i].size());
+            }
+            batches[5].appendByteArray(reinterpret_cast<const uint8_t *>(urls[i].data()), urls[i].size());
+        }
+        std::vector<const ColumnBatch *> pointers;
+        for (const ColumnBatch &batch : batches)
+        {
+            pointers.push_back(&batch);
+        }
+        writer.writeRowGroup(pointers);
+    }
+    writer.close();
+}
+
+BenchmarkFile::~BenchmarkFile()
+{
+    std::remove(path_.c_str());
+    std::remove(output().c_str());
+}
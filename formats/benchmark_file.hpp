@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The Parquet file the scan and rewrite benchmarks share: `rows` rows in row groups
+ * of 128K rows with Snappy compression, generated from basics/benchmark_data.h. The columns:
+ * - id: ascending INT64 with steps below 10
+ * - key: uniform INT64 in [0, rows)
+ * - price: DOUBLE with two decimals in [0, 1000)
+ * - quantity: INT32 drawn from 100 values, dictionary encoded
+ * - name: optional BYTE_ARRAY, 10% nulls, 1000 distinct strings, dictionary encoded
+ * - url: plain BYTE_ARRAY, ascending with a long shared prefix
+ *
+ * Written to /tmp under the benchmark's name and the process id; the destructor removes
+ * it along with output().
+ */
+class BenchmarkFile
+{
+public:
+    BenchmarkFile(const std::string &name, size_t rows);
+    ~BenchmarkFile();
+
+    BenchmarkFile(const BenchmarkFile &) = delete;
+    BenchmarkFile &operator=(const BenchmarkFile &) = delete;
+
+    const std::string &path() const { return path_; }
+
+    /// Where benchmarks writing a file derived from this one put it
+    std::string output() const { return path_ + ".out"; }
+
+    size_t rows() const { return ids_.size(); }
+
+    /// The id column
+    const std::vector<int64_t> &ids() const { return ids_; }
+
+private:
+    std::string path_;
+    std::vector<int64_t> ids_;
+};
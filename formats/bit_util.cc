@@ -0,0 +1,197 @@
+#include "bit_util.hpp"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace bit_util
+{
+    void unpack32(const uint8_t *data, const uint8_t *end, size_t first, size_t count, int bit_width,
+                  uint32_t *out) noexcept
+    {
+        if (bit_width == 0)
+        {
+            std::memset(out, 0, count * sizeof(uint32_t));
+            return;
+        }
+        const uint64_t mask = (uint64_t{1} << bit_width) - 1;
+        size_t bit = first * static_cast<size_t>(bit_width);
+        for (size_t i = 0; i < count; ++i, bit += bit_width)
+        {
+            // bit % 8 + bit_width <= 39, so a single 64 bit load always covers the value
+            uint64_t word = loadWord(data + (bit >> 3), end);
+            out[i] = static_cast<uint32_t>((word >> (bit & 7)) & mask);
+        }
+    }
+
+    void unpack64(const uint8_t *data, const uint8_t *end, size_t first, size_t count, int bit_width,
+                  uint64_t *out) noexcept
+    {
+        if (bit_width == 0)
+        {
+            std::memset(out, 0, count * sizeof(uint64_t));
+            return;
+        }
+        const uint64_t mask = bit_width == 64 ? ~uint64_t{0} : (uint64_t{1} << bit_width) - 1;
+        size_t bit = first * static_cast<size_t>(bit_width);
+        for (size_t i = 0; i < count; ++i, bit += bit_width)
+        {
+            const uint8_t *p = data + (bit >> 3);
+            int shift = static_cast<int>(bit & 7);
+            uint64_t value = loadWord(p, end) >> shift;
+            if (shift + bit_width > 64 && p + 8 < end)
+            {
+                value |= static_cast<uint64_t>(p[8]) << (64 - shift);
+            }
+            out[i] = value & mask;
+        }
+    }
+
+    void pack64(const uint64_t *values, size_t count, int bit_width, uint8_t *out) noexcept
+    {
+        if (bit_width == 0)
+        {
+            return;
+        }
+        const uint64_t mask = bit_width == 64 ? ~uint64_t{0} : (uint64_t{1} << bit_width) - 1;
+        size_t bit = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint64_t value = values[i] & mask;
+            int remaining = bit_width;
+            while (remaining > 0)
+            {
+                int shift = static_cast<int>(bit & 7);
+                out[bit >> 3] |= static_cast<uint8_t>(value << shift);
+                int written = 8 - shift < remaining ? 8 - shift : remaining;
+                value >>= written;
+                bit += written;
+                remaining -= written;
+            }
+        }
+    }
+
+    size_t levelsToBitmap(const int16_t *levels, size_t count, int16_t max_level, uint8_t *bitmap,
+                          size_t bit_offset) noexcept
+    {
+        size_t valid = 0;
+        size_t i = 0;
+
+        // Scalar prologue until the output is byte aligned
+        for (; i < count && ((bit_offset + i) & 7) != 0; ++i)
+        {
+            bool is_valid = levels[i] == max_level;
+            setBitTo(bitmap, bit_offset + i, is_valid);
+            valid += is_valid;
+        }
+
+#if defined(__SSE2__)
+        const __m128i max_levels = _mm_set1_epi16(max_level);
+        for (; i + 16 <= count; i += 16)
+        {
+            __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(levels + i));
+            __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(levels + i + 8));
+            // Equal lanes become 0xffff, the saturating pack turns them into 0xff bytes
+            __m128i packed = _mm_packs_epi16(_mm_cmpeq_epi16(lo, max_levels), _mm_cmpeq_epi16(hi, max_levels));
+            auto mask = static_cast<uint16_t>(_mm_movemask_epi8(packed));
+            std::memcpy(bitmap + ((bit_offset + i) >> 3), &mask, sizeof(mask));
+            valid += static_cast<size_t>(__builtin_popcount(mask));
+        }
+#endif
+
+        for (; i + 8 <= count; i += 8)
+        {
+            uint8_t byte = 0;
+            for (int j = 0; j < 8; ++j)
+            {
+                byte |= static_cast<uint8_t>((levels[i + j] == max_level) << j);
+            }
+            bitmap[(bit_offset + i) >> 3] = byte;
+            valid += static_cast<size_t>(__builtin_popcount(byte));
+        }
+
+        for (; i < count; ++i)
+        {
+            bool is_valid = levels[i] == max_level;
+            setBitTo(bitmap, bit_offset + i, is_valid);
+            valid += is_valid;
+        }
+        return valid;
+    }
+
+    void unpackBits(const uint8_t *bits, size_t bit_offset, size_t count, uint8_t *out) noexcept
+    {
+        size_t i = 0;
+        for (; i < count && ((bit_offset + i) & 7) != 0; ++i)
+        {
+            out[i] = getBit(bits, bit_offset + i);
+        }
+        const uint8_t *bytes = bits + ((bit_offset + i) >> 3);
+        // Byte k of the multiplied word is a copy of the input byte, masking keeps its bit k
+        constexpr uint64_t kBroadcast = 0x0101010101010101;
+        constexpr uint64_t kBitOfByte = 0x8040201008040201;
+
+#if defined(__SSE2__)
+        const __m128i bit_of_byte = _mm_set1_epi64x(static_cast<long long>(kBitOfByte));
+        const __m128i ones = _mm_set1_epi8(1);
+        for (; i + 16 <= count; i += 16, bytes += 2)
+        {
+            __m128i spread = _mm_set_epi64x(static_cast<long long>(bytes[1] * kBroadcast),
+                                            static_cast<long long>(bytes[0] * kBroadcast));
+            __m128i set = _mm_cmpeq_epi8(_mm_and_si128(spread, bit_of_byte), bit_of_byte);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_and_si128(set, ones));
+        }
+#endif
+
+        for (; i + 8 <= count; i += 8, ++bytes)
+        {
+            // Adding 0x7f carries into bit 7 of every byte that kept its bit, and never
+            // past it
+            uint64_t word = ((((*bytes * kBroadcast) & kBitOfByte) + 0x7f7f7f7f7f7f7f7f) >> 7) & kBroadcast;
+            std::memcpy(out + i, &word, sizeof(word));
+        }
+
+        for (; i < count; ++i)
+        {
+            out[i] = getBit(bits, bit_offset + i);
+        }
+    }
+
+    size_t countSetBits(const uint8_t *bitmap, size_t bit_offset, size_t count) noexcept
+    {
+        size_t set = 0;
+        size_t i = 0;
+        for (; i < count && ((bit_offset + i) & 7) != 0; ++i)
+        {
+            set += getBit(bitmap, bit_offset + i);
+        }
+        const uint8_t *bytes = bitmap + ((bit_offset + i) >> 3);
+        for (; i + 64 <= count; i += 64, bytes += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes, sizeof(word));
+            set += static_cast<size_t>(__builtin_popcountll(word));
+        }
+        for (; i < count; ++i)
+        {
+            set += getBit(bitmap, bit_offset + i);
+        }
+        return set;
+    }
+
+    void setBitsTo(uint8_t *bitmap, size_t bit_offset, size_t count, bool value) noexcept
+    {
+        size_t i = 0;
+        for (; i < count && ((bit_offset + i) & 7) != 0; ++i)
+        {
+            setBitTo(bitmap, bit_offset + i, value);
+        }
+        size_t whole_bytes = (count - i) / 8;
+        std::memset(bitmap + ((bit_offset + i) >> 3), value ? 0xff : 0, whole_bytes);
+        i += whole_bytes * 8;
+        for (; i < count; ++i)
+        {
+            setBitTo(bitmap, bit_offset + i, value);
+        }
+    }
+} // namespace bit_util
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "parquet.hpp"
+
+// Low level helpers shared by the encoders and decoders: variable length integers,
+// zigzag encoding, bit unpacking and validity bitmaps.
+//
+// Bitmaps use the Arrow bit order: bit i lives in byte i / 8 at position i % 8
+// (least significant bit first), which is also the order used by Parquet bit packing.
+
+namespace bit_util
+{
+    inline bool getBit(const uint8_t *bits, size_t i) noexcept
+    {
+        return (bits[i >> 3] >> (i & 7)) & 1;
+    }
+
+    inline void setBit(uint8_t *bits, size_t i) noexcept
+    {
+        bits[i >> 3] |= static_cast<uint8_t>(1u << (i & 7));
+    }
+
+    inline void clearBit(uint8_t *bits, size_t i) noexcept
+    {
+        bits[i >> 3] &= static_cast<uint8_t>(~(1u << (i & 7)));
+    }
+
+    inline void setBitTo(uint8_t *bits, size_t i, bool value) noexcept
+    {
+        if (value)
+        {
+            setBit(bits, i);
+        }
+        else
+        {
+            clearBit(bits, i);
+        }
+    }
+
+    inline size_t bytesForBits(size_t bits) noexcept
+    {
+        return (bits + 7) / 8;
+    }
+
+    /**
+     * @brief Reads an unsigned LEB128 varint and advances `data`.
+     * @throws ParquetException if the varint is truncated or longer than 10 bytes
+     */
+    inline uint64_t readUleb128(const uint8_t *&data, const uint8_t *end)
+    {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 70; shift += 7)
+        {
+            if (data >= end)
+            {
+                throw ParquetException("Truncated varint");
+            }
+            uint8_t byte = *data++;
+            result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return result;
+            }
+        }
+        throw ParquetException("Varint is too long");
+    }
+
+    /**
+     * @brief Writes `value` as an unsigned LEB128 varint and returns the number of bytes written.
+     * `out` must have room for at least 10 bytes.
+     */
+    inline size_t writeUleb128(uint64_t value, uint8_t *out) noexcept
+    {
+        size_t i = 0;
+        while (value >= 0x80)
+        {
+            out[i++] = static_cast<uint8_t>(value | 0x80);
+            value >>= 7;
+        }
+        out[i++] = static_cast<uint8_t>(value);
+        return i;
+    }
+
+    inline uint64_t zigzagEncode(int64_t value) noexcept
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    inline int64_t zigzagDecode(uint64_t value) noexcept
+    {
+        return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    /**
+     * @brief Loads up to 8 bytes as a little endian word without reading past `end`.
+     */
+    inline uint64_t loadWord(const uint8_t *data, const uint8_t *end) noexcept
+    {
+        uint64_t word = 0;
+        if (end - data >= 8)
+        {
+            std::memcpy(&word, data, 8);
+        }
+        else if (end > data)
+        {
+            std::memcpy(&word, data, static_cast<size_t>(end - data));
+        }
+        return word;
+    }
+
+    /**
+     * @brief Unpacks `count` values of `bit_width` bits (at most 32), starting at value
+     * index `first`, from an LSB-first bit packed buffer.
+     *
+     * The caller must make sure the buffer holds at least (first + count) * bit_width bits.
+     */
+    void unpack32(const uint8_t *data, const uint8_t *end, size_t first, size_t count, int bit_width,
+                  uint32_t *out) noexcept;
+
+    /**
+     * @brief Same as unpack32, for bit widths up to 64.
+     */
+    void unpack64(const uint8_t *data, const uint8_t *end, size_t first, size_t count, int bit_width,
+                  uint64_t *out) noexcept;
+
+    /**
+     * @brief Packs `count` values into `out` using `bit_width` bits per value, LSB first.
+     * `out` must be zeroed and hold at least bytesForBits(count * bit_width) bytes.
+     */
+    void pack64(const uint64_t *values, size_t count, int bit_width, uint8_t *out) noexcept;
+
+    /**
+     * @brief Writes one validity bit per definition level (set when the level equals
+     * `max_level`) into `bitmap`, starting at bit `bit_offset`.
+     * @return The number of bits that were set, i.e. the number of non-null values
+     *
+     * Uses SSE2 to compare 16 levels at a time when available.
+     */
+    size_t levelsToBitmap(const int16_t *levels, size_t count, int16_t max_level, uint8_t *bitmap,
+                          size_t bit_offset) noexcept;
+
+    /**
+     * @brief Writes the bits [bit_offset, bit_offset + count) of `bits` to `out` as one
+     * byte each, 0 or 1.
+     *
+     * Uses SSE2 to expand 16 bits at a time when available.
+     */
+    void unpackBits(const uint8_t *bits, size_t bit_offset, size_t count, uint8_t *out) noexcept;
+
+    /**
+     * @brief Counts the set bits in [bit_offset, bit_offset + count).
+     */
+    size_t countSetBits(const uint8_t *bitmap, size_t bit_offset, size_t count) noexcept;
+
+    /**
+     * @brief Sets `count` bits starting at `bit_offset` to `value`.
+     */
+    void setBitsTo(uint8_t *bitmap, size_t bit_offset, size_t count, bool value) noexcept;
+
+    inline int bitWidth(uint64_t max_value) noexcept
+    {
+        return max_value == 0 ? 0 : 64 - __builtin_clzll(max_value);
+    }
+} // namespace bit_util
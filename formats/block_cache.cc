@@ -0,0 +1,159 @@
+#include "block_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "instrumentation.hpp"
+#include "parquet.hpp"
+
+namespace
+{
+    size_t blockSizeOrThrow(size_t block_size)
+    {
+        if (block_size == 0)
+        {
+            throw std::invalid_argument("Block size must not be zero");
+        }
+        return block_size;
+    }
+} // namespace
+
+BlockCache::BlockCache(size_t capacity, size_t block_size)
+    : capacity_(capacity), block_size_(blockSizeOrThrow(block_size)),
+      blocks_(capacity, std::clamp<size_t>(capacity / block_size / 64, 1, 16))
+{
+}
+
+bool BlockCache::lookup(const std::string &file, uint64_t block, Slice &out)
+{
+    auto handle = blocks_.lookup(Key{file, block});
+    if (!handle)
+    {
+        FORMATS_COUNT(BLOCK_CACHE_MISSES, 1);
+        return false;
+    }
+    FORMATS_COUNT(BLOCK_CACHE_HITS, 1);
+    out = *handle;
+    return true;
+}
+
+void BlockCache::insert(const std::string &file, uint64_t block, Slice bytes)
+{
+    size_t size = bytes.size;
+    blocks_.insert(Key{file, block}, std::move(bytes), size);
+}
+
+BlockCacheStats BlockCache::stats() const
+{
+    CacheStats cache = blocks_.stats();
+    BlockCacheStats stats;
+    stats.hits = cache.hits;
+    stats.misses = cache.misses;
+    stats.evictions = cache.evictions;
+    stats.bytes = cache.bytes;
+    return stats;
+}
+
+CachedFile::CachedFile(std::shared_ptr<const RandomAccessFile> file, std::shared_ptr<BlockCache> cache)
+    : RandomAccessFile(file->path()), file_(std::move(file)), cache_(std::move(cache)), size_(file_->size())
+{
+    // The size guards against rewrites on backends without a version
+    key_ = path() + '\0' + file_->version() + '\0' + std::to_string(size_);
+}
+
+CachedFile::Blocks CachedFile::start(ReadRange range) const
+{
+    if (range.end() > size_ || range.end() < range.offset)
+    {
+        throw ParquetException("Unexpected end of " + path());
+    }
+    size_t block_size = cache_->blockSize();
+    Blocks blocks;
+    blocks.first_block = range.offset / block_size;
+    if (range.length == 0)
+    {
+        return blocks;
+    }
+    uint64_t last_block = (range.end() - 1) / block_size;
+    blocks.slices.resize(static_cast<size_t>(last_block - blocks.first_block + 1));
+    for (uint64_t block = blocks.first_block; block <= last_block; ++block)
+    {
+        if (cache_->lookup(key_, block, blocks.slices[block - blocks.first_block]))
+        {
+            continue;
+        }
+        if (!blocks.fetches.empty() && blocks.fetches.back().first_block + blocks.fetches.back().count == block)
+        {
+            ++blocks.fetches.back().count;
+        }
+        else
+        {
+            blocks.fetches.push_back({block, 1, {}});
+        }
+    }
+    for (Fetch &fetch : blocks.fetches)
+    {
+        uint64_t offset = fetch.first_block * block_size;
+        uint64_t end = std::min<uint64_t>((fetch.first_block + fetch.count) * block_size, size_);
+        fetch.bytes = file_->readAsync({offset, static_cast<size_t>(end - offset)});
+    }
+    return blocks;
+}
+
+void CachedFile::finish(Blocks &blocks) const
+{
+    size_t block_size = cache_->blockSize();
+    for (Fetch &fetch : blocks.fetches)
+    {
+        Slice bytes = fetch.bytes.get();
+        for (size_t i = 0; i < fetch.count; ++i)
+        {
+            size_t offset = i * block_size;
+            Slice block = bytes.sub(offset, std::min(block_size, bytes.size - offset));
+            cache_->insert(key_, fetch.first_block + i, block);
+            blocks.slices[fetch.first_block + i - blocks.first_block] = std::move(block);
+        }
+    }
+    blocks.fetches.clear();
+}
+
+void CachedFile::copy(const Blocks &blocks, ReadRange range, uint8_t *out) const
+{
+    size_t block_size = cache_->blockSize();
+    uint64_t offset = range.offset;
+    while (offset < range.end())
+    {
+        uint64_t block = offset / block_size;
+        const Slice &slice = blocks.slices[block - blocks.first_block];
+        size_t within = static_cast<size_t>(offset - block * block_size);
+        size_t n = static_cast<size_t>(std::min<uint64_t>(slice.size - within, range.end() - offset));
+        std::memcpy(out, slice.data + within, n);
+        out += n;
+        offset += n;
+    }
+}
+
+void CachedFile::readAt(uint64_t offset, size_t size, uint8_t *out) const
+{
+    ReadRange range{offset, size};
+    Blocks blocks = start(range);
+    finish(blocks);
+    copy(blocks, range, out);
+}
+
+std::future<Slice> CachedFile::readAsync(ReadRange range) const
+{
+    Blocks blocks = start(range);
+    return std::async(std::launch::deferred, [this, range, blocks = std::move(blocks)]() mutable
+                      {
+                          finish(blocks);
+                          if (blocks.slices.size() == 1)
+                          {
+                              size_t within = static_cast<size_t>(range.offset - blocks.first_block * cache_->blockSize());
+                              return blocks.slices[0].sub(within, range.length);
+                          }
+                          std::vector<uint8_t> bytes(range.length);
+                          copy(blocks, range, bytes.data());
+                          return Slice::fromVector(std::move(bytes)); });
+}
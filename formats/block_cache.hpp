@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "basics/sharded_cache.h"
+#include "io.hpp"
+
+struct BlockCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+
+    /// Bytes held by the cached blocks
+    size_t bytes = 0;
+};
+
+/**
+ * @brief LRU cache of fixed-size file blocks, shared by the files of a CachingFileSystem.
+ *
+ * Blocks are keyed by a file key (path and version) and the block index. Thread safe: a
+ * ShardedCache with one shard per 64 blocks of capacity, up to 16.
+ */
+class BlockCache
+{
+public:
+    /**
+     * @param capacity Upper bound of the cached bytes
+     * @param block_size Size of the blocks files are split into
+     * @throws std::invalid_argument for a zero block size
+     */
+    explicit BlockCache(size_t capacity, size_t block_size = 1024 * 1024);
+
+    size_t capacity() const noexcept { return capacity_; }
+    size_t blockSize() const noexcept { return block_size_; }
+
+    /**
+     * @brief Looks a block up and marks it as recently used.
+     * @return false on a miss
+     */
+    bool lookup(const std::string &file, uint64_t block, Slice &out);
+
+    /**
+     * @brief Inserts or replaces a block, evicting the least recently used blocks to make
+     * room. Blocks larger than a shard's share of the capacity are not cached.
+     */
+    void insert(const std::string &file, uint64_t block, Slice bytes);
+
+    BlockCacheStats stats() const;
+
+private:
+    struct Key
+    {
+        std::string file;
+        uint64_t block;
+
+        bool operator==(const Key &other) const { return block == other.block && file == other.file; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const noexcept
+        {
+            return std::hash<std::string>()(key.file) ^ (std::hash<uint64_t>()(key.block) * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+
+    size_t capacity_;
+    size_t block_size_;
+    ShardedCache<Key, Slice, LruPolicy, KeyHash> blocks_;
+};
+
+/**
+ * @brief A RandomAccessFile that serves reads from a BlockCache and reads only the
+ * missing blocks from the underlying file.
+ *
+ * A read is widened to whole blocks. Each run of consecutive missing blocks becomes one
+ * asynchronous read of the underlying file, so the runs of one read are fetched in
+ * parallel when the backend supports it.
+ */
+class CachedFile : public RandomAccessFile
+{
+public:
+    CachedFile(std::shared_ptr<const RandomAccessFile> file, std::shared_ptr<BlockCache> cache);
+
+    uint64_t size() const override { return size_; }
+    std::string version() const override { return file_->version(); }
+    void readAt(uint64_t offset, size_t size, uint8_t *out) const override;
+    std::future<Slice> readAsync(ReadRange range) const override;
+
+private:
+    struct Fetch
+    {
+        uint64_t first_block;
+        size_t count;
+        std::future<Slice> bytes;
+    };
+
+    struct Blocks
+    {
+        uint64_t first_block = 0;
+        std::vector<Slice> slices;
+        std::vector<Fetch> fetches;
+    };
+
+    Blocks start(ReadRange range) const;
+    void finish(Blocks &blocks) const;
+    void copy(const Blocks &blocks, ReadRange range, uint8_t *out) const;
+
+    std::shared_ptr<const RandomAccessFile> file_;
+    std::shared_ptr<BlockCache> cache_;
+    uint64_t size_;
+    std::string key_;
+};
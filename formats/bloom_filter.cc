@@ -0,0 +1,186 @@
+#include "bloom_filter.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    // Salts of the split block Bloom filter, one per word of a block
+    constexpr uint32_t kSalt[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                   0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+    inline uint64_t rotl(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t load64(const uint8_t *p)
+    {
+        uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t load32(const uint8_t *p)
+    {
+        uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint64_t round(uint64_t accumulator, uint64_t input)
+    {
+        return rotl(accumulator + input * kPrime2, 31) * kPrime1;
+    }
+
+    inline uint64_t mergeRound(uint64_t accumulator, uint64_t value)
+    {
+        return (accumulator ^ round(0, value)) * kPrime1 + kPrime4;
+    }
+
+    bool isValidSize(size_t num_bytes)
+    {
+        return num_bytes >= BloomFilter::kMinBytes && num_bytes <= BloomFilter::kMaxBytes &&
+               (num_bytes & (num_bytes - 1)) == 0;
+    }
+} // namespace
+
+uint64_t xxHash64(const uint8_t *data, size_t size)
+{
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    uint64_t hash;
+    if (size >= 32)
+    {
+        uint64_t v1 = kPrime1 + kPrime2;
+        uint64_t v2 = kPrime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - kPrime1;
+        for (; p + 32 <= end; p += 32)
+        {
+            v1 = round(v1, load64(p));
+            v2 = round(v2, load64(p + 8));
+            v3 = round(v3, load64(p + 16));
+            v4 = round(v4, load64(p + 24));
+        }
+        hash = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        hash = mergeRound(hash, v1);
+        hash = mergeRound(hash, v2);
+        hash = mergeRound(hash, v3);
+        hash = mergeRound(hash, v4);
+    }
+    else
+    {
+        hash = kPrime5;
+    }
+    hash += size;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        hash ^= round(0, load64(p));
+        hash = rotl(hash, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end)
+    {
+        hash ^= static_cast<uint64_t>(load32(p)) * kPrime1;
+        hash = rotl(hash, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+    {
+        hash ^= *p * kPrime5;
+        hash = rotl(hash, 11) * kPrime1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= kPrime2;
+    hash ^= hash >> 29;
+    hash *= kPrime3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+size_t BloomFilter::optimalNumBytes(size_t ndv, double fpp)
+{
+    if (!(fpp > 0 && fpp < 1))
+    {
+        throw std::invalid_argument("False positive probability must be in (0, 1)");
+    }
+    // m = -8 * ndv / ln(1 - fpp^(1/8)) bits, for 8 bits set per value
+    double bits = -8.0 * static_cast<double>(ndv) / std::log(1 - std::pow(fpp, 1.0 / 8));
+    size_t num_bytes = kMinBytes;
+    while (num_bytes < kMaxBytes && static_cast<double>(num_bytes) * 8 < bits)
+    {
+        num_bytes *= 2;
+    }
+    return num_bytes;
+}
+
+BloomFilter::BloomFilter(size_t num_bytes) : bitset_(num_bytes), num_blocks_(num_bytes / kBlockSize)
+{
+    if (!isValidSize(num_bytes))
+    {
+        throw std::invalid_argument("Bloom filter size must be a power of two between 32 bytes and 128MB");
+    }
+}
+
+BloomFilter::BloomFilter(std::vector<uint8_t> bitset)
+    : bitset_(std::move(bitset)), num_blocks_(bitset_.size() / kBlockSize)
+{
+    if (!isValidSize(bitset_.size()))
+    {
+        throw ParquetException("Invalid Bloom filter size " + std::to_string(bitset_.size()));
+    }
+}
+
+void BloomFilter::insert(uint64_t hash)
+{
+    uint32_t *words = block(hash);
+    auto key = static_cast<uint32_t>(hash);
+    for (int i = 0; i < 8; ++i)
+    {
+        words[i] |= uint32_t{1} << ((key * kSalt[i]) >> 27);
+    }
+}
+
+bool BloomFilter::mightContain(uint64_t hash) const
+{
+    const uint32_t *words = block(hash);
+    auto key = static_cast<uint32_t>(hash);
+    for (int i = 0; i < 8; ++i)
+    {
+        if ((words[i] & (uint32_t{1} << ((key * kSalt[i]) >> 27))) == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t BloomFilter::hash(const ColumnBatch &batch, size_t i)
+{
+    switch (batch.type())
+    {
+    case AtomicType::INT32:
+        return hash(batch.value<int32_t>(i));
+    case AtomicType::INT64:
+        return hash(batch.value<int64_t>(i));
+    case AtomicType::FLOAT:
+        return hash(batch.value<float>(i));
+    case AtomicType::DOUBLE:
+        return hash(batch.value<double>(i));
+    case AtomicType::BYTE_ARRAY:
+    case AtomicType::FIXED_LEN_BYTE_ARRAY:
+        return hash(batch.byteArray(i));
+    case AtomicType::BOOLEAN:
+        break;
+    }
+    throw std::invalid_argument("BOOLEAN columns have no Bloom filters");
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "column_batch.hpp"
+
+/**
+ * @brief XXH64 with seed 0, the hash Parquet Bloom filters use.
+ */
+uint64_t xxHash64(const uint8_t *data, size_t size);
+
+/**
+ * @brief The split block Bloom filter of the Parquet spec.
+ *
+ * The bitset is an array of 32 byte blocks of eight 32 bit words. The upper half of a
+ * value's hash picks the block, the lower half sets (or tests) one bit in each word.
+ * Values are hashed in their PLAIN encoding without length prefix, so a filter written
+ * by any implementation can be probed here.
+ */
+class BloomFilter
+{
+public:
+    static constexpr size_t kBlockSize = 32;
+    static constexpr size_t kMinBytes = kBlockSize;
+    static constexpr size_t kMaxBytes = 128 * 1024 * 1024;
+
+    /**
+     * @brief The bitset size (a power of two) for `ndv` distinct values at a false
+     * positive probability of `fpp`.
+     */
+    static size_t optimalNumBytes(size_t ndv, double fpp);
+
+    /**
+     * @throws std::invalid_argument unless num_bytes is a power of two in [kMinBytes, kMaxBytes]
+     */
+    explicit BloomFilter(size_t num_bytes);
+
+    /**
+     * @brief A filter over a bitset read from a file.
+     * @throws ParquetException if the bitset size is invalid
+     */
+    explicit BloomFilter(std::vector<uint8_t> bitset);
+
+    void insert(uint64_t hash);
+    bool mightContain(uint64_t hash) const;
+
+    static uint64_t hash(std::string_view bytes)
+    {
+        return xxHash64(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+    }
+
+    template <typename T>
+    static uint64_t hash(T value)
+    {
+        return xxHash64(reinterpret_cast<const uint8_t *>(&value), sizeof(value));
+    }
+
+    /**
+     * @brief The hash of slot i of a plain (not dictionary encoded) batch; the slot must
+     * not be null.
+     * @throws std::invalid_argument for BOOLEAN batches
+     */
+    static uint64_t hash(const ColumnBatch &batch, size_t i);
+
+    const std::vector<uint8_t> &bitset() const noexcept { return bitset_; }
+    size_t numBytes() const noexcept { return bitset_.size(); }
+
+private:
+    uint32_t *block(uint64_t hash) { return reinterpret_cast<uint32_t *>(bitset_.data()) + blockIndex(hash) * 8; }
+    const uint32_t *block(uint64_t hash) const
+    {
+        return reinterpret_cast<const uint32_t *>(bitset_.data()) + blockIndex(hash) * 8;
+    }
+    size_t blockIndex(uint64_t hash) const { return static_cast<size_t>(((hash >> 32) * num_blocks_) >> 32); }
+
+    std::vector<uint8_t> bitset_;
+    uint64_t num_blocks_;
+};
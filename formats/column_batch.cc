@@ -0,0 +1,465 @@
+#include "column_batch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "bit_util.hpp"
+
+AlignedBuffer::~AlignedBuffer()
+{
+    if (data_)
+    {
+        resource_->deallocate(data_, capacity_, kBufferAlignment);
+    }
+}
+
+AlignedBuffer::AlignedBuffer(AlignedBuffer &&other) noexcept
+    : resource_(other.resource_), data_(other.data_), size_(other.size_), capacity_(other.capacity_)
+{
+    other.data_ = nullptr;
+    other.size_ = 0;
+    other.capacity_ = 0;
+}
+
+AlignedBuffer &AlignedBuffer::operator=(AlignedBuffer &&other) noexcept
+{
+    if (this != &other)
+    {
+        if (data_)
+        {
+            resource_->deallocate(data_, capacity_, kBufferAlignment);
+        }
+        resource_ = other.resource_;
+        data_ = other.data_;
+        size_ = other.size_;
+        capacity_ = other.capacity_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.capacity_ = 0;
+    }
+    return *this;
+}
+
+void AlignedBuffer::reserve(size_t capacity)
+{
+    if (capacity <= capacity_)
+    {
+        return;
+    }
+    // Round up to whole cache lines so SIMD loops may touch the tail of the last line
+    capacity = (capacity + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment;
+    auto *data = static_cast<uint8_t *>(resource_->allocate(capacity, kBufferAlignment));
+    if (size_ > 0)
+    {
+        std::memcpy(data, data_, size_);
+    }
+    if (data_)
+    {
+        resource_->deallocate(data_, capacity_, kBufferAlignment);
+    }
+    data_ = data;
+    capacity_ = capacity;
+}
+
+void AlignedBuffer::resize(size_t size)
+{
+    if (size > capacity_)
+    {
+        reserve(std::max(size, capacity_ * 2));
+    }
+    size_ = size;
+}
+
+uint8_t *AlignedBuffer::grow(size_t bytes)
+{
+    size_t old_size = size_;
+    resize(size_ + bytes);
+    return data_ + old_size;
+}
+
+ColumnBatch::ColumnBatch(AtomicType type, int32_t type_length, std::pmr::memory_resource *resource)
+    : type_(type), type_length_(type_length), values_(resource), offsets_(resource), data_(resource),
+      validity_(resource)
+{
+    if (type == AtomicType::FIXED_LEN_BYTE_ARRAY && type_length <= 0)
+    {
+        throw std::invalid_argument("FIXED_LEN_BYTE_ARRAY requires a positive type length");
+    }
+    clear();
+}
+
+size_t ColumnBatch::valueWidth() const noexcept
+{
+    if (dictionary_ != nullptr)
+    {
+        return sizeof(int32_t);
+    }
+    switch (type_)
+    {
+    case AtomicType::BOOLEAN:
+        return 1;
+    case AtomicType::INT32:
+    case AtomicType::FLOAT:
+        return 4;
+    case AtomicType::INT64:
+    case AtomicType::DOUBLE:
+        return 8;
+    case AtomicType::FIXED_LEN_BYTE_ARRAY:
+        return static_cast<size_t>(type_length_);
+    case AtomicType::BYTE_ARRAY:
+        return 0;
+    }
+    return 0;
+}
+
+bool ColumnBatch::isValid(size_t i) const noexcept
+{
+    return !has_validity_ || bit_util::getBit(validity_.data(), i);
+}
+
+std::string_view ColumnBatch::byteArray(size_t i) const noexcept
+{
+    if (type_ == AtomicType::FIXED_LEN_BYTE_ARRAY)
+    {
+        auto width = static_cast<size_t>(type_length_);
+        return {reinterpret_cast<const char *>(values_.data() + i * width), width};
+    }
+    const int32_t *offsets = offsets_.as<int32_t>();
+    return {reinterpret_cast<const char *>(data_.data() + offsets[i]),
+            static_cast<size_t>(offsets[i + 1] - offsets[i])};
+}
+
+void ColumnBatch::setDictionary(std::shared_ptr<const ColumnBatch> dictionary)
+{
+    if (length_ != 0)
+    {
+        throw std::logic_error("Dictionary can only be changed on an empty batch");
+    }
+    dictionary_ = std::move(dictionary);
+}
+
+void ColumnBatch::materialize()
+{
+    if (dictionary_ == nullptr)
+    {
+        return;
+    }
+    const ColumnBatch &dictionary = *dictionary_;
+    const int32_t *indices = values_.as<int32_t>();
+    ColumnBatch plain(type_, type_length_, values_.resource());
+    for (size_t i = 0; i < length_; ++i)
+    {
+        if (!isValid(i))
+        {
+            plain.appendNulls(1);
+        }
+        else if (type_ == AtomicType::BYTE_ARRAY)
+        {
+            std::string_view value = dictionary.byteArray(static_cast<size_t>(indices[i]));
+            plain.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+        }
+        else
+        {
+            size_t width = dictionary.valueWidth();
+            const uint8_t *value = dictionary.values<uint8_t>() + static_cast<size_t>(indices[i]) * width;
+            std::memcpy(plain.appendValues<uint8_t>(1), value, width);
+        }
+    }
+    *this = std::move(plain);
+}
+
+void ColumnBatch::clear()
+{
+    length_ = 0;
+    null_count_ = 0;
+    pending_validity_ = 0;
+    has_validity_ = false;
+    values_.clear();
+    data_.clear();
+    validity_.clear();
+    // BYTE_ARRAY batches always start with a single zero offset
+    offsets_.resize(sizeof(int32_t));
+    offsets_.as<int32_t>()[0] = 0;
+}
+
+void ColumnBatch::ensureValidity(size_t slots)
+{
+    size_t bytes = bit_util::bytesForBits(slots);
+    if (!has_validity_)
+    {
+        validity_.resize(bytes);
+        bit_util::setBitsTo(validity_.data(), 0, length_, true);
+        has_validity_ = true;
+    }
+    else if (bytes > validity_.size())
+    {
+        validity_.resize(bytes);
+    }
+}
+
+uint8_t *ColumnBatch::appendSlots(size_t count)
+{
+    uint8_t *slots = values_.grow(count * valueWidth());
+    // Slots appended between appendValidity() and spread() already have their validity
+    if (has_validity_ && pending_validity_ == 0)
+    {
+        ensureValidity(length_ + count);
+        bit_util::setBitsTo(validity_.data(), length_, count, true);
+    }
+    length_ += count;
+    return slots;
+}
+
+void ColumnBatch::appendByteArray(const uint8_t *bytes, size_t size)
+{
+    auto [offsets, data] = appendByteArrays(1, size);
+    if (size > 0)
+    {
+        std::memcpy(data, bytes, size);
+    }
+    offsets[0] = offsets[-1] + static_cast<int32_t>(size);
+}
+
+std::pair<int32_t *, uint8_t *> ColumnBatch::appendByteArrays(size_t count, size_t total_bytes)
+{
+    if (data_.size() + total_bytes > static_cast<size_t>(std::numeric_limits<int32_t>::max()))
+    {
+        throw ParquetException("BYTE_ARRAY batch exceeds 2GB of data");
+    }
+    uint8_t *data = data_.grow(total_bytes);
+    offsets_.grow(count * sizeof(int32_t));
+    int32_t *offsets = offsets_.as<int32_t>() + length_ + 1;
+    if (has_validity_ && pending_validity_ == 0)
+    {
+        ensureValidity(length_ + count);
+        bit_util::setBitsTo(validity_.data(), length_, count, true);
+    }
+    length_ += count;
+    return {offsets, data};
+}
+
+void ColumnBatch::appendNulls(size_t count)
+{
+    ensureValidity(length_ + count);
+    bit_util::setBitsTo(validity_.data(), length_, count, false);
+    if (type_ == AtomicType::BYTE_ARRAY && dictionary_ == nullptr)
+    {
+        offsets_.grow(count * sizeof(int32_t));
+        int32_t *offsets = offsets_.as<int32_t>() + length_;
+        std::fill(offsets + 1, offsets + 1 + count, offsets[0]);
+    }
+    else
+    {
+        size_t width = valueWidth();
+        std::memset(values_.grow(count * width), 0, count * width);
+    }
+    length_ += count;
+    null_count_ += count;
+}
+
+size_t ColumnBatch::appendValidity(const int16_t *def_levels, size_t count, int16_t max_def_level)
+{
+    pending_validity_ = count;
+    if (!has_validity_)
+    {
+        // Keep the bitmap unallocated for as long as there are no nulls
+        bool all_valid = std::all_of(def_levels, def_levels + count,
+                                     [max_def_level](int16_t level)
+                                     { return level == max_def_level; });
+        if (all_valid)
+        {
+            return count;
+        }
+    }
+    ensureValidity(length_ + count);
+    return bit_util::levelsToBitmap(def_levels, count, max_def_level, validity_.data(), length_);
+}
+
+void ColumnBatch::spread(size_t first, size_t count)
+{
+    size_t dense = length_ - first;
+    pending_validity_ = 0;
+    if (dense == count)
+    {
+        return;
+    }
+    if (dense > count || !has_validity_)
+    {
+        throw std::logic_error("spread() called without matching appendValidity()");
+    }
+
+    const uint8_t *validity = validity_.data();
+    if (type_ == AtomicType::BYTE_ARRAY && dictionary_ == nullptr)
+    {
+        offsets_.grow((count - dense) * sizeof(int32_t));
+        int32_t *offsets = offsets_.as<int32_t>() + first;
+        std::vector<int32_t> ends(offsets + 1, offsets + 1 + dense);
+        int32_t current = offsets[0];
+        size_t next = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (bit_util::getBit(validity, first + i))
+            {
+                current = ends[next++];
+            }
+            offsets[i + 1] = current;
+        }
+    }
+    else
+    {
+        // Walk backwards so every value moves to a slot at or after its dense position
+        size_t width = valueWidth();
+        values_.grow((count - dense) * width);
+        uint8_t *values = values_.data() + first * width;
+        size_t next = dense;
+        for (size_t i = count; i-- > 0 && next < i + 1;)
+        {
+            if (bit_util::getBit(validity, first + i))
+            {
+                --next;
+                std::memmove(values + i * width, values + next * width, width);
+            }
+            else
+            {
+                std::memset(values + i * width, 0, width);
+            }
+        }
+    }
+    null_count_ += count - dense;
+    length_ = first + count;
+}
+
+namespace
+{
+    /**
+     * @brief Appends the positions of the set bits of `selection` in [first, end) to `out`,
+     * minus `shift`.
+     */
+    void selectedSlots(const Bitmap &selection, size_t first, size_t end, size_t shift, std::vector<size_t> &out)
+    {
+        const uint64_t *words = selection.words();
+        for (size_t w = first / Bitmap::kWordBits; w * Bitmap::kWordBits < end; ++w)
+        {
+            size_t base = w * Bitmap::kWordBits;
+            uint64_t word = words[w];
+            if (base < first)
+            {
+                word &= ~uint64_t(0) << (first - base);
+            }
+            if (end - base < Bitmap::kWordBits)
+            {
+                word &= (uint64_t(1) << (end - base)) - 1;
+            }
+            for (; word != 0; word &= word - 1)
+            {
+                out.push_back(base + static_cast<size_t>(__builtin_ctzll(word)) - shift);
+            }
+        }
+    }
+
+    template <typename T>
+    void gather(const uint8_t *values, const std::vector<size_t> &slots, uint8_t *out) noexcept
+    {
+        const T *in = reinterpret_cast<const T *>(values);
+        T *typed = reinterpret_cast<T *>(out);
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            typed[i] = in[slots[i]];
+        }
+    }
+} // namespace
+
+void ColumnBatch::appendSelected(const ColumnBatch &source, size_t first, size_t count, const Bitmap &selection,
+                                 size_t first_bit)
+{
+    if (source.type_ != type_ || source.type_length_ != type_length_)
+    {
+        throw std::invalid_argument("Cannot append slots of another type");
+    }
+    if (first + count > source.length_ || first_bit + count > selection.size())
+    {
+        throw std::invalid_argument("Selected slots out of range");
+    }
+    if (length_ == 0)
+    {
+        dictionary_ = source.dictionary_;
+    }
+    if (source.dictionary_ != dictionary_)
+    {
+        throw std::invalid_argument("Cannot append slots of another dictionary");
+    }
+
+    // Gather the selected slots one by one: selections scattered enough to be copied
+    // rather than decoded run by run have short runs
+    std::vector<size_t> slots;
+    selectedSlots(selection, first_bit, first_bit + count, first_bit - first, slots);
+    size_t slot = length_;
+    if (type_ == AtomicType::BYTE_ARRAY && dictionary_ == nullptr)
+    {
+        const int32_t *offsets = source.offsets();
+        size_t bytes = 0;
+        for (size_t i : slots)
+        {
+            bytes += static_cast<size_t>(offsets[i + 1] - offsets[i]);
+        }
+        auto [ends, data] = appendByteArrays(slots.size(), bytes);
+        int32_t end = ends[-1];
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            auto size = static_cast<size_t>(offsets[slots[i] + 1] - offsets[slots[i]]);
+            if (size > 0)
+            {
+                std::memcpy(data, source.data() + offsets[slots[i]], size);
+                data += size;
+            }
+            end += static_cast<int32_t>(size);
+            ends[i] = end;
+        }
+    }
+    else
+    {
+        size_t width = valueWidth();
+        uint8_t *out = appendSlots(slots.size());
+        switch (width)
+        {
+        case 1:
+            gather<uint8_t>(source.values_.data(), slots, out);
+            break;
+        case 4:
+            gather<uint32_t>(source.values_.data(), slots, out);
+            break;
+        case 8:
+            gather<uint64_t>(source.values_.data(), slots, out);
+            break;
+        default:
+            for (size_t i = 0; i < slots.size(); ++i)
+            {
+                std::memcpy(out + i * width, source.values_.data() + slots[i] * width, width);
+            }
+        }
+    }
+
+    // Null slots were copied as they are (zeroed, empty); only their validity is left
+    const uint8_t *validity = source.validity();
+    if (validity == nullptr)
+    {
+        return;
+    }
+    size_t nulls = 0;
+    for (size_t i : slots)
+    {
+        nulls += !bit_util::getBit(validity, i);
+    }
+    if (nulls > 0)
+    {
+        ensureValidity(length_);
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            bit_util::setBitTo(validity_.data(), slot + i, bit_util::getBit(validity, slots[i]));
+        }
+        null_count_ += nulls;
+    }
+}
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+
+#include "basics/bitmap.h"
+#include "parquet.hpp"
+
+/// Alignment of every ColumnBatch buffer, one cache line (and one AVX-512 register).
+constexpr size_t kBufferAlignment = 64;
+
+/// Number of values the decoders produce per call when the caller has no preference.
+constexpr size_t kDefaultBatchSize = 4096;
+
+/**
+ * @brief A growable byte buffer whose memory is aligned to kBufferAlignment.
+ *
+ * Growing keeps the existing contents. Shrinking (resize or clear) never releases
+ * memory, so a buffer reused across batches stops allocating once it reached its
+ * steady state size. The memory comes from a std::pmr::memory_resource, e.g. an Arena
+ * that is reset after every row group.
+ */
+class AlignedBuffer
+{
+public:
+    explicit AlignedBuffer(std::pmr::memory_resource *resource = std::pmr::get_default_resource()) noexcept
+        : resource_(resource) {}
+    ~AlignedBuffer();
+
+    AlignedBuffer(const AlignedBuffer &) = delete;
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+
+    AlignedBuffer(AlignedBuffer &&other) noexcept;
+    AlignedBuffer &operator=(AlignedBuffer &&other) noexcept;
+
+    uint8_t *data() noexcept { return data_; }
+    const uint8_t *data() const noexcept { return data_; }
+
+    template <typename T>
+    T *as() noexcept { return reinterpret_cast<T *>(data_); }
+
+    template <typename T>
+    const T *as() const noexcept { return reinterpret_cast<const T *>(data_); }
+
+    size_t size() const noexcept { return size_; }
+    size_t capacity() const noexcept { return capacity_; }
+    bool empty() const noexcept { return size_ == 0; }
+    std::pmr::memory_resource *resource() const noexcept { return resource_; }
+
+    void reserve(size_t capacity);
+    void resize(size_t size);
+    void clear() noexcept { size_ = 0; }
+
+    /**
+     * @brief Grows the buffer by `bytes` and returns a pointer to the first new byte.
+     * The new bytes are uninitialized.
+     */
+    uint8_t *grow(size_t bytes);
+
+private:
+    std::pmr::memory_resource *resource_;
+    uint8_t *data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+};
+
+/**
+ * @brief An Arrow-like columnar batch of values of a single Parquet type.
+ *
+ * This is the hand-off format between the page decoders and the query engine. The
+ * layout depends on the type:
+ *
+ * - Fixed width types keep their values back to back in an aligned buffer (BOOLEAN uses
+ *   one byte per value, FIXED_LEN_BYTE_ARRAY uses typeLength() bytes per value).
+ * - BYTE_ARRAY keeps length() + 1 int32 offsets into a separate data buffer.
+ * - Dictionary encoded batches keep int32 indices into dictionary() instead of values.
+ *
+ * Null slots are tracked by a validity bitmap (a set bit means the value is present).
+ * The bitmap is only allocated once the first null shows up, so validity() returns
+ * nullptr as long as every value is present. Null slots still occupy a zeroed slot in the
+ * value buffer and have an empty range in the offsets.
+ *
+ * Decoders append the non-null values of a page with the append* methods. Optional
+ * columns first record the validity of the next slots with appendValidity(), then append
+ * the dense values, then call spread() to move the values to their slots.
+ *
+ * All buffers are allocated from the memory resource given at construction. With an
+ * Arena, the batch must be destroyed before the arena is reset.
+ */
+class ColumnBatch
+{
+public:
+    explicit ColumnBatch(AtomicType type, int32_t type_length = 0,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    ColumnBatch(const ColumnBatch &) = delete;
+    ColumnBatch &operator=(const ColumnBatch &) = delete;
+
+    ColumnBatch(ColumnBatch &&other) noexcept = default;
+    ColumnBatch &operator=(ColumnBatch &&other) noexcept = default;
+
+    AtomicType type() const noexcept { return type_; }
+    int32_t typeLength() const noexcept { return type_length_; }
+
+    /**
+     * @brief Bytes per slot in the value buffer, 0 for BYTE_ARRAY (unless dictionary encoded).
+     */
+    size_t valueWidth() const noexcept;
+
+    size_t length() const noexcept { return length_; }
+    size_t nullCount() const noexcept { return null_count_; }
+    bool empty() const noexcept { return length_ == 0; }
+
+    const uint8_t *validity() const noexcept { return has_validity_ ? validity_.data() : nullptr; }
+    bool isValid(size_t i) const noexcept;
+
+    template <typename T>
+    const T *values() const noexcept { return values_.as<T>(); }
+
+    template <typename T>
+    T value(size_t i) const noexcept { return values_.as<T>()[i]; }
+
+    const int32_t *offsets() const noexcept { return offsets_.as<int32_t>(); }
+    const uint8_t *data() const noexcept { return data_.data(); }
+
+    /**
+     * @brief The bytes of slot i of a BYTE_ARRAY or FIXED_LEN_BYTE_ARRAY batch.
+     */
+    std::string_view byteArray(size_t i) const noexcept;
+
+    bool isDictionaryEncoded() const noexcept { return dictionary_ != nullptr; }
+    const std::shared_ptr<const ColumnBatch> &dictionary() const noexcept { return dictionary_; }
+    const int32_t *indices() const noexcept { return values_.as<int32_t>(); }
+
+    /**
+     * @brief Switches an empty batch to dictionary encoding: from now on the value buffer
+     * holds int32 indices into `dictionary`. Passing nullptr switches back to plain values.
+     * @throws std::logic_error if the batch is not empty
+     */
+    void setDictionary(std::shared_ptr<const ColumnBatch> dictionary);
+
+    /**
+     * @brief Replaces the indices of a dictionary encoded batch by the values they point
+     * to; plain batches stay as they are.
+     */
+    void materialize();
+
+    /**
+     * @brief Drops all values but keeps the allocated memory (and the dictionary, if any)
+     * for the next batch.
+     */
+    void clear();
+
+    /**
+     * @brief Appends `count` uninitialized fixed width slots and returns a pointer to the
+     * first one, typed as T.
+     */
+    template <typename T>
+    T *appendValues(size_t count)
+    {
+        return reinterpret_cast<T *>(appendSlots(count));
+    }
+
+    /**
+     * @brief Appends one BYTE_ARRAY value.
+     */
+    void appendByteArray(const uint8_t *bytes, size_t size);
+
+    /**
+     * @brief Appends `count` BYTE_ARRAY values whose `total_bytes` bytes are stored back
+     * to back. Returns pointers to the `count` new end offsets and to the data. The
+     * caller fills both; offsets are absolute positions in the data buffer.
+     */
+    std::pair<int32_t *, uint8_t *> appendByteArrays(size_t count, size_t total_bytes);
+
+    /**
+     * @brief Appends `count` null slots.
+     */
+    void appendNulls(size_t count);
+
+    /**
+     * @brief Records the validity of the next `count` slots from their definition levels.
+     * Does not change length(); the values are expected to be appended densely next and
+     * then moved into place with spread().
+     * @return The number of non-null values among the `count` slots
+     */
+    size_t appendValidity(const int16_t *def_levels, size_t count, int16_t max_def_level);
+
+    /**
+     * @brief Moves the dense values appended since slot `first` to their slots according to
+     * the validity recorded by appendValidity(), leaving length() == first + count.
+     */
+    void spread(size_t first, size_t count);
+
+    /**
+     * @brief Appends the slots of `source` in [first, first + count) whose bit is set in
+     * `selection`, bit `first_bit` standing for slot `first`. An empty batch takes the
+     * dictionary of a dictionary encoded `source`.
+     * @throws std::invalid_argument if `source` has another type or dictionary, or if the
+     * range exceeds `source` or `selection`
+     */
+    void appendSelected(const ColumnBatch &source, size_t first, size_t count, const Bitmap &selection,
+                        size_t first_bit);
+
+private:
+    uint8_t *appendSlots(size_t count);
+    void ensureValidity(size_t slots);
+
+    AtomicType type_;
+    int32_t type_length_;
+    size_t length_ = 0;
+    size_t null_count_ = 0;
+    size_t pending_validity_ = 0;
+    bool has_validity_ = false;
+
+    AlignedBuffer values_;
+    AlignedBuffer offsets_;
+    AlignedBuffer data_;
+    AlignedBuffer validity_;
+    std::shared_ptr<const ColumnBatch> dictionary_;
+};
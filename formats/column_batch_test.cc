@@ -0,0 +1,349 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bit_util.hpp"
+#include "column_batch.hpp"
+
+TEST(AlignedBufferTest, GrowKeepsContentsAndAlignment)
+{
+    AlignedBuffer buffer;
+    for (int i = 0; i < 1000; ++i)
+    {
+        *buffer.grow(1) = static_cast<uint8_t>(i);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.data()) % kBufferAlignment, 0u);
+    }
+    ASSERT_EQ(buffer.size(), 1000u);
+    for (int i = 0; i < 1000; ++i)
+    {
+        EXPECT_EQ(buffer.data()[i], static_cast<uint8_t>(i));
+    }
+
+    size_t capacity = buffer.capacity();
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.capacity(), capacity);
+}
+
+TEST(ColumnBatchTest, FixedWidthValues)
+{
+    ColumnBatch batch(AtomicType::INT64);
+    int64_t *values = batch.appendValues<int64_t>(3);
+    values[0] = 1;
+    values[1] = -2;
+    values[2] = 3;
+
+    EXPECT_EQ(batch.length(), 3u);
+    EXPECT_EQ(batch.nullCount(), 0u);
+    EXPECT_EQ(batch.validity(), nullptr);
+    EXPECT_EQ(batch.value<int64_t>(1), -2);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(batch.values<int64_t>()) % kBufferAlignment, 0u);
+}
+
+TEST(ColumnBatchTest, ByteArrays)
+{
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    batch.appendByteArray(reinterpret_cast<const uint8_t *>("hello"), 5);
+    batch.appendByteArray(nullptr, 0);
+    batch.appendByteArray(reinterpret_cast<const uint8_t *>("world"), 5);
+
+    ASSERT_EQ(batch.length(), 3u);
+    EXPECT_EQ(batch.byteArray(0), "hello");
+    EXPECT_EQ(batch.byteArray(1), "");
+    EXPECT_EQ(batch.byteArray(2), "world");
+    EXPECT_EQ(batch.offsets()[3], 10);
+}
+
+TEST(ColumnBatchTest, NullsAllocateValidityLazily)
+{
+    ColumnBatch batch(AtomicType::INT32);
+    *batch.appendValues<int32_t>(1) = 7;
+    EXPECT_EQ(batch.validity(), nullptr);
+
+    batch.appendNulls(2);
+    *batch.appendValues<int32_t>(1) = 9;
+
+    ASSERT_NE(batch.validity(), nullptr);
+    EXPECT_EQ(batch.length(), 4u);
+    EXPECT_EQ(batch.nullCount(), 2u);
+    EXPECT_TRUE(batch.isValid(0));
+    EXPECT_FALSE(batch.isValid(1));
+    EXPECT_FALSE(batch.isValid(2));
+    EXPECT_TRUE(batch.isValid(3));
+    EXPECT_EQ(batch.value<int32_t>(1), 0);
+    EXPECT_EQ(batch.value<int32_t>(3), 9);
+}
+
+TEST(ColumnBatchTest, SpreadFixedWidthValues)
+{
+    ColumnBatch batch(AtomicType::INT32);
+    std::vector<int16_t> levels = {1, 0, 1, 1, 0, 0, 1};
+
+    size_t valid = batch.appendValidity(levels.data(), levels.size(), 1);
+    ASSERT_EQ(valid, 4u);
+    int32_t *dense = batch.appendValues<int32_t>(valid);
+    for (int32_t i = 0; i < 4; ++i)
+    {
+        dense[i] = 10 + i;
+    }
+    batch.spread(0, levels.size());
+
+    ASSERT_EQ(batch.length(), 7u);
+    EXPECT_EQ(batch.nullCount(), 3u);
+    std::vector<int32_t> expected = {10, 0, 11, 12, 0, 0, 13};
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(batch.isValid(i), levels[i] == 1) << i;
+        EXPECT_EQ(batch.value<int32_t>(i), expected[i]) << i;
+    }
+}
+
+TEST(ColumnBatchTest, SpreadByteArrays)
+{
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    batch.appendByteArray(reinterpret_cast<const uint8_t *>("x"), 1);
+
+    std::vector<int16_t> levels = {0, 2, 2, 1};
+    size_t valid = batch.appendValidity(levels.data(), levels.size(), 2);
+    ASSERT_EQ(valid, 2u);
+    batch.appendByteArray(reinterpret_cast<const uint8_t *>("ab"), 2);
+    batch.appendByteArray(reinterpret_cast<const uint8_t *>("cde"), 3);
+    batch.spread(1, levels.size());
+
+    ASSERT_EQ(batch.length(), 5u);
+    EXPECT_EQ(batch.nullCount(), 2u);
+    EXPECT_TRUE(batch.isValid(0));
+    EXPECT_FALSE(batch.isValid(1));
+    EXPECT_EQ(batch.byteArray(0), "x");
+    EXPECT_EQ(batch.byteArray(1), "");
+    EXPECT_EQ(batch.byteArray(2), "ab");
+    EXPECT_EQ(batch.byteArray(3), "cde");
+    EXPECT_EQ(batch.byteArray(4), "");
+}
+
+TEST(ColumnBatchTest, ClearKeepsDictionary)
+{
+    auto dictionary = std::make_shared<ColumnBatch>(AtomicType::DOUBLE);
+    *dictionary->appendValues<double>(1) = 1.5;
+
+    ColumnBatch batch(AtomicType::DOUBLE);
+    batch.setDictionary(dictionary);
+    *batch.appendValues<int32_t>(1) = 0;
+    EXPECT_TRUE(batch.isDictionaryEncoded());
+    EXPECT_EQ(batch.valueWidth(), sizeof(int32_t));
+    EXPECT_THROW(batch.setDictionary(nullptr), std::logic_error);
+
+    batch.clear();
+    EXPECT_TRUE(batch.empty());
+    EXPECT_EQ(batch.dictionary(), dictionary);
+}
+
+TEST(ColumnBatchTest, MaterializeLooksUpIndices)
+{
+    auto dictionary = std::make_shared<ColumnBatch>(AtomicType::BYTE_ARRAY);
+    dictionary->appendByteArray(reinterpret_cast<const uint8_t *>("ab"), 2);
+    dictionary->appendByteArray(nullptr, 0);
+
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    batch.setDictionary(dictionary);
+    *batch.appendValues<int32_t>(1) = 1;
+    batch.appendNulls(1);
+    *batch.appendValues<int32_t>(1) = 0;
+    batch.materialize();
+
+    EXPECT_FALSE(batch.isDictionaryEncoded());
+    ASSERT_EQ(batch.length(), 3u);
+    EXPECT_EQ(batch.nullCount(), 1u);
+    EXPECT_EQ(batch.byteArray(0), "");
+    EXPECT_FALSE(batch.isValid(1));
+    EXPECT_EQ(batch.byteArray(2), "ab");
+
+    auto doubles = std::make_shared<ColumnBatch>(AtomicType::DOUBLE);
+    *doubles->appendValues<double>(1) = 2.5;
+    ColumnBatch values(AtomicType::DOUBLE);
+    values.setDictionary(doubles);
+    *values.appendValues<int32_t>(1) = 0;
+    values.materialize();
+    EXPECT_EQ(values.valueWidth(), sizeof(double));
+    EXPECT_EQ(values.value<double>(0), 2.5);
+}
+
+TEST(ColumnBatchTest, AppendSelectedCopiesSelectedSlots)
+{
+    // Slot i holds i, every third slot is null
+    ColumnBatch ints(AtomicType::INT64);
+    ColumnBatch strings(AtomicType::BYTE_ARRAY);
+    for (size_t i = 0; i < 200; ++i)
+    {
+        if (i % 3 == 0)
+        {
+            ints.appendNulls(1);
+            strings.appendNulls(1);
+            continue;
+        }
+        *ints.appendValues<int64_t>(1) = static_cast<int64_t>(i);
+        std::string value = std::to_string(i);
+        strings.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+    }
+    std::mt19937 rng(5);
+    Bitmap selection(200);
+    for (size_t i = 0; i < selection.size(); ++i)
+    {
+        selection.setTo(i, rng() % 4 != 0);
+    }
+
+    ColumnBatch selected_ints(AtomicType::INT64);
+    selected_ints.appendSelected(ints, 10, 100, selection, 10);
+    selected_ints.appendSelected(ints, 110, 90, selection, 110);
+    ColumnBatch selected_strings(AtomicType::BYTE_ARRAY);
+    selected_strings.appendSelected(strings, 10, 190, selection, 10);
+    std::vector<size_t> rows;
+    for (size_t i = 10; i < selection.size(); ++i)
+    {
+        if (selection[i])
+        {
+            rows.push_back(i);
+        }
+    }
+    ASSERT_EQ(selected_ints.length(), rows.size());
+    ASSERT_EQ(selected_strings.length(), rows.size());
+    size_t nulls = 0;
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        bool valid = rows[i] % 3 != 0;
+        nulls += !valid;
+        ASSERT_EQ(selected_ints.isValid(i), valid);
+        ASSERT_EQ(selected_strings.isValid(i), valid);
+        EXPECT_EQ(selected_ints.value<int64_t>(i), valid ? static_cast<int64_t>(rows[i]) : 0);
+        EXPECT_EQ(selected_strings.byteArray(i), valid ? std::to_string(rows[i]) : "");
+    }
+    EXPECT_EQ(selected_ints.nullCount(), nulls);
+    EXPECT_EQ(selected_strings.nullCount(), nulls);
+
+    // A block of slots whose first slot stands for bit 100
+    Bitmap all(200, true);
+    ColumnBatch block(AtomicType::BYTE_ARRAY);
+    block.appendSelected(strings, 100, 100, all, 100);
+    ColumnBatch selected_block(AtomicType::BYTE_ARRAY);
+    selected_block.appendSelected(block, 0, 100, selection, 100);
+    size_t skipped = selected_strings.length() - selected_block.length();
+    for (size_t i = 0; i < selected_block.length(); ++i)
+    {
+        EXPECT_EQ(selected_block.isValid(i), selected_strings.isValid(skipped + i));
+        EXPECT_EQ(selected_block.byteArray(i), selected_strings.byteArray(skipped + i));
+    }
+
+    // Indices keep their dictionary
+    auto dictionary = std::make_shared<ColumnBatch>(AtomicType::INT32);
+    *dictionary->appendValues<int32_t>(1) = 7;
+    ColumnBatch indices(AtomicType::INT32);
+    indices.setDictionary(dictionary);
+    std::fill_n(indices.appendValues<int32_t>(200), 200, 0);
+    ColumnBatch selected_indices(AtomicType::INT32);
+    selected_indices.appendSelected(indices, 0, 200, selection, 0);
+    EXPECT_EQ(selected_indices.dictionary(), dictionary);
+    EXPECT_EQ(selected_indices.length(), selection.count());
+
+    EXPECT_THROW(selected_indices.appendSelected(ints, 0, 10, selection, 0), std::invalid_argument);
+    EXPECT_THROW(selected_ints.appendSelected(ints, 150, 51, selection, 0), std::invalid_argument);
+    EXPECT_THROW(selected_ints.appendSelected(ints, 0, 51, selection, 150), std::invalid_argument);
+}
+
+TEST(BitUtilTest, LevelsToBitmapMatchesScalar)
+{
+    std::mt19937 rng(42);
+    std::vector<int16_t> levels(1000);
+    for (auto &level : levels)
+    {
+        level = static_cast<int16_t>(rng() % 3);
+    }
+
+    for (size_t offset : {0, 3, 8, 13})
+    {
+        std::vector<uint8_t> bitmap(200, 0xAA);
+        size_t valid = bit_util::levelsToBitmap(levels.data(), levels.size(), 2, bitmap.data(), offset);
+
+        size_t expected_valid = 0;
+        for (size_t i = 0; i < levels.size(); ++i)
+        {
+            EXPECT_EQ(bit_util::getBit(bitmap.data(), offset + i), levels[i] == 2) << i;
+            expected_valid += levels[i] == 2;
+        }
+        EXPECT_EQ(valid, expected_valid);
+        EXPECT_EQ(bit_util::countSetBits(bitmap.data(), offset, levels.size()), expected_valid);
+    }
+}
+
+TEST(BitUtilTest, UnpackBitsMatchesGetBit)
+{
+    std::mt19937 rng(11);
+    std::vector<uint8_t> bitmap(64);
+    for (auto &byte : bitmap)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+
+    for (size_t offset : {0, 1, 8, 13})
+    {
+        for (size_t count : {0, 5, 16, 37, 400})
+        {
+            std::vector<uint8_t> out(count + 1, 0xAA);
+            bit_util::unpackBits(bitmap.data(), offset, count, out.data());
+            for (size_t i = 0; i < count; ++i)
+            {
+                ASSERT_EQ(out[i], bit_util::getBit(bitmap.data(), offset + i)) << offset << " " << i;
+            }
+            EXPECT_EQ(out[count], 0xAA);
+        }
+    }
+}
+
+TEST(BitUtilTest, PackUnpackRoundTrip)
+{
+    std::mt19937_64 rng(7);
+    for (int width : {1, 3, 8, 17, 32, 45, 64})
+    {
+        uint64_t mask = width == 64 ? ~uint64_t{0} : (uint64_t{1} << width) - 1;
+        std::vector<uint64_t> values(100);
+        for (auto &value : values)
+        {
+            value = rng() & mask;
+        }
+        std::vector<uint8_t> packed(bit_util::bytesForBits(values.size() * width));
+        bit_util::pack64(values.data(), values.size(), width, packed.data());
+
+        std::vector<uint64_t> unpacked(values.size());
+        bit_util::unpack64(packed.data(), packed.data() + packed.size(), 0, values.size(), width, unpacked.data());
+        EXPECT_EQ(unpacked, values) << width;
+
+        if (width <= 32)
+        {
+            std::vector<uint32_t> unpacked32(values.size() - 5);
+            bit_util::unpack32(packed.data(), packed.data() + packed.size(), 5, unpacked32.size(), width,
+                               unpacked32.data());
+            for (size_t i = 0; i < unpacked32.size(); ++i)
+            {
+                EXPECT_EQ(unpacked32[i], values[i + 5]);
+            }
+        }
+    }
+}
+
+TEST(BitUtilTest, Varints)
+{
+    uint8_t buffer[10];
+    for (int64_t value : std::vector<int64_t>{0, 1, -1, 63, -64, 300, INT64_MAX, INT64_MIN})
+    {
+        size_t size = bit_util::writeUleb128(bit_util::zigzagEncode(value), buffer);
+        const uint8_t *p = buffer;
+        EXPECT_EQ(bit_util::zigzagDecode(bit_util::readUleb128(p, buffer + size)), value);
+        EXPECT_EQ(p, buffer + size);
+    }
+
+    const uint8_t truncated[] = {0x80};
+    const uint8_t *p = truncated;
+    EXPECT_THROW(bit_util::readUleb128(p, truncated + 1), ParquetException);
+}
@@ -0,0 +1,287 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+#include "bit_util.hpp"
+
+namespace
+{
+    namespace snappy
+    {
+        // Snappy compresses independent blocks of at most 64KB, so every copy offset fits
+        // the two byte copy element
+        constexpr size_t kBlockSize = 1 << 16;
+        constexpr int kHashBits = 14;
+        constexpr size_t kMinMatch = 4;
+
+        enum Tag : uint8_t
+        {
+            LITERAL = 0,
+            COPY_1 = 1,
+            COPY_2 = 2,
+            COPY_4 = 3
+        };
+
+        uint32_t load32(const uint8_t *p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t hash(uint32_t bytes)
+        {
+            return (bytes * 0x1e35a7bd) >> (32 - kHashBits);
+        }
+
+        uint8_t *emitLiteral(const uint8_t *data, size_t length, uint8_t *out)
+        {
+            size_t n = length - 1;
+            if (n < 60)
+            {
+                *out++ = static_cast<uint8_t>(n << 2 | LITERAL);
+            }
+            else
+            {
+                int bytes = n < (1u << 8) ? 1 : n < (1u << 16) ? 2
+                                            : n < (1u << 24)   ? 3
+                                                               : 4;
+                *out++ = static_cast<uint8_t>((59 + bytes) << 2 | LITERAL);
+                for (int i = 0; i < bytes; ++i)
+                {
+                    *out++ = static_cast<uint8_t>(n >> (8 * i));
+                }
+            }
+            std::memcpy(out, data, length);
+            return out + length;
+        }
+
+        uint8_t *emitCopy(size_t offset, size_t length, uint8_t *out)
+        {
+            // The two byte offset form takes lengths of 1 to 64; leave at least 4 bytes for
+            // the last element so it stays a worthwhile copy
+            while (length > 0)
+            {
+                size_t n = length > 64 ? (length - 64 >= kMinMatch ? 64 : 60) : length;
+                *out++ = static_cast<uint8_t>((n - 1) << 2 | COPY_2);
+                *out++ = static_cast<uint8_t>(offset);
+                *out++ = static_cast<uint8_t>(offset >> 8);
+                length -= n;
+            }
+            return out;
+        }
+
+        uint8_t *compressBlock(const uint8_t *block, size_t size, uint8_t *out)
+        {
+            int32_t table[1 << kHashBits];
+            std::fill(std::begin(table), std::end(table), -1);
+
+            size_t literal_start = 0;
+            size_t i = 0;
+            while (size >= kMinMatch && i <= size - kMinMatch)
+            {
+                uint32_t bytes = load32(block + i);
+                uint32_t h = hash(bytes);
+                int32_t candidate = table[h];
+                table[h] = static_cast<int32_t>(i);
+                if (candidate < 0 || load32(block + candidate) != bytes)
+                {
+                    // Skip faster through data that does not compress
+                    i += 1 + ((i - literal_start) >> 5);
+                    continue;
+                }
+
+                size_t length = kMinMatch;
+                while (i + length < size && block[candidate + length] == block[i + length])
+                {
+                    ++length;
+                }
+                if (literal_start < i)
+                {
+                    out = emitLiteral(block + literal_start, i - literal_start, out);
+                }
+                out = emitCopy(i - static_cast<size_t>(candidate), length, out);
+                i += length;
+                literal_start = i;
+            }
+            if (literal_start < size)
+            {
+                out = emitLiteral(block + literal_start, size - literal_start, out);
+            }
+            return out;
+        }
+
+        size_t compress(const uint8_t *data, size_t size, uint8_t *out)
+        {
+            uint8_t *begin = out;
+            out += bit_util::writeUleb128(size, out);
+            for (size_t offset = 0; offset < size; offset += kBlockSize)
+            {
+                out = compressBlock(data + offset, std::min(kBlockSize, size - offset), out);
+            }
+            return static_cast<size_t>(out - begin);
+        }
+
+        void decompress(const uint8_t *data, size_t size, uint8_t *out, size_t out_size)
+        {
+            const uint8_t *end = data + size;
+            if (bit_util::readUleb128(data, end) != out_size)
+            {
+                throw ParquetException("Snappy uncompressed length does not match the page header");
+            }
+
+            size_t position = 0;
+            while (data < end)
+            {
+                uint8_t tag = *data++;
+                size_t length;
+                size_t offset;
+                switch (tag & 3)
+                {
+                case LITERAL:
+                {
+                    length = tag >> 2;
+                    if (length >= 60)
+                    {
+                        size_t bytes = length - 59;
+                        if (static_cast<size_t>(end - data) < bytes)
+                        {
+                            throw ParquetException("Truncated Snappy literal");
+                        }
+                        length = 0;
+                        for (size_t i = 0; i < bytes; ++i)
+                        {
+                            length |= static_cast<size_t>(data[i]) << (8 * i);
+                        }
+                        data += bytes;
+                    }
+                    ++length;
+                    if (static_cast<size_t>(end - data) < length || out_size - position < length)
+                    {
+                        throw ParquetException("Snappy literal out of bounds");
+                    }
+                    std::memcpy(out + position, data, length);
+                    data += length;
+                    position += length;
+                    continue;
+                }
+                case COPY_1:
+                    if (data >= end)
+                    {
+                        throw ParquetException("Truncated Snappy copy");
+                    }
+                    length = ((tag >> 2) & 7) + 4;
+                    offset = static_cast<size_t>(tag >> 5) << 8 | *data++;
+                    break;
+                case COPY_2:
+                    if (end - data < 2)
+                    {
+                        throw ParquetException("Truncated Snappy copy");
+                    }
+                    length = (tag >> 2) + 1;
+                    offset = data[0] | static_cast<size_t>(data[1]) << 8;
+                    data += 2;
+                    break;
+                default:
+                    if (end - data < 4)
+                    {
+                        throw ParquetException("Truncated Snappy copy");
+                    }
+                    length = (tag >> 2) + 1;
+                    offset = load32(data);
+                    data += 4;
+                    break;
+                }
+
+                if (offset == 0 || offset > position || out_size - position < length)
+                {
+                    throw ParquetException("Snappy copy out of bounds");
+                }
+                uint8_t *dst = out + position;
+                const uint8_t *src = dst - offset;
+                if (offset >= length)
+                {
+                    std::memcpy(dst, src, length);
+                }
+                else
+                {
+                    // Overlapping copies repeat the last `offset` bytes
+                    for (size_t i = 0; i < length; ++i)
+                    {
+                        dst[i] = src[i];
+                    }
+                }
+                position += length;
+            }
+            if (position != out_size)
+            {
+                throw ParquetException("Snappy data is shorter than the uncompressed length");
+            }
+        }
+    } // namespace snappy
+
+    [[noreturn]] void unsupported(CompressionCodec codec)
+    {
+        throw ParquetException("Unsupported compression codec " + std::to_string(static_cast<int>(codec)));
+    }
+} // namespace
+
+bool isCodecSupported(CompressionCodec codec) noexcept
+{
+    return codec == CompressionCodec::UNCOMPRESSED || codec == CompressionCodec::SNAPPY;
+}
+
+size_t maxCompressedLength(CompressionCodec codec, size_t size)
+{
+    switch (codec)
+    {
+    case CompressionCodec::UNCOMPRESSED:
+        return size;
+    case CompressionCodec::SNAPPY:
+        // Same bound as the reference implementation
+        return 32 + size + size / 6;
+    default:
+        unsupported(codec);
+    }
+}
+
+size_t compress(CompressionCodec codec, const uint8_t *data, size_t size, uint8_t *out)
+{
+    switch (codec)
+    {
+    case CompressionCodec::UNCOMPRESSED:
+        if (size > 0)
+        {
+            std::memcpy(out, data, size);
+        }
+        return size;
+    case CompressionCodec::SNAPPY:
+        return snappy::compress(data, size, out);
+    default:
+        unsupported(codec);
+    }
+}
+
+void decompress(CompressionCodec codec, const uint8_t *data, size_t size, uint8_t *out, size_t out_size)
+{
+    switch (codec)
+    {
+    case CompressionCodec::UNCOMPRESSED:
+        if (size != out_size)
+        {
+            throw ParquetException("Uncompressed page size does not match the page header");
+        }
+        if (size > 0)
+        {
+            std::memcpy(out, data, size);
+        }
+        return;
+    case CompressionCodec::SNAPPY:
+        snappy::decompress(data, size, out, out_size);
+        return;
+    default:
+        unsupported(codec);
+    }
+}
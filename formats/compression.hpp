@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "parquet_metadata.hpp"
+
+// Page compression codecs. Only UNCOMPRESSED and SNAPPY are implemented so far; Snappy is
+// what most writers default to and needs no external library.
+//
+// Snappy format description:
+// https://github.com/google/snappy/blob/main/format_description.txt
+
+/**
+ * @brief Whether compress() and decompress() support `codec`.
+ */
+bool isCodecSupported(CompressionCodec codec) noexcept;
+
+/**
+ * @brief Upper bound of the compressed size of `size` input bytes.
+ * @throws ParquetException if the codec is not supported
+ */
+size_t maxCompressedLength(CompressionCodec codec, size_t size);
+
+/**
+ * @brief Compresses `size` bytes into `out`, which must hold maxCompressedLength() bytes.
+ * @return The compressed size
+ * @throws ParquetException if the codec is not supported
+ */
+size_t compress(CompressionCodec codec, const uint8_t *data, size_t size, uint8_t *out);
+
+/**
+ * @brief Decompresses `size` bytes into `out`, which must be exactly `out_size` bytes, the
+ * uncompressed size recorded in the page header.
+ * @throws ParquetException if the input is corrupt or does not decompress to `out_size` bytes
+ */
+void decompress(CompressionCodec codec, const uint8_t *data, size_t size, uint8_t *out, size_t out_size);
@@ -0,0 +1,129 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "basics/benchmark_data.h"
+#include "compression.hpp"
+#include "encodings.hpp"
+
+// Compression and decompression throughput of every supported codec over the PLAIN
+// encoding of 1K to 1M values (BENCHMARK_MAX_SIZE raises the limit) of four kinds of
+// data: ascending INT64 timestamps (steps below 1000), uniformly random INT64, DOUBLE in
+// [0, 1) and BYTE_ARRAY drawn from 1000 strings of 8 to 24 characters. Reports the
+// uncompressed bytes per second and the compression ratio.
+
+namespace
+{
+    enum DataKind
+    {
+        kAscending,
+        kRandom,
+        kDoubles,
+        kStrings
+    };
+
+    std::vector<uint8_t> plainPage(int64_t kind, size_t n)
+    {
+        std::vector<uint8_t> page;
+        switch (kind)
+        {
+        case kAscending:
+        {
+            ColumnBatch batch(AtomicType::INT64);
+            int64_t *values = batch.appendValues<int64_t>(n);
+            std::vector<int64_t> steps = ascendingIntegers(n, 999, 1);
+            for (size_t i = 0; i < n; ++i)
+            {
+                values[i] = 1700000000000000 + steps[i];
+            }
+            encodePlain(batch, 0, n, page);
+            break;
+        }
+        case kRandom:
+        {
+            ColumnBatch batch(AtomicType::INT64);
+            std::vector<uint64_t> random = uniformIntegers(n, UINT64_MAX, 1);
+            std::memcpy(batch.appendValues<int64_t>(n), random.data(), n * sizeof(int64_t));
+            encodePlain(batch, 0, n, page);
+            break;
+        }
+        case kDoubles:
+        {
+            ColumnBatch batch(AtomicType::DOUBLE);
+            std::vector<double> doubles = uniformDoubles(n, 1);
+            std::copy(doubles.begin(), doubles.end(), batch.appendValues<double>(n));
+            encodePlain(batch, 0, n, page);
+            break;
+        }
+        default:
+        {
+            ColumnBatch batch(AtomicType::BYTE_ARRAY);
+            for (const std::string &value : randomStrings(n, 1000, 8, 24, 1))
+            {
+                batch.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+            }
+            encodePlain(batch, 0, n, page);
+        }
+        }
+        return page;
+    }
+
+    void codecArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"codec", "data", "values"});
+        for (int codec = 0; codec <= static_cast<int>(CompressionCodec::LZ4_RAW); ++codec)
+        {
+            if (!isCodecSupported(static_cast<CompressionCodec>(codec)))
+            {
+                continue;
+            }
+            for (int kind = kAscending; kind <= kStrings; ++kind)
+            {
+                for (int64_t n : benchmarkSizes(1000000))
+                {
+                    benchmark->Args({codec, kind, n});
+                }
+            }
+        }
+    }
+} // namespace
+
+static void BM_Compress(benchmark::State &state)
+{
+    auto codec = static_cast<CompressionCodec>(state.range(0));
+    std::vector<uint8_t> page = plainPage(state.range(1), static_cast<size_t>(state.range(2)));
+    std::vector<uint8_t> out(maxCompressedLength(codec, page.size()));
+    size_t compressed = 0;
+    for (auto _ : state)
+    {
+        compressed = compress(codec, page.data(), page.size(), out.data());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * page.size()));
+    state.counters["ratio"] = static_cast<double>(page.size()) / static_cast<double>(compressed);
+}
+
+static void BM_Decompress(benchmark::State &state)
+{
+    auto codec = static_cast<CompressionCodec>(state.range(0));
+    std::vector<uint8_t> page = plainPage(state.range(1), static_cast<size_t>(state.range(2)));
+    std::vector<uint8_t> compressed(maxCompressedLength(codec, page.size()));
+    compressed.resize(compress(codec, page.data(), page.size(), compressed.data()));
+    std::vector<uint8_t> out(page.size());
+    for (auto _ : state)
+    {
+        decompress(codec, compressed.data(), compressed.size(), out.data(), out.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * page.size()));
+    state.counters["ratio"] = static_cast<double>(page.size()) / static_cast<double>(compressed.size());
+}
+
+BENCHMARK(BM_Compress)->Apply(codecArgs);
+BENCHMARK(BM_Decompress)->Apply(codecArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,1303 @@
+#include "encodings.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+#include "bit_util.hpp"
+
+namespace
+{
+    // Scratch space for the unpacking loops, small enough to live on the stack
+    constexpr size_t kScratchSize = 512;
+
+    size_t fixedWidth(AtomicType type, int32_t type_length)
+    {
+        switch (type)
+        {
+        case AtomicType::INT32:
+        case AtomicType::FLOAT:
+            return 4;
+        case AtomicType::INT64:
+        case AtomicType::DOUBLE:
+            return 8;
+        case AtomicType::FIXED_LEN_BYTE_ARRAY:
+            return static_cast<size_t>(type_length);
+        default:
+            return 0;
+        }
+    }
+
+    uint32_t readLength(const uint8_t *data)
+    {
+        uint32_t length;
+        std::memcpy(&length, data, sizeof(length));
+        return length;
+    }
+
+    class PlainDecoder : public ValueDecoder
+    {
+    public:
+        PlainDecoder(AtomicType type, int32_t type_length, const uint8_t *data, size_t size)
+            : type_(type), width_(fixedWidth(type, type_length)), data_(data), end_(data + size) {}
+
+        size_t decode(ColumnBatch &batch, size_t count) override
+        {
+            switch (type_)
+            {
+            case AtomicType::BOOLEAN:
+                return decodeBooleans(batch, count);
+            case AtomicType::BYTE_ARRAY:
+                return decodeByteArrays(batch, count);
+            default:
+                return decodeFixed(batch, count);
+            }
+        }
+
+        size_t skip(size_t count) override
+        {
+            switch (type_)
+            {
+            case AtomicType::BOOLEAN:
+            {
+                count = std::min(count, static_cast<size_t>(end_ - data_) * 8 - bit_position_);
+                bit_position_ += count;
+                data_ += bit_position_ / 8;
+                bit_position_ %= 8;
+                return count;
+            }
+            case AtomicType::BYTE_ARRAY:
+            {
+                size_t skipped = 0;
+                for (; skipped < count && data_ < end_; ++skipped)
+                {
+                    if (end_ - data_ < 4 || static_cast<size_t>(end_ - data_ - 4) < readLength(data_))
+                    {
+                        throw ParquetException("BYTE_ARRAY value runs past the end of the page");
+                    }
+                    data_ += 4 + readLength(data_);
+                }
+                return skipped;
+            }
+            default:
+                count = std::min(count, static_cast<size_t>(end_ - data_) / width_);
+                data_ += count * width_;
+                return count;
+            }
+        }
+
+    private:
+        size_t decodeFixed(ColumnBatch &batch, size_t count)
+        {
+            count = std::min(count, static_cast<size_t>(end_ - data_) / width_);
+            if (count == 0)
+            {
+                return 0;
+            }
+            std::memcpy(batch.appendValues<uint8_t>(count), data_, count * width_);
+            data_ += count * width_;
+            return count;
+        }
+
+        size_t decodeBooleans(ColumnBatch &batch, size_t count)
+        {
+            size_t available = static_cast<size_t>(end_ - data_) * 8 - bit_position_;
+            count = std::min(count, available);
+            bit_util::unpackBits(data_, bit_position_, count, batch.appendValues<uint8_t>(count));
+            bit_position_ += count;
+            data_ += bit_position_ / 8;
+            bit_position_ %= 8;
+            return count;
+        }
+
+        size_t decodeByteArrays(ColumnBatch &batch, size_t count)
+        {
+            size_t decoded = 0;
+            while (decoded < count && data_ < end_)
+            {
+                decoded += decodeByteArrayRun(batch, std::min(count - decoded, kScratchSize));
+            }
+            return decoded;
+        }
+
+        /**
+         * @brief Decodes up to kScratchSize values: one pass over the length prefixes
+         * validates them and sizes the output, a second one copies the values.
+         */
+        size_t decodeByteArrayRun(ColumnBatch &batch, size_t count)
+        {
+            // Each length locates the next one, so the scan is a dependent chain. Positions
+            // are offsets rather than pointers so that a bogus length cannot overflow them,
+            // and one check after the loop catches a value running past the page.
+            auto size = static_cast<size_t>(end_ - data_);
+            uint32_t lengths[kScratchSize];
+            size_t n = 0;
+            size_t position = 0;
+            for (; n < count && position + 4 <= size; ++n)
+            {
+                lengths[n] = readLength(data_ + position);
+                position += 4 + size_t{lengths[n]};
+            }
+            if (position > size)
+            {
+                throw ParquetException("BYTE_ARRAY value runs past the end of the page");
+            }
+            if (n < count && position < size)
+            {
+                throw ParquetException("Truncated BYTE_ARRAY length");
+            }
+            size_t total_bytes = position - 4 * n;
+
+            auto [offsets, out] = batch.appendByteArrays(n, total_bytes);
+            int32_t offset = offsets[-1];
+            for (size_t i = 0; i < n; ++i)
+            {
+                offset += static_cast<int32_t>(lengths[i]);
+                offsets[i] = offset;
+            }
+            // Values of up to kCopyBytes are copied as kCopyBytes, the overrun landing where
+            // the next value goes, as long as both the page and the output have room for it.
+            // A fixed size copy compiles to two vector moves and, unlike a copy of the exact
+            // length, does not branch on it.
+            constexpr size_t kCopyBytes = 32;
+            uint8_t *out_end = out + total_bytes;
+            for (size_t i = 0, from = 4; i < n; from += 4 + size_t{lengths[i]}, ++i)
+            {
+                size_t length = lengths[i];
+                if (length <= kCopyBytes && from + kCopyBytes <= size &&
+                    static_cast<size_t>(out_end - out) >= kCopyBytes)
+                {
+                    std::memcpy(out, data_ + from, kCopyBytes);
+                }
+                else
+                {
+                    std::memcpy(out, data_ + from, length);
+                }
+                out += length;
+            }
+            data_ += position;
+            return n;
+        }
+
+        AtomicType type_;
+        size_t width_;
+        const uint8_t *data_;
+        const uint8_t *end_;
+        size_t bit_position_ = 0;
+    };
+
+    class RleBooleanDecoder : public ValueDecoder
+    {
+    public:
+        RleBooleanDecoder(const uint8_t *data, size_t size)
+            : decoder_(data + 4, prefixedLength(data, size), 1) {}
+
+        size_t decode(ColumnBatch &batch, size_t count) override
+        {
+            uint8_t *out = batch.appendValues<uint8_t>(count);
+            size_t decoded = decoder_.getBatch(out, count);
+            if (decoded != count)
+            {
+                throw ParquetException("RLE boolean page has fewer values than expected");
+            }
+            return decoded;
+        }
+
+        size_t skip(size_t count) override { return decoder_.skip(count); }
+
+    private:
+        static size_t prefixedLength(const uint8_t *data, size_t size)
+        {
+            if (size < 4 || readLength(data) > size - 4)
+            {
+                throw ParquetException("Invalid RLE boolean length prefix");
+            }
+            return readLength(data);
+        }
+
+        RleBitPackedDecoder decoder_;
+    };
+
+    class DictionaryDecoder : public ValueDecoder
+    {
+    public:
+        DictionaryDecoder(const uint8_t *data, size_t size, std::shared_ptr<const ColumnBatch> dictionary,
+                          bool keep_indices)
+            : decoder_(data + 1, size - 1, bitWidth(data, size)), dictionary_(std::move(dictionary)),
+              keep_indices_(keep_indices) {}
+
+        size_t decode(ColumnBatch &batch, size_t count) override
+        {
+            // A batch that already holds values keeps getting values
+            if (keep_indices_ && (batch.empty() || batch.dictionary() == dictionary_))
+            {
+                if (batch.dictionary() != dictionary_)
+                {
+                    batch.setDictionary(dictionary_);
+                }
+                int32_t *out = batch.appendValues<int32_t>(count);
+                size_t decoded = decoder_.getBatch(out, count);
+                checkIndices(out, decoded);
+                if (decoded != count)
+                {
+                    throw ParquetException("Dictionary page has fewer indices than expected");
+                }
+                return decoded;
+            }
+
+            size_t decoded = 0;
+            int32_t indices[kScratchSize];
+            while (decoded < count)
+            {
+                size_t n = decoder_.getBatch(indices, std::min(count - decoded, kScratchSize));
+                if (n == 0)
+                {
+                    break;
+                }
+                checkIndices(indices, n);
+                gather(batch, indices, n);
+                decoded += n;
+            }
+            return decoded;
+        }
+
+        /**
+         * @brief Skips indices without unpacking them; they are not range checked either,
+         * no value is looked up.
+         */
+        size_t skip(size_t count) override { return decoder_.skip(count); }
+
+    private:
+        static int bitWidth(const uint8_t *data, size_t size)
+        {
+            if (size < 1 || data[0] > 32)
+            {
+                throw ParquetException("Invalid dictionary index bit width");
+            }
+            return data[0];
+        }
+
+        void checkIndices(const int32_t *indices, size_t count) const
+        {
+            auto dictionary_size = static_cast<uint32_t>(dictionary_->length());
+            uint32_t max_index = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                max_index = std::max(max_index, static_cast<uint32_t>(indices[i]));
+            }
+            if (count > 0 && max_index >= dictionary_size)
+            {
+                throw ParquetException("Dictionary index out of range");
+            }
+        }
+
+        void gather(ColumnBatch &batch, const int32_t *indices, size_t count)
+        {
+            if (dictionary_->type() == AtomicType::BYTE_ARRAY)
+            {
+                const int32_t *dict_offsets = dictionary_->offsets();
+                size_t total_bytes = 0;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    total_bytes += static_cast<size_t>(dict_offsets[indices[i] + 1] - dict_offsets[indices[i]]);
+                }
+                auto [offsets, out] = batch.appendByteArrays(count, total_bytes);
+                int32_t offset = offsets[-1];
+                for (size_t i = 0; i < count; ++i)
+                {
+                    std::string_view value = dictionary_->byteArray(static_cast<size_t>(indices[i]));
+                    std::memcpy(out, value.data(), value.size());
+                    out += value.size();
+                    offset += static_cast<int32_t>(value.size());
+                    offsets[i] = offset;
+                }
+                return;
+            }
+
+            size_t width = dictionary_->valueWidth();
+            const uint8_t *values = dictionary_->values<uint8_t>();
+            uint8_t *out = batch.appendValues<uint8_t>(count);
+            switch (width)
+            {
+            case 4:
+                for (size_t i = 0; i < count; ++i)
+                {
+                    reinterpret_cast<uint32_t *>(out)[i] = reinterpret_cast<const uint32_t *>(values)[indices[i]];
+                }
+                break;
+            case 8:
+                for (size_t i = 0; i < count; ++i)
+                {
+                    reinterpret_cast<uint64_t *>(out)[i] = reinterpret_cast<const uint64_t *>(values)[indices[i]];
+                }
+                break;
+            default:
+                for (size_t i = 0; i < count; ++i)
+                {
+                    std::memcpy(out + i * width, values + static_cast<size_t>(indices[i]) * width, width);
+                }
+            }
+        }
+
+        RleBitPackedDecoder decoder_;
+        std::shared_ptr<const ColumnBatch> dictionary_;
+        bool keep_indices_;
+    };
+
+    template <typename T>
+    class DeltaBinaryPackedDecoder : public ValueDecoder
+    {
+    public:
+        DeltaBinaryPackedDecoder(const uint8_t *data, size_t size) : decoder_(data, size) {}
+
+        size_t decode(ColumnBatch &batch, size_t count) override
+        {
+            count = std::min(count, decoder_.remainingValues());
+            return decoder_.getBatch(batch.appendValues<T>(count), count);
+        }
+
+        size_t skip(size_t count) override { return decoder_.skip(count); }
+
+    private:
+        DeltaBitPackDecoder decoder_;
+    };
+
+    class DeltaLengthByteArrayDecoder : public ValueDecoder
+    {
+    public:
+        DeltaLengthByteArrayDecoder(const uint8_t *data, const uint8_t *end) : end_(end)
+        {
+            DeltaBitPackDecoder lengths(data, static_cast<size_t>(end - data));
+            lengths_.resize(lengths.totalValues());
+            if (lengths.getBatch(lengths_.data(), lengths_.size()) != lengths_.size())
+            {
+                throw ParquetException("Truncated DELTA_LENGTH_BYTE_ARRAY lengths");
+            }
+            data_ = lengths.position();
+        }
+
+        size_t decode(ColumnBatch &batch, size_t count) override
+        {
+            count = std::min(count, lengths_.size() - next_);
+            size_t total_bytes = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (lengths_[next_ + i] < 0)
+                {
+                    throw ParquetException("Negative DELTA_LENGTH_BYTE_ARRAY length");
+                }
+                total_bytes += static_cast<size_t>(lengths_[next_ + i]);
+            }
+            if (total_bytes > static_cast<size_t>(end_ - data_))
+            {
+                throw ParquetException("DELTA_LENGTH_BYTE_ARRAY data runs past the end of the page");
+            }
+
+            auto [offsets, out] = batch.appendByteArrays(count, total_bytes);
+            std::memcpy(out, data_, total_bytes);
+            data_ += total_bytes;
+            int32_t offset = offsets[-1];
+            for (size_t i = 0; i < count; ++i)
+            {
+                offset += lengths_[next_ + i];
+                offsets[i] = offset;
+            }
+            next_ += count;
+            return count;
+        }
+
+        size_t skip(size_t count) override
+        {
+            count = std::min(count, lengths_.size() - next_);
+            for (size_t i = 0; i < count; ++i)
+            {
+                next();
+            }
+            return count;
+        }
+
+        /**
+         * @brief Returns the next value without appending it anywhere.
+         */
+        std::string_view next()
+        {
+            if (next_ >= lengths_.size())
+            {
+                throw ParquetException("DELTA_LENGTH_BYTE_ARRAY ran out of values");
+            }
+            auto length = static_cast<size_t>(lengths_[next_++]);
+            if (length > static_cast<size_t>(end_ - data_))
+            {
+                throw ParquetException("DELTA_LENGTH_BYTE_ARRAY data runs past the end of the page");
+            }
+            std::string_view value(reinterpret_cast<const char *>(data_), length);
+            data_ += length;
+            return value;
+        }
+
+        size_t remainingValues() const noexcept { return lengths_.size() - next_; }
+
+    private:
+        std::vector<int32_t> lengths_;
+        size_t next_ = 0;
+        const uint8_t *end_;
+        const uint8_t *data_ = nullptr;
+    };
+
+    class DeltaByteArrayDecoder : public ValueDecoder
+    {
+    public:
+        DeltaByteArrayDecoder(AtomicType type, int32_t type_length, const uint8_t *data, size_t size)
+            : type_(type), type_length_(static_cast<size_t>(type_length)),
+              suffixes_(decodePrefixLengths(data, size), data + size) {}
+
+        size_t decode(ColumnBatch &batch, size_t count) override
+        {
+            count = std::min(count, suffixes_.remainingValues());
+            uint8_t *fixed = type_ == AtomicType::FIXED_LEN_BYTE_ARRAY ? batch.appendValues<uint8_t>(count) : nullptr;
+            for (size_t i = 0; i < count; ++i)
+            {
+                nextValue();
+                if (fixed != nullptr)
+                {
+                    if (last_.size() != type_length_)
+                    {
+                        throw ParquetException("DELTA_BYTE_ARRAY value does not match the fixed length");
+                    }
+                    std::memcpy(fixed + i * type_length_, last_.data(), type_length_);
+                }
+                else
+                {
+                    batch.appendByteArray(reinterpret_cast<const uint8_t *>(last_.data()), last_.size());
+                }
+            }
+            return count;
+        }
+
+        size_t skip(size_t count) override
+        {
+            // Every value shares a prefix with the one before, so the skipped values are
+            // still assembled, just never appended
+            count = std::min(count, suffixes_.remainingValues());
+            for (size_t i = 0; i < count; ++i)
+            {
+                nextValue();
+            }
+            return count;
+        }
+
+    private:
+        void nextValue()
+        {
+            auto prefix = static_cast<size_t>(prefix_lengths_[next_++]);
+            if (prefix > last_.size())
+            {
+                throw ParquetException("DELTA_BYTE_ARRAY prefix is longer than the previous value");
+            }
+            std::string_view suffix = suffixes_.next();
+            last_.resize(prefix);
+            last_.append(suffix);
+        }
+
+        const uint8_t *decodePrefixLengths(const uint8_t *data, size_t size)
+        {
+            DeltaBitPackDecoder decoder(data, size);
+            prefix_lengths_.resize(decoder.totalValues());
+            if (decoder.getBatch(prefix_lengths_.data(), prefix_lengths_.size()) != prefix_lengths_.size())
+            {
+                throw ParquetException("Truncated DELTA_BYTE_ARRAY prefix lengths");
+            }
+            if (std::any_of(prefix_lengths_.begin(), prefix_lengths_.end(), [](int32_t length)
+                            { return length < 0; }))
+            {
+                throw ParquetException("Negative DELTA_BYTE_ARRAY prefix length");
+            }
+            return decoder.position();
+        }
+
+        AtomicType type_;
+        size_t type_length_;
+        std::vector<int32_t> prefix_lengths_;
+        DeltaLengthByteArrayDecoder suffixes_;
+        size_t next_ = 0;
+        std::string last_;
+    };
+
+    class ByteStreamSplitDecoder : public ValueDecoder
+    {
+    public:
+        ByteStreamSplitDecoder(AtomicType type, int32_t type_length, const uint8_t *data, size_t size)
+            : width_(fixedWidth(type, type_length)), data_(data), num_values_(width_ == 0 ? 0 : size / width_)
+        {
+            if (width_ == 0 || size % width_ != 0)
+            {
+                throw ParquetException("BYTE_STREAM_SPLIT page size is not a multiple of the value width");
+            }
+        }
+
+        size_t decode(ColumnBatch &batch, size_t count) override
+        {
+            count = std::min(count, num_values_ - next_);
+            if (count == 0)
+            {
+                return 0;
+            }
+            uint8_t *out = batch.appendValues<uint8_t>(count);
+            switch (width_)
+            {
+            case 4:
+                gather<4>(out, count);
+                break;
+            case 8:
+                gather<8>(out, count);
+                break;
+            default:
+                for (size_t i = 0; i < count; ++i)
+                {
+                    for (size_t b = 0; b < width_; ++b)
+                    {
+                        out[i * width_ + b] = data_[b * num_values_ + next_ + i];
+                    }
+                }
+            }
+            next_ += count;
+            return count;
+        }
+
+        size_t skip(size_t count) override
+        {
+            count = std::min(count, num_values_ - next_);
+            next_ += count;
+            return count;
+        }
+
+    private:
+        template <size_t kWidth>
+        void gather(uint8_t *out, size_t count) const
+        {
+            const uint8_t *streams[kWidth];
+            for (size_t b = 0; b < kWidth; ++b)
+            {
+                streams[b] = data_ + b * num_values_ + next_;
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                for (size_t b = 0; b < kWidth; ++b)
+                {
+                    out[i * kWidth + b] = streams[b][i];
+                }
+            }
+        }
+
+        size_t width_;
+        const uint8_t *data_;
+        size_t num_values_;
+        size_t next_ = 0;
+    };
+} // namespace
+
+RleBitPackedDecoder::RleBitPackedDecoder(const uint8_t *data, size_t size, int bit_width)
+    : data_(data), end_(data + size), bit_width_(bit_width)
+{
+    if (bit_width < 0 || bit_width > 32)
+    {
+        throw ParquetException("Invalid RLE bit width");
+    }
+}
+
+bool RleBitPackedDecoder::nextRun()
+{
+    if (data_ >= end_)
+    {
+        return false;
+    }
+    uint64_t header = bit_util::readUleb128(data_, end_);
+    if (header & 1)
+    {
+        // Bit packed run of (header >> 1) groups of 8 values
+        size_t groups = header >> 1;
+        size_t bytes = groups * static_cast<size_t>(bit_width_);
+        size_t available = static_cast<size_t>(end_ - data_);
+        literal_data_ = data_;
+        literal_position_ = 0;
+        literal_count_ = groups * 8;
+        if (bytes > available)
+        {
+            // Tolerate a truncated final run, as long as the values we hand out exist
+            literal_count_ = bit_width_ == 0 ? literal_count_ : available * 8 / static_cast<size_t>(bit_width_);
+            bytes = available;
+        }
+        data_ += bytes;
+        return literal_count_ > 0;
+    }
+
+    repeat_count_ = header >> 1;
+    size_t value_bytes = static_cast<size_t>(bit_width_ + 7) / 8;
+    if (static_cast<size_t>(end_ - data_) < value_bytes)
+    {
+        throw ParquetException("Truncated RLE run");
+    }
+    repeated_value_ = 0;
+    for (size_t i = 0; i < value_bytes; ++i)
+    {
+        repeated_value_ |= static_cast<uint32_t>(data_[i]) << (8 * i);
+    }
+    data_ += value_bytes;
+    return repeat_count_ > 0 || nextRun();
+}
+
+template <typename T>
+size_t RleBitPackedDecoder::getBatch(T *out, size_t count)
+{
+    size_t decoded = 0;
+    while (decoded < count)
+    {
+        if (repeat_count_ > 0)
+        {
+            size_t n = std::min(count - decoded, repeat_count_);
+            std::fill(out + decoded, out + decoded + n, static_cast<T>(repeated_value_));
+            repeat_count_ -= n;
+            decoded += n;
+        }
+        else if (literal_count_ > 0)
+        {
+            size_t n = std::min(count - decoded, literal_count_);
+            if constexpr (sizeof(T) == sizeof(uint32_t))
+            {
+                bit_util::unpack32(literal_data_, end_, literal_position_, n, bit_width_,
+                                   reinterpret_cast<uint32_t *>(out + decoded));
+            }
+            else
+            {
+                uint32_t scratch[kScratchSize];
+                n = std::min(n, kScratchSize);
+                bit_util::unpack32(literal_data_, end_, literal_position_, n, bit_width_, scratch);
+                std::copy(scratch, scratch + n, out + decoded);
+            }
+            literal_position_ += n;
+            literal_count_ -= n;
+            decoded += n;
+        }
+        else if (!nextRun())
+        {
+            break;
+        }
+    }
+    return decoded;
+}
+
+template size_t RleBitPackedDecoder::getBatch<uint8_t>(uint8_t *, size_t);
+template size_t RleBitPackedDecoder::getBatch<int16_t>(int16_t *, size_t);
+template size_t RleBitPackedDecoder::getBatch<int32_t>(int32_t *, size_t);
+template size_t RleBitPackedDecoder::getBatch<uint32_t>(uint32_t *, size_t);
+
+size_t RleBitPackedDecoder::skip(size_t count)
+{
+    size_t matches = 0;
+    return skipValues<false>(count, 0, matches);
+}
+
+size_t RleBitPackedDecoder::skip(size_t count, uint32_t value, size_t &matches)
+{
+    return skipValues<true>(count, value, matches);
+}
+
+template <bool kCount>
+size_t RleBitPackedDecoder::skipValues(size_t count, uint32_t value, size_t &matches)
+{
+    size_t skipped = 0;
+    while (skipped < count)
+    {
+        if (repeat_count_ > 0)
+        {
+            size_t n = std::min(count - skipped, repeat_count_);
+            if constexpr (kCount)
+            {
+                matches += repeated_value_ == value ? n : 0;
+            }
+            repeat_count_ -= n;
+            skipped += n;
+        }
+        else if (literal_count_ > 0)
+        {
+            size_t n = std::min(count - skipped, literal_count_);
+            if constexpr (kCount)
+            {
+                if (bit_width_ == 1)
+                {
+                    size_t ones = bit_util::countSetBits(literal_data_, literal_position_, n);
+                    matches += value == 1 ? ones : value == 0 ? n - ones : 0;
+                }
+                else
+                {
+                    uint32_t scratch[kScratchSize];
+                    n = std::min(n, kScratchSize);
+                    bit_util::unpack32(literal_data_, end_, literal_position_, n, bit_width_, scratch);
+                    matches += static_cast<size_t>(std::count(scratch, scratch + n, value));
+                }
+            }
+            literal_position_ += n;
+            literal_count_ -= n;
+            skipped += n;
+        }
+        else if (!nextRun())
+        {
+            break;
+        }
+    }
+    return skipped;
+}
+
+DeltaBitPackDecoder::DeltaBitPackDecoder(const uint8_t *data, size_t size)
+    : data_(data), end_(data + size)
+{
+    uint64_t block_size = bit_util::readUleb128(data_, end_);
+    miniblocks_per_block_ = bit_util::readUleb128(data_, end_);
+    total_values_ = bit_util::readUleb128(data_, end_);
+    last_value_ = static_cast<uint64_t>(bit_util::zigzagDecode(bit_util::readUleb128(data_, end_)));
+
+    if (block_size == 0 || block_size % 128 != 0 || miniblocks_per_block_ == 0 ||
+        block_size % miniblocks_per_block_ != 0 || (block_size / miniblocks_per_block_) % 32 != 0)
+    {
+        throw ParquetException("Invalid DELTA_BINARY_PACKED block layout");
+    }
+    values_per_miniblock_ = block_size / miniblocks_per_block_;
+    remaining_ = total_values_;
+    first_pending_ = total_values_ > 0;
+    bit_widths_.resize(miniblocks_per_block_);
+    miniblock_index_ = miniblocks_per_block_;
+}
+
+void DeltaBitPackDecoder::nextMiniblock()
+{
+    if (miniblock_index_ == miniblocks_per_block_)
+    {
+        min_delta_ = static_cast<uint64_t>(bit_util::zigzagDecode(bit_util::readUleb128(data_, end_)));
+        if (static_cast<size_t>(end_ - data_) < miniblocks_per_block_)
+        {
+            throw ParquetException("Truncated DELTA_BINARY_PACKED block header");
+        }
+        std::memcpy(bit_widths_.data(), data_, miniblocks_per_block_);
+        data_ += miniblocks_per_block_;
+        miniblock_index_ = 0;
+    }
+
+    miniblock_bit_width_ = bit_widths_[miniblock_index_++];
+    if (miniblock_bit_width_ > 64)
+    {
+        throw ParquetException("Invalid DELTA_BINARY_PACKED bit width");
+    }
+    size_t bytes = values_per_miniblock_ * static_cast<size_t>(miniblock_bit_width_) / 8;
+    size_t needed = std::min(remaining_, values_per_miniblock_) * static_cast<size_t>(miniblock_bit_width_);
+    if (static_cast<size_t>(end_ - data_) * 8 < needed)
+    {
+        throw ParquetException("Truncated DELTA_BINARY_PACKED miniblock");
+    }
+    miniblock_data_ = data_;
+    data_ += std::min(bytes, static_cast<size_t>(end_ - data_));
+    miniblock_position_ = 0;
+    miniblock_remaining_ = values_per_miniblock_;
+}
+
+template <typename T>
+size_t DeltaBitPackDecoder::getBatch(T *out, size_t count)
+{
+    count = std::min(count, remaining_);
+    size_t decoded = 0;
+    if (count > 0 && first_pending_)
+    {
+        out[decoded++] = static_cast<T>(last_value_);
+        first_pending_ = false;
+        --remaining_;
+    }
+
+    uint64_t deltas[kScratchSize];
+    while (decoded < count)
+    {
+        if (miniblock_remaining_ == 0)
+        {
+            nextMiniblock();
+        }
+        size_t n = std::min({count - decoded, miniblock_remaining_, kScratchSize});
+        bit_util::unpack64(miniblock_data_, end_, miniblock_position_, n, miniblock_bit_width_, deltas);
+        // Unsigned arithmetic gives the two's complement wrap around the spec asks for
+        uint64_t value = last_value_;
+        for (size_t i = 0; i < n; ++i)
+        {
+            value += min_delta_ + deltas[i];
+            out[decoded + i] = static_cast<T>(value);
+        }
+        last_value_ = value;
+        miniblock_position_ += n;
+        miniblock_remaining_ -= n;
+        remaining_ -= n;
+        decoded += n;
+    }
+    return decoded;
+}
+
+template size_t DeltaBitPackDecoder::getBatch<int32_t>(int32_t *, size_t);
+template size_t DeltaBitPackDecoder::getBatch<int64_t>(int64_t *, size_t);
+
+size_t DeltaBitPackDecoder::skip(size_t count)
+{
+    // The wrap around happens in 64 bits either way, so int64_t scratch suits both types
+    int64_t scratch[kScratchSize];
+    size_t skipped = 0;
+    while (skipped < count)
+    {
+        size_t n = getBatch(scratch, std::min(count - skipped, kScratchSize));
+        if (n == 0)
+        {
+            break;
+        }
+        skipped += n;
+    }
+    return skipped;
+}
+
+size_t ValueDecoder::decodeSpaced(ColumnBatch &batch, const int16_t *def_levels, size_t count,
+                                  int16_t max_def_level)
+{
+    size_t first = batch.length();
+    size_t valid = batch.appendValidity(def_levels, count, max_def_level);
+    if (decode(batch, valid) != valid)
+    {
+        throw ParquetException("Page has fewer values than its definition levels");
+    }
+    batch.spread(first, count);
+    return count;
+}
+
+std::shared_ptr<ColumnBatch> decodeDictionaryPage(AtomicType type, int32_t type_length, const uint8_t *data,
+                                                  size_t size, size_t num_values)
+{
+    auto dictionary = std::make_shared<ColumnBatch>(type, type_length);
+    PlainDecoder decoder(type, type_length, data, size);
+    if (decoder.decode(*dictionary, num_values) != num_values)
+    {
+        throw ParquetException("Dictionary page has fewer values than its header");
+    }
+    return dictionary;
+}
+
+std::unique_ptr<ValueDecoder> makeValueDecoder(Encoding encoding, AtomicType type, int32_t type_length,
+                                               const uint8_t *data, size_t size,
+                                               std::shared_ptr<const ColumnBatch> dictionary,
+                                               bool keep_dictionary_indices)
+{
+    switch (encoding)
+    {
+    case Encoding::PLAIN:
+        return std::make_unique<PlainDecoder>(type, type_length, data, size);
+    case Encoding::PLAIN_DICTIONARY:
+    case Encoding::RLE_DICTIONARY:
+        if (dictionary == nullptr)
+        {
+            throw ParquetException("Dictionary encoded page without a dictionary page");
+        }
+        return std::make_unique<DictionaryDecoder>(data, size, std::move(dictionary), keep_dictionary_indices);
+    case Encoding::RLE:
+        if (type == AtomicType::BOOLEAN)
+        {
+            return std::make_unique<RleBooleanDecoder>(data, size);
+        }
+        break;
+    case Encoding::DELTA_BINARY_PACKED:
+        if (type == AtomicType::INT32)
+        {
+            return std::make_unique<DeltaBinaryPackedDecoder<int32_t>>(data, size);
+        }
+        if (type == AtomicType::INT64)
+        {
+            return std::make_unique<DeltaBinaryPackedDecoder<int64_t>>(data, size);
+        }
+        break;
+    case Encoding::DELTA_LENGTH_BYTE_ARRAY:
+        if (type == AtomicType::BYTE_ARRAY)
+        {
+            return std::make_unique<DeltaLengthByteArrayDecoder>(data, data + size);
+        }
+        break;
+    case Encoding::DELTA_BYTE_ARRAY:
+        if (type == AtomicType::BYTE_ARRAY || type == AtomicType::FIXED_LEN_BYTE_ARRAY)
+        {
+            return std::make_unique<DeltaByteArrayDecoder>(type, type_length, data, size);
+        }
+        break;
+    case Encoding::BYTE_STREAM_SPLIT:
+        if (type != AtomicType::BOOLEAN && type != AtomicType::BYTE_ARRAY)
+        {
+            return std::make_unique<ByteStreamSplitDecoder>(type, type_length, data, size);
+        }
+        break;
+    default:
+        break;
+    }
+    throw ParquetException("Unsupported encoding " + std::to_string(static_cast<int>(encoding)) +
+                           " for this column type");
+}
+
+template <typename T>
+void encodeRleBitPacked(const T *values, size_t count, int bit_width, std::vector<uint8_t> &out)
+{
+    using Unsigned = std::make_unsigned_t<T>;
+    uint8_t varint[10];
+    size_t value_bytes = bit_util::bytesForBits(static_cast<size_t>(bit_width));
+
+    // Bit packs [literal_start, end), padding the last group of 8 with zeros
+    size_t literal_start = 0;
+    auto flushLiterals = [&](size_t end)
+    {
+        if (end == literal_start)
+        {
+            return;
+        }
+        size_t n = end - literal_start;
+        size_t groups = (n + 7) / 8;
+        out.insert(out.end(), varint, varint + bit_util::writeUleb128(groups << 1 | 1, varint));
+        uint64_t bits = 0;
+        int pending = 0;
+        for (size_t i = 0; i < groups * 8; ++i)
+        {
+            uint64_t value = i < n ? static_cast<Unsigned>(values[literal_start + i]) : 0;
+            bits |= value << pending;
+            pending += bit_width;
+            while (pending >= 8)
+            {
+                out.push_back(static_cast<uint8_t>(bits));
+                bits >>= 8;
+                pending -= 8;
+            }
+        }
+        literal_start = end;
+    };
+
+    size_t i = 0;
+    while (i < count)
+    {
+        size_t run = 1;
+        while (i + run < count && values[i + run] == values[i])
+        {
+            ++run;
+        }
+        // A literal run must hold whole groups of 8, so it borrows the first values of the
+        // repeated run to complete its last group
+        size_t pad = (8 - (i - literal_start) % 8) % 8;
+        if (run >= pad + 8)
+        {
+            flushLiterals(i + pad);
+            out.insert(out.end(), varint, varint + bit_util::writeUleb128((run - pad) << 1, varint));
+            uint32_t value = static_cast<Unsigned>(values[i]);
+            for (size_t b = 0; b < value_bytes; ++b)
+            {
+                out.push_back(static_cast<uint8_t>(value >> (8 * b)));
+            }
+            literal_start = i + run;
+        }
+        i += run;
+    }
+    flushLiterals(count);
+}
+
+template void encodeRleBitPacked<int16_t>(const int16_t *, size_t, int, std::vector<uint8_t> &);
+template void encodeRleBitPacked<uint32_t>(const uint32_t *, size_t, int, std::vector<uint8_t> &);
+
+void encodePlain(const ColumnBatch &batch, size_t first, size_t count, std::vector<uint8_t> &out)
+{
+    if (batch.isDictionaryEncoded())
+    {
+        throw std::invalid_argument("PLAIN encoding needs materialized values");
+    }
+    const uint8_t *validity = batch.validity();
+    auto valid = [validity](size_t i)
+    { return validity == nullptr || bit_util::getBit(validity, i); };
+
+    switch (batch.type())
+    {
+    case AtomicType::BOOLEAN:
+    {
+        const uint8_t *values = batch.values<uint8_t>();
+        uint8_t bits = 0;
+        int pending = 0;
+        for (size_t i = first; i < first + count; ++i)
+        {
+            if (!valid(i))
+            {
+                continue;
+            }
+            bits |= static_cast<uint8_t>((values[i] != 0) << pending);
+            if (++pending == 8)
+            {
+                out.push_back(bits);
+                bits = 0;
+                pending = 0;
+            }
+        }
+        if (pending > 0)
+        {
+            out.push_back(bits);
+        }
+        break;
+    }
+    case AtomicType::BYTE_ARRAY:
+        for (size_t i = first; i < first + count; ++i)
+        {
+            if (!valid(i))
+            {
+                continue;
+            }
+            std::string_view value = batch.byteArray(i);
+            uint32_t length = static_cast<uint32_t>(value.size());
+            const uint8_t *length_bytes = reinterpret_cast<const uint8_t *>(&length);
+            out.insert(out.end(), length_bytes, length_bytes + sizeof(length));
+            out.insert(out.end(), value.begin(), value.end());
+        }
+        break;
+    default:
+    {
+        size_t width = batch.valueWidth();
+        const uint8_t *values = batch.values<uint8_t>();
+        if (validity == nullptr)
+        {
+            out.insert(out.end(), values + first * width, values + (first + count) * width);
+            break;
+        }
+        // Copy runs of present values at once
+        size_t i = first;
+        while (i < first + count)
+        {
+            while (i < first + count && !valid(i))
+            {
+                ++i;
+            }
+            size_t run_start = i;
+            while (i < first + count && valid(i))
+            {
+                ++i;
+            }
+            out.insert(out.end(), values + run_start * width, values + i * width);
+        }
+        break;
+    }
+    }
+}
+
+template <typename T>
+void encodeDeltaBinaryPacked(const T *values, size_t count, std::vector<uint8_t> &out)
+{
+    using Unsigned = std::make_unsigned_t<T>;
+    constexpr size_t kBlockSize = 128;
+    constexpr size_t kMiniblocks = 4;
+    constexpr size_t kMiniblockSize = kBlockSize / kMiniblocks;
+    uint8_t varint[10];
+    auto appendUleb128 = [&out, &varint](uint64_t value)
+    { out.insert(out.end(), varint, varint + bit_util::writeUleb128(value, varint)); };
+
+    appendUleb128(kBlockSize);
+    appendUleb128(kMiniblocks);
+    appendUleb128(count);
+    appendUleb128(bit_util::zigzagEncode(count == 0 ? 0 : values[0]));
+    uint64_t deltas[kBlockSize];
+    for (size_t start = 1; start < count; start += kBlockSize)
+    {
+        size_t n = std::min(count - start, kBlockSize);
+        T min_delta = std::numeric_limits<T>::max();
+        for (size_t i = 0; i < n; ++i)
+        {
+            auto delta = static_cast<Unsigned>(static_cast<Unsigned>(values[start + i]) -
+                                               static_cast<Unsigned>(values[start + i - 1]));
+            deltas[i] = delta;
+            min_delta = std::min(min_delta, static_cast<T>(delta));
+        }
+        appendUleb128(bit_util::zigzagEncode(min_delta));
+
+        uint8_t widths[kMiniblocks] = {};
+        for (size_t i = 0; i < kBlockSize; ++i)
+        {
+            deltas[i] = i < n ? static_cast<Unsigned>(static_cast<Unsigned>(deltas[i]) - static_cast<Unsigned>(min_delta))
+                              : 0;
+            widths[i / kMiniblockSize] =
+                std::max(widths[i / kMiniblockSize], static_cast<uint8_t>(bit_util::bitWidth(deltas[i])));
+        }
+        out.insert(out.end(), widths, widths + kMiniblocks);
+        for (size_t m = 0; m * kMiniblockSize < n; ++m)
+        {
+            size_t offset = out.size();
+            out.resize(offset + kMiniblockSize * widths[m] / 8);
+            bit_util::pack64(deltas + m * kMiniblockSize, kMiniblockSize, widths[m], out.data() + offset);
+        }
+    }
+}
+
+template void encodeDeltaBinaryPacked<int32_t>(const int32_t *, size_t, std::vector<uint8_t> &);
+template void encodeDeltaBinaryPacked<int64_t>(const int64_t *, size_t, std::vector<uint8_t> &);
+
+void encodeDeltaByteArray(const ColumnBatch &batch, size_t first, size_t count, std::vector<uint8_t> &out)
+{
+    std::vector<std::string_view> suffixes;
+    std::vector<int32_t> prefix_lengths;
+    std::vector<int32_t> suffix_lengths;
+    std::string_view previous;
+    for (size_t i = first; i < first + count; ++i)
+    {
+        if (!batch.isValid(i))
+        {
+            continue;
+        }
+        std::string_view value = batch.byteArray(i);
+        size_t prefix = 0;
+        size_t max_prefix = std::min(value.size(), previous.size());
+        while (prefix < max_prefix && value[prefix] == previous[prefix])
+        {
+            ++prefix;
+        }
+        prefix_lengths.push_back(static_cast<int32_t>(prefix));
+        suffix_lengths.push_back(static_cast<int32_t>(value.size() - prefix));
+        suffixes.push_back(value.substr(prefix));
+        previous = value;
+    }
+    encodeDeltaBinaryPacked(prefix_lengths.data(), prefix_lengths.size(), out);
+    encodeDeltaBinaryPacked(suffix_lengths.data(), suffix_lengths.size(), out);
+    for (std::string_view suffix : suffixes)
+    {
+        out.insert(out.end(), suffix.begin(), suffix.end());
+    }
+}
+
+void encodeByteStreamSplit(const ColumnBatch &batch, size_t first, size_t count, std::vector<uint8_t> &out)
+{
+    size_t width = batch.valueWidth();
+    if (width == 0 || batch.type() == AtomicType::BOOLEAN || batch.isDictionaryEncoded())
+    {
+        throw std::invalid_argument("BYTE_STREAM_SPLIT encoding needs fixed width values");
+    }
+    size_t n = count - (batch.validity() ? count - bit_util::countSetBits(batch.validity(), first, count) : 0);
+    size_t offset = out.size();
+    out.resize(offset + n * width);
+    uint8_t *streams = out.data() + offset;
+    const uint8_t *values = batch.values<uint8_t>();
+    size_t j = 0;
+    for (size_t i = first; i < first + count; ++i)
+    {
+        if (!batch.isValid(i))
+        {
+            continue;
+        }
+        for (size_t b = 0; b < width; ++b)
+        {
+            streams[b * n + j] = values[i * width + b];
+        }
+        ++j;
+    }
+}
+
+DictionaryEncoder::DictionaryEncoder(const ColumnBatch &batch, size_t max_dictionary_bytes)
+    : batch_(batch), indices_(batch.length(), 0)
+{
+    if (batch.type() == AtomicType::BOOLEAN || batch.isDictionaryEncoded())
+    {
+        throw std::invalid_argument("Cannot build a dictionary of this batch");
+    }
+    size_t width = batch.valueWidth();
+    switch (batch.type() == AtomicType::BYTE_ARRAY ? 0 : width)
+    {
+    case 4:
+        indexValues<uint32_t>(width, max_dictionary_bytes);
+        break;
+    case 8:
+        indexValues<uint64_t>(width, max_dictionary_bytes);
+        break;
+    default:
+        indexValues<std::string_view>(width, max_dictionary_bytes);
+    }
+}
+
+template <typename Key>
+void DictionaryEncoder::indexValues(size_t width, size_t max_dictionary_bytes)
+{
+    std::unordered_map<Key, uint32_t> index;
+    for (size_t i = 0; i < batch_.length(); ++i)
+    {
+        if (!batch_.isValid(i))
+        {
+            continue;
+        }
+        Key key;
+        if constexpr (std::is_same_v<Key, std::string_view>)
+        {
+            key = batch_.byteArray(i);
+        }
+        else
+        {
+            std::memcpy(&key, batch_.values<uint8_t>() + i * sizeof(Key), sizeof(Key));
+        }
+        auto [it, inserted] = index.try_emplace(key, static_cast<uint32_t>(entries_.size()));
+        if (inserted)
+        {
+            if constexpr (std::is_same_v<Key, std::string_view>)
+            {
+                dictionary_bytes_ += batch_.type() == AtomicType::BYTE_ARRAY ? sizeof(uint32_t) + key.size() : width;
+            }
+            else
+            {
+                dictionary_bytes_ += width;
+            }
+            if (dictionary_bytes_ > max_dictionary_bytes)
+            {
+                complete_ = false;
+                indices_.clear();
+                entries_.clear();
+                return;
+            }
+            entries_.push_back(i);
+        }
+        indices_[i] = it->second;
+    }
+}
+
+int DictionaryEncoder::bitWidth() const noexcept
+{
+    return std::max(bit_util::bitWidth(std::max<size_t>(entries_.size(), 1) - 1), 1);
+}
+
+void DictionaryEncoder::encodeDictionary(std::vector<uint8_t> &out) const
+{
+    size_t width = batch_.valueWidth();
+    for (size_t slot : entries_)
+    {
+        if (batch_.type() == AtomicType::BYTE_ARRAY)
+        {
+            std::string_view value = batch_.byteArray(slot);
+            auto length = static_cast<uint32_t>(value.size());
+            const uint8_t *length_bytes = reinterpret_cast<const uint8_t *>(&length);
+            out.insert(out.end(), length_bytes, length_bytes + sizeof(length));
+            out.insert(out.end(), value.begin(), value.end());
+        }
+        else
+        {
+            const uint8_t *value = batch_.values<uint8_t>() + slot * width;
+            out.insert(out.end(), value, value + width);
+        }
+    }
+}
+
+void DictionaryEncoder::encodeIndices(size_t first, size_t count, std::vector<uint8_t> &out) const
+{
+    std::vector<uint32_t> indices;
+    indices.reserve(count);
+    for (size_t i = first; i < first + count; ++i)
+    {
+        if (batch_.isValid(i))
+        {
+            indices.push_back(indices_[i]);
+        }
+    }
+    int bit_width = bitWidth();
+    out.push_back(static_cast<uint8_t>(bit_width));
+    encodeRleBitPacked(indices.data(), indices.size(), bit_width, out);
+}
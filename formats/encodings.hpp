@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "column_batch.hpp"
+#include "parquet.hpp"
+
+// Page value decoders. Every decoder writes straight into a ColumnBatch, a batch of
+// values at a time, so the hot loops never go through a per-value virtual call.
+//
+// Encoding specification:
+// https://github.com/apache/parquet-format/blob/master/Encodings.md
+
+/**
+ * @brief Decoder for the RLE / bit-packing hybrid encoding, used for repetition and
+ * definition levels, dictionary indices and RLE encoded booleans.
+ *
+ * `data` must point right after the optional 4 byte length prefix.
+ */
+class RleBitPackedDecoder
+{
+public:
+    RleBitPackedDecoder(const uint8_t *data, size_t size, int bit_width);
+
+    /**
+     * @brief Decodes up to `count` values into `out`.
+     * @tparam T uint8_t, int16_t, int32_t or uint32_t
+     * @return The number of values decoded, less than `count` only at the end of the data
+     */
+    template <typename T>
+    size_t getBatch(T *out, size_t count);
+
+    /**
+     * @brief Skips up to `count` values without unpacking them.
+     * @return The number of values skipped, less than `count` only at the end of the data
+     */
+    size_t skip(size_t count);
+
+    /**
+     * @brief Skips up to `count` values like skip() and adds the number of skipped values
+     * equal to `value` to `matches`, which only unpacks bit packed runs wider than 1 bit.
+     */
+    size_t skip(size_t count, uint32_t value, size_t &matches);
+
+private:
+    bool nextRun();
+
+    template <bool kCount>
+    size_t skipValues(size_t count, uint32_t value, size_t &matches);
+
+    const uint8_t *data_;
+    const uint8_t *end_;
+    int bit_width_;
+
+    uint32_t repeated_value_ = 0;
+    size_t repeat_count_ = 0;
+
+    const uint8_t *literal_data_ = nullptr;
+    size_t literal_count_ = 0;
+    size_t literal_position_ = 0;
+};
+
+/**
+ * @brief Decoder for DELTA_BINARY_PACKED integers. Also decodes the lengths used by the
+ * DELTA_LENGTH_BYTE_ARRAY and DELTA_BYTE_ARRAY encodings.
+ */
+class DeltaBitPackDecoder
+{
+public:
+    DeltaBitPackDecoder(const uint8_t *data, size_t size);
+
+    /**
+     * @brief Decodes up to `count` values into `out`.
+     * @tparam T int32_t or int64_t; arithmetic wraps around like the encoder's did
+     * @return The number of values decoded
+     */
+    template <typename T>
+    size_t getBatch(T *out, size_t count);
+
+    /**
+     * @brief Skips up to `count` values. Every value is the sum of the deltas before it,
+     * so the skipped miniblocks are still unpacked, into scratch space.
+     * @return The number of values skipped
+     */
+    size_t skip(size_t count);
+
+    size_t totalValues() const noexcept { return total_values_; }
+    size_t remainingValues() const noexcept { return remaining_; }
+
+    /**
+     * @brief The first byte after the encoded values, valid once all values are decoded.
+     */
+    const uint8_t *position() const noexcept { return data_; }
+
+private:
+    void nextMiniblock();
+
+    const uint8_t *data_;
+    const uint8_t *end_;
+
+    size_t values_per_miniblock_ = 0;
+    size_t miniblocks_per_block_ = 0;
+    size_t total_values_ = 0;
+    size_t remaining_ = 0;
+    bool first_pending_ = true;
+    uint64_t last_value_ = 0;
+
+    uint64_t min_delta_ = 0;
+    std::vector<uint8_t> bit_widths_;
+    size_t miniblock_index_ = 0;
+    const uint8_t *miniblock_data_ = nullptr;
+    int miniblock_bit_width_ = 0;
+    size_t miniblock_position_ = 0;
+    size_t miniblock_remaining_ = 0;
+};
+
+/**
+ * @brief Decodes the values section of a data page into a ColumnBatch.
+ */
+class ValueDecoder
+{
+public:
+    virtual ~ValueDecoder() = default;
+
+    /**
+     * @brief Appends up to `count` non-null values to `batch`.
+     * @return The number of values appended, less than `count` only at the end of the page
+     * @throws ParquetException on corrupt data
+     */
+    virtual size_t decode(ColumnBatch &batch, size_t count) = 0;
+
+    /**
+     * @brief Skips up to `count` non-null values without materializing them: fixed width
+     * and dictionary encoded values are skipped by moving a position, byte arrays by
+     * walking their lengths.
+     * @return The number of values skipped, less than `count` only at the end of the page
+     * @throws ParquetException on corrupt data
+     */
+    virtual size_t skip(size_t count) = 0;
+
+    /**
+     * @brief Appends `count` slots to `batch`, where slots whose definition level is below
+     * `max_def_level` are null and the others get the next decoded value.
+     * @throws ParquetException if the page runs out of values
+     */
+    size_t decodeSpaced(ColumnBatch &batch, const int16_t *def_levels, size_t count, int16_t max_def_level);
+};
+
+/**
+ * @brief Decodes a PLAIN encoded dictionary page into a standalone batch.
+ */
+std::shared_ptr<ColumnBatch> decodeDictionaryPage(AtomicType type, int32_t type_length, const uint8_t *data,
+                                                  size_t size, size_t num_values);
+
+/**
+ * @brief Creates the decoder for a data page encoded with `encoding`.
+ *
+ * Dictionary encoded pages need the decoded `dictionary`. With `keep_dictionary_indices`
+ * the decoder appends the indices to a dictionary encoded batch instead of materializing
+ * the values, which lets downstream operators work directly on the codes.
+ *
+ * @throws ParquetException if the encoding is not supported for `type`
+ */
+std::unique_ptr<ValueDecoder> makeValueDecoder(Encoding encoding, AtomicType type, int32_t type_length,
+                                               const uint8_t *data, size_t size,
+                                               std::shared_ptr<const ColumnBatch> dictionary = nullptr,
+                                               bool keep_dictionary_indices = false);
+
+/**
+ * @brief Appends `count` values encoded with the RLE / bit-packing hybrid encoding to
+ * `out`, without the length prefix. Runs of at least 8 equal values become RLE runs, the
+ * rest is bit packed in groups of 8 (the last group padded with zeros).
+ * @tparam T int16_t (levels) or uint32_t (dictionary indices)
+ */
+template <typename T>
+void encodeRleBitPacked(const T *values, size_t count, int bit_width, std::vector<uint8_t> &out);
+
+/**
+ * @brief Appends the PLAIN encoding of the non-null values in slots [first, first + count)
+ * of `batch` to `out`.
+ * @throws std::invalid_argument if `batch` is dictionary encoded
+ */
+void encodePlain(const ColumnBatch &batch, size_t first, size_t count, std::vector<uint8_t> &out);
+
+/**
+ * @brief Appends the DELTA_BINARY_PACKED encoding of `count` values to `out`, in blocks
+ * of 128 values with 4 miniblocks each.
+ * @tparam T int32_t or int64_t; deltas wrap around in T, so they never need more bits
+ * than T has
+ */
+template <typename T>
+void encodeDeltaBinaryPacked(const T *values, size_t count, std::vector<uint8_t> &out);
+
+/**
+ * @brief Appends the DELTA_BYTE_ARRAY encoding of the non-null values in slots
+ * [first, first + count) of a BYTE_ARRAY or FIXED_LEN_BYTE_ARRAY batch to `out`: the
+ * lengths of the prefixes shared with the previous value, then the suffixes as
+ * DELTA_LENGTH_BYTE_ARRAY.
+ */
+void encodeDeltaByteArray(const ColumnBatch &batch, size_t first, size_t count, std::vector<uint8_t> &out);
+
+/**
+ * @brief Appends the BYTE_STREAM_SPLIT encoding of the non-null values in slots
+ * [first, first + count) of a fixed width batch (INT32, INT64, FLOAT, DOUBLE or
+ * FIXED_LEN_BYTE_ARRAY) to `out`: byte k of every value goes to stream k, which makes
+ * floating point data compress better without changing its size.
+ */
+void encodeByteStreamSplit(const ColumnBatch &batch, size_t first, size_t count, std::vector<uint8_t> &out);
+
+/**
+ * @brief The dictionary of a column chunk, for writing a dictionary page and
+ * RLE_DICTIONARY data pages. Every distinct non-null value gets the index of its first
+ * occurrence; floating point values are told apart by their bits, so -0.0 and NaN
+ * payloads survive the round trip.
+ */
+class DictionaryEncoder
+{
+public:
+    /**
+     * @brief Indexes the non-null values of `batch`, which must outlive the encoder, and
+     * gives up once the dictionary page would exceed `max_dictionary_bytes`.
+     * @throws std::invalid_argument for BOOLEAN or dictionary encoded batches
+     */
+    DictionaryEncoder(const ColumnBatch &batch, size_t max_dictionary_bytes);
+
+    /**
+     * @brief False if the dictionary outgrew its limit; nothing can be encoded then.
+     */
+    bool complete() const noexcept { return complete_; }
+
+    /// Number of distinct values
+    size_t size() const noexcept { return entries_.size(); }
+
+    /// Size of the PLAIN encoded dictionary page
+    size_t dictionaryBytes() const noexcept { return dictionary_bytes_; }
+
+    int bitWidth() const noexcept;
+
+    /**
+     * @brief Appends the dictionary page, i.e. the distinct values PLAIN encoded.
+     */
+    void encodeDictionary(std::vector<uint8_t> &out) const;
+
+    /**
+     * @brief Appends the RLE_DICTIONARY encoding of the non-null slots in
+     * [first, first + count): the bit width, then the indices RLE / bit-packed.
+     */
+    void encodeIndices(size_t first, size_t count, std::vector<uint8_t> &out) const;
+
+private:
+    template <typename Key>
+    void indexValues(size_t width, size_t max_dictionary_bytes);
+
+    const ColumnBatch &batch_;
+
+    // One per slot, 0 for nulls
+    std::vector<uint32_t> indices_;
+
+    // Slot of the first occurrence of every dictionary entry
+    std::vector<size_t> entries_;
+    size_t dictionary_bytes_ = 0;
+    bool complete_ = true;
+};
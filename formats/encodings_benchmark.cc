@@ -0,0 +1,333 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "basics/benchmark_data.h"
+#include "encodings.hpp"
+
+// Encoding and decoding throughput of the page encodings over 1K to 1M values
+// (BENCHMARK_MAX_SIZE raises the limit), decoded into a ColumnBatch a kDefaultBatchSize
+// batch at a time the way ColumnChunkReader does:
+// - PLAIN for BOOLEAN, INT32, INT64, FLOAT, DOUBLE, FIXED_LEN_BYTE_ARRAY (16 bytes) and
+//   BYTE_ARRAY (1000 strings of 8 to 24 characters), reported in bytes of page per second
+// - the RLE / bit-packing hybrid for dictionary indices of 1 to 20 bits, as random values
+//   (bit packed) and as runs of 16 on average (mostly RLE runs)
+// - RLE_DICTIONARY with 1000 INT64 or BYTE_ARRAY entries, materialized or kept as indices
+// - DELTA_BINARY_PACKED for ascending INT64, DELTA_LENGTH_BYTE_ARRAY and DELTA_BYTE_ARRAY
+// - BYTE_STREAM_SPLIT for DOUBLE
+
+namespace
+{
+    // The type length of the FIXED_LEN_BYTE_ARRAY columns, that of a UUID
+    constexpr int32_t kFixedLength = 16;
+
+    int32_t typeLength(AtomicType type)
+    {
+        return type == AtomicType::FIXED_LEN_BYTE_ARRAY ? kFixedLength : 0;
+    }
+
+    void valueCounts(benchmark::internal::Benchmark *benchmark)
+    {
+        for (int64_t n : benchmarkSizes(1000000))
+        {
+            benchmark->Arg(n);
+        }
+    }
+
+    std::shared_ptr<ColumnBatch> batchOf(AtomicType type, size_t n, uint64_t seed)
+    {
+        auto batch = std::make_shared<ColumnBatch>(type, typeLength(type));
+        switch (type)
+        {
+        case AtomicType::BOOLEAN:
+        {
+            std::vector<uint64_t> values = uniformIntegers(n, 2, seed);
+            std::copy(values.begin(), values.end(), batch->appendValues<uint8_t>(n));
+            break;
+        }
+        case AtomicType::INT32:
+        {
+            std::vector<uint64_t> values = uniformIntegers(n, uint64_t{1} << 31, seed);
+            std::copy(values.begin(), values.end(), batch->appendValues<int32_t>(n));
+            break;
+        }
+        case AtomicType::INT64:
+        {
+            std::vector<uint64_t> values = uniformIntegers(n, uint64_t{1} << 63, seed);
+            std::copy(values.begin(), values.end(), batch->appendValues<int64_t>(n));
+            break;
+        }
+        case AtomicType::FLOAT:
+        {
+            std::vector<double> values = uniformDoubles(n, seed);
+            std::copy(values.begin(), values.end(), batch->appendValues<float>(n));
+            break;
+        }
+        case AtomicType::DOUBLE:
+        {
+            std::vector<double> values = uniformDoubles(n, seed);
+            std::copy(values.begin(), values.end(), batch->appendValues<double>(n));
+            break;
+        }
+        case AtomicType::FIXED_LEN_BYTE_ARRAY:
+        {
+            std::vector<uint64_t> values = uniformIntegers(n * kFixedLength, 256, seed);
+            std::copy(values.begin(), values.end(), batch->appendValues<uint8_t>(n));
+            break;
+        }
+        default:
+            for (const std::string &value : randomStrings(n, 1000, 8, 24, seed))
+            {
+                batch->appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+            }
+        }
+        return batch;
+    }
+
+    /**
+     * @brief Decodes the `count` values of a page, batch by batch, into `batch`.
+     */
+    size_t decodePage(ValueDecoder &decoder, ColumnBatch &batch, size_t count)
+    {
+        size_t decoded = 0;
+        while (decoded < count)
+        {
+            decoded += decoder.decode(batch, std::min(kDefaultBatchSize, count - decoded));
+        }
+        return decoded;
+    }
+
+    void rleArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"bit_width", "runs", "values"});
+        for (int64_t bit_width : {1, 4, 12, 20})
+        {
+            for (int64_t runs : {0, 1})
+            {
+                for (int64_t n : benchmarkSizes(1000000))
+                {
+                    benchmark->Args({bit_width, runs, n});
+                }
+            }
+        }
+    }
+
+    std::vector<uint32_t> rleValues(const benchmark::State &state)
+    {
+        uint64_t distinct = uint64_t{1} << state.range(0);
+        auto n = static_cast<size_t>(state.range(2));
+        std::vector<uint64_t> values = state.range(1) ? runIntegers(n, distinct, 16, 1)
+                                                      : uniformIntegers(n, distinct, 1);
+        return {values.begin(), values.end()};
+    }
+} // namespace
+
+static void BM_PlainEncode(benchmark::State &state, AtomicType type)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    std::shared_ptr<ColumnBatch> batch = batchOf(type, n, 1);
+    std::vector<uint8_t> page;
+    for (auto _ : state)
+    {
+        page.clear();
+        encodePlain(*batch, 0, n, page);
+        benchmark::DoNotOptimize(page.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * page.size()));
+}
+
+static void BM_PlainDecode(benchmark::State &state, AtomicType type)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> page;
+    encodePlain(*batchOf(type, n, 1), 0, n, page);
+    ColumnBatch batch(type, typeLength(type));
+    for (auto _ : state)
+    {
+        batch.clear();
+        auto decoder = makeValueDecoder(Encoding::PLAIN, type, typeLength(type), page.data(), page.size());
+        benchmark::DoNotOptimize(decodePage(*decoder, batch, n));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * page.size()));
+}
+
+BENCHMARK_CAPTURE(BM_PlainEncode, boolean, AtomicType::BOOLEAN)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainEncode, int32, AtomicType::INT32)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainEncode, int64, AtomicType::INT64)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainEncode, float, AtomicType::FLOAT)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainEncode, double, AtomicType::DOUBLE)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainEncode, fixed_len_byte_array, AtomicType::FIXED_LEN_BYTE_ARRAY)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainEncode, byte_array, AtomicType::BYTE_ARRAY)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainDecode, boolean, AtomicType::BOOLEAN)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainDecode, int32, AtomicType::INT32)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainDecode, int64, AtomicType::INT64)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainDecode, float, AtomicType::FLOAT)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainDecode, double, AtomicType::DOUBLE)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainDecode, fixed_len_byte_array, AtomicType::FIXED_LEN_BYTE_ARRAY)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_PlainDecode, byte_array, AtomicType::BYTE_ARRAY)->Apply(valueCounts);
+
+static void BM_RleBitPackedEncode(benchmark::State &state)
+{
+    std::vector<uint32_t> values = rleValues(state);
+    std::vector<uint8_t> encoded;
+    for (auto _ : state)
+    {
+        encoded.clear();
+        encodeRleBitPacked(values.data(), values.size(), static_cast<int>(state.range(0)), encoded);
+        benchmark::DoNotOptimize(encoded.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * values.size()));
+    state.counters["bytes_per_value"] = static_cast<double>(encoded.size()) / static_cast<double>(values.size());
+}
+
+static void BM_RleBitPackedDecode(benchmark::State &state)
+{
+    std::vector<uint32_t> values = rleValues(state);
+    std::vector<uint8_t> encoded;
+    encodeRleBitPacked(values.data(), values.size(), static_cast<int>(state.range(0)), encoded);
+    std::vector<uint32_t> out(kDefaultBatchSize);
+    for (auto _ : state)
+    {
+        RleBitPackedDecoder decoder(encoded.data(), encoded.size(), static_cast<int>(state.range(0)));
+        while (decoder.getBatch(out.data(), out.size()) > 0)
+        {
+            benchmark::DoNotOptimize(out.data());
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * values.size()));
+}
+
+BENCHMARK(BM_RleBitPackedEncode)->Apply(rleArgs);
+BENCHMARK(BM_RleBitPackedDecode)->Apply(rleArgs);
+
+static void BM_DictionaryDecode(benchmark::State &state, AtomicType type, bool keep_indices)
+{
+    constexpr size_t kEntries = 1000;
+    constexpr int kBitWidth = 10;
+    auto n = static_cast<size_t>(state.range(0));
+    std::shared_ptr<ColumnBatch> dictionary = batchOf(type, kEntries, 1);
+    std::vector<uint64_t> indices = zipfianIntegers(n, kEntries, 0.8, 2);
+    std::vector<uint32_t> codes(indices.begin(), indices.end());
+    std::vector<uint8_t> page{kBitWidth};
+    encodeRleBitPacked(codes.data(), codes.size(), kBitWidth, page);
+    ColumnBatch batch(type);
+    for (auto _ : state)
+    {
+        batch.clear();
+        auto decoder = makeValueDecoder(Encoding::RLE_DICTIONARY, type, 0, page.data(), page.size(), dictionary,
+                                        keep_indices);
+        benchmark::DoNotOptimize(decodePage(*decoder, batch, n));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK_CAPTURE(BM_DictionaryDecode, int64, AtomicType::INT64, false)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_DictionaryDecode, int64_indices, AtomicType::INT64, true)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_DictionaryDecode, byte_array, AtomicType::BYTE_ARRAY, false)->Apply(valueCounts);
+BENCHMARK_CAPTURE(BM_DictionaryDecode, byte_array_indices, AtomicType::BYTE_ARRAY, true)->Apply(valueCounts);
+
+static void BM_DeltaBinaryPackedEncode(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    std::vector<int64_t> values = ascendingIntegers(n, 999, 1);
+    std::vector<uint8_t> page;
+    for (auto _ : state)
+    {
+        page.clear();
+        encodeDeltaBinaryPacked(values.data(), n, page);
+        benchmark::DoNotOptimize(page.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes_per_value"] = static_cast<double>(page.size()) / static_cast<double>(n);
+}
+
+static void BM_DeltaBinaryPackedDecode(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    std::vector<int64_t> values = ascendingIntegers(n, 999, 1);
+    std::vector<uint8_t> page;
+    encodeDeltaBinaryPacked(values.data(), n, page);
+    ColumnBatch batch(AtomicType::INT64);
+    for (auto _ : state)
+    {
+        batch.clear();
+        auto decoder = makeValueDecoder(Encoding::DELTA_BINARY_PACKED, AtomicType::INT64, 0, page.data(), page.size());
+        benchmark::DoNotOptimize(decodePage(*decoder, batch, n));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["bytes_per_value"] = static_cast<double>(page.size()) / static_cast<double>(n);
+}
+
+static void BM_DeltaLengthByteArrayDecode(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    std::vector<std::string> values = randomStrings(n, 1000, 8, 24, 1);
+    std::vector<int32_t> lengths;
+    for (const std::string &value : values)
+    {
+        lengths.push_back(static_cast<int32_t>(value.size()));
+    }
+    std::vector<uint8_t> page;
+    encodeDeltaBinaryPacked(lengths.data(), lengths.size(), page);
+    for (const std::string &value : values)
+    {
+        page.insert(page.end(), value.begin(), value.end());
+    }
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    for (auto _ : state)
+    {
+        batch.clear();
+        auto decoder = makeValueDecoder(Encoding::DELTA_LENGTH_BYTE_ARRAY, AtomicType::BYTE_ARRAY, 0, page.data(),
+                                        page.size());
+        benchmark::DoNotOptimize(decodePage(*decoder, batch, n));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_DeltaByteArrayDecode(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    std::shared_ptr<ColumnBatch> values = batchOf(AtomicType::BYTE_ARRAY, n, 1);
+    std::vector<uint8_t> page;
+    encodeDeltaByteArray(*values, 0, n, page);
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    for (auto _ : state)
+    {
+        batch.clear();
+        auto decoder =
+            makeValueDecoder(Encoding::DELTA_BYTE_ARRAY, AtomicType::BYTE_ARRAY, 0, page.data(), page.size());
+        benchmark::DoNotOptimize(decodePage(*decoder, batch, n));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_ByteStreamSplitDecode(benchmark::State &state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+    std::vector<uint8_t> page;
+    encodeByteStreamSplit(*batchOf(AtomicType::DOUBLE, n, 1), 0, n, page);
+    ColumnBatch batch(AtomicType::DOUBLE);
+    for (auto _ : state)
+    {
+        batch.clear();
+        auto decoder = makeValueDecoder(Encoding::BYTE_STREAM_SPLIT, AtomicType::DOUBLE, 0, page.data(), page.size());
+        benchmark::DoNotOptimize(decodePage(*decoder, batch, n));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * page.size()));
+}
+
+BENCHMARK(BM_DeltaBinaryPackedEncode)->Apply(valueCounts);
+BENCHMARK(BM_DeltaBinaryPackedDecode)->Apply(valueCounts);
+BENCHMARK(BM_DeltaLengthByteArrayDecode)->Apply(valueCounts);
+BENCHMARK(BM_DeltaByteArrayDecode)->Apply(valueCounts);
+BENCHMARK(BM_ByteStreamSplitDecode)->Apply(valueCounts);
+
+BENCHMARK_MAIN();
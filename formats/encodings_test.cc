@@ -0,0 +1,752 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "bit_util.hpp"
+#include "encodings.hpp"
+
+namespace
+{
+    void appendUleb(std::vector<uint8_t> &out, uint64_t value)
+    {
+        uint8_t buffer[10];
+        out.insert(out.end(), buffer, buffer + bit_util::writeUleb128(value, buffer));
+    }
+
+    void appendLength(std::vector<uint8_t> &out, uint32_t length)
+    {
+        uint8_t bytes[4];
+        std::memcpy(bytes, &length, 4);
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    // Reference DELTA_BINARY_PACKED encoder: one block of 128 values split in 4 miniblocks
+    std::vector<uint8_t> deltaEncode(const std::vector<int64_t> &values)
+    {
+        std::vector<uint8_t> out;
+        appendUleb(out, 128);
+        appendUleb(out, 4);
+        appendUleb(out, values.size());
+        appendUleb(out, bit_util::zigzagEncode(values.empty() ? 0 : values[0]));
+
+        for (size_t start = 1; start < values.size(); start += 128)
+        {
+            size_t end = std::min(values.size(), start + 128);
+            std::vector<uint64_t> deltas;
+            for (size_t i = start; i < end; ++i)
+            {
+                deltas.push_back(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(values[i - 1]));
+            }
+            int64_t min_delta = static_cast<int64_t>(deltas[0]);
+            for (uint64_t delta : deltas)
+            {
+                min_delta = std::min(min_delta, static_cast<int64_t>(delta));
+            }
+            appendUleb(out, bit_util::zigzagEncode(min_delta));
+
+            deltas.resize(128, static_cast<uint64_t>(min_delta));
+            std::vector<uint8_t> widths(4);
+            for (size_t m = 0; m < 4; ++m)
+            {
+                uint64_t max_value = 0;
+                for (size_t i = m * 32; i < m * 32 + 32; ++i)
+                {
+                    deltas[i] -= static_cast<uint64_t>(min_delta);
+                    max_value = std::max(max_value, deltas[i]);
+                }
+                widths[m] = static_cast<uint8_t>(bit_util::bitWidth(max_value));
+            }
+            out.insert(out.end(), widths.begin(), widths.end());
+            size_t needed = (end - start + 31) / 32;
+            for (size_t m = 0; m < needed; ++m)
+            {
+                std::vector<uint8_t> packed(32 * widths[m] / 8);
+                bit_util::pack64(deltas.data() + m * 32, 32, widths[m], packed.data());
+                out.insert(out.end(), packed.begin(), packed.end());
+            }
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> deltaLengthEncode(const std::vector<std::string> &values)
+    {
+        std::vector<int64_t> lengths;
+        std::string data;
+        for (const auto &value : values)
+        {
+            lengths.push_back(static_cast<int64_t>(value.size()));
+            data += value;
+        }
+        std::vector<uint8_t> out = deltaEncode(lengths);
+        out.insert(out.end(), data.begin(), data.end());
+        return out;
+    }
+
+    std::string slotBytes(const ColumnBatch &batch, size_t i)
+    {
+        if (batch.type() == AtomicType::BYTE_ARRAY)
+        {
+            return std::string(batch.byteArray(i));
+        }
+        return std::string(reinterpret_cast<const char *>(batch.values<uint8_t>() + i * batch.valueWidth()),
+                           batch.valueWidth());
+    }
+
+    // Skips and decodes runs of 1, 2, 3, ... values in turn and checks the decoded values
+    // against `expected`
+    void expectSkipsMatch(Encoding encoding, const ColumnBatch &expected, const std::vector<uint8_t> &page,
+                          std::shared_ptr<const ColumnBatch> dictionary = nullptr)
+    {
+        auto decoder = makeValueDecoder(encoding, expected.type(), expected.typeLength(), page.data(), page.size(),
+                                        std::move(dictionary));
+        ColumnBatch decoded(expected.type(), expected.typeLength());
+        std::vector<size_t> slots;
+        size_t position = 0;
+        for (size_t run = 1; position < expected.length(); ++run)
+        {
+            size_t count = std::min(run, expected.length() - position);
+            if (run % 2 == 1)
+            {
+                ASSERT_EQ(decoder->skip(count), count);
+            }
+            else
+            {
+                ASSERT_EQ(decoder->decode(decoded, count), count);
+                for (size_t i = 0; i < count; ++i)
+                {
+                    slots.push_back(position + i);
+                }
+            }
+            position += count;
+        }
+        ASSERT_EQ(decoded.length(), slots.size());
+        for (size_t i = 0; i < slots.size(); ++i)
+        {
+            ASSERT_EQ(slotBytes(decoded, i), slotBytes(expected, slots[i])) << static_cast<int>(encoding) << " " << i;
+        }
+    }
+} // namespace
+
+TEST(RleBitPackedDecoderTest, BitPackedRunFromSpec)
+{
+    // The numbers 0 through 7 using bit width 3, as in Encodings.md
+    const uint8_t data[] = {0x03, 0x88, 0xC6, 0xFA};
+    RleBitPackedDecoder decoder(data, sizeof(data), 3);
+
+    int16_t values[10];
+    ASSERT_EQ(decoder.getBatch(values, 10), 8u);
+    for (int16_t i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(values[i], i);
+    }
+}
+
+TEST(RleBitPackedDecoderTest, MixedRuns)
+{
+    // Five 4s, then 0..7 bit packed, then 300 ones
+    std::vector<uint8_t> data = {10, 0x04, 0x03, 0x88, 0xC6, 0xFA};
+    appendUleb(data, 300 << 1);
+    data.push_back(1);
+    RleBitPackedDecoder decoder(data.data(), data.size(), 3);
+
+    std::vector<uint32_t> values(400);
+    size_t decoded = 0;
+    while (size_t n = decoder.getBatch(values.data() + decoded, 7))
+    {
+        decoded += n;
+    }
+    ASSERT_EQ(decoded, 313u);
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(values[i], 4u);
+    }
+    for (uint32_t i = 0; i < 8; ++i)
+    {
+        EXPECT_EQ(values[5 + i], i);
+    }
+    for (int i = 13; i < 313; ++i)
+    {
+        EXPECT_EQ(values[i], 1u);
+    }
+}
+
+TEST(RleBitPackedDecoderTest, SkipsRunsAndCountsMatches)
+{
+    // Five 4s, then 0..7 bit packed, then 300 ones
+    std::vector<uint8_t> data = {10, 0x04, 0x03, 0x88, 0xC6, 0xFA};
+    appendUleb(data, 300 << 1);
+    data.push_back(1);
+    RleBitPackedDecoder decoder(data.data(), data.size(), 3);
+
+    size_t matches = 0;
+    EXPECT_EQ(decoder.skip(3, 4, matches), 3u);
+    EXPECT_EQ(matches, 3u);
+    EXPECT_EQ(decoder.skip(6, 1, matches), 6u);
+    EXPECT_EQ(matches, 4u);
+    uint32_t value;
+    ASSERT_EQ(decoder.getBatch(&value, 1), 1u);
+    EXPECT_EQ(value, 4u);
+    EXPECT_EQ(decoder.skip(100), 100u);
+    std::vector<uint32_t> rest(300);
+    EXPECT_EQ(decoder.getBatch(rest.data(), rest.size()), 203u);
+    EXPECT_EQ(rest[0], 1u);
+    EXPECT_EQ(decoder.skip(10), 0u);
+
+    // Bit width 1, as for the definition levels of optional columns: bit packed runs are
+    // counted without unpacking them
+    std::mt19937 rng(5);
+    std::vector<int16_t> levels(1000);
+    for (size_t i = 0; i < levels.size(); ++i)
+    {
+        levels[i] = static_cast<int16_t>(i >= 400 && i < 600 ? 1 : rng() % 2);
+    }
+    std::vector<uint8_t> encoded;
+    encodeRleBitPacked(levels.data(), levels.size(), 1, encoded);
+    RleBitPackedDecoder level_decoder(encoded.data(), encoded.size(), 1);
+    for (size_t first = 0; first < levels.size(); first += 37)
+    {
+        size_t count = std::min<size_t>(37, levels.size() - first);
+        size_t zeros = 0;
+        ASSERT_EQ(level_decoder.skip(count, 0, zeros), count);
+        EXPECT_EQ(zeros, static_cast<size_t>(std::count(levels.begin() + first, levels.begin() + first + count, 0)));
+    }
+}
+
+TEST(DeltaBitPackDecoderTest, SpecExample)
+{
+    std::vector<int64_t> values = {7, 5, 3, 1, 2, 3, 4, 5};
+    std::vector<uint8_t> encoded = deltaEncode(values);
+    DeltaBitPackDecoder decoder(encoded.data(), encoded.size());
+
+    std::vector<int32_t> decoded(values.size());
+    ASSERT_EQ(decoder.getBatch(decoded.data(), decoded.size()), values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        EXPECT_EQ(decoded[i], values[i]);
+    }
+    EXPECT_EQ(decoder.position(), encoded.data() + encoded.size());
+}
+
+TEST(DeltaBitPackDecoderTest, RandomValuesWrapAround)
+{
+    std::mt19937_64 rng(1);
+    std::vector<int64_t> values(10000);
+    for (auto &value : values)
+    {
+        value = static_cast<int64_t>(rng());
+    }
+    values[10] = INT64_MIN;
+    values[11] = INT64_MAX;
+    std::vector<uint8_t> encoded = deltaEncode(values);
+
+    ColumnBatch batch(AtomicType::INT64);
+    auto decoder = makeValueDecoder(Encoding::DELTA_BINARY_PACKED, AtomicType::INT64, 0, encoded.data(),
+                                    encoded.size());
+    while (decoder->decode(batch, kDefaultBatchSize) > 0)
+    {
+    }
+    ASSERT_EQ(batch.length(), values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        ASSERT_EQ(batch.value<int64_t>(i), values[i]) << i;
+    }
+}
+
+TEST(ValueDecoderTest, PlainFixedWidth)
+{
+    std::vector<double> values = {1.5, -2.25, 1e300};
+    ColumnBatch batch(AtomicType::DOUBLE);
+    auto decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::DOUBLE, 0,
+                                    reinterpret_cast<const uint8_t *>(values.data()), values.size() * 8);
+
+    EXPECT_EQ(decoder->decode(batch, 2), 2u);
+    EXPECT_EQ(decoder->decode(batch, 2), 1u);
+    EXPECT_EQ(decoder->decode(batch, 2), 0u);
+    ASSERT_EQ(batch.length(), 3u);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        EXPECT_EQ(batch.value<double>(i), values[i]);
+    }
+}
+
+TEST(ValueDecoderTest, PlainBooleans)
+{
+    const uint8_t data[] = {0b10110001, 0b00000001};
+    ColumnBatch batch(AtomicType::BOOLEAN);
+    auto decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::BOOLEAN, 0, data, sizeof(data));
+    EXPECT_EQ(decoder->decode(batch, 3), 3u);
+    EXPECT_EQ(decoder->decode(batch, 6), 6u);
+
+    std::vector<uint8_t> expected = {1, 0, 0, 0, 1, 1, 0, 1, 1};
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(batch.value<uint8_t>(i), expected[i]) << i;
+    }
+
+    // Unaligned batches spanning whole words
+    std::vector<uint8_t> words(100);
+    for (size_t i = 0; i < words.size(); ++i)
+    {
+        words[i] = static_cast<uint8_t>(i * 37);
+    }
+    ColumnBatch long_batch(AtomicType::BOOLEAN);
+    decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::BOOLEAN, 0, words.data(), words.size());
+    EXPECT_EQ(decoder->decode(long_batch, 5), 5u);
+    EXPECT_EQ(decoder->decode(long_batch, 300), 300u);
+    EXPECT_EQ(decoder->decode(long_batch, 1000), 495u);
+    ASSERT_EQ(long_batch.length(), 800u);
+    for (size_t i = 0; i < long_batch.length(); ++i)
+    {
+        ASSERT_EQ(long_batch.value<uint8_t>(i), bit_util::getBit(words.data(), i)) << i;
+    }
+}
+
+TEST(ValueDecoderTest, PlainByteArrays)
+{
+    std::vector<uint8_t> data;
+    for (std::string value : {"parquet", "", "columnar"})
+    {
+        appendLength(data, static_cast<uint32_t>(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+    }
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    auto decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::BYTE_ARRAY, 0, data.data(), data.size());
+    EXPECT_EQ(decoder->decode(batch, 10), 3u);
+    EXPECT_EQ(batch.byteArray(0), "parquet");
+    EXPECT_EQ(batch.byteArray(1), "");
+    EXPECT_EQ(batch.byteArray(2), "columnar");
+
+    data.pop_back();
+    ColumnBatch truncated(AtomicType::BYTE_ARRAY);
+    decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::BYTE_ARRAY, 0, data.data(), data.size());
+    EXPECT_THROW(decoder->decode(truncated, 10), ParquetException);
+
+    // A length prefix cut short
+    data = {3, 0, 0, 0, 'a', 'b', 'c', 1, 0};
+    ColumnBatch short_length(AtomicType::BYTE_ARRAY);
+    decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::BYTE_ARRAY, 0, data.data(), data.size());
+    EXPECT_THROW(decoder->decode(short_length, 10), ParquetException);
+}
+
+TEST(ValueDecoderTest, PlainByteArraysAcrossRuns)
+{
+    // Lengths from 0 to 70 straddle the copy sizes, 2000 values several decoding runs
+    std::mt19937 rng(5);
+    std::vector<std::string> values;
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < 2000; ++i)
+    {
+        std::string value(rng() % 71, '\0');
+        for (char &c : value)
+        {
+            c = static_cast<char>('a' + rng() % 26);
+        }
+        appendLength(data, static_cast<uint32_t>(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+        values.push_back(value);
+    }
+
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    auto decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::BYTE_ARRAY, 0, data.data(), data.size());
+    EXPECT_EQ(decoder->decode(batch, 3), 3u);
+    EXPECT_EQ(decoder->skip(10), 10u);
+    EXPECT_EQ(decoder->decode(batch, 1500), 1500u);
+    EXPECT_EQ(decoder->decode(batch, 1000), 487u);
+    EXPECT_EQ(decoder->decode(batch, 1000), 0u);
+    ASSERT_EQ(batch.length(), 1990u);
+    for (size_t i = 0; i < batch.length(); ++i)
+    {
+        ASSERT_EQ(batch.byteArray(i), values[i < 3 ? i : i + 10]) << i;
+    }
+}
+
+TEST(ValueDecoderTest, DictionaryMaterializedAndIndices)
+{
+    std::vector<uint8_t> dictionary_page;
+    for (std::string value : {"red", "green", "blue"})
+    {
+        appendLength(dictionary_page, static_cast<uint32_t>(value.size()));
+        dictionary_page.insert(dictionary_page.end(), value.begin(), value.end());
+    }
+    auto dictionary = decodeDictionaryPage(AtomicType::BYTE_ARRAY, 0, dictionary_page.data(),
+                                           dictionary_page.size(), 3);
+    ASSERT_EQ(dictionary->length(), 3u);
+
+    // Bit width 2, then a run of three 2s and a bit packed group 0,1,2,1,0,0,0,0
+    const uint8_t page[] = {2, 6, 2, 3, 0b01100100, 0b00000000};
+
+    ColumnBatch values(AtomicType::BYTE_ARRAY);
+    auto decoder = makeValueDecoder(Encoding::RLE_DICTIONARY, AtomicType::BYTE_ARRAY, 0, page, sizeof(page),
+                                    dictionary);
+    EXPECT_EQ(decoder->decode(values, 7), 7u);
+    std::vector<std::string> expected = {"blue", "blue", "blue", "red", "green", "blue", "green"};
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(values.byteArray(i), expected[i]) << i;
+    }
+
+    ColumnBatch indices(AtomicType::BYTE_ARRAY);
+    decoder = makeValueDecoder(Encoding::RLE_DICTIONARY, AtomicType::BYTE_ARRAY, 0, page, sizeof(page),
+                               dictionary, true);
+    EXPECT_EQ(decoder->decode(indices, 7), 7u);
+    EXPECT_TRUE(indices.isDictionaryEncoded());
+    std::vector<int32_t> expected_indices = {2, 2, 2, 0, 1, 2, 1};
+    for (size_t i = 0; i < expected_indices.size(); ++i)
+    {
+        EXPECT_EQ(indices.indices()[i], expected_indices[i]) << i;
+    }
+}
+
+TEST(ValueDecoderTest, DictionaryIndexOutOfRange)
+{
+    const int32_t dictionary_values[] = {5, 6};
+    auto dictionary = decodeDictionaryPage(AtomicType::INT32, 0,
+                                           reinterpret_cast<const uint8_t *>(dictionary_values), 8, 2);
+    const uint8_t page[] = {2, 2, 3};
+    ColumnBatch batch(AtomicType::INT32);
+    auto decoder = makeValueDecoder(Encoding::RLE_DICTIONARY, AtomicType::INT32, 0, page, sizeof(page),
+                                    dictionary);
+    EXPECT_THROW(decoder->decode(batch, 1), ParquetException);
+}
+
+TEST(ValueDecoderTest, DeltaLengthByteArray)
+{
+    std::vector<std::string> values = {"Hello", "World", "Foobar", "ABCDEF"};
+    std::vector<uint8_t> encoded = deltaLengthEncode(values);
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    auto decoder = makeValueDecoder(Encoding::DELTA_LENGTH_BYTE_ARRAY, AtomicType::BYTE_ARRAY, 0,
+                                    encoded.data(), encoded.size());
+    EXPECT_EQ(decoder->decode(batch, 10), 4u);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        EXPECT_EQ(batch.byteArray(i), values[i]);
+    }
+}
+
+TEST(ValueDecoderTest, DeltaByteArray)
+{
+    // "axis", "axle", "babble", "babyhood" from Encodings.md
+    std::vector<uint8_t> encoded = deltaEncode({0, 2, 0, 3});
+    std::vector<uint8_t> suffixes = deltaLengthEncode({"axis", "le", "babble", "yhood"});
+    encoded.insert(encoded.end(), suffixes.begin(), suffixes.end());
+
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    auto decoder = makeValueDecoder(Encoding::DELTA_BYTE_ARRAY, AtomicType::BYTE_ARRAY, 0, encoded.data(),
+                                    encoded.size());
+    EXPECT_EQ(decoder->decode(batch, 3), 3u);
+    EXPECT_EQ(decoder->decode(batch, 3), 1u);
+    EXPECT_EQ(batch.byteArray(0), "axis");
+    EXPECT_EQ(batch.byteArray(1), "axle");
+    EXPECT_EQ(batch.byteArray(2), "babble");
+    EXPECT_EQ(batch.byteArray(3), "babyhood");
+}
+
+TEST(ValueDecoderTest, RleBooleans)
+{
+    // Length prefix, then a run of 3 trues and a bit packed group
+    std::vector<uint8_t> encoded;
+    appendLength(encoded, 4);
+    encoded.insert(encoded.end(), {6, 1, 3, 0b00000101});
+    ColumnBatch batch(AtomicType::BOOLEAN);
+    auto decoder = makeValueDecoder(Encoding::RLE, AtomicType::BOOLEAN, 0, encoded.data(), encoded.size());
+    EXPECT_EQ(decoder->decode(batch, 6), 6u);
+    std::vector<uint8_t> expected = {1, 1, 1, 1, 0, 1};
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(batch.value<uint8_t>(i), expected[i]) << i;
+    }
+}
+
+TEST(ValueDecoderTest, DecodeSpacedAcrossBatches)
+{
+    std::vector<int32_t> values(10000);
+    std::vector<int16_t> levels(15000);
+    std::mt19937 rng(3);
+    size_t next = 0;
+    for (auto &level : levels)
+    {
+        level = (rng() % 3 != 0 && next < values.size()) ? 1 : 0;
+        next += level;
+    }
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        values[i] = static_cast<int32_t>(i * 7);
+    }
+
+    auto decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::INT32, 0,
+                                    reinterpret_cast<const uint8_t *>(values.data()), next * 4);
+    ColumnBatch batch(AtomicType::INT32);
+    size_t expected_value = 0;
+    for (size_t start = 0; start < levels.size(); start += kDefaultBatchSize)
+    {
+        size_t count = std::min(kDefaultBatchSize, levels.size() - start);
+        batch.clear();
+        decoder->decodeSpaced(batch, levels.data() + start, count, 1);
+        ASSERT_EQ(batch.length(), count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(batch.isValid(i), levels[start + i] == 1);
+            if (batch.isValid(i))
+            {
+                ASSERT_EQ(batch.value<int32_t>(i), values[expected_value++]);
+            }
+        }
+    }
+    EXPECT_EQ(expected_value, next);
+}
+
+TEST(ValueDecoderTest, SkipsWithoutMaterializing)
+{
+    std::mt19937 rng(3);
+    ColumnBatch integers(AtomicType::INT64);
+    ColumnBatch strings(AtomicType::BYTE_ARRAY);
+    ColumnBatch booleans(AtomicType::BOOLEAN);
+    std::vector<int16_t> bits;
+    for (size_t i = 0; i < 1000; ++i)
+    {
+        *integers.appendValues<int64_t>(1) = static_cast<int64_t>(rng() % 100) - 50;
+        std::string value = "value" + std::to_string(rng() % 30);
+        strings.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+        bits.push_back(static_cast<int16_t>(rng() % 2));
+        *booleans.appendValues<uint8_t>(1) = static_cast<uint8_t>(bits.back());
+    }
+
+    for (const ColumnBatch *batch : {&integers, &strings, &booleans})
+    {
+        std::vector<uint8_t> page;
+        encodePlain(*batch, 0, batch->length(), page);
+        expectSkipsMatch(Encoding::PLAIN, *batch, page);
+    }
+    for (const ColumnBatch *batch : {&integers, &strings})
+    {
+        DictionaryEncoder encoder(*batch, 1 << 20);
+        std::vector<uint8_t> dictionary_page;
+        encoder.encodeDictionary(dictionary_page);
+        std::vector<uint8_t> page;
+        encoder.encodeIndices(0, batch->length(), page);
+        expectSkipsMatch(Encoding::RLE_DICTIONARY, *batch, page,
+                         decodeDictionaryPage(batch->type(), 0, dictionary_page.data(), dictionary_page.size(),
+                                              encoder.size()));
+    }
+    std::vector<uint8_t> page;
+    encodeDeltaBinaryPacked(integers.values<int64_t>(), integers.length(), page);
+    expectSkipsMatch(Encoding::DELTA_BINARY_PACKED, integers, page);
+    page.clear();
+    encodeByteStreamSplit(integers, 0, integers.length(), page);
+    expectSkipsMatch(Encoding::BYTE_STREAM_SPLIT, integers, page);
+    page.clear();
+    encodeDeltaByteArray(strings, 0, strings.length(), page);
+    expectSkipsMatch(Encoding::DELTA_BYTE_ARRAY, strings, page);
+    page.assign(4, 0);
+    encodeRleBitPacked(bits.data(), bits.size(), 1, page);
+    auto length = static_cast<uint32_t>(page.size() - 4);
+    std::memcpy(page.data(), &length, sizeof(length));
+    expectSkipsMatch(Encoding::RLE, booleans, page);
+
+    // Skipping stops at the end of the page
+    page.clear();
+    encodePlain(integers, 0, 10, page);
+    auto decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::INT64, 0, page.data(), page.size());
+    EXPECT_EQ(decoder->skip(7), 7u);
+    EXPECT_EQ(decoder->skip(7), 3u);
+}
+
+TEST(ValueDecoderTest, UnsupportedEncoding)
+{
+    const uint8_t data[] = {0};
+    EXPECT_THROW(makeValueDecoder(Encoding::DELTA_BINARY_PACKED, AtomicType::DOUBLE, 0, data, 1),
+                 ParquetException);
+    EXPECT_THROW(makeValueDecoder(Encoding::RLE_DICTIONARY, AtomicType::INT32, 0, data, 1), ParquetException);
+}
+
+TEST(RleBitPackedEncoderTest, RoundTrip)
+{
+    std::mt19937 rng(3);
+    for (int width : {1, 3, 12, 20})
+    {
+        std::vector<uint32_t> values;
+        while (values.size() < 5000)
+        {
+            uint32_t value = rng() & ((1u << width) - 1);
+            // Mix of short and long runs, so both run kinds show up at odd alignments
+            size_t run = rng() % 3 == 0 ? rng() % 40 : 1;
+            values.insert(values.end(), run + 1, value);
+        }
+        std::vector<uint8_t> encoded;
+        encodeRleBitPacked(values.data(), values.size(), width, encoded);
+
+        RleBitPackedDecoder decoder(encoded.data(), encoded.size(), width);
+        std::vector<uint32_t> decoded(values.size());
+        ASSERT_EQ(decoder.getBatch(decoded.data(), decoded.size()), values.size());
+        EXPECT_EQ(decoded, values) << width;
+    }
+}
+
+TEST(PlainEncoderTest, SkipsNulls)
+{
+    ColumnBatch batch(AtomicType::INT32);
+    *batch.appendValues<int32_t>(1) = 1;
+    batch.appendNulls(1);
+    *batch.appendValues<int32_t>(1) = 3;
+
+    std::vector<uint8_t> encoded;
+    encodePlain(batch, 0, batch.length(), encoded);
+    ASSERT_EQ(encoded.size(), 8u);
+
+    ColumnBatch decoded(AtomicType::INT32);
+    auto decoder = makeValueDecoder(Encoding::PLAIN, AtomicType::INT32, 0, encoded.data(), encoded.size());
+    ASSERT_EQ(decoder->decode(decoded, 10), 2u);
+    EXPECT_EQ(decoded.value<int32_t>(0), 1);
+    EXPECT_EQ(decoded.value<int32_t>(1), 3);
+}
+
+TEST(DeltaBinaryPackedEncoderTest, RoundTrip)
+{
+    std::mt19937 rng(5);
+    for (size_t count : {0, 1, 2, 129, 1000})
+    {
+        std::vector<int32_t> values(count);
+        for (auto &value : values)
+        {
+            value = static_cast<int32_t>(rng());
+        }
+        if (count > 2)
+        {
+            // Deltas that only fit in 32 bits by wrapping around
+            values[1] = INT32_MIN;
+            values[2] = INT32_MAX;
+        }
+        std::vector<uint8_t> encoded;
+        encodeDeltaBinaryPacked(values.data(), values.size(), encoded);
+
+        ColumnBatch batch(AtomicType::INT32);
+        auto decoder = makeValueDecoder(Encoding::DELTA_BINARY_PACKED, AtomicType::INT32, 0, encoded.data(),
+                                        encoded.size());
+        EXPECT_EQ(decoder->decode(batch, count + 1), count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ASSERT_EQ(batch.value<int32_t>(i), values[i]) << count << " " << i;
+        }
+    }
+
+    // Matches the reference encoder where both use single miniblock widths
+    std::vector<int64_t> values = {7, 5, 3, 1, 2, 3, 4, 5};
+    std::vector<uint8_t> encoded;
+    encodeDeltaBinaryPacked(values.data(), values.size(), encoded);
+    EXPECT_EQ(encoded, deltaEncode(values));
+}
+
+TEST(DeltaByteArrayEncoderTest, RoundTrip)
+{
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    std::vector<std::string> values = {"axis", "axle", "", "babble", "babyhood", "babyhood", "c"};
+    for (const std::string &value : values)
+    {
+        batch.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+        batch.appendNulls(1);
+    }
+    std::vector<uint8_t> encoded;
+    encodeDeltaByteArray(batch, 2, batch.length() - 2, encoded);
+
+    ColumnBatch decoded(AtomicType::BYTE_ARRAY);
+    auto decoder = makeValueDecoder(Encoding::DELTA_BYTE_ARRAY, AtomicType::BYTE_ARRAY, 0, encoded.data(),
+                                    encoded.size());
+    ASSERT_EQ(decoder->decode(decoded, 100), values.size() - 1);
+    for (size_t i = 1; i < values.size(); ++i)
+    {
+        EXPECT_EQ(decoded.byteArray(i - 1), values[i]);
+    }
+}
+
+TEST(ByteStreamSplitTest, RoundTrip)
+{
+    ColumnBatch doubles(AtomicType::DOUBLE);
+    std::vector<double> values = {1.5, -0.0, 1e300, 3.25, -7.0};
+    for (double value : values)
+    {
+        *doubles.appendValues<double>(1) = value;
+    }
+    doubles.appendNulls(1);
+    std::vector<uint8_t> encoded;
+    encodeByteStreamSplit(doubles, 0, doubles.length(), encoded);
+    ASSERT_EQ(encoded.size(), values.size() * sizeof(double));
+    // Stream 7 holds the sign and exponent bytes
+    EXPECT_EQ(encoded[7 * values.size() + 1], 0x80);
+
+    ColumnBatch decoded(AtomicType::DOUBLE);
+    auto decoder = makeValueDecoder(Encoding::BYTE_STREAM_SPLIT, AtomicType::DOUBLE, 0, encoded.data(),
+                                    encoded.size());
+    ASSERT_EQ(decoder->decode(decoded, 3), 3u);
+    ASSERT_EQ(decoder->decode(decoded, 3), 2u);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        EXPECT_EQ(std::signbit(decoded.value<double>(i)), std::signbit(values[i]));
+        EXPECT_EQ(decoded.value<double>(i), values[i]);
+    }
+
+    ColumnBatch codes(AtomicType::FIXED_LEN_BYTE_ARRAY, 3);
+    for (const char *code : {"abc", "def", "ghi"})
+    {
+        std::memcpy(codes.appendValues<uint8_t>(1), code, 3); // One slot of type_length bytes
+    }
+    encoded.clear();
+    encodeByteStreamSplit(codes, 1, 2, encoded);
+    EXPECT_EQ(std::string(encoded.begin(), encoded.end()), "dgehfi");
+    ColumnBatch decoded_codes(AtomicType::FIXED_LEN_BYTE_ARRAY, 3);
+    decoder = makeValueDecoder(Encoding::BYTE_STREAM_SPLIT, AtomicType::FIXED_LEN_BYTE_ARRAY, 3, encoded.data(),
+                               encoded.size());
+    ASSERT_EQ(decoder->decode(decoded_codes, 10), 2u);
+    EXPECT_EQ(decoded_codes.byteArray(0), "def");
+    EXPECT_EQ(decoded_codes.byteArray(1), "ghi");
+
+    EXPECT_THROW(makeValueDecoder(Encoding::BYTE_STREAM_SPLIT, AtomicType::DOUBLE, 0, encoded.data(), 6),
+                 ParquetException);
+}
+
+TEST(DictionaryEncoderTest, RoundTrip)
+{
+    ColumnBatch batch(AtomicType::BYTE_ARRAY);
+    std::vector<std::string> values;
+    std::mt19937 rng(7);
+    for (size_t i = 0; i < 3000; ++i)
+    {
+        if (i % 7 == 0)
+        {
+            batch.appendNulls(1);
+            continue;
+        }
+        values.push_back("value" + std::to_string(rng() % 50));
+        batch.appendByteArray(reinterpret_cast<const uint8_t *>(values.back().data()), values.back().size());
+    }
+    DictionaryEncoder encoder(batch, 1 << 20);
+    ASSERT_TRUE(encoder.complete());
+    EXPECT_EQ(encoder.size(), 50u);
+    EXPECT_EQ(encoder.bitWidth(), 6);
+
+    std::vector<uint8_t> dictionary_page;
+    encoder.encodeDictionary(dictionary_page);
+    EXPECT_EQ(dictionary_page.size(), encoder.dictionaryBytes());
+    std::shared_ptr<const ColumnBatch> dictionary = decodeDictionaryPage(
+        AtomicType::BYTE_ARRAY, 0, dictionary_page.data(), dictionary_page.size(), encoder.size());
+
+    std::vector<uint8_t> indices;
+    encoder.encodeIndices(0, batch.length(), indices);
+    ColumnBatch decoded(AtomicType::BYTE_ARRAY);
+    auto decoder = makeValueDecoder(Encoding::RLE_DICTIONARY, AtomicType::BYTE_ARRAY, 0, indices.data(),
+                                    indices.size(), dictionary);
+    // The last bit-packed group is padded, the page's definition levels tell how many values there are
+    ASSERT_EQ(decoder->decode(decoded, values.size()), values.size());
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        ASSERT_EQ(decoded.byteArray(i), values[i]) << i;
+    }
+
+    // Too many distinct values for the limit
+    EXPECT_FALSE(DictionaryEncoder(batch, 100).complete());
+    EXPECT_THROW(DictionaryEncoder(ColumnBatch(AtomicType::BOOLEAN), 100), std::invalid_argument);
+}
@@ -0,0 +1,319 @@
+#include "encryption.hpp"
+
+#include <sys/random.h>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+    constexpr size_t kLengthSize = 4;
+
+    void appendOrdinal(std::string &aad, int64_t ordinal)
+    {
+        if (ordinal > std::numeric_limits<int16_t>::max())
+        {
+            throw ParquetException("Encrypted files cannot have more than 32767 row groups, columns or pages per "
+                                   "column chunk");
+        }
+        aad.push_back(static_cast<char>(ordinal & 0xff));
+        aad.push_back(static_cast<char>((ordinal >> 8) & 0xff));
+    }
+
+    uint32_t readLength(const uint8_t *data)
+    {
+        return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+               (static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+    }
+
+    const uint8_t *bytes(const std::string &s)
+    {
+        return reinterpret_cast<const uint8_t *>(s.data());
+    }
+} // namespace
+
+ModuleCipher::ModuleCipher(ParquetCipher cipher, const std::string &key, std::string file_aad)
+    : cipher_(cipher), aes_(bytes(key), key.size()), file_aad_(std::move(file_aad))
+{
+}
+
+std::string ModuleCipher::aad(ModuleType type, int64_t row_group, int64_t column, int64_t page) const
+{
+    std::string aad = file_aad_;
+    aad.push_back(static_cast<char>(type));
+    for (int64_t ordinal : {row_group, column, page})
+    {
+        if (ordinal >= 0)
+        {
+            appendOrdinal(aad, ordinal);
+        }
+    }
+    return aad;
+}
+
+bool ModuleCipher::usesCtr(ModuleType type) const noexcept
+{
+    return cipher_ == ParquetCipher::AES_GCM_CTR_V1 &&
+           (type == ModuleType::DATA_PAGE || type == ModuleType::DICTIONARY_PAGE);
+}
+
+size_t ModuleCipher::overhead(ModuleType type) const noexcept
+{
+    return kLengthSize + kGcmNonceSize + (usesCtr(type) ? 0 : kGcmTagSize);
+}
+
+void ModuleCipher::encrypt(ModuleType type, const uint8_t *data, size_t size, const std::string &aad,
+                           std::vector<uint8_t> &out) const
+{
+    size_t length = size + overhead(type) - kLengthSize;
+    if (length > std::numeric_limits<uint32_t>::max())
+    {
+        throw std::length_error("Modules are limited to 4 GiB");
+    }
+    size_t start = out.size();
+    out.resize(start + kLengthSize + length);
+    uint8_t *module = out.data() + start;
+    for (size_t i = 0; i < kLengthSize; ++i)
+    {
+        module[i] = static_cast<uint8_t>(length >> (8 * i));
+    }
+    uint8_t *nonce = module + kLengthSize;
+    std::string random = randomBytes(kGcmNonceSize);
+    std::memcpy(nonce, random.data(), kGcmNonceSize);
+    uint8_t *ciphertext = nonce + kGcmNonceSize;
+    if (usesCtr(type))
+    {
+        aes_.ctr(nonce, 1, data, size, ciphertext);
+    }
+    else
+    {
+        aes_.encrypt(nonce, bytes(aad), aad.size(), data, size, ciphertext, ciphertext + size);
+    }
+}
+
+size_t ModuleCipher::moduleSize(const uint8_t *data, size_t available)
+{
+    if (available < kLengthSize || readLength(data) > available - kLengthSize)
+    {
+        throw ParquetException("Truncated encrypted module");
+    }
+    return kLengthSize + readLength(data);
+}
+
+size_t ModuleCipher::decrypt(ModuleType type, const uint8_t *data, size_t size, const std::string &aad,
+                             uint8_t *out) const
+{
+    if (size < overhead(type) || moduleSize(data, size) != size)
+    {
+        throw ParquetException("Malformed encrypted module");
+    }
+    const uint8_t *nonce = data + kLengthSize;
+    const uint8_t *ciphertext = nonce + kGcmNonceSize;
+    size_t plaintext_size = size - overhead(type);
+    if (usesCtr(type))
+    {
+        aes_.ctr(nonce, 1, ciphertext, plaintext_size, out);
+    }
+    else if (!aes_.decrypt(nonce, bytes(aad), aad.size(), ciphertext, plaintext_size, out,
+                           ciphertext + plaintext_size))
+    {
+        throw ParquetException("Encrypted module failed authentication: wrong key, AAD or tampered data");
+    }
+    return plaintext_size;
+}
+
+std::vector<uint8_t> ModuleCipher::decrypt(ModuleType type, const uint8_t *data, size_t size,
+                                           const std::string &aad) const
+{
+    std::vector<uint8_t> plaintext(size >= overhead(type) ? size - overhead(type) : 0);
+    decrypt(type, data, size, aad, plaintext.data());
+    return plaintext;
+}
+
+void ModuleCipher::sign(const uint8_t *footer, size_t size, uint8_t *signature) const
+{
+    std::string nonce = randomBytes(kGcmNonceSize);
+    std::memcpy(signature, nonce.data(), kGcmNonceSize);
+    std::vector<uint8_t> ciphertext(size);
+    std::string footer_aad = aad(ModuleType::FOOTER);
+    aes_.encrypt(signature, bytes(footer_aad), footer_aad.size(), footer, size, ciphertext.data(),
+                 signature + kGcmNonceSize);
+}
+
+void ModuleCipher::verify(const uint8_t *footer, size_t size, const uint8_t *signature) const
+{
+    std::vector<uint8_t> ciphertext(size);
+    uint8_t tag[kGcmTagSize];
+    std::string footer_aad = aad(ModuleType::FOOTER);
+    aes_.encrypt(signature, bytes(footer_aad), footer_aad.size(), footer, size, ciphertext.data(), tag);
+    uint8_t difference = 0;
+    for (size_t i = 0; i < kGcmTagSize; ++i)
+    {
+        difference |= tag[i] ^ signature[kGcmNonceSize + i];
+    }
+    if (difference != 0)
+    {
+        throw ParquetException("Footer signature mismatch: wrong footer key, AAD or tampered footer");
+    }
+}
+
+FileEncryptor::FileEncryptor(const FileEncryptionProperties &properties, const std::vector<ColumnDescriptor> &columns)
+    : properties_(properties)
+{
+    if (properties_.aad_prefix.empty() && !properties_.store_aad_prefix)
+    {
+        throw std::invalid_argument("store_aad_prefix = false needs an AAD prefix");
+    }
+    AesGcmV1 parameters;
+    parameters.aad_file_unique = randomBytes(8);
+    if (!properties_.aad_prefix.empty())
+    {
+        if (properties_.store_aad_prefix)
+        {
+            parameters.aad_prefix = properties_.aad_prefix;
+        }
+        else
+        {
+            parameters.supply_aad_prefix = true;
+        }
+    }
+    if (properties_.cipher == ParquetCipher::AES_GCM_V1)
+    {
+        algorithm_.AES_GCM_V1 = parameters;
+    }
+    else
+    {
+        algorithm_.AES_GCM_CTR_V1 = AesGcmCtrV1{parameters};
+    }
+    std::string file_aad = properties_.aad_prefix + *parameters.aad_file_unique;
+    footer_cipher_ = std::make_shared<const ModuleCipher>(properties_.cipher, properties_.footer_key, file_aad);
+
+    size_t found = 0;
+    for (const ColumnDescriptor &column : columns)
+    {
+        columns_.push_back(column);
+        std::shared_ptr<const ModuleCipher> cipher;
+        auto it = properties_.columns.find(column.dottedPath());
+        if (properties_.columns.empty() || (it != properties_.columns.end() && it->second.key.empty()))
+        {
+            cipher = footer_cipher_;
+        }
+        else if (it != properties_.columns.end())
+        {
+            cipher = std::make_shared<const ModuleCipher>(properties_.cipher, it->second.key, file_aad);
+        }
+        found += it != properties_.columns.end();
+        column_ciphers_.push_back(std::move(cipher));
+    }
+    if (found != properties_.columns.size())
+    {
+        throw std::invalid_argument("Encryption properties name columns that are not in the schema");
+    }
+}
+
+ColumnCryptoMetaData FileEncryptor::cryptoMetaData(size_t column) const
+{
+    ColumnCryptoMetaData crypto_metadata;
+    auto it = properties_.columns.find(columns_.at(column).dottedPath());
+    if (it != properties_.columns.end() && !it->second.key.empty())
+    {
+        EncryptionWithColumnKey column_key;
+        column_key.path_in_schema = columns_[column].path;
+        if (!it->second.key_metadata.empty())
+        {
+            column_key.key_metadata = it->second.key_metadata;
+        }
+        crypto_metadata.ENCRYPTION_WITH_COLUMN_KEY = std::move(column_key);
+    }
+    return crypto_metadata;
+}
+
+FileDecryptor::FileDecryptor(const FileDecryptionProperties &properties, const EncryptionAlgorithm &algorithm,
+                             const std::optional<std::string> &footer_key_metadata)
+    : properties_(properties)
+{
+    const AesGcmV1 &parameters = algorithm.AES_GCM_V1 ? *algorithm.AES_GCM_V1 : *algorithm.AES_GCM_CTR_V1;
+    cipher_ = algorithm.AES_GCM_V1 ? ParquetCipher::AES_GCM_V1 : ParquetCipher::AES_GCM_CTR_V1;
+    if (!parameters.aad_file_unique)
+    {
+        throw ParquetException("Encrypted file without aad_file_unique");
+    }
+    std::string prefix = properties_.aad_prefix;
+    if (parameters.aad_prefix)
+    {
+        if (!prefix.empty() && prefix != *parameters.aad_prefix)
+        {
+            throw ParquetException("The AAD prefix stored in the file is not the one given");
+        }
+        prefix = *parameters.aad_prefix;
+    }
+    else if (parameters.supply_aad_prefix.value_or(false) && prefix.empty())
+    {
+        throw ParquetException("The file does not store its AAD prefix and none was given");
+    }
+    file_aad_ = prefix + *parameters.aad_file_unique;
+
+    std::string key = properties_.footer_key;
+    if (key.empty() && footer_key_metadata && properties_.key_retriever)
+    {
+        key = properties_.key_retriever(*footer_key_metadata);
+    }
+    if (!key.empty())
+    {
+        footer_cipher_ = std::make_shared<const ModuleCipher>(cipher_, key, file_aad_);
+    }
+}
+
+std::shared_ptr<const ModuleCipher> FileDecryptor::columnCipher(const ColumnCryptoMetaData &crypto_metadata,
+                                                                const std::string &dotted_path)
+{
+    if (!crypto_metadata.ENCRYPTION_WITH_COLUMN_KEY)
+    {
+        return footer_cipher_;
+    }
+    auto cached = column_ciphers_.find(dotted_path);
+    if (cached != column_ciphers_.end())
+    {
+        return cached->second;
+    }
+    std::string key;
+    auto it = properties_.column_keys.find(dotted_path);
+    if (it != properties_.column_keys.end())
+    {
+        key = it->second;
+    }
+    else if (properties_.key_retriever && crypto_metadata.ENCRYPTION_WITH_COLUMN_KEY->key_metadata)
+    {
+        key = properties_.key_retriever(*crypto_metadata.ENCRYPTION_WITH_COLUMN_KEY->key_metadata);
+    }
+    std::shared_ptr<const ModuleCipher> cipher;
+    if (!key.empty())
+    {
+        cipher = std::make_shared<const ModuleCipher>(cipher_, key, file_aad_);
+    }
+    column_ciphers_.emplace(dotted_path, cipher);
+    return cipher;
+}
+
+std::string randomBytes(size_t size)
+{
+    std::string result(size, '\0');
+    size_t filled = 0;
+    while (filled < size)
+    {
+        ssize_t n = getrandom(result.data() + filled, size - filled, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "getrandom");
+        }
+        filled += static_cast<size_t>(n);
+    }
+    return result;
+}
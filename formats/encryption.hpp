@@ -0,0 +1,246 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "aes_gcm.hpp"
+#include "parquet_metadata.hpp"
+
+// Parquet modular encryption:
+// https://github.com/apache/parquet-format/blob/master/Encryption.md
+//
+// Every encrypted part of a file (footer, column metadata, page headers, pages, page
+// indexes, Bloom filters) is a module: a 4 byte little endian length, a random 12 byte
+// nonce, the ciphertext and, for GCM, a 16 byte tag. The additional authenticated data
+// (AAD) of a module ties it to its place in the file: the file AAD (an optional prefix
+// and 8 random bytes per file), the module type and the ordinals of its row group, column
+// and page. AES_GCM_V1 encrypts every module with GCM; AES_GCM_CTR_V1 encrypts pages with
+// CTR, which is cheaper but only authenticated through the page headers.
+//
+// Files are written in one of two modes. With an encrypted footer (magic "PARE") the
+// footer is a module behind plaintext FileCryptoMetaData. With a plaintext footer (magic
+// "PAR1") readers without keys can read the plaintext columns; the footer is signed with
+// the footer key, and the metadata of encrypted columns is left in plaintext without its
+// statistics.
+
+enum class ParquetCipher
+{
+    AES_GCM_V1,
+    AES_GCM_CTR_V1
+};
+
+enum class ModuleType : uint8_t
+{
+    FOOTER = 0,
+    COLUMN_META_DATA = 1,
+    DATA_PAGE = 2,
+    DICTIONARY_PAGE = 3,
+    DATA_PAGE_HEADER = 4,
+    DICTIONARY_PAGE_HEADER = 5,
+    COLUMN_INDEX = 6,
+    OFFSET_INDEX = 7,
+    BLOOM_FILTER_HEADER = 8,
+    BLOOM_FILTER_BITSET = 9
+};
+
+/// Nonce and GCM tag appended to a plaintext footer
+constexpr size_t kFooterSignatureSize = kGcmNonceSize + kGcmTagSize;
+
+struct ColumnEncryptionProperties
+{
+    /// Key of the column, or empty to encrypt it with the footer key
+    std::string key;
+    std::string key_metadata;
+};
+
+struct FileEncryptionProperties
+{
+    ParquetCipher cipher = ParquetCipher::AES_GCM_V1;
+
+    /// 16, 24 or 32 bytes
+    std::string footer_key;
+
+    /// Stored in the file for readers to find the key with, e.g. a key id
+    std::string footer_key_metadata;
+
+    /// Encrypted columns by dotted path. When empty every column is encrypted with the
+    /// footer key, otherwise the columns not listed are left in plaintext.
+    std::map<std::string, ColumnEncryptionProperties> columns;
+
+    bool plaintext_footer = false;
+
+    /// Prepended to the file AAD, e.g. the table name and file path, so that files cannot
+    /// be swapped unnoticed
+    std::string aad_prefix;
+
+    /// Whether the prefix is stored in the file; readers must supply it otherwise
+    bool store_aad_prefix = true;
+};
+
+struct FileDecryptionProperties
+{
+    /// Footer key and column keys by dotted path, where known up front
+    std::string footer_key;
+    std::map<std::string, std::string> column_keys;
+
+    /// Looks up the keys not given above by their key metadata; returns an empty string
+    /// for unknown keys
+    std::function<std::string(const std::string &key_metadata)> key_retriever;
+
+    /// The AAD prefix of files that do not store theirs
+    std::string aad_prefix;
+
+    /// Whether the signature of a plaintext footer is checked, which needs the footer key
+    bool check_footer_signature = true;
+};
+
+/**
+ * @brief Encrypts and decrypts the modules of one key of a file.
+ */
+class ModuleCipher
+{
+public:
+    /**
+     * @throws std::invalid_argument unless the key has 16, 24 or 32 bytes
+     */
+    ModuleCipher(ParquetCipher cipher, const std::string &key, std::string file_aad);
+
+    /**
+     * @brief The AAD of a module; the ordinals are left out where negative, as for the
+     * modules that do not belong to a row group, column or page.
+     * @throws ParquetException for ordinals above 32767, which the format cannot express
+     */
+    std::string aad(ModuleType type, int64_t row_group = -1, int64_t column = -1, int64_t page = -1) const;
+
+    /**
+     * @brief Bytes a module of this type adds to its plaintext.
+     */
+    size_t overhead(ModuleType type) const noexcept;
+
+    /**
+     * @brief Appends the module of `size` bytes of plaintext to `out`.
+     */
+    void encrypt(ModuleType type, const uint8_t *data, size_t size, const std::string &aad,
+                 std::vector<uint8_t> &out) const;
+
+    /**
+     * @brief Size of the module at `data`, its length field included.
+     * @throws ParquetException if the module is longer than `available`
+     */
+    static size_t moduleSize(const uint8_t *data, size_t available);
+
+    /**
+     * @brief Decrypts the module of `size` bytes at `data` into `out`, which must hold
+     * `size - overhead(type)` bytes.
+     * @return The plaintext size
+     * @throws ParquetException if the module is malformed or fails authentication
+     */
+    size_t decrypt(ModuleType type, const uint8_t *data, size_t size, const std::string &aad, uint8_t *out) const;
+    std::vector<uint8_t> decrypt(ModuleType type, const uint8_t *data, size_t size, const std::string &aad) const;
+
+    /**
+     * @brief Signs a plaintext footer: a fresh nonce and the GCM tag of the footer.
+     */
+    void sign(const uint8_t *footer, size_t size, uint8_t *signature) const;
+
+    /**
+     * @throws ParquetException if the signature does not match the footer
+     */
+    void verify(const uint8_t *footer, size_t size, const uint8_t *signature) const;
+
+private:
+    bool usesCtr(ModuleType type) const noexcept;
+
+    ParquetCipher cipher_;
+    AesGcm aes_;
+    std::string file_aad_;
+};
+
+/**
+ * @brief The cipher of a column chunk and the ordinals that go into the AAD of its
+ * modules.
+ */
+struct ChunkCipher
+{
+    std::shared_ptr<const ModuleCipher> cipher;
+    int64_t row_group = 0;
+    int64_t column = 0;
+
+    std::string aad(ModuleType type, int64_t page = -1) const { return cipher->aad(type, row_group, column, page); }
+};
+
+/**
+ * @brief The writer side: the ciphers of the footer and of every encrypted column.
+ */
+class FileEncryptor
+{
+public:
+    /**
+     * @throws std::invalid_argument for keys of the wrong size or unknown columns
+     */
+    FileEncryptor(const FileEncryptionProperties &properties, const std::vector<ColumnDescriptor> &columns);
+
+    bool plaintextFooter() const noexcept { return properties_.plaintext_footer; }
+    const FileEncryptionProperties &properties() const noexcept { return properties_; }
+    const EncryptionAlgorithm &algorithm() const noexcept { return algorithm_; }
+    const ModuleCipher &footerCipher() const noexcept { return *footer_cipher_; }
+
+    /**
+     * @return null for plaintext columns
+     */
+    const std::shared_ptr<const ModuleCipher> &columnCipher(size_t column) const { return column_ciphers_.at(column); }
+
+    ColumnCryptoMetaData cryptoMetaData(size_t column) const;
+
+private:
+    FileEncryptionProperties properties_;
+    std::vector<ColumnDescriptor> columns_;
+    EncryptionAlgorithm algorithm_;
+    std::shared_ptr<const ModuleCipher> footer_cipher_;
+    std::vector<std::shared_ptr<const ModuleCipher>> column_ciphers_;
+};
+
+/**
+ * @brief The reader side: finds the keys of a file and builds its ciphers.
+ */
+class FileDecryptor
+{
+public:
+    /**
+     * @param footer_key_metadata From FileCryptoMetaData, or the footer signing key
+     * metadata of a plaintext footer
+     * @throws ParquetException if the file AAD cannot be built
+     */
+    FileDecryptor(const FileDecryptionProperties &properties, const EncryptionAlgorithm &algorithm,
+                  const std::optional<std::string> &footer_key_metadata);
+
+    /**
+     * @return null if the footer key is unknown
+     */
+    const std::shared_ptr<const ModuleCipher> &footerCipher() const noexcept { return footer_cipher_; }
+
+    /**
+     * @return null if the column's key is unknown
+     */
+    std::shared_ptr<const ModuleCipher> columnCipher(const ColumnCryptoMetaData &crypto_metadata,
+                                                     const std::string &dotted_path);
+
+private:
+    const FileDecryptionProperties &properties_;
+    ParquetCipher cipher_;
+    std::string file_aad_;
+    std::shared_ptr<const ModuleCipher> footer_cipher_;
+    std::map<std::string, std::shared_ptr<const ModuleCipher>> column_ciphers_;
+};
+
+/**
+ * @brief Bytes from the operating system's secure random source.
+ * @throws std::system_error if it fails
+ */
+std::string randomBytes(size_t size);
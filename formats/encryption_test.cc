@@ -0,0 +1,431 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "encryption.hpp"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+namespace
+{
+    std::vector<uint8_t> hex(const std::string &digits)
+    {
+        std::vector<uint8_t> bytes;
+        for (size_t i = 0; i < digits.size(); i += 2)
+        {
+            bytes.push_back(static_cast<uint8_t>(std::stoi(digits.substr(i, 2), nullptr, 16)));
+        }
+        return bytes;
+    }
+
+    std::string tempPath(const std::string &name)
+    {
+        return testing::TempDir() + "/" + name;
+    }
+
+    const std::string kFooterKey = "0123456789012345";
+    const std::string kColumnKey = "abcdefghijklmnopqrstuvwxyz012345";
+
+    std::vector<ColumnDescriptor> columns()
+    {
+        std::vector<ColumnDescriptor> result(2);
+        result[0].path = {"id"};
+        result[0].type = AtomicType::INT64;
+        result[1].path = {"name"};
+        result[1].type = AtomicType::BYTE_ARRAY;
+        result[1].max_definition_level = 1;
+        return result;
+    }
+
+    void writeFile(const std::string &path, const FileEncryptionProperties &encryption,
+                   CompressionCodec codec = CompressionCodec::UNCOMPRESSED)
+    {
+        WriterOptions options;
+        options.codec = codec;
+        options.page_size = 500; // Many pages per chunk
+        options.bloom_filter_columns = {"id", "name"};
+        // Dictionary pages and page indexes are modules of their own
+        options.adaptive_encoding = true;
+        options.column_encodings = {{"name", Encoding::RLE_DICTIONARY}};
+        options.encryption = encryption;
+        ParquetFileWriter writer(path, columns(), options);
+        for (int64_t g = 0; g < 3; ++g)
+        {
+            ColumnBatch ids(AtomicType::INT64);
+            ColumnBatch names(AtomicType::BYTE_ARRAY);
+            for (int64_t i = g * 1000; i < (g + 1) * 1000; ++i)
+            {
+                *ids.appendValues<int64_t>(1) = i;
+                std::string name = "name" + std::to_string(i);
+                if (i % 7 == 0)
+                {
+                    names.appendNulls(1);
+                }
+                else
+                {
+                    names.appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+                }
+            }
+            writer.writeRowGroup({&ids, &names});
+        }
+        writer.close();
+    }
+
+    ColumnBatch readColumn(const ParquetFileReader &reader, size_t row_group, size_t column)
+    {
+        ColumnChunkReader chunk = reader.columnChunk(row_group, column);
+        ColumnBatch batch(reader.columns()[column].type);
+        while (chunk.readBatch(batch, 333) > 0)
+        {
+        }
+        return batch;
+    }
+
+    void expectContents(const ParquetFileReader &reader)
+    {
+        ASSERT_EQ(reader.numRowGroups(), 3u);
+        for (size_t g = 0; g < 3; ++g)
+        {
+            ColumnBatch ids = readColumn(reader, g, 0);
+            ColumnBatch names = readColumn(reader, g, 1);
+            ASSERT_EQ(ids.length(), 1000u);
+            ASSERT_EQ(names.length(), 1000u);
+            for (size_t i = 0; i < 1000; ++i)
+            {
+                auto row = static_cast<int64_t>(g * 1000 + i);
+                ASSERT_EQ(ids.value<int64_t>(i), row);
+                ASSERT_EQ(names.isValid(i), row % 7 != 0);
+                if (row % 7 != 0)
+                {
+                    ASSERT_EQ(names.byteArray(i), "name" + std::to_string(row));
+                }
+            }
+            EXPECT_EQ(reader.columnMetaData(g, 0).statistics->null_count, 0);
+            ColumnBatch probe(AtomicType::INT64);
+            *probe.appendValues<int64_t>(1) = static_cast<int64_t>(g * 1000 + 5);
+            EXPECT_TRUE(reader.bloomFilter(g, 0)->mightContain(BloomFilter::hash(probe, 0)));
+            EXPECT_TRUE(reader.columnMetaData(g, 1).dictionary_page_offset.has_value());
+            EXPECT_EQ(reader.columnIndex(g, 1)->null_pages.size(), reader.offsetIndex(g, 1)->page_locations.size());
+
+            // Pages found through the offset index are decrypted with their ordinals
+            Bitmap selection(1000);
+            for (size_t first : {0, 300, 600, 990})
+            {
+                selection.setRange(first, first + 10, true);
+            }
+            for (size_t c = 0; c < 2; ++c)
+            {
+                ColumnChunkReader chunk = reader.columnChunk(g, c);
+                chunk.selectPages(*reader.offsetIndex(g, c), reader.columnChunkRange(g, c).offset, selection);
+                ColumnBatch selected(reader.columns()[c].type);
+                ASSERT_EQ(chunk.readSelected(selected, selection, 0, 1000), 40u);
+                for (size_t i = 0; i < 40; ++i)
+                {
+                    size_t slot = (i / 10 == 3 ? 990 : i / 10 * 300) + i % 10;
+                    if (c == 0)
+                    {
+                        ASSERT_EQ(selected.value<int64_t>(i), ids.value<int64_t>(slot));
+                    }
+                    else
+                    {
+                        ASSERT_EQ(selected.isValid(i), names.isValid(slot));
+                        ASSERT_EQ(selected.byteArray(i), names.byteArray(slot));
+                    }
+                }
+            }
+        }
+    }
+
+    std::shared_ptr<const FileDecryptionProperties> footerKeyOnly()
+    {
+        auto decryption = std::make_shared<FileDecryptionProperties>();
+        decryption->footer_key = kFooterKey;
+        return decryption;
+    }
+
+    std::vector<char> readBytes(const std::string &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return std::vector<char>(std::istreambuf_iterator<char>(in), {});
+    }
+
+    void writeBytes(const std::string &path, const std::vector<char> &bytes)
+    {
+        std::ofstream(path, std::ios::binary).write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+} // namespace
+
+TEST(AesGcmTest, MatchesTestVectors)
+{
+    // From the GCM specification (McGrew and Viega), test cases 2, 4, 10 and 16
+    struct Vector
+    {
+        const char *key, *plaintext, *aad, *nonce, *ciphertext, *tag;
+    };
+    const std::string plaintext = "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e"
+                                  "2449a6b525b16aedf5aa0de657ba637b39";
+    const Vector vectors[] = {
+        {"00000000000000000000000000000000", "00000000000000000000000000000000", "", "000000000000000000000000",
+         "0388dace60b6a392f328c2b971b2fe78", "ab6e47d42cec13bdf53a67b21257bddf"},
+        {"feffe9928665731c6d6a8f9467308308", plaintext.c_str(), "feedfacedeadbeeffeedfacedeadbeefabaddad2",
+         "cafebabefacedbaddecaf888",
+         "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0a"
+         "ac973d58e091",
+         "5bc94fbc3221a5db94fae95ae7121a47"},
+        {"feffe9928665731c6d6a8f9467308308feffe9928665731c", plaintext.c_str(),
+         "feedfacedeadbeeffeedfacedeadbeefabaddad2", "cafebabefacedbaddecaf888",
+         "3980ca0b3c00e841eb06fac4872a2757859e1ceaa6efd984628593b40ca1e19c7d773d00c144c525ac619d18c84a3f4718e2448b2fe3"
+         "24d9ccda2710",
+         "2519498e80f1478f37ba55bd6d27618c"},
+        {"feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308", plaintext.c_str(),
+         "feedfacedeadbeeffeedfacedeadbeefabaddad2", "cafebabefacedbaddecaf888",
+         "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba"
+         "7a0abcc9f662",
+         "76fc6ece0f4e1768cddf8853bb2d551b"},
+    };
+    for (bool hardware : {false, true})
+    {
+        for (const Vector &vector : vectors)
+        {
+            std::vector<uint8_t> key = hex(vector.key);
+            std::vector<uint8_t> input = hex(vector.plaintext);
+            std::vector<uint8_t> aad = hex(vector.aad);
+            std::vector<uint8_t> nonce = hex(vector.nonce);
+            AesGcm aes(key.data(), key.size(), hardware);
+            std::vector<uint8_t> output(input.size());
+            std::vector<uint8_t> tag(kGcmTagSize);
+            aes.encrypt(nonce.data(), aad.data(), aad.size(), input.data(), input.size(), output.data(), tag.data());
+            EXPECT_EQ(output, hex(vector.ciphertext)) << vector.key;
+            EXPECT_EQ(tag, hex(vector.tag)) << vector.key;
+
+            std::vector<uint8_t> decrypted(input.size());
+            EXPECT_TRUE(aes.decrypt(nonce.data(), aad.data(), aad.size(), output.data(), output.size(),
+                                    decrypted.data(), tag.data()));
+            EXPECT_EQ(decrypted, input);
+            tag[0] ^= 1;
+            EXPECT_FALSE(aes.decrypt(nonce.data(), aad.data(), aad.size(), output.data(), output.size(),
+                                     decrypted.data(), tag.data()));
+        }
+    }
+    EXPECT_THROW(AesGcm(reinterpret_cast<const uint8_t *>("short"), 5), std::invalid_argument);
+}
+
+TEST(AesGcmTest, HardwareAndPortableCodeAgree)
+{
+    std::vector<uint8_t> key(32);
+    for (size_t i = 0; i < key.size(); ++i)
+    {
+        key[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+    AesGcm portable(key.data(), key.size(), false);
+    AesGcm hardware(key.data(), key.size(), true);
+    uint8_t nonce[kGcmNonceSize] = {1, 2, 3};
+    for (size_t size : {0, 1, 15, 16, 17, 63, 64, 65, 127, 128, 129, 255, 256, 257, 400, 1000, 10007})
+    {
+        std::vector<uint8_t> input(size);
+        std::vector<uint8_t> aad(size % 37);
+        for (size_t i = 0; i < size; ++i)
+        {
+            input[i] = static_cast<uint8_t>(i * 31);
+        }
+        std::vector<uint8_t> a(size);
+        std::vector<uint8_t> b(size);
+        uint8_t tag_a[kGcmTagSize];
+        uint8_t tag_b[kGcmTagSize];
+        portable.encrypt(nonce, aad.data(), aad.size(), input.data(), size, a.data(), tag_a);
+        hardware.encrypt(nonce, aad.data(), aad.size(), input.data(), size, b.data(), tag_b);
+        EXPECT_EQ(a, b) << size;
+        EXPECT_EQ(std::vector<uint8_t>(tag_a, tag_a + kGcmTagSize), std::vector<uint8_t>(tag_b, tag_b + kGcmTagSize));
+        for (const AesGcm *aes : {&portable, &hardware})
+        {
+            std::vector<uint8_t> decrypted(size, 1);
+            EXPECT_TRUE(aes->decrypt(nonce, aad.data(), aad.size(), a.data(), size, decrypted.data(), tag_a));
+            EXPECT_EQ(decrypted, input) << size;
+            // A tag that does not match leaves no plaintext behind, in place or not
+            tag_a[0] ^= 1;
+            EXPECT_FALSE(aes->decrypt(nonce, aad.data(), aad.size(), a.data(), size, decrypted.data(), tag_a));
+            EXPECT_EQ(decrypted, std::vector<uint8_t>(size)) << size;
+            std::vector<uint8_t> in_place = a;
+            EXPECT_FALSE(aes->decrypt(nonce, aad.data(), aad.size(), in_place.data(), size, in_place.data(), tag_a));
+            EXPECT_EQ(in_place, a) << size;
+            tag_a[0] ^= 1;
+            EXPECT_TRUE(aes->decrypt(nonce, aad.data(), aad.size(), in_place.data(), size, in_place.data(), tag_a));
+            EXPECT_EQ(in_place, input) << size;
+        }
+        portable.ctr(nonce, 1, input.data(), size, a.data());
+        hardware.ctr(nonce, 1, input.data(), size, b.data());
+        EXPECT_EQ(a, b) << size;
+    }
+}
+
+TEST(ModuleCipherTest, RoundTripsModules)
+{
+    for (ParquetCipher algorithm : {ParquetCipher::AES_GCM_V1, ParquetCipher::AES_GCM_CTR_V1})
+    {
+        ModuleCipher cipher(algorithm, kFooterKey, "file");
+        std::string page = "the values of a page";
+        std::string aad = cipher.aad(ModuleType::DATA_PAGE, 1, 2, 3);
+        EXPECT_EQ(aad, std::string("file\x02\x01\x00\x02\x00\x03\x00", 11));
+        std::vector<uint8_t> module;
+        cipher.encrypt(ModuleType::DATA_PAGE, reinterpret_cast<const uint8_t *>(page.data()), page.size(), aad,
+                       module);
+        ASSERT_EQ(module.size(), page.size() + cipher.overhead(ModuleType::DATA_PAGE));
+        EXPECT_EQ(ModuleCipher::moduleSize(module.data(), module.size()), module.size());
+        std::vector<uint8_t> plaintext = cipher.decrypt(ModuleType::DATA_PAGE, module.data(), module.size(), aad);
+        EXPECT_EQ(std::string(plaintext.begin(), plaintext.end()), page);
+        // Pages are only authenticated under GCM; headers always are
+        bool ctr = algorithm == ParquetCipher::AES_GCM_CTR_V1;
+        EXPECT_EQ(cipher.overhead(ModuleType::DATA_PAGE), ctr ? 16u : 32u);
+        EXPECT_EQ(cipher.overhead(ModuleType::DATA_PAGE_HEADER), 32u);
+        if (!ctr)
+        {
+            EXPECT_THROW(cipher.decrypt(ModuleType::DATA_PAGE, module.data(), module.size(),
+                                        cipher.aad(ModuleType::DATA_PAGE, 1, 2, 4)),
+                         ParquetException);
+        }
+        EXPECT_THROW(ModuleCipher::moduleSize(module.data(), module.size() - 1), ParquetException);
+    }
+    EXPECT_THROW(ModuleCipher(ParquetCipher::AES_GCM_V1, kFooterKey, "").aad(ModuleType::DATA_PAGE, 40000, 0, 0),
+                 ParquetException);
+}
+
+TEST(EncryptionTest, RoundTripsWithEncryptedFooter)
+{
+    for (ParquetCipher algorithm : {ParquetCipher::AES_GCM_V1, ParquetCipher::AES_GCM_CTR_V1})
+    {
+        for (CompressionCodec codec : {CompressionCodec::UNCOMPRESSED, CompressionCodec::SNAPPY})
+        {
+            std::string path = tempPath("encrypted_footer.parquet");
+            FileEncryptionProperties encryption;
+            encryption.cipher = algorithm;
+            encryption.footer_key = kFooterKey;
+            writeFile(path, encryption, codec);
+
+            std::vector<char> bytes = readBytes(path);
+            EXPECT_EQ(std::string(bytes.end() - 4, bytes.end()), "PARE");
+            EXPECT_EQ(std::string(bytes.data(), 4), "PARE");
+            EXPECT_EQ(std::string(bytes.begin(), bytes.end()).find("name123"), std::string::npos);
+
+            ParquetFileReader reader(path, footerKeyOnly());
+            expectContents(reader);
+            EXPECT_THROW(ParquetFileReader plain(path), ParquetException);
+            std::remove(path.c_str());
+        }
+    }
+}
+
+TEST(EncryptionTest, ColumnKeysAndPlaintextFooter)
+{
+    std::string path = tempPath("plaintext_footer.parquet");
+    FileEncryptionProperties encryption;
+    encryption.cipher = ParquetCipher::AES_GCM_CTR_V1;
+    encryption.footer_key = kFooterKey;
+    encryption.footer_key_metadata = "footer-key-v1";
+    encryption.columns["name"] = {kColumnKey, "name-key-v1"};
+    encryption.plaintext_footer = true;
+    writeFile(path, encryption, CompressionCodec::SNAPPY);
+    EXPECT_EQ(std::string(readBytes(path).data(), 4), "PAR1");
+
+    // Without keys: the plaintext column reads, the encrypted one throws
+    ParquetFileReader plain(path);
+    EXPECT_EQ(readColumn(plain, 1, 0).value<int64_t>(3), 1003);
+    EXPECT_FALSE(plain.columnMetaData(0, 1).statistics);
+    EXPECT_THROW(plain.columnChunk(0, 1), ParquetException);
+    EXPECT_THROW(plain.bloomFilter(0, 1), ParquetException);
+
+    // With keys found by their metadata
+    auto decryption = std::make_shared<FileDecryptionProperties>();
+    decryption->key_retriever = [](const std::string &key_metadata)
+    { return key_metadata == "footer-key-v1" ? kFooterKey : key_metadata == "name-key-v1" ? kColumnKey : ""; };
+    expectContents(ParquetFileReader(path, decryption));
+    EXPECT_TRUE(ParquetFileReader(path, decryption).columnMetaData(0, 1).statistics);
+
+    // A reader with only the footer key checks the signature and reads the plaintext column
+    ParquetFileReader footer_only(path, footerKeyOnly());
+    EXPECT_EQ(readColumn(footer_only, 2, 0).length(), 1000u);
+    EXPECT_THROW(footer_only.columnChunk(0, 1), ParquetException);
+
+    auto wrong = std::make_shared<FileDecryptionProperties>();
+    wrong->footer_key = kColumnKey;
+    EXPECT_THROW(ParquetFileReader(path, wrong), ParquetException);
+    wrong->check_footer_signature = false;
+    wrong->column_keys["name"] = kFooterKey;
+    EXPECT_THROW(readColumn(ParquetFileReader(path, wrong), 0, 1), ParquetException);
+    std::remove(path.c_str());
+}
+
+TEST(EncryptionTest, DetectsTampering)
+{
+    std::string path = tempPath("tampered.parquet");
+    FileEncryptionProperties encryption;
+    encryption.footer_key = kFooterKey;
+    writeFile(path, encryption);
+    std::vector<char> bytes = readBytes(path);
+    ParquetFileReader reader(path, footerKeyOnly());
+    ReadRange range = reader.columnChunkRange(1, 1);
+
+    // A flipped bit in a page
+    bytes[range.offset + range.length / 2] ^= 1;
+    writeBytes(path, bytes);
+    ParquetFileReader tampered(path, footerKeyOnly());
+    EXPECT_NO_THROW(readColumn(tampered, 0, 1));
+    EXPECT_THROW(readColumn(tampered, 1, 1), ParquetException);
+
+    // A flipped bit in the footer
+    bytes[range.offset + range.length / 2] ^= 1;
+    bytes[bytes.size() - 20] ^= 1;
+    writeBytes(path, bytes);
+    EXPECT_THROW(ParquetFileReader(path, footerKeyOnly()), ParquetException);
+
+    auto wrong = std::make_shared<FileDecryptionProperties>();
+    wrong->footer_key = kColumnKey;
+    bytes[bytes.size() - 20] ^= 1;
+    writeBytes(path, bytes);
+    EXPECT_THROW(ParquetFileReader(path, wrong), ParquetException);
+    EXPECT_THROW(ParquetFileReader(path, std::make_shared<FileDecryptionProperties>()), ParquetException);
+    std::remove(path.c_str());
+}
+
+TEST(EncryptionTest, AadPrefix)
+{
+    std::string path = tempPath("aad_prefix.parquet");
+    FileEncryptionProperties encryption;
+    encryption.footer_key = kFooterKey;
+    encryption.aad_prefix = "table/part-0";
+    encryption.store_aad_prefix = false;
+    writeFile(path, encryption);
+
+    EXPECT_THROW(ParquetFileReader(path, footerKeyOnly()), ParquetException);
+    auto decryption = std::make_shared<FileDecryptionProperties>();
+    decryption->footer_key = kFooterKey;
+    decryption->aad_prefix = "table/part-1";
+    EXPECT_THROW(ParquetFileReader(path, decryption), ParquetException);
+    decryption->aad_prefix = "table/part-0";
+    expectContents(ParquetFileReader(path, decryption));
+
+    encryption.store_aad_prefix = true;
+    writeFile(path, encryption);
+    expectContents(ParquetFileReader(path, footerKeyOnly()));
+    decryption->aad_prefix = "table/part-1";
+    EXPECT_THROW(ParquetFileReader(path, decryption), ParquetException);
+    std::remove(path.c_str());
+}
+
+TEST(EncryptionTest, RejectsInvalidProperties)
+{
+    FileEncryptionProperties encryption;
+    encryption.footer_key = "too short";
+    EXPECT_THROW(writeFile(tempPath("invalid.parquet"), encryption), std::invalid_argument);
+    encryption.footer_key = kFooterKey;
+    encryption.columns["missing"] = {kColumnKey, ""};
+    EXPECT_THROW(writeFile(tempPath("invalid.parquet"), encryption), std::invalid_argument);
+    encryption.columns.clear();
+    encryption.store_aad_prefix = false;
+    EXPECT_THROW(writeFile(tempPath("invalid.parquet"), encryption), std::invalid_argument);
+    std::remove(tempPath("invalid.parquet").c_str());
+}
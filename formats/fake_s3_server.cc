@@ -0,0 +1,197 @@
+#include "fake_s3_server.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <thread>
+
+#include "sha256.hpp"
+
+namespace
+{
+    HttpResponse errorResponse(int status, const std::string &code)
+    {
+        HttpResponse response;
+        response.status = status;
+        response.headers.emplace_back("Content-Type", "application/xml");
+        std::string body = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<Error><Code>" + code + "</Code></Error>";
+        response.body.assign(body.begin(), body.end());
+        return response;
+    }
+
+    std::string percentDecode(const std::string &value)
+    {
+        std::string decoded;
+        for (size_t i = 0; i < value.size(); ++i)
+        {
+            if (value[i] == '%' && i + 2 < value.size())
+            {
+                decoded += static_cast<char>(std::strtol(value.substr(i + 1, 2).c_str(), nullptr, 16));
+                i += 2;
+            }
+            else
+            {
+                decoded += value[i];
+            }
+        }
+        return decoded;
+    }
+
+    // Resolves a Range header against the object size; false if it cannot be satisfied
+    bool resolveRange(const std::string &header, uint64_t size, uint64_t &first, uint64_t &last)
+    {
+        if (header.compare(0, 6, "bytes=") != 0 || header.find(',') != std::string::npos)
+        {
+            return false;
+        }
+        std::string spec = header.substr(6);
+        size_t dash = spec.find('-');
+        if (dash == std::string::npos)
+        {
+            return false;
+        }
+        std::string start = spec.substr(0, dash);
+        std::string end = spec.substr(dash + 1);
+        if (start.empty())
+        {
+            uint64_t suffix = std::strtoull(end.c_str(), nullptr, 10);
+            if (suffix == 0 || size == 0)
+            {
+                return false;
+            }
+            first = suffix >= size ? 0 : size - suffix;
+            last = size - 1;
+            return true;
+        }
+        first = std::strtoull(start.c_str(), nullptr, 10);
+        last = end.empty() ? size - 1 : std::min<uint64_t>(std::strtoull(end.c_str(), nullptr, 10), size - 1);
+        return first < size && first <= last;
+    }
+} // namespace
+
+FakeS3Server::FakeS3Server(std::chrono::microseconds latency)
+    : latency_us_(latency.count()),
+      server_(std::make_unique<HttpServer>([this](const HttpRequest &request)
+                                           { return handle(request); }))
+{
+}
+
+std::string FakeS3Server::endpoint() const
+{
+    return "http://127.0.0.1:" + std::to_string(server_->port());
+}
+
+void FakeS3Server::putObject(const std::string &bucket, const std::string &key, std::vector<uint8_t> bytes)
+{
+    auto object = std::make_shared<Object>();
+    // Real ETags are MD5 digests; any digest of the contents will do
+    object->etag = "\"" + toHex(sha256(std::string(bytes.begin(), bytes.end()))).substr(0, 32) + "\"";
+    object->bytes = std::move(bytes);
+    std::lock_guard<std::mutex> lock(mutex_);
+    objects_[bucket + "/" + key] = std::move(object);
+}
+
+FakeS3Stats FakeS3Server::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void FakeS3Server::resetStats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = FakeS3Stats();
+}
+
+HttpResponse FakeS3Server::handle(const HttpRequest &request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.requests;
+        stats_.get_requests += request.method == "GET";
+        stats_.head_requests += request.method == "HEAD";
+    }
+    if (int64_t latency = latency_us_.load(); latency > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(latency));
+    }
+    size_t failures = failures_.load();
+    while (failures > 0 && !failures_.compare_exchange_weak(failures, failures - 1))
+    {
+    }
+    if (failures > 0)
+    {
+        return errorResponse(503, "SlowDown");
+    }
+
+    std::string path = percentDecode(request.target.substr(0, request.target.find('?')));
+    std::string name = path.empty() ? path : path.substr(1);
+    if (request.method == "PUT")
+    {
+        size_t slash = name.find('/');
+        if (slash == std::string::npos)
+        {
+            return errorResponse(400, "InvalidRequest");
+        }
+        putObject(name.substr(0, slash), name.substr(slash + 1), request.body);
+        HttpResponse response;
+        response.status = 200;
+        return response;
+    }
+    if (request.method != "GET" && request.method != "HEAD")
+    {
+        return errorResponse(400, "InvalidRequest");
+    }
+
+    std::shared_ptr<const Object> object;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = objects_.find(name);
+        if (it != objects_.end())
+        {
+            object = it->second;
+        }
+    }
+    if (!object)
+    {
+        return errorResponse(404, "NoSuchKey");
+    }
+    const std::string *if_match = request.header("If-Match");
+    if (if_match && *if_match != object->etag)
+    {
+        return errorResponse(412, "PreconditionFailed");
+    }
+
+    HttpResponse response;
+    response.headers.emplace_back("ETag", object->etag);
+    response.headers.emplace_back("Accept-Ranges", "bytes");
+    uint64_t size = object->bytes.size();
+    uint64_t first = 0;
+    uint64_t last = size == 0 ? 0 : size - 1;
+    const std::string *range = request.header("Range");
+    if (range)
+    {
+        if (!resolveRange(*range, size, first, last))
+        {
+            return errorResponse(416, "InvalidRange");
+        }
+        response.status = 206;
+        response.headers.emplace_back("Content-Range", "bytes " + std::to_string(first) + "-" +
+                                                           std::to_string(last) + "/" + std::to_string(size));
+    }
+    else
+    {
+        response.status = 200;
+    }
+    uint64_t length = size == 0 ? 0 : last - first + 1;
+    if (request.method == "HEAD")
+    {
+        response.headers.emplace_back("Content-Length", std::to_string(length));
+        return response;
+    }
+    response.body.assign(object->bytes.begin() + static_cast<std::ptrdiff_t>(first),
+                         object->bytes.begin() + static_cast<std::ptrdiff_t>(first + length));
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.bytes += length;
+    return response;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "http.hpp"
+
+struct FakeS3Stats
+{
+    uint64_t requests = 0;
+    uint64_t get_requests = 0;
+    uint64_t head_requests = 0;
+
+    /// Body bytes sent
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief An in-process S3 stand-in for tests and benchmarks: serves GET (with Range and
+ * If-Match), HEAD and PUT of objects held in memory, with path-style addressing on
+ * 127.0.0.1. Requests are not authenticated.
+ *
+ * Every request is delayed by the configured latency, which models the first-byte
+ * latency of an object store, and failures can be injected to exercise retries.
+ */
+class FakeS3Server
+{
+public:
+    explicit FakeS3Server(std::chrono::microseconds latency = {});
+
+    /**
+     * @brief The endpoint to put into S3Options, http://127.0.0.1:port.
+     */
+    std::string endpoint() const;
+
+    void putObject(const std::string &bucket, const std::string &key, std::vector<uint8_t> bytes);
+
+    void setLatency(std::chrono::microseconds latency) { latency_us_ = latency.count(); }
+
+    /**
+     * @brief Answers the next `count` requests with 503 SlowDown.
+     */
+    void failRequests(size_t count) { failures_ = count; }
+
+    FakeS3Stats stats() const;
+    void resetStats();
+
+private:
+    struct Object
+    {
+        std::vector<uint8_t> bytes;
+        std::string etag;
+    };
+
+    HttpResponse handle(const HttpRequest &request);
+
+    std::atomic<int64_t> latency_us_;
+    std::atomic<size_t> failures_{0};
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<const Object>> objects_;
+    FakeS3Stats stats_;
+
+    // Last, so it stops serving before the objects go away
+    std::unique_ptr<HttpServer> server_;
+};
@@ -0,0 +1,15 @@
+#include "filesystem.hpp"
+
+std::shared_ptr<const RandomAccessFile> LocalFileSystem::openFile(const std::string &path) const
+{
+    if (options_.io_uring && IoUringFile::isSupported())
+    {
+        return std::make_shared<IoUringFile>(path, options_.io_uring_options);
+    }
+    return std::make_shared<LocalFile>(path);
+}
+
+std::shared_ptr<const RandomAccessFile> CachingFileSystem::openFile(const std::string &path) const
+{
+    return std::make_shared<CachedFile>(base_->openFile(path), cache_);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "block_cache.hpp"
+#include "io.hpp"
+#include "io_uring_file.hpp"
+
+/**
+ * @brief Opens files for random access; implemented for local disks and object stores.
+ */
+class FileSystem
+{
+public:
+    virtual ~FileSystem() = default;
+
+    /**
+     * @throws std::system_error if the file does not exist or cannot be opened
+     */
+    virtual std::shared_ptr<const RandomAccessFile> openFile(const std::string &path) const = 0;
+};
+
+struct LocalFileSystemOptions
+{
+    /// Read through IoUringFile where the kernel supports it
+    bool io_uring = false;
+    IoUringOptions io_uring_options;
+};
+
+class LocalFileSystem : public FileSystem
+{
+public:
+    explicit LocalFileSystem(LocalFileSystemOptions options = {}) : options_(options) {}
+
+    std::shared_ptr<const RandomAccessFile> openFile(const std::string &path) const override;
+
+private:
+    LocalFileSystemOptions options_;
+};
+
+/**
+ * @brief Wraps the files of another file system in CachedFiles sharing one BlockCache.
+ */
+class CachingFileSystem : public FileSystem
+{
+public:
+    CachingFileSystem(std::shared_ptr<const FileSystem> base, std::shared_ptr<BlockCache> cache)
+        : base_(std::move(base)), cache_(std::move(cache)) {}
+
+    std::shared_ptr<const RandomAccessFile> openFile(const std::string &path) const override;
+
+    const std::shared_ptr<BlockCache> &cache() const noexcept { return cache_; }
+
+private:
+    std::shared_ptr<const FileSystem> base_;
+    std::shared_ptr<BlockCache> cache_;
+};
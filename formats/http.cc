@@ -0,0 +1,537 @@
+#include "http.hpp"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+namespace
+{
+    // Upper bound of a request or response head, a guard against garbage
+    constexpr size_t kMaxHeadSize = 64 * 1024;
+
+    [[noreturn]] void throwErrno(const std::string &what)
+    {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    [[noreturn]] void throwProtocolError(const std::string &what)
+    {
+        throw std::system_error(std::make_error_code(std::errc::protocol_error), what);
+    }
+
+    bool equalsIgnoreCase(const std::string &a, const std::string &b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+                                                  { return std::tolower(static_cast<unsigned char>(x)) ==
+                                                           std::tolower(static_cast<unsigned char>(y)); });
+    }
+
+    void writeAll(int fd, const void *data, size_t size)
+    {
+        const char *p = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throwErrno("Cannot send");
+            }
+            p += n;
+            size -= static_cast<size_t>(n);
+        }
+    }
+
+    size_t receive(int fd, void *out, size_t size)
+    {
+        while (true)
+        {
+            ssize_t n = ::recv(fd, out, size, 0);
+            if (n >= 0)
+            {
+                return static_cast<size_t>(n);
+            }
+            if (errno != EINTR)
+            {
+                throwErrno("Cannot receive");
+            }
+        }
+    }
+
+    // A socket with the bytes received past the last message
+    struct Stream
+    {
+        int fd = -1;
+        std::string buffer;
+
+        /**
+         * Reads up to the empty line ending a message head. Returns false when the peer
+         * closed the connection before sending anything.
+         */
+        bool readHead(std::string &head)
+        {
+            size_t searched = 0;
+            while (true)
+            {
+                size_t end = buffer.find("\r\n\r\n", searched > 3 ? searched - 3 : 0);
+                if (end != std::string::npos)
+                {
+                    head = buffer.substr(0, end);
+                    buffer.erase(0, end + 4);
+                    return true;
+                }
+                if (buffer.size() > kMaxHeadSize)
+                {
+                    throwProtocolError("HTTP head too large");
+                }
+                searched = buffer.size();
+                char chunk[16 * 1024];
+                size_t n = receive(fd, chunk, sizeof(chunk));
+                if (n == 0)
+                {
+                    if (buffer.empty())
+                    {
+                        return false;
+                    }
+                    throwProtocolError("Connection closed within an HTTP head");
+                }
+                buffer.append(chunk, n);
+            }
+        }
+
+        void readBody(size_t length, std::vector<uint8_t> &body)
+        {
+            body.resize(length);
+            size_t buffered = std::min(length, buffer.size());
+            std::memcpy(body.data(), buffer.data(), buffered);
+            buffer.erase(0, buffered);
+            for (size_t done = buffered; done < length;)
+            {
+                size_t n = receive(fd, body.data() + done, length - done);
+                if (n == 0)
+                {
+                    throwProtocolError("Connection closed within an HTTP body");
+                }
+                done += n;
+            }
+        }
+
+        void readToEnd(std::vector<uint8_t> &body)
+        {
+            body.assign(buffer.begin(), buffer.end());
+            buffer.clear();
+            while (true)
+            {
+                size_t done = body.size();
+                body.resize(done + 64 * 1024);
+                size_t n = receive(fd, body.data() + done, 64 * 1024);
+                body.resize(done + n);
+                if (n == 0)
+                {
+                    return;
+                }
+            }
+        }
+    };
+
+    // Splits a head into its first line and headers
+    std::string parseHead(const std::string &head, HttpHeaders &headers)
+    {
+        size_t line_end = head.find("\r\n");
+        std::string first = head.substr(0, line_end);
+        while (line_end != std::string::npos)
+        {
+            size_t start = line_end + 2;
+            line_end = head.find("\r\n", start);
+            std::string line = head.substr(start, line_end == std::string::npos ? std::string::npos : line_end - start);
+            size_t colon = line.find(':');
+            if (colon == std::string::npos)
+            {
+                throwProtocolError("Malformed HTTP header");
+            }
+            size_t value = line.find_first_not_of(" \t", colon + 1);
+            size_t value_end = line.find_last_not_of(" \t");
+            headers.emplace_back(line.substr(0, colon), value == std::string::npos
+                                                            ? std::string()
+                                                            : line.substr(value, value_end - value + 1));
+        }
+        return first;
+    }
+
+    bool contentLength(const HttpHeaders &headers, size_t &length)
+    {
+        const std::string *value = findHeader(headers, "Content-Length");
+        if (!value)
+        {
+            return false;
+        }
+        try
+        {
+            length = std::stoull(*value);
+        }
+        catch (const std::exception &)
+        {
+            throwProtocolError("Invalid Content-Length");
+        }
+        return true;
+    }
+
+    void appendHeaders(std::string &head, const HttpHeaders &headers)
+    {
+        for (const auto &[name, value] : headers)
+        {
+            head += name;
+            head += ": ";
+            head += value;
+            head += "\r\n";
+        }
+    }
+
+    const char *reasonPhrase(int status)
+    {
+        switch (status)
+        {
+        case 200:
+            return "OK";
+        case 206:
+            return "Partial Content";
+        case 304:
+            return "Not Modified";
+        case 400:
+            return "Bad Request";
+        case 403:
+            return "Forbidden";
+        case 404:
+            return "Not Found";
+        case 412:
+            return "Precondition Failed";
+        case 416:
+            return "Range Not Satisfiable";
+        case 500:
+            return "Internal Server Error";
+        case 503:
+            return "Service Unavailable";
+        default:
+            return "Unknown";
+        }
+    }
+} // namespace
+
+const std::string *findHeader(const HttpHeaders &headers, const std::string &name)
+{
+    for (const auto &header : headers)
+    {
+        if (equalsIgnoreCase(header.first, name))
+        {
+            return &header.second;
+        }
+    }
+    return nullptr;
+}
+
+struct HttpClient::Connection : Stream
+{
+    ~Connection()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+};
+
+HttpClient::HttpClient(std::string host, uint16_t port, size_t max_idle_connections)
+    : host_(std::move(host)), port_(port), authority_(host_ + ":" + std::to_string(port)),
+      max_idle_connections_(max_idle_connections)
+{
+}
+
+HttpClient::~HttpClient() = default;
+
+std::unique_ptr<HttpClient::Connection> HttpClient::connect()
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    int status = ::getaddrinfo(host_.c_str(), std::to_string(port_).c_str(), &hints, &addresses);
+    if (status != 0)
+    {
+        throw std::system_error(std::make_error_code(std::errc::host_unreachable),
+                                "Cannot resolve " + host_ + ": " + ::gai_strerror(status));
+    }
+
+    auto connection = std::make_unique<Connection>();
+    int error = 0;
+    for (addrinfo *address = addresses; address; address = address->ai_next)
+    {
+        int fd = ::socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if (fd < 0)
+        {
+            error = errno;
+            continue;
+        }
+        if (::connect(fd, address->ai_addr, address->ai_addrlen) == 0)
+        {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+            connection->fd = fd;
+            break;
+        }
+        error = errno;
+        ::close(fd);
+    }
+    ::freeaddrinfo(addresses);
+    if (connection->fd < 0)
+    {
+        throw std::system_error(error, std::generic_category(), "Cannot connect to " + authority_);
+    }
+    return connection;
+}
+
+HttpResponse HttpClient::send(const HttpRequest &request)
+{
+    std::string head = request.method + " " + request.target + " HTTP/1.1\r\nHost: " + authority_ + "\r\n";
+    appendHeaders(head, request.headers);
+    if (!request.body.empty() || request.method == "PUT" || request.method == "POST")
+    {
+        head += "Content-Length: " + std::to_string(request.body.size()) + "\r\n";
+    }
+    head += "\r\n";
+
+    for (int attempt = 0;; ++attempt)
+    {
+        std::unique_ptr<Connection> connection;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!idle_.empty() && attempt == 0)
+            {
+                connection = std::move(idle_.back());
+                idle_.pop_back();
+            }
+        }
+        bool reused = connection != nullptr;
+        if (!reused)
+        {
+            connection = connect();
+        }
+
+        HttpResponse response;
+        std::string response_head;
+        try
+        {
+            writeAll(connection->fd, head.data(), head.size());
+            writeAll(connection->fd, request.body.data(), request.body.size());
+            if (!connection->readHead(response_head))
+            {
+                throwProtocolError("Connection closed by " + authority_);
+            }
+        }
+        catch (const std::system_error &)
+        {
+            // The server may have closed an idle connection, which only shows on use
+            if (reused)
+            {
+                continue;
+            }
+            throw;
+        }
+
+        std::string status_line = parseHead(response_head, response.headers);
+        if (status_line.compare(0, 5, "HTTP/") != 0 || status_line.size() < 12)
+        {
+            throwProtocolError("Malformed HTTP status line from " + authority_);
+        }
+        response.status = std::atoi(status_line.c_str() + 9);
+
+        bool keep_alive = true;
+        size_t length = 0;
+        if (request.method == "HEAD" || response.status == 204 || response.status == 304 ||
+            response.status / 100 == 1)
+        {
+            // No body
+        }
+        else if (contentLength(response.headers, length))
+        {
+            connection->readBody(length, response.body);
+        }
+        else
+        {
+            connection->readToEnd(response.body);
+            keep_alive = false;
+        }
+        const std::string *connection_header = response.header("Connection");
+        if (connection_header && equalsIgnoreCase(*connection_header, "close"))
+        {
+            keep_alive = false;
+        }
+
+        if (keep_alive)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (idle_.size() < max_idle_connections_)
+            {
+                idle_.push_back(std::move(connection));
+            }
+        }
+        return response;
+    }
+}
+
+HttpServer::HttpServer(Handler handler, uint16_t port) : handler_(std::move(handler))
+{
+    listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0)
+    {
+        throwErrno("Cannot create a socket");
+    }
+    int one = 1;
+    ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    socklen_t address_size = sizeof(address);
+    if (::bind(listen_fd_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        ::listen(listen_fd_, 128) != 0 ||
+        ::getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&address), &address_size) != 0)
+    {
+        int error = errno;
+        ::close(listen_fd_);
+        throw std::system_error(error, std::generic_category(), "Cannot listen on port " + std::to_string(port));
+    }
+    port_ = ntohs(address.sin_port);
+    acceptor_ = std::thread([this]()
+                            { acceptLoop(); });
+}
+
+HttpServer::~HttpServer()
+{
+    stopping_ = true;
+    // Wakes up accept()
+    ::shutdown(listen_fd_, SHUT_RDWR);
+    acceptor_.join();
+    ::close(listen_fd_);
+
+    std::vector<std::thread> workers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int fd : open_fds_)
+        {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+        workers.swap(workers_);
+    }
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void HttpServer::acceptLoop()
+{
+    while (true)
+    {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_)
+        {
+            ::close(fd);
+            return;
+        }
+        int one = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        ++connections_;
+        open_fds_.push_back(fd);
+        workers_.emplace_back([this, fd]()
+                              { serve(fd); });
+    }
+}
+
+void HttpServer::serve(int fd)
+{
+    Stream stream;
+    stream.fd = fd;
+    try
+    {
+        std::string head;
+        while (!stopping_ && stream.readHead(head))
+        {
+            HttpRequest request;
+            std::string request_line = parseHead(head, request.headers);
+            size_t method_end = request_line.find(' ');
+            size_t target_end = request_line.rfind(' ');
+            if (method_end == std::string::npos || target_end <= method_end)
+            {
+                throwProtocolError("Malformed HTTP request line");
+            }
+            request.method = request_line.substr(0, method_end);
+            request.target = request_line.substr(method_end + 1, target_end - method_end - 1);
+            size_t length = 0;
+            if (contentLength(request.headers, length))
+            {
+                stream.readBody(length, request.body);
+            }
+
+            HttpResponse response;
+            try
+            {
+                response = handler_(request);
+            }
+            catch (const std::exception &e)
+            {
+                response = HttpResponse();
+                response.status = 500;
+                std::string message = e.what();
+                response.body.assign(message.begin(), message.end());
+            }
+
+            std::string response_head = "HTTP/1.1 " + std::to_string(response.status) + " " +
+                                        reasonPhrase(response.status) + "\r\n";
+            appendHeaders(response_head, response.headers);
+            if (!response.header("Content-Length"))
+            {
+                response_head += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+            }
+            response_head += "\r\n";
+            writeAll(fd, response_head.data(), response_head.size());
+            if (request.method != "HEAD")
+            {
+                writeAll(fd, response.body.data(), response.body.size());
+            }
+            const std::string *connection = request.header("Connection");
+            if (connection && equalsIgnoreCase(*connection, "close"))
+            {
+                break;
+            }
+        }
+    }
+    catch (const std::system_error &)
+    {
+        // The client went away or sent garbage; drop the connection
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_fds_.erase(std::find(open_fds_.begin(), open_fds_.end(), fd));
+    ::close(fd);
+}
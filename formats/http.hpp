@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Minimal HTTP/1.1 over plain TCP: a client with keep-alive connection pooling for the
+// object store backend, and a server for the in-process fake object store. Bodies are
+// framed by Content-Length; chunked transfer encoding and TLS are not supported.
+
+using HttpHeaders = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * @brief The value of a header (names compare case-insensitively), null when missing.
+ */
+const std::string *findHeader(const HttpHeaders &headers, const std::string &name);
+
+struct HttpRequest
+{
+    std::string method;
+
+    /// Path and query, e.g. /bucket/key?versionId=1
+    std::string target;
+
+    HttpHeaders headers;
+    std::vector<uint8_t> body;
+
+    const std::string *header(const std::string &name) const { return findHeader(headers, name); }
+};
+
+struct HttpResponse
+{
+    int status = 0;
+    HttpHeaders headers;
+    std::vector<uint8_t> body;
+
+    const std::string *header(const std::string &name) const { return findHeader(headers, name); }
+};
+
+/**
+ * @brief Sends requests to one host, reusing idle connections. Thread safe; concurrent
+ * requests use separate connections.
+ */
+class HttpClient
+{
+public:
+    /**
+     * @param max_idle_connections Idle connections kept open for reuse
+     */
+    HttpClient(std::string host, uint16_t port, size_t max_idle_connections = 64);
+    ~HttpClient();
+
+    HttpClient(const HttpClient &) = delete;
+    HttpClient &operator=(const HttpClient &) = delete;
+
+    /**
+     * @brief Sends the request and reads the whole response. Adds the Host and
+     * Content-Length headers. A request on a reused connection that the server closed in
+     * the meantime is retried once on a new connection.
+     * @throws std::system_error on connection errors, or a malformed response
+     */
+    HttpResponse send(const HttpRequest &request);
+
+    /**
+     * @brief The value of the Host header, host:port.
+     */
+    const std::string &authority() const noexcept { return authority_; }
+
+private:
+    struct Connection;
+
+    std::unique_ptr<Connection> connect();
+
+    std::string host_;
+    uint16_t port_;
+    std::string authority_;
+    size_t max_idle_connections_;
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Connection>> idle_;
+};
+
+/**
+ * @brief Serves HTTP on 127.0.0.1 with one thread per connection, for tests and
+ * benchmarks. The handler runs concurrently for different connections.
+ */
+class HttpServer
+{
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest &)>;
+
+    /**
+     * @param port The port to listen on, 0 picks a free one
+     * @throws std::system_error if the socket cannot be set up
+     */
+    explicit HttpServer(Handler handler, uint16_t port = 0);
+
+    /**
+     * @brief Closes all connections and waits for the handlers to return.
+     */
+    ~HttpServer();
+
+    HttpServer(const HttpServer &) = delete;
+    HttpServer &operator=(const HttpServer &) = delete;
+
+    uint16_t port() const noexcept { return port_; }
+
+    /**
+     * @brief Connections accepted so far.
+     */
+    size_t connections() const noexcept { return connections_.load(); }
+
+private:
+    void acceptLoop();
+    void serve(int fd);
+
+    Handler handler_;
+    int listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::atomic<size_t> connections_{0};
+    std::thread acceptor_;
+
+    std::mutex mutex_;
+    std::vector<int> open_fds_;
+    std::vector<std::thread> workers_;
+};
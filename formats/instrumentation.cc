@@ -0,0 +1,600 @@
+#include "instrumentation.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+namespace instrumentation
+{
+    namespace
+    {
+        struct StageCounters
+        {
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> total_ns{0};
+            std::atomic<uint64_t> max_ns{0};
+            std::array<std::atomic<uint64_t>, kHistogramBuckets> buckets{};
+        };
+
+        struct TraceEvent
+        {
+            Stage stage;
+            uint64_t start_ns;
+            uint64_t duration_ns;
+        };
+
+        /**
+         * @brief The counters of one thread. Only the owning thread writes them, so updates
+         * are a relaxed load and store instead of a locked read-modify-write; snapshot()
+         * reads them concurrently. Trace events are rare enough for a mutex, which is
+         * uncontended unless a trace is being started or written.
+         */
+        struct ThreadState
+        {
+            size_t id = 0;
+            std::array<std::atomic<uint64_t>, kNumCounters> counters{};
+            std::array<StageCounters, kNumStages> stages{};
+
+            std::mutex trace_mutex;
+            std::vector<TraceEvent> events;
+            uint64_t dropped_events = 0;
+        };
+
+        struct ThreadEvent
+        {
+            size_t thread;
+            TraceEvent event;
+        };
+
+        struct Registry
+        {
+            std::mutex mutex;
+            std::vector<ThreadState *> threads;
+            size_t next_thread_id = 1;
+
+            // What exited threads recorded
+            Snapshot retired;
+            std::vector<ThreadEvent> retired_events;
+            uint64_t retired_dropped_events = 0;
+        };
+
+        // Never destroyed: threads may exit during static destruction
+        Registry &registry()
+        {
+            static Registry *registry = new Registry();
+            return *registry;
+        }
+
+        std::atomic<bool> enabled_flag{true};
+        std::atomic<bool> tracing_flag{false};
+        std::atomic<size_t> trace_capacity{0};
+        std::atomic<uint64_t> trace_start_ns{0};
+        std::atomic<uint64_t> trace_start_ticks{0};
+
+        /**
+         * @brief What nowTicks() reads and how ticks convert to nanoseconds. The time stamp
+         * counter is used when the CPU reports it invariant (constant rate, running in every
+         * power state); its rate is measured against the steady clock over a millisecond,
+         * once. Reading the steady clock costs some 30-40 ns, twice per timed stage, while
+         * the counter takes a fraction of that.
+         */
+        struct TickClock
+        {
+            bool tsc = false;
+            double nanos_per_tick = 1.0;
+
+            uint64_t nanos(uint64_t ticks) const noexcept
+            {
+                return tsc ? static_cast<uint64_t>(static_cast<double>(ticks) * nanos_per_tick) : ticks;
+            }
+        };
+
+        TickClock calibrate() noexcept
+        {
+            TickClock clock;
+#if defined(__x86_64__)
+            unsigned int eax = 0;
+            unsigned int ebx = 0;
+            unsigned int ecx = 0;
+            unsigned int edx = 0;
+            if (__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0)
+            {
+                uint64_t start_ns = nowNanos();
+                uint64_t start_ticks = __rdtsc();
+                uint64_t end_ns;
+                uint64_t end_ticks;
+                do
+                {
+                    end_ns = nowNanos();
+                    end_ticks = __rdtsc();
+                } while (end_ns - start_ns < 1000000);
+                if (end_ticks > start_ticks)
+                {
+                    clock.tsc = true;
+                    clock.nanos_per_tick =
+                        static_cast<double>(end_ns - start_ns) / static_cast<double>(end_ticks - start_ticks);
+                }
+            }
+#endif
+            return clock;
+        }
+
+        const TickClock &tickClock() noexcept
+        {
+            static const TickClock clock = calibrate();
+            return clock;
+        }
+
+        void increment(std::atomic<uint64_t> &value, uint64_t n)
+        {
+            value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        void accumulate(Snapshot &into, const ThreadState &state)
+        {
+            for (size_t i = 0; i < kNumCounters; ++i)
+            {
+                into.counters[i] += state.counters[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < kNumStages; ++i)
+            {
+                const StageCounters &stage = state.stages[i];
+                Histogram &histogram = into.stages[i];
+                histogram.count += stage.count.load(std::memory_order_relaxed);
+                histogram.total_ns += stage.total_ns.load(std::memory_order_relaxed);
+                histogram.max_ns = std::max(histogram.max_ns, stage.max_ns.load(std::memory_order_relaxed));
+                for (size_t b = 0; b < kHistogramBuckets; ++b)
+                {
+                    histogram.buckets[b] += stage.buckets[b].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief Registers the thread's state on first use and folds it into the retired
+         * totals when the thread exits.
+         */
+        class ThreadHandle
+        {
+        public:
+            ThreadHandle() : state_(std::make_unique<ThreadState>())
+            {
+                Registry &r = registry();
+                std::lock_guard<std::mutex> lock(r.mutex);
+                state_->id = r.next_thread_id++;
+                r.threads.push_back(state_.get());
+            }
+
+            ~ThreadHandle();
+
+            ThreadState *state() const noexcept { return state_.get(); }
+
+        private:
+            std::unique_ptr<ThreadState> state_;
+        };
+
+        thread_local ThreadState *current_thread = nullptr;
+        thread_local bool thread_exited = false;
+
+        ThreadHandle::~ThreadHandle()
+        {
+            current_thread = nullptr;
+            thread_exited = true;
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.threads.erase(std::find(r.threads.begin(), r.threads.end(), state_.get()));
+            accumulate(r.retired, *state_);
+            std::lock_guard<std::mutex> trace_lock(state_->trace_mutex);
+            for (const TraceEvent &event : state_->events)
+            {
+                r.retired_events.push_back({state_->id, event});
+            }
+            r.retired_dropped_events += state_->dropped_events;
+        }
+
+        /**
+         * @return null once the thread's thread-locals are being destroyed
+         */
+        ThreadState *threadState()
+        {
+            if (ThreadState *state = current_thread)
+            {
+                return state;
+            }
+            if (thread_exited)
+            {
+                return nullptr;
+            }
+            thread_local ThreadHandle handle;
+            current_thread = handle.state();
+            return current_thread;
+        }
+
+        void appendMicros(std::string &out, uint64_t nanos)
+        {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%llu.%03llu", static_cast<unsigned long long>(nanos / 1000),
+                          static_cast<unsigned long long>(nanos % 1000));
+            out += buffer;
+        }
+
+        void appendDuration(std::string &out, uint64_t nanos)
+        {
+            char buffer[32];
+            if (nanos >= 1000000)
+            {
+                std::snprintf(buffer, sizeof(buffer), "%.3gms", static_cast<double>(nanos) / 1e6);
+            }
+            else if (nanos >= 1000)
+            {
+                std::snprintf(buffer, sizeof(buffer), "%.3gus", static_cast<double>(nanos) / 1e3);
+            }
+            else
+            {
+                std::snprintf(buffer, sizeof(buffer), "%lluns", static_cast<unsigned long long>(nanos));
+            }
+            out += buffer;
+        }
+    } // namespace
+
+    const char *counterName(Counter counter)
+    {
+        switch (counter)
+        {
+        case Counter::BYTES_READ:
+            return "bytes_read";
+        case Counter::READ_CALLS:
+            return "read_calls";
+        case Counter::PAGES_DECOMPRESSED:
+            return "pages_decompressed";
+        case Counter::BYTES_DECOMPRESSED:
+            return "bytes_decompressed";
+        case Counter::PAGES_DECODED:
+            return "pages_decoded";
+        case Counter::VALUES_DECODED:
+            return "values_decoded";
+        case Counter::PAGES_SKIPPED:
+            return "pages_skipped";
+        case Counter::VALUES_SKIPPED:
+            return "values_skipped";
+        case Counter::BATCHES_SCANNED:
+            return "batches_scanned";
+        case Counter::METADATA_CACHE_HITS:
+            return "metadata_cache_hits";
+        case Counter::METADATA_CACHE_MISSES:
+            return "metadata_cache_misses";
+        case Counter::BLOCK_CACHE_HITS:
+            return "block_cache_hits";
+        case Counter::BLOCK_CACHE_MISSES:
+            return "block_cache_misses";
+        default:
+            return "unknown";
+        }
+    }
+
+    const char *stageName(Stage stage)
+    {
+        switch (stage)
+        {
+        case Stage::READ:
+            return "read";
+        case Stage::DECOMPRESS:
+            return "decompress";
+        case Stage::DECODE:
+            return "decode";
+        case Stage::SCAN_WAIT:
+            return "scan_wait";
+        default:
+            return "unknown";
+        }
+    }
+
+    double Histogram::meanNanos() const
+    {
+        return count == 0 ? 0.0 : static_cast<double>(total_ns) / static_cast<double>(count);
+    }
+
+    uint64_t Histogram::quantileNanos(double quantile) const
+    {
+        if (count == 0)
+        {
+            return 0;
+        }
+        auto target = static_cast<uint64_t>(std::ceil(std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count)));
+        target = std::max<uint64_t>(target, 1);
+        uint64_t seen = 0;
+        for (size_t b = 0; b + 1 < kHistogramBuckets; ++b)
+        {
+            seen += buckets[b];
+            if (seen >= target)
+            {
+                return std::min(b == 0 ? 0 : uint64_t{1} << b, max_ns);
+            }
+        }
+        return max_ns;
+    }
+
+    Snapshot Snapshot::since(const Snapshot &earlier) const
+    {
+        Snapshot delta = *this;
+        for (size_t i = 0; i < kNumCounters; ++i)
+        {
+            delta.counters[i] -= earlier.counters[i];
+        }
+        for (size_t i = 0; i < kNumStages; ++i)
+        {
+            delta.stages[i].count -= earlier.stages[i].count;
+            delta.stages[i].total_ns -= earlier.stages[i].total_ns;
+            for (size_t b = 0; b < kHistogramBuckets; ++b)
+            {
+                delta.stages[i].buckets[b] -= earlier.stages[i].buckets[b];
+            }
+        }
+        return delta;
+    }
+
+    std::string Snapshot::toString() const
+    {
+        std::string out;
+        for (size_t i = 0; i < kNumCounters; ++i)
+        {
+            if (counters[i] != 0)
+            {
+                out += counterName(static_cast<Counter>(i));
+                out += ": ";
+                out += std::to_string(counters[i]);
+                out += '\n';
+            }
+        }
+        for (size_t i = 0; i < kNumStages; ++i)
+        {
+            const Histogram &histogram = stages[i];
+            if (histogram.count == 0)
+            {
+                continue;
+            }
+            out += stageName(static_cast<Stage>(i));
+            out += ": count=";
+            out += std::to_string(histogram.count);
+            out += " total=";
+            appendDuration(out, histogram.total_ns);
+            out += " mean=";
+            appendDuration(out, static_cast<uint64_t>(histogram.meanNanos()));
+            out += " p50=";
+            appendDuration(out, histogram.quantileNanos(0.5));
+            out += " p99=";
+            appendDuration(out, histogram.quantileNanos(0.99));
+            out += " max=";
+            appendDuration(out, histogram.max_ns);
+            out += '\n';
+        }
+        return out;
+    }
+
+    Snapshot snapshot()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        Snapshot result = r.retired;
+        for (const ThreadState *state : r.threads)
+        {
+            accumulate(result, *state);
+        }
+        return result;
+    }
+
+    void setEnabled(bool enabled) noexcept
+    {
+        enabled_flag.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool enabled() noexcept
+    {
+        return enabled_flag.load(std::memory_order_relaxed);
+    }
+
+    void add(Counter counter, uint64_t n) noexcept
+    {
+        if (!enabled())
+        {
+            return;
+        }
+        if (ThreadState *state = threadState())
+        {
+            increment(state->counters[static_cast<size_t>(counter)], n);
+        }
+    }
+
+    void record(Stage stage, uint64_t start_ns, uint64_t duration_ns) noexcept
+    {
+        ThreadState *state = threadState();
+        if (!state)
+        {
+            return;
+        }
+        StageCounters &counters = state->stages[static_cast<size_t>(stage)];
+        increment(counters.count, 1);
+        increment(counters.total_ns, duration_ns);
+        if (duration_ns > counters.max_ns.load(std::memory_order_relaxed))
+        {
+            counters.max_ns.store(duration_ns, std::memory_order_relaxed);
+        }
+        auto bucket = std::min<size_t>(static_cast<size_t>(std::bit_width(duration_ns)), kHistogramBuckets - 1);
+        increment(counters.buckets[bucket], 1);
+
+        if (tracing_flag.load(std::memory_order_relaxed) &&
+            start_ns >= trace_start_ns.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(state->trace_mutex);
+            if (state->events.size() < trace_capacity.load(std::memory_order_relaxed))
+            {
+                state->events.push_back({stage, start_ns, duration_ns});
+            }
+            else
+            {
+                ++state->dropped_events;
+            }
+        }
+    }
+
+    uint64_t nowNanos() noexcept
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+
+    uint64_t nowTicks() noexcept
+    {
+#if defined(__x86_64__)
+        if (tickClock().tsc)
+        {
+            return __rdtsc();
+        }
+#endif
+        return nowNanos();
+    }
+
+    void recordTicks(Stage stage, uint64_t start_ticks, uint64_t end_ticks) noexcept
+    {
+        const TickClock &clock = tickClock();
+        // Events are placed relative to the start of the trace, so the error of the
+        // measured tick rate only builds up over the trace; events that started before
+        // it get a start record() drops
+        uint64_t start_ns = 0;
+        uint64_t trace_ticks = trace_start_ticks.load(std::memory_order_relaxed);
+        if (tracing_flag.load(std::memory_order_relaxed) && start_ticks >= trace_ticks)
+        {
+            start_ns = trace_start_ns.load(std::memory_order_relaxed) + clock.nanos(start_ticks - trace_ticks);
+        }
+        record(stage, start_ns, clock.nanos(end_ticks - start_ticks));
+    }
+
+    void startTrace(size_t max_events_per_thread)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        tracing_flag.store(false, std::memory_order_relaxed);
+        for (ThreadState *state : r.threads)
+        {
+            std::lock_guard<std::mutex> trace_lock(state->trace_mutex);
+            state->events.clear();
+            state->dropped_events = 0;
+        }
+        r.retired_events.clear();
+        r.retired_dropped_events = 0;
+        trace_capacity.store(max_events_per_thread, std::memory_order_relaxed);
+        trace_start_ns.store(nowNanos(), std::memory_order_relaxed);
+        trace_start_ticks.store(nowTicks(), std::memory_order_relaxed);
+        tracing_flag.store(true, std::memory_order_relaxed);
+    }
+
+    void stopTrace()
+    {
+        tracing_flag.store(false, std::memory_order_relaxed);
+    }
+
+    bool tracing() noexcept
+    {
+        return tracing_flag.load(std::memory_order_relaxed);
+    }
+
+    void writeTrace(std::ostream &out)
+    {
+        uint64_t end_ns = nowNanos();
+        std::vector<ThreadEvent> events;
+        std::vector<size_t> threads;
+        uint64_t dropped_events;
+        {
+            Registry &r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            events = r.retired_events;
+            dropped_events = r.retired_dropped_events;
+            for (ThreadState *state : r.threads)
+            {
+                std::lock_guard<std::mutex> trace_lock(state->trace_mutex);
+                for (const TraceEvent &event : state->events)
+                {
+                    events.push_back({state->id, event});
+                }
+                dropped_events += state->dropped_events;
+            }
+        }
+        for (const ThreadEvent &event : events)
+        {
+            threads.push_back(event.thread);
+        }
+        std::sort(threads.begin(), threads.end());
+        threads.erase(std::unique(threads.begin(), threads.end()), threads.end());
+
+        uint64_t start_ns = trace_start_ns.load(std::memory_order_relaxed);
+        std::string pid = std::to_string(::getpid());
+        std::string json = "{\"traceEvents\":[";
+        bool first = true;
+        auto separate = [&json, &first]()
+        {
+            if (!first)
+            {
+                json += ",\n";
+            }
+            first = false;
+        };
+        for (size_t thread : threads)
+        {
+            separate();
+            json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":";
+            json += pid;
+            json += ",\"tid\":";
+            json += std::to_string(thread);
+            json += ",\"args\":{\"name\":\"thread ";
+            json += std::to_string(thread);
+            json += "\"}}";
+        }
+        for (const ThreadEvent &event : events)
+        {
+            separate();
+            json += "{\"name\":\"";
+            json += stageName(event.event.stage);
+            json += "\",\"cat\":\"formats\",\"ph\":\"X\",\"ts\":";
+            appendMicros(json, event.event.start_ns - start_ns);
+            json += ",\"dur\":";
+            appendMicros(json, event.event.duration_ns);
+            json += ",\"pid\":";
+            json += pid;
+            json += ",\"tid\":";
+            json += std::to_string(event.thread);
+            json += '}';
+        }
+        Snapshot counters = snapshot();
+        for (size_t i = 0; i < kNumCounters; ++i)
+        {
+            separate();
+            json += "{\"name\":\"";
+            json += counterName(static_cast<Counter>(i));
+            json += "\",\"cat\":\"formats\",\"ph\":\"C\",\"ts\":";
+            appendMicros(json, end_ns - start_ns);
+            json += ",\"pid\":";
+            json += pid;
+            json += ",\"args\":{\"value\":";
+            json += std::to_string(counters.counters[i]);
+            json += "}}";
+        }
+        json += "],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":\"";
+        json += std::to_string(dropped_events);
+        json += "\"}}\n";
+        out << json;
+    }
+} // namespace instrumentation
@@ -0,0 +1,204 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Counters and stage timings of the read path, kept per thread so recording stays off any
+ * shared cache line, summed on demand by snapshot(). Optionally records every timed stage
+ * as an event and dumps them in the Chrome trace event format (chrome://tracing,
+ * ui.perfetto.dev).
+ *
+ * The probes in the library are the FORMATS_COUNT and FORMATS_TIME macros, which expand to
+ * nothing unless FORMATS_INSTRUMENTATION is defined (`bazel build --define
+ * instrumentation=1`). Compiled in, recording is on by default and costs a relaxed load
+ * of the enabled flag per probe while switched off with setEnabled(false). The probes sit
+ * at chunk, page and batch granularity, never per value.
+ */
+namespace instrumentation
+{
+#ifdef FORMATS_INSTRUMENTATION
+    inline constexpr bool kCompiledIn = true;
+#else
+    inline constexpr bool kCompiledIn = false;
+#endif
+
+    enum class Counter
+    {
+        /// Bytes read from storage (local files, io_uring, S3), cache hits excluded
+        BYTES_READ,
+        READ_CALLS,
+        PAGES_DECOMPRESSED,
+        /// Uncompressed size of the decompressed pages
+        BYTES_DECOMPRESSED,
+        PAGES_DECODED,
+        VALUES_DECODED,
+        /// Data pages passed over without decoding, by a skip or because selectPages() left
+        /// them out
+        PAGES_SKIPPED,
+        /// Slots skipped without being materialized
+        VALUES_SKIPPED,
+        BATCHES_SCANNED,
+        METADATA_CACHE_HITS,
+        METADATA_CACHE_MISSES,
+        BLOCK_CACHE_HITS,
+        BLOCK_CACHE_MISSES,
+        COUNT
+    };
+
+    enum class Stage
+    {
+        /// A synchronous read from storage
+        READ,
+        /// Splitting a column chunk into pages, decryption and decompression
+        DECOMPRESS,
+        /// One readBatch() call, page setup included
+        DECODE,
+        /// A ParquetScanner::next() call, i.e. the consumer waiting for a batch
+        SCAN_WAIT,
+        COUNT
+    };
+
+    inline constexpr size_t kNumCounters = static_cast<size_t>(Counter::COUNT);
+    inline constexpr size_t kNumStages = static_cast<size_t>(Stage::COUNT);
+    inline constexpr size_t kHistogramBuckets = 64;
+
+    const char *counterName(Counter counter);
+    const char *stageName(Stage stage);
+
+    /**
+     * @brief Durations of a stage in power of two buckets: bucket 0 holds zero durations,
+     * bucket i durations in [2^(i-1), 2^i) nanoseconds, the last one everything longer.
+     */
+    struct Histogram
+    {
+        uint64_t count = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+        std::array<uint64_t, kHistogramBuckets> buckets{};
+
+        double meanNanos() const;
+
+        /**
+         * @brief Upper bound of the bucket holding the given quantile, capped at max_ns.
+         * @param quantile In [0, 1]
+         */
+        uint64_t quantileNanos(double quantile) const;
+    };
+
+    struct Snapshot
+    {
+        std::array<uint64_t, kNumCounters> counters{};
+        std::array<Histogram, kNumStages> stages{};
+
+        uint64_t counter(Counter counter) const { return counters[static_cast<size_t>(counter)]; }
+        const Histogram &stage(Stage stage) const { return stages[static_cast<size_t>(stage)]; }
+
+        /**
+         * @brief What was recorded since an earlier snapshot. Maxima cannot be subtracted
+         * and keep the later value.
+         */
+        Snapshot since(const Snapshot &earlier) const;
+
+        /**
+         * @brief One line per non-zero counter and stage, for logs and tools.
+         */
+        std::string toString() const;
+    };
+
+    /**
+     * @brief Sums the counters of all threads, including threads that have exited.
+     * Counters only grow; diff two snapshots with Snapshot::since() to measure a section.
+     */
+    Snapshot snapshot();
+
+    /**
+     * @brief Switches recording on and off at runtime; on by default.
+     */
+    void setEnabled(bool enabled) noexcept;
+    bool enabled() noexcept;
+
+    void add(Counter counter, uint64_t n = 1) noexcept;
+
+    /**
+     * @brief Records a duration in the stage's histogram and, while tracing, as an event.
+     */
+    void record(Stage stage, uint64_t start_ns, uint64_t duration_ns) noexcept;
+
+    /**
+     * @brief Monotonic clock in nanoseconds, the time base of record().
+     */
+    uint64_t nowNanos() noexcept;
+
+    /**
+     * @brief The clock of StageTimer: the time stamp counter where it runs at a constant
+     * rate, which takes a fraction of the time of nowNanos(), and nowNanos() otherwise.
+     * Only the difference of two ticks means anything.
+     */
+    uint64_t nowTicks() noexcept;
+
+    /**
+     * @brief record() for a stage that ran from `start_ticks` to `end_ticks` of nowTicks().
+     */
+    void recordTicks(Stage stage, uint64_t start_ticks, uint64_t end_ticks) noexcept;
+
+    /**
+     * @brief Starts collecting trace events, dropping the events of an earlier trace.
+     * Threads keep at most `max_events_per_thread` events; later ones are dropped and
+     * counted.
+     */
+    void startTrace(size_t max_events_per_thread = size_t{1} << 20);
+    void stopTrace();
+    bool tracing() noexcept;
+
+    /**
+     * @brief Writes the collected events as a Chrome trace event JSON object: one complete
+     * ("X") event per timed stage, named threads, and the counters of snapshot() as counter
+     * ("C") events at the end of the trace.
+     */
+    void writeTrace(std::ostream &out);
+
+    /**
+     * @brief Times a scope as a stage. Does nothing if recording was off when it started.
+     */
+    class StageTimer
+    {
+    public:
+        explicit StageTimer(Stage stage) noexcept : stage_(stage), start_(enabled() ? nowTicks() : kNotStarted) {}
+
+        ~StageTimer()
+        {
+            if (start_ != kNotStarted)
+            {
+                recordTicks(stage_, start_, nowTicks());
+            }
+        }
+
+        StageTimer(const StageTimer &) = delete;
+        StageTimer &operator=(const StageTimer &) = delete;
+
+    private:
+        static constexpr uint64_t kNotStarted = UINT64_MAX;
+
+        Stage stage_;
+        uint64_t start_;
+    };
+} // namespace instrumentation
+
+#define FORMATS_INSTRUMENTATION_CONCAT_(a, b) a##b
+#define FORMATS_INSTRUMENTATION_CONCAT(a, b) FORMATS_INSTRUMENTATION_CONCAT_(a, b)
+
+#ifdef FORMATS_INSTRUMENTATION
+/// Adds `n` to a Counter; `n` is not evaluated when instrumentation is compiled out
+#define FORMATS_COUNT(counter, n) ::instrumentation::add(::instrumentation::Counter::counter, (n))
+/// Times the rest of the enclosing scope as a Stage
+#define FORMATS_TIME(stage)                                                                     \
+    ::instrumentation::StageTimer FORMATS_INSTRUMENTATION_CONCAT(formats_stage_timer_, __LINE__)( \
+        ::instrumentation::Stage::stage)
+#else
+#define FORMATS_COUNT(counter, n) static_cast<void>(0)
+#define FORMATS_TIME(stage) static_cast<void>(0)
+#endif
@@ -0,0 +1,207 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "basics/benchmark_data.h"
+#include "instrumentation.hpp"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+// The cost of the read path probes. Reads every column of a Snappy compressed file of 1M
+// rows (ascending INT64 ids and a BYTE_ARRAY name drawn from 1000 strings) through
+// ColumnChunkReader in batches of 256 and 4096 values, the smaller batches firing the
+// decode probes 16 times as often.
+//
+// BM_ReadFile runs with recording off, on, and on while tracing. BM_Overhead runs a scan
+// with recording off and one with it on in every iteration, so both see the same machine
+// state, over enough iterations for a stable median, and reports the median slowdown as
+// overhead_pct next to the budget of 2% (budget_pct). probe_ns is the measured cost of
+// the probes of one readBatch() call on their own.
+//
+// Build with --define instrumentation=1, as run_instrumentation_benchmark.sh does; without
+// it the probes are compiled out and the label says so. Comparing the two builds through
+// compare_benchmarks.py gives the cost of probes switched off at runtime.
+
+namespace
+{
+    constexpr size_t kRows = 1000000;
+    constexpr double kOverheadBudgetPct = 2;
+
+    class BenchmarkFile
+    {
+    public:
+        BenchmarkFile() : path_("/tmp/instrumentation_benchmark_" + std::to_string(::getpid()) + ".parquet")
+        {
+            std::vector<ColumnDescriptor> columns(2);
+            columns[0].path = {"id"};
+            columns[0].type = AtomicType::INT64;
+            columns[1].path = {"name"};
+            columns[1].type = AtomicType::BYTE_ARRAY;
+            WriterOptions options;
+            options.codec = CompressionCodec::SNAPPY;
+            ParquetFileWriter writer(path_, columns, options);
+            std::vector<int64_t> ids = ascendingIntegers(kRows, 10, 1);
+            std::vector<std::string> names = randomStrings(kRows, 1000, 8, 24, 2);
+            constexpr size_t kRowGroupRows = 128 * 1024;
+            for (size_t first = 0; first < kRows; first += kRowGroupRows)
+            {
+                size_t count = std::min(kRowGroupRows, kRows - first);
+                ColumnBatch id_batch(AtomicType::INT64);
+                ColumnBatch name_batch(AtomicType::BYTE_ARRAY);
+                std::copy_n(ids.begin() + first, count, id_batch.appendValues<int64_t>(count));
+                for (size_t i = first; i < first + count; ++i)
+                {
+                    name_batch.appendByteArray(reinterpret_cast<const uint8_t *>(names[i].data()), names[i].size());
+                }
+                writer.writeRowGroup({&id_batch, &name_batch});
+            }
+            writer.close();
+        }
+
+        ~BenchmarkFile() { std::remove(path_.c_str()); }
+
+        const std::string &path() const { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+    const std::string &benchmarkPath()
+    {
+        static BenchmarkFile file;
+        return file.path();
+    }
+
+    void readFile(const ParquetFileReader &reader, size_t batch_size)
+    {
+        for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+        {
+            for (size_t column = 0; column < reader.columns().size(); ++column)
+            {
+                ColumnChunkReader chunk = reader.columnChunk(rg, column);
+                ColumnBatch batch(reader.columns()[column].type);
+                while (chunk.hasNext())
+                {
+                    batch.clear();
+                    chunk.readBatch(batch, batch_size);
+                    benchmark::DoNotOptimize(batch.data());
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief One timed stage and one counter update, the probes of a readBatch() call.
+     */
+    void probe()
+    {
+        FORMATS_TIME(DECODE);
+        FORMATS_COUNT(VALUES_DECODED, 1);
+    }
+
+    uint64_t stageCount(const instrumentation::Snapshot &snapshot)
+    {
+        uint64_t count = 0;
+        for (const instrumentation::Histogram &stage : snapshot.stages)
+        {
+            count += stage.count;
+        }
+        return count;
+    }
+
+    void setLabel(benchmark::State &state)
+    {
+        if (!instrumentation::kCompiledIn)
+        {
+            state.SetLabel("compiled out");
+        }
+    }
+
+    enum Mode
+    {
+        kOff,
+        kOn,
+        kTracing
+    };
+} // namespace
+
+static void BM_ReadFile(benchmark::State &state)
+{
+    ParquetFileReader reader(benchmarkPath());
+    auto batch_size = static_cast<size_t>(state.range(1));
+    instrumentation::setEnabled(state.range(0) != kOff);
+    if (state.range(0) == kTracing)
+    {
+        instrumentation::startTrace();
+    }
+    instrumentation::Snapshot before = instrumentation::snapshot();
+    for (auto _ : state)
+    {
+        readFile(reader, batch_size);
+        if (state.range(0) == kTracing)
+        {
+            // Keeps the trace buffers from filling up and dropping events
+            state.PauseTiming();
+            instrumentation::startTrace();
+            state.ResumeTiming();
+        }
+    }
+    instrumentation::Snapshot delta = instrumentation::snapshot().since(before);
+    instrumentation::stopTrace();
+    instrumentation::setEnabled(true);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kRows * reader.columns().size()));
+    state.counters["probes_per_iteration"] =
+        static_cast<double>(stageCount(delta)) / static_cast<double>(state.iterations());
+    setLabel(state);
+}
+
+static void BM_Overhead(benchmark::State &state)
+{
+    ParquetFileReader reader(benchmarkPath());
+    auto batch_size = static_cast<size_t>(state.range(0));
+    std::vector<double> ratios;
+    bool first_enabled = false;
+    for (auto _ : state)
+    {
+        // Alternates which scan goes first, the second one tends to run a little slower
+        uint64_t elapsed_ns[2];
+        for (bool enabled : {first_enabled, !first_enabled})
+        {
+            instrumentation::setEnabled(enabled);
+            uint64_t start = instrumentation::nowNanos();
+            readFile(reader, batch_size);
+            elapsed_ns[enabled] = instrumentation::nowNanos() - start;
+        }
+        first_enabled = !first_enabled;
+        ratios.push_back(static_cast<double>(elapsed_ns[1]) / static_cast<double>(elapsed_ns[0]));
+    }
+    instrumentation::setEnabled(true);
+
+    constexpr int kProbes = 1000000;
+    uint64_t start = instrumentation::nowNanos();
+    for (int i = 0; i < kProbes; ++i)
+    {
+        probe();
+    }
+    double probe_ns = static_cast<double>(instrumentation::nowNanos() - start) / kProbes;
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * 2 * kRows * reader.columns().size()));
+    // The median of the per-iteration ratios, robust against the odd descheduled scan
+    std::nth_element(ratios.begin(), ratios.begin() + ratios.size() / 2, ratios.end());
+    state.counters["overhead_pct"] = 100.0 * (ratios[ratios.size() / 2] - 1.0);
+    state.counters["budget_pct"] = kOverheadBudgetPct;
+    state.counters["probe_ns"] = probe_ns;
+    setLabel(state);
+}
+
+BENCHMARK(BM_ReadFile)
+    ->ArgNames({"mode", "batch"})
+    ->ArgsProduct({{kOff, kOn, kTracing}, {256, 4096}})
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Overhead)->ArgNames({"batch"})->Arg(256)->Arg(4096)->MinTime(5)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,198 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "instrumentation.hpp"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+using namespace instrumentation;
+
+namespace
+{
+    size_t occurrences(const std::string &text, const std::string &pattern)
+    {
+        size_t count = 0;
+        for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        {
+            ++count;
+        }
+        return count;
+    }
+} // namespace
+
+TEST(InstrumentationTest, SumsCountersOfAllThreads)
+{
+    Snapshot before = snapshot();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([]()
+                             {
+                                 for (int i = 0; i < 1000; ++i)
+                                 {
+                                     add(Counter::PAGES_DECODED);
+                                     add(Counter::BYTES_READ, 3);
+                                 }
+                                 record(Stage::DECODE, nowNanos(), 1500); });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    add(Counter::PAGES_DECODED, 5);
+
+    // The threads have exited, their counts stay
+    Snapshot delta = snapshot().since(before);
+    EXPECT_EQ(delta.counter(Counter::PAGES_DECODED), 4005u);
+    EXPECT_EQ(delta.counter(Counter::BYTES_READ), 12000u);
+    EXPECT_EQ(delta.stage(Stage::DECODE).count, 4u);
+    EXPECT_EQ(delta.stage(Stage::DECODE).total_ns, 6000u);
+    EXPECT_EQ(delta.stage(Stage::DECODE).buckets[11], 4u);
+    EXPECT_EQ(delta.counter(Counter::METADATA_CACHE_HITS), 0u);
+    EXPECT_NE(delta.toString().find("pages_decoded: 4005"), std::string::npos);
+
+    setEnabled(false);
+    add(Counter::PAGES_DECODED, 7);
+    {
+        StageTimer timer(Stage::READ);
+    }
+    setEnabled(true);
+    Snapshot disabled = snapshot().since(before);
+    EXPECT_EQ(disabled.counter(Counter::PAGES_DECODED), 4005u);
+    EXPECT_EQ(disabled.stage(Stage::READ).count, 0u);
+}
+
+TEST(InstrumentationTest, HistogramQuantiles)
+{
+    Histogram histogram;
+    EXPECT_EQ(histogram.quantileNanos(0.5), 0u);
+    EXPECT_EQ(histogram.meanNanos(), 0.0);
+
+    // 90 durations in [512, 1024), 10 in [65536, 131072)
+    histogram.count = 100;
+    histogram.buckets[10] = 90;
+    histogram.buckets[17] = 10;
+    histogram.total_ns = 90 * 600 + 10 * 70000;
+    histogram.max_ns = 70000;
+    EXPECT_EQ(histogram.quantileNanos(0.0), 1024u);
+    EXPECT_EQ(histogram.quantileNanos(0.5), 1024u);
+    EXPECT_EQ(histogram.quantileNanos(0.9), 1024u);
+    EXPECT_EQ(histogram.quantileNanos(0.95), 70000u);
+    EXPECT_EQ(histogram.quantileNanos(1.0), 70000u);
+    EXPECT_DOUBLE_EQ(histogram.meanNanos(), 7540.0);
+}
+
+TEST(InstrumentationTest, WritesChromeTraceEvents)
+{
+    startTrace(3);
+    EXPECT_TRUE(tracing());
+    uint64_t start = nowNanos();
+    for (int i = 0; i < 5; ++i)
+    {
+        record(Stage::DECOMPRESS, start + 1000 * static_cast<uint64_t>(i), 2500);
+    }
+    std::thread([start]()
+                { record(Stage::READ, start, 10); })
+        .join();
+    stopTrace();
+    record(Stage::DECODE, nowNanos(), 10);
+
+    std::ostringstream out;
+    writeTrace(out);
+    std::string json = out.str();
+    EXPECT_EQ(json.rfind("{\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(occurrences(json, "\"name\":\"decompress\""), 3u);
+    EXPECT_EQ(occurrences(json, "\"name\":\"read\""), 1u);
+    EXPECT_EQ(occurrences(json, "\"name\":\"decode\""), 0u);
+    EXPECT_EQ(occurrences(json, "\"ph\":\"X\""), 4u);
+    EXPECT_EQ(occurrences(json, "\"name\":\"thread_name\""), 2u);
+    EXPECT_EQ(occurrences(json, "\"dur\":2.500,"), 3u);
+    EXPECT_EQ(occurrences(json, "\"ph\":\"C\""), kNumCounters);
+    EXPECT_NE(json.find("\"dropped_events\":\"2\""), std::string::npos);
+
+    // A new trace starts empty
+    startTrace();
+    stopTrace();
+    std::ostringstream empty;
+    writeTrace(empty);
+    EXPECT_EQ(occurrences(empty.str(), "\"ph\":\"X\""), 0u);
+}
+
+TEST(InstrumentationTest, StageTimersMeasureNanoseconds)
+{
+    Snapshot before = snapshot();
+    startTrace();
+    uint64_t start = nowNanos();
+    {
+        StageTimer timer(Stage::READ);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    uint64_t elapsed = nowNanos() - start;
+    stopTrace();
+    std::ostringstream traced;
+    writeTrace(traced);
+    EXPECT_EQ(occurrences(traced.str(), "\"ph\":\"X\""), 1u);
+    // Ticks of a stage started before the trace are not traced
+    uint64_t early = nowTicks();
+    startTrace();
+    recordTicks(Stage::READ, early, nowTicks());
+    stopTrace();
+
+    Histogram read = snapshot().since(before).stage(Stage::READ);
+    EXPECT_EQ(read.count, 2u);
+    EXPECT_GE(read.max_ns, 19000000u);
+    EXPECT_LE(read.max_ns, elapsed + elapsed / 100);
+    std::ostringstream out;
+    writeTrace(out);
+    EXPECT_EQ(occurrences(out.str(), "\"ph\":\"X\""), 0u);
+}
+
+TEST(InstrumentationTest, CountsReaderStages)
+{
+    std::string path = testing::TempDir() + "/instrumentation.parquet";
+    std::vector<ColumnDescriptor> columns(1);
+    columns[0].path = {"id"};
+    columns[0].type = AtomicType::INT64;
+    WriterOptions options;
+    options.codec = CompressionCodec::SNAPPY;
+    ColumnBatch ids(AtomicType::INT64);
+    for (int64_t i = 0; i < 10000; ++i)
+    {
+        *ids.appendValues<int64_t>(1) = i;
+    }
+    ParquetFileWriter writer(path, columns, options);
+    writer.writeRowGroup({&ids});
+    writer.close();
+
+    Snapshot before = snapshot();
+    ParquetFileReader reader(path);
+    ColumnChunkReader chunk = reader.columnChunk(0, 0);
+    ColumnBatch batch(AtomicType::INT64);
+    while (chunk.hasNext())
+    {
+        chunk.readBatch(batch, 1000);
+    }
+    ASSERT_EQ(batch.length(), 10000u);
+    Snapshot delta = snapshot().since(before);
+
+    if (!kCompiledIn)
+    {
+        EXPECT_EQ(delta.counter(Counter::BYTES_READ), 0u);
+        EXPECT_EQ(delta.stage(Stage::DECODE).count, 0u);
+        return;
+    }
+    EXPECT_GE(delta.counter(Counter::BYTES_READ), reader.columnChunkRange(0, 0).length);
+    EXPECT_GE(delta.counter(Counter::READ_CALLS), 2u);
+    EXPECT_GE(delta.stage(Stage::READ).count, 2u);
+    EXPECT_GE(delta.counter(Counter::PAGES_DECOMPRESSED), 1u);
+    EXPECT_GE(delta.counter(Counter::BYTES_DECOMPRESSED), 80000u);
+    EXPECT_EQ(delta.stage(Stage::DECOMPRESS).count, 1u);
+    EXPECT_GE(delta.counter(Counter::PAGES_DECODED), 1u);
+    EXPECT_EQ(delta.counter(Counter::VALUES_DECODED), 10000u);
+    EXPECT_EQ(delta.stage(Stage::DECODE).count, 10u);
+}
@@ -0,0 +1,172 @@
+#include "io.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <numeric>
+#include <stdexcept>
+#include <system_error>
+
+#include "instrumentation.hpp"
+#include "parquet.hpp"
+
+Slice Slice::fromVector(std::vector<uint8_t> bytes)
+{
+    auto owner = std::make_shared<std::vector<uint8_t>>(std::move(bytes));
+    Slice slice;
+    slice.data = owner->data();
+    slice.size = owner->size();
+    slice.owner = std::move(owner);
+    return slice;
+}
+
+Slice Slice::sub(size_t offset, size_t length) const
+{
+    if (offset > size || length > size - offset)
+    {
+        throw std::out_of_range("Sub-slice out of bounds");
+    }
+    Slice slice;
+    slice.owner = owner;
+    slice.data = data + offset;
+    slice.size = length;
+    return slice;
+}
+
+std::future<Slice> RandomAccessFile::readAsync(ReadRange range) const
+{
+    return std::async(std::launch::deferred, [this, range]()
+                      {
+                          std::vector<uint8_t> bytes(range.length);
+                          readAt(range.offset, range.length, bytes.data());
+                          return Slice::fromVector(std::move(bytes)); });
+}
+
+LocalFile::LocalFile(const std::string &path) : RandomAccessFile(path)
+{
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0)
+    {
+        int error = errno;
+        ::close(fd_);
+        throw std::system_error(error, std::generic_category(), "Cannot stat " + path);
+    }
+    size_ = static_cast<uint64_t>(st.st_size);
+    version_ = std::to_string(static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec);
+}
+
+LocalFile::~LocalFile()
+{
+    ::close(fd_);
+}
+
+void LocalFile::readAt(uint64_t offset, size_t size, uint8_t *out) const
+{
+    FORMATS_TIME(READ);
+    FORMATS_COUNT(BYTES_READ, size);
+    FORMATS_COUNT(READ_CALLS, 1);
+    while (size > 0)
+    {
+        ssize_t n = ::pread(fd_, out, size, static_cast<off_t>(offset));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Cannot read " + path());
+        }
+        if (n == 0)
+        {
+            throw ParquetException("Unexpected end of " + path());
+        }
+        out += n;
+        offset += static_cast<uint64_t>(n);
+        size -= static_cast<size_t>(n);
+    }
+}
+
+std::vector<CoalescedRead> coalesceRanges(const std::vector<ReadRange> &ranges, const CoalesceOptions &options)
+{
+    std::vector<size_t> order(ranges.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::sort(order.begin(), order.end(), [&ranges](size_t a, size_t b)
+              { return ranges[a].offset < ranges[b].offset; });
+
+    std::vector<CoalescedRead> reads;
+    for (size_t index : order)
+    {
+        const ReadRange &range = ranges[index];
+        if (!reads.empty())
+        {
+            ReadRange &current = reads.back().range;
+            uint64_t end = std::max(current.end(), range.end());
+            if (range.offset <= current.end() + options.hole_size_limit &&
+                end - current.offset <= options.range_size_limit)
+            {
+                current.length = static_cast<size_t>(end - current.offset);
+                reads.back().members.push_back(index);
+                continue;
+            }
+        }
+        reads.push_back({range, {index}});
+    }
+    return reads;
+}
+
+RangePrefetcher::RangePrefetcher(std::shared_ptr<const RandomAccessFile> file, const std::vector<ReadRange> &ranges,
+                                 CoalesceOptions options)
+    : file_(std::move(file)), ranges_(ranges), read_of_range_(ranges.size())
+{
+    for (CoalescedRead &read : coalesceRanges(ranges_, options))
+    {
+        for (size_t member : read.members)
+        {
+            read_of_range_[member] = reads_.size();
+        }
+        reads_.push_back({read.range, {}, read.members.size()});
+    }
+}
+
+std::shared_future<Slice> RangePrefetcher::start(size_t index)
+{
+    Read &read = reads_[read_of_range_.at(index)];
+    if (!read.bytes.valid())
+    {
+        read.bytes = file_->readAsync(read.range).share();
+    }
+    return read.bytes;
+}
+
+void RangePrefetcher::prefetch(size_t index)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    start(index);
+}
+
+Slice RangePrefetcher::get(size_t index)
+{
+    std::shared_future<Slice> bytes;
+    uint64_t read_offset;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        bytes = start(index);
+        Read &read = reads_[read_of_range_[index]];
+        read_offset = read.range.offset;
+        if (--read.unfetched == 0)
+        {
+            // The remaining references are the slices handed out
+            read.bytes = {};
+        }
+    }
+    const ReadRange &range = ranges_[index];
+    return bytes.get().sub(static_cast<size_t>(range.offset - read_offset), range.length);
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// I/O layer under the Parquet reader: random access files, coalescing of nearby byte
+// ranges into larger reads, and reading them ahead of the decoder.
+
+struct ReadRange
+{
+    uint64_t offset = 0;
+    size_t length = 0;
+
+    uint64_t end() const noexcept { return offset + length; }
+};
+
+/**
+ * @brief Read-only bytes together with whatever keeps them alive (a vector, a pooled I/O
+ * buffer, ...). Copies share the storage, sub-slices keep the whole storage alive.
+ */
+struct Slice
+{
+    std::shared_ptr<const void> owner;
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+
+    static Slice fromVector(std::vector<uint8_t> bytes);
+
+    /**
+     * @throws std::out_of_range if the sub-slice does not fit
+     */
+    Slice sub(size_t offset, size_t length) const;
+};
+
+/**
+ * @brief A file that supports positional reads from any number of threads.
+ */
+class RandomAccessFile
+{
+public:
+    explicit RandomAccessFile(std::string path) : path_(std::move(path)) {}
+    virtual ~RandomAccessFile() = default;
+
+    RandomAccessFile(const RandomAccessFile &) = delete;
+    RandomAccessFile &operator=(const RandomAccessFile &) = delete;
+
+    const std::string &path() const noexcept { return path_; }
+
+    virtual uint64_t size() const = 0;
+
+    /**
+     * @brief Identifies the contents of the file at the time it was opened (modification
+     * time, ETag, ...), so caches can tell a rewritten file from the one they hold. Empty
+     * when the backend has no such notion.
+     */
+    virtual std::string version() const { return {}; }
+
+    /**
+     * @brief Reads exactly `size` bytes at `offset`.
+     * @throws std::system_error on I/O errors, ParquetException past the end of the file
+     */
+    virtual void readAt(uint64_t offset, size_t size, uint8_t *out) const = 0;
+
+    /**
+     * @brief Starts reading `range` and returns a future of its bytes.
+     *
+     * The default is a deferred readAt(), i.e. the read runs on the thread that first waits
+     * for the result. Asynchronous backends submit the read right away.
+     */
+    virtual std::future<Slice> readAsync(ReadRange range) const;
+
+private:
+    std::string path_;
+};
+
+/**
+ * @brief A local file read with pread().
+ */
+class LocalFile : public RandomAccessFile
+{
+public:
+    /**
+     * @throws std::system_error if the file cannot be opened
+     */
+    explicit LocalFile(const std::string &path);
+    ~LocalFile() override;
+
+    uint64_t size() const override { return size_; }
+
+    /**
+     * @brief The modification time in nanoseconds.
+     */
+    std::string version() const override { return version_; }
+
+    void readAt(uint64_t offset, size_t size, uint8_t *out) const override;
+
+    int fd() const noexcept { return fd_; }
+
+private:
+    int fd_ = -1;
+    uint64_t size_ = 0;
+    std::string version_;
+};
+
+struct CoalesceOptions
+{
+    /// Ranges separated by at most this many bytes are read together; reading the hole is
+    /// cheaper than another request
+    size_t hole_size_limit = 8 * 1024;
+
+    /// Coalesced reads stop growing at this size, so a scan still gets parallel reads
+    size_t range_size_limit = 32 * 1024 * 1024;
+};
+
+struct CoalescedRead
+{
+    ReadRange range;
+
+    /// Indices of the input ranges the read covers
+    std::vector<size_t> members;
+};
+
+/**
+ * @brief Merges ranges whose gap is at most `hole_size_limit` into reads of at most
+ * `range_size_limit` bytes (a single larger range is read as is). The reads are sorted by
+ * offset; overlapping input ranges are fine.
+ */
+std::vector<CoalescedRead> coalesceRanges(const std::vector<ReadRange> &ranges, const CoalesceOptions &options);
+
+/**
+ * @brief Reads a known list of ranges (e.g. the column chunks of a scan) with coalesced
+ * reads that can be started ahead of time.
+ *
+ * prefetch() starts the read covering a range without waiting for it; get() waits for it
+ * (starting it if needed) and returns the bytes of the range. Each range can be fetched
+ * once. A coalesced read happens once and its buffer is released when all of its ranges
+ * were fetched and their slices are gone.
+ */
+class RangePrefetcher
+{
+public:
+    RangePrefetcher(std::shared_ptr<const RandomAccessFile> file, const std::vector<ReadRange> &ranges,
+                    CoalesceOptions options = {});
+
+    void prefetch(size_t index);
+    Slice get(size_t index);
+
+    size_t numReads() const noexcept { return reads_.size(); }
+
+private:
+    struct Read
+    {
+        ReadRange range;
+        std::shared_future<Slice> bytes;
+        size_t unfetched;
+    };
+
+    std::shared_future<Slice> start(size_t index);
+
+    std::shared_ptr<const RandomAccessFile> file_;
+    std::vector<ReadRange> ranges_;
+    std::vector<size_t> read_of_range_;
+
+    std::mutex mutex_;
+    std::vector<Read> reads_;
+};
@@ -0,0 +1,211 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+#include "io_uring_file.hpp"
+#include "parquet_writer.hpp"
+#include "scanner.hpp"
+
+// Cold-cache reads of a Parquet file through LocalFile (pread) and IoUringFile, with
+// different coalescing hole sizes. The file (~200MB, 8 row groups of 16 columns) is
+// written once per process to $IO_BENCHMARK_DIR (default /tmp, point it at the disk to
+// measure), and the page cache of the file is dropped with posix_fadvise before every
+// iteration, so each iteration really reads from the device.
+
+namespace
+{
+    constexpr size_t kRowGroups = 8;
+    constexpr size_t kRowsPerGroup = 512 * 1024;
+    constexpr size_t kColumns = 16;
+
+    class BenchmarkFile
+    {
+    public:
+        BenchmarkFile()
+        {
+            const char *dir = std::getenv("IO_BENCHMARK_DIR");
+            path_ = std::string(dir ? dir : "/tmp") + "/io_benchmark_" + std::to_string(::getpid()) + ".parquet";
+            std::vector<ColumnDescriptor> columns(kColumns);
+            for (size_t c = 0; c < kColumns; ++c)
+            {
+                columns[c].path = {std::string("c") + std::to_string(c)};
+                columns[c].type = c % 2 == 0 ? AtomicType::INT64 : AtomicType::DOUBLE;
+            }
+            WriterOptions options;
+            options.codec = CompressionCodec::SNAPPY;
+            ParquetFileWriter writer(path_, columns, options);
+
+            std::mt19937_64 rng(42);
+            for (size_t g = 0; g < kRowGroups; ++g)
+            {
+                std::vector<ColumnBatch> batches;
+                std::vector<const ColumnBatch *> pointers;
+                for (const auto &column : columns)
+                {
+                    ColumnBatch batch(column.type);
+                    // Random values, so Snappy cannot shrink the chunks much
+                    for (size_t i = 0; i < kRowsPerGroup; ++i)
+                    {
+                        if (column.type == AtomicType::INT64)
+                        {
+                            *batch.appendValues<int64_t>(1) = static_cast<int64_t>(rng());
+                        }
+                        else
+                        {
+                            *batch.appendValues<double>(1) = static_cast<double>(rng()) / 3;
+                        }
+                    }
+                    batches.push_back(std::move(batch));
+                }
+                for (const auto &batch : batches)
+                {
+                    pointers.push_back(&batch);
+                }
+                writer.writeRowGroup(pointers);
+            }
+            writer.close();
+        }
+
+        ~BenchmarkFile() { std::remove(path_.c_str()); }
+
+        const std::string &path() const noexcept { return path_; }
+
+        void dropPageCache() const
+        {
+            int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0)
+            {
+                ::fdatasync(fd);
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                ::close(fd);
+            }
+        }
+
+    private:
+        std::string path_;
+    };
+
+    const BenchmarkFile &benchmarkFile()
+    {
+        static BenchmarkFile file;
+        return file;
+    }
+
+    std::shared_ptr<const RandomAccessFile> openFile(int backend)
+    {
+        const std::string &path = benchmarkFile().path();
+        if (backend == 1)
+        {
+            return std::make_shared<IoUringFile>(path);
+        }
+        return std::make_shared<LocalFile>(path);
+    }
+
+    bool skipUnsupported(benchmark::State &state)
+    {
+        if (state.range(0) == 1 && !IoUringFile::isSupported())
+        {
+            state.SkipWithError("io_uring is not available");
+            return true;
+        }
+        return false;
+    }
+} // namespace
+
+// Reads every column chunk of the file through a RangePrefetcher, without decoding
+static void BM_ColdRead(benchmark::State &state)
+{
+    if (skipUnsupported(state))
+    {
+        return;
+    }
+    CoalesceOptions coalesce;
+    coalesce.hole_size_limit = static_cast<size_t>(state.range(1));
+
+    int64_t bytes = 0;
+    size_t reads = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        benchmarkFile().dropPageCache();
+        state.ResumeTiming();
+
+        ParquetFileReader file(openFile(static_cast<int>(state.range(0))));
+        std::vector<ReadRange> ranges;
+        for (size_t g = 0; g < file.numRowGroups(); ++g)
+        {
+            for (size_t c = 0; c < file.columns().size(); ++c)
+            {
+                ranges.push_back(file.columnChunkRange(g, c));
+            }
+        }
+        RangePrefetcher prefetcher(file.file(), ranges, coalesce);
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            prefetcher.prefetch(i);
+        }
+        for (size_t i = 0; i < ranges.size(); ++i)
+        {
+            Slice slice = prefetcher.get(i);
+            benchmark::DoNotOptimize(slice.data);
+            bytes += static_cast<int64_t>(slice.size);
+        }
+        reads = prefetcher.numReads();
+    }
+    state.SetBytesProcessed(bytes);
+    state.counters["reads"] = static_cast<double>(reads);
+}
+
+// A full scan with decoding on 4 threads
+static void BM_ColdScan(benchmark::State &state)
+{
+    if (skipUnsupported(state))
+    {
+        return;
+    }
+    ThreadPool pool(4);
+    ScanOptions options;
+    options.pool = &pool;
+    options.ordered = false;
+    options.coalesce.hole_size_limit = static_cast<size_t>(state.range(1));
+
+    int64_t bytes = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        benchmarkFile().dropPageCache();
+        state.ResumeTiming();
+
+        auto file = std::make_shared<ParquetFileReader>(openFile(static_cast<int>(state.range(0))));
+        ParquetScanner scanner(file, options);
+        ScanBatch batch;
+        while (scanner.next(batch))
+        {
+            benchmark::DoNotOptimize(batch.batch->length());
+        }
+        for (const auto &row_group : file->metadata().row_groups)
+        {
+            bytes += row_group.total_byte_size;
+        }
+    }
+    state.SetBytesProcessed(bytes);
+}
+
+BENCHMARK(BM_ColdRead)
+    ->ArgNames({"uring", "hole"})
+    ->ArgsProduct({{0, 1}, {0, 8 * 1024, 1024 * 1024}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ColdScan)
+    ->ArgNames({"uring", "hole"})
+    ->ArgsProduct({{0, 1}, {0, 8 * 1024}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,221 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "filesystem.hpp"
+#include "io.hpp"
+#include "io_uring_file.hpp"
+#include "parquet.hpp"
+
+namespace
+{
+    std::string writeTestFile(const std::string &name, size_t size)
+    {
+        std::string path = testing::TempDir() + "/" + name;
+        std::vector<uint8_t> bytes(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            bytes[i] = static_cast<uint8_t>(i * 7 + i / 256);
+        }
+        FILE *file = std::fopen(path.c_str(), "wb");
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+        return path;
+    }
+
+    uint8_t expectedByte(uint64_t offset)
+    {
+        return static_cast<uint8_t>(offset * 7 + offset / 256);
+    }
+
+    class CountingFile : public RandomAccessFile
+    {
+    public:
+        explicit CountingFile(const std::string &path) : RandomAccessFile(path), file_(path) {}
+
+        uint64_t size() const override { return file_.size(); }
+
+        void readAt(uint64_t offset, size_t size, uint8_t *out) const override
+        {
+            ++reads;
+            file_.readAt(offset, size, out);
+        }
+
+        mutable std::atomic<int> reads{0};
+
+    private:
+        LocalFile file_;
+    };
+} // namespace
+
+TEST(CoalesceRangesTest, MergesWithinHoleSizeLimit)
+{
+    CoalesceOptions options;
+    options.hole_size_limit = 10;
+    options.range_size_limit = 100;
+    std::vector<ReadRange> ranges = {{50, 10}, {0, 10}, {15, 5}, {200, 90}, {295, 10}, {60, 5}};
+
+    auto reads = coalesceRanges(ranges, options);
+    ASSERT_EQ(reads.size(), 4u);
+    EXPECT_EQ(reads[0].range.offset, 0u);
+    EXPECT_EQ(reads[0].range.length, 20u);
+    EXPECT_EQ(reads[0].members, (std::vector<size_t>{1, 2}));
+    EXPECT_EQ(reads[1].range.offset, 50u);
+    EXPECT_EQ(reads[1].range.length, 15u);
+    EXPECT_EQ(reads[1].members, (std::vector<size_t>{0, 5}));
+    // Merging would exceed the range size limit
+    EXPECT_EQ(reads[2].members, (std::vector<size_t>{3}));
+    EXPECT_EQ(reads[3].members, (std::vector<size_t>{4}));
+}
+
+TEST(RangePrefetcherTest, ReadsEachCoalescedRangeOnce)
+{
+    std::string path = writeTestFile("prefetch.bin", 100000);
+    auto file = std::make_shared<CountingFile>(path);
+    std::vector<ReadRange> ranges = {{0, 1000}, {1500, 1000}, {50000, 100}, {50100, 900}};
+    CoalesceOptions options;
+    options.hole_size_limit = 1000;
+
+    RangePrefetcher prefetcher(file, ranges, options);
+    EXPECT_EQ(prefetcher.numReads(), 2u);
+    prefetcher.prefetch(0);
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        Slice slice = prefetcher.get(i);
+        ASSERT_EQ(slice.size, ranges[i].length);
+        for (size_t j = 0; j < slice.size; ++j)
+        {
+            ASSERT_EQ(slice.data[j], expectedByte(ranges[i].offset + j));
+        }
+    }
+    EXPECT_EQ(file->reads.load(), 2);
+    std::remove(path.c_str());
+}
+
+TEST(LocalFileTest, ReadPastEndThrows)
+{
+    std::string path = writeTestFile("local.bin", 100);
+    LocalFile file(path);
+    EXPECT_EQ(file.size(), 100u);
+    uint8_t buffer[10];
+    file.readAt(90, 10, buffer);
+    EXPECT_EQ(buffer[9], expectedByte(99));
+    EXPECT_THROW(file.readAt(95, 10, buffer), ParquetException);
+    std::remove(path.c_str());
+}
+
+TEST(IoUringFileTest, ReadsMatchPread)
+{
+    if (!IoUringFile::isSupported())
+    {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    std::string path = writeTestFile("uring.bin", 3 * 1024 * 1024 + 17);
+    IoUringOptions options;
+    options.queue_depth = 4;
+    options.buffer_size = 256 * 1024;
+    options.buffer_count = 2;
+    IoUringFile file(path, options);
+
+    // More reads than queue entries and pooled buffers, some larger than a buffer
+    std::vector<ReadRange> ranges;
+    for (uint64_t offset = 0; offset + 300000 < file.size(); offset += 100003)
+    {
+        ranges.push_back({offset, offset % 2 == 0 ? size_t{1000} : size_t{300000}});
+    }
+    std::vector<std::future<Slice>> futures;
+    for (const ReadRange &range : ranges)
+    {
+        futures.push_back(file.readAsync(range));
+    }
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        Slice slice = futures[i].get();
+        ASSERT_EQ(slice.size, ranges[i].length);
+        for (size_t j = 0; j < slice.size; j += 101)
+        {
+            ASSERT_EQ(slice.data[j], expectedByte(ranges[i].offset + j));
+        }
+    }
+
+    std::vector<uint8_t> buffer(1000);
+    file.readAt(file.size() - 1000, 1000, buffer.data());
+    EXPECT_EQ(buffer[999], expectedByte(file.size() - 1));
+    EXPECT_THROW(file.readAt(file.size() - 10, 20, buffer.data()), ParquetException);
+    std::remove(path.c_str());
+}
+
+TEST(BlockCacheTest, EvictsLeastRecentlyUsedBlocks)
+{
+    BlockCache cache(3 * 100, 100);
+    auto block = [](uint8_t value)
+    { return Slice::fromVector(std::vector<uint8_t>(100, value)); };
+    cache.insert("f", 0, block(0));
+    cache.insert("f", 1, block(1));
+    cache.insert("f", 2, block(2));
+    Slice out;
+    ASSERT_TRUE(cache.lookup("f", 0, out));
+    EXPECT_EQ(out.data[0], 0);
+    cache.insert("f", 3, block(3));
+
+    EXPECT_FALSE(cache.lookup("f", 1, out));
+    EXPECT_TRUE(cache.lookup("f", 0, out));
+    EXPECT_FALSE(cache.lookup("g", 0, out));
+    // Larger than the whole cache
+    cache.insert("f", 4, Slice::fromVector(std::vector<uint8_t>(301)));
+    EXPECT_FALSE(cache.lookup("f", 4, out));
+
+    BlockCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 3u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.bytes, 300u);
+}
+
+TEST(CachingFileSystemTest, ReadsMissingBlocksOnly)
+{
+    std::string path = writeTestFile("cached.bin", 10000);
+    auto base = std::make_shared<CountingFile>(path);
+    auto cache = std::make_shared<BlockCache>(1 << 20, 1000);
+    CachedFile file(base, cache);
+    EXPECT_EQ(file.size(), 10000u);
+
+    std::vector<uint8_t> buffer(2500);
+    file.readAt(1500, 2500, buffer.data());
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+        ASSERT_EQ(buffer[i], expectedByte(1500 + i));
+    }
+    EXPECT_EQ(base->reads.load(), 1);
+
+    // Blocks 1 to 3 are cached, 0 and 4 are read separately
+    Slice slice = file.readAsync({500, 4000}).get();
+    ASSERT_EQ(slice.size, 4000u);
+    for (size_t i = 0; i < slice.size; ++i)
+    {
+        ASSERT_EQ(slice.data[i], expectedByte(500 + i));
+    }
+    EXPECT_EQ(base->reads.load(), 3);
+
+    // Within one cached block, served without a copy or a read
+    slice = file.readAsync({4100, 10}).get();
+    EXPECT_EQ(slice.data[0], expectedByte(4100));
+    file.readAt(9990, 10, buffer.data());
+    EXPECT_EQ(buffer[9], expectedByte(9999));
+    EXPECT_EQ(base->reads.load(), 4);
+    EXPECT_THROW(file.readAt(9995, 10, buffer.data()), ParquetException);
+
+    // LocalFile has a version (the modification time), so its blocks are keyed apart from
+    // the ones of the versionless CountingFile
+    CachingFileSystem filesystem(std::make_shared<LocalFileSystem>(), cache);
+    auto other = filesystem.openFile(path);
+    uint64_t misses = cache->stats().misses;
+    other->readAt(0, 10, buffer.data());
+    EXPECT_EQ(buffer[5], expectedByte(5));
+    EXPECT_EQ(cache->stats().misses, misses + 1);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,489 @@
+#include "io_uring_file.hpp"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "instrumentation.hpp"
+#include "parquet.hpp"
+
+namespace
+{
+    // Reads are capped at 1GB, safely below the kernel's limit of just under 2GB per read;
+    // larger requests complete short and are resubmitted for the rest
+    constexpr size_t kMaxReadSize = size_t{1} << 30;
+
+    // User data of the no-op an entry becomes when submitting it failed; the completion
+    // thread skips it
+    constexpr uint64_t kDiscarded = 1;
+
+    int ioUringSetup(unsigned entries, io_uring_params *params)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int ioUringEnter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    int ioUringRegister(int fd, unsigned opcode, const void *arg, unsigned count)
+    {
+        return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, count));
+    }
+
+    /**
+     * @brief Fixed size page aligned buffers, shared with the slices that use them.
+     */
+    class BufferPool
+    {
+    public:
+        BufferPool(size_t buffer_size, size_t count) : buffer_size_(buffer_size)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                buffers_.push_back(static_cast<uint8_t *>(::operator new(buffer_size, std::align_val_t{4096})));
+                free_.push_back(static_cast<int>(i));
+            }
+        }
+
+        ~BufferPool()
+        {
+            for (uint8_t *buffer : buffers_)
+            {
+                ::operator delete(buffer, std::align_val_t{4096});
+            }
+        }
+
+        size_t bufferSize() const noexcept { return buffer_size_; }
+        const std::vector<uint8_t *> &buffers() const noexcept { return buffers_; }
+
+        /**
+         * @return A free buffer index, -1 if all are in use
+         */
+        int acquire()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.empty())
+            {
+                return -1;
+            }
+            int index = free_.back();
+            free_.pop_back();
+            return index;
+        }
+
+        void release(int index)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_.push_back(index);
+        }
+
+    private:
+        size_t buffer_size_;
+        std::vector<uint8_t *> buffers_;
+        std::mutex mutex_;
+        std::vector<int> free_;
+    };
+
+    struct Request
+    {
+        uint8_t *out;
+        uint64_t offset;
+        size_t remaining;
+        int buffer_index;
+        Slice slice;
+        std::promise<Slice> promise;
+    };
+} // namespace
+
+struct IoUringFile::Ring
+{
+    int fd = -1;
+    int file_fd = -1;
+    unsigned entries = 0;
+
+    void *sq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    void *cq_ptr = MAP_FAILED;
+    size_t cq_size = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    unsigned *sq_tail = nullptr;
+    unsigned *sq_mask = nullptr;
+    unsigned *sq_array = nullptr;
+    unsigned *cq_head = nullptr;
+    unsigned *cq_tail = nullptr;
+    unsigned *cq_mask = nullptr;
+    io_uring_cqe *cqes = nullptr;
+
+    std::shared_ptr<BufferPool> pool;
+    bool registered = false;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    unsigned in_flight = 0;
+    std::thread reaper;
+
+    Ring(int file_fd, const IoUringOptions &options) : file_fd(file_fd)
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = ioUringSetup(std::max(options.queue_depth, 1u), &params);
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+        }
+        // Starting the completion thread is the last step, so nothing uses the ring when
+        // it is unmapped on failure
+        try
+        {
+            map(params);
+            if (options.buffer_count > 0 && options.buffer_size > 0)
+            {
+                pool = std::make_shared<BufferPool>(options.buffer_size, options.buffer_count);
+                std::vector<iovec> iovecs;
+                for (uint8_t *buffer : pool->buffers())
+                {
+                    iovecs.push_back({buffer, options.buffer_size});
+                }
+                registered = ioUringRegister(fd, IORING_REGISTER_BUFFERS, iovecs.data(),
+                                             static_cast<unsigned>(iovecs.size())) == 0;
+            }
+            reaper = std::thread([this]()
+                                 { reap(); });
+        }
+        catch (...)
+        {
+            unmap();
+            throw;
+        }
+    }
+
+    ~Ring()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]()
+                     { return in_flight == 0; });
+        // A no-op without request tells the completion thread to exit
+        io_uring_sqe *sqe = nextSqe();
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = 0;
+        commit(sqe);
+        lock.unlock();
+        reaper.join();
+        unmap();
+    }
+
+    void map(const io_uring_params &params)
+    {
+        entries = params.sq_entries;
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap)
+        {
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        }
+        sq_ptr = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::generic_category(), "mmap io_uring submission queue");
+        }
+        cq_ptr = single_mmap ? sq_ptr
+                             : ::mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                      IORING_OFF_CQ_RING);
+        if (cq_ptr == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::generic_category(), "mmap io_uring completion queue");
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(
+            ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+        {
+            throw std::system_error(errno, std::generic_category(), "mmap io_uring entries");
+        }
+
+        auto *sq = static_cast<uint8_t *>(sq_ptr);
+        sq_tail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+        auto *cq = static_cast<uint8_t *>(cq_ptr);
+        cq_head = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+    }
+
+    void unmap()
+    {
+        if (sqes != MAP_FAILED)
+        {
+            ::munmap(sqes, sqes_size);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+        {
+            ::munmap(cq_ptr, cq_size);
+        }
+        if (sq_ptr != MAP_FAILED)
+        {
+            ::munmap(sq_ptr, sq_size);
+        }
+        ::close(fd);
+    }
+
+    // The submission queue is only touched with `mutex` held. At most `entries` requests
+    // are in flight, so the next entry is always free and the completion queue (twice as
+    // large) never overflows.
+    io_uring_sqe *nextSqe()
+    {
+        unsigned index = *sq_tail & *sq_mask;
+        io_uring_sqe *sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array[index] = index;
+        return sqe;
+    }
+
+    void commit(io_uring_sqe *sqe)
+    {
+        __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+        ++in_flight;
+        while (ioUringEnter(fd, 1, 0, 0) < 0)
+        {
+            if (errno != EINTR && errno != EAGAIN)
+            {
+                int error = errno;
+                // The entry stays in the queue and a later io_uring_enter submits it. The
+                // caller frees the request, so the entry becomes a no-op the completion
+                // thread skips, and it no longer counts as in flight.
+                std::memset(sqe, 0, sizeof(*sqe));
+                sqe->opcode = IORING_OP_NOP;
+                sqe->user_data = kDiscarded;
+                --in_flight;
+                changed.notify_all();
+                throw std::system_error(error, std::generic_category(), "io_uring_enter");
+            }
+        }
+    }
+
+    void submitLocked(Request *request)
+    {
+        io_uring_sqe *sqe = nextSqe();
+        if (request->buffer_index >= 0)
+        {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->buf_index = static_cast<uint16_t>(request->buffer_index);
+        }
+        else
+        {
+            sqe->opcode = IORING_OP_READ;
+        }
+        sqe->fd = file_fd;
+        sqe->off = request->offset;
+        sqe->addr = reinterpret_cast<uint64_t>(request->out);
+        sqe->len = static_cast<uint32_t>(std::min(request->remaining, kMaxReadSize));
+        sqe->user_data = reinterpret_cast<uint64_t>(request);
+        commit(sqe);
+    }
+
+    void submit(Request *request)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        changed.wait(lock, [this]()
+                     { return in_flight < entries; });
+        submitLocked(request);
+    }
+
+    void complete(Request *request, int result)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        --in_flight;
+        changed.notify_all();
+        bool resubmit = result == -EINTR || result == -EAGAIN;
+        if (result > 0)
+        {
+            auto n = static_cast<size_t>(result);
+            request->out += n;
+            request->offset += n;
+            request->remaining -= n;
+            resubmit = request->remaining > 0;
+        }
+        // A failed resubmission fails the request; it must not escape the completion thread
+        std::exception_ptr error;
+        if (resubmit)
+        {
+            try
+            {
+                submitLocked(request);
+                return;
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+        }
+        lock.unlock();
+
+        if (error)
+        {
+            request->promise.set_exception(error);
+        }
+        else if (result < 0)
+        {
+            request->promise.set_exception(
+                std::make_exception_ptr(std::system_error(-result, std::generic_category(), "io_uring read")));
+        }
+        else if (result == 0)
+        {
+            request->promise.set_exception(std::make_exception_ptr(ParquetException("Unexpected end of file")));
+        }
+        else
+        {
+            request->promise.set_value(std::move(request->slice));
+        }
+        delete request;
+    }
+
+    void reap()
+    {
+        bool stopping = false;
+        while (!stopping)
+        {
+            if (ioUringEnter(fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+            {
+                // Nothing sensible to do; retry rather than lose completions
+                std::this_thread::yield();
+            }
+            unsigned head = *cq_head;
+            unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+            while (head != tail)
+            {
+                const io_uring_cqe &cqe = cqes[head & *cq_mask];
+                uint64_t user_data = cqe.user_data;
+                int result = cqe.res;
+                ++head;
+                __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+                if (user_data == 0)
+                {
+                    stopping = true;
+                    continue;
+                }
+                if (user_data == kDiscarded)
+                {
+                    continue;
+                }
+                complete(reinterpret_cast<Request *>(user_data), result);
+            }
+        }
+    }
+};
+
+bool IoUringFile::isSupported() noexcept
+{
+    static const bool supported = []()
+    {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        int fd = ioUringSetup(1, &params);
+        if (fd < 0)
+        {
+            return false;
+        }
+        ::close(fd);
+        return true;
+    }();
+    return supported;
+}
+
+IoUringFile::IoUringFile(const std::string &path, IoUringOptions options)
+    : LocalFile(path), ring_(std::make_unique<Ring>(fd(), options)) {}
+
+IoUringFile::~IoUringFile() = default;
+
+bool IoUringFile::buffersRegistered() const noexcept
+{
+    return ring_->registered;
+}
+
+void IoUringFile::readAt(uint64_t offset, size_t size, uint8_t *out) const
+{
+    if (size == 0)
+    {
+        return;
+    }
+    FORMATS_TIME(READ);
+    FORMATS_COUNT(BYTES_READ, size);
+    FORMATS_COUNT(READ_CALLS, 1);
+    auto *request = new Request{out, offset, size, -1, {}, {}};
+    std::future<Slice> done = request->promise.get_future();
+    try
+    {
+        ring_->submit(request);
+    }
+    catch (...)
+    {
+        delete request;
+        throw;
+    }
+    done.get();
+}
+
+std::future<Slice> IoUringFile::readAsync(ReadRange range) const
+{
+    Slice slice;
+    int buffer_index = -1;
+    BufferPool *pool = ring_->pool.get();
+    if (ring_->registered && range.length <= pool->bufferSize())
+    {
+        buffer_index = pool->acquire();
+    }
+    if (buffer_index >= 0)
+    {
+        uint8_t *buffer = pool->buffers()[static_cast<size_t>(buffer_index)];
+        slice.owner = std::shared_ptr<const void>(buffer, [pool = ring_->pool, buffer_index](const void *)
+                                                  { pool->release(buffer_index); });
+        slice.data = buffer;
+        slice.size = range.length;
+    }
+    else
+    {
+        slice = Slice::fromVector(std::vector<uint8_t>(range.length));
+    }
+
+    if (range.length == 0)
+    {
+        std::promise<Slice> ready;
+        ready.set_value(std::move(slice));
+        return ready.get_future();
+    }
+    // Asynchronous reads are counted but not timed; their latency shows in the stage waiting for them
+    FORMATS_COUNT(BYTES_READ, range.length);
+    FORMATS_COUNT(READ_CALLS, 1);
+    auto *request = new Request{const_cast<uint8_t *>(slice.data), range.offset, range.length, buffer_index,
+                                std::move(slice), {}};
+    std::future<Slice> result = request->promise.get_future();
+    try
+    {
+        ring_->submit(request);
+    }
+    catch (...)
+    {
+        delete request;
+        throw;
+    }
+    return result;
+}
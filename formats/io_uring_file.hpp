@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "io.hpp"
+
+struct IoUringOptions
+{
+    /// Submission queue entries, i.e. reads in flight at once
+    unsigned queue_depth = 64;
+
+    /// Pool of buffers registered with the ring. Asynchronous reads that fit a buffer land
+    /// in one with IORING_OP_READ_FIXED, which saves the kernel pinning the pages per read.
+    /// Larger reads, or reads while every buffer is in use, go to heap memory instead.
+    size_t buffer_size = 4 * 1024 * 1024;
+    size_t buffer_count = 16;
+};
+
+/**
+ * @brief A local file read through io_uring.
+ *
+ * readAsync() submits the read right away and a completion thread fulfils the futures,
+ * so a scan can keep many reads in flight without tying up threads, and decoding threads
+ * never stall on page faults the way they would with mmap. Short reads are resubmitted
+ * for the remaining bytes.
+ *
+ * The ring is driven with raw system calls, liburing is not needed.
+ */
+class IoUringFile : public LocalFile
+{
+public:
+    /**
+     * @brief Whether the kernel supports io_uring (it may be disabled or filtered out).
+     */
+    static bool isSupported() noexcept;
+
+    /**
+     * @throws std::system_error if the file cannot be opened or the ring cannot be set up
+     */
+    explicit IoUringFile(const std::string &path, IoUringOptions options = {});
+
+    /**
+     * @brief Waits for the reads in flight.
+     */
+    ~IoUringFile() override;
+
+    void readAt(uint64_t offset, size_t size, uint8_t *out) const override;
+    std::future<Slice> readAsync(ReadRange range) const override;
+
+    /**
+     * @brief Whether the buffer pool was registered; registration fails when the memory
+     * lock limit is too low, reads then fall back to plain IORING_OP_READ.
+     */
+    bool buffersRegistered() const noexcept;
+
+private:
+    struct Ring;
+    std::unique_ptr<Ring> ring_;
+};
@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "benchmark_file.hpp"
+#include "scanner.hpp"
+
+// Late materialization against decoding everything, at 0.1%, 1% and 10% selectivity (and
+// 100% for the overhead), on the 1M row BenchmarkFile of benchmark_file.hpp (row groups of
+// 128K rows, Snappy compression, pages of 20K rows or 1MB). The predicate columns:
+// - id: ascending INT64, so `id < bound` selects a contiguous range of rows and most pages
+//   hold none of them (clustered)
+// - key: uniform INT64, so `key < bound` scatters the rows over every page (random)
+// and the payload: price, quantity, name and url.
+//
+// BM_Eager scans every column and evaluates the predicate on the decoded batches, the
+// way a consumer without late materialization would. BM_Late hands the predicate to the
+// scanner as a filter. Both decode on one pool thread, so the wall times compare decoding work.
+
+namespace
+{
+    constexpr size_t kRows = 1000000;
+
+    enum Predicate
+    {
+        kClustered,
+        kRandom
+    };
+
+    const BenchmarkFile &benchmarkFile()
+    {
+        static BenchmarkFile file("late_materialization_benchmark", kRows);
+        return file;
+    }
+
+    const std::shared_ptr<const ParquetFileReader> &benchmarkReader()
+    {
+        static const std::shared_ptr<const ParquetFileReader> reader =
+            std::make_shared<ParquetFileReader>(benchmarkFile().path());
+        return reader;
+    }
+
+    /**
+     * @brief The bound of `column < bound` selecting `basis_points` of the rows.
+     */
+    int64_t selectionBound(Predicate predicate, int64_t basis_points)
+    {
+        size_t selected = kRows * static_cast<size_t>(basis_points) / 10000;
+        if (predicate == kRandom)
+        {
+            return static_cast<int64_t>(selected);
+        }
+        const std::vector<int64_t> &ids = benchmarkFile().ids();
+        return selected == kRows ? ids.back() + 1 : ids[selected];
+    }
+
+    /**
+     * @brief Sets the bits of the rows whose value is below `bound` and returns their number.
+     */
+    size_t selectBelow(const ColumnBatch &column, int64_t bound, Bitmap &selection)
+    {
+        const int64_t *values = column.values<int64_t>();
+        size_t selected = 0;
+        for (size_t i = 0; i < column.length(); ++i)
+        {
+            if (values[i] < bound)
+            {
+                selection.set(i);
+                ++selected;
+            }
+        }
+        return selected;
+    }
+
+    ScanOptions scanOptions()
+    {
+        ScanOptions options;
+        options.threads = 1;
+        return options;
+    }
+
+    void selectivityArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"predicate", "basis_points"});
+        benchmark->ArgsProduct({{kClustered, kRandom}, {10, 100, 1000, 10000}});
+        benchmark->UseRealTime();
+        benchmark->Unit(benchmark::kMillisecond);
+    }
+} // namespace
+
+static void BM_Eager(benchmark::State &state)
+{
+    auto predicate = static_cast<Predicate>(state.range(0));
+    int64_t bound = selectionBound(predicate, state.range(1));
+    size_t column = predicate == kClustered ? 0 : 1;
+    size_t selected = 0;
+    for (auto _ : state)
+    {
+        ParquetScanner scanner(benchmarkReader(), scanOptions());
+        selected = 0;
+        ScanBatch batch;
+        while (scanner.next(batch))
+        {
+            if (batch.column == column)
+            {
+                Bitmap selection(batch.batch->length());
+                selected += selectBelow(*batch.batch, bound, selection);
+            }
+            benchmark::DoNotOptimize(batch.batch->data());
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kRows));
+    state.counters["selected_rows"] = static_cast<double>(selected);
+}
+
+static void BM_Late(benchmark::State &state)
+{
+    auto predicate = static_cast<Predicate>(state.range(0));
+    int64_t bound = selectionBound(predicate, state.range(1));
+    ScanOptions options = scanOptions();
+    options.filter_columns = {predicate == kClustered ? "id" : "key"};
+    options.filter = [bound](const std::vector<ColumnBatch> &columns, Bitmap &selection)
+    { selectBelow(columns[0], bound, selection); };
+    size_t selected = 0;
+    for (auto _ : state)
+    {
+        ParquetScanner scanner(benchmarkReader(), options);
+        selected = 0;
+        ScanBatch batch;
+        while (scanner.next(batch))
+        {
+            selected += batch.column == 0 ? batch.batch->length() : 0;
+            benchmark::DoNotOptimize(batch.batch->data());
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kRows));
+    state.counters["selected_rows"] = static_cast<double>(selected);
+}
+
+BENCHMARK(BM_Eager)->Apply(selectivityArgs);
+BENCHMARK(BM_Late)->Apply(selectivityArgs);
+
+BENCHMARK_MAIN();
@@ -1,8 +1,137 @@
 #include "parquet.hpp"
+#include "parquet_rewriter.hpp"
+#include <algorithm>
+#include <cstring>
+#include <exception>
 #include <iostream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-int main()
+namespace
 {
-    std::cout << "Rebuilding PARQUET one step at a time" << std::endl;
-    return 0;
-}
\ No newline at end of file
+    const char kUsage[] = "usage: main rewrite [--columns a,b.c] [--codec uncompressed|snappy]\n"
+                          "                    [--encoding column=plain|dictionary|delta|delta_byte_array|"
+                          "byte_stream_split]...\n"
+                          "                    [--sort column[:desc]] [--threads n] <input> <output>\n";
+
+    std::vector<std::string> split(const std::string &list)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= list.size())
+        {
+            size_t end = std::min(list.find(',', start), list.size());
+            parts.push_back(list.substr(start, end - start));
+            start = end + 1;
+        }
+        return parts;
+    }
+
+    template <typename T>
+    T lookup(const std::map<std::string, T> &names, const std::string &name, const char *what)
+    {
+        auto it = names.find(name);
+        if (it == names.end())
+        {
+            throw std::invalid_argument(std::string("Unknown ") + what + " " + name);
+        }
+        return it->second;
+    }
+
+    int rewrite(int argc, char **argv)
+    {
+        const std::map<std::string, CompressionCodec> codecs = {
+            {"uncompressed", CompressionCodec::UNCOMPRESSED},
+            {"snappy", CompressionCodec::SNAPPY},
+        };
+        const std::map<std::string, Encoding> encodings = {
+            {"plain", Encoding::PLAIN},
+            {"dictionary", Encoding::RLE_DICTIONARY},
+            {"delta", Encoding::DELTA_BINARY_PACKED},
+            {"delta_byte_array", Encoding::DELTA_BYTE_ARRAY},
+            {"byte_stream_split", Encoding::BYTE_STREAM_SPLIT},
+        };
+        RewriteOptions options;
+        std::vector<std::string> paths;
+        for (int i = 2; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg.rfind("--", 0) != 0)
+            {
+                paths.push_back(arg);
+                continue;
+            }
+            if (i + 1 == argc)
+            {
+                throw std::invalid_argument("Missing value of " + arg);
+            }
+            std::string value = argv[++i];
+            if (arg == "--columns")
+            {
+                options.columns = split(value);
+            }
+            else if (arg == "--codec")
+            {
+                options.codec = lookup(codecs, value, "codec");
+            }
+            else if (arg == "--encoding")
+            {
+                size_t equals = value.rfind('=');
+                if (equals == std::string::npos)
+                {
+                    throw std::invalid_argument("Expected column=encoding, got " + value);
+                }
+                options.column_encodings[value.substr(0, equals)] =
+                    lookup(encodings, value.substr(equals + 1), "encoding");
+            }
+            else if (arg == "--sort")
+            {
+                options.descending = value.size() > 5 && value.compare(value.size() - 5, 5, ":desc") == 0;
+                options.sort_column = options.descending ? value.substr(0, value.size() - 5) : value;
+            }
+            else if (arg == "--threads")
+            {
+                options.threads = std::stoul(value);
+            }
+            else
+            {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        if (paths.size() != 2)
+        {
+            std::cerr << kUsage;
+            return 2;
+        }
+        RewriteResult result = rewriteParquetFile(paths[0], paths[1], options);
+        std::cout << result.row_groups << " row groups, " << result.copied_chunks << " chunks copied ("
+                  << result.copied_bytes << " bytes), " << result.rewritten_chunks << " chunks rewritten, "
+                  << result.input_bytes << " -> " << result.output_bytes << " bytes" << std::endl;
+        return 0;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cout << "Rebuilding PARQUET one step at a time" << std::endl;
+        return 0;
+    }
+    if (std::strcmp(argv[1], "rewrite") != 0)
+    {
+        std::cerr << kUsage;
+        return 2;
+    }
+    try
+    {
+        return rewrite(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,58 @@
+#include "metadata_cache.hpp"
+
+#include "instrumentation.hpp"
+
+MetadataCache::MetadataCache(size_t capacity, size_t num_shards)
+    : capacity_(capacity), entries_(capacity, num_shards)
+{
+}
+
+const std::shared_ptr<MetadataCache> &MetadataCache::global()
+{
+    static const std::shared_ptr<MetadataCache> cache = std::make_shared<MetadataCache>(size_t{256} << 20);
+    return cache;
+}
+
+std::string MetadataCache::fileKey(const RandomAccessFile &file)
+{
+    std::string key = file.path();
+    key += '\0';
+    key += std::to_string(file.size());
+    key += '\0';
+    key += file.version();
+    return key;
+}
+
+std::shared_ptr<const void> MetadataCache::lookup(const std::string &key)
+{
+    auto handle = entries_.lookup(key);
+    if (!handle)
+    {
+        FORMATS_COUNT(METADATA_CACHE_MISSES, 1);
+        return nullptr;
+    }
+    FORMATS_COUNT(METADATA_CACHE_HITS, 1);
+    return *handle;
+}
+
+std::shared_ptr<const void> MetadataCache::insert(const std::string &key, std::shared_ptr<const void> value,
+                                                  size_t charge)
+{
+    if (!value)
+    {
+        return value;
+    }
+    return *entries_.tryInsert(key, std::move(value), charge);
+}
+
+MetadataCacheStats MetadataCache::stats() const
+{
+    CacheStats cache = entries_.stats();
+    MetadataCacheStats stats;
+    stats.hits = cache.hits;
+    stats.misses = cache.misses;
+    stats.evictions = cache.evictions;
+    stats.entries = cache.entries;
+    stats.bytes = cache.bytes;
+    return stats;
+}
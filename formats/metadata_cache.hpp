@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "basics/sharded_cache.h"
+#include "io.hpp"
+
+struct MetadataCacheStats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    size_t entries = 0;
+
+    /// Sum of the charges of the cached entries
+    size_t bytes = 0;
+};
+
+/**
+ * @brief A size-bounded cache of parsed file metadata (footers, page indexes, Bloom
+ * filters) shared by all readers of a process.
+ *
+ * Keys start with fileKey(), i.e. path, size and version (mtime or ETag), so a rewritten
+ * file never hits the entries of its previous contents. Values are immutable and handed
+ * out as shared pointers; evicting an entry does not affect readers still using it.
+ *
+ * The cache is a ShardedCache with CLOCK eviction: a hit only sets the entry's reference
+ * bit under its shard's shared lock, and eviction sweeps the shard's entries, giving
+ * referenced ones a second chance.
+ */
+class MetadataCache
+{
+public:
+    /**
+     * @param capacity Upper bound of the summed charges, split evenly between the shards
+     * @throws std::invalid_argument for zero shards
+     */
+    explicit MetadataCache(size_t capacity, size_t num_shards = 16);
+
+    /**
+     * @brief The process-wide cache, 256MB.
+     */
+    static const std::shared_ptr<MetadataCache> &global();
+
+    /**
+     * @brief The key prefix of the entries belonging to a file.
+     */
+    static std::string fileKey(const RandomAccessFile &file);
+
+    size_t capacity() const noexcept { return capacity_; }
+
+    /**
+     * @brief Returns the cached value, or calls `load` and caches its result. `load`
+     * returns the value and sets its charge (about the bytes it holds). Concurrent misses
+     * of one key may load it more than once; the first insert wins. Errors of `load`
+     * propagate and nothing is cached.
+     */
+    template <typename T>
+    std::shared_ptr<const T> getOrLoad(const std::string &key,
+                                       const std::function<std::shared_ptr<const T>(size_t &charge)> &load)
+    {
+        if (std::shared_ptr<const void> value = lookup(key))
+        {
+            return std::static_pointer_cast<const T>(value);
+        }
+        size_t charge = 0;
+        std::shared_ptr<const T> value = load(charge);
+        return std::static_pointer_cast<const T>(insert(key, value, charge));
+    }
+
+    /**
+     * @return null on a miss
+     */
+    std::shared_ptr<const void> lookup(const std::string &key);
+
+    /**
+     * @brief Inserts a value unless the key is present already, evicting entries as
+     * needed. Values charged more than a shard holds are returned but not cached.
+     * @return The cached value for the key
+     */
+    std::shared_ptr<const void> insert(const std::string &key, std::shared_ptr<const void> value, size_t charge);
+
+    MetadataCacheStats stats() const;
+
+private:
+    size_t capacity_;
+    ShardedCache<std::string, std::shared_ptr<const void>, ClockPolicy> entries_;
+};
@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "metadata_cache.hpp"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+// Latency of opening a Parquet file with a large footer (256 row groups of 32 columns,
+// ~1MB of Thrift), without a metadata cache (every open reads and parses the footer)
+// and with a warm one (an open is a lookup). The file stays in the page cache, so the
+// cold numbers are the floor of a local open; remote stores add their round trips.
+
+namespace
+{
+    constexpr size_t kRowGroups = 256;
+    constexpr size_t kColumns = 32;
+
+    class BenchmarkFile
+    {
+    public:
+        BenchmarkFile()
+        {
+            path_ = "/tmp/metadata_cache_benchmark_" + std::to_string(::getpid()) + ".parquet";
+            std::vector<ColumnDescriptor> columns(kColumns);
+            for (size_t c = 0; c < kColumns; ++c)
+            {
+                columns[c].path = {"column_with_a_longer_name_" + std::to_string(c)};
+                columns[c].type = AtomicType::INT64;
+            }
+            ParquetFileWriter writer(path_, columns);
+            ColumnBatch batch(AtomicType::INT64);
+            int64_t *values = batch.appendValues<int64_t>(16);
+            for (int64_t i = 0; i < 16; ++i)
+            {
+                values[i] = i;
+            }
+            std::vector<const ColumnBatch *> batches(kColumns, &batch);
+            for (size_t g = 0; g < kRowGroups; ++g)
+            {
+                writer.writeRowGroup(batches);
+            }
+            writer.close();
+        }
+
+        ~BenchmarkFile() { std::remove(path_.c_str()); }
+
+        const std::string &path() const noexcept { return path_; }
+
+    private:
+        std::string path_;
+    };
+
+    const BenchmarkFile &benchmarkFile()
+    {
+        static BenchmarkFile file;
+        return file;
+    }
+} // namespace
+
+static void BM_Open(benchmark::State &state)
+{
+    const std::string &path = benchmarkFile().path();
+    std::shared_ptr<MetadataCache> cache;
+    if (state.range(0) == 1)
+    {
+        cache = std::make_shared<MetadataCache>(size_t{64} << 20);
+    }
+    for (auto _ : state)
+    {
+        ParquetFileReader reader(std::make_shared<LocalFile>(path), cache);
+        benchmark::DoNotOptimize(reader.metadata().num_rows);
+    }
+    if (cache)
+    {
+        MetadataCacheStats stats = cache->stats();
+        state.counters["hits"] = static_cast<double>(stats.hits);
+        state.counters["misses"] = static_cast<double>(stats.misses);
+    }
+}
+
+// Warm opens from several threads, which only share-lock the cache shards
+static void BM_OpenConcurrent(benchmark::State &state)
+{
+    static std::shared_ptr<MetadataCache> cache = std::make_shared<MetadataCache>(size_t{64} << 20);
+    const std::string &path = benchmarkFile().path();
+    for (auto _ : state)
+    {
+        ParquetFileReader reader(std::make_shared<LocalFile>(path), cache);
+        benchmark::DoNotOptimize(reader.metadata().num_rows);
+    }
+}
+
+BENCHMARK(BM_Open)->ArgName("cached")->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_OpenConcurrent)->Threads(1)->Threads(4)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
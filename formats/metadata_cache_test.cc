@@ -0,0 +1,270 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+#include "bloom_filter.hpp"
+#include "metadata_cache.hpp"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+namespace
+{
+    class CountingFile : public RandomAccessFile
+    {
+    public:
+        CountingFile(const std::string &path, std::string version)
+            : RandomAccessFile(path), file_(path), version_(std::move(version)) {}
+
+        uint64_t size() const override { return file_.size(); }
+        std::string version() const override { return version_; }
+
+        void readAt(uint64_t offset, size_t size, uint8_t *out) const override
+        {
+            ++reads;
+            file_.readAt(offset, size, out);
+        }
+
+        mutable std::atomic<int> reads{0};
+
+    private:
+        LocalFile file_;
+        std::string version_;
+    };
+
+    // Two row groups of an INT64 column with a Bloom filter and a BYTE_ARRAY column
+    std::string writeTestFile(const std::string &name)
+    {
+        std::string path = testing::TempDir() + "/" + name;
+        std::vector<ColumnDescriptor> columns(2);
+        columns[0].path = {"id"};
+        columns[0].type = AtomicType::INT64;
+        columns[1].path = {"name"};
+        columns[1].type = AtomicType::BYTE_ARRAY;
+        columns[1].max_definition_level = 1;
+        WriterOptions options;
+        options.bloom_filter_columns = {"id", "name"};
+        // ReadsPageIndexes splices in a page index of its own
+        options.write_page_index = false;
+        ParquetFileWriter writer(path, columns, options);
+        for (int64_t g = 0; g < 2; ++g)
+        {
+            ColumnBatch ids(AtomicType::INT64);
+            ColumnBatch names(AtomicType::BYTE_ARRAY);
+            for (int64_t i = 0; i < 1000; ++i)
+            {
+                *ids.appendValues<int64_t>(1) = g * 1000 + i;
+                if (i % 10 == 0)
+                {
+                    names.appendNulls(1);
+                }
+                else
+                {
+                    std::string value = "name-" + std::to_string(g * 1000 + i);
+                    names.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+                }
+            }
+            writer.writeRowGroup({&ids, &names});
+        }
+        writer.close();
+        return path;
+    }
+} // namespace
+
+TEST(BloomFilterTest, HashesLikeXxHash64)
+{
+    EXPECT_EQ(xxHash64(nullptr, 0), 0xEF46DB3751D8E999ULL);
+    EXPECT_EQ(BloomFilter::hash(std::string_view("a")), 0xD24EC4F1A98C6E5BULL);
+    EXPECT_EQ(BloomFilter::hash(std::string_view("abc")), 0x44BC2CF5AD770999ULL);
+}
+
+TEST(BloomFilterTest, HasNoFalseNegativesAndFewFalsePositives)
+{
+    EXPECT_EQ(BloomFilter::optimalNumBytes(0, 0.01), BloomFilter::kMinBytes);
+    size_t num_bytes = BloomFilter::optimalNumBytes(10000, 0.01);
+    EXPECT_EQ(num_bytes & (num_bytes - 1), 0u);
+    EXPECT_THROW(BloomFilter::optimalNumBytes(10, 1.5), std::invalid_argument);
+    EXPECT_THROW(BloomFilter(100), std::invalid_argument);
+
+    BloomFilter filter(num_bytes);
+    for (int64_t i = 0; i < 10000; ++i)
+    {
+        filter.insert(BloomFilter::hash(i));
+    }
+    size_t false_positives = 0;
+    for (int64_t i = 0; i < 10000; ++i)
+    {
+        ASSERT_TRUE(filter.mightContain(BloomFilter::hash(i)));
+        false_positives += filter.mightContain(BloomFilter::hash(i + 1000000));
+    }
+    EXPECT_LT(false_positives, 200u);
+}
+
+TEST(MetadataCacheTest, CountsHitsMissesAndEvictions)
+{
+    MetadataCache cache(300, 1);
+    auto load = [](int value, size_t charge)
+    {
+        return [value, charge](size_t &out)
+        {
+            out = charge;
+            return std::make_shared<const int>(value);
+        };
+    };
+    EXPECT_EQ(*cache.getOrLoad<int>("a", load(1, 100)), 1);
+    EXPECT_EQ(*cache.getOrLoad<int>("a", load(2, 100)), 1);
+    cache.getOrLoad<int>("b", load(3, 100));
+    cache.getOrLoad<int>("c", load(4, 100));
+
+    // "a" was used since its insert and gets a second chance, "b" goes
+    cache.getOrLoad<int>("d", load(5, 100));
+    EXPECT_NE(cache.lookup("a"), nullptr);
+    EXPECT_EQ(cache.lookup("b"), nullptr);
+
+    // Larger than the cache: returned, not cached
+    EXPECT_EQ(*cache.getOrLoad<int>("e", load(6, 1000)), 6);
+    EXPECT_EQ(cache.lookup("e"), nullptr);
+
+    EXPECT_THROW(cache.getOrLoad<int>("f", [](size_t &) -> std::shared_ptr<const int>
+                                      { throw std::runtime_error("load failed"); }),
+                 std::runtime_error);
+    EXPECT_EQ(cache.lookup("f"), nullptr);
+
+    MetadataCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(stats.misses, 9u);
+    EXPECT_EQ(stats.evictions, 1u);
+    EXPECT_EQ(stats.entries, 3u);
+    EXPECT_EQ(stats.bytes, 300u);
+}
+
+TEST(MetadataCacheTest, IsSafeUnderConcurrentUse)
+{
+    MetadataCache cache(64 * 100, 4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&cache, t]()
+                             {
+                                 for (int i = 0; i < 2000; ++i)
+                                 {
+                                     int key = (i * 7 + t) % 200;
+                                     auto value = cache.getOrLoad<int>(std::to_string(key), [key](size_t &charge)
+                                                                       {
+                                                                           charge = 100;
+                                                                           return std::make_shared<const int>(key); });
+                                     ASSERT_EQ(*value, key);
+                                 } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    MetadataCacheStats stats = cache.stats();
+    EXPECT_EQ(stats.hits + stats.misses, 8000u);
+    EXPECT_LE(stats.bytes, cache.capacity());
+}
+
+TEST(MetadataCacheTest, SharesFootersAndBloomFiltersBetweenOpens)
+{
+    std::string path = writeTestFile("metadata_cache.parquet");
+    auto cache = std::make_shared<MetadataCache>(1 << 20);
+
+    auto file = std::make_shared<CountingFile>(path, "v1");
+    ParquetFileReader first(file, cache);
+    EXPECT_EQ(file->reads.load(), 1);
+    auto filter = first.bloomFilter(1, 0);
+    ASSERT_NE(filter, nullptr);
+    EXPECT_EQ(file->reads.load(), 2);
+    for (int64_t id = 1000; id < 2000; ++id)
+    {
+        ASSERT_TRUE(filter->mightContain(BloomFilter::hash(id)));
+    }
+    EXPECT_FALSE(filter->mightContain(BloomFilter::hash(int64_t{5000})) &&
+                 filter->mightContain(BloomFilter::hash(int64_t{5001})) &&
+                 filter->mightContain(BloomFilter::hash(int64_t{5002})));
+    auto names = first.bloomFilter(0, 1);
+    ASSERT_NE(names, nullptr);
+    EXPECT_TRUE(names->mightContain(BloomFilter::hash(std::string_view("name-1"))));
+    EXPECT_EQ(first.columnIndex(0, 0), nullptr);
+    EXPECT_EQ(first.offsetIndex(0, 0), nullptr);
+
+    // Same path, size and version: nothing is read
+    auto again = std::make_shared<CountingFile>(path, "v1");
+    ParquetFileReader second(again, cache);
+    EXPECT_EQ(&second.metadata(), &first.metadata());
+    EXPECT_EQ(second.bloomFilter(1, 0), filter);
+    EXPECT_EQ(again->reads.load(), 0);
+
+    // A new version is a miss
+    auto changed = std::make_shared<CountingFile>(path, "v2");
+    ParquetFileReader third(changed, cache);
+    EXPECT_EQ(changed->reads.load(), 1);
+    EXPECT_NE(&third.metadata(), &first.metadata());
+    std::remove(path.c_str());
+}
+
+TEST(MetadataCacheTest, ReadsPageIndexes)
+{
+    std::string path = writeTestFile("page_index.parquet");
+    std::ifstream stream(path, std::ios::binary);
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    stream.close();
+
+    // Splice a page index in front of the footer, as writers place it
+    FileMetaData metadata;
+    {
+        ParquetFileReader reader(path);
+        metadata = reader.metadata();
+    }
+    uint32_t footer_length;
+    std::memcpy(&footer_length, bytes.data() + bytes.size() - 8, 4);
+    bytes.resize(bytes.size() - 8 - footer_length);
+
+    ColumnIndex column_index;
+    column_index.null_pages = {false};
+    column_index.min_values = {std::string(8, '\0')};
+    column_index.max_values = {std::string(8, '\x7f')};
+    column_index.boundary_order = BoundaryOrder::ASCENDING;
+    column_index.null_counts = {0};
+    OffsetIndex offset_index;
+    ColumnChunk &chunk = metadata.row_groups[0].columns[0];
+    offset_index.page_locations = {{chunk.meta_data->data_page_offset,
+                                    static_cast<int32_t>(chunk.meta_data->total_compressed_size), 0}};
+    std::vector<uint8_t> column_index_bytes = serializeThrift(column_index);
+    std::vector<uint8_t> offset_index_bytes = serializeThrift(offset_index);
+    chunk.column_index_offset = static_cast<int64_t>(bytes.size());
+    chunk.column_index_length = static_cast<int32_t>(column_index_bytes.size());
+    bytes.insert(bytes.end(), column_index_bytes.begin(), column_index_bytes.end());
+    chunk.offset_index_offset = static_cast<int64_t>(bytes.size());
+    chunk.offset_index_length = static_cast<int32_t>(offset_index_bytes.size());
+    bytes.insert(bytes.end(), offset_index_bytes.begin(), offset_index_bytes.end());
+    std::vector<uint8_t> footer = serializeThrift(metadata);
+    bytes.insert(bytes.end(), footer.begin(), footer.end());
+    footer_length = static_cast<uint32_t>(footer.size());
+    const auto *length_bytes = reinterpret_cast<const uint8_t *>(&footer_length);
+    bytes.insert(bytes.end(), length_bytes, length_bytes + 4);
+    bytes.insert(bytes.end(), {'P', 'A', 'R', '1'});
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char *>(bytes.data()),
+                                                                  static_cast<std::streamsize>(bytes.size()));
+
+    auto cache = std::make_shared<MetadataCache>(1 << 20);
+    ParquetFileReader reader(std::make_shared<LocalFile>(path), cache);
+    auto index = reader.columnIndex(0, 0);
+    ASSERT_NE(index, nullptr);
+    EXPECT_EQ(index->boundary_order, BoundaryOrder::ASCENDING);
+    EXPECT_EQ(index->max_values, column_index.max_values);
+    EXPECT_EQ(index->null_pages, std::vector<bool>{false});
+    auto offsets = reader.offsetIndex(0, 0);
+    ASSERT_NE(offsets, nullptr);
+    ASSERT_EQ(offsets->page_locations.size(), 1u);
+    EXPECT_EQ(offsets->page_locations[0].offset, chunk.meta_data->data_page_offset);
+    EXPECT_EQ(reader.columnIndex(0, 0), index);
+    EXPECT_EQ(reader.columnIndex(1, 0), nullptr);
+    EXPECT_GE(cache->stats().hits, 1u);
+    std::remove(path.c_str());
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <stdexcept>
 #include <string>
 
 // Parquet file format specification:
@@ -18,4 +19,32 @@ enum class AtomicType
     DOUBLE,
     BYTE_ARRAY,
     FIXED_LEN_BYTE_ARRAY
-};
\ No newline at end of file
+};
+
+/**
+ * The encodings supported by Parquet. The numeric values match the `Encoding` enum in
+ * parquet.thrift so they can be read from and written to the file metadata as is.
+ */
+enum class Encoding
+{
+    PLAIN = 0,
+    PLAIN_DICTIONARY = 2,
+    RLE = 3,
+    BIT_PACKED = 4,
+    DELTA_BINARY_PACKED = 5,
+    DELTA_LENGTH_BYTE_ARRAY = 6,
+    DELTA_BYTE_ARRAY = 7,
+    RLE_DICTIONARY = 8,
+    BYTE_STREAM_SPLIT = 9
+};
+
+/**
+ * Thrown when a Parquet file or page cannot be decoded (truncated input, invalid
+ * headers, unsupported encodings and so on).
+ */
+class ParquetException : public std::runtime_error
+{
+public:
+    explicit ParquetException(const std::string &message)
+        : std::runtime_error(message) {}
+};
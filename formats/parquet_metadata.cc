@@ -0,0 +1,1426 @@
+#include "parquet_metadata.hpp"
+
+#include <functional>
+
+using thrift::CompactProtocolReader;
+using thrift::CompactProtocolWriter;
+using thrift::CompactType;
+
+namespace
+{
+    void checkType(CompactType actual, CompactType expected)
+    {
+        bool both_bool = (actual == CompactType::BOOLEAN_TRUE || actual == CompactType::BOOLEAN_FALSE) &&
+                         (expected == CompactType::BOOLEAN_TRUE || expected == CompactType::BOOLEAN_FALSE);
+        if (actual != expected && !both_bool)
+        {
+            throw thrift::ProtocolException("Unexpected field type " + std::to_string(static_cast<int>(actual)));
+        }
+    }
+
+    template <typename T>
+    void readList(CompactProtocolReader &reader, std::vector<T> &out, const std::function<T()> &read_element)
+    {
+        auto [element_type, size] = reader.readListBegin();
+        (void)element_type;
+        out.clear();
+        out.reserve(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            out.push_back(read_element());
+        }
+    }
+
+    template <typename T>
+    void readStructList(CompactProtocolReader &reader, std::vector<T> &out)
+    {
+        readList<T>(reader, out, [&reader]()
+                    {
+                        T value;
+                        value.read(reader);
+                        return value; });
+    }
+
+    template <typename T>
+    void writeStructList(CompactProtocolWriter &writer, int16_t id, const std::vector<T> &values)
+    {
+        writer.writeFieldBegin(id, CompactType::LIST);
+        writer.writeListBegin(CompactType::STRUCT, values.size());
+        for (const auto &value : values)
+        {
+            value.write(writer);
+        }
+    }
+
+    void writeI64List(CompactProtocolWriter &writer, int16_t id, const std::vector<int64_t> &values)
+    {
+        writer.writeFieldBegin(id, CompactType::LIST);
+        writer.writeListBegin(CompactType::I64, values.size());
+        for (int64_t value : values)
+        {
+            writer.writeI64(value);
+        }
+    }
+
+    void writeOptionalBinary(CompactProtocolWriter &writer, int16_t id, const std::optional<std::string> &value)
+    {
+        if (value)
+        {
+            writer.writeFieldBegin(id, CompactType::BINARY);
+            writer.writeBinary(*value);
+        }
+    }
+
+    void writeOptionalI32(CompactProtocolWriter &writer, int16_t id, const std::optional<int32_t> &value)
+    {
+        if (value)
+        {
+            writer.writeFieldBegin(id, CompactType::I32);
+            writer.writeI32(*value);
+        }
+    }
+
+    void writeOptionalI64(CompactProtocolWriter &writer, int16_t id, const std::optional<int64_t> &value)
+    {
+        if (value)
+        {
+            writer.writeFieldBegin(id, CompactType::I64);
+            writer.writeI64(*value);
+        }
+    }
+
+    template <typename T>
+    void writeOptionalStruct(CompactProtocolWriter &writer, int16_t id, const std::optional<T> &value)
+    {
+        if (value)
+        {
+            writer.writeFieldBegin(id, CompactType::STRUCT);
+            value->write(writer);
+        }
+    }
+} // namespace
+
+int32_t toThriftType(AtomicType type)
+{
+    switch (type)
+    {
+    case AtomicType::BOOLEAN:
+        return 0;
+    case AtomicType::INT32:
+        return 1;
+    case AtomicType::INT64:
+        return 2;
+    case AtomicType::FLOAT:
+        return 4;
+    case AtomicType::DOUBLE:
+        return 5;
+    case AtomicType::BYTE_ARRAY:
+        return 6;
+    case AtomicType::FIXED_LEN_BYTE_ARRAY:
+        return 7;
+    }
+    throw ParquetException("Unknown atomic type");
+}
+
+AtomicType fromThriftType(int32_t type)
+{
+    switch (type)
+    {
+    case 0:
+        return AtomicType::BOOLEAN;
+    case 1:
+        return AtomicType::INT32;
+    case 2:
+        return AtomicType::INT64;
+    case 3:
+        throw ParquetException("INT96 columns are not supported");
+    case 4:
+        return AtomicType::FLOAT;
+    case 5:
+        return AtomicType::DOUBLE;
+    case 6:
+        return AtomicType::BYTE_ARRAY;
+    case 7:
+        return AtomicType::FIXED_LEN_BYTE_ARRAY;
+    default:
+        throw ParquetException("Unknown physical type " + std::to_string(type));
+    }
+}
+
+void KeyValue::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::BINARY);
+            key = reader.readBinary();
+            break;
+        case 2:
+            checkType(type, CompactType::BINARY);
+            value = reader.readBinary();
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void KeyValue::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::BINARY);
+    writer.writeBinary(key);
+    writeOptionalBinary(writer, 2, value);
+    writer.writeStructEnd();
+}
+
+void Statistics::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::BINARY);
+            max = reader.readBinary();
+            break;
+        case 2:
+            checkType(type, CompactType::BINARY);
+            min = reader.readBinary();
+            break;
+        case 3:
+            checkType(type, CompactType::I64);
+            null_count = reader.readI64();
+            break;
+        case 4:
+            checkType(type, CompactType::I64);
+            distinct_count = reader.readI64();
+            break;
+        case 5:
+            checkType(type, CompactType::BINARY);
+            max_value = reader.readBinary();
+            break;
+        case 6:
+            checkType(type, CompactType::BINARY);
+            min_value = reader.readBinary();
+            break;
+        case 7:
+            checkType(type, CompactType::BOOLEAN_TRUE);
+            is_max_value_exact = CompactProtocolReader::readBool(type);
+            break;
+        case 8:
+            checkType(type, CompactType::BOOLEAN_TRUE);
+            is_min_value_exact = CompactProtocolReader::readBool(type);
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void Statistics::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writeOptionalBinary(writer, 1, max);
+    writeOptionalBinary(writer, 2, min);
+    writeOptionalI64(writer, 3, null_count);
+    writeOptionalI64(writer, 4, distinct_count);
+    writeOptionalBinary(writer, 5, max_value);
+    writeOptionalBinary(writer, 6, min_value);
+    if (is_max_value_exact)
+    {
+        writer.writeBoolField(7, *is_max_value_exact);
+    }
+    if (is_min_value_exact)
+    {
+        writer.writeBoolField(8, *is_min_value_exact);
+    }
+    writer.writeStructEnd();
+}
+
+void SizeStatistics::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::I64);
+            unencoded_byte_array_data_bytes = reader.readI64();
+            break;
+        case 2:
+            checkType(type, CompactType::LIST);
+            readList<int64_t>(reader, repetition_level_histogram, [&reader]()
+                              { return reader.readI64(); });
+            break;
+        case 3:
+            checkType(type, CompactType::LIST);
+            readList<int64_t>(reader, definition_level_histogram, [&reader]()
+                              { return reader.readI64(); });
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void SizeStatistics::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writeOptionalI64(writer, 1, unencoded_byte_array_data_bytes);
+    if (!repetition_level_histogram.empty())
+    {
+        writeI64List(writer, 2, repetition_level_histogram);
+    }
+    if (!definition_level_histogram.empty())
+    {
+        writeI64List(writer, 3, definition_level_histogram);
+    }
+    writer.writeStructEnd();
+}
+
+void SchemaElement::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type_id;
+    while (reader.readFieldBegin(id, type_id))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type_id, CompactType::I32);
+            type = fromThriftType(reader.readI32());
+            break;
+        case 2:
+            checkType(type_id, CompactType::I32);
+            type_length = reader.readI32();
+            break;
+        case 3:
+            checkType(type_id, CompactType::I32);
+            repetition_type = static_cast<FieldRepetitionType>(reader.readI32());
+            break;
+        case 4:
+            checkType(type_id, CompactType::BINARY);
+            name = reader.readBinary();
+            break;
+        case 5:
+            checkType(type_id, CompactType::I32);
+            num_children = reader.readI32();
+            break;
+        case 6:
+            checkType(type_id, CompactType::I32);
+            converted_type = reader.readI32();
+            break;
+        case 7:
+            checkType(type_id, CompactType::I32);
+            scale = reader.readI32();
+            break;
+        case 8:
+            checkType(type_id, CompactType::I32);
+            precision = reader.readI32();
+            break;
+        case 9:
+            checkType(type_id, CompactType::I32);
+            field_id = reader.readI32();
+            break;
+        default:
+            reader.skip(type_id);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void SchemaElement::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    if (type)
+    {
+        writer.writeFieldBegin(1, CompactType::I32);
+        writer.writeI32(toThriftType(*type));
+    }
+    writeOptionalI32(writer, 2, type_length);
+    if (repetition_type)
+    {
+        writer.writeFieldBegin(3, CompactType::I32);
+        writer.writeI32(static_cast<int32_t>(*repetition_type));
+    }
+    writer.writeFieldBegin(4, CompactType::BINARY);
+    writer.writeBinary(name);
+    writeOptionalI32(writer, 5, num_children);
+    writeOptionalI32(writer, 6, converted_type);
+    writeOptionalI32(writer, 7, scale);
+    writeOptionalI32(writer, 8, precision);
+    writeOptionalI32(writer, 9, field_id);
+    writer.writeStructEnd();
+}
+
+void DataPageHeader::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::I32);
+            num_values = reader.readI32();
+            break;
+        case 2:
+            checkType(type, CompactType::I32);
+            encoding = static_cast<Encoding>(reader.readI32());
+            break;
+        case 3:
+            checkType(type, CompactType::I32);
+            definition_level_encoding = static_cast<Encoding>(reader.readI32());
+            break;
+        case 4:
+            checkType(type, CompactType::I32);
+            repetition_level_encoding = static_cast<Encoding>(reader.readI32());
+            break;
+        case 5:
+            checkType(type, CompactType::STRUCT);
+            statistics.emplace().read(reader);
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void DataPageHeader::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(num_values);
+    writer.writeFieldBegin(2, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(encoding));
+    writer.writeFieldBegin(3, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(definition_level_encoding));
+    writer.writeFieldBegin(4, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(repetition_level_encoding));
+    writeOptionalStruct(writer, 5, statistics);
+    writer.writeStructEnd();
+}
+
+void DictionaryPageHeader::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::I32);
+            num_values = reader.readI32();
+            break;
+        case 2:
+            checkType(type, CompactType::I32);
+            encoding = static_cast<Encoding>(reader.readI32());
+            break;
+        case 3:
+            checkType(type, CompactType::BOOLEAN_TRUE);
+            is_sorted = CompactProtocolReader::readBool(type);
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void DictionaryPageHeader::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(num_values);
+    writer.writeFieldBegin(2, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(encoding));
+    if (is_sorted)
+    {
+        writer.writeBoolField(3, *is_sorted);
+    }
+    writer.writeStructEnd();
+}
+
+void DataPageHeaderV2::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::I32);
+            num_values = reader.readI32();
+            break;
+        case 2:
+            checkType(type, CompactType::I32);
+            num_nulls = reader.readI32();
+            break;
+        case 3:
+            checkType(type, CompactType::I32);
+            num_rows = reader.readI32();
+            break;
+        case 4:
+            checkType(type, CompactType::I32);
+            encoding = static_cast<Encoding>(reader.readI32());
+            break;
+        case 5:
+            checkType(type, CompactType::I32);
+            definition_levels_byte_length = reader.readI32();
+            break;
+        case 6:
+            checkType(type, CompactType::I32);
+            repetition_levels_byte_length = reader.readI32();
+            break;
+        case 7:
+            checkType(type, CompactType::BOOLEAN_TRUE);
+            is_compressed = CompactProtocolReader::readBool(type);
+            break;
+        case 8:
+            checkType(type, CompactType::STRUCT);
+            statistics.emplace().read(reader);
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void DataPageHeaderV2::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(num_values);
+    writer.writeFieldBegin(2, CompactType::I32);
+    writer.writeI32(num_nulls);
+    writer.writeFieldBegin(3, CompactType::I32);
+    writer.writeI32(num_rows);
+    writer.writeFieldBegin(4, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(encoding));
+    writer.writeFieldBegin(5, CompactType::I32);
+    writer.writeI32(definition_levels_byte_length);
+    writer.writeFieldBegin(6, CompactType::I32);
+    writer.writeI32(repetition_levels_byte_length);
+    writer.writeBoolField(7, is_compressed);
+    writeOptionalStruct(writer, 8, statistics);
+    writer.writeStructEnd();
+}
+
+void PageHeader::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type_id;
+    while (reader.readFieldBegin(id, type_id))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type_id, CompactType::I32);
+            type = static_cast<PageType>(reader.readI32());
+            break;
+        case 2:
+            checkType(type_id, CompactType::I32);
+            uncompressed_page_size = reader.readI32();
+            break;
+        case 3:
+            checkType(type_id, CompactType::I32);
+            compressed_page_size = reader.readI32();
+            break;
+        case 4:
+            checkType(type_id, CompactType::I32);
+            crc = reader.readI32();
+            break;
+        case 5:
+            checkType(type_id, CompactType::STRUCT);
+            data_page_header.emplace().read(reader);
+            break;
+        case 7:
+            checkType(type_id, CompactType::STRUCT);
+            dictionary_page_header.emplace().read(reader);
+            break;
+        case 8:
+            checkType(type_id, CompactType::STRUCT);
+            data_page_header_v2.emplace().read(reader);
+            break;
+        default:
+            reader.skip(type_id);
+        }
+    }
+    reader.readStructEnd();
+    if (uncompressed_page_size < 0 || compressed_page_size < 0)
+    {
+        throw thrift::ProtocolException("Negative page size");
+    }
+}
+
+void PageHeader::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(type));
+    writer.writeFieldBegin(2, CompactType::I32);
+    writer.writeI32(uncompressed_page_size);
+    writer.writeFieldBegin(3, CompactType::I32);
+    writer.writeI32(compressed_page_size);
+    writeOptionalI32(writer, 4, crc);
+    writeOptionalStruct(writer, 5, data_page_header);
+    writeOptionalStruct(writer, 7, dictionary_page_header);
+    writeOptionalStruct(writer, 8, data_page_header_v2);
+    writer.writeStructEnd();
+}
+
+void ColumnMetaData::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type_id;
+    while (reader.readFieldBegin(id, type_id))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type_id, CompactType::I32);
+            type = fromThriftType(reader.readI32());
+            break;
+        case 2:
+            checkType(type_id, CompactType::LIST);
+            readList<Encoding>(reader, encodings, [&reader]()
+                               { return static_cast<Encoding>(reader.readI32()); });
+            break;
+        case 3:
+            checkType(type_id, CompactType::LIST);
+            readList<std::string>(reader, path_in_schema, [&reader]()
+                                  { return reader.readBinary(); });
+            break;
+        case 4:
+            checkType(type_id, CompactType::I32);
+            codec = static_cast<CompressionCodec>(reader.readI32());
+            break;
+        case 5:
+            checkType(type_id, CompactType::I64);
+            num_values = reader.readI64();
+            break;
+        case 6:
+            checkType(type_id, CompactType::I64);
+            total_uncompressed_size = reader.readI64();
+            break;
+        case 7:
+            checkType(type_id, CompactType::I64);
+            total_compressed_size = reader.readI64();
+            break;
+        case 9:
+            checkType(type_id, CompactType::I64);
+            data_page_offset = reader.readI64();
+            break;
+        case 11:
+            checkType(type_id, CompactType::I64);
+            dictionary_page_offset = reader.readI64();
+            break;
+        case 12:
+            checkType(type_id, CompactType::STRUCT);
+            statistics.emplace().read(reader);
+            break;
+        case 14:
+            checkType(type_id, CompactType::I64);
+            bloom_filter_offset = reader.readI64();
+            break;
+        case 15:
+            checkType(type_id, CompactType::I32);
+            bloom_filter_length = reader.readI32();
+            break;
+        case 16:
+            checkType(type_id, CompactType::STRUCT);
+            size_statistics.emplace().read(reader);
+            break;
+        default:
+            reader.skip(type_id);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void ColumnMetaData::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(toThriftType(type));
+    writer.writeFieldBegin(2, CompactType::LIST);
+    writer.writeListBegin(CompactType::I32, encodings.size());
+    for (Encoding encoding : encodings)
+    {
+        writer.writeI32(static_cast<int32_t>(encoding));
+    }
+    writer.writeFieldBegin(3, CompactType::LIST);
+    writer.writeListBegin(CompactType::BINARY, path_in_schema.size());
+    for (const auto &name : path_in_schema)
+    {
+        writer.writeBinary(name);
+    }
+    writer.writeFieldBegin(4, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(codec));
+    writer.writeFieldBegin(5, CompactType::I64);
+    writer.writeI64(num_values);
+    writer.writeFieldBegin(6, CompactType::I64);
+    writer.writeI64(total_uncompressed_size);
+    writer.writeFieldBegin(7, CompactType::I64);
+    writer.writeI64(total_compressed_size);
+    writer.writeFieldBegin(9, CompactType::I64);
+    writer.writeI64(data_page_offset);
+    writeOptionalI64(writer, 11, dictionary_page_offset);
+    writeOptionalStruct(writer, 12, statistics);
+    writeOptionalI64(writer, 14, bloom_filter_offset);
+    writeOptionalI32(writer, 15, bloom_filter_length);
+    writeOptionalStruct(writer, 16, size_statistics);
+    writer.writeStructEnd();
+}
+
+void AesGcmV1::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::BINARY);
+            aad_prefix = reader.readBinary();
+            break;
+        case 2:
+            checkType(type, CompactType::BINARY);
+            aad_file_unique = reader.readBinary();
+            break;
+        case 3:
+            checkType(type, CompactType::BOOLEAN_TRUE);
+            supply_aad_prefix = CompactProtocolReader::readBool(type);
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void AesGcmV1::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writeOptionalBinary(writer, 1, aad_prefix);
+    writeOptionalBinary(writer, 2, aad_file_unique);
+    if (supply_aad_prefix)
+    {
+        writer.writeBoolField(3, *supply_aad_prefix);
+    }
+    writer.writeStructEnd();
+}
+
+void EncryptionAlgorithm::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::STRUCT);
+            AES_GCM_V1.emplace().read(reader);
+            break;
+        case 2:
+            checkType(type, CompactType::STRUCT);
+            AES_GCM_CTR_V1.emplace().read(reader);
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+    if (AES_GCM_V1.has_value() == AES_GCM_CTR_V1.has_value())
+    {
+        throw thrift::ProtocolException("Unsupported encryption algorithm");
+    }
+}
+
+void EncryptionAlgorithm::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writeOptionalStruct(writer, 1, AES_GCM_V1);
+    writeOptionalStruct(writer, 2, AES_GCM_CTR_V1);
+    writer.writeStructEnd();
+}
+
+void FileCryptoMetaData::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    bool has_algorithm = false;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::STRUCT);
+            encryption_algorithm.read(reader);
+            has_algorithm = true;
+            break;
+        case 2:
+            checkType(type, CompactType::BINARY);
+            key_metadata = reader.readBinary();
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+    if (!has_algorithm)
+    {
+        throw thrift::ProtocolException("File crypto metadata misses the encryption algorithm");
+    }
+}
+
+void FileCryptoMetaData::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::STRUCT);
+    encryption_algorithm.write(writer);
+    writeOptionalBinary(writer, 2, key_metadata);
+    writer.writeStructEnd();
+}
+
+void EncryptionWithColumnKey::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::LIST);
+            readList<std::string>(reader, path_in_schema, [&reader]()
+                                  { return reader.readBinary(); });
+            break;
+        case 2:
+            checkType(type, CompactType::BINARY);
+            key_metadata = reader.readBinary();
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void EncryptionWithColumnKey::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::LIST);
+    writer.writeListBegin(CompactType::BINARY, path_in_schema.size());
+    for (const auto &name : path_in_schema)
+    {
+        writer.writeBinary(name);
+    }
+    writeOptionalBinary(writer, 2, key_metadata);
+    writer.writeStructEnd();
+}
+
+void ColumnCryptoMetaData::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    bool found = false;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::STRUCT);
+            reader.skip(type);
+            found = true;
+            break;
+        case 2:
+            checkType(type, CompactType::STRUCT);
+            ENCRYPTION_WITH_COLUMN_KEY.emplace().read(reader);
+            found = true;
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+    if (!found)
+    {
+        throw thrift::ProtocolException("Unsupported column encryption");
+    }
+}
+
+void ColumnCryptoMetaData::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    if (ENCRYPTION_WITH_COLUMN_KEY)
+    {
+        writeOptionalStruct(writer, 2, ENCRYPTION_WITH_COLUMN_KEY);
+    }
+    else
+    {
+        writer.writeFieldBegin(1, CompactType::STRUCT);
+        writer.writeStructBegin();
+        writer.writeStructEnd();
+    }
+    writer.writeStructEnd();
+}
+
+void ColumnChunk::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::BINARY);
+            file_path = reader.readBinary();
+            break;
+        case 2:
+            checkType(type, CompactType::I64);
+            file_offset = reader.readI64();
+            break;
+        case 3:
+            checkType(type, CompactType::STRUCT);
+            meta_data.emplace().read(reader);
+            break;
+        case 4:
+            checkType(type, CompactType::I64);
+            offset_index_offset = reader.readI64();
+            break;
+        case 5:
+            checkType(type, CompactType::I32);
+            offset_index_length = reader.readI32();
+            break;
+        case 6:
+            checkType(type, CompactType::I64);
+            column_index_offset = reader.readI64();
+            break;
+        case 7:
+            checkType(type, CompactType::I32);
+            column_index_length = reader.readI32();
+            break;
+        case 8:
+            checkType(type, CompactType::STRUCT);
+            crypto_metadata.emplace().read(reader);
+            break;
+        case 9:
+            checkType(type, CompactType::BINARY);
+            encrypted_column_metadata = reader.readBinary();
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void ColumnChunk::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writeOptionalBinary(writer, 1, file_path);
+    writer.writeFieldBegin(2, CompactType::I64);
+    writer.writeI64(file_offset);
+    writeOptionalStruct(writer, 3, meta_data);
+    writeOptionalI64(writer, 4, offset_index_offset);
+    writeOptionalI32(writer, 5, offset_index_length);
+    writeOptionalI64(writer, 6, column_index_offset);
+    writeOptionalI32(writer, 7, column_index_length);
+    writeOptionalStruct(writer, 8, crypto_metadata);
+    writeOptionalBinary(writer, 9, encrypted_column_metadata);
+    writer.writeStructEnd();
+}
+
+void RowGroup::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::LIST);
+            readStructList(reader, columns);
+            break;
+        case 2:
+            checkType(type, CompactType::I64);
+            total_byte_size = reader.readI64();
+            break;
+        case 3:
+            checkType(type, CompactType::I64);
+            num_rows = reader.readI64();
+            break;
+        case 5:
+            checkType(type, CompactType::I64);
+            file_offset = reader.readI64();
+            break;
+        case 6:
+            checkType(type, CompactType::I64);
+            total_compressed_size = reader.readI64();
+            break;
+        case 7:
+            checkType(type, CompactType::I16);
+            ordinal = reader.readI16();
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void RowGroup::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writeStructList(writer, 1, columns);
+    writer.writeFieldBegin(2, CompactType::I64);
+    writer.writeI64(total_byte_size);
+    writer.writeFieldBegin(3, CompactType::I64);
+    writer.writeI64(num_rows);
+    writeOptionalI64(writer, 5, file_offset);
+    writeOptionalI64(writer, 6, total_compressed_size);
+    if (ordinal)
+    {
+        writer.writeFieldBegin(7, CompactType::I16);
+        writer.writeI16(*ordinal);
+    }
+    writer.writeStructEnd();
+}
+
+void FileMetaData::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::I32);
+            version = reader.readI32();
+            break;
+        case 2:
+            checkType(type, CompactType::LIST);
+            readStructList(reader, schema);
+            break;
+        case 3:
+            checkType(type, CompactType::I64);
+            num_rows = reader.readI64();
+            break;
+        case 4:
+            checkType(type, CompactType::LIST);
+            readStructList(reader, row_groups);
+            break;
+        case 5:
+            checkType(type, CompactType::LIST);
+            readStructList(reader, key_value_metadata);
+            break;
+        case 6:
+            checkType(type, CompactType::BINARY);
+            created_by = reader.readBinary();
+            break;
+        case 8:
+            checkType(type, CompactType::STRUCT);
+            encryption_algorithm.emplace().read(reader);
+            break;
+        case 9:
+            checkType(type, CompactType::BINARY);
+            footer_signing_key_metadata = reader.readBinary();
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void FileMetaData::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(version);
+    writeStructList(writer, 2, schema);
+    writer.writeFieldBegin(3, CompactType::I64);
+    writer.writeI64(num_rows);
+    writeStructList(writer, 4, row_groups);
+    if (!key_value_metadata.empty())
+    {
+        writeStructList(writer, 5, key_value_metadata);
+    }
+    writeOptionalBinary(writer, 6, created_by);
+    writeOptionalStruct(writer, 8, encryption_algorithm);
+    writeOptionalBinary(writer, 9, footer_signing_key_metadata);
+    writer.writeStructEnd();
+}
+
+void PageLocation::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::I64);
+            offset = reader.readI64();
+            break;
+        case 2:
+            checkType(type, CompactType::I32);
+            compressed_page_size = reader.readI32();
+            break;
+        case 3:
+            checkType(type, CompactType::I64);
+            first_row_index = reader.readI64();
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void PageLocation::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I64);
+    writer.writeI64(offset);
+    writer.writeFieldBegin(2, CompactType::I32);
+    writer.writeI32(compressed_page_size);
+    writer.writeFieldBegin(3, CompactType::I64);
+    writer.writeI64(first_row_index);
+    writer.writeStructEnd();
+}
+
+void OffsetIndex::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::LIST);
+            readStructList(reader, page_locations);
+            break;
+        case 2:
+            checkType(type, CompactType::LIST);
+            readList<int64_t>(reader, unencoded_byte_array_data_bytes, [&reader]()
+                              { return reader.readI64(); });
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void OffsetIndex::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writeStructList(writer, 1, page_locations);
+    if (!unencoded_byte_array_data_bytes.empty())
+    {
+        writeI64List(writer, 2, unencoded_byte_array_data_bytes);
+    }
+    writer.writeStructEnd();
+}
+
+void ColumnIndex::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+        {
+            checkType(type, CompactType::LIST);
+            auto [element_type, size] = reader.readListBegin();
+            (void)element_type;
+            null_pages.clear();
+            for (size_t i = 0; i < size; ++i)
+            {
+                null_pages.push_back(reader.readBoolElement());
+            }
+            break;
+        }
+        case 2:
+            checkType(type, CompactType::LIST);
+            readList<std::string>(reader, min_values, [&reader]()
+                                  { return reader.readBinary(); });
+            break;
+        case 3:
+            checkType(type, CompactType::LIST);
+            readList<std::string>(reader, max_values, [&reader]()
+                                  { return reader.readBinary(); });
+            break;
+        case 4:
+            checkType(type, CompactType::I32);
+            boundary_order = static_cast<BoundaryOrder>(reader.readI32());
+            break;
+        case 5:
+            checkType(type, CompactType::LIST);
+            readList<int64_t>(reader, null_counts, [&reader]()
+                              { return reader.readI64(); });
+            break;
+        case 6:
+            checkType(type, CompactType::LIST);
+            readList<int64_t>(reader, repetition_level_histograms, [&reader]()
+                              { return reader.readI64(); });
+            break;
+        case 7:
+            checkType(type, CompactType::LIST);
+            readList<int64_t>(reader, definition_level_histograms, [&reader]()
+                              { return reader.readI64(); });
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+}
+
+void ColumnIndex::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::LIST);
+    writer.writeListBegin(CompactType::BOOLEAN_TRUE, null_pages.size());
+    for (bool null_page : null_pages)
+    {
+        writer.writeBoolElement(null_page);
+    }
+    for (int16_t field : {2, 3})
+    {
+        const std::vector<std::string> &values = field == 2 ? min_values : max_values;
+        writer.writeFieldBegin(field, CompactType::LIST);
+        writer.writeListBegin(CompactType::BINARY, values.size());
+        for (const std::string &value : values)
+        {
+            writer.writeBinary(value);
+        }
+    }
+    writer.writeFieldBegin(4, CompactType::I32);
+    writer.writeI32(static_cast<int32_t>(boundary_order));
+    if (!null_counts.empty())
+    {
+        writeI64List(writer, 5, null_counts);
+    }
+    if (!repetition_level_histograms.empty())
+    {
+        writeI64List(writer, 6, repetition_level_histograms);
+    }
+    if (!definition_level_histograms.empty())
+    {
+        writeI64List(writer, 7, definition_level_histograms);
+    }
+    writer.writeStructEnd();
+}
+
+namespace
+{
+    // Reads a union of empty structs and fails unless member `expected` is set
+    void readEmptyUnion(CompactProtocolReader &reader, int16_t expected, const char *what)
+    {
+        reader.readStructBegin();
+        int16_t id;
+        CompactType type;
+        bool found = false;
+        while (reader.readFieldBegin(id, type))
+        {
+            found = found || (id == expected && type == CompactType::STRUCT);
+            reader.skip(type);
+        }
+        reader.readStructEnd();
+        if (!found)
+        {
+            throw thrift::ProtocolException(std::string("Unsupported Bloom filter ") + what);
+        }
+    }
+
+    void writeEmptyUnion(CompactProtocolWriter &writer, int16_t id)
+    {
+        writer.writeFieldBegin(id, CompactType::STRUCT);
+        writer.writeStructBegin();
+        writer.writeFieldBegin(1, CompactType::STRUCT);
+        writer.writeStructBegin();
+        writer.writeStructEnd();
+        writer.writeStructEnd();
+    }
+} // namespace
+
+void BloomFilterHeader::read(CompactProtocolReader &reader)
+{
+    reader.readStructBegin();
+    int16_t id;
+    CompactType type;
+    bool algorithm = false, hash = false, compression = false;
+    while (reader.readFieldBegin(id, type))
+    {
+        switch (id)
+        {
+        case 1:
+            checkType(type, CompactType::I32);
+            num_bytes = reader.readI32();
+            break;
+        case 2:
+            checkType(type, CompactType::STRUCT);
+            readEmptyUnion(reader, 1, "algorithm");
+            algorithm = true;
+            break;
+        case 3:
+            checkType(type, CompactType::STRUCT);
+            readEmptyUnion(reader, 1, "hash");
+            hash = true;
+            break;
+        case 4:
+            checkType(type, CompactType::STRUCT);
+            readEmptyUnion(reader, 1, "compression");
+            compression = true;
+            break;
+        default:
+            reader.skip(type);
+        }
+    }
+    reader.readStructEnd();
+    if (!algorithm || !hash || !compression)
+    {
+        throw thrift::ProtocolException("Bloom filter header misses required fields");
+    }
+}
+
+void BloomFilterHeader::write(CompactProtocolWriter &writer) const
+{
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(num_bytes);
+    writeEmptyUnion(writer, 2);
+    writeEmptyUnion(writer, 3);
+    writeEmptyUnion(writer, 4);
+    writer.writeStructEnd();
+}
+
+std::string ColumnDescriptor::dottedPath() const
+{
+    std::string dotted;
+    for (const auto &name : path)
+    {
+        if (!dotted.empty())
+        {
+            dotted += '.';
+        }
+        dotted += name;
+    }
+    return dotted;
+}
+
+namespace
+{
+    void collectLeaves(const std::vector<SchemaElement> &schema, size_t &index, std::vector<std::string> &path,
+                       int16_t definition_level, int16_t repetition_level, std::vector<ColumnDescriptor> &out)
+    {
+        if (index >= schema.size())
+        {
+            throw ParquetException("Schema has fewer elements than its num_children claim");
+        }
+        const SchemaElement &element = schema[index++];
+        FieldRepetitionType repetition = element.repetition_type.value_or(FieldRepetitionType::REQUIRED);
+        if (repetition != FieldRepetitionType::REQUIRED)
+        {
+            ++definition_level;
+        }
+        if (repetition == FieldRepetitionType::REPEATED)
+        {
+            ++repetition_level;
+        }
+
+        path.push_back(element.name);
+        if (element.num_children.value_or(0) > 0)
+        {
+            for (int32_t i = 0; i < *element.num_children; ++i)
+            {
+                collectLeaves(schema, index, path, definition_level, repetition_level, out);
+            }
+        }
+        else
+        {
+            if (!element.type)
+            {
+                throw ParquetException("Leaf column " + element.name + " has no type");
+            }
+            ColumnDescriptor column;
+            column.path = path;
+            column.type = *element.type;
+            column.type_length = element.type_length.value_or(0);
+            column.max_definition_level = definition_level;
+            column.max_repetition_level = repetition_level;
+            out.push_back(std::move(column));
+        }
+        path.pop_back();
+    }
+} // namespace
+
+std::vector<ColumnDescriptor> leafColumns(const std::vector<SchemaElement> &schema)
+{
+    std::vector<ColumnDescriptor> columns;
+    if (schema.empty())
+    {
+        return columns;
+    }
+    // The root element is the message itself and does not contribute to the paths or levels
+    size_t index = 1;
+    std::vector<std::string> path;
+    for (int32_t i = 0; i < schema[0].num_children.value_or(0); ++i)
+    {
+        collectLeaves(schema, index, path, 0, 0, columns);
+    }
+    if (index != schema.size())
+    {
+        throw ParquetException("Schema has elements that are not reachable from the root");
+    }
+    return columns;
+}
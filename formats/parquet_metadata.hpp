@@ -0,0 +1,403 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "parquet.hpp"
+#include "thrift_compact_protocol.hpp"
+
+// Hand written counterparts of the parquet.thrift structs the reader and writer need.
+// Field names follow parquet.thrift. Unknown fields are skipped when reading, so files
+// written by newer writers still parse.
+//
+// Thrift definitions:
+// https://github.com/apache/parquet-format/blob/master/src/main/thrift/parquet.thrift
+
+enum class CompressionCodec
+{
+    UNCOMPRESSED = 0,
+    SNAPPY = 1,
+    GZIP = 2,
+    LZO = 3,
+    BROTLI = 4,
+    LZ4 = 5,
+    ZSTD = 6,
+    LZ4_RAW = 7
+};
+
+enum class PageType
+{
+    DATA_PAGE = 0,
+    INDEX_PAGE = 1,
+    DICTIONARY_PAGE = 2,
+    DATA_PAGE_V2 = 3
+};
+
+enum class FieldRepetitionType
+{
+    REQUIRED = 0,
+    OPTIONAL = 1,
+    REPEATED = 2
+};
+
+/**
+ * @brief Converts between AtomicType and the `Type` enum of parquet.thrift (which also
+ * has the deprecated INT96).
+ * @throws ParquetException for INT96 and unknown values
+ */
+int32_t toThriftType(AtomicType type);
+AtomicType fromThriftType(int32_t type);
+
+struct KeyValue
+{
+    std::string key;
+    std::optional<std::string> value;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct Statistics
+{
+    std::optional<std::string> max;
+    std::optional<std::string> min;
+    std::optional<int64_t> null_count;
+    std::optional<int64_t> distinct_count;
+    std::optional<std::string> max_value;
+    std::optional<std::string> min_value;
+    std::optional<bool> is_max_value_exact;
+    std::optional<bool> is_min_value_exact;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct SizeStatistics
+{
+    std::optional<int64_t> unencoded_byte_array_data_bytes;
+    std::vector<int64_t> repetition_level_histogram;
+    std::vector<int64_t> definition_level_histogram;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct SchemaElement
+{
+    std::optional<AtomicType> type;
+    std::optional<int32_t> type_length;
+    std::optional<FieldRepetitionType> repetition_type;
+    std::string name;
+    std::optional<int32_t> num_children;
+    std::optional<int32_t> converted_type;
+    std::optional<int32_t> scale;
+    std::optional<int32_t> precision;
+    std::optional<int32_t> field_id;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct DataPageHeader
+{
+    int32_t num_values = 0;
+    Encoding encoding = Encoding::PLAIN;
+    Encoding definition_level_encoding = Encoding::RLE;
+    Encoding repetition_level_encoding = Encoding::RLE;
+    std::optional<Statistics> statistics;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct DictionaryPageHeader
+{
+    int32_t num_values = 0;
+    Encoding encoding = Encoding::PLAIN;
+    std::optional<bool> is_sorted;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct DataPageHeaderV2
+{
+    int32_t num_values = 0;
+    int32_t num_nulls = 0;
+    int32_t num_rows = 0;
+    Encoding encoding = Encoding::PLAIN;
+    int32_t definition_levels_byte_length = 0;
+    int32_t repetition_levels_byte_length = 0;
+    bool is_compressed = true;
+    std::optional<Statistics> statistics;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct PageHeader
+{
+    PageType type = PageType::DATA_PAGE;
+    int32_t uncompressed_page_size = 0;
+    int32_t compressed_page_size = 0;
+    std::optional<int32_t> crc;
+    std::optional<DataPageHeader> data_page_header;
+    std::optional<DictionaryPageHeader> dictionary_page_header;
+    std::optional<DataPageHeaderV2> data_page_header_v2;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct ColumnMetaData
+{
+    AtomicType type = AtomicType::INT32;
+    std::vector<Encoding> encodings;
+    std::vector<std::string> path_in_schema;
+    CompressionCodec codec = CompressionCodec::UNCOMPRESSED;
+    int64_t num_values = 0;
+    int64_t total_uncompressed_size = 0;
+    int64_t total_compressed_size = 0;
+    int64_t data_page_offset = 0;
+    std::optional<int64_t> dictionary_page_offset;
+    std::optional<Statistics> statistics;
+    std::optional<int64_t> bloom_filter_offset;
+    std::optional<int32_t> bloom_filter_length;
+    std::optional<SizeStatistics> size_statistics;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+/**
+ * @brief Parameters of the AES_GCM_V1 algorithm of modular encryption; AES_GCM_CTR_V1 has
+ * the same fields.
+ */
+struct AesGcmV1
+{
+    std::optional<std::string> aad_prefix;
+    std::optional<std::string> aad_file_unique;
+    std::optional<bool> supply_aad_prefix;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct AesGcmCtrV1 : AesGcmV1
+{
+};
+
+/**
+ * @brief A union: exactly one member is set.
+ */
+struct EncryptionAlgorithm
+{
+    std::optional<AesGcmV1> AES_GCM_V1;
+    std::optional<AesGcmCtrV1> AES_GCM_CTR_V1;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+/**
+ * @brief Plaintext metadata in front of an encrypted footer.
+ */
+struct FileCryptoMetaData
+{
+    EncryptionAlgorithm encryption_algorithm;
+    std::optional<std::string> key_metadata;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct EncryptionWithColumnKey
+{
+    std::vector<std::string> path_in_schema;
+    std::optional<std::string> key_metadata;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+/**
+ * @brief A union of ENCRYPTION_WITH_FOOTER_KEY, an empty struct, and
+ * ENCRYPTION_WITH_COLUMN_KEY; the column is encrypted with the footer key unless the
+ * latter is set.
+ */
+struct ColumnCryptoMetaData
+{
+    std::optional<EncryptionWithColumnKey> ENCRYPTION_WITH_COLUMN_KEY;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct ColumnChunk
+{
+    std::optional<std::string> file_path;
+    int64_t file_offset = 0;
+    std::optional<ColumnMetaData> meta_data;
+    std::optional<int64_t> offset_index_offset;
+    std::optional<int32_t> offset_index_length;
+    std::optional<int64_t> column_index_offset;
+    std::optional<int32_t> column_index_length;
+    std::optional<ColumnCryptoMetaData> crypto_metadata;
+
+    /// The serialized ColumnMetaData, encrypted with the column's key
+    std::optional<std::string> encrypted_column_metadata;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct RowGroup
+{
+    std::vector<ColumnChunk> columns;
+    int64_t total_byte_size = 0;
+    int64_t num_rows = 0;
+    std::optional<int64_t> file_offset;
+    std::optional<int64_t> total_compressed_size;
+    std::optional<int16_t> ordinal;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+struct FileMetaData
+{
+    int32_t version = 2;
+    std::vector<SchemaElement> schema;
+    int64_t num_rows = 0;
+    std::vector<RowGroup> row_groups;
+    std::vector<KeyValue> key_value_metadata;
+    std::optional<std::string> created_by;
+
+    /// Set in files with encrypted columns and a plaintext footer
+    std::optional<EncryptionAlgorithm> encryption_algorithm;
+    std::optional<std::string> footer_signing_key_metadata;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+enum class BoundaryOrder
+{
+    UNORDERED = 0,
+    ASCENDING = 1,
+    DESCENDING = 2
+};
+
+struct PageLocation
+{
+    int64_t offset = 0;
+    int32_t compressed_page_size = 0;
+    int64_t first_row_index = 0;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+/**
+ * @brief Where the data pages of a column chunk are; part of the page index.
+ */
+struct OffsetIndex
+{
+    std::vector<PageLocation> page_locations;
+    std::vector<int64_t> unencoded_byte_array_data_bytes;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+/**
+ * @brief Per page statistics of a column chunk; part of the page index.
+ */
+struct ColumnIndex
+{
+    std::vector<bool> null_pages;
+    std::vector<std::string> min_values;
+    std::vector<std::string> max_values;
+    BoundaryOrder boundary_order = BoundaryOrder::UNORDERED;
+    std::vector<int64_t> null_counts;
+    std::vector<int64_t> repetition_level_histograms;
+    std::vector<int64_t> definition_level_histograms;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+/**
+ * @brief Header in front of the bitset of a Bloom filter. The algorithm, hash and
+ * compression are unions with a single member each so far (split block, xxHash64,
+ * uncompressed); reading rejects anything else.
+ */
+struct BloomFilterHeader
+{
+    int32_t num_bytes = 0;
+
+    void read(thrift::CompactProtocolReader &reader);
+    void write(thrift::CompactProtocolWriter &writer) const;
+};
+
+/**
+ * @brief A leaf column of the schema with the levels needed to decode it.
+ */
+struct ColumnDescriptor
+{
+    std::vector<std::string> path;
+    AtomicType type = AtomicType::INT32;
+    int32_t type_length = 0;
+    int16_t max_definition_level = 0;
+    int16_t max_repetition_level = 0;
+
+    /**
+     * @brief The dotted path, e.g. "a.b.c".
+     */
+    std::string dottedPath() const;
+};
+
+/**
+ * @brief Flattens the depth-first schema list into its leaf columns, in file order.
+ * @throws ParquetException if the schema tree is malformed
+ */
+std::vector<ColumnDescriptor> leafColumns(const std::vector<SchemaElement> &schema);
+
+/**
+ * @brief Parses a serialized struct (e.g. FileMetaData or PageHeader) from `data`.
+ * @param consumed If not null, receives the number of bytes the struct occupied
+ * @throws ParquetException if the bytes are not a valid struct
+ */
+template <typename T>
+T parseThrift(const uint8_t *data, size_t size, size_t *consumed = nullptr)
+{
+    T value;
+    try
+    {
+        thrift::CompactProtocolReader reader(data, size);
+        value.read(reader);
+        if (consumed != nullptr)
+        {
+            *consumed = reader.position();
+        }
+    }
+    catch (const thrift::ProtocolException &e)
+    {
+        throw ParquetException(std::string("Invalid Thrift metadata: ") + e.what());
+    }
+    return value;
+}
+
+/**
+ * @brief Serializes a struct with the compact protocol.
+ */
+template <typename T>
+std::vector<uint8_t> serializeThrift(const T &value)
+{
+    thrift::CompactProtocolWriter writer;
+    value.write(writer);
+    return writer.release();
+}
@@ -0,0 +1,830 @@
+#include "parquet_reader.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+#include "bit_util.hpp"
+#include "compression.hpp"
+#include "instrumentation.hpp"
+
+namespace
+{
+    constexpr uint8_t kMagic[4] = {'P', 'A', 'R', '1'};
+    constexpr uint8_t kEncryptedMagic[4] = {'P', 'A', 'R', 'E'};
+
+    // Magic at both ends plus the footer length
+    constexpr size_t kMinFileSize = 12;
+
+    // Bytes read from the end of the file when opening it. Most footers fit, so opening
+    // usually takes a single read, which matters for object stores.
+    constexpr size_t kFooterPrefetchSize = 64 * 1024;
+
+    // Parsed metadata takes a few times the memory of its compact protocol encoding; the
+    // cache charges are the encoded size times this
+    constexpr size_t kParsedSizeFactor = 3;
+
+    // Bytes read for a Bloom filter header whose length is not in the metadata
+    constexpr size_t kBloomFilterHeaderSize = 256;
+
+    bool isDataPage(PageType type)
+    {
+        return type == PageType::DATA_PAGE || type == PageType::DATA_PAGE_V2;
+    }
+} // namespace
+
+ColumnChunkReader::ColumnChunkReader(ColumnDescriptor column, const ColumnMetaData &metadata, Slice chunk,
+                                     std::optional<ChunkCipher> cipher, std::pmr::memory_resource *resource)
+    : column_(std::move(column)), codec_(metadata.codec), num_values_(metadata.num_values),
+      has_dictionary_page_(metadata.dictionary_page_offset && *metadata.dictionary_page_offset > 0),
+      chunk_(std::move(chunk)), cipher_(std::move(cipher)), uncompressed_(resource), pages_(resource),
+      level_scratch_(resource)
+{
+    if (column_.max_repetition_level > 0)
+    {
+        throw ParquetException("Repeated column " + column_.dottedPath() + " is not supported yet");
+    }
+    if (!isCodecSupported(codec_))
+    {
+        throw ParquetException("Column " + column_.dottedPath() + " uses an unsupported compression codec");
+    }
+}
+
+void ColumnChunkReader::selectPages(const OffsetIndex &offset_index, uint64_t chunk_offset, const Bitmap &selection)
+{
+    if (decompressed_)
+    {
+        throw std::logic_error("selectPages() must be called before decompress()");
+    }
+    const std::vector<PageLocation> &locations = offset_index.page_locations;
+    std::vector<bool> selected(locations.size());
+    for (size_t i = 0; i < locations.size(); ++i)
+    {
+        const PageLocation &location = locations[i];
+        int64_t first_row = location.first_row_index;
+        int64_t end_row = i + 1 < locations.size() ? locations[i + 1].first_row_index : num_values_;
+        auto position = static_cast<uint64_t>(location.offset) - chunk_offset;
+        if (location.offset < static_cast<int64_t>(chunk_offset) || location.compressed_page_size < 0 ||
+            position + static_cast<uint64_t>(location.compressed_page_size) > chunk_.size || first_row < 0 ||
+            end_row < first_row || end_row > num_values_)
+        {
+            throw ParquetException("Offset index of column " + column_.dottedPath() + " does not fit its chunk");
+        }
+        selected[i] = selection.findNext(static_cast<size_t>(first_row)) < static_cast<size_t>(end_row);
+    }
+    page_locations_ = locations;
+    selected_pages_ = std::move(selected);
+    chunk_offset_ = chunk_offset;
+}
+
+bool ColumnChunkReader::skipsPages() const noexcept
+{
+    return std::find(selected_pages_.begin(), selected_pages_.end(), false) != selected_pages_.end();
+}
+
+const uint8_t *ColumnChunkReader::addPage(const uint8_t *p, const uint8_t *end, bool dictionary,
+                                          int64_t page_ordinal)
+{
+    size_t consumed;
+    PageHeader header;
+    if (cipher_)
+    {
+        ModuleType type = dictionary ? ModuleType::DICTIONARY_PAGE_HEADER : ModuleType::DATA_PAGE_HEADER;
+        consumed = ModuleCipher::moduleSize(p, static_cast<size_t>(end - p));
+        std::vector<uint8_t> plaintext = cipher_->cipher->decrypt(type, p, consumed, cipher_->aad(type, page_ordinal));
+        header = parseThrift<PageHeader>(plaintext.data(), plaintext.size());
+    }
+    else
+    {
+        header = parseThrift<PageHeader>(p, static_cast<size_t>(end - p), &consumed);
+    }
+    p += consumed;
+    auto compressed_size = static_cast<size_t>(header.compressed_page_size);
+    if (compressed_size > static_cast<size_t>(end - p))
+    {
+        throw ParquetException("Page of column " + column_.dottedPath() + " is truncated");
+    }
+    if ((header.type == PageType::DATA_PAGE && !header.data_page_header) ||
+        (header.type == PageType::DATA_PAGE_V2 && !header.data_page_header_v2) ||
+        (header.type == PageType::DICTIONARY_PAGE && !header.dictionary_page_header))
+    {
+        throw ParquetException("Page header of column " + column_.dottedPath() + " misses its type specific header");
+    }
+    int32_t num_values = 0;
+    if (header.data_page_header)
+    {
+        num_values = header.data_page_header->num_values;
+    }
+    else if (header.data_page_header_v2)
+    {
+        num_values = header.data_page_header_v2->num_values;
+    }
+    pages_.push_back({std::move(header), p, compressed_size, static_cast<size_t>(std::max(num_values, 0)), false});
+    return p + compressed_size;
+}
+
+void ColumnChunkReader::decompress()
+{
+    if (decompressed_)
+    {
+        return;
+    }
+    FORMATS_TIME(DECOMPRESS);
+
+    // First pass: page headers, so the decompressed pages can share one allocation. With
+    // selected pages, only the pages in front of the first data page (the dictionary page)
+    // are walked; the selected data pages are found through their locations
+    const uint8_t *p = chunk_.data;
+    const uint8_t *end = p + chunk_.size;
+    const uint8_t *data_pages = end;
+    if (!selected_pages_.empty())
+    {
+        data_pages = chunk_.data + (page_locations_[0].offset - static_cast<int64_t>(chunk_offset_));
+    }
+    int64_t page_ordinal = 0;
+    while (p < data_pages)
+    {
+        // Only the metadata tells whether the first page is a dictionary page, which its
+        // header needs to be decrypted with
+        bool dictionary = has_dictionary_page_ && pages_.empty();
+        p = addPage(p, end, dictionary, dictionary ? -1 : page_ordinal);
+        page_ordinal += dictionary ? 0 : 1;
+    }
+    for (size_t i = 0; i < selected_pages_.size(); ++i)
+    {
+        const PageLocation &location = page_locations_[i];
+        if (selected_pages_[i])
+        {
+            addPage(chunk_.data + (location.offset - static_cast<int64_t>(chunk_offset_)), end, false,
+                    static_cast<int64_t>(i));
+            continue;
+        }
+        int64_t next_row = i + 1 < page_locations_.size() ? page_locations_[i + 1].first_row_index : num_values_;
+        pages_.push_back({PageHeader(), nullptr, 0, static_cast<size_t>(next_row - location.first_row_index), true});
+    }
+    size_t total_size = 0;
+    size_t max_page_size = 0;
+    for (const Page &page : pages_)
+    {
+        if (!page.skipped)
+        {
+            total_size += static_cast<size_t>(page.header.uncompressed_page_size);
+            max_page_size = std::max(max_page_size, page.size);
+        }
+    }
+
+    // Second pass: without compression or encryption the pages stay in the chunk buffer,
+    // otherwise they are decompressed back to back and the chunk buffer is released.
+    // Encrypted pages are decrypted into a scratch buffer that is reused from page to page
+    // and stays in cache, or straight to their place when they are not compressed.
+    if (codec_ != CompressionCodec::UNCOMPRESSED || cipher_)
+    {
+        FORMATS_COUNT(PAGES_DECOMPRESSED, static_cast<uint64_t>(std::count_if(pages_.begin(), pages_.end(),
+                                                                              [](const Page &page)
+                                                                              { return !page.skipped; })));
+        FORMATS_COUNT(BYTES_DECOMPRESSED, total_size);
+        uncompressed_.resize(total_size);
+        uint8_t *out = uncompressed_.data();
+        std::vector<uint8_t> scratch(cipher_ && codec_ != CompressionCodec::UNCOMPRESSED ? max_page_size : 0);
+        page_ordinal = 0;
+        for (Page &page : pages_)
+        {
+            if (page.skipped)
+            {
+                ++page_ordinal;
+                continue;
+            }
+            auto size = static_cast<size_t>(page.header.uncompressed_page_size);
+            if (cipher_)
+            {
+                bool dictionary = page.header.type == PageType::DICTIONARY_PAGE;
+                ModuleType type = dictionary ? ModuleType::DICTIONARY_PAGE : ModuleType::DATA_PAGE;
+                size_t overhead = cipher_->cipher->overhead(type);
+                if (page.size < overhead ||
+                    (codec_ == CompressionCodec::UNCOMPRESSED && page.size - overhead != size))
+                {
+                    throw ParquetException("Encrypted page of column " + column_.dottedPath() + " has the wrong size");
+                }
+                uint8_t *target = codec_ == CompressionCodec::UNCOMPRESSED ? out : scratch.data();
+                page.size = cipher_->cipher->decrypt(type, page.data, page.size,
+                                                     cipher_->aad(type, dictionary ? -1 : page_ordinal), target);
+                page.data = target;
+                page_ordinal += dictionary ? 0 : 1;
+                if (codec_ == CompressionCodec::UNCOMPRESSED)
+                {
+                    out += size;
+                    continue;
+                }
+            }
+            size_t plain_prefix = 0;
+            if (page.header.data_page_header_v2)
+            {
+                const DataPageHeaderV2 &v2 = *page.header.data_page_header_v2;
+                // V2 pages keep their levels uncompressed in front of the values
+                plain_prefix = static_cast<size_t>(v2.definition_levels_byte_length) +
+                               static_cast<size_t>(v2.repetition_levels_byte_length);
+                if (v2.definition_levels_byte_length < 0 || v2.repetition_levels_byte_length < 0 ||
+                    plain_prefix > page.size || plain_prefix > size)
+                {
+                    throw ParquetException("Invalid level lengths in a V2 page of column " + column_.dottedPath());
+                }
+                if (!v2.is_compressed)
+                {
+                    plain_prefix = page.size;
+                }
+            }
+            std::memcpy(out, page.data, std::min(plain_prefix, size));
+            if (plain_prefix < page.size)
+            {
+                ::decompress(codec_, page.data + plain_prefix, page.size - plain_prefix, out + plain_prefix,
+                             size - plain_prefix);
+            }
+            else if (page.size != size)
+            {
+                throw ParquetException("Uncompressed page size does not match the page header");
+            }
+            page.data = out;
+            page.size = size;
+            out += size;
+        }
+        chunk_ = Slice();
+    }
+
+    for (size_t i = 0; i < pages_.size(); ++i)
+    {
+        const Page &page = pages_[i];
+        if (page.skipped || page.header.type != PageType::DICTIONARY_PAGE)
+        {
+            continue;
+        }
+        if (i != 0)
+        {
+            throw ParquetException("Dictionary page of column " + column_.dottedPath() + " is not the first page");
+        }
+        auto num_values = page.header.dictionary_page_header->num_values;
+        if (num_values < 0)
+        {
+            throw ParquetException("Negative dictionary size");
+        }
+        dictionary_ = decodeDictionaryPage(column_.type, column_.type_length, page.data, page.size,
+                                           static_cast<size_t>(num_values));
+    }
+    decompressed_ = true;
+}
+
+bool ColumnChunkReader::nextPage(size_t skip_values)
+{
+    while (next_page_ < pages_.size())
+    {
+        const Page &page = pages_[next_page_++];
+        if (!page.skipped && !isDataPage(page.header.type))
+        {
+            continue;
+        }
+        if (page.skipped || page.num_values <= skip_values)
+        {
+            // Skipped as a whole, the page needs no decoders
+            values_.reset();
+            def_levels_.reset();
+            page_remaining_ = page.num_values;
+            if (page_remaining_ == 0)
+            {
+                continue;
+            }
+            FORMATS_COUNT(PAGES_SKIPPED, 1);
+            return true;
+        }
+
+        const uint8_t *p = page.data;
+        const uint8_t *end = p + page.size;
+        int bit_width = bit_util::bitWidth(static_cast<uint64_t>(column_.max_definition_level));
+        int32_t num_values;
+        Encoding encoding;
+        def_levels_.reset();
+        if (page.header.type == PageType::DATA_PAGE)
+        {
+            const DataPageHeader &header = *page.header.data_page_header;
+            num_values = header.num_values;
+            encoding = header.encoding;
+            if (column_.max_definition_level > 0)
+            {
+                if (header.definition_level_encoding != Encoding::RLE)
+                {
+                    throw ParquetException("Only RLE encoded definition levels are supported");
+                }
+                if (end - p < 4)
+                {
+                    throw ParquetException("Truncated definition levels");
+                }
+                uint32_t length;
+                std::memcpy(&length, p, sizeof(length));
+                p += 4;
+                if (length > static_cast<size_t>(end - p))
+                {
+                    throw ParquetException("Truncated definition levels");
+                }
+                def_levels_ = std::make_unique<RleBitPackedDecoder>(p, length, bit_width);
+                p += length;
+            }
+        }
+        else
+        {
+            const DataPageHeaderV2 &header = *page.header.data_page_header_v2;
+            num_values = header.num_values;
+            encoding = header.encoding;
+            // decompress() validated that the level sections fit the page
+            p += header.repetition_levels_byte_length;
+            if (column_.max_definition_level > 0)
+            {
+                def_levels_ = std::make_unique<RleBitPackedDecoder>(
+                    p, static_cast<size_t>(header.definition_levels_byte_length), bit_width);
+            }
+            p += header.definition_levels_byte_length;
+        }
+
+        if (num_values <= 0)
+        {
+            continue;
+        }
+        values_ = makeValueDecoder(encoding, column_.type, column_.type_length, p, static_cast<size_t>(end - p),
+                                   dictionary_, keep_dictionary_indices_);
+        dictionary_encoded_page_ = encoding == Encoding::RLE_DICTIONARY || encoding == Encoding::PLAIN_DICTIONARY;
+        page_remaining_ = static_cast<size_t>(num_values);
+        FORMATS_COUNT(PAGES_DECODED, 1);
+        return true;
+    }
+    return false;
+}
+
+size_t ColumnChunkReader::readBatch(ColumnBatch &batch, size_t max_values)
+{
+    decompress();
+    FORMATS_TIME(DECODE);
+    return readValues(batch, max_values);
+}
+
+size_t ColumnChunkReader::skip(size_t max_values)
+{
+    decompress();
+    FORMATS_TIME(DECODE);
+    return skipValues(max_values);
+}
+
+size_t ColumnChunkReader::readSelected(ColumnBatch &batch, const Bitmap &selection, size_t first, size_t count)
+{
+    if (first + count > selection.size())
+    {
+        throw std::invalid_argument("Selection has fewer bits than slots to read");
+    }
+    decompress();
+    FORMATS_TIME(DECODE);
+    size_t end = first + count;
+    size_t appended = 0;
+    for (size_t i = first; i < end;)
+    {
+        bool selected = selection[i];
+        size_t run = std::min(selection.findNext(i, !selected), end) - i;
+        if ((selected ? readValues(batch, run) : skipValues(run)) != run)
+        {
+            throw ParquetException("Column chunk of " + column_.dottedPath() + " has fewer values than selected");
+        }
+        appended += selected ? run : 0;
+        i += run;
+    }
+    return appended;
+}
+
+size_t ColumnChunkReader::readValues(ColumnBatch &batch, size_t max_values)
+{
+    size_t appended = 0;
+    while (appended < max_values)
+    {
+        if (page_remaining_ == 0 && !nextPage())
+        {
+            break;
+        }
+        if (!values_)
+        {
+            throw ParquetException("Reading a page of column " + column_.dottedPath() +
+                                   " that selectPages() left out");
+        }
+        if (batch.isDictionaryEncoded() && batch.dictionary() != (dictionary_encoded_page_ ? dictionary_ : nullptr))
+        {
+            // The page cannot add to the indices the batch holds
+            if (batch.empty())
+            {
+                batch.setDictionary(nullptr);
+            }
+            else
+            {
+                batch.materialize();
+            }
+        }
+        size_t n = std::min(page_remaining_, max_values - appended);
+        if (def_levels_)
+        {
+            level_scratch_.resize(std::max(level_scratch_.size(), n));
+            if (def_levels_->getBatch(level_scratch_.data(), n) != n)
+            {
+                throw ParquetException("Page has fewer definition levels than values");
+            }
+            values_->decodeSpaced(batch, level_scratch_.data(), n, column_.max_definition_level);
+        }
+        else if (values_->decode(batch, n) != n)
+        {
+            throw ParquetException("Page has fewer values than its header");
+        }
+        page_remaining_ -= n;
+        appended += n;
+    }
+    FORMATS_COUNT(VALUES_DECODED, appended);
+    return appended;
+}
+
+size_t ColumnChunkReader::skipValues(size_t max_values)
+{
+    size_t skipped = 0;
+    while (skipped < max_values)
+    {
+        if (page_remaining_ == 0 && !nextPage(max_values - skipped))
+        {
+            break;
+        }
+        size_t n = std::min(page_remaining_, max_values - skipped);
+        if (values_)
+        {
+            size_t valid = n;
+            if (def_levels_)
+            {
+                valid = 0;
+                if (def_levels_->skip(n, static_cast<uint32_t>(column_.max_definition_level), valid) != n)
+                {
+                    throw ParquetException("Page has fewer definition levels than values");
+                }
+            }
+            if (values_->skip(valid) != valid)
+            {
+                throw ParquetException("Page has fewer values than its definition levels");
+            }
+        }
+        page_remaining_ -= n;
+        skipped += n;
+    }
+    FORMATS_COUNT(VALUES_SKIPPED, skipped);
+    return skipped;
+}
+
+bool ColumnChunkReader::hasNext()
+{
+    decompress();
+    return page_remaining_ > 0 || nextPage();
+}
+
+ParquetFileReader::ParquetFileReader(const std::string &path,
+                                     std::shared_ptr<const FileDecryptionProperties> decryption)
+    : ParquetFileReader(std::make_shared<LocalFile>(path), nullptr, std::move(decryption)) {}
+
+ParquetFileReader::ParquetFileReader(std::shared_ptr<const RandomAccessFile> file,
+                                     std::shared_ptr<MetadataCache> cache,
+                                     std::shared_ptr<const FileDecryptionProperties> decryption)
+    : file_(std::move(file)), cache_(decryption ? nullptr : std::move(cache)), decryption_(std::move(decryption)),
+      size_(file_->size())
+{
+    if (!cache_)
+    {
+        size_t charge;
+        footer_ = readFooter(charge);
+        return;
+    }
+    cache_key_ = MetadataCache::fileKey(*file_);
+    footer_ = cache_->getOrLoad<ParquetFooter>(cache_key_, [this](size_t &charge)
+                                               { return readFooter(charge); });
+}
+
+std::shared_ptr<const ParquetFooter> ParquetFileReader::readFooter(size_t &charge) const
+{
+    const std::string &path = file_->path();
+    if (size_ < kMinFileSize)
+    {
+        throw ParquetException(path + " is too small to be a Parquet file");
+    }
+
+    // One speculative read of the tail; the leading magic is only checked when the tail
+    // covers it, reading it separately would cost an extra request
+    size_t tail_size = static_cast<size_t>(std::min<uint64_t>(size_, kFooterPrefetchSize));
+    std::vector<uint8_t> tail(tail_size);
+    file_->readAt(size_ - tail_size, tail_size, tail.data());
+    const uint8_t *trailer = tail.data() + tail_size - 8;
+    bool encrypted_footer = std::memcmp(trailer + 4, kEncryptedMagic, 4) == 0;
+    const uint8_t *magic = encrypted_footer ? kEncryptedMagic : kMagic;
+    if (std::memcmp(trailer + 4, magic, 4) != 0 || (tail_size == size_ && std::memcmp(tail.data(), magic, 4) != 0))
+    {
+        throw ParquetException(path + " is not a Parquet file");
+    }
+    if (encrypted_footer && !decryption_)
+    {
+        throw ParquetException(path + " has an encrypted footer and no decryption properties were given");
+    }
+    uint32_t footer_length;
+    std::memcpy(&footer_length, trailer, sizeof(footer_length));
+    if (footer_length > size_ - kMinFileSize)
+    {
+        throw ParquetException("Footer length of " + path + " exceeds the file size");
+    }
+
+    std::vector<uint8_t> footer;
+    const uint8_t *footer_data;
+    if (footer_length + size_t{8} <= tail_size)
+    {
+        footer_data = trailer - footer_length;
+    }
+    else
+    {
+        footer.resize(footer_length);
+        file_->readAt(size_ - 8 - footer_length, footer_length, footer.data());
+        footer_data = footer.data();
+    }
+
+    auto parsed = std::make_shared<ParquetFooter>();
+    std::unique_ptr<FileDecryptor> decryptor;
+    if (encrypted_footer)
+    {
+        size_t crypto_size;
+        auto crypto_metadata = parseThrift<FileCryptoMetaData>(footer_data, footer_length, &crypto_size);
+        decryptor = std::make_unique<FileDecryptor>(*decryption_, crypto_metadata.encryption_algorithm,
+                                                    crypto_metadata.key_metadata);
+        const std::shared_ptr<const ModuleCipher> &cipher = decryptor->footerCipher();
+        if (!cipher)
+        {
+            throw ParquetException("No key for the encrypted footer of " + path);
+        }
+        std::vector<uint8_t> plaintext = cipher->decrypt(ModuleType::FOOTER, footer_data + crypto_size,
+                                                         footer_length - crypto_size, cipher->aad(ModuleType::FOOTER));
+        parsed->metadata = parseThrift<FileMetaData>(plaintext.data(), plaintext.size());
+    }
+    else
+    {
+        size_t metadata_size;
+        parsed->metadata = parseThrift<FileMetaData>(footer_data, footer_length, &metadata_size);
+        if (parsed->metadata.encryption_algorithm && decryption_)
+        {
+            decryptor = std::make_unique<FileDecryptor>(*decryption_, *parsed->metadata.encryption_algorithm,
+                                                        parsed->metadata.footer_signing_key_metadata);
+            if (decryption_->check_footer_signature)
+            {
+                if (!decryptor->footerCipher())
+                {
+                    throw ParquetException("No footer key to check the footer signature of " + path);
+                }
+                if (footer_length - metadata_size != kFooterSignatureSize)
+                {
+                    throw ParquetException("The plaintext footer of " + path + " has no signature");
+                }
+                decryptor->footerCipher()->verify(footer_data, metadata_size, footer_data + metadata_size);
+            }
+        }
+    }
+    parsed->columns = leafColumns(parsed->metadata.schema);
+    if (decryptor)
+    {
+        parsed->column_ciphers.resize(parsed->columns.size());
+    }
+    for (size_t r = 0; r < parsed->metadata.row_groups.size(); ++r)
+    {
+        RowGroup &row_group = parsed->metadata.row_groups[r];
+        if (row_group.columns.size() != parsed->columns.size())
+        {
+            throw ParquetException("Row group column count does not match the schema");
+        }
+        for (size_t c = 0; c < row_group.columns.size(); ++c)
+        {
+            ColumnChunk &chunk = row_group.columns[c];
+            if (chunk.crypto_metadata && decryptor)
+            {
+                auto cipher = decryptor->columnCipher(*chunk.crypto_metadata, parsed->columns[c].dottedPath());
+                parsed->column_ciphers[c] = cipher;
+                if (cipher && chunk.encrypted_column_metadata)
+                {
+                    const std::string &module = *chunk.encrypted_column_metadata;
+                    std::vector<uint8_t> plaintext = cipher->decrypt(
+                        ModuleType::COLUMN_META_DATA, reinterpret_cast<const uint8_t *>(module.data()),
+                        module.size(),
+                        cipher->aad(ModuleType::COLUMN_META_DATA, static_cast<int64_t>(r), static_cast<int64_t>(c)));
+                    chunk.meta_data = parseThrift<ColumnMetaData>(plaintext.data(), plaintext.size());
+                }
+            }
+            // Encrypted columns without their key may lack metadata; columnMetaData() throws
+            // when they are used
+            if (!chunk.meta_data && !chunk.crypto_metadata)
+            {
+                throw ParquetException("Column chunks without inline metadata are not supported");
+            }
+        }
+    }
+    charge = footer_length * kParsedSizeFactor;
+    return parsed;
+}
+
+const ColumnMetaData &ParquetFileReader::columnMetaData(size_t row_group, size_t column) const
+{
+    const ColumnChunk &chunk = footer_->metadata.row_groups.at(row_group).columns.at(column);
+    if (!chunk.meta_data)
+    {
+        throw ParquetException("Column " + footer_->columns[column].dottedPath() +
+                               " is encrypted with a key the reader does not have");
+    }
+    return *chunk.meta_data;
+}
+
+std::optional<ChunkCipher> ParquetFileReader::chunkCipher(size_t row_group, size_t column) const
+{
+    const ColumnChunk &chunk = footer_->metadata.row_groups.at(row_group).columns.at(column);
+    if (!chunk.crypto_metadata)
+    {
+        return std::nullopt;
+    }
+    if (footer_->column_ciphers.empty() || !footer_->column_ciphers[column])
+    {
+        throw ParquetException("Column " + footer_->columns[column].dottedPath() +
+                               " is encrypted with a key the reader does not have");
+    }
+    return ChunkCipher{footer_->column_ciphers[column], static_cast<int64_t>(row_group), static_cast<int64_t>(column)};
+}
+
+ReadRange ParquetFileReader::columnChunkRange(size_t row_group, size_t column) const
+{
+    const ColumnMetaData &metadata = columnMetaData(row_group, column);
+    int64_t start = metadata.data_page_offset;
+    if (metadata.dictionary_page_offset && *metadata.dictionary_page_offset > 0 &&
+        *metadata.dictionary_page_offset < start)
+    {
+        start = *metadata.dictionary_page_offset;
+    }
+    int64_t length = metadata.total_compressed_size;
+    if (start < 0 || length < 0 || static_cast<uint64_t>(start) + static_cast<uint64_t>(length) > size_)
+    {
+        throw ParquetException("Column chunk lies outside of " + file_->path());
+    }
+    return {static_cast<uint64_t>(start), static_cast<size_t>(length)};
+}
+
+Slice ParquetFileReader::readColumnChunk(size_t row_group, size_t column) const
+{
+    ReadRange range = columnChunkRange(row_group, column);
+    std::vector<uint8_t> bytes(range.length);
+    file_->readAt(range.offset, range.length, bytes.data());
+    return Slice::fromVector(std::move(bytes));
+}
+
+ColumnChunkReader ParquetFileReader::columnChunk(size_t row_group, size_t column,
+                                                 std::pmr::memory_resource *resource) const
+{
+    return columnChunk(row_group, column, readColumnChunk(row_group, column), resource);
+}
+
+ColumnChunkReader ParquetFileReader::columnChunk(size_t row_group, size_t column, Slice chunk,
+                                                 std::pmr::memory_resource *resource) const
+{
+    return ColumnChunkReader(footer_->columns.at(column), columnMetaData(row_group, column), std::move(chunk),
+                             chunkCipher(row_group, column), resource);
+}
+
+template <typename T>
+std::shared_ptr<const T> ParquetFileReader::cached(const std::string &kind, size_t row_group, size_t column,
+                                                   const std::function<std::shared_ptr<const T>(size_t &)> &load) const
+{
+    if (!cache_)
+    {
+        size_t charge;
+        return load(charge);
+    }
+    std::string key = cache_key_;
+    key += '\0';
+    key += kind;
+    key += '\0';
+    key += std::to_string(row_group);
+    key += ':';
+    key += std::to_string(column);
+    return cache_->getOrLoad<T>(key, load);
+}
+
+template <typename T>
+std::shared_ptr<const T> ParquetFileReader::readIndex(const std::optional<int64_t> &offset,
+                                                      const std::optional<int32_t> &length,
+                                                      const std::optional<ChunkCipher> &cipher, size_t &charge) const
+{
+    if (!offset || !length)
+    {
+        return nullptr;
+    }
+    if (*offset < 0 || *length <= 0 || static_cast<uint64_t>(*offset) + static_cast<uint64_t>(*length) > size_)
+    {
+        throw ParquetException("Page index lies outside of " + file_->path());
+    }
+    std::vector<uint8_t> bytes(static_cast<size_t>(*length));
+    file_->readAt(static_cast<uint64_t>(*offset), bytes.size(), bytes.data());
+    if (cipher)
+    {
+        ModuleType type = std::is_same_v<T, ColumnIndex> ? ModuleType::COLUMN_INDEX : ModuleType::OFFSET_INDEX;
+        bytes = cipher->cipher->decrypt(type, bytes.data(), bytes.size(), cipher->aad(type));
+    }
+    charge = bytes.size() * kParsedSizeFactor;
+    return std::make_shared<const T>(parseThrift<T>(bytes.data(), bytes.size()));
+}
+
+std::shared_ptr<const ColumnIndex> ParquetFileReader::columnIndex(size_t row_group, size_t column) const
+{
+    const ColumnChunk &chunk = footer_->metadata.row_groups.at(row_group).columns.at(column);
+    return cached<ColumnIndex>("column_index", row_group, column, [this, &chunk, row_group, column](size_t &charge)
+                               { return readIndex<ColumnIndex>(chunk.column_index_offset, chunk.column_index_length,
+                                                               chunkCipher(row_group, column), charge); });
+}
+
+std::shared_ptr<const OffsetIndex> ParquetFileReader::offsetIndex(size_t row_group, size_t column) const
+{
+    const ColumnChunk &chunk = footer_->metadata.row_groups.at(row_group).columns.at(column);
+    return cached<OffsetIndex>("offset_index", row_group, column, [this, &chunk, row_group, column](size_t &charge)
+                               { return readIndex<OffsetIndex>(chunk.offset_index_offset, chunk.offset_index_length,
+                                                               chunkCipher(row_group, column), charge); });
+}
+
+std::vector<uint8_t> ParquetFileReader::readModule(uint64_t offset, const ChunkCipher &cipher, ModuleType type) const
+{
+    uint8_t length[4];
+    if (offset + sizeof(length) > size_)
+    {
+        throw ParquetException("Encrypted module lies outside of " + file_->path());
+    }
+    file_->readAt(offset, sizeof(length), length);
+    size_t module_size = ModuleCipher::moduleSize(length, static_cast<size_t>(size_ - offset));
+    std::vector<uint8_t> module(module_size);
+    file_->readAt(offset, module_size, module.data());
+    return cipher.cipher->decrypt(type, module.data(), module_size, cipher.aad(type));
+}
+
+std::shared_ptr<const BloomFilter> ParquetFileReader::readBloomFilter(const ColumnMetaData &metadata,
+                                                                      const std::optional<ChunkCipher> &cipher,
+                                                                      size_t &charge) const
+{
+    if (!metadata.bloom_filter_offset)
+    {
+        return nullptr;
+    }
+    int64_t offset = *metadata.bloom_filter_offset;
+    if (offset < 0 || static_cast<uint64_t>(offset) >= size_)
+    {
+        throw ParquetException("Bloom filter lies outside of " + file_->path());
+    }
+    if (cipher)
+    {
+        // Header and bitset are modules of their own; the first tells the size of the second
+        auto start = static_cast<uint64_t>(offset);
+        std::vector<uint8_t> header_bytes = readModule(start, *cipher, ModuleType::BLOOM_FILTER_HEADER);
+        auto header = parseThrift<BloomFilterHeader>(header_bytes.data(), header_bytes.size());
+        size_t header_size = header_bytes.size() + cipher->cipher->overhead(ModuleType::BLOOM_FILTER_HEADER);
+        std::vector<uint8_t> bitset = readModule(start + header_size, *cipher, ModuleType::BLOOM_FILTER_BITSET);
+        if (header.num_bytes <= 0 || static_cast<size_t>(header.num_bytes) != bitset.size())
+        {
+            throw ParquetException("Invalid Bloom filter size in " + file_->path());
+        }
+        charge = bitset.size();
+        return std::make_shared<const BloomFilter>(std::move(bitset));
+    }
+    // Without a length, read what should cover the header and fetch the rest of the bitset
+    // once its size is known
+    auto available = static_cast<size_t>(size_ - static_cast<uint64_t>(offset));
+    size_t length = metadata.bloom_filter_length && *metadata.bloom_filter_length > 0
+                        ? static_cast<size_t>(*metadata.bloom_filter_length)
+                        : std::min(available, kBloomFilterHeaderSize);
+    if (length > available)
+    {
+        throw ParquetException("Bloom filter lies outside of " + file_->path());
+    }
+    std::vector<uint8_t> bytes(length);
+    file_->readAt(static_cast<uint64_t>(offset), length, bytes.data());
+    size_t header_size;
+    auto header = parseThrift<BloomFilterHeader>(bytes.data(), bytes.size(), &header_size);
+    if (header.num_bytes <= 0 || static_cast<size_t>(header.num_bytes) > available - header_size)
+    {
+        throw ParquetException("Invalid Bloom filter size in " + file_->path());
+    }
+
+    auto num_bytes = static_cast<size_t>(header.num_bytes);
+    std::vector<uint8_t> bitset(num_bytes);
+    size_t have = std::min(num_bytes, bytes.size() - header_size);
+    std::memcpy(bitset.data(), bytes.data() + header_size, have);
+    if (have < num_bytes)
+    {
+        file_->readAt(static_cast<uint64_t>(offset) + header_size + have, num_bytes - have, bitset.data() + have);
+    }
+    charge = num_bytes;
+    return std::make_shared<const BloomFilter>(std::move(bitset));
+}
+
+std::shared_ptr<const BloomFilter> ParquetFileReader::bloomFilter(size_t row_group, size_t column) const
+{
+    const ColumnMetaData &metadata = columnMetaData(row_group, column);
+    return cached<BloomFilter>("bloom_filter", row_group, column, [this, &metadata, row_group, column](size_t &charge)
+                               { return readBloomFilter(metadata, chunkCipher(row_group, column), charge); });
+}
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bloom_filter.hpp"
+#include "column_batch.hpp"
+#include "encodings.hpp"
+#include "encryption.hpp"
+#include "io.hpp"
+#include "metadata_cache.hpp"
+#include "parquet_metadata.hpp"
+
+/**
+ * @brief Decodes the pages of one column chunk into ColumnBatches.
+ *
+ * The work is split in the three stages the scanner pipelines: the caller reads the raw
+ * chunk bytes (I/O), decompress() parses the page headers and decrypts and decompresses
+ * every page, and readBatch() decodes values. Only non-repeated columns are supported so
+ * far: a value is valid where its definition level is the maximum (nested optional groups
+ * included), columns with repetition levels are rejected.
+ *
+ * The decompressed pages and the decoding scratch space come from the memory resource
+ * given at construction, e.g. an Arena reset after every row group.
+ */
+class ColumnChunkReader
+{
+public:
+    /**
+     * @param chunk The bytes of the chunk, starting at its first page
+     * @param cipher For encrypted chunks; decompress() then decrypts the page headers and
+     * pages
+     * @param resource Allocates the decompressed pages and the scratch space; must outlive
+     * the reader
+     * @throws ParquetException if the column is repeated or uses an unsupported codec
+     */
+    ColumnChunkReader(ColumnDescriptor column, const ColumnMetaData &metadata, Slice chunk,
+                      std::optional<ChunkCipher> cipher = std::nullopt,
+                      std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+
+    const ColumnDescriptor &column() const noexcept { return column_; }
+
+    /**
+     * @brief Leaves out the data pages without a row set in `selection`, which has a bit
+     * per row of the row group. decompress() then finds the other pages through
+     * `offset_index` without parsing the headers in between, and neither decrypts nor
+     * decompresses the pages left out. skip() passes over them; readBatch() must not
+     * reach them. Must be called before decompress().
+     * @param chunk_offset File offset of the chunk, which the page locations refer to
+     * @throws ParquetException if the offset index does not fit the chunk
+     */
+    void selectPages(const OffsetIndex &offset_index, uint64_t chunk_offset, const Bitmap &selection);
+
+    /**
+     * @brief Whether selectPages() left out at least one page.
+     */
+    bool skipsPages() const noexcept;
+
+    /**
+     * @brief Makes readBatch() and readSelected() append the indices of dictionary encoded
+     * pages to `batch` as they are, with the chunk's dictionary set on it (see
+     * ColumnBatch::setDictionary()), instead of looking up their values. A batch that
+     * already holds values gets values. When a batch holding indices meets a PLAIN page
+     * (a writer falling back from dictionary encoding), it switches to values if it is
+     * empty and is materialized otherwise.
+     */
+    void keepDictionaryIndices(bool keep = true) noexcept { keep_dictionary_indices_ = keep; }
+
+    /**
+     * @brief Parses all page headers, decrypts and decompresses the pages and decodes the
+     * dictionary page. Called by the first readBatch() if the caller did not call it
+     * before. The raw chunk bytes are released afterwards, unless the pages are neither
+     * compressed nor encrypted.
+     * @throws ParquetException on corrupt pages
+     */
+    void decompress();
+
+    /**
+     * @brief Bytes held by the decompressed pages.
+     */
+    size_t uncompressedSize() const noexcept { return uncompressed_.size(); }
+
+    /**
+     * @brief Appends up to `max_values` slots (values or nulls) to `batch`.
+     * @return The number of slots appended, 0 once the chunk is exhausted
+     * @throws ParquetException on corrupt pages
+     */
+    size_t readBatch(ColumnBatch &batch, size_t max_values);
+
+    /**
+     * @brief Skips up to `max_values` slots without materializing them. Pages that are
+     * skipped as a whole are not decoded at all; within a page, runs of definition levels
+     * and dictionary indices are skipped without unpacking them.
+     * @return The number of slots skipped, less than `max_values` only at the end of the chunk
+     * @throws ParquetException on corrupt pages
+     */
+    size_t skip(size_t max_values);
+
+    /**
+     * @brief Reads the next `count` slots and appends those whose bit is set in
+     * `selection` to `batch`, bit `first` standing for the next slot. Runs of unset bits
+     * are skipped like skip() does.
+     * @return The number of slots appended
+     * @throws std::invalid_argument if `selection` has fewer than `first + count` bits
+     * @throws ParquetException if the chunk has fewer than `count` slots left, or on
+     * corrupt pages
+     */
+    size_t readSelected(ColumnBatch &batch, const Bitmap &selection, size_t first, size_t count);
+
+    /**
+     * @brief Whether readBatch() has values left to return.
+     */
+    bool hasNext();
+
+private:
+    struct Page
+    {
+        PageHeader header;
+        const uint8_t *data;
+        size_t size;
+        /// Slots of a data page
+        size_t num_values;
+        /// Left out by selectPages(); only num_values is known
+        bool skipped;
+    };
+
+    const uint8_t *addPage(const uint8_t *p, const uint8_t *end, bool dictionary, int64_t page_ordinal);
+    bool nextPage(size_t skip_values = 0);
+    size_t readValues(ColumnBatch &batch, size_t max_values);
+    size_t skipValues(size_t max_values);
+
+    ColumnDescriptor column_;
+    CompressionCodec codec_;
+    int64_t num_values_;
+    bool has_dictionary_page_;
+    Slice chunk_;
+    std::optional<ChunkCipher> cipher_;
+    std::pmr::vector<uint8_t> uncompressed_;
+    bool decompressed_ = false;
+
+    // Set by selectPages()
+    std::vector<PageLocation> page_locations_;
+    std::vector<bool> selected_pages_;
+    uint64_t chunk_offset_ = 0;
+
+    std::pmr::vector<Page> pages_;
+    size_t next_page_ = 0;
+    std::shared_ptr<const ColumnBatch> dictionary_;
+    bool keep_dictionary_indices_ = false;
+
+    // State of the current data page; pages entered to be skipped as a whole have no
+    // decoders
+    std::unique_ptr<ValueDecoder> values_;
+    bool dictionary_encoded_page_ = false;
+    std::unique_ptr<RleBitPackedDecoder> def_levels_;
+    size_t page_remaining_ = 0;
+    std::pmr::vector<int16_t> level_scratch_;
+};
+
+/**
+ * @brief The parsed and validated footer of a Parquet file.
+ */
+struct ParquetFooter
+{
+    FileMetaData metadata;
+    std::vector<ColumnDescriptor> columns;
+
+    /// For encrypted files, the cipher of every encrypted column the reader has the key
+    /// of, by column; null for plaintext columns and unknown keys
+    std::vector<std::shared_ptr<const ModuleCipher>> column_ciphers;
+};
+
+/**
+ * @brief Reads the footer of a Parquet file and the raw bytes of its column chunks.
+ *
+ * All reads go through a RandomAccessFile, so one reader can be shared by any number of
+ * threads. Opening reads the last 64KB of the file in one go, which covers the footer of
+ * most files; only larger footers need a second read.
+ *
+ * With a MetadataCache the parsed footer, page indexes and Bloom filters are shared by
+ * all readers of the same file version, so reopening a file reads nothing but what the
+ * RandomAccessFile needs to learn its size and version.
+ *
+ * Encrypted files (see encryption.hpp) need FileDecryptionProperties with the keys; readers
+ * with them bypass the MetadataCache, which would otherwise hand decrypted metadata to
+ * readers without the keys. Without keys, the plaintext columns of files with a
+ * plaintext footer can still be read.
+ */
+class ParquetFileReader
+{
+public:
+    /**
+     * @throws std::system_error if the file cannot be opened or read
+     * @throws ParquetException if the file is not a valid Parquet file, or its footer
+     * cannot be decrypted or fails authentication
+     */
+    explicit ParquetFileReader(const std::string &path,
+                               std::shared_ptr<const FileDecryptionProperties> decryption = nullptr);
+    explicit ParquetFileReader(std::shared_ptr<const RandomAccessFile> file,
+                               std::shared_ptr<MetadataCache> cache = nullptr,
+                               std::shared_ptr<const FileDecryptionProperties> decryption = nullptr);
+
+    ParquetFileReader(const ParquetFileReader &) = delete;
+    ParquetFileReader &operator=(const ParquetFileReader &) = delete;
+
+    const FileMetaData &metadata() const noexcept { return footer_->metadata; }
+    const std::vector<ColumnDescriptor> &columns() const noexcept { return footer_->columns; }
+    size_t numRowGroups() const noexcept { return footer_->metadata.row_groups.size(); }
+    uint64_t size() const noexcept { return size_; }
+    const std::shared_ptr<const RandomAccessFile> &file() const noexcept { return file_; }
+
+    /**
+     * @brief The metadata of a column chunk.
+     * @throws std::out_of_range for invalid indices
+     * @throws ParquetException if the chunk is encrypted with a key the reader does not have
+     */
+    const ColumnMetaData &columnMetaData(size_t row_group, size_t column) const;
+
+    /**
+     * @brief The byte range of a column chunk, from its first page to its end.
+     * @throws ParquetException if the range lies outside of the file
+     */
+    ReadRange columnChunkRange(size_t row_group, size_t column) const;
+
+    /**
+     * @brief Reads the raw bytes of a column chunk.
+     */
+    Slice readColumnChunk(size_t row_group, size_t column) const;
+
+    /**
+     * @brief Reads a column chunk and returns a reader for it, which allocates from
+     * `resource`.
+     */
+    ColumnChunkReader columnChunk(size_t row_group, size_t column,
+                                  std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+    /**
+     * @brief Returns a reader for a column chunk whose bytes were already read, e.g. by a
+     * RangePrefetcher over columnChunkRange().
+     * @throws ParquetException if the chunk is encrypted with a key the reader does not have
+     */
+    ColumnChunkReader columnChunk(size_t row_group, size_t column, Slice chunk,
+                                  std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const;
+
+    /**
+     * @brief The page index of a column chunk, read on every call unless the reader has a
+     * MetadataCache.
+     * @return null if the file has none for the chunk
+     * @throws ParquetException if the index is corrupt
+     */
+    std::shared_ptr<const ColumnIndex> columnIndex(size_t row_group, size_t column) const;
+    std::shared_ptr<const OffsetIndex> offsetIndex(size_t row_group, size_t column) const;
+
+    /**
+     * @brief The Bloom filter of a column chunk, read on every call unless the reader has
+     * a MetadataCache.
+     * @return null if the file has none for the chunk
+     * @throws ParquetException if the filter is corrupt
+     */
+    std::shared_ptr<const BloomFilter> bloomFilter(size_t row_group, size_t column) const;
+
+private:
+    std::shared_ptr<const ParquetFooter> readFooter(size_t &charge) const;
+
+    std::optional<ChunkCipher> chunkCipher(size_t row_group, size_t column) const;
+
+    template <typename T>
+    std::shared_ptr<const T> readIndex(const std::optional<int64_t> &offset, const std::optional<int32_t> &length,
+                                       const std::optional<ChunkCipher> &cipher, size_t &charge) const;
+
+    std::shared_ptr<const BloomFilter> readBloomFilter(const ColumnMetaData &metadata,
+                                                       const std::optional<ChunkCipher> &cipher, size_t &charge) const;
+    std::vector<uint8_t> readModule(uint64_t offset, const ChunkCipher &cipher, ModuleType type) const;
+
+    template <typename T>
+    std::shared_ptr<const T> cached(const std::string &kind, size_t row_group, size_t column,
+                                    const std::function<std::shared_ptr<const T>(size_t &)> &load) const;
+
+    std::shared_ptr<const RandomAccessFile> file_;
+    std::shared_ptr<MetadataCache> cache_;
+    std::shared_ptr<const FileDecryptionProperties> decryption_;
+    std::string cache_key_;
+    uint64_t size_ = 0;
+    std::shared_ptr<const ParquetFooter> footer_;
+};
@@ -0,0 +1,214 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "basics/benchmark_data.h"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+// The Parquet write and read paths on files of 1K to 1M rows (BENCHMARK_MAX_SIZE raises
+// the limit) in row groups of 128K rows, uncompressed and Snappy compressed, with three
+// columns: ascending INT64 ids, DOUBLE values in [0, 1) and an optional BYTE_ARRAY name
+// (10% nulls, 1000 distinct strings of 8 to 24 characters). Measures writing a file,
+// opening it (reading and parsing the footer) and reading each column through
+// ColumnChunkReader, chunk read, decompression and decoding included. The files are in
+// the page cache, so reads are not I/O bound.
+
+namespace
+{
+    constexpr size_t kRowGroupRows = 128 * 1024;
+    constexpr int64_t kColumns = 3;
+
+    std::vector<ColumnDescriptor> benchmarkColumns()
+    {
+        std::vector<ColumnDescriptor> columns(kColumns);
+        columns[0].path = {"id"};
+        columns[0].type = AtomicType::INT64;
+        columns[1].path = {"value"};
+        columns[1].type = AtomicType::DOUBLE;
+        columns[2].path = {"name"};
+        columns[2].type = AtomicType::BYTE_ARRAY;
+        columns[2].max_definition_level = 1;
+        return columns;
+    }
+
+    /**
+     * @brief The rows of the file, as one batch per column and row group.
+     */
+    std::vector<std::vector<ColumnBatch>> benchmarkRowGroups(size_t rows)
+    {
+        std::vector<int64_t> ids = ascendingIntegers(rows, 10, 1);
+        std::vector<double> values = uniformDoubles(rows, 2);
+        std::vector<std::string> names = randomStrings(rows, 1000, 8, 24, 3);
+        std::vector<uint64_t> nulls = uniformIntegers(rows, 10, 4);
+        std::vector<std::vector<ColumnBatch>> row_groups;
+        for (size_t first = 0; first < rows; first += kRowGroupRows)
+        {
+            size_t count = std::min(kRowGroupRows, rows - first);
+            std::vector<ColumnBatch> &batches = row_groups.emplace_back();
+            batches.emplace_back(AtomicType::INT64);
+            batches.emplace_back(AtomicType::DOUBLE);
+            batches.emplace_back(AtomicType::BYTE_ARRAY);
+            std::copy_n(ids.begin() + first, count, batches[0].appendValues<int64_t>(count));
+            std::copy_n(values.begin() + first, count, batches[1].appendValues<double>(count));
+            for (size_t i = first; i < first + count; ++i)
+            {
+                if (nulls[i] == 0)
+                {
+                    batches[2].appendNulls(1);
+                }
+                else
+                {
+                    batches[2].appendByteArray(reinterpret_cast<const uint8_t *>(names[i].data()), names[i].size());
+                }
+            }
+        }
+        return row_groups;
+    }
+
+    void writeFile(const std::string &path, const std::vector<std::vector<ColumnBatch>> &row_groups,
+                   CompressionCodec codec)
+    {
+        WriterOptions options;
+        options.codec = codec;
+        ParquetFileWriter writer(path, benchmarkColumns(), options);
+        for (const std::vector<ColumnBatch> &batches : row_groups)
+        {
+            writer.writeRowGroup({&batches[0], &batches[1], &batches[2]});
+        }
+        writer.close();
+    }
+
+    std::string benchmarkPath(int64_t codec, int64_t rows)
+    {
+        return "/tmp/parquet_reader_benchmark_" + std::to_string(::getpid()) + "_" + std::to_string(codec) + "_" +
+               std::to_string(rows) + ".parquet";
+    }
+
+    /**
+     * @brief Writes each (codec, rows) file once per process and removes them at exit.
+     */
+    class BenchmarkFiles
+    {
+    public:
+        ~BenchmarkFiles()
+        {
+            for (const auto &[key, path] : paths_)
+            {
+                std::remove(path.c_str());
+            }
+        }
+
+        const std::string &path(int64_t codec, int64_t rows)
+        {
+            auto [it, inserted] = paths_.try_emplace({codec, rows}, benchmarkPath(codec, rows));
+            if (inserted)
+            {
+                writeFile(it->second, benchmarkRowGroups(static_cast<size_t>(rows)),
+                          static_cast<CompressionCodec>(codec));
+            }
+            return it->second;
+        }
+
+    private:
+        std::map<std::pair<int64_t, int64_t>, std::string> paths_;
+    };
+
+    BenchmarkFiles &benchmarkFiles()
+    {
+        static BenchmarkFiles files;
+        return files;
+    }
+
+    void fileArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"codec", "rows"});
+        for (CompressionCodec codec : {CompressionCodec::UNCOMPRESSED, CompressionCodec::SNAPPY})
+        {
+            for (int64_t rows : benchmarkSizes(1000000))
+            {
+                benchmark->Args({static_cast<int64_t>(codec), rows});
+            }
+        }
+        benchmark->Unit(benchmark::kMicrosecond);
+    }
+
+    void columnArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"codec", "column", "rows"});
+        for (CompressionCodec codec : {CompressionCodec::UNCOMPRESSED, CompressionCodec::SNAPPY})
+        {
+            for (int64_t column = 0; column < kColumns; ++column)
+            {
+                for (int64_t rows : benchmarkSizes(1000000))
+                {
+                    benchmark->Args({static_cast<int64_t>(codec), column, rows});
+                }
+            }
+        }
+        benchmark->Unit(benchmark::kMicrosecond);
+    }
+} // namespace
+
+static void BM_WriteFile(benchmark::State &state)
+{
+    std::vector<std::vector<ColumnBatch>> row_groups = benchmarkRowGroups(static_cast<size_t>(state.range(1)));
+    std::string path = benchmarkPath(state.range(0), state.range(1)) + ".write";
+    for (auto _ : state)
+    {
+        writeFile(path, row_groups, static_cast<CompressionCodec>(state.range(0)));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+    state.counters["file_bytes"] = static_cast<double>(ParquetFileReader(path).size());
+    std::remove(path.c_str());
+}
+
+static void BM_OpenFile(benchmark::State &state)
+{
+    const std::string &path = benchmarkFiles().path(state.range(0), state.range(1));
+    for (auto _ : state)
+    {
+        ParquetFileReader reader(path);
+        benchmark::DoNotOptimize(reader.numRowGroups());
+    }
+}
+
+static void BM_ReadColumn(benchmark::State &state)
+{
+    ParquetFileReader reader(benchmarkFiles().path(state.range(0), state.range(2)));
+    auto column = static_cast<size_t>(state.range(1));
+    uint64_t bytes = 0;
+    for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+    {
+        bytes += reader.columnChunkRange(rg, column).length;
+    }
+    for (auto _ : state)
+    {
+        for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+        {
+            ColumnChunkReader chunk = reader.columnChunk(rg, column);
+            ColumnBatch batch(reader.columns()[column].type);
+            while (chunk.hasNext())
+            {
+                batch.clear();
+                chunk.readBatch(batch, kDefaultBatchSize);
+                benchmark::DoNotOptimize(batch.data());
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(2));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+BENCHMARK(BM_WriteFile)->Apply(fileArgs);
+BENCHMARK(BM_OpenFile)->Apply(fileArgs);
+BENCHMARK(BM_ReadColumn)->Apply(columnArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,638 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "compression.hpp"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+namespace
+{
+    ColumnDescriptor column(std::string name, AtomicType type, bool optional, int32_t type_length = 0)
+    {
+        ColumnDescriptor descriptor;
+        descriptor.path = {std::move(name)};
+        descriptor.type = type;
+        descriptor.type_length = type_length;
+        descriptor.max_definition_level = optional ? 1 : 0;
+        return descriptor;
+    }
+
+    std::string tempPath(const std::string &name)
+    {
+        return testing::TempDir() + "/" + name;
+    }
+
+    std::string slotBytes(const ColumnBatch &batch, size_t i)
+    {
+        if (batch.type() == AtomicType::BYTE_ARRAY)
+        {
+            return std::string(batch.byteArray(i));
+        }
+        return std::string(reinterpret_cast<const char *>(batch.values<uint8_t>() + i * batch.valueWidth()),
+                           batch.valueWidth());
+    }
+} // namespace
+
+TEST(CompressionTest, SnappyRoundTrip)
+{
+    std::mt19937 rng(1);
+    std::vector<std::vector<uint8_t>> inputs = {{}, {42}};
+    std::vector<uint8_t> random(200000);
+    for (auto &byte : random)
+    {
+        byte = static_cast<uint8_t>(rng());
+    }
+    inputs.push_back(random);
+    std::vector<uint8_t> repetitive;
+    for (int i = 0; i < 300000; ++i)
+    {
+        repetitive.push_back(static_cast<uint8_t>("abcabcabd"[i % 9]));
+    }
+    inputs.push_back(repetitive);
+
+    for (const auto &input : inputs)
+    {
+        std::vector<uint8_t> compressed(maxCompressedLength(CompressionCodec::SNAPPY, input.size()));
+        compressed.resize(compress(CompressionCodec::SNAPPY, input.data(), input.size(), compressed.data()));
+        std::vector<uint8_t> output(input.size());
+        decompress(CompressionCodec::SNAPPY, compressed.data(), compressed.size(), output.data(), output.size());
+        EXPECT_EQ(output, input);
+    }
+
+    std::vector<uint8_t> compressed(maxCompressedLength(CompressionCodec::SNAPPY, repetitive.size()));
+    compressed.resize(compress(CompressionCodec::SNAPPY, repetitive.data(), repetitive.size(), compressed.data()));
+    EXPECT_LT(compressed.size(), repetitive.size() / 10);
+}
+
+TEST(CompressionTest, SnappyRejectsCorruptInput)
+{
+    std::vector<uint8_t> output(16);
+    // Copy whose offset points before the start of the output
+    const uint8_t bad_copy[] = {16, 0x01 << 2 | 2, 0x10, 0x00};
+    EXPECT_THROW(decompress(CompressionCodec::SNAPPY, bad_copy, sizeof(bad_copy), output.data(), output.size()),
+                 ParquetException);
+    // Literal longer than the input
+    const uint8_t bad_literal[] = {16, 15 << 2, 'a'};
+    EXPECT_THROW(decompress(CompressionCodec::SNAPPY, bad_literal, sizeof(bad_literal), output.data(),
+                            output.size()),
+                 ParquetException);
+    EXPECT_THROW(maxCompressedLength(CompressionCodec::BROTLI, 1), ParquetException);
+}
+
+class ParquetRoundTripTest : public testing::TestWithParam<std::tuple<CompressionCodec, bool>>
+{
+};
+
+TEST_P(ParquetRoundTripTest, ReadsBackWrittenColumns)
+{
+    auto [codec, adaptive] = GetParam();
+    std::string path = tempPath("round_trip_" + std::to_string(static_cast<int>(codec)) + "_" +
+                                std::to_string(adaptive) + ".parquet");
+    std::vector<ColumnDescriptor> columns = {
+        column("id", AtomicType::INT64, false),
+        column("name", AtomicType::BYTE_ARRAY, true),
+        column("flag", AtomicType::BOOLEAN, false),
+        column("score", AtomicType::DOUBLE, true),
+        column("code", AtomicType::FIXED_LEN_BYTE_ARRAY, false, 3),
+    };
+
+    const size_t rows_per_group = 2500;
+    const size_t row_groups = 3;
+    {
+        WriterOptions options;
+        options.codec = codec;
+        options.page_size = 1000; // Many pages per chunk
+        options.adaptive_encoding = adaptive;
+        ParquetFileWriter writer(path, columns, options);
+        for (size_t g = 0; g < row_groups; ++g)
+        {
+            ColumnBatch ids(AtomicType::INT64);
+            ColumnBatch names(AtomicType::BYTE_ARRAY);
+            ColumnBatch flags(AtomicType::BOOLEAN);
+            ColumnBatch scores(AtomicType::DOUBLE);
+            ColumnBatch codes(AtomicType::FIXED_LEN_BYTE_ARRAY, 3);
+            for (size_t i = 0; i < rows_per_group; ++i)
+            {
+                size_t row = g * rows_per_group + i;
+                *ids.appendValues<int64_t>(1) = static_cast<int64_t>(row);
+                if (row % 3 == 0)
+                {
+                    names.appendNulls(1);
+                }
+                else
+                {
+                    std::string name = "name" + std::to_string(row);
+                    names.appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+                }
+                *flags.appendValues<uint8_t>(1) = row % 2;
+                if (row % 5 == 0)
+                {
+                    scores.appendNulls(1);
+                }
+                else
+                {
+                    *scores.appendValues<double>(1) = static_cast<double>(row) / 4;
+                }
+                uint8_t *code = codes.appendValues<uint8_t>(1); // One slot of type_length bytes
+                code[0] = 'a' + row % 26;
+                code[1] = 'b';
+                code[2] = 'c';
+            }
+            writer.writeRowGroup({&ids, &names, &flags, &scores, &codes});
+        }
+        writer.close();
+    }
+
+    ParquetFileReader reader(path);
+    ASSERT_EQ(reader.numRowGroups(), row_groups);
+    ASSERT_EQ(reader.columns().size(), columns.size());
+    EXPECT_EQ(reader.metadata().num_rows, static_cast<int64_t>(rows_per_group * row_groups));
+    EXPECT_EQ(reader.columns()[1].max_definition_level, 1);
+
+    for (size_t g = 0; g < row_groups; ++g)
+    {
+        std::vector<ColumnBatch> batches;
+        for (size_t c = 0; c < columns.size(); ++c)
+        {
+            ColumnChunkReader chunk = reader.columnChunk(g, c);
+            ColumnBatch batch(columns[c].type, columns[c].type_length);
+            // Odd batch size so batches straddle page boundaries
+            while (chunk.readBatch(batch, 777) > 0)
+            {
+            }
+            EXPECT_FALSE(chunk.hasNext());
+            batches.push_back(std::move(batch));
+        }
+        for (size_t i = 0; i < rows_per_group; ++i)
+        {
+            size_t row = g * rows_per_group + i;
+            ASSERT_EQ(batches[0].value<int64_t>(i), static_cast<int64_t>(row));
+            ASSERT_EQ(batches[1].isValid(i), row % 3 != 0);
+            if (row % 3 != 0)
+            {
+                ASSERT_EQ(batches[1].byteArray(i), "name" + std::to_string(row));
+            }
+            ASSERT_EQ(batches[2].value<uint8_t>(i), row % 2);
+            ASSERT_EQ(batches[3].isValid(i), row % 5 != 0);
+            if (row % 5 != 0)
+            {
+                ASSERT_EQ(batches[3].value<double>(i), static_cast<double>(row) / 4);
+            }
+            ASSERT_EQ(batches[4].byteArray(i), std::string(1, static_cast<char>('a' + row % 26)) + "bc");
+        }
+    }
+    std::remove(path.c_str());
+}
+
+INSTANTIATE_TEST_SUITE_P(CodecsAndEncodings, ParquetRoundTripTest,
+                         testing::Combine(testing::Values(CompressionCodec::UNCOMPRESSED, CompressionCodec::SNAPPY),
+                                          testing::Bool()));
+
+TEST(ParquetFileReaderTest, RejectsInvalidFiles)
+{
+    std::string path = tempPath("not_parquet.parquet");
+    FILE *file = std::fopen(path.c_str(), "wb");
+    std::fputs("this is definitely not a parquet file", file);
+    std::fclose(file);
+    EXPECT_THROW(ParquetFileReader reader(path), ParquetException);
+    std::remove(path.c_str());
+
+    EXPECT_THROW(ParquetFileReader reader(tempPath("missing.parquet")), std::system_error);
+}
+
+TEST(ParquetFileWriterTest, RejectsMismatchedBatches)
+{
+    std::string path = tempPath("mismatch.parquet");
+    ParquetFileWriter writer(path, {column("a", AtomicType::INT32, false), column("b", AtomicType::INT32, false)});
+    ColumnBatch a(AtomicType::INT32);
+    ColumnBatch b(AtomicType::INT32);
+    a.appendValues<int32_t>(2);
+    b.appendValues<int32_t>(1);
+    EXPECT_THROW(writer.writeRowGroup({&a, &b}), std::invalid_argument);
+
+    ColumnBatch nulls(AtomicType::INT32);
+    nulls.appendNulls(2);
+    EXPECT_THROW(writer.writeRowGroup({&a, &nulls}), std::invalid_argument);
+    writer.close();
+    std::remove(path.c_str());
+}
+
+TEST(ParquetFileWriterTest, WritesNestedColumnsAndStatistics)
+{
+    // required group g { optional group o { optional int64 x; } required binary s; }
+    std::vector<SchemaElement> schema(5);
+    schema[0].name = "schema";
+    schema[0].num_children = 1;
+    schema[1].name = "g";
+    schema[1].repetition_type = FieldRepetitionType::REQUIRED;
+    schema[1].num_children = 2;
+    schema[2].name = "o";
+    schema[2].repetition_type = FieldRepetitionType::OPTIONAL;
+    schema[2].num_children = 1;
+    schema[3].name = "x";
+    schema[3].type = AtomicType::INT64;
+    schema[3].repetition_type = FieldRepetitionType::OPTIONAL;
+    schema[4].name = "s";
+    schema[4].type = AtomicType::BYTE_ARRAY;
+    schema[4].repetition_type = FieldRepetitionType::REQUIRED;
+
+    std::string path = tempPath("nested.parquet");
+    ParquetFileWriter writer(path, schema);
+    ColumnBatch x(AtomicType::INT64);
+    ColumnBatch strings(AtomicType::BYTE_ARRAY);
+    x.appendNulls(2);
+    *x.appendValues<int64_t>(1) = -7;
+    *x.appendValues<int64_t>(1) = 40;
+    std::string long_string(100, 'z');
+    for (std::string_view value : {std::string_view("b"), std::string_view("a\xff"), std::string_view(long_string),
+                                   std::string_view("")})
+    {
+        strings.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+    }
+    // o is null in row 0, x in row 1
+    std::vector<int16_t> x_levels = {0, 1, 2, 2};
+    EXPECT_THROW(writer.writeRowGroup({&x, &strings}, {std::vector<int16_t>{0, 1, 2, 1}.data(), nullptr}),
+                 std::invalid_argument);
+    EXPECT_THROW(writer.writeRowGroup({&x, &strings}, {std::vector<int16_t>{0, 3, 2, 2}.data(), nullptr}),
+                 std::invalid_argument);
+    writer.writeRowGroup({&x, &strings}, {x_levels.data(), nullptr});
+    writer.close();
+
+    ParquetFileReader reader(path);
+    ASSERT_EQ(reader.columns().size(), 2u);
+    EXPECT_EQ(reader.columns()[0].dottedPath(), "g.o.x");
+    EXPECT_EQ(reader.columns()[0].max_definition_level, 2);
+
+    const Statistics &x_statistics = *reader.columnMetaData(0, 0).statistics;
+    EXPECT_EQ(x_statistics.null_count, 2);
+    int64_t min = 0;
+    int64_t max = 0;
+    std::memcpy(&min, x_statistics.min_value->data(), sizeof(min));
+    std::memcpy(&max, x_statistics.max_value->data(), sizeof(max));
+    EXPECT_EQ(min, -7);
+    EXPECT_EQ(max, 40);
+
+    const Statistics &string_statistics = *reader.columnMetaData(0, 1).statistics;
+    EXPECT_EQ(string_statistics.min_value, "");
+    EXPECT_EQ(string_statistics.max_value, std::string(63, 'z') + "{");
+    EXPECT_EQ(string_statistics.is_max_value_exact, false);
+
+    ColumnBatch batch(AtomicType::INT64);
+    ColumnChunkReader chunk = reader.columnChunk(0, 0);
+    while (chunk.readBatch(batch, kDefaultBatchSize) > 0)
+    {
+    }
+    ASSERT_EQ(batch.length(), 4u);
+    EXPECT_FALSE(batch.isValid(0));
+    EXPECT_FALSE(batch.isValid(1));
+    EXPECT_EQ(batch.value<int64_t>(3), 40);
+    std::remove(path.c_str());
+}
+
+TEST(ParquetFileWriterTest, PicksEncodingsPerPage)
+{
+    std::string path = tempPath("encodings.parquet");
+    std::vector<ColumnDescriptor> columns = {
+        column("id", AtomicType::INT64, false),      column("category", AtomicType::BYTE_ARRAY, true),
+        column("url", AtomicType::BYTE_ARRAY, false), column("random", AtomicType::INT32, false),
+        column("pinned", AtomicType::INT32, false),  column("overflow", AtomicType::INT64, false),
+    };
+    const size_t rows = 20000;
+    ColumnBatch ids(AtomicType::INT64);
+    ColumnBatch categories(AtomicType::BYTE_ARRAY);
+    ColumnBatch urls(AtomicType::BYTE_ARRAY);
+    ColumnBatch random(AtomicType::INT32);
+    ColumnBatch pinned(AtomicType::INT32);
+    ColumnBatch overflow(AtomicType::INT64);
+    std::mt19937 rng(11);
+    for (size_t row = 0; row < rows; ++row)
+    {
+        *ids.appendValues<int64_t>(1) = static_cast<int64_t>(1000000 + row * 3);
+        if (row % 10 == 0)
+        {
+            categories.appendNulls(1);
+        }
+        else
+        {
+            std::string category = "category" + std::to_string(rng() % 8);
+            categories.appendByteArray(reinterpret_cast<const uint8_t *>(category.data()), category.size());
+        }
+        char url[64];
+        std::snprintf(url, sizeof(url), "https://example.com/items/%08zu", row);
+        urls.appendByteArray(reinterpret_cast<const uint8_t *>(url), std::strlen(url));
+        *random.appendValues<int32_t>(1) = static_cast<int32_t>(rng());
+        *pinned.appendValues<int32_t>(1) = static_cast<int32_t>(row % 5);
+        *overflow.appendValues<int64_t>(1) = static_cast<int64_t>(rng());
+    }
+
+    WriterOptions options;
+    options.adaptive_encoding = true;
+    options.page_size = 16 * 1024;
+    options.column_encodings = {{"pinned", Encoding::BYTE_STREAM_SPLIT}, {"overflow", Encoding::RLE_DICTIONARY}};
+    options.max_dictionary_size = 1000;
+    {
+        ParquetFileWriter writer(path, columns, options);
+        writer.writeRowGroup({&ids, &categories, &urls, &random, &pinned, &overflow});
+        writer.close();
+    }
+
+    ParquetFileReader reader(path);
+    auto encodings = [&reader](size_t column) { return reader.columnMetaData(0, column).encodings; };
+    EXPECT_EQ(encodings(0), (std::vector<Encoding>{Encoding::RLE, Encoding::DELTA_BINARY_PACKED}));
+    EXPECT_EQ(encodings(1), (std::vector<Encoding>{Encoding::PLAIN, Encoding::RLE, Encoding::RLE_DICTIONARY}));
+    EXPECT_TRUE(reader.columnMetaData(0, 1).dictionary_page_offset.has_value());
+    EXPECT_EQ(encodings(2), (std::vector<Encoding>{Encoding::RLE, Encoding::DELTA_BYTE_ARRAY}));
+    EXPECT_EQ(encodings(3), (std::vector<Encoding>{Encoding::PLAIN, Encoding::RLE}));
+    EXPECT_EQ(encodings(4), (std::vector<Encoding>{Encoding::RLE, Encoding::BYTE_STREAM_SPLIT}));
+    // The dictionary outgrew its limit
+    EXPECT_EQ(encodings(5), (std::vector<Encoding>{Encoding::PLAIN, Encoding::RLE}));
+    EXPECT_LT(reader.columnMetaData(0, 0).total_compressed_size, static_cast<int64_t>(rows * sizeof(int64_t) / 4));
+
+    const ColumnBatch *expected[] = {&ids, &categories, &urls, &random, &pinned, &overflow};
+    for (size_t c = 0; c < columns.size(); ++c)
+    {
+        ColumnBatch batch(columns[c].type);
+        ColumnChunkReader chunk = reader.columnChunk(0, c);
+        while (chunk.readBatch(batch, 999) > 0)
+        {
+        }
+        ASSERT_EQ(batch.length(), rows);
+        for (size_t i = 0; i < rows; ++i)
+        {
+            ASSERT_EQ(batch.isValid(i), expected[c]->isValid(i));
+            if (batch.isValid(i))
+            {
+                ASSERT_EQ(slotBytes(batch, i), slotBytes(*expected[c], i)) << c << " " << i;
+            }
+        }
+    }
+    std::remove(path.c_str());
+
+    options.column_encodings = {{"category", Encoding::DELTA_BINARY_PACKED}};
+    EXPECT_THROW(ParquetFileWriter(path, columns, options), std::invalid_argument);
+    options.column_encodings = {{"missing", Encoding::PLAIN}};
+    EXPECT_THROW(ParquetFileWriter(path, columns, options), std::invalid_argument);
+}
+
+TEST(ParquetFileWriterTest, WritesPageIndexAndSizeStatistics)
+{
+    std::string path = tempPath("page_index.parquet");
+    std::vector<ColumnDescriptor> columns = {column("x", AtomicType::DOUBLE, true),
+                                             column("s", AtomicType::BYTE_ARRAY, false)};
+    const size_t rows = 1000;
+    ColumnBatch x(AtomicType::DOUBLE);
+    ColumnBatch strings(AtomicType::BYTE_ARRAY);
+    for (size_t row = 0; row < rows; ++row)
+    {
+        // Rows 300 to 399 are all null, descending values otherwise
+        if (row >= 300 && row < 400)
+        {
+            x.appendNulls(1);
+        }
+        else
+        {
+            *x.appendValues<double>(1) = -static_cast<double>(row);
+        }
+        std::string value(row % 7, 'a');
+        strings.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+    }
+    WriterOptions options;
+    options.page_row_limit = 100;
+    {
+        ParquetFileWriter writer(path, columns, options);
+        writer.writeRowGroup({&x, &strings});
+        writer.close();
+    }
+
+    ParquetFileReader reader(path);
+    const ColumnMetaData &metadata = reader.columnMetaData(0, 0);
+    double min = 0;
+    std::memcpy(&min, metadata.statistics->min_value->data(), sizeof(min));
+    EXPECT_EQ(min, -999.0);
+    EXPECT_EQ(metadata.statistics->null_count, 100);
+    ASSERT_TRUE(metadata.size_statistics);
+    EXPECT_EQ(metadata.size_statistics->definition_level_histogram, (std::vector<int64_t>{100, 900}));
+
+    auto column_index = reader.columnIndex(0, 0);
+    ASSERT_NE(column_index, nullptr);
+    ASSERT_EQ(column_index->null_pages.size(), 10u);
+    EXPECT_TRUE(column_index->null_pages[3]);
+    EXPECT_FALSE(column_index->null_pages[4]);
+    EXPECT_EQ(column_index->null_counts[3], 100);
+    EXPECT_EQ(column_index->boundary_order, BoundaryOrder::DESCENDING);
+    double page_max = 0;
+    std::memcpy(&page_max, column_index->max_values[4].data(), sizeof(page_max));
+    EXPECT_EQ(page_max, -400.0);
+    EXPECT_EQ(column_index->definition_level_histograms.size(), 20u);
+
+    auto offset_index = reader.offsetIndex(0, 0);
+    ASSERT_NE(offset_index, nullptr);
+    ASSERT_EQ(offset_index->page_locations.size(), 10u);
+    EXPECT_EQ(offset_index->page_locations[0].offset, metadata.data_page_offset);
+    for (size_t page = 1; page < 10; ++page)
+    {
+        const PageLocation &previous = offset_index->page_locations[page - 1];
+        EXPECT_EQ(offset_index->page_locations[page].offset, previous.offset + previous.compressed_page_size);
+        EXPECT_EQ(offset_index->page_locations[page].first_row_index, static_cast<int64_t>(page * 100));
+    }
+
+    const ColumnMetaData &string_metadata = reader.columnMetaData(0, 1);
+    int64_t string_bytes = 0;
+    for (size_t row = 0; row < rows; ++row)
+    {
+        string_bytes += static_cast<int64_t>(row % 7);
+    }
+    EXPECT_EQ(string_metadata.size_statistics->unencoded_byte_array_data_bytes, string_bytes);
+    // Every page has the same bounds, which counts as ascending
+    EXPECT_EQ(reader.columnIndex(0, 1)->boundary_order, BoundaryOrder::ASCENDING);
+    auto string_offsets = reader.offsetIndex(0, 1);
+    EXPECT_EQ(string_offsets->unencoded_byte_array_data_bytes.size(), 10u);
+    std::remove(path.c_str());
+
+    options.write_page_index = false;
+    {
+        ParquetFileWriter writer(path, columns, options);
+        writer.writeRowGroup({&x, &strings});
+        writer.close();
+    }
+    ParquetFileReader without_index(path);
+    EXPECT_EQ(without_index.columnIndex(0, 0), nullptr);
+    EXPECT_EQ(without_index.offsetIndex(0, 0), nullptr);
+    std::remove(path.c_str());
+}
+
+TEST(ColumnChunkReaderTest, SkipsPagesAndReadsSelectedRows)
+{
+    std::string path = tempPath("selected_rows.parquet");
+    std::vector<ColumnDescriptor> columns = {column("id", AtomicType::INT64, true),
+                                             column("name", AtomicType::BYTE_ARRAY, false)};
+    const size_t rows = 2000;
+    ColumnBatch ids(AtomicType::INT64);
+    ColumnBatch names(AtomicType::BYTE_ARRAY);
+    for (size_t row = 0; row < rows; ++row)
+    {
+        if (row % 5 == 0)
+        {
+            ids.appendNulls(1);
+        }
+        else
+        {
+            *ids.appendValues<int64_t>(1) = static_cast<int64_t>(row);
+        }
+        std::string name = "name" + std::to_string(row % 40);
+        names.appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+    }
+    WriterOptions options;
+    options.codec = CompressionCodec::SNAPPY;
+    options.page_row_limit = 100;
+    options.column_encodings = {{"name", Encoding::RLE_DICTIONARY}};
+    {
+        ParquetFileWriter writer(path, columns, options);
+        writer.writeRowGroup({&ids, &names});
+        writer.close();
+    }
+
+    // Rows 250 to 259, row 1234 and every third row from 1500 on: 7 of 20 pages
+    Bitmap selection(rows);
+    selection.setRange(250, 260, true);
+    selection.set(1234);
+    std::vector<size_t> selected_rows;
+    for (size_t row = 0; row < rows; ++row)
+    {
+        if (row >= 1500 && row % 3 == 0)
+        {
+            selection.set(row);
+        }
+        if (selection[row])
+        {
+            selected_rows.push_back(row);
+        }
+    }
+
+    ParquetFileReader reader(path);
+    const ColumnBatch *expected[] = {&ids, &names};
+    for (size_t c = 0; c < columns.size(); ++c)
+    {
+        for (bool select_pages : {false, true})
+        {
+            ColumnChunkReader chunk = reader.columnChunk(0, c);
+            if (select_pages)
+            {
+                chunk.selectPages(*reader.offsetIndex(0, c), reader.columnChunkRange(0, c).offset, selection);
+            }
+            ColumnBatch batch(columns[c].type);
+            for (size_t first = 0; first < rows; first += 300)
+            {
+                chunk.readSelected(batch, selection, first, std::min<size_t>(300, rows - first));
+            }
+            EXPECT_EQ(chunk.skip(10), 0u);
+            ASSERT_EQ(batch.length(), selected_rows.size());
+            for (size_t i = 0; i < selected_rows.size(); ++i)
+            {
+                ASSERT_EQ(batch.isValid(i), expected[c]->isValid(selected_rows[i]));
+                ASSERT_EQ(slotBytes(batch, i), slotBytes(*expected[c], selected_rows[i])) << c << " " << i;
+            }
+        }
+    }
+
+    // Pages left out are not decompressed, and cannot be read
+    ColumnChunkReader all = reader.columnChunk(0, 0);
+    all.decompress();
+    ColumnChunkReader selected = reader.columnChunk(0, 0);
+    selected.selectPages(*reader.offsetIndex(0, 0), reader.columnChunkRange(0, 0).offset, selection);
+    selected.decompress();
+    EXPECT_LT(selected.uncompressedSize(), all.uncompressedSize() * 7 / 20 + 100);
+    EXPECT_EQ(selected.skip(250), 250u);
+    ColumnBatch batch(AtomicType::INT64);
+    EXPECT_EQ(selected.readBatch(batch, 50), 50u);
+    EXPECT_THROW(selected.readBatch(batch, 1000), ParquetException);
+    EXPECT_THROW(selected.selectPages(*reader.offsetIndex(0, 0), 0, selection), std::logic_error);
+
+    ColumnChunkReader mismatched = reader.columnChunk(0, 0);
+    EXPECT_THROW(mismatched.selectPages(*reader.offsetIndex(0, 1), reader.columnChunkRange(0, 0).offset,
+                                        selection),
+                 ParquetException);
+    std::remove(path.c_str());
+}
+
+TEST(ColumnChunkReaderTest, KeepsDictionaryIndices)
+{
+    // A few distinct values far apart followed by ascending ones: the first pages are
+    // dictionary encoded and the later ones DELTA_BINARY_PACKED
+    std::string path = tempPath("dictionary_indices.parquet");
+    std::vector<ColumnDescriptor> columns = {column("value", AtomicType::INT32, true)};
+    const size_t rows = 6000;
+    ColumnBatch values(AtomicType::INT32);
+    for (size_t row = 0; row < rows; ++row)
+    {
+        if (row % 7 == 0)
+        {
+            values.appendNulls(1);
+        }
+        else
+        {
+            *values.appendValues<int32_t>(1) = static_cast<int32_t>(row < rows / 2 ? row * 7919 % 5 * 1000003 : row);
+        }
+    }
+    WriterOptions options;
+    options.adaptive_encoding = true;
+    options.page_row_limit = 1000;
+    {
+        ParquetFileWriter writer(path, columns, options);
+        writer.writeRowGroup({&values});
+        writer.close();
+    }
+    ParquetFileReader reader(path);
+    std::vector<Encoding> encodings = reader.columnMetaData(0, 0).encodings;
+    ASSERT_NE(std::find(encodings.begin(), encodings.end(), Encoding::RLE_DICTIONARY), encodings.end());
+    ASSERT_NE(std::find(encodings.begin(), encodings.end(), Encoding::DELTA_BINARY_PACKED), encodings.end());
+
+    auto expectValues = [&values](const ColumnBatch &batch, size_t first)
+    {
+        for (size_t i = 0; i < batch.length(); ++i)
+        {
+            ASSERT_EQ(batch.isValid(i), values.isValid(first + i));
+            if (!batch.isValid(i))
+            {
+                continue;
+            }
+            int32_t value = batch.isDictionaryEncoded() ? batch.dictionary()->value<int32_t>(
+                                                              static_cast<size_t>(batch.indices()[i]))
+                                                        : batch.value<int32_t>(i);
+            ASSERT_EQ(value, values.value<int32_t>(first + i)) << first + i;
+        }
+    };
+
+    // Batches of a page hold indices until the pages switch to values
+    ColumnChunkReader chunk = reader.columnChunk(0, 0);
+    chunk.keepDictionaryIndices();
+    ColumnBatch batch(AtomicType::INT32);
+    size_t first = 0;
+    std::vector<bool> encoded;
+    while (chunk.readBatch(batch, 500) > 0)
+    {
+        encoded.push_back(batch.isDictionaryEncoded());
+        expectValues(batch, first);
+        first += batch.length();
+        batch.clear();
+    }
+    EXPECT_EQ(first, rows);
+    EXPECT_TRUE(encoded.front());
+    EXPECT_FALSE(encoded.back());
+
+    // A batch spanning both kinds of pages is materialized
+    ColumnChunkReader whole = reader.columnChunk(0, 0);
+    whole.keepDictionaryIndices();
+    ColumnBatch all(AtomicType::INT32);
+    EXPECT_EQ(whole.readBatch(all, rows), rows);
+    EXPECT_FALSE(all.isDictionaryEncoded());
+    expectValues(all, 0);
+    std::remove(path.c_str());
+}
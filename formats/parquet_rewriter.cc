@@ -0,0 +1,508 @@
+#include "parquet_rewriter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace
+{
+    size_t columnIndex(const std::vector<ColumnDescriptor> &descriptors, const std::string &name)
+    {
+        auto it = std::find_if(descriptors.begin(), descriptors.end(), [&name](const ColumnDescriptor &column)
+                               { return column.dottedPath() == name; });
+        if (it == descriptors.end())
+        {
+            throw std::invalid_argument("Unknown column " + name);
+        }
+        return static_cast<size_t>(it - descriptors.begin());
+    }
+
+    /**
+     * @brief Appends the element at `index` and its subtree to `out`, without the leaves
+     * `keep` drops and the groups left without leaves. Returns the number of leaves kept.
+     */
+    size_t pruneSchema(const std::vector<SchemaElement> &schema, size_t &index, const std::vector<bool> &keep,
+                       size_t &leaf, std::vector<SchemaElement> &out)
+    {
+        const SchemaElement &element = schema[index++];
+        if (element.num_children.value_or(0) <= 0)
+        {
+            if (!keep[leaf++])
+            {
+                return 0;
+            }
+            out.push_back(element);
+            return 1;
+        }
+        size_t position = out.size();
+        out.push_back(element);
+        int32_t children = 0;
+        size_t kept = 0;
+        for (int32_t i = 0; i < *element.num_children; ++i)
+        {
+            size_t leaves = pruneSchema(schema, index, keep, leaf, out);
+            children += leaves > 0 ? 1 : 0;
+            kept += leaves;
+        }
+        if (kept == 0)
+        {
+            out.resize(position);
+            return 0;
+        }
+        out[position].num_children = children;
+        return kept;
+    }
+
+    /**
+     * @brief The value encoding of the data pages of a chunk, pinned on its column when it
+     * is re-encoded so it keeps its encoding; nullopt for PLAIN and encodings the writer
+     * does not write.
+     */
+    std::optional<Encoding> chunkEncoding(const ColumnMetaData &metadata)
+    {
+        if (metadata.type == AtomicType::BOOLEAN)
+        {
+            return std::nullopt;
+        }
+        const std::vector<Encoding> &encodings = metadata.encodings;
+        auto has = [&encodings](Encoding encoding)
+        { return std::find(encodings.begin(), encodings.end(), encoding) != encodings.end(); };
+        bool dictionary_page = metadata.dictionary_page_offset && *metadata.dictionary_page_offset > 0;
+        if (dictionary_page || has(Encoding::RLE_DICTIONARY) || has(Encoding::PLAIN_DICTIONARY))
+        {
+            return Encoding::RLE_DICTIONARY;
+        }
+        for (Encoding encoding :
+             {Encoding::DELTA_BINARY_PACKED, Encoding::DELTA_BYTE_ARRAY, Encoding::BYTE_STREAM_SPLIT})
+        {
+            if (has(encoding))
+            {
+                return encoding;
+            }
+        }
+        return std::nullopt;
+    }
+
+    bool encrypted(const FileMetaData &metadata)
+    {
+        if (metadata.encryption_algorithm)
+        {
+            return true;
+        }
+        for (const RowGroup &row_group : metadata.row_groups)
+        {
+            for (const ColumnChunk &chunk : row_group.columns)
+            {
+                if (chunk.crypto_metadata || chunk.encrypted_column_metadata)
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /// A column chunk of the input: copied, or decoded to be encoded again
+    struct SourceChunk
+    {
+        CopiedColumnChunk copy;
+        std::unique_ptr<ColumnBatch> batch;
+    };
+
+    CopiedColumnChunk copyChunk(const ParquetFileReader &reader, size_t row_group, size_t column)
+    {
+        CopiedColumnChunk copy;
+        copy.metadata = reader.columnMetaData(row_group, column);
+        copy.source_offset = reader.columnChunkRange(row_group, column).offset;
+        copy.bytes = reader.readColumnChunk(row_group, column);
+        copy.column_index = reader.columnIndex(row_group, column);
+        copy.offset_index = reader.offsetIndex(row_group, column);
+        // Serialized again rather than read as is, since bloom_filter_length is optional
+        if (std::shared_ptr<const BloomFilter> filter = reader.bloomFilter(row_group, column))
+        {
+            BloomFilterHeader header;
+            header.num_bytes = static_cast<int32_t>(filter->numBytes());
+            std::vector<uint8_t> bytes = serializeThrift(header);
+            bytes.insert(bytes.end(), filter->bitset().begin(), filter->bitset().end());
+            copy.bloom_filter = Slice::fromVector(std::move(bytes));
+        }
+        return copy;
+    }
+
+    std::unique_ptr<ColumnBatch> decodeChunk(const ParquetFileReader &reader, size_t row_group, size_t column,
+                                             size_t num_rows)
+    {
+        const ColumnDescriptor &descriptor = reader.columns()[column];
+        auto batch = std::make_unique<ColumnBatch>(descriptor.type, descriptor.type_length);
+        ColumnChunkReader chunk = reader.columnChunk(row_group, column);
+        while (batch->length() < num_rows && chunk.readBatch(*batch, num_rows - batch->length()) > 0)
+        {
+        }
+        if (batch->length() != num_rows || chunk.hasNext())
+        {
+            throw ParquetException("Column chunk of " + descriptor.dottedPath() + " in row group " +
+                                   std::to_string(row_group) + " does not hold one value per row");
+        }
+        return batch;
+    }
+
+    template <typename T>
+    bool lessThan(const T &x, const T &y)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            if (std::isnan(x) || std::isnan(y))
+            {
+                return !std::isnan(x);
+            }
+        }
+        return x < y;
+    }
+
+    /**
+     * @brief The rows of `column` ordered by their values, nulls first and NaN above every
+     * other number; rows with equal values keep their order.
+     */
+    template <typename T>
+    std::vector<uint32_t> sortRows(const ColumnBatch &column, bool descending)
+    {
+        // The values are sorted as (value, row) pairs, which keeps equal values in row order
+        // without a stable sort and compares without going back to the batch
+        std::vector<uint32_t> rows;
+        std::vector<std::pair<T, uint32_t>> keyed;
+        keyed.reserve(column.length() - column.nullCount());
+        for (size_t i = 0; i < column.length(); ++i)
+        {
+            auto row = static_cast<uint32_t>(i);
+            if (!column.isValid(i))
+            {
+                rows.push_back(row);
+            }
+            else if constexpr (std::is_same_v<T, std::string_view>)
+            {
+                keyed.emplace_back(column.byteArray(i), row);
+            }
+            else
+            {
+                keyed.emplace_back(column.value<T>(i), row);
+            }
+        }
+        std::sort(keyed.begin(), keyed.end(),
+                  [descending](const std::pair<T, uint32_t> &a, const std::pair<T, uint32_t> &b)
+                  {
+                      const T &x = descending ? b.first : a.first;
+                      const T &y = descending ? a.first : b.first;
+                      if (lessThan(x, y) || lessThan(y, x))
+                      {
+                          return lessThan(x, y);
+                      }
+                      return a.second < b.second;
+                  });
+        for (const std::pair<T, uint32_t> &entry : keyed)
+        {
+            rows.push_back(entry.second);
+        }
+        return rows;
+    }
+
+    std::vector<uint32_t> sortedRows(const ColumnBatch &column, bool descending)
+    {
+        switch (column.type())
+        {
+        case AtomicType::BOOLEAN:
+            return sortRows<uint8_t>(column, descending);
+        case AtomicType::INT32:
+            return sortRows<int32_t>(column, descending);
+        case AtomicType::INT64:
+            return sortRows<int64_t>(column, descending);
+        case AtomicType::FLOAT:
+            return sortRows<float>(column, descending);
+        case AtomicType::DOUBLE:
+            return sortRows<double>(column, descending);
+        case AtomicType::BYTE_ARRAY:
+        case AtomicType::FIXED_LEN_BYTE_ARRAY:
+            break;
+        }
+        return sortRows<std::string_view>(column, descending);
+    }
+
+    template <typename T>
+    void gather(const T *values, const std::vector<uint32_t> &rows, T *out)
+    {
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            out[i] = values[rows[i]];
+        }
+    }
+
+    /**
+     * @brief The slots of `column` in the order of `rows`.
+     */
+    std::unique_ptr<ColumnBatch> permute(const ColumnBatch &column, const std::vector<uint32_t> &rows)
+    {
+        // Like the decoders do: the validity first, then the values of the valid slots back
+        // to back, then spread() moves them to their slots
+        auto out = std::make_unique<ColumnBatch>(column.type(), column.typeLength());
+        std::vector<uint32_t> valid_rows;
+        const std::vector<uint32_t> *dense = &rows;
+        if (column.nullCount() > 0)
+        {
+            std::vector<int16_t> levels(rows.size());
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                levels[i] = column.isValid(rows[i]) ? 1 : 0;
+                if (levels[i] == 1)
+                {
+                    valid_rows.push_back(rows[i]);
+                }
+            }
+            out->appendValidity(levels.data(), rows.size(), 1);
+            dense = &valid_rows;
+        }
+
+        if (column.type() == AtomicType::BYTE_ARRAY)
+        {
+            size_t total = 0;
+            for (uint32_t row : *dense)
+            {
+                total += column.byteArray(row).size();
+            }
+            auto [offsets, data] = out->appendByteArrays(dense->size(), total);
+            size_t position = 0;
+            for (size_t i = 0; i < dense->size(); ++i)
+            {
+                std::string_view value = column.byteArray((*dense)[i]);
+                if (!value.empty())
+                {
+                    std::memcpy(data + position, value.data(), value.size());
+                    position += value.size();
+                }
+                offsets[i] = static_cast<int32_t>(position);
+            }
+        }
+        else
+        {
+            size_t width = column.valueWidth();
+            const uint8_t *values = column.values<uint8_t>();
+            uint8_t *slots = out->appendValues<uint8_t>(dense->size());
+            if (width == sizeof(uint32_t))
+            {
+                gather(reinterpret_cast<const uint32_t *>(values), *dense, reinterpret_cast<uint32_t *>(slots));
+            }
+            else if (width == sizeof(uint64_t))
+            {
+                gather(reinterpret_cast<const uint64_t *>(values), *dense, reinterpret_cast<uint64_t *>(slots));
+            }
+            else
+            {
+                for (size_t i = 0; i < dense->size(); ++i)
+                {
+                    std::memcpy(slots + i * width, values + (*dense)[i] * width, width);
+                }
+            }
+        }
+        if (column.nullCount() > 0)
+        {
+            out->spread(0, rows.size());
+        }
+        return out;
+    }
+} // namespace
+
+RewriteResult rewriteParquetFile(const ParquetFileReader &input, const std::string &output,
+                                 const RewriteOptions &options)
+{
+    const FileMetaData &metadata = input.metadata();
+    const std::vector<ColumnDescriptor> &descriptors = input.columns();
+    if (encrypted(metadata))
+    {
+        throw std::invalid_argument("Encrypted files cannot be rewritten");
+    }
+    if (options.writer.encryption)
+    {
+        throw std::invalid_argument("Rewritten files cannot be encrypted");
+    }
+
+    // The columns to write, as indices into the input's columns
+    std::vector<bool> keep(descriptors.size(), options.columns.empty());
+    for (const std::string &name : options.columns)
+    {
+        keep[columnIndex(descriptors, name)] = true;
+    }
+    std::vector<size_t> columns;
+    for (size_t i = 0; i < descriptors.size(); ++i)
+    {
+        if (keep[i])
+        {
+            columns.push_back(i);
+        }
+    }
+    if (columns.empty())
+    {
+        throw std::invalid_argument("No columns to write");
+    }
+    for (const auto &[name, encoding] : options.column_encodings)
+    {
+        if (!keep[columnIndex(descriptors, name)])
+        {
+            throw std::invalid_argument("Cannot re-encode dropped column " + name);
+        }
+    }
+    std::optional<size_t> sort_column;
+    if (!options.sort_column.empty())
+    {
+        sort_column = columnIndex(descriptors, options.sort_column);
+    }
+
+    // A chunk is copied unless its codec or encoding changes or its rows move
+    auto rewritten = [&](size_t row_group, size_t column)
+    {
+        return sort_column || options.column_encodings.count(descriptors[column].dottedPath()) > 0 ||
+               (options.codec && *options.codec != input.columnMetaData(row_group, column).codec);
+    };
+
+    WriterOptions writer_options = options.writer;
+    writer_options.column_codecs.clear();
+    writer_options.column_encodings = options.column_encodings;
+    writer_options.key_value_metadata = metadata.key_value_metadata;
+    for (size_t column : columns)
+    {
+        const ColumnDescriptor &descriptor = descriptors[column];
+        std::string name = descriptor.dottedPath();
+        bool bloom_filter = false;
+        bool any_rewritten = false;
+        for (size_t rg = 0; rg < input.numRowGroups(); ++rg)
+        {
+            bloom_filter |= input.columnMetaData(rg, column).bloom_filter_offset.has_value();
+            any_rewritten |= rewritten(rg, column);
+        }
+        if (!any_rewritten || input.numRowGroups() == 0)
+        {
+            continue;
+        }
+        // The reader only returns whether a value is present, not which optional group is null
+        if (descriptor.max_definition_level > 1)
+        {
+            throw std::invalid_argument("Column " + name + " below optional groups cannot be re-encoded");
+        }
+        const ColumnMetaData &first = input.columnMetaData(0, column);
+        writer_options.column_codecs[name] = options.codec.value_or(first.codec);
+        std::optional<Encoding> encoding = chunkEncoding(first);
+        if (!options.writer.adaptive_encoding && encoding)
+        {
+            writer_options.column_encodings.try_emplace(name, *encoding);
+        }
+        std::vector<std::string> &bloom_filters = writer_options.bloom_filter_columns;
+        if (bloom_filter && std::find(bloom_filters.begin(), bloom_filters.end(), name) == bloom_filters.end())
+        {
+            bloom_filters.push_back(name);
+        }
+    }
+
+    std::unique_ptr<ThreadPool> owned_pool;
+    ThreadPool *pool = options.pool;
+    if (!pool)
+    {
+        owned_pool = std::make_unique<ThreadPool>(options.threads);
+        pool = owned_pool.get();
+    }
+    writer_options.pool = pool;
+
+    std::vector<SchemaElement> schema;
+    size_t index = 0;
+    size_t leaf = 0;
+    pruneSchema(metadata.schema, index, keep, leaf, schema);
+
+    RewriteResult result;
+    result.input_bytes = input.size();
+    // Written aside and renamed into place, so the output appears complete or not at all
+    // and the input stays readable until then, even where it is the same file
+    std::string temporary = output + ".tmp";
+    try
+    {
+        ParquetFileWriter writer(temporary, std::move(schema), std::move(writer_options));
+
+        // The sort column is decoded along with the written columns, even if it is dropped
+        std::vector<size_t> sources = columns;
+        if (sort_column && !keep[*sort_column])
+        {
+            sources.push_back(*sort_column);
+        }
+        for (size_t rg = 0; rg < input.numRowGroups(); ++rg)
+        {
+            auto num_rows = static_cast<size_t>(metadata.row_groups[rg].num_rows);
+            std::vector<SourceChunk> chunks = parallelMap<SourceChunk>(
+                *pool, sources.size(),
+                [&](size_t i)
+                {
+                    SourceChunk chunk;
+                    if (sources[i] == sort_column || rewritten(rg, sources[i]))
+                    {
+                        chunk.batch = decodeChunk(input, rg, sources[i], num_rows);
+                    }
+                    else
+                    {
+                        chunk.copy = copyChunk(input, rg, sources[i]);
+                    }
+                    return chunk;
+                });
+
+            if (sort_column)
+            {
+                size_t position = static_cast<size_t>(std::find(sources.begin(), sources.end(), *sort_column) -
+                                                      sources.begin());
+                std::vector<uint32_t> rows = sortedRows(*chunks[position].batch, options.descending);
+                std::vector<std::unique_ptr<ColumnBatch>> permuted = parallelMap<std::unique_ptr<ColumnBatch>>(
+                    *pool, columns.size(), [&](size_t i) { return permute(*chunks[i].batch, rows); });
+                for (size_t i = 0; i < columns.size(); ++i)
+                {
+                    chunks[i].batch = std::move(permuted[i]);
+                }
+            }
+
+            std::vector<RowGroupColumn> entries(columns.size());
+            for (size_t i = 0; i < columns.size(); ++i)
+            {
+                if (chunks[i].batch)
+                {
+                    entries[i].batch = chunks[i].batch.get();
+                    ++result.rewritten_chunks;
+                }
+                else
+                {
+                    entries[i].copy = &chunks[i].copy;
+                    ++result.copied_chunks;
+                    result.copied_bytes += chunks[i].copy.bytes.size;
+                }
+            }
+            writer.writeRowGroup(entries, num_rows);
+            ++result.row_groups;
+        }
+        writer.close();
+        std::filesystem::rename(temporary, output);
+    }
+    catch (...)
+    {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        throw;
+    }
+    result.output_bytes = std::filesystem::file_size(output);
+    return result;
+}
+
+RewriteResult rewriteParquetFile(const std::string &input, const std::string &output, const RewriteOptions &options)
+{
+    std::error_code error;
+    if (std::filesystem::equivalent(input, output, error))
+    {
+        throw std::invalid_argument("Cannot rewrite " + input + " onto itself");
+    }
+    ParquetFileReader reader(input);
+    return rewriteParquetFile(reader, output, options);
+}
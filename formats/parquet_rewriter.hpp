@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+#include "thread_pool.hpp"
+
+struct RewriteOptions
+{
+    /// Dotted paths of the columns to keep; empty keeps all. The columns stay in file order.
+    std::vector<std::string> columns;
+
+    /// Codec of every column chunk; unset keeps the codec of each chunk
+    std::optional<CompressionCodec> codec;
+
+    /// Columns to re-encode, by dotted path, see WriterOptions::column_encodings
+    std::map<std::string, Encoding> column_encodings;
+
+    /// Dotted path of the column to sort the rows of every row group by, nulls first; empty
+    /// keeps the row order. The column does not need to be kept.
+    std::string sort_column;
+    bool descending = false;
+
+    /// Options of the re-encoded chunks (page sizes, adaptive encoding, Bloom filters...);
+    /// the codecs, pinned encodings and pool are set by the rewrite. Must not encrypt.
+    WriterOptions writer;
+
+    /// Pool to decode and encode the changed chunks on; when null the rewrite starts its
+    /// own pool of `threads` workers
+    ThreadPool *pool = nullptr;
+    size_t threads = 0;
+};
+
+struct RewriteResult
+{
+    size_t row_groups = 0;
+    size_t copied_chunks = 0;
+    size_t rewritten_chunks = 0;
+
+    /// Bytes of the chunks copied as they are
+    uint64_t copied_bytes = 0;
+
+    uint64_t input_bytes = 0;
+    uint64_t output_bytes = 0;
+};
+
+/**
+ * @brief Writes the rows of `input` to a new Parquet file at `output`, keeping, dropping,
+ * re-compressing, re-encoding or sorting columns as `options` say.
+ *
+ * Row groups stay as they are. A column chunk that does not change (its codec stays, its
+ * encoding is not pinned and the rows are not sorted) is copied byte for byte, together
+ * with its page indexes and Bloom filter; only the offsets in the footer and the offset
+ * index move. The other chunks are decoded and encoded again, in parallel on the pool. A
+ * re-encoded chunk keeps the codec its column has in the first row group unless
+ * `options.codec` is set.
+ *
+ * The file is written to `output` + ".tmp" and renamed to `output` once complete, so a
+ * failed rewrite leaves no partial output behind. Encrypted files are not supported, and
+ * neither is re-encoding columns below optional groups, whose definition levels the
+ * reader does not return.
+ *
+ * @throws std::invalid_argument for unknown columns, encodings the column type does not
+ * allow, encrypted files, columns that cannot be re-encoded or, given the input's path,
+ * an output that is the input file
+ * @throws ParquetException if the input is corrupt
+ * @throws std::system_error on I/O errors
+ */
+RewriteResult rewriteParquetFile(const ParquetFileReader &input, const std::string &output,
+                                 const RewriteOptions &options = {});
+
+RewriteResult rewriteParquetFile(const std::string &input, const std::string &output,
+                                 const RewriteOptions &options = {});
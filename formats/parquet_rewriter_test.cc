@@ -0,0 +1,334 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "bloom_filter.hpp"
+#include "parquet_rewriter.hpp"
+
+namespace
+{
+    const size_t kRowGroups = 3;
+    const size_t kRowsPerGroup = 5000;
+
+    // id: required INT64 r; price: DOUBLE (r * 7919) % 1000 / 4 with every 11th row null;
+    // name: BYTE_ARRAY "name-" + r % 50, dictionary encoded. Snappy, Bloom filters on id.
+    std::string writeInput(const std::string &name)
+    {
+        std::string path = testing::TempDir() + "/" + name;
+        std::vector<ColumnDescriptor> columns(3);
+        columns[0].path = {"id"};
+        columns[0].type = AtomicType::INT64;
+        columns[1].path = {"price"};
+        columns[1].type = AtomicType::DOUBLE;
+        columns[1].max_definition_level = 1;
+        columns[2].path = {"name"};
+        columns[2].type = AtomicType::BYTE_ARRAY;
+        WriterOptions options;
+        options.codec = CompressionCodec::SNAPPY;
+        options.page_row_limit = 1000;
+        options.column_encodings = {{"name", Encoding::RLE_DICTIONARY}};
+        options.bloom_filter_columns = {"id"};
+        options.key_value_metadata = {{"origin", "parquet_rewriter_test"}};
+        ParquetFileWriter writer(path, columns, options);
+        for (size_t g = 0; g < kRowGroups; ++g)
+        {
+            ColumnBatch ids(AtomicType::INT64);
+            ColumnBatch prices(AtomicType::DOUBLE);
+            ColumnBatch names(AtomicType::BYTE_ARRAY);
+            for (size_t i = 0; i < kRowsPerGroup; ++i)
+            {
+                size_t row = g * kRowsPerGroup + i;
+                *ids.appendValues<int64_t>(1) = static_cast<int64_t>(row);
+                if (row % 11 == 0)
+                {
+                    prices.appendNulls(1);
+                }
+                else
+                {
+                    *prices.appendValues<double>(1) = static_cast<double>(row * 7919 % 1000) / 4;
+                }
+                std::string value = "name-" + std::to_string(row % 50);
+                names.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+            }
+            writer.writeRowGroup({&ids, &prices, &names});
+        }
+        writer.close();
+        return path;
+    }
+
+    ColumnBatch readColumn(const ParquetFileReader &reader, size_t row_group, size_t column)
+    {
+        ColumnBatch batch(reader.columns()[column].type);
+        ColumnChunkReader chunk = reader.columnChunk(row_group, column);
+        while (chunk.readBatch(batch, 1000) > 0)
+        {
+        }
+        return batch;
+    }
+
+    // The value of an id, price or name slot as a string, "null" for nulls
+    std::string slot(const ColumnBatch &batch, size_t i)
+    {
+        if (!batch.isValid(i))
+        {
+            return "null";
+        }
+        switch (batch.type())
+        {
+        case AtomicType::INT64:
+            return std::to_string(batch.value<int64_t>(i));
+        case AtomicType::DOUBLE:
+            return std::to_string(batch.value<double>(i));
+        default:
+            return std::string(batch.byteArray(i));
+        }
+    }
+
+    std::vector<std::string> rows(const ParquetFileReader &reader, size_t row_group)
+    {
+        std::vector<ColumnBatch> columns;
+        for (size_t c = 0; c < reader.columns().size(); ++c)
+        {
+            columns.push_back(readColumn(reader, row_group, c));
+        }
+        std::vector<std::string> out;
+        for (size_t i = 0; i < columns[0].length(); ++i)
+        {
+            std::string row;
+            for (const ColumnBatch &column : columns)
+            {
+                row += slot(column, i) + "|";
+            }
+            out.push_back(row);
+        }
+        return out;
+    }
+
+    std::vector<uint8_t> chunkBytes(const ParquetFileReader &reader, size_t row_group, size_t column)
+    {
+        Slice bytes = reader.readColumnChunk(row_group, column);
+        return std::vector<uint8_t>(bytes.data, bytes.data + bytes.size);
+    }
+} // namespace
+
+TEST(ParquetRewriterTest, CopiesUnchangedChunksVerbatim)
+{
+    std::string input_path = writeInput("rewrite_copy_input.parquet");
+    std::string output_path = testing::TempDir() + "/rewrite_copy_output.parquet";
+    RewriteOptions options;
+    options.columns = {"name", "id"};
+    options.threads = 2;
+    RewriteResult result = rewriteParquetFile(input_path, output_path, options);
+    EXPECT_EQ(result.row_groups, kRowGroups);
+    EXPECT_EQ(result.copied_chunks, 2 * kRowGroups);
+    EXPECT_EQ(result.rewritten_chunks, 0u);
+    EXPECT_GT(result.copied_bytes, 0u);
+    EXPECT_LT(result.output_bytes, result.input_bytes);
+    EXPECT_FALSE(std::filesystem::exists(output_path + ".tmp"));
+
+    ParquetFileReader input(input_path);
+    ParquetFileReader output(output_path);
+    ASSERT_EQ(output.columns().size(), 2u);
+    EXPECT_EQ(output.columns()[0].dottedPath(), "id");
+    EXPECT_EQ(output.columns()[1].dottedPath(), "name");
+    EXPECT_EQ(output.metadata().schema.size(), 3u);
+    EXPECT_EQ(output.metadata().schema[0].num_children, 2);
+    EXPECT_EQ(output.metadata().num_rows, static_cast<int64_t>(kRowGroups * kRowsPerGroup));
+    ASSERT_EQ(output.metadata().key_value_metadata.size(), 1u);
+    EXPECT_EQ(output.metadata().key_value_metadata[0].value, "parquet_rewriter_test");
+
+    // Every 3rd row from 2500 on, so the page selection skips the first pages
+    Bitmap selection(kRowsPerGroup);
+    for (size_t row = 2500; row < kRowsPerGroup; row += 3)
+    {
+        selection.set(row);
+    }
+    for (size_t g = 0; g < kRowGroups; ++g)
+    {
+        const size_t sources[] = {0, 2};
+        for (size_t c = 0; c < 2; ++c)
+        {
+            EXPECT_EQ(chunkBytes(output, g, c), chunkBytes(input, g, sources[c]));
+            EXPECT_EQ(output.columnMetaData(g, c).encodings, input.columnMetaData(g, sources[c]).encodings);
+
+            // The offset index points into the new file
+            ColumnChunkReader chunk = output.columnChunk(g, c);
+            chunk.selectPages(*output.offsetIndex(g, c), output.columnChunkRange(g, c).offset, selection);
+            ColumnBatch batch(output.columns()[c].type);
+            chunk.readSelected(batch, selection, 0, kRowsPerGroup);
+            ColumnBatch expected = readColumn(input, g, sources[c]);
+            ASSERT_EQ(batch.length(), (kRowsPerGroup - 2500 + 2) / 3);
+            for (size_t i = 0; i < batch.length(); ++i)
+            {
+                ASSERT_EQ(slot(batch, i), slot(expected, 2500 + 3 * i));
+            }
+            EXPECT_EQ(output.columnIndex(g, c)->min_values, input.columnIndex(g, sources[c])->min_values);
+        }
+        std::shared_ptr<const BloomFilter> filter = output.bloomFilter(g, 0);
+        ASSERT_NE(filter, nullptr);
+        EXPECT_TRUE(filter->mightContain(BloomFilter::hash(static_cast<int64_t>(g * kRowsPerGroup + 17))));
+        EXPECT_EQ(output.bloomFilter(g, 1), nullptr);
+    }
+    std::remove(input_path.c_str());
+    std::remove(output_path.c_str());
+}
+
+TEST(ParquetRewriterTest, ReencodesOnlyTheChangedColumns)
+{
+    std::string input_path = writeInput("rewrite_encode_input.parquet");
+    std::string output_path = testing::TempDir() + "/rewrite_encode_output.parquet";
+    ParquetFileReader input(input_path);
+
+    RewriteOptions options;
+    options.column_encodings = {{"price", Encoding::BYTE_STREAM_SPLIT}};
+    RewriteResult result = rewriteParquetFile(input, output_path, options);
+    EXPECT_EQ(result.copied_chunks, 2 * kRowGroups);
+    EXPECT_EQ(result.rewritten_chunks, kRowGroups);
+    {
+        ParquetFileReader output(output_path);
+        for (size_t g = 0; g < kRowGroups; ++g)
+        {
+            EXPECT_EQ(rows(output, g), rows(input, g));
+            EXPECT_EQ(chunkBytes(output, g, 0), chunkBytes(input, g, 0));
+            EXPECT_EQ(chunkBytes(output, g, 2), chunkBytes(input, g, 2));
+            const std::vector<Encoding> &encodings = output.columnMetaData(g, 1).encodings;
+            EXPECT_NE(std::find(encodings.begin(), encodings.end(), Encoding::BYTE_STREAM_SPLIT), encodings.end());
+            EXPECT_EQ(output.columnMetaData(g, 1).codec, CompressionCodec::SNAPPY);
+            EXPECT_NE(output.offsetIndex(g, 1), nullptr);
+        }
+    }
+
+    // A new codec rewrites every chunk; name keeps its dictionary and id its Bloom filter
+    options = {};
+    options.codec = CompressionCodec::UNCOMPRESSED;
+    result = rewriteParquetFile(input, output_path, options);
+    EXPECT_EQ(result.copied_chunks, 0u);
+    EXPECT_EQ(result.rewritten_chunks, 3 * kRowGroups);
+    EXPECT_GT(result.output_bytes, result.input_bytes);
+    ParquetFileReader output(output_path);
+    for (size_t g = 0; g < kRowGroups; ++g)
+    {
+        EXPECT_EQ(rows(output, g), rows(input, g));
+        for (size_t c = 0; c < 3; ++c)
+        {
+            EXPECT_EQ(output.columnMetaData(g, c).codec, CompressionCodec::UNCOMPRESSED);
+        }
+        EXPECT_TRUE(output.columnMetaData(g, 2).dictionary_page_offset.has_value());
+        EXPECT_NE(output.bloomFilter(g, 0), nullptr);
+    }
+    std::remove(input_path.c_str());
+    std::remove(output_path.c_str());
+}
+
+TEST(ParquetRewriterTest, SortsTheRowsOfEveryRowGroup)
+{
+    std::string input_path = writeInput("rewrite_sort_input.parquet");
+    std::string output_path = testing::TempDir() + "/rewrite_sort_output.parquet";
+    ParquetFileReader input(input_path);
+    for (bool descending : {false, true})
+    {
+        RewriteOptions options;
+        options.columns = {"id", "name"};
+        options.sort_column = "price";
+        options.descending = descending;
+        RewriteResult result = rewriteParquetFile(input, output_path, options);
+        EXPECT_EQ(result.rewritten_chunks, 2 * kRowGroups);
+
+        ParquetFileReader output(output_path);
+        for (size_t g = 0; g < kRowGroups; ++g)
+        {
+            ColumnBatch ids = readColumn(output, g, 0);
+            ColumnBatch names = readColumn(output, g, 1);
+            ASSERT_EQ(ids.length(), kRowsPerGroup);
+            // The nulls come first, in their original order, then the prices in order
+            double previous = descending ? INFINITY : -INFINITY;
+            int64_t previous_id = -1;
+            size_t nulls = 0;
+            for (size_t row = g * kRowsPerGroup; row < (g + 1) * kRowsPerGroup; ++row)
+            {
+                nulls += row % 11 == 0 ? 1 : 0;
+            }
+            for (size_t i = 0; i < kRowsPerGroup; ++i)
+            {
+                auto row = static_cast<size_t>(ids.value<int64_t>(i));
+                ASSERT_EQ(row / kRowsPerGroup, g);
+                ASSERT_EQ(std::string(names.byteArray(i)), "name-" + std::to_string(row % 50));
+                ASSERT_EQ(row % 11 == 0, i < nulls) << i;
+                if (row % 11 == 0)
+                {
+                    ASSERT_GT(static_cast<int64_t>(row), previous_id);
+                    previous_id = static_cast<int64_t>(row);
+                    continue;
+                }
+                double price = static_cast<double>(row * 7919 % 1000) / 4;
+                ASSERT_TRUE(descending ? price <= previous : price >= previous);
+                previous = price;
+            }
+        }
+    }
+    std::remove(input_path.c_str());
+    std::remove(output_path.c_str());
+}
+
+TEST(ParquetRewriterTest, RejectsInvalidOptions)
+{
+    std::string input_path = writeInput("rewrite_invalid_input.parquet");
+    std::string output_path = testing::TempDir() + "/rewrite_invalid_output.parquet";
+    ParquetFileReader input(input_path);
+
+    RewriteOptions unknown_column;
+    unknown_column.columns = {"id", "missing"};
+    EXPECT_THROW(rewriteParquetFile(input, output_path, unknown_column), std::invalid_argument);
+
+    RewriteOptions dropped_encoding;
+    dropped_encoding.columns = {"id"};
+    dropped_encoding.column_encodings = {{"name", Encoding::DELTA_BYTE_ARRAY}};
+    EXPECT_THROW(rewriteParquetFile(input, output_path, dropped_encoding), std::invalid_argument);
+
+    RewriteOptions wrong_encoding;
+    wrong_encoding.column_encodings = {{"id", Encoding::DELTA_BYTE_ARRAY}};
+    EXPECT_THROW(rewriteParquetFile(input, output_path, wrong_encoding), std::invalid_argument);
+
+    RewriteOptions unknown_sort;
+    unknown_sort.sort_column = "missing";
+    EXPECT_THROW(rewriteParquetFile(input, output_path, unknown_sort), std::invalid_argument);
+
+    // Rewriting a file onto itself would truncate it while it is being read
+    EXPECT_THROW(rewriteParquetFile(input_path, input_path), std::invalid_argument);
+    EXPECT_THROW(rewriteParquetFile(input_path, testing::TempDir() + "/./rewrite_invalid_input.parquet"),
+                 std::invalid_argument);
+    EXPECT_EQ(rows(ParquetFileReader(input_path), 0).size(), kRowsPerGroup);
+    // An open reader keeps reading the old file, which the output replaces only once complete
+    RewriteResult in_place = rewriteParquetFile(ParquetFileReader(input_path), input_path);
+    EXPECT_EQ(in_place.copied_chunks, 3 * kRowGroups);
+    EXPECT_EQ(rows(ParquetFileReader(input_path), 0), rows(input, 0));
+
+    RewriteOptions encrypted;
+    encrypted.writer.encryption = FileEncryptionProperties{};
+    encrypted.writer.encryption->footer_key = std::string(16, 'k');
+    EXPECT_THROW(rewriteParquetFile(input, output_path, encrypted), std::invalid_argument);
+
+    // Copied chunks must match the column and the row group
+    CopiedColumnChunk copy;
+    copy.bytes = input.readColumnChunk(0, 0);
+    copy.metadata = input.columnMetaData(0, 0);
+    copy.source_offset = input.columnChunkRange(0, 0).offset;
+    std::vector<ColumnDescriptor> columns(1);
+    columns[0].path = {"id"};
+    columns[0].type = AtomicType::INT64;
+    ParquetFileWriter writer(output_path, columns);
+    RowGroupColumn entry;
+    EXPECT_THROW(writer.writeRowGroup({entry}, kRowsPerGroup), std::invalid_argument);
+    entry.copy = &copy;
+    EXPECT_THROW(writer.writeRowGroup({entry}, kRowsPerGroup - 1), std::invalid_argument);
+    writer.writeRowGroup({entry}, kRowsPerGroup);
+    writer.close();
+    EXPECT_EQ(rows(ParquetFileReader(output_path), 0).size(), kRowsPerGroup);
+    std::remove(input_path.c_str());
+    std::remove(output_path.c_str());
+}
@@ -0,0 +1,1204 @@
+#include "parquet_writer.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_set>
+
+#include "bit_util.hpp"
+#include "bloom_filter.hpp"
+#include "compression.hpp"
+#include "encodings.hpp"
+
+namespace
+{
+    constexpr uint8_t kMagic[4] = {'P', 'A', 'R', '1'};
+    constexpr uint8_t kEncryptedMagic[4] = {'P', 'A', 'R', 'E'};
+
+    // Longest byte array bound kept in the statistics
+    constexpr size_t kMaxStatisticsSize = 64;
+
+    void appendLength(std::vector<uint8_t> &out, uint32_t length)
+    {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&length);
+        out.insert(out.end(), bytes, bytes + sizeof(length));
+    }
+
+    /**
+     * @brief Number of slots, starting at `first`, whose PLAIN encoding fills about
+     * `page_size` bytes, at most `row_limit` unless that is 0.
+     */
+    size_t pageSlots(const ColumnBatch &batch, size_t first, size_t page_size, size_t row_limit)
+    {
+        size_t remaining = batch.length() - first;
+        if (row_limit > 0)
+        {
+            remaining = std::min(remaining, row_limit);
+        }
+        if (batch.type() != AtomicType::BYTE_ARRAY)
+        {
+            size_t width = std::max<size_t>(batch.valueWidth(), 1);
+            return std::min(remaining, std::max<size_t>(page_size / width, 1));
+        }
+        const int32_t *offsets = batch.offsets();
+        size_t bytes = 0;
+        size_t i = first;
+        while (i < first + remaining && bytes < page_size)
+        {
+            bytes += sizeof(uint32_t) + static_cast<size_t>(offsets[i + 1] - offsets[i]);
+            ++i;
+        }
+        return i - first;
+    }
+
+    size_t plainSize(const ColumnBatch &batch, size_t first, size_t count)
+    {
+        size_t size = 0;
+        for (size_t i = first; i < first + count; ++i)
+        {
+            if (batch.isValid(i))
+            {
+                size += batch.type() == AtomicType::BYTE_ARRAY ? sizeof(uint32_t) + batch.byteArray(i).size()
+                                                               : batch.valueWidth();
+            }
+        }
+        return size;
+    }
+
+    /**
+     * @brief The encodings a page of the given type can be written with, PLAIN first.
+     */
+    std::vector<Encoding> candidateEncodings(AtomicType type)
+    {
+        switch (type)
+        {
+        case AtomicType::BOOLEAN:
+            return {Encoding::PLAIN};
+        case AtomicType::INT32:
+        case AtomicType::INT64:
+            return {Encoding::PLAIN, Encoding::RLE_DICTIONARY, Encoding::DELTA_BINARY_PACKED,
+                    Encoding::BYTE_STREAM_SPLIT};
+        case AtomicType::FLOAT:
+        case AtomicType::DOUBLE:
+            return {Encoding::PLAIN, Encoding::RLE_DICTIONARY, Encoding::BYTE_STREAM_SPLIT};
+        case AtomicType::BYTE_ARRAY:
+            return {Encoding::PLAIN, Encoding::RLE_DICTIONARY, Encoding::DELTA_BYTE_ARRAY};
+        case AtomicType::FIXED_LEN_BYTE_ARRAY:
+            return {Encoding::PLAIN, Encoding::RLE_DICTIONARY, Encoding::DELTA_BYTE_ARRAY,
+                    Encoding::BYTE_STREAM_SPLIT};
+        }
+        return {Encoding::PLAIN};
+    }
+
+    /**
+     * @brief Extra time to decode a value, in units of what scanning a PLAIN value costs
+     * (page read and decompression included); rough figures from encodings_benchmark.
+     */
+    double decodeCost(Encoding encoding)
+    {
+        switch (encoding)
+        {
+        case Encoding::RLE_DICTIONARY:
+            return 1.0;
+        case Encoding::DELTA_BINARY_PACKED:
+            return 2.0;
+        case Encoding::DELTA_BYTE_ARRAY:
+            return 3.0;
+        case Encoding::BYTE_STREAM_SPLIT:
+            return 0.5;
+        default:
+            return 0.0;
+        }
+    }
+
+    template <typename T>
+    void encodeDeltaValues(const ColumnBatch &batch, size_t first, size_t count, std::vector<uint8_t> &out)
+    {
+        if (batch.nullCount() == 0)
+        {
+            encodeDeltaBinaryPacked(batch.values<T>() + first, count, out);
+            return;
+        }
+        std::vector<T> values;
+        values.reserve(count);
+        for (size_t i = first; i < first + count; ++i)
+        {
+            if (batch.isValid(i))
+            {
+                values.push_back(batch.value<T>(i));
+            }
+        }
+        encodeDeltaBinaryPacked(values.data(), values.size(), out);
+    }
+
+    void encodeValues(Encoding encoding, const ColumnBatch &batch, size_t first, size_t count,
+                      const DictionaryEncoder *dictionary, std::vector<uint8_t> &out)
+    {
+        switch (encoding)
+        {
+        case Encoding::RLE_DICTIONARY:
+            dictionary->encodeIndices(first, count, out);
+            break;
+        case Encoding::DELTA_BINARY_PACKED:
+            if (batch.type() == AtomicType::INT32)
+            {
+                encodeDeltaValues<int32_t>(batch, first, count, out);
+            }
+            else
+            {
+                encodeDeltaValues<int64_t>(batch, first, count, out);
+            }
+            break;
+        case Encoding::DELTA_BYTE_ARRAY:
+            encodeDeltaByteArray(batch, first, count, out);
+            break;
+        case Encoding::BYTE_STREAM_SPLIT:
+            encodeByteStreamSplit(batch, first, count, out);
+            break;
+        default:
+            encodePlain(batch, first, count, out);
+        }
+    }
+
+    /**
+     * @brief Whether the first values of a batch repeat enough for a dictionary to pay
+     * off, i.e. at most half of them are distinct.
+     */
+    bool fewDistinctValues(const ColumnBatch &batch, size_t sample_size)
+    {
+        std::unordered_set<std::string_view> distinct;
+        size_t values = 0;
+        size_t width = batch.valueWidth();
+        for (size_t i = 0; i < batch.length() && values < sample_size; ++i)
+        {
+            if (!batch.isValid(i))
+            {
+                continue;
+            }
+            if (batch.type() == AtomicType::BYTE_ARRAY)
+            {
+                distinct.insert(batch.byteArray(i));
+            }
+            else
+            {
+                distinct.emplace(reinterpret_cast<const char *>(batch.values<uint8_t>() + i * width), width);
+            }
+            ++values;
+        }
+        return values > 0 && distinct.size() * 2 <= values;
+    }
+
+    struct PagePlan
+    {
+        size_t first;
+        size_t count;
+        Encoding encoding;
+    };
+
+    /**
+     * @brief Splits a column chunk into pages and picks the encoding of every page among
+     * `candidates` by encoding (and compressing) a sample of its values with each. Pages
+     * grow by the factor their encoding shrinks the sample below PLAIN.
+     */
+    std::vector<PagePlan> planPages(const ColumnBatch &batch, const WriterOptions &options,
+                                    std::vector<Encoding> candidates, const DictionaryEncoder *dictionary)
+    {
+        if (dictionary == nullptr || !dictionary->complete())
+        {
+            candidates.erase(std::remove(candidates.begin(), candidates.end(), Encoding::RLE_DICTIONARY),
+                             candidates.end());
+        }
+        if (candidates.empty())
+        {
+            candidates.push_back(Encoding::PLAIN);
+        }
+        size_t chunk_values = batch.length() - batch.nullCount();
+        std::vector<PagePlan> pages;
+        std::vector<uint8_t> encoded;
+        std::vector<uint8_t> compressed;
+        size_t first = 0;
+        while (first < batch.length())
+        {
+            size_t count = pageSlots(batch, first, options.page_size, options.page_row_limit);
+            if (candidates.size() == 1 && candidates[0] == Encoding::PLAIN)
+            {
+                pages.push_back({first, count, Encoding::PLAIN});
+                first += count;
+                continue;
+            }
+            size_t sample = std::min(count, std::max<size_t>(options.encoding_sample_size, 1));
+            size_t sample_plain = plainSize(batch, first, sample);
+            size_t sample_values = batch.nullCount() == 0 ? sample : 0;
+            for (size_t i = first; sample_values == 0 && i < first + sample; ++i)
+            {
+                sample_values += batch.isValid(i) ? 1 : 0;
+            }
+
+            Encoding best = candidates[0];
+            double best_cost = 0;
+            size_t best_size = sample_plain;
+            for (Encoding encoding : candidates)
+            {
+                encoded.clear();
+                encodeValues(encoding, batch, first, sample, dictionary, encoded);
+                double size = static_cast<double>(encoded.size());
+                if (options.codec != CompressionCodec::UNCOMPRESSED)
+                {
+                    compressed.resize(maxCompressedLength(options.codec, encoded.size()));
+                    size = static_cast<double>(
+                        ::compress(options.codec, encoded.data(), encoded.size(), compressed.data()));
+                }
+                if (encoding == Encoding::RLE_DICTIONARY && chunk_values > 0)
+                {
+                    // The dictionary page is shared by the pages in proportion to their values
+                    size += static_cast<double>(dictionary->dictionaryBytes()) * static_cast<double>(sample_values) /
+                            static_cast<double>(chunk_values);
+                }
+                double cost = size * (1 + options.decode_cost_weight * decodeCost(encoding));
+                if (encoding == candidates[0] || cost < best_cost)
+                {
+                    best = encoding;
+                    best_cost = cost;
+                    best_size = encoded.size();
+                }
+            }
+            if (best_size > 0 && best_size < sample_plain)
+            {
+                auto page_size = static_cast<size_t>(static_cast<double>(options.page_size) *
+                                                     static_cast<double>(sample_plain) / static_cast<double>(best_size));
+                count = pageSlots(batch, first, std::min(page_size, options.page_size * 64), options.page_row_limit);
+            }
+            pages.push_back({first, count, best});
+            first += count;
+        }
+        return pages;
+    }
+    std::vector<SchemaElement> flatSchema(const std::vector<ColumnDescriptor> &columns)
+    {
+        std::vector<SchemaElement> schema(1);
+        schema[0].name = "schema";
+        schema[0].num_children = static_cast<int32_t>(columns.size());
+        for (const ColumnDescriptor &column : columns)
+        {
+            if (column.path.size() != 1 || column.max_repetition_level != 0 || column.max_definition_level > 1)
+            {
+                throw std::invalid_argument("Only flat required or optional columns can be written");
+            }
+            SchemaElement element;
+            element.name = column.path[0];
+            element.type = column.type;
+            if (column.type == AtomicType::FIXED_LEN_BYTE_ARRAY)
+            {
+                element.type_length = column.type_length;
+            }
+            element.repetition_type =
+                column.max_definition_level > 0 ? FieldRepetitionType::OPTIONAL : FieldRepetitionType::REQUIRED;
+            schema.push_back(std::move(element));
+        }
+        return schema;
+    }
+
+    template <typename T>
+    std::string plainBytes(T value)
+    {
+        return std::string(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void fixedWidthBounds(T min, T max, Statistics &statistics)
+    {
+        if constexpr (std::is_floating_point_v<T>)
+        {
+            // The format asks for a signed zero that covers both zeros
+            min = min == 0 ? -T{0} : min;
+            max = max == 0 ? T{0} : max;
+        }
+        statistics.min_value = plainBytes(min);
+        statistics.max_value = plainBytes(max);
+        statistics.is_min_value_exact = true;
+        statistics.is_max_value_exact = true;
+    }
+
+    void byteArrayBounds(std::string_view min, std::string_view max, Statistics &statistics)
+    {
+        // Long bounds are cut: a prefix is still a lower bound, and a prefix with its last
+        // byte below 0xFF incremented still an upper bound
+        statistics.min_value = std::string(min.substr(0, kMaxStatisticsSize));
+        statistics.is_min_value_exact = min.size() <= kMaxStatisticsSize;
+        if (max.size() <= kMaxStatisticsSize)
+        {
+            statistics.max_value = std::string(max);
+            statistics.is_max_value_exact = true;
+            return;
+        }
+        std::string bound(max.substr(0, kMaxStatisticsSize));
+        while (!bound.empty() && static_cast<uint8_t>(bound.back()) == 0xFF)
+        {
+            bound.pop_back();
+        }
+        if (!bound.empty())
+        {
+            bound.back() = static_cast<char>(static_cast<uint8_t>(bound.back()) + 1);
+            statistics.max_value = std::move(bound);
+            statistics.is_max_value_exact = false;
+        }
+    }
+
+    /**
+     * @brief Sets the bounds of `statistics` to the values in two slots.
+     */
+    void setBounds(const ColumnBatch &batch, size_t min_slot, size_t max_slot, Statistics &statistics)
+    {
+        switch (batch.type())
+        {
+        case AtomicType::BOOLEAN:
+            fixedWidthBounds(batch.value<uint8_t>(min_slot), batch.value<uint8_t>(max_slot), statistics);
+            break;
+        case AtomicType::INT32:
+            fixedWidthBounds(batch.value<int32_t>(min_slot), batch.value<int32_t>(max_slot), statistics);
+            break;
+        case AtomicType::INT64:
+            fixedWidthBounds(batch.value<int64_t>(min_slot), batch.value<int64_t>(max_slot), statistics);
+            break;
+        case AtomicType::FLOAT:
+            fixedWidthBounds(batch.value<float>(min_slot), batch.value<float>(max_slot), statistics);
+            break;
+        case AtomicType::DOUBLE:
+            fixedWidthBounds(batch.value<double>(min_slot), batch.value<double>(max_slot), statistics);
+            break;
+        case AtomicType::BYTE_ARRAY:
+        case AtomicType::FIXED_LEN_BYTE_ARRAY:
+            byteArrayBounds(batch.byteArray(min_slot), batch.byteArray(max_slot), statistics);
+            break;
+        }
+    }
+
+    /**
+     * @brief Orders the slots of a fixed width batch by value; NaN is not ordered and
+     * stays out of the statistics.
+     */
+    template <typename T>
+    struct ValueOrder
+    {
+        const T *values;
+
+        bool ordered(size_t i) const
+        {
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                return !std::isnan(values[i]);
+            }
+            return true;
+        }
+
+        bool less(size_t a, size_t b) const { return values[a] < values[b]; }
+    };
+
+    /**
+     * @brief Orders the slots of a BYTE_ARRAY or FIXED_LEN_BYTE_ARRAY batch by their bytes,
+     * compared unsigned.
+     */
+    struct ByteArrayOrder
+    {
+        const ColumnBatch *batch;
+
+        bool ordered(size_t) const { return true; }
+        bool less(size_t a, size_t b) const { return batch->byteArray(a) < batch->byteArray(b); }
+    };
+
+    template <typename Visitor>
+    void visitOrder(const ColumnBatch &batch, Visitor &&visitor)
+    {
+        switch (batch.type())
+        {
+        case AtomicType::BOOLEAN:
+            visitor(ValueOrder<uint8_t>{batch.values<uint8_t>()});
+            break;
+        case AtomicType::INT32:
+            visitor(ValueOrder<int32_t>{batch.values<int32_t>()});
+            break;
+        case AtomicType::INT64:
+            visitor(ValueOrder<int64_t>{batch.values<int64_t>()});
+            break;
+        case AtomicType::FLOAT:
+            visitor(ValueOrder<float>{batch.values<float>()});
+            break;
+        case AtomicType::DOUBLE:
+            visitor(ValueOrder<double>{batch.values<double>()});
+            break;
+        case AtomicType::BYTE_ARRAY:
+        case AtomicType::FIXED_LEN_BYTE_ARRAY:
+            visitor(ByteArrayOrder{&batch});
+            break;
+        }
+    }
+
+    bool slotLess(const ColumnBatch &batch, size_t a, size_t b)
+    {
+        bool less = false;
+        visitOrder(batch, [&](const auto &order)
+                   { less = order.less(a, b); });
+        return less;
+    }
+
+    /**
+     * @brief What the pass over the slots of a page finds besides their definition levels.
+     */
+    struct PageSummary
+    {
+        size_t null_count = 0;
+
+        // Slots of the smallest and largest ordered values
+        std::optional<size_t> min_slot;
+        std::optional<size_t> max_slot;
+
+        // Bytes of the BYTE_ARRAY values without their lengths
+        int64_t unencoded_bytes = 0;
+    };
+
+    /**
+     * @brief One pass over the slots of a page: stores their definition levels in `levels`
+     * and counts them in `histogram` (both only for max_level > 0), and finds nulls,
+     * bounds and value bytes.
+     */
+    template <typename Order>
+    PageSummary summarizePage(const ColumnBatch &batch, size_t first, size_t count, const int16_t *definition_levels,
+                              int16_t max_level, const Order &order, int16_t *levels, int64_t *histogram)
+    {
+        PageSummary summary;
+        bool byte_array = batch.type() == AtomicType::BYTE_ARRAY;
+        for (size_t i = first; i < first + count; ++i)
+        {
+            bool valid = batch.isValid(i);
+            if (max_level > 0)
+            {
+                int16_t level = valid ? max_level
+                                      : definition_levels ? definition_levels[i]
+                                                          : static_cast<int16_t>(max_level - 1);
+                levels[i - first] = level;
+                ++histogram[level];
+            }
+            if (!valid)
+            {
+                ++summary.null_count;
+                continue;
+            }
+            if (byte_array)
+            {
+                summary.unencoded_bytes += static_cast<int64_t>(batch.byteArray(i).size());
+            }
+            if (!order.ordered(i))
+            {
+                continue;
+            }
+            if (!summary.min_slot || order.less(i, *summary.min_slot))
+            {
+                summary.min_slot = i;
+            }
+            if (!summary.max_slot || order.less(*summary.max_slot, i))
+            {
+                summary.max_slot = i;
+            }
+        }
+        return summary;
+    }
+} // namespace
+
+ParquetFileWriter::ParquetFileWriter(const std::string &path, std::vector<ColumnDescriptor> columns,
+                                     WriterOptions options)
+    : ParquetFileWriter(path, flatSchema(columns), std::move(options))
+{
+}
+
+ParquetFileWriter::ParquetFileWriter(const std::string &path, std::vector<SchemaElement> schema,
+                                     WriterOptions options)
+    : path_(path), columns_(leafColumns(schema)), options_(std::move(options))
+{
+    for (const ColumnDescriptor &column : columns_)
+    {
+        if (column.max_repetition_level != 0)
+        {
+            throw std::invalid_argument("Repeated column " + column.dottedPath() + " cannot be written");
+        }
+    }
+    metadata_.schema = std::move(schema);
+    metadata_.created_by = options_.created_by;
+    metadata_.key_value_metadata = options_.key_value_metadata;
+
+    bloom_filters_.resize(columns_.size());
+    for (const std::string &name : options_.bloom_filter_columns)
+    {
+        auto it = std::find_if(columns_.begin(), columns_.end(), [&name](const ColumnDescriptor &column)
+                               { return column.dottedPath() == name; });
+        if (it == columns_.end() || it->type == AtomicType::BOOLEAN)
+        {
+            throw std::invalid_argument("Cannot write a Bloom filter for column " + name);
+        }
+        bloom_filters_[static_cast<size_t>(it - columns_.begin())] = true;
+    }
+    encodings_.resize(columns_.size());
+    for (const auto &[name, encoding] : options_.column_encodings)
+    {
+        auto it = std::find_if(columns_.begin(), columns_.end(), [&name](const ColumnDescriptor &column)
+                               { return column.dottedPath() == name; });
+        std::vector<Encoding> candidates = it == columns_.end() ? std::vector<Encoding>{} : candidateEncodings(it->type);
+        if (std::find(candidates.begin(), candidates.end(), encoding) == candidates.end())
+        {
+            throw std::invalid_argument("Cannot write column " + name + " with encoding " +
+                                        std::to_string(static_cast<int>(encoding)));
+        }
+        encodings_[static_cast<size_t>(it - columns_.begin())] = encoding;
+    }
+    codecs_.assign(columns_.size(), options_.codec);
+    for (const auto &[name, codec] : options_.column_codecs)
+    {
+        auto it = std::find_if(columns_.begin(), columns_.end(), [&name](const ColumnDescriptor &column)
+                               { return column.dottedPath() == name; });
+        if (it == columns_.end())
+        {
+            throw std::invalid_argument("Cannot compress unknown column " + name);
+        }
+        maxCompressedLength(codec, 0);
+        codecs_[static_cast<size_t>(it - columns_.begin())] = codec;
+    }
+    if (!(options_.decode_cost_weight >= 0))
+    {
+        throw std::invalid_argument("The decode cost weight must not be negative");
+    }
+    BloomFilter::optimalNumBytes(1, options_.bloom_filter_fpp); // Rejects invalid probabilities up front
+    maxCompressedLength(options_.codec, 0); // Rejects unsupported codecs up front
+    if (options_.encryption)
+    {
+        encryptor_ = std::make_unique<FileEncryptor>(*options_.encryption, columns_);
+    }
+
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot create " + path);
+    }
+    write(encryptor_ && !encryptor_->plaintextFooter() ? kEncryptedMagic : kMagic, sizeof(kMagic));
+}
+
+ParquetFileWriter::~ParquetFileWriter()
+{
+    if (fd_ >= 0)
+    {
+        try
+        {
+            close();
+        }
+        catch (...)
+        {
+        }
+    }
+}
+
+void ParquetFileWriter::writeRowGroup(const std::vector<const ColumnBatch *> &batches,
+                                      const std::vector<const int16_t *> &definition_levels)
+{
+    if (batches.size() != columns_.size() || (!definition_levels.empty() && definition_levels.size() != batches.size()))
+    {
+        throw std::invalid_argument("Expected one batch per column");
+    }
+    std::vector<RowGroupColumn> columns;
+    for (size_t i = 0; i < batches.size(); ++i)
+    {
+        columns.push_back({batches[i], definition_levels.empty() ? nullptr : definition_levels[i], nullptr});
+    }
+    writeRowGroup(columns, columns_.empty() ? 0 : batches[0]->length());
+}
+
+void ParquetFileWriter::writeRowGroup(const std::vector<RowGroupColumn> &columns, size_t num_rows)
+{
+    if (columns.size() != columns_.size())
+    {
+        throw std::invalid_argument("Expected one entry per column");
+    }
+    std::vector<size_t> encoded_columns;
+    for (size_t i = 0; i < columns_.size(); ++i)
+    {
+        checkColumn(i, columns[i], num_rows);
+        if (columns[i].batch)
+        {
+            encoded_columns.push_back(i);
+        }
+    }
+
+    // Everything is encoded before the first byte is written, so a failing column leaves
+    // the file as it was
+    auto ordinal = static_cast<int64_t>(metadata_.row_groups.size());
+    auto encode = [&](size_t i)
+    {
+        const RowGroupColumn &entry = columns[encoded_columns[i]];
+        return encodeColumnChunk(encoded_columns[i], *entry.batch, entry.definition_levels, ordinal);
+    };
+    std::vector<EncodedChunk> encoded;
+    if (options_.pool && encoded_columns.size() > 1)
+    {
+        encoded = parallelMap<EncodedChunk>(*options_.pool, encoded_columns.size(), encode);
+    }
+    else
+    {
+        for (size_t i = 0; i < encoded_columns.size(); ++i)
+        {
+            encoded.push_back(encode(i));
+        }
+    }
+
+    RowGroup row_group;
+    row_group.num_rows = static_cast<int64_t>(num_rows);
+    row_group.file_offset = static_cast<int64_t>(offset_);
+    row_group.ordinal = static_cast<int16_t>(ordinal);
+    int64_t compressed_size = 0;
+    std::vector<ColumnIndex> column_indexes(columns_.size());
+    std::vector<OffsetIndex> offset_indexes(columns_.size());
+    for (size_t i = 0, next = 0; i < columns_.size(); ++i)
+    {
+        // The offsets are relative to the encoded bytes, or those of the source file
+        auto shift = static_cast<int64_t>(offset_);
+        ColumnChunk chunk;
+        if (const CopiedColumnChunk *copy = columns[i].copy)
+        {
+            shift -= static_cast<int64_t>(copy->source_offset);
+            chunk.meta_data = copy->metadata;
+            chunk.meta_data->path_in_schema = columns_[i].path;
+            chunk.meta_data->bloom_filter_offset.reset();
+            chunk.meta_data->bloom_filter_length.reset();
+            if (copy->column_index)
+            {
+                column_indexes[i] = *copy->column_index;
+            }
+            if (copy->offset_index)
+            {
+                offset_indexes[i] = *copy->offset_index;
+            }
+            write(copy->bytes.data, copy->bytes.size);
+        }
+        else
+        {
+            EncodedChunk &out = encoded[next++];
+            chunk = std::move(out.chunk);
+            column_indexes[i] = std::move(out.column_index);
+            offset_indexes[i] = std::move(out.offset_index);
+            write(out.bytes.data(), out.bytes.size());
+        }
+        ColumnMetaData &metadata = *chunk.meta_data;
+        metadata.data_page_offset += shift;
+        if (metadata.dictionary_page_offset)
+        {
+            *metadata.dictionary_page_offset += shift;
+        }
+        chunk.file_offset = metadata.data_page_offset;
+        for (PageLocation &location : offset_indexes[i].page_locations)
+        {
+            location.offset += shift;
+        }
+        row_group.total_byte_size += metadata.total_uncompressed_size;
+        compressed_size += metadata.total_compressed_size;
+        row_group.columns.push_back(std::move(chunk));
+    }
+    for (size_t i = 0; i < columns_.size(); ++i)
+    {
+        ColumnMetaData &metadata = *row_group.columns[i].meta_data;
+        if (columns[i].copy && columns[i].copy->bloom_filter.size > 0)
+        {
+            metadata.bloom_filter_offset = static_cast<int64_t>(offset_);
+            metadata.bloom_filter_length = static_cast<int32_t>(columns[i].copy->bloom_filter.size);
+            write(columns[i].copy->bloom_filter.data, columns[i].copy->bloom_filter.size);
+        }
+        else if (columns[i].batch && bloom_filters_[i])
+        {
+            writeBloomFilter(i, *columns[i].batch, metadata);
+        }
+    }
+    for (size_t i = 0; encryptor_ && i < columns_.size(); ++i)
+    {
+        encryptColumnMetaData(i, row_group.columns[i]);
+    }
+    row_group.total_compressed_size = compressed_size;
+    metadata_.num_rows += row_group.num_rows;
+    metadata_.row_groups.push_back(std::move(row_group));
+    if (options_.write_page_index)
+    {
+        column_indexes_.push_back(std::move(column_indexes));
+        offset_indexes_.push_back(std::move(offset_indexes));
+    }
+}
+
+void ParquetFileWriter::checkColumn(size_t column, const RowGroupColumn &entry, size_t num_rows) const
+{
+    const ColumnDescriptor &descriptor = columns_[column];
+    if ((entry.batch == nullptr) == (entry.copy == nullptr))
+    {
+        throw std::invalid_argument("Column " + descriptor.dottedPath() + " needs either a batch or a copied chunk");
+    }
+    if (entry.copy)
+    {
+        if (encryptor_)
+        {
+            throw std::invalid_argument("Column chunks cannot be copied into an encrypted file");
+        }
+        if (entry.copy->metadata.type != descriptor.type ||
+            entry.copy->metadata.num_values != static_cast<int64_t>(num_rows))
+        {
+            throw std::invalid_argument("Copied chunk of column " + descriptor.dottedPath() +
+                                        " does not match the column or the row group");
+        }
+        return;
+    }
+
+    const ColumnBatch &batch = *entry.batch;
+    if (batch.length() != num_rows)
+    {
+        throw std::invalid_argument("All batches of a row group must have the same length");
+    }
+    if (batch.type() != descriptor.type || batch.isDictionaryEncoded())
+    {
+        throw std::invalid_argument("Batch for column " + descriptor.dottedPath() + " has the wrong type");
+    }
+    if (batch.nullCount() > 0 && descriptor.max_definition_level == 0)
+    {
+        throw std::invalid_argument("Required column " + descriptor.dottedPath() + " has nulls");
+    }
+    const int16_t *levels = entry.definition_levels;
+    for (size_t slot = 0; levels && slot < num_rows; ++slot)
+    {
+        int16_t max_level = descriptor.max_definition_level;
+        if (levels[slot] < 0 || levels[slot] > max_level || (levels[slot] == max_level) != batch.isValid(slot))
+        {
+            throw std::invalid_argument("Definition level of slot " + std::to_string(slot) + " of column " +
+                                        descriptor.dottedPath() + " does not match the batch");
+        }
+    }
+}
+
+ParquetFileWriter::EncodedChunk ParquetFileWriter::encodeColumnChunk(size_t column, const ColumnBatch &batch,
+                                                                    const int16_t *definition_levels,
+                                                                    int64_t row_group) const
+{
+    const ColumnDescriptor &descriptor = columns_[column];
+    EncodedChunk out;
+    ColumnIndex &column_index = out.column_index;
+    OffsetIndex &offset_index = out.offset_index;
+
+    std::vector<Encoding> candidates = {Encoding::PLAIN};
+    if (encodings_[column])
+    {
+        candidates = {*encodings_[column]};
+    }
+    else if (options_.adaptive_encoding)
+    {
+        candidates = candidateEncodings(batch.type());
+    }
+    std::unique_ptr<DictionaryEncoder> dictionary;
+    if (std::find(candidates.begin(), candidates.end(), Encoding::RLE_DICTIONARY) != candidates.end() &&
+        (candidates.size() == 1 || fewDistinctValues(batch, 4 * options_.encoding_sample_size)))
+    {
+        dictionary = std::make_unique<DictionaryEncoder>(batch, options_.max_dictionary_size);
+    }
+    std::vector<PagePlan> pages = planPages(batch, options_, std::move(candidates), dictionary.get());
+
+    ColumnMetaData metadata;
+    metadata.type = descriptor.type;
+    metadata.path_in_schema = descriptor.path;
+    metadata.codec = codecs_[column];
+    metadata.num_values = static_cast<int64_t>(batch.length());
+    // PLAIN also stands for the dictionary page, and RLE for the definition levels
+    auto addEncoding = [&metadata](Encoding encoding)
+    {
+        if (std::find(metadata.encodings.begin(), metadata.encodings.end(), encoding) == metadata.encodings.end())
+        {
+            metadata.encodings.push_back(encoding);
+        }
+    };
+    for (const PagePlan &page : pages)
+    {
+        if (page.encoding == Encoding::PLAIN || page.encoding == Encoding::RLE_DICTIONARY)
+        {
+            addEncoding(Encoding::PLAIN);
+        }
+    }
+    if (pages.empty())
+    {
+        addEncoding(Encoding::PLAIN);
+    }
+    addEncoding(Encoding::RLE);
+    for (const PagePlan &page : pages)
+    {
+        addEncoding(page.encoding);
+    }
+
+    std::vector<uint8_t> page;
+    if (std::find(metadata.encodings.begin(), metadata.encodings.end(), Encoding::RLE_DICTIONARY) !=
+        metadata.encodings.end())
+    {
+        metadata.dictionary_page_offset = static_cast<int64_t>(out.bytes.size());
+        dictionary->encodeDictionary(page);
+        PageHeader header;
+        header.type = PageType::DICTIONARY_PAGE;
+        DictionaryPageHeader &dictionary_header = header.dictionary_page_header.emplace();
+        dictionary_header.num_values = static_cast<int32_t>(dictionary->size());
+        appendPage(header, page, column, row_group, -1, metadata, out);
+    }
+    metadata.data_page_offset = static_cast<int64_t>(out.bytes.size());
+
+    int16_t max_level = descriptor.max_definition_level;
+    std::vector<uint8_t> levels;
+    std::vector<int16_t> def_levels;
+    std::vector<int64_t> histogram(static_cast<size_t>(max_level) + 1);
+    std::vector<int64_t> chunk_histogram(histogram.size());
+    std::optional<size_t> chunk_min;
+    std::optional<size_t> chunk_max;
+    int64_t unencoded_bytes = 0;
+    bool index_complete = true;
+    bool ascending = true;
+    bool descending = true;
+    std::optional<size_t> previous_min;
+    std::optional<size_t> previous_max;
+    for (size_t ordinal = 0; ordinal < pages.size(); ++ordinal)
+    {
+        const PagePlan &plan = pages[ordinal];
+        page.clear();
+        def_levels.resize(plan.count);
+        std::fill(histogram.begin(), histogram.end(), 0);
+        PageSummary summary;
+        visitOrder(batch, [&](const auto &order)
+                   { summary = summarizePage(batch, plan.first, plan.count, definition_levels, max_level, order,
+                                             def_levels.data(), histogram.data()); });
+        if (max_level > 0)
+        {
+            levels.clear();
+            encodeRleBitPacked(def_levels.data(), plan.count, bit_util::bitWidth(static_cast<uint64_t>(max_level)),
+                               levels);
+            appendLength(page, static_cast<uint32_t>(levels.size()));
+            page.insert(page.end(), levels.begin(), levels.end());
+        }
+        encodeValues(plan.encoding, batch, plan.first, plan.count, dictionary.get(), page);
+
+        PageHeader header;
+        header.type = PageType::DATA_PAGE;
+        DataPageHeader &data_header = header.data_page_header.emplace();
+        data_header.num_values = static_cast<int32_t>(plan.count);
+        data_header.encoding = plan.encoding;
+        Statistics &statistics = data_header.statistics.emplace();
+        statistics.null_count = static_cast<int64_t>(summary.null_count);
+        if (summary.min_slot)
+        {
+            setBounds(batch, *summary.min_slot, *summary.max_slot, statistics);
+        }
+        auto page_offset = static_cast<int64_t>(out.bytes.size());
+        size_t page_bytes = appendPage(header, page, column, row_group, static_cast<int64_t>(ordinal), metadata, out);
+
+        offset_index.page_locations.push_back(
+            {page_offset, static_cast<int32_t>(page_bytes), static_cast<int64_t>(plan.first)});
+        bool null_page = summary.null_count == plan.count;
+        // A page of NaNs has no bounds to put in the column index, which is left out then
+        index_complete = index_complete && (null_page || summary.min_slot);
+        column_index.null_pages.push_back(null_page);
+        column_index.min_values.push_back(statistics.min_value.value_or(""));
+        column_index.max_values.push_back(statistics.max_value.value_or(""));
+        column_index.null_counts.push_back(static_cast<int64_t>(summary.null_count));
+        if (max_level > 0)
+        {
+            column_index.definition_level_histograms.insert(column_index.definition_level_histograms.end(),
+                                                            histogram.begin(), histogram.end());
+            for (size_t level = 0; level < histogram.size(); ++level)
+            {
+                chunk_histogram[level] += histogram[level];
+            }
+        }
+        if (batch.type() == AtomicType::BYTE_ARRAY)
+        {
+            offset_index.unencoded_byte_array_data_bytes.push_back(summary.unencoded_bytes);
+            unencoded_bytes += summary.unencoded_bytes;
+        }
+
+        if (!summary.min_slot)
+        {
+            continue;
+        }
+        if (previous_min)
+        {
+            ascending = ascending && !slotLess(batch, *summary.min_slot, *previous_min) &&
+                        !slotLess(batch, *summary.max_slot, *previous_max);
+            descending = descending && !slotLess(batch, *previous_min, *summary.min_slot) &&
+                         !slotLess(batch, *previous_max, *summary.max_slot);
+        }
+        previous_min = summary.min_slot;
+        previous_max = summary.max_slot;
+        if (!chunk_min || slotLess(batch, *summary.min_slot, *chunk_min))
+        {
+            chunk_min = summary.min_slot;
+        }
+        if (!chunk_max || slotLess(batch, *chunk_max, *summary.max_slot))
+        {
+            chunk_max = summary.max_slot;
+        }
+    }
+    column_index.boundary_order = ascending    ? BoundaryOrder::ASCENDING
+                                  : descending ? BoundaryOrder::DESCENDING
+                                               : BoundaryOrder::UNORDERED;
+    if (!index_complete)
+    {
+        column_index = ColumnIndex();
+    }
+
+    Statistics &statistics = metadata.statistics.emplace();
+    statistics.null_count = static_cast<int64_t>(batch.nullCount());
+    if (chunk_min)
+    {
+        setBounds(batch, *chunk_min, *chunk_max, statistics);
+    }
+    if (max_level > 0 || batch.type() == AtomicType::BYTE_ARRAY)
+    {
+        SizeStatistics &size_statistics = metadata.size_statistics.emplace();
+        if (batch.type() == AtomicType::BYTE_ARRAY)
+        {
+            size_statistics.unencoded_byte_array_data_bytes = unencoded_bytes;
+        }
+        if (max_level > 0)
+        {
+            size_statistics.definition_level_histogram = std::move(chunk_histogram);
+        }
+    }
+
+    out.chunk.file_offset = metadata.data_page_offset;
+    out.chunk.meta_data = std::move(metadata);
+    out.compressed = {};
+    out.encrypted = {};
+    return out;
+}
+
+size_t ParquetFileWriter::appendPage(PageHeader &header, const std::vector<uint8_t> &page, size_t column,
+                                     int64_t row_group, int64_t page_ordinal, ColumnMetaData &metadata,
+                                     EncodedChunk &out) const
+{
+    const ModuleCipher *cipher = encryptor_ ? encryptor_->columnCipher(column).get() : nullptr;
+    bool dictionary = header.type == PageType::DICTIONARY_PAGE;
+    std::vector<uint8_t> &compressed = out.compressed;
+    std::vector<uint8_t> &encrypted = out.encrypted;
+
+    compressed.resize(maxCompressedLength(codecs_[column], page.size()));
+    compressed.resize(::compress(codecs_[column], page.data(), page.size(), compressed.data()));
+    if (cipher)
+    {
+        ModuleType type = dictionary ? ModuleType::DICTIONARY_PAGE : ModuleType::DATA_PAGE;
+        encrypted.clear();
+        cipher->encrypt(type, compressed.data(), compressed.size(), cipher->aad(type, row_group, column, page_ordinal),
+                        encrypted);
+        compressed.swap(encrypted);
+    }
+
+    header.uncompressed_page_size = static_cast<int32_t>(page.size());
+    header.compressed_page_size = static_cast<int32_t>(compressed.size());
+    std::vector<uint8_t> header_bytes = serializeThrift(header);
+    if (cipher)
+    {
+        ModuleType type = dictionary ? ModuleType::DICTIONARY_PAGE_HEADER : ModuleType::DATA_PAGE_HEADER;
+        encrypted.clear();
+        cipher->encrypt(type, header_bytes.data(), header_bytes.size(),
+                        cipher->aad(type, row_group, column, page_ordinal), encrypted);
+        header_bytes.swap(encrypted);
+    }
+
+    out.bytes.insert(out.bytes.end(), header_bytes.begin(), header_bytes.end());
+    out.bytes.insert(out.bytes.end(), compressed.begin(), compressed.end());
+    metadata.total_uncompressed_size += static_cast<int64_t>(header_bytes.size() + page.size());
+    metadata.total_compressed_size += static_cast<int64_t>(header_bytes.size() + compressed.size());
+    return header_bytes.size() + compressed.size();
+}
+
+void ParquetFileWriter::writeBloomFilter(size_t column, const ColumnBatch &batch, ColumnMetaData &metadata)
+{
+    BloomFilter filter(BloomFilter::optimalNumBytes(std::max<size_t>(batch.length() - batch.nullCount(), 1),
+                                                    options_.bloom_filter_fpp));
+    for (size_t i = 0; i < batch.length(); ++i)
+    {
+        if (batch.isValid(i))
+        {
+            filter.insert(BloomFilter::hash(batch, i));
+        }
+    }
+    BloomFilterHeader header;
+    header.num_bytes = static_cast<int32_t>(filter.numBytes());
+    std::vector<uint8_t> header_bytes = serializeThrift(header);
+
+    metadata.bloom_filter_offset = static_cast<int64_t>(offset_);
+    const ModuleCipher *cipher = encryptor_ ? encryptor_->columnCipher(column).get() : nullptr;
+    if (!cipher)
+    {
+        metadata.bloom_filter_length = static_cast<int32_t>(header_bytes.size() + filter.numBytes());
+        write(header_bytes.data(), header_bytes.size());
+        write(filter.bitset().data(), filter.numBytes());
+        return;
+    }
+    auto row_group = static_cast<int64_t>(metadata_.row_groups.size());
+    std::vector<uint8_t> modules;
+    cipher->encrypt(ModuleType::BLOOM_FILTER_HEADER, header_bytes.data(), header_bytes.size(),
+                    cipher->aad(ModuleType::BLOOM_FILTER_HEADER, row_group, column), modules);
+    cipher->encrypt(ModuleType::BLOOM_FILTER_BITSET, filter.bitset().data(), filter.numBytes(),
+                    cipher->aad(ModuleType::BLOOM_FILTER_BITSET, row_group, column), modules);
+    metadata.bloom_filter_length = static_cast<int32_t>(modules.size());
+    write(modules.data(), modules.size());
+}
+
+void ParquetFileWriter::encryptColumnMetaData(size_t column, ColumnChunk &chunk) const
+{
+    const ModuleCipher *cipher = encryptor_->columnCipher(column).get();
+    if (!cipher)
+    {
+        return;
+    }
+    chunk.crypto_metadata = encryptor_->cryptoMetaData(column);
+    // Behind an encrypted footer, the metadata of columns with the footer key needs no
+    // second encryption
+    if (!encryptor_->plaintextFooter() && !chunk.crypto_metadata->ENCRYPTION_WITH_COLUMN_KEY)
+    {
+        return;
+    }
+    std::vector<uint8_t> plaintext = serializeThrift(*chunk.meta_data);
+    std::vector<uint8_t> module;
+    cipher->encrypt(ModuleType::COLUMN_META_DATA, plaintext.data(), plaintext.size(),
+                    cipher->aad(ModuleType::COLUMN_META_DATA, metadata_.row_groups.size(), column), module);
+    chunk.encrypted_column_metadata = std::string(module.begin(), module.end());
+    if (encryptor_->plaintextFooter())
+    {
+        // Readers without the key still see where the chunk is, but not its values
+        chunk.meta_data->statistics.reset();
+        chunk.meta_data->size_statistics.reset();
+    }
+    else
+    {
+        chunk.meta_data.reset();
+    }
+}
+
+template <typename T>
+void ParquetFileWriter::writeIndex(const T &index, ModuleType type, size_t row_group, size_t column,
+                                   std::optional<int64_t> &offset, std::optional<int32_t> &length)
+{
+    std::vector<uint8_t> bytes = serializeThrift(index);
+    const ModuleCipher *cipher = encryptor_ ? encryptor_->columnCipher(column).get() : nullptr;
+    if (cipher)
+    {
+        std::vector<uint8_t> module;
+        cipher->encrypt(type, bytes.data(), bytes.size(), cipher->aad(type, row_group, column), module);
+        bytes.swap(module);
+    }
+    offset = static_cast<int64_t>(offset_);
+    length = static_cast<int32_t>(bytes.size());
+    write(bytes.data(), bytes.size());
+}
+
+void ParquetFileWriter::writePageIndexes()
+{
+    // All column indexes first, then all offset indexes, so readers pruning on the column
+    // indexes find them in one range
+    for (size_t row_group = 0; row_group < column_indexes_.size(); ++row_group)
+    {
+        for (size_t column = 0; column < columns_.size(); ++column)
+        {
+            const ColumnIndex &index = column_indexes_[row_group][column];
+            if (!index.null_pages.empty())
+            {
+                ColumnChunk &chunk = metadata_.row_groups[row_group].columns[column];
+                writeIndex(index, ModuleType::COLUMN_INDEX, row_group, column, chunk.column_index_offset,
+                           chunk.column_index_length);
+            }
+        }
+    }
+    for (size_t row_group = 0; row_group < offset_indexes_.size(); ++row_group)
+    {
+        for (size_t column = 0; column < columns_.size(); ++column)
+        {
+            const OffsetIndex &index = offset_indexes_[row_group][column];
+            if (!index.page_locations.empty())
+            {
+                ColumnChunk &chunk = metadata_.row_groups[row_group].columns[column];
+                writeIndex(index, ModuleType::OFFSET_INDEX, row_group, column, chunk.offset_index_offset,
+                           chunk.offset_index_length);
+            }
+        }
+    }
+    column_indexes_.clear();
+    offset_indexes_.clear();
+}
+
+void ParquetFileWriter::close()
+{
+    if (fd_ < 0)
+    {
+        return;
+    }
+    writePageIndexes();
+    std::vector<uint8_t> footer;
+    const uint8_t *magic = kMagic;
+    if (!encryptor_)
+    {
+        footer = serializeThrift(metadata_);
+    }
+    else if (encryptor_->plaintextFooter())
+    {
+        metadata_.encryption_algorithm = encryptor_->algorithm();
+        if (!encryptor_->properties().footer_key_metadata.empty())
+        {
+            metadata_.footer_signing_key_metadata = encryptor_->properties().footer_key_metadata;
+        }
+        footer = serializeThrift(metadata_);
+        size_t size = footer.size();
+        footer.resize(size + kFooterSignatureSize);
+        encryptor_->footerCipher().sign(footer.data(), size, footer.data() + size);
+    }
+    else
+    {
+        FileCryptoMetaData crypto_metadata;
+        crypto_metadata.encryption_algorithm = encryptor_->algorithm();
+        if (!encryptor_->properties().footer_key_metadata.empty())
+        {
+            crypto_metadata.key_metadata = encryptor_->properties().footer_key_metadata;
+        }
+        footer = serializeThrift(crypto_metadata);
+        std::vector<uint8_t> plaintext = serializeThrift(metadata_);
+        const ModuleCipher &cipher = encryptor_->footerCipher();
+        cipher.encrypt(ModuleType::FOOTER, plaintext.data(), plaintext.size(), cipher.aad(ModuleType::FOOTER), footer);
+        magic = kEncryptedMagic;
+    }
+    appendLength(footer, static_cast<uint32_t>(footer.size()));
+    footer.insert(footer.end(), magic, magic + sizeof(kMagic));
+    write(footer.data(), footer.size());
+
+    int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot close " + path_);
+    }
+}
+
+void ParquetFileWriter::write(const uint8_t *data, size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t n = ::write(fd_, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "Cannot write " + path_);
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+        offset_ += static_cast<uint64_t>(n);
+    }
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "column_batch.hpp"
+#include "encryption.hpp"
+#include "io.hpp"
+#include "parquet_metadata.hpp"
+#include "thread_pool.hpp"
+
+struct WriterOptions
+{
+    CompressionCodec codec = CompressionCodec::UNCOMPRESSED;
+
+    /// Codecs pinned per dotted column path, taking precedence over `codec`
+    std::map<std::string, CompressionCodec> column_codecs;
+
+    /// Target size of the encoded values of one data page
+    size_t page_size = 1 << 20;
+
+    /// Most rows in one data page, so the page index stays fine grained enough to skip
+    /// pages of well compressible columns; 0 for no limit
+    size_t page_row_limit = 20000;
+
+    /// Picks the encoding of every data page among those its column type allows, see
+    /// ParquetFileWriter. Otherwise pages are PLAIN unless pinned in column_encodings.
+    bool adaptive_encoding = false;
+
+    /// Value encodings pinned per dotted column path, taking precedence over
+    /// adaptive_encoding: PLAIN, RLE_DICTIONARY, DELTA_BINARY_PACKED, DELTA_BYTE_ARRAY or
+    /// BYTE_STREAM_SPLIT, as far as the column type allows
+    std::map<std::string, Encoding> column_encodings;
+
+    /// How much decoding speed counts against size when choosing an encoding: a candidate
+    /// costs its compressed size times 1 + weight * its decoding cost relative to PLAIN.
+    /// 0 picks the smallest pages.
+    double decode_cost_weight = 0.1;
+
+    /// Values of every page the candidate encodings are tried on
+    size_t encoding_sample_size = 1024;
+
+    /// Largest dictionary page of a column chunk; RLE_DICTIONARY falls back to PLAIN for
+    /// chunks with more distinct values
+    size_t max_dictionary_size = 1 << 20;
+
+    /// Writes the ColumnIndex and OffsetIndex of every column chunk in front of the footer
+    bool write_page_index = true;
+
+    std::string created_by = "cpp formats";
+
+    /// Key-value metadata of the footer
+    std::vector<KeyValue> key_value_metadata;
+
+    /// Dotted paths of the columns that get a Bloom filter per column chunk
+    std::vector<std::string> bloom_filter_columns;
+
+    /// False positive probability the Bloom filters are sized for, assuming every value
+    /// of a chunk is distinct
+    double bloom_filter_fpp = 0.01;
+
+    /// Modular encryption of the file, see encryption.hpp
+    std::optional<FileEncryptionProperties> encryption;
+
+    /// Pool to encode the column chunks of a row group on in parallel; when null they are
+    /// encoded one after the other. Must not be a pool whose tasks call writeRowGroup().
+    ThreadPool *pool = nullptr;
+};
+
+/**
+ * @brief A column chunk to take over verbatim from another Parquet file.
+ */
+struct CopiedColumnChunk
+{
+    /// The pages of the chunk, from its first page to its end
+    Slice bytes;
+
+    /// Its metadata, with the offsets it has in the source file
+    ColumnMetaData metadata;
+
+    /// The offset of `bytes` in the source file
+    uint64_t source_offset = 0;
+
+    /// Its page indexes; null if the source file has none
+    std::shared_ptr<const ColumnIndex> column_index;
+    std::shared_ptr<const OffsetIndex> offset_index;
+
+    /// Its Bloom filter as stored in the source file, header included; empty if it has none
+    Slice bloom_filter;
+};
+
+/**
+ * @brief One column of a row group: either values to encode (with their definition
+ * levels, see ParquetFileWriter::writeRowGroup()) or a chunk to copy.
+ */
+struct RowGroupColumn
+{
+    const ColumnBatch *batch = nullptr;
+    const int16_t *definition_levels = nullptr;
+    const CopiedColumnChunk *copy = nullptr;
+};
+
+/**
+ * @brief Writes non-repeated columns to a Parquet file, one row group per call.
+ *
+ * Values go to V1 data pages with RLE encoded definition levels. Pages are PLAIN encoded
+ * by default. With WriterOptions::adaptive_encoding, the first encoding_sample_size
+ * values of every page are encoded (and compressed) with each candidate, and the page
+ * gets the one with the lowest size weighed by decoding cost; a chunk's dictionary page
+ * counts towards its dictionary encoded pages in proportion to their values. Pages whose
+ * encoding beats PLAIN grow to keep page_size bytes of encoded values.
+ *
+ * Statistics (null count, and min and max of the non-null values), SizeStatistics and the
+ * page index are collected in the pass that writes the definition levels, so every page
+ * header carries its Statistics too. Bloom filters of a row group are written right after
+ * its column chunks, the page indexes of all row groups in front of the footer. With
+ * WriterOptions::encryption set, pages, page headers, Bloom filters, page indexes, column
+ * metadata and the footer are encrypted or signed as modules.
+ *
+ * Column chunks are encoded in memory, in parallel with WriterOptions::pool, and then
+ * written in column order. A row group may also take over chunks of another file as they
+ * are (CopiedColumnChunk), without decoding them; their offsets, including those of their
+ * page index, are moved to where they land in this file.
+ */
+class ParquetFileWriter
+{
+public:
+    /**
+     * @param columns Top level columns; max_definition_level is 0 for required and 1 for
+     * optional columns
+     * @throws std::invalid_argument for nested or repeated columns, Bloom filters on
+     * unknown or BOOLEAN columns, encodings pinned on unknown columns or columns of
+     * another type, or invalid encryption properties
+     * @throws std::system_error if the file cannot be created
+     */
+    ParquetFileWriter(const std::string &path, std::vector<ColumnDescriptor> columns, WriterOptions options = {});
+
+    /**
+     * @param schema Depth-first schema, starting with the root; groups may be nested and
+     * optional but not repeated
+     * @throws std::invalid_argument for repeated fields, Bloom filters on unknown or
+     * BOOLEAN columns, encodings pinned on unknown columns or columns of another type, or
+     * invalid encryption properties
+     * @throws ParquetException if the schema tree is malformed
+     * @throws std::system_error if the file cannot be created
+     */
+    ParquetFileWriter(const std::string &path, std::vector<SchemaElement> schema, WriterOptions options = {});
+
+    /**
+     * @brief Closes the file if close() was not called; errors are ignored.
+     */
+    ~ParquetFileWriter();
+
+    ParquetFileWriter(const ParquetFileWriter &) = delete;
+    ParquetFileWriter &operator=(const ParquetFileWriter &) = delete;
+
+    /**
+     * @brief Writes one row group with one batch per column, all of the same length.
+     *
+     * Null slots of a column below optional groups need their definition level, i.e. the
+     * number of optional ancestors (and the column itself) that are present. It is taken
+     * from `definition_levels`, one array per column with one level per slot, where given;
+     * otherwise a null slot is assumed to only lack its own value (max level - 1).
+     *
+     * @throws std::invalid_argument if the batches do not match the columns, or a level
+     * is out of range or disagrees with the batch's validity
+     * @throws std::system_error on I/O errors
+     */
+    void writeRowGroup(const std::vector<const ColumnBatch *> &batches,
+                       const std::vector<const int16_t *> &definition_levels = {});
+
+    /**
+     * @brief Writes one row group of `num_rows` rows with one entry per column, each with
+     * either a batch of `num_rows` slots or a copied chunk of `num_rows` values.
+     *
+     * @throws std::invalid_argument if the entries do not match the columns, as for the
+     * overload above, or if chunks are copied into an encrypted file
+     * @throws std::system_error on I/O errors
+     */
+    void writeRowGroup(const std::vector<RowGroupColumn> &columns, size_t num_rows);
+
+    /**
+     * @brief Writes the page indexes and the footer and closes the file.
+     */
+    void close();
+
+private:
+    /// A column chunk encoded in memory, with offsets relative to the start of `bytes`
+    struct EncodedChunk
+    {
+        std::vector<uint8_t> bytes;
+        ColumnChunk chunk;
+        ColumnIndex column_index;
+        OffsetIndex offset_index;
+
+        // Scratch space of appendPage()
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> encrypted;
+    };
+
+    void checkColumn(size_t column, const RowGroupColumn &entry, size_t num_rows) const;
+    EncodedChunk encodeColumnChunk(size_t column, const ColumnBatch &batch, const int16_t *definition_levels,
+                                   int64_t row_group) const;
+    size_t appendPage(PageHeader &header, const std::vector<uint8_t> &page, size_t column, int64_t row_group,
+                      int64_t page_ordinal, ColumnMetaData &metadata, EncodedChunk &out) const;
+    void writeBloomFilter(size_t column, const ColumnBatch &batch, ColumnMetaData &metadata);
+    void encryptColumnMetaData(size_t column, ColumnChunk &chunk) const;
+    void writePageIndexes();
+    template <typename T>
+    void writeIndex(const T &index, ModuleType type, size_t row_group, size_t column, std::optional<int64_t> &offset,
+                    std::optional<int32_t> &length);
+    void write(const uint8_t *data, size_t size);
+
+    std::string path_;
+    int fd_ = -1;
+    uint64_t offset_ = 0;
+    std::vector<ColumnDescriptor> columns_;
+    std::vector<bool> bloom_filters_;
+    std::vector<std::optional<Encoding>> encodings_;
+    std::vector<CompressionCodec> codecs_;
+    WriterOptions options_;
+    FileMetaData metadata_;
+    std::unique_ptr<FileEncryptor> encryptor_;
+
+    // Page indexes of the row groups written so far, one per column chunk
+    std::vector<std::vector<ColumnIndex>> column_indexes_;
+    std::vector<std::vector<OffsetIndex>> offset_indexes_;
+};
@@ -0,0 +1,124 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+#include "benchmark_file.hpp"
+#include "parquet_rewriter.hpp"
+
+// Rewriting a Parquet file against decoding and encoding all of it, on the 1M row
+// BenchmarkFile of benchmark_file.hpp (row groups of 128K rows, Snappy compression).
+//
+// BM_Rewrite modes:
+// - copy: drops url and copies every other chunk as it is
+// - one_column: re-encodes price with BYTE_STREAM_SPLIT and copies the rest
+// - codec: decompresses every chunk (UNCOMPRESSED), i.e. re-encodes everything
+// - sort: sorts every row group by key, re-encoding everything
+// BM_DecodeEncode is the baseline of a tool without page copying: every chunk is decoded
+// and written again, one after the other. Work runs on pool threads, hence wall times.
+
+namespace
+{
+    constexpr size_t kRows = 1000000;
+
+    enum Mode
+    {
+        kCopy,
+        kOneColumn,
+        kCodec,
+        kSort
+    };
+
+    const BenchmarkFile &benchmarkFile()
+    {
+        static BenchmarkFile file("rewrite_benchmark", kRows);
+        return file;
+    }
+
+    RewriteOptions rewriteOptions(int64_t mode, int64_t threads)
+    {
+        RewriteOptions options;
+        options.threads = static_cast<size_t>(threads);
+        switch (mode)
+        {
+        case kCopy:
+            options.columns = {"id", "key", "price", "quantity", "name"};
+            break;
+        case kOneColumn:
+            options.column_encodings = {{"price", Encoding::BYTE_STREAM_SPLIT}};
+            break;
+        case kCodec:
+            options.codec = CompressionCodec::UNCOMPRESSED;
+            break;
+        case kSort:
+            options.sort_column = "key";
+            break;
+        default:
+            break;
+        }
+        return options;
+    }
+
+    void rewriteArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"mode", "threads"});
+        benchmark->ArgsProduct({{kCopy, kOneColumn, kCodec, kSort}, {1, 4}});
+        benchmark->UseRealTime();
+        benchmark->Unit(benchmark::kMillisecond);
+    }
+} // namespace
+
+static void BM_Rewrite(benchmark::State &state)
+{
+    const BenchmarkFile &file = benchmarkFile();
+    RewriteOptions options = rewriteOptions(state.range(0), state.range(1));
+    RewriteResult result;
+    for (auto _ : state)
+    {
+        result = rewriteParquetFile(file.path(), file.output(), options);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * result.input_bytes));
+    state.counters["copied_chunks"] = static_cast<double>(result.copied_chunks);
+    state.counters["rewritten_chunks"] = static_cast<double>(result.rewritten_chunks);
+    state.counters["output_bytes"] = static_cast<double>(result.output_bytes);
+}
+
+static void BM_DecodeEncode(benchmark::State &state)
+{
+    const BenchmarkFile &file = benchmarkFile();
+    uint64_t input_bytes = 0;
+    for (auto _ : state)
+    {
+        ParquetFileReader reader(file.path());
+        input_bytes = reader.size();
+        WriterOptions options;
+        options.codec = CompressionCodec::SNAPPY;
+        options.column_encodings = {{"quantity", Encoding::RLE_DICTIONARY}, {"name", Encoding::RLE_DICTIONARY}};
+        ParquetFileWriter writer(file.output(), reader.metadata().schema, options);
+        for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+        {
+            std::vector<ColumnBatch> batches;
+            std::vector<const ColumnBatch *> pointers;
+            for (size_t column = 0; column < reader.columns().size(); ++column)
+            {
+                ColumnBatch &batch = batches.emplace_back(reader.columns()[column].type);
+                ColumnChunkReader chunk = reader.columnChunk(rg, column);
+                while (chunk.readBatch(batch, kDefaultBatchSize) > 0)
+                {
+                }
+            }
+            for (const ColumnBatch &batch : batches)
+            {
+                pointers.push_back(&batch);
+            }
+            writer.writeRowGroup(pointers);
+        }
+        writer.close();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input_bytes));
+}
+
+BENCHMARK(BM_Rewrite)->Apply(rewriteArgs);
+BENCHMARK(BM_DecodeEncode)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
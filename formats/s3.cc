@@ -0,0 +1,552 @@
+#include "s3.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "instrumentation.hpp"
+#include "parquet.hpp"
+#include "sha256.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+    const char kEmptyPayloadHash[] = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
+
+    std::string lowercase(std::string value)
+    {
+        std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        return value;
+    }
+
+    std::string trim(const std::string &value)
+    {
+        size_t first = value.find_first_not_of(" \t");
+        if (first == std::string::npos)
+        {
+            return {};
+        }
+        return value.substr(first, value.find_last_not_of(" \t") - first + 1);
+    }
+
+    // Percent-encoding as S3 expects it in paths: everything but unreserved characters
+    // and the separators
+    std::string uriEncode(const std::string &value)
+    {
+        static const char kDigits[] = "0123456789ABCDEF";
+        std::string encoded;
+        for (unsigned char c : value)
+        {
+            if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~' || c == '/')
+            {
+                encoded += static_cast<char>(c);
+            }
+            else
+            {
+                encoded += '%';
+                encoded += kDigits[c >> 4];
+                encoded += kDigits[c & 0xf];
+            }
+        }
+        return encoded;
+    }
+
+    std::string amzDate()
+    {
+        std::time_t now = std::time(nullptr);
+        std::tm utc;
+        ::gmtime_r(&now, &utc);
+        char buffer[17];
+        std::strftime(buffer, sizeof(buffer), "%Y%m%dT%H%M%SZ", &utc);
+        return buffer;
+    }
+
+    // The value of an XML element of an S3 error response, e.g. <Code>NoSuchKey</Code>
+    std::string xmlElement(const std::vector<uint8_t> &body, const std::string &name)
+    {
+        std::string text(body.begin(), body.end());
+        size_t start = text.find("<" + name + ">");
+        size_t end = text.find("</" + name + ">");
+        if (start == std::string::npos || end == std::string::npos || end < start)
+        {
+            return {};
+        }
+        start += name.size() + 2;
+        return text.substr(start, end - start);
+    }
+
+    [[noreturn]] void throwStatus(const HttpResponse &response, const std::string &what)
+    {
+        int error = EIO;
+        switch (response.status)
+        {
+        case 403:
+            error = EACCES;
+            break;
+        case 404:
+            error = ENOENT;
+            break;
+        case 412:
+            error = ESTALE;
+            break;
+        }
+        std::string message = what + ": HTTP " + std::to_string(response.status);
+        std::string code = xmlElement(response.body, "Code");
+        if (!code.empty())
+        {
+            message += " " + code;
+        }
+        throw std::system_error(error, std::generic_category(), message);
+    }
+
+    std::string rangeHeader(ReadRange range)
+    {
+        return "bytes=" + std::to_string(range.offset) + "-" + std::to_string(range.end() - 1);
+    }
+} // namespace
+
+S3Options S3Options::fromEnvironment()
+{
+    S3Options options;
+    auto read = [](const char *name, std::string &value)
+    {
+        if (const char *set = std::getenv(name))
+        {
+            value = set;
+        }
+    };
+    read("AWS_ENDPOINT_URL", options.endpoint);
+    read("AWS_REGION", options.region);
+    read("AWS_ACCESS_KEY_ID", options.access_key);
+    read("AWS_SECRET_ACCESS_KEY", options.secret_key);
+    read("AWS_SESSION_TOKEN", options.session_token);
+    return options;
+}
+
+void signRequestV4(HttpRequest &request, const std::string &host, const S3Options &options,
+                   const std::string &amz_date)
+{
+    std::string payload_hash = request.body.empty()
+                                   ? std::string(kEmptyPayloadHash)
+                                   : toHex(sha256(std::string(request.body.begin(), request.body.end())));
+    request.headers.emplace_back("x-amz-date", amz_date);
+    request.headers.emplace_back("x-amz-content-sha256", payload_hash);
+    if (!options.session_token.empty())
+    {
+        request.headers.emplace_back("x-amz-security-token", options.session_token);
+    }
+
+    std::vector<std::pair<std::string, std::string>> headers = {{"host", host}};
+    for (const auto &[name, value] : request.headers)
+    {
+        headers.emplace_back(lowercase(name), trim(value));
+    }
+    std::sort(headers.begin(), headers.end());
+    std::string canonical_headers;
+    std::string signed_headers;
+    for (const auto &[name, value] : headers)
+    {
+        canonical_headers += name + ":" + value + "\n";
+        signed_headers += (signed_headers.empty() ? "" : ";") + name;
+    }
+
+    size_t query_start = request.target.find('?');
+    std::string path = request.target.substr(0, query_start);
+    std::string query;
+    if (query_start != std::string::npos)
+    {
+        std::vector<std::string> parameters;
+        std::string rest = request.target.substr(query_start + 1);
+        for (size_t start = 0; start <= rest.size();)
+        {
+            size_t end = std::min(rest.find('&', start), rest.size());
+            std::string parameter = rest.substr(start, end - start);
+            parameters.push_back(parameter.find('=') == std::string::npos ? parameter + "=" : parameter);
+            start = end + 1;
+        }
+        std::sort(parameters.begin(), parameters.end());
+        for (const std::string &parameter : parameters)
+        {
+            query += (query.empty() ? "" : "&") + parameter;
+        }
+    }
+
+    std::string canonical_request = request.method + "\n" + path + "\n" + query + "\n" + canonical_headers + "\n" +
+                                    signed_headers + "\n" + payload_hash;
+    std::string date = amz_date.substr(0, 8);
+    std::string scope = date + "/" + options.region + "/s3/aws4_request";
+    std::string string_to_sign = "AWS4-HMAC-SHA256\n" + amz_date + "\n" + scope + "\n" +
+                                 toHex(sha256(canonical_request));
+
+    Sha256Digest key = hmacSha256("AWS4" + options.secret_key, date);
+    key = hmacSha256(key.data(), key.size(), options.region);
+    key = hmacSha256(key.data(), key.size(), "s3");
+    key = hmacSha256(key.data(), key.size(), "aws4_request");
+    std::string signature = toHex(hmacSha256(key.data(), key.size(), string_to_sign));
+
+    request.headers.emplace_back("Authorization", "AWS4-HMAC-SHA256 Credential=" + options.access_key + "/" + scope +
+                                                      ",SignedHeaders=" + signed_headers +
+                                                      ",Signature=" + signature);
+}
+
+// State shared by an S3FileSystem and the files it opened
+struct S3Client
+{
+    S3Client(S3Options options_, std::string host, uint16_t port)
+        : options(std::move(options_)), client(std::move(host), port, options.io_threads + 4),
+          pool(std::max<size_t>(options.io_threads, 1))
+    {
+    }
+
+    /**
+     * Signs and sends a request, retrying server errors and connection failures.
+     */
+    HttpResponse send(const HttpRequest &request)
+    {
+        for (int attempt = 0;; ++attempt)
+        {
+            HttpRequest signed_request = request;
+            if (!options.access_key.empty())
+            {
+                signRequestV4(signed_request, client.authority(), options, amzDate());
+            }
+            ++requests;
+            try
+            {
+                HttpResponse response = client.send(signed_request);
+                bytes += response.body.size();
+                if (response.status < 500 || attempt >= options.max_retries)
+                {
+                    return response;
+                }
+            }
+            catch (const std::system_error &)
+            {
+                if (attempt >= options.max_retries)
+                {
+                    throw;
+                }
+            }
+            ++retries;
+            std::this_thread::sleep_for(options.retry_delay * (1 << attempt));
+        }
+    }
+
+    S3Options options;
+    HttpClient client;
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> retries{0};
+    std::atomic<uint64_t> bytes{0};
+
+    // Last, so the I/O threads are joined before anything they use is destroyed
+    ThreadPool pool;
+};
+
+namespace
+{
+    class S3File : public RandomAccessFile
+    {
+    public:
+        S3File(std::shared_ptr<S3Client> client, const std::string &path, std::string target);
+        ~S3File() override;
+
+        uint64_t size() const override { return size_; }
+        std::string version() const override { return etag_; }
+        void readAt(uint64_t offset, size_t size, uint8_t *out) const override;
+        std::future<Slice> readAsync(ReadRange range) const override;
+
+    private:
+        void check(ReadRange range) const;
+        bool inTail(ReadRange range) const { return range.offset >= size_ - tail_.size; }
+        HttpResponse get(ReadRange range) const;
+        void fetch(ReadRange range, uint8_t *out) const;
+        void run(std::function<void()> work) const;
+
+        std::shared_ptr<S3Client> client_;
+        std::string target_;
+        uint64_t size_ = 0;
+        std::string etag_;
+        Slice tail_;
+
+        // Tasks on the I/O threads still referencing the file
+        mutable std::mutex mutex_;
+        mutable std::condition_variable idle_;
+        mutable size_t pending_ = 0;
+    };
+
+    S3File::S3File(std::shared_ptr<S3Client> client, const std::string &path, std::string target)
+        : RandomAccessFile(path), client_(std::move(client)), target_(std::move(target))
+    {
+        const S3Options &options = client_->options;
+        HttpRequest request;
+        request.target = target_;
+        HttpResponse response;
+        if (options.footer_prefetch_size > 0)
+        {
+            // A suffix range returns the tail together with the object size
+            request.method = "GET";
+            request.headers.emplace_back("Range", "bytes=-" + std::to_string(options.footer_prefetch_size));
+            response = client_->send(request);
+            if (response.status == 206)
+            {
+                const std::string *content_range = response.header("Content-Range");
+                size_t slash = content_range ? content_range->rfind('/') : std::string::npos;
+                if (slash == std::string::npos)
+                {
+                    throw std::system_error(std::make_error_code(std::errc::protocol_error),
+                                            "Missing Content-Range in the response for " + path);
+                }
+                size_ = std::strtoull(content_range->c_str() + slash + 1, nullptr, 10);
+            }
+            else if (response.status == 200)
+            {
+                size_ = response.body.size();
+            }
+        }
+        // Empty objects cannot satisfy a suffix range
+        if (options.footer_prefetch_size == 0 || response.status == 416)
+        {
+            request.method = "HEAD";
+            request.headers.clear();
+            response = client_->send(request);
+            if (response.status == 200)
+            {
+                const std::string *length = response.header("Content-Length");
+                size_ = length ? std::strtoull(length->c_str(), nullptr, 10) : 0;
+            }
+        }
+        if (response.status != 200 && response.status != 206)
+        {
+            throwStatus(response, "Cannot open " + path);
+        }
+        if (response.body.size() > size_)
+        {
+            throw std::system_error(std::make_error_code(std::errc::protocol_error),
+                                    "Response for " + path + " is larger than the object");
+        }
+        if (const std::string *etag = response.header("ETag"))
+        {
+            etag_ = *etag;
+        }
+        tail_ = Slice::fromVector(std::move(response.body));
+    }
+
+    S3File::~S3File()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this]()
+                   { return pending_ == 0; });
+    }
+
+    void S3File::check(ReadRange range) const
+    {
+        if (range.end() > size_ || range.end() < range.offset)
+        {
+            throw ParquetException("Unexpected end of " + path());
+        }
+    }
+
+    HttpResponse S3File::get(ReadRange range) const
+    {
+        FORMATS_TIME(READ);
+        FORMATS_COUNT(BYTES_READ, range.length);
+        FORMATS_COUNT(READ_CALLS, 1);
+        HttpRequest request;
+        request.method = "GET";
+        request.target = target_;
+        request.headers.emplace_back("Range", rangeHeader(range));
+        if (!etag_.empty())
+        {
+            request.headers.emplace_back("If-Match", etag_);
+        }
+        HttpResponse response = client_->send(request);
+        if (response.status != 206 && !(response.status == 200 && range.offset == 0 && range.length == size_))
+        {
+            throwStatus(response, "Cannot read " + path());
+        }
+        if (response.body.size() != range.length)
+        {
+            throw std::system_error(std::make_error_code(std::errc::protocol_error),
+                                    "Short response reading " + path());
+        }
+        return response;
+    }
+
+    void S3File::fetch(ReadRange range, uint8_t *out) const
+    {
+        HttpResponse response = get(range);
+        std::memcpy(out, response.body.data(), range.length);
+    }
+
+    void S3File::readAt(uint64_t offset, size_t size, uint8_t *out) const
+    {
+        ReadRange range{offset, size};
+        check(range);
+        if (size == 0)
+        {
+            return;
+        }
+        if (inTail(range))
+        {
+            std::memcpy(out, tail_.data + (offset - (size_ - tail_.size)), size);
+            return;
+        }
+        fetch(range, out);
+    }
+
+    void S3File::run(std::function<void()> work) const
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++pending_;
+        }
+        client_->pool.submit([this, work = std::move(work)]()
+                             {
+                                 work();
+                                 // Notify under the lock, the file may be destroyed right after
+                                 std::lock_guard<std::mutex> lock(mutex_);
+                                 if (--pending_ == 0)
+                                 {
+                                     idle_.notify_all();
+                                 } });
+    }
+
+    std::future<Slice> S3File::readAsync(ReadRange range) const
+    {
+        check(range);
+        auto promise = std::make_shared<std::promise<Slice>>();
+        std::future<Slice> future = promise->get_future();
+        if (range.length == 0 || inTail(range))
+        {
+            promise->set_value(range.length == 0 ? Slice()
+                                                 : tail_.sub(static_cast<size_t>(range.offset - (size_ - tail_.size)),
+                                                             range.length));
+            return future;
+        }
+
+        size_t part_size = std::max<size_t>(client_->options.part_size, 1);
+        if (range.length <= part_size)
+        {
+            run([this, range, promise]()
+                {
+                    try
+                    {
+                        HttpResponse response = get(range);
+                        promise->set_value(Slice::fromVector(std::move(response.body)));
+                    }
+                    catch (...)
+                    {
+                        promise->set_exception(std::current_exception());
+                    } });
+            return future;
+        }
+
+        // Parts land in one buffer; the last part to finish fulfils the promise
+        struct Parts
+        {
+            std::vector<uint8_t> bytes;
+            std::atomic<size_t> remaining;
+            std::mutex mutex;
+            std::exception_ptr error;
+        };
+        auto parts = std::make_shared<Parts>();
+        parts->bytes.resize(range.length);
+        size_t count = (range.length + part_size - 1) / part_size;
+        parts->remaining = count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            size_t offset = i * part_size;
+            ReadRange part{range.offset + offset, std::min(part_size, range.length - offset)};
+            run([this, part, offset, parts, promise]()
+                {
+                    try
+                    {
+                        fetch(part, parts->bytes.data() + offset);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(parts->mutex);
+                        if (!parts->error)
+                        {
+                            parts->error = std::current_exception();
+                        }
+                    }
+                    if (--parts->remaining == 0)
+                    {
+                        if (parts->error)
+                        {
+                            promise->set_exception(parts->error);
+                        }
+                        else
+                        {
+                            promise->set_value(Slice::fromVector(std::move(parts->bytes)));
+                        }
+                    } });
+        }
+        return future;
+    }
+
+    // Splits s3://bucket/key or bucket/key into the bucket and the key
+    std::pair<std::string, std::string> splitPath(const std::string &path)
+    {
+        std::string rest = path.compare(0, 5, "s3://") == 0 ? path.substr(5) : path;
+        size_t slash = rest.find('/');
+        if (slash == std::string::npos || slash == 0 || slash + 1 == rest.size())
+        {
+            throw std::invalid_argument("Invalid S3 path " + path + ", expected s3://bucket/key");
+        }
+        return {rest.substr(0, slash), rest.substr(slash + 1)};
+    }
+} // namespace
+
+S3FileSystem::S3FileSystem(S3Options options)
+{
+    const std::string scheme = "http://";
+    if (options.endpoint.compare(0, scheme.size(), scheme) != 0)
+    {
+        throw std::invalid_argument("Unsupported S3 endpoint " + options.endpoint + ", only http:// is supported");
+    }
+    std::string authority = options.endpoint.substr(scheme.size());
+    authority = authority.substr(0, authority.find('/'));
+    size_t colon = authority.rfind(':');
+    std::string host = authority.substr(0, colon);
+    uint16_t port = 80;
+    if (colon != std::string::npos)
+    {
+        int parsed = std::atoi(authority.c_str() + colon + 1);
+        if (parsed <= 0 || parsed > 65535)
+        {
+            throw std::invalid_argument("Invalid port in S3 endpoint " + options.endpoint);
+        }
+        port = static_cast<uint16_t>(parsed);
+    }
+    client_ = std::make_shared<S3Client>(std::move(options), std::move(host), port);
+}
+
+S3FileSystem::~S3FileSystem() = default;
+
+std::shared_ptr<const RandomAccessFile> S3FileSystem::openFile(const std::string &path) const
+{
+    auto [bucket, key] = splitPath(path);
+    return std::make_shared<S3File>(client_, path, "/" + uriEncode(bucket) + "/" + uriEncode(key));
+}
+
+S3Stats S3FileSystem::stats() const
+{
+    S3Stats stats;
+    stats.requests = client_->requests.load();
+    stats.retries = client_->retries.load();
+    stats.bytes = client_->bytes.load();
+    return stats;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "filesystem.hpp"
+#include "http.hpp"
+
+struct S3Options
+{
+    /// http://host[:port] of an S3 compatible service, requests use path-style addressing.
+    /// TLS is not supported, https endpoints need a local proxy.
+    std::string endpoint = "http://127.0.0.1:9000";
+    std::string region = "us-east-1";
+
+    /// Requests are signed with AWS Signature Version 4 unless the access key is empty
+    std::string access_key;
+    std::string secret_key;
+    std::string session_token;
+
+    /// Opening a file fetches this many bytes from its end together with its size, which
+    /// covers the footer reads of ParquetFileReader. 0 sends a HEAD request instead.
+    size_t footer_prefetch_size = 64 * 1024;
+
+    /// Asynchronous reads larger than this are split into parts fetched in parallel
+    size_t part_size = 8 * 1024 * 1024;
+
+    /// Threads issuing the asynchronous requests, i.e. requests in flight at once
+    size_t io_threads = 16;
+
+    /// Retries of requests failing with a 5xx status or a connection error, the delay
+    /// doubles on every attempt
+    int max_retries = 3;
+    std::chrono::milliseconds retry_delay{50};
+
+    /**
+     * @brief Options from AWS_ENDPOINT_URL, AWS_REGION, AWS_ACCESS_KEY_ID,
+     * AWS_SECRET_ACCESS_KEY and AWS_SESSION_TOKEN, defaults for the unset ones.
+     */
+    static S3Options fromEnvironment();
+};
+
+struct S3Stats
+{
+    uint64_t requests = 0;
+    uint64_t retries = 0;
+
+    /// Body bytes received
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Adds the AWS Signature Version 4 headers (x-amz-date, x-amz-content-sha256,
+ * Authorization) to a request for the given Host. Signs every header of the request.
+ * @param amz_date The request time, e.g. 20130524T000000Z
+ */
+void signRequestV4(HttpRequest &request, const std::string &host, const S3Options &options,
+                   const std::string &amz_date);
+
+struct S3Client;
+
+/**
+ * @brief Objects of an S3 compatible object store as random access files, read with HTTP
+ * range requests.
+ *
+ * Paths are s3://bucket/key or bucket/key. Every read is a request with high latency, so
+ * files should be read through a RangePrefetcher (the scanner does), which coalesces
+ * nearby ranges into one request and keeps requests in flight on the I/O threads, and
+ * possibly through a CachingFileSystem. Reads send If-Match with the ETag seen when the
+ * file was opened, so an object replaced in the meantime fails the read instead of
+ * mixing two versions.
+ */
+class S3FileSystem : public FileSystem
+{
+public:
+    /**
+     * @throws std::invalid_argument for an unsupported endpoint
+     */
+    explicit S3FileSystem(S3Options options = {});
+    ~S3FileSystem() override;
+
+    /**
+     * @throws std::system_error if the object does not exist (ENOENT), access is denied
+     * (EACCES) or the request fails
+     */
+    std::shared_ptr<const RandomAccessFile> openFile(const std::string &path) const override;
+
+    S3Stats stats() const;
+
+private:
+    std::shared_ptr<S3Client> client_;
+};
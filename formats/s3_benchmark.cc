@@ -0,0 +1,138 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+#include "fake_s3_server.hpp"
+#include "parquet_writer.hpp"
+#include "s3.hpp"
+#include "scanner.hpp"
+
+// Wall time and requests per query against the in-process fake S3 with injected latency.
+// A query opens the file (footer) and scans 2 of its 16 columns (8 row groups, ~32MB).
+// The variants compare reading every column chunk with its own request, coalescing
+// nearby chunks, skipping the footer prefetch (HEAD + footer reads instead), and a warm
+// block cache.
+
+namespace
+{
+    constexpr size_t kRowGroups = 8;
+    constexpr size_t kRowsPerGroup = 32 * 1024;
+    constexpr size_t kColumns = 16;
+
+    const std::vector<uint8_t> &fileBytes()
+    {
+        static std::vector<uint8_t> bytes = []()
+        {
+            std::string path = std::string("/tmp/s3_benchmark_") + std::to_string(::getpid()) + ".parquet";
+            std::vector<ColumnDescriptor> columns(kColumns);
+            for (size_t c = 0; c < kColumns; ++c)
+            {
+                columns[c].path = {std::string("c") + std::to_string(c)};
+                columns[c].type = AtomicType::INT64;
+            }
+            {
+                ParquetFileWriter writer(path, columns);
+                std::mt19937_64 rng(42);
+                for (size_t g = 0; g < kRowGroups; ++g)
+                {
+                    std::vector<ColumnBatch> batches;
+                    std::vector<const ColumnBatch *> pointers;
+                    for (size_t c = 0; c < kColumns; ++c)
+                    {
+                        ColumnBatch &batch = batches.emplace_back(AtomicType::INT64);
+                        int64_t *values = batch.appendValues<int64_t>(kRowsPerGroup);
+                        for (size_t i = 0; i < kRowsPerGroup; ++i)
+                        {
+                            values[i] = static_cast<int64_t>(rng());
+                        }
+                    }
+                    for (const auto &batch : batches)
+                    {
+                        pointers.push_back(&batch);
+                    }
+                    writer.writeRowGroup(pointers);
+                }
+            }
+            std::ifstream stream(path, std::ios::binary);
+            std::vector<uint8_t> contents((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+            std::remove(path.c_str());
+            return contents;
+        }();
+        return bytes;
+    }
+
+    enum Variant
+    {
+        kNoCoalescing,
+        kCoalescing,
+        kNoFooterPrefetch,
+        kWarmCache,
+    };
+} // namespace
+
+static void BM_S3Query(benchmark::State &state)
+{
+    FakeS3Server server(std::chrono::milliseconds(state.range(0)));
+    server.putObject("bucket", "table.parquet", fileBytes());
+    auto variant = static_cast<Variant>(state.range(1));
+
+    S3Options options;
+    options.endpoint = server.endpoint();
+    if (variant == kNoFooterPrefetch)
+    {
+        options.footer_prefetch_size = 0;
+    }
+    std::shared_ptr<const FileSystem> filesystem = std::make_shared<S3FileSystem>(options);
+    if (variant == kWarmCache)
+    {
+        filesystem = std::make_shared<CachingFileSystem>(filesystem, std::make_shared<BlockCache>(size_t{256} << 20));
+    }
+    ThreadPool pool(4);
+    ScanOptions scan;
+    scan.pool = &pool;
+    scan.ordered = false;
+    // Neighbouring columns, so coalescing reads both chunks of a row group at once
+    scan.columns = {"c3", "c4"};
+    if (variant == kNoCoalescing)
+    {
+        scan.coalesce.hole_size_limit = 0;
+        scan.coalesce.range_size_limit = 1;
+    }
+
+    auto query = [&]()
+    {
+        auto file = std::make_shared<ParquetFileReader>(filesystem->openFile("s3://bucket/table.parquet"));
+        ParquetScanner scanner(file, scan);
+        ScanBatch batch;
+        while (scanner.next(batch))
+        {
+            benchmark::DoNotOptimize(batch.batch->length());
+        }
+    };
+    if (variant == kWarmCache)
+    {
+        query();
+    }
+
+    server.resetStats();
+    for (auto _ : state)
+    {
+        query();
+    }
+    FakeS3Stats stats = server.stats();
+    state.counters["requests"] = benchmark::Counter(static_cast<double>(stats.requests), benchmark::Counter::kAvgIterations);
+    state.counters["MB"] = benchmark::Counter(static_cast<double>(stats.bytes) / 1e6, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_S3Query)
+    ->ArgNames({"latency_ms", "variant"})
+    ->ArgsProduct({{0, 5, 20}, {kNoCoalescing, kCoalescing, kNoFooterPrefetch, kWarmCache}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
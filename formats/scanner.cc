@@ -0,0 +1,486 @@
+#include "scanner.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "instrumentation.hpp"
+
+namespace
+{
+    size_t columnIndex(const std::vector<ColumnDescriptor> &descriptors, const std::string &name)
+    {
+        auto it = std::find_if(descriptors.begin(), descriptors.end(), [&name](const ColumnDescriptor &column)
+                               { return column.dottedPath() == name; });
+        if (it == descriptors.end())
+        {
+            throw std::invalid_argument("Unknown column " + name);
+        }
+        return static_cast<size_t>(it - descriptors.begin());
+    }
+
+    /**
+     * @brief Raw chunk, decompressed pages and decoded values, each about one chunk worth.
+     */
+    size_t chunkFootprint(const ColumnMetaData &metadata)
+    {
+        return static_cast<size_t>(std::max<int64_t>(metadata.total_compressed_size, 0)) +
+               2 * static_cast<size_t>(std::max<int64_t>(metadata.total_uncompressed_size, 0));
+    }
+
+    /**
+     * @brief The number of rows from `first` on that hold the next `count` selected rows;
+     * there must be that many.
+     */
+    size_t rowsHolding(const RankSelect &ranks, size_t first, size_t count)
+    {
+        return ranks.select(ranks.rank(first) + count - 1) + 1 - first;
+    }
+
+    /**
+     * @brief The number of runs of set bits.
+     */
+    size_t countRuns(const Bitmap &bitmap)
+    {
+        // A run starts at every set bit whose predecessor is clear
+        size_t runs = 0;
+        uint64_t carry = 0;
+        for (size_t w = 0; w < bitmap.wordCount(); ++w)
+        {
+            uint64_t word = bitmap.words()[w];
+            runs += static_cast<size_t>(__builtin_popcountll(word & ~((word << 1) | carry)));
+            carry = word >> 63;
+        }
+        return runs;
+    }
+
+    // Selections with a run per fewer rows than this are scattered, see decodeSelected()
+    constexpr size_t kScatteredRowsPerRun = 16;
+} // namespace
+
+ParquetScanner::ParquetScanner(std::shared_ptr<const ParquetFileReader> file, ScanOptions options)
+    : file_(std::move(file)), options_(std::move(options))
+{
+    if (options_.batch_size == 0)
+    {
+        throw std::invalid_argument("Batch size must be positive");
+    }
+
+    const auto &descriptors = file_->columns();
+    std::vector<size_t> columns;
+    if (options_.columns.empty())
+    {
+        for (size_t i = 0; i < descriptors.size(); ++i)
+        {
+            columns.push_back(i);
+        }
+    }
+    for (const auto &name : options_.columns)
+    {
+        columns.push_back(columnIndex(descriptors, name));
+    }
+    if (!options_.filter_columns.empty() && !options_.filter)
+    {
+        throw std::invalid_argument("Filter columns without a filter");
+    }
+    for (const auto &name : options_.filter_columns)
+    {
+        filter_columns_.push_back(columnIndex(descriptors, name));
+    }
+
+    std::vector<size_t> row_groups = options_.row_groups;
+    if (row_groups.empty())
+    {
+        for (size_t i = 0; i < file_->numRowGroups(); ++i)
+        {
+            row_groups.push_back(i);
+        }
+    }
+
+    for (size_t row_group : row_groups)
+    {
+        if (row_group >= file_->numRowGroups())
+        {
+            throw std::out_of_range("Row group " + std::to_string(row_group) + " does not exist");
+        }
+        Selection *selection = nullptr;
+        size_t filter_footprint = 0;
+        if (options_.filter)
+        {
+            selection = selections_.emplace_back(std::make_unique<Selection>()).get();
+            selection->row_group = row_group;
+            selection->column_users.assign(filter_columns_.size(), 0);
+            for (size_t column : filter_columns_)
+            {
+                filter_footprint += chunkFootprint(file_->columnMetaData(row_group, column));
+            }
+        }
+        for (size_t column : columns)
+        {
+            size_t footprint = chunkFootprint(file_->columnMetaData(row_group, column)) + filter_footprint;
+            std::optional<size_t> filter_column;
+            auto filter = std::find(filter_columns_.begin(), filter_columns_.end(), column);
+            if (selection != nullptr && filter != filter_columns_.end() && !options_.dictionary_indices)
+            {
+                filter_column = static_cast<size_t>(filter - filter_columns_.begin());
+                ++selection->column_users[*filter_column];
+            }
+            chunks_.push_back({row_group, column, footprint, selection, 0, filter_column, {}});
+            filter_footprint = 0;
+        }
+    }
+
+    // Chunks copying the rows of a filter column read nothing
+    std::vector<ReadRange> ranges;
+    for (Chunk &chunk : chunks_)
+    {
+        if (!chunk.filter_column)
+        {
+            chunk.range = ranges.size();
+            ranges.push_back(file_->columnChunkRange(chunk.row_group, chunk.column));
+        }
+    }
+    for (const auto &selection : selections_)
+    {
+        selection->first_range = ranges.size();
+        for (size_t column : filter_columns_)
+        {
+            ranges.push_back(file_->columnChunkRange(selection->row_group, column));
+        }
+    }
+    prefetcher_ = std::make_unique<RangePrefetcher>(file_->file(), ranges, options_.coalesce);
+
+    if (options_.pool != nullptr)
+    {
+        pool_ = options_.pool;
+    }
+    else
+    {
+        owned_pool_ = std::make_unique<ThreadPool>(options_.threads);
+        pool_ = owned_pool_.get();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    schedule();
+}
+
+ParquetScanner::~ParquetScanner()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cancelled_ = true;
+    idle_cv_.wait(lock, [this]()
+                  { return active_tasks_ == 0; });
+}
+
+bool ParquetScanner::next(ScanBatch &out)
+{
+    FORMATS_TIME(SCAN_WAIT);
+    std::unique_lock<std::mutex> lock(mutex_);
+    size_t chunk;
+    while (true)
+    {
+        if (error_)
+        {
+            std::rethrow_exception(error_);
+        }
+
+        if (options_.ordered)
+        {
+            if (next_to_deliver_ == chunks_.size())
+            {
+                return false;
+            }
+            chunk = next_to_deliver_;
+            auto &batches = chunks_[chunk].batches;
+            if (!batches.empty())
+            {
+                out = std::move(batches.front());
+                batches.pop_front();
+                break;
+            }
+        }
+        else
+        {
+            if (finished_ == chunks_.size())
+            {
+                return false;
+            }
+            if (!ready_.empty())
+            {
+                chunk = ready_.front().chunk;
+                out = std::move(ready_.front().batch);
+                ready_.pop_front();
+                break;
+            }
+        }
+        ready_cv_.wait(lock);
+    }
+
+    if (out.last)
+    {
+        in_flight_bytes_ -= chunks_[chunk].footprint;
+        ++finished_;
+        if (options_.ordered)
+        {
+            ++next_to_deliver_;
+        }
+        schedule();
+    }
+    FORMATS_COUNT(BATCHES_SCANNED, 1);
+    return true;
+}
+
+size_t ParquetScanner::peakInFlightBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return peak_in_flight_bytes_;
+}
+
+void ParquetScanner::schedule()
+{
+    while (next_to_schedule_ < chunks_.size() && !cancelled_ && !error_)
+    {
+        size_t chunk = next_to_schedule_;
+        size_t footprint = chunks_[chunk].footprint;
+        if (in_flight_bytes_ > 0 && in_flight_bytes_ + footprint > options_.max_in_flight_bytes)
+        {
+            break;
+        }
+        in_flight_bytes_ += footprint;
+        peak_in_flight_bytes_ = std::max(peak_in_flight_bytes_, in_flight_bytes_);
+        ++next_to_schedule_;
+        Selection *selection = chunks_[chunk].selection;
+        if (selection != nullptr && !selection->prefetched)
+        {
+            for (size_t i = 0; i < filter_columns_.size(); ++i)
+            {
+                prefetcher_->prefetch(selection->first_range + i);
+            }
+            selection->prefetched = true;
+        }
+        if (!chunks_[chunk].filter_column)
+        {
+            prefetcher_->prefetch(chunks_[chunk].range);
+        }
+        submitLocked([this, chunk]()
+                     { read(chunk); });
+    }
+}
+
+void ParquetScanner::submit(std::function<void()> work)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    submitLocked(std::move(work));
+}
+
+void ParquetScanner::submitLocked(std::function<void()> work)
+{
+    if (cancelled_ || error_)
+    {
+        return;
+    }
+    ++active_tasks_;
+    pool_->submit([this, work = std::move(work)]()
+                  {
+                      std::exception_ptr error;
+                      try
+                      {
+                          work();
+                      }
+                      catch (...)
+                      {
+                          error = std::current_exception();
+                      }
+
+                      std::lock_guard<std::mutex> lock(mutex_);
+                      if (error && !error_)
+                      {
+                          error_ = error;
+                          ready_cv_.notify_all();
+                      }
+                      // Notify while holding the lock: the destructor may return as soon
+                      // as it can observe zero active tasks
+                      if (--active_tasks_ == 0)
+                      {
+                          idle_cv_.notify_all();
+                      } });
+}
+
+void ParquetScanner::read(size_t chunk)
+{
+    const Chunk &state = chunks_[chunk];
+    if (state.filter_column)
+    {
+        Selection &selection = select(*state.selection);
+        decodeSelected(chunk, nullptr, &selection.columns[*state.filter_column]);
+        releaseFilterColumn(selection, *state.filter_column);
+        return;
+    }
+    auto reader = std::make_shared<ColumnChunkReader>(
+        file_->columnChunk(state.row_group, state.column, prefetcher_->get(state.range)));
+    reader->keepDictionaryIndices(options_.dictionary_indices);
+    if (state.selection != nullptr)
+    {
+        const Bitmap &selection = select(*state.selection).bitmap;
+        if (auto offset_index = file_->offsetIndex(state.row_group, state.column))
+        {
+            reader->selectPages(*offset_index, file_->columnChunkRange(state.row_group, state.column).offset,
+                                selection);
+        }
+    }
+    submit([this, chunk, reader]()
+           {
+               reader->decompress();
+               submit([this, chunk, reader]()
+                      { decode(chunk, reader); }); });
+}
+
+void ParquetScanner::decode(size_t chunk, const std::shared_ptr<ColumnChunkReader> &reader)
+{
+    const Chunk &state = chunks_[chunk];
+    if (state.selection != nullptr)
+    {
+        decodeSelected(chunk, reader.get(), nullptr);
+        return;
+    }
+    const ColumnDescriptor &column = reader->column();
+    for (size_t sequence = 0;; ++sequence)
+    {
+        ScanBatch out;
+        out.row_group = state.row_group;
+        out.column = state.column;
+        out.sequence = sequence;
+        out.batch = std::make_shared<ColumnBatch>(column.type, column.type_length);
+        reader->readBatch(*out.batch, options_.batch_size);
+        out.last = !reader->hasNext();
+        bool last = out.last;
+        if (!deliver(chunk, std::move(out)) || last)
+        {
+            return;
+        }
+    }
+}
+
+void ParquetScanner::decodeSelected(size_t chunk, ColumnChunkReader *reader, const ColumnBatch *decoded)
+{
+    const Chunk &state = chunks_[chunk];
+    const ColumnDescriptor &column = file_->columns()[state.column];
+    // read() waited for the selection
+    const Selection &selection = *state.selection;
+    size_t num_rows = selection.bitmap.size();
+    size_t remaining = selection.ranks->count();
+    size_t row = 0;
+    // Decoding run by run costs a call per run. When the selected rows are scattered in
+    // short runs and no page can be left out, decoding every row and copying the selected
+    // ones is cheaper.
+    std::optional<ColumnBatch> all_rows;
+    if (reader != nullptr && selection.scattered && !reader->skipsPages())
+    {
+        all_rows.emplace(column.type, column.type_length);
+    }
+    for (size_t sequence = 0;; ++sequence)
+    {
+        // The last batch takes all remaining rows, so the reader sees the whole chunk
+        size_t rows = remaining > options_.batch_size ? rowsHolding(*selection.ranks, row, options_.batch_size)
+                                                      : num_rows - row;
+        ScanBatch out;
+        out.row_group = state.row_group;
+        out.column = state.column;
+        out.sequence = sequence;
+        out.batch = std::make_shared<ColumnBatch>(column.type, column.type_length);
+        if (all_rows)
+        {
+            all_rows->clear();
+            if (reader->readBatch(*all_rows, rows) != rows)
+            {
+                throw ParquetException("Column chunk of " + column.dottedPath() + " has fewer values than selected");
+            }
+            out.batch->appendSelected(*all_rows, 0, rows, selection.bitmap, row);
+        }
+        else if (reader != nullptr)
+        {
+            reader->readSelected(*out.batch, selection.bitmap, row, rows);
+        }
+        else
+        {
+            out.batch->appendSelected(*decoded, row, rows, selection.bitmap, row);
+        }
+        remaining -= out.batch->length();
+        row += rows;
+        out.last = row == num_rows;
+        bool last = out.last;
+        if (!deliver(chunk, std::move(out)) || last)
+        {
+            return;
+        }
+    }
+}
+
+ParquetScanner::Selection &ParquetScanner::select(Selection &selection)
+{
+    std::lock_guard<std::mutex> lock(selection.mutex);
+    if (selection.done)
+    {
+        return selection;
+    }
+    auto num_rows = static_cast<size_t>(file_->metadata().row_groups[selection.row_group].num_rows);
+    std::vector<ColumnBatch> columns;
+    for (size_t i = 0; i < filter_columns_.size(); ++i)
+    {
+        ColumnChunkReader reader =
+            file_->columnChunk(selection.row_group, filter_columns_[i], prefetcher_->get(selection.first_range + i));
+        ColumnBatch &batch = columns.emplace_back(reader.column().type, reader.column().type_length);
+        if (reader.readBatch(batch, num_rows) != num_rows)
+        {
+            throw ParquetException("Column chunk of " + reader.column().dottedPath() +
+                                   " has fewer values than its row group has rows");
+        }
+    }
+    selection.bitmap = Bitmap(num_rows);
+    options_.filter(columns, selection.bitmap);
+    if (selection.bitmap.size() != num_rows)
+    {
+        throw std::logic_error("The filter changed the size of the selection");
+    }
+    selection.ranks.emplace(selection.bitmap);
+    selection.scattered = countRuns(selection.bitmap) * kScatteredRowsPerRun > num_rows;
+    selection.columns = std::move(columns);
+    for (size_t i = 0; i < filter_columns_.size(); ++i)
+    {
+        if (selection.column_users[i] == 0)
+        {
+            ColumnBatch &batch = selection.columns[i];
+            batch = ColumnBatch(batch.type(), batch.typeLength());
+        }
+    }
+    selection.done = true;
+    return selection;
+}
+
+void ParquetScanner::releaseFilterColumn(Selection &selection, size_t filter_column)
+{
+    std::lock_guard<std::mutex> lock(selection.mutex);
+    if (--selection.column_users[filter_column] == 0)
+    {
+        ColumnBatch &batch = selection.columns[filter_column];
+        batch = ColumnBatch(batch.type(), batch.typeLength());
+    }
+}
+
+bool ParquetScanner::deliver(size_t chunk, ScanBatch batch)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (cancelled_ || error_)
+    {
+        return false;
+    }
+    if (options_.ordered)
+    {
+        chunks_[chunk].batches.push_back(std::move(batch));
+    }
+    else
+    {
+        ready_.push_back({chunk, std::move(batch)});
+    }
+    ready_cv_.notify_all();
+    return true;
+}
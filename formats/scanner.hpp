@@ -0,0 +1,206 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "column_batch.hpp"
+#include "io.hpp"
+#include "parquet_reader.hpp"
+#include "thread_pool.hpp"
+
+struct ScanOptions
+{
+    /// Dotted paths of the columns to read, all columns when empty
+    std::vector<std::string> columns;
+
+    /// Row groups to read, all row groups when empty
+    std::vector<size_t> row_groups;
+
+    /// Maximum number of slots per delivered batch
+    size_t batch_size = kDefaultBatchSize;
+
+    /// Late materialization: dotted paths of the columns `filter` looks at. Each row group
+    /// first decodes these columns in full and passes them to `filter`, in this order;
+    /// `filter` sets the bits of the rows to keep in `selection`, a cleared bitmap with one
+    /// bit per row of the row group. The scanned columns then only decode the selected
+    /// rows and every batch holds selected rows only. Pages without a selected row are
+    /// neither decompressed nor decoded when the file has an offset index.
+    std::vector<std::string> filter_columns;
+    std::function<void(const std::vector<ColumnBatch> &columns, Bitmap &selection)> filter;
+
+    /// Deliver dictionary encoded pages as dictionary encoded batches, with indices into
+    /// the chunk's dictionary instead of values (see ColumnChunkReader::keepDictionaryIndices())
+    bool dictionary_indices = false;
+
+    /// Deliver batches in (row group, column, sequence) order instead of as they complete
+    bool ordered = true;
+
+    /// Upper bound of the memory held by scheduled column chunks (raw bytes, decompressed
+    /// pages and decoded batches not yet returned by next()). A single chunk larger than
+    /// the bound is still read, but only when nothing else is in flight.
+    size_t max_in_flight_bytes = size_t{256} << 20;
+
+    /// How the chunk reads are merged; nearby chunks are read with one request
+    CoalesceOptions coalesce;
+
+    /// Pool to run on; when null the scanner starts its own pool of `threads` workers
+    ThreadPool *pool = nullptr;
+    size_t threads = 0;
+};
+
+struct ScanBatch
+{
+    size_t row_group = 0;
+
+    /// Index of the column in ParquetFileReader::columns()
+    size_t column = 0;
+
+    /// Position of the batch within its column chunk
+    size_t sequence = 0;
+
+    /// Whether this is the last batch of its column chunk
+    bool last = false;
+
+    std::shared_ptr<ColumnBatch> batch;
+};
+
+/**
+ * @brief Scans a Parquet file in parallel, one task chain per (row group, column chunk).
+ *
+ * Each chunk goes through three pipelined tasks on the pool: reading the chunk bytes,
+ * decompressing its pages and decoding them into batches of at most batch_size slots.
+ * Different chunks are in different stages at the same time, and chunks are only
+ * scheduled while their estimated footprint fits max_in_flight_bytes; the memory of a
+ * chunk is released once its last batch was returned by next().
+ *
+ * Chunk reads go through a RangePrefetcher: nearby chunks share one coalesced read, and
+ * a chunk's read is started when the chunk is scheduled, so files with an asynchronous
+ * backend (IoUringFile) have the bytes in flight before a worker picks up the chunk.
+ *
+ * With a filter (late materialization), the chunks of a row group wait for its selection,
+ * which the first of them to be read computes from the filter columns, fetched through
+ * the same prefetcher. The footprint of the filter columns is charged to the first chunk
+ * of the row group. Selected rows are decoded run by run, unselected runs are skipped
+ * without materializing them. Where that does not pay off, because the selected rows are
+ * scattered in short runs over every page of a chunk, the chunk is decoded in full and the
+ * selected rows are copied out. Scanned filter columns are not decoded again: their
+ * selected rows are copied out of the batch the filter saw (unless dictionary_indices is
+ * set, as the filter sees values).
+ *
+ * Every chunk yields at least one batch (empty for empty chunks), the last one flagged
+ * with `last`.
+ */
+class ParquetScanner
+{
+public:
+    /**
+     * @throws std::invalid_argument for unknown columns or a zero batch size
+     * @throws std::out_of_range for invalid row groups
+     */
+    ParquetScanner(std::shared_ptr<const ParquetFileReader> file, ScanOptions options = {});
+
+    /**
+     * @brief Cancels the scan and waits for the running tasks.
+     */
+    ~ParquetScanner();
+
+    ParquetScanner(const ParquetScanner &) = delete;
+    ParquetScanner &operator=(const ParquetScanner &) = delete;
+
+    /**
+     * @brief Waits for the next batch.
+     * @return false once all batches were returned
+     * @throws The first error raised by a scan task (e.g. ParquetException)
+     */
+    bool next(ScanBatch &out);
+
+    /**
+     * @brief The largest in-flight footprint seen so far.
+     */
+    size_t peakInFlightBytes() const;
+
+private:
+    /**
+     * @brief The selection of a row group, computed by the first of its chunks that needs
+     * it. The filter chunks' reads are ranges first_range, first_range + 1, ... of the
+     * prefetcher.
+     */
+    struct Selection
+    {
+        size_t row_group;
+        size_t first_range;
+        bool prefetched = false;
+
+        std::mutex mutex;
+        bool done = false;
+        Bitmap bitmap;
+        std::optional<RankSelect> ranks;
+        /// The selected rows are scattered in short runs, see decodeSelected()
+        bool scattered = false;
+
+        /// The decoded filter columns, and for each the number of scanned chunks yet to
+        /// take their rows from it; a column is released once that drops to zero
+        std::vector<ColumnBatch> columns;
+        std::vector<size_t> column_users;
+    };
+
+    struct Chunk
+    {
+        size_t row_group;
+        size_t column;
+        size_t footprint;
+        Selection *selection;
+        /// Index of the prefetcher range holding the chunk
+        size_t range;
+        /// Position of the column among the filter columns when its rows are copied from
+        /// the selection's decoded column instead of being read
+        std::optional<size_t> filter_column;
+        std::deque<ScanBatch> batches;
+    };
+
+    struct Ready
+    {
+        size_t chunk;
+        ScanBatch batch;
+    };
+
+    void schedule();
+    void submit(std::function<void()> work);
+    void submitLocked(std::function<void()> work);
+    void read(size_t chunk);
+    void decode(size_t chunk, const std::shared_ptr<ColumnChunkReader> &reader);
+    void decodeSelected(size_t chunk, ColumnChunkReader *reader, const ColumnBatch *decoded);
+    Selection &select(Selection &selection);
+    void releaseFilterColumn(Selection &selection, size_t filter_column);
+    bool deliver(size_t chunk, ScanBatch batch);
+
+    std::shared_ptr<const ParquetFileReader> file_;
+    ScanOptions options_;
+    std::unique_ptr<ThreadPool> owned_pool_;
+    ThreadPool *pool_;
+    std::vector<size_t> filter_columns_;
+    std::vector<std::unique_ptr<Selection>> selections_;
+    std::vector<Chunk> chunks_;
+    std::unique_ptr<RangePrefetcher> prefetcher_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable ready_cv_;
+    std::condition_variable idle_cv_;
+    std::deque<Ready> ready_;
+    size_t next_to_schedule_ = 0;
+    size_t next_to_deliver_ = 0;
+    size_t finished_ = 0;
+    size_t in_flight_bytes_ = 0;
+    size_t peak_in_flight_bytes_ = 0;
+    size_t active_tasks_ = 0;
+    bool cancelled_ = false;
+    std::exception_ptr error_;
+};
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+#include "parquet_writer.hpp"
+#include "scanner.hpp"
+
+// Scan throughput of ParquetScanner from 1 to N threads. The file is written once per
+// process: 16 row groups of 8 columns (INT64, DOUBLE, optional BYTE_ARRAY) with Snappy
+// compression, so every thread count scans the same ~100MB of decoded data.
+
+namespace
+{
+    constexpr size_t kRowGroups = 16;
+    constexpr size_t kRowsPerGroup = 256 * 1024;
+    constexpr size_t kColumns = 8;
+
+    std::shared_ptr<const ParquetFileReader> benchmarkFile()
+    {
+        static std::shared_ptr<const ParquetFileReader> file = []()
+        {
+            std::string path = std::string("/tmp/scanner_benchmark_") + std::to_string(::getpid()) + ".parquet";
+            std::vector<ColumnDescriptor> columns(kColumns);
+            for (size_t c = 0; c < kColumns; ++c)
+            {
+                columns[c].path = {std::string("c") + std::to_string(c)};
+                columns[c].type = c % 3 == 0 ? AtomicType::INT64 : c % 3 == 1 ? AtomicType::DOUBLE
+                                                                              : AtomicType::BYTE_ARRAY;
+                columns[c].max_definition_level = columns[c].type == AtomicType::BYTE_ARRAY ? 1 : 0;
+            }
+            WriterOptions options;
+            options.codec = CompressionCodec::SNAPPY;
+            ParquetFileWriter writer(path, columns, options);
+
+            std::mt19937_64 rng(42);
+            for (size_t g = 0; g < kRowGroups; ++g)
+            {
+                std::vector<ColumnBatch> batches;
+                std::vector<const ColumnBatch *> pointers;
+                for (const auto &column : columns)
+                {
+                    ColumnBatch batch(column.type);
+                    for (size_t i = 0; i < kRowsPerGroup; ++i)
+                    {
+                        switch (column.type)
+                        {
+                        case AtomicType::INT64:
+                            // Small deltas, compresses like a typical id or timestamp column
+                            *batch.appendValues<int64_t>(1) = static_cast<int64_t>(g * kRowsPerGroup + i);
+                            break;
+                        case AtomicType::DOUBLE:
+                            *batch.appendValues<double>(1) = static_cast<double>(rng() % 10000) / 100;
+                            break;
+                        default:
+                            if (rng() % 10 == 0)
+                            {
+                                batch.appendNulls(1);
+                            }
+                            else
+                            {
+                                std::string value = "value-";
+                                value += std::to_string(rng() % 1000);
+                                batch.appendByteArray(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+                            }
+                        }
+                    }
+                    batches.push_back(std::move(batch));
+                }
+                for (const auto &batch : batches)
+                {
+                    pointers.push_back(&batch);
+                }
+                writer.writeRowGroup(pointers);
+            }
+            writer.close();
+            auto reader = std::make_shared<ParquetFileReader>(path);
+            std::remove(path.c_str());
+            return reader;
+        }();
+        return file;
+    }
+} // namespace
+
+static void BM_Scan(benchmark::State &state)
+{
+    auto file = benchmarkFile();
+    ThreadPool pool(static_cast<size_t>(state.range(0)));
+    ScanOptions options;
+    options.pool = &pool;
+    options.ordered = state.range(1) != 0;
+
+    int64_t bytes = 0;
+    for (auto _ : state)
+    {
+        ParquetScanner scanner(file, options);
+        ScanBatch batch;
+        while (scanner.next(batch))
+        {
+            benchmark::DoNotOptimize(batch.batch->length());
+        }
+    }
+    for (const auto &row_group : file->metadata().row_groups)
+    {
+        bytes += row_group.total_byte_size;
+    }
+    state.SetBytesProcessed(bytes * state.iterations());
+    state.SetItemsProcessed(static_cast<int64_t>(kRowGroups * kRowsPerGroup * kColumns) * state.iterations());
+}
+BENCHMARK(BM_Scan)
+    ->ArgNames({"threads", "ordered"})
+    ->ArgsProduct({benchmark::CreateRange(1, 64, 2), {0, 1}})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,369 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "io_uring_file.hpp"
+#include "parquet_writer.hpp"
+#include "scanner.hpp"
+
+namespace
+{
+    const size_t kRowGroups = 4;
+    const size_t kRowsPerGroup = 10000;
+
+    // Two optional INT64 columns; column c of row r holds r * (c + 1), every 7th value is null
+    std::string writePath(const std::string &name)
+    {
+        std::string path = testing::TempDir() + "/" + name;
+        std::vector<ColumnDescriptor> columns(2);
+        for (size_t c = 0; c < columns.size(); ++c)
+        {
+            columns[c].path = {"c" + std::to_string(c)};
+            columns[c].type = AtomicType::INT64;
+            columns[c].max_definition_level = 1;
+        }
+        WriterOptions options;
+        options.codec = CompressionCodec::SNAPPY;
+        options.page_size = 16 * 1024;
+        ParquetFileWriter writer(path, columns, options);
+        for (size_t g = 0; g < kRowGroups; ++g)
+        {
+            std::vector<ColumnBatch> batches;
+            for (size_t c = 0; c < columns.size(); ++c)
+            {
+                ColumnBatch batch(AtomicType::INT64);
+                for (size_t i = 0; i < kRowsPerGroup; ++i)
+                {
+                    size_t row = g * kRowsPerGroup + i;
+                    if (row % 7 == 0)
+                    {
+                        batch.appendNulls(1);
+                    }
+                    else
+                    {
+                        *batch.appendValues<int64_t>(1) = static_cast<int64_t>(row * (c + 1));
+                    }
+                }
+                batches.push_back(std::move(batch));
+            }
+            writer.writeRowGroup({&batches[0], &batches[1]});
+        }
+        writer.close();
+        return path;
+    }
+
+    std::shared_ptr<const ParquetFileReader> writeFile(const std::string &name)
+    {
+        std::string path = writePath(name);
+        auto reader = std::make_shared<ParquetFileReader>(path);
+        std::remove(path.c_str());
+        return reader;
+    }
+
+    // Checks the values of a batch and returns its number of slots
+    size_t checkBatch(const ScanBatch &batch, size_t first_row)
+    {
+        for (size_t i = 0; i < batch.batch->length(); ++i)
+        {
+            size_t row = first_row + i;
+            EXPECT_EQ(batch.batch->isValid(i), row % 7 != 0);
+            if (row % 7 != 0)
+            {
+                EXPECT_EQ(batch.batch->value<int64_t>(i), static_cast<int64_t>(row * (batch.column + 1)));
+            }
+        }
+        return batch.batch->length();
+    }
+} // namespace
+
+TEST(ThreadPoolTest, RunsAllTasksIncludingNestedOnes)
+{
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool(4);
+        for (int i = 0; i < 100; ++i)
+        {
+            pool.submit([&pool, &count]()
+                        {
+                            ++count;
+                            pool.submit([&count]()
+                                        { ++count; }); });
+        }
+    }
+    EXPECT_EQ(count.load(), 200);
+}
+
+TEST(ParquetScannerTest, OrderedDeliveryFollowsTheFile)
+{
+    auto file = writeFile("scan_ordered.parquet");
+    ScanOptions options;
+    options.threads = 4;
+    options.batch_size = 3000;
+    ParquetScanner scanner(file, options);
+
+    std::vector<std::pair<size_t, size_t>> chunks;
+    size_t row = 0;
+    size_t expected_sequence = 0;
+    ScanBatch batch;
+    while (scanner.next(batch))
+    {
+        if (chunks.empty() || chunks.back() != std::make_pair(batch.row_group, batch.column))
+        {
+            chunks.emplace_back(batch.row_group, batch.column);
+            row = batch.row_group * kRowsPerGroup;
+            expected_sequence = 0;
+        }
+        EXPECT_EQ(batch.sequence, expected_sequence++);
+        row += checkBatch(batch, row);
+        if (batch.last)
+        {
+            EXPECT_EQ(row, (batch.row_group + 1) * kRowsPerGroup);
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> expected;
+    for (size_t g = 0; g < kRowGroups; ++g)
+    {
+        expected.emplace_back(g, 0);
+        expected.emplace_back(g, 1);
+    }
+    EXPECT_EQ(chunks, expected);
+}
+
+TEST(ParquetScannerTest, UnorderedDeliveryReturnsEveryBatch)
+{
+    auto file = writeFile("scan_unordered.parquet");
+    ThreadPool pool(3);
+    ScanOptions options;
+    options.pool = &pool;
+    options.ordered = false;
+    options.columns = {"c1"};
+    options.row_groups = {1, 3};
+    ParquetScanner scanner(file, options);
+
+    // Batches of one chunk still arrive in sequence order
+    std::map<size_t, size_t> next_row;
+    std::set<size_t> finished;
+    ScanBatch batch;
+    while (scanner.next(batch))
+    {
+        EXPECT_EQ(batch.column, 1u);
+        auto it = next_row.emplace(batch.row_group, batch.row_group * kRowsPerGroup).first;
+        it->second += checkBatch(batch, it->second);
+        if (batch.last)
+        {
+            finished.insert(batch.row_group);
+        }
+    }
+    EXPECT_EQ(finished, (std::set<size_t>{1, 3}));
+    EXPECT_EQ(next_row[3], 4 * kRowsPerGroup);
+}
+
+TEST(ParquetScannerTest, InFlightMemoryStaysBounded)
+{
+    auto file = writeFile("scan_bounded.parquet");
+    size_t largest_chunk = 0;
+    for (size_t g = 0; g < kRowGroups; ++g)
+    {
+        for (size_t c = 0; c < 2; ++c)
+        {
+            const ColumnMetaData &metadata = file->columnMetaData(g, c);
+            largest_chunk = std::max<size_t>(largest_chunk, static_cast<size_t>(metadata.total_compressed_size +
+                                                                                2 * metadata.total_uncompressed_size));
+        }
+    }
+
+    ScanOptions options;
+    options.threads = 4;
+    options.max_in_flight_bytes = largest_chunk * 2;
+    ParquetScanner scanner(file, options);
+    size_t batches = 0;
+    ScanBatch batch;
+    while (scanner.next(batch))
+    {
+        ++batches;
+    }
+    EXPECT_GT(batches, 0u);
+    EXPECT_LE(scanner.peakInFlightBytes(), options.max_in_flight_bytes);
+
+    // A budget below a single chunk still makes progress, one chunk at a time
+    options.max_in_flight_bytes = 1;
+    ParquetScanner tiny(file, options);
+    size_t rows = 0;
+    while (tiny.next(batch))
+    {
+        rows += batch.batch->length();
+    }
+    EXPECT_EQ(rows, 2 * kRowGroups * kRowsPerGroup);
+    EXPECT_LE(tiny.peakInFlightBytes(), largest_chunk);
+}
+
+TEST(ParquetScannerTest, RejectsInvalidOptions)
+{
+    auto file = writeFile("scan_invalid.parquet");
+    ScanOptions options;
+    options.threads = 1;
+    options.columns = {"missing"};
+    EXPECT_THROW(ParquetScanner(file, options), std::invalid_argument);
+    options.columns.clear();
+    options.row_groups = {kRowGroups};
+    EXPECT_THROW(ParquetScanner(file, options), std::out_of_range);
+    options.row_groups.clear();
+    options.filter_columns = {"c0"};
+    EXPECT_THROW(ParquetScanner(file, options), std::invalid_argument);
+}
+
+TEST(ParquetScannerTest, FilterDecodesSelectedRowsOnly)
+{
+    auto file = writeFile("scan_filter.parquet");
+    ScanOptions options;
+    options.threads = 4;
+    options.batch_size = 50;
+    options.filter_columns = {"c0"};
+    options.filter = [](const std::vector<ColumnBatch> &columns, Bitmap &selection)
+    {
+        const ColumnBatch &c0 = columns[0];
+        ASSERT_EQ(c0.length(), kRowsPerGroup);
+        for (size_t i = 0; i < c0.length(); ++i)
+        {
+            if (c0.isValid(i) && c0.value<int64_t>(i) % 100 < 3)
+            {
+                selection.set(i);
+            }
+        }
+    };
+    std::vector<size_t> expected_rows;
+    for (size_t row = 0; row < kRowGroups * kRowsPerGroup; ++row)
+    {
+        if (row % 7 != 0 && row % 100 < 3)
+        {
+            expected_rows.push_back(row);
+        }
+    }
+
+    ParquetScanner scanner(file, options);
+    std::map<size_t, std::vector<int64_t>> values;
+    ScanBatch batch;
+    while (scanner.next(batch))
+    {
+        EXPECT_LE(batch.batch->length(), options.batch_size);
+        EXPECT_EQ(batch.batch->nullCount(), 0u);
+        for (size_t i = 0; i < batch.batch->length(); ++i)
+        {
+            values[batch.column].push_back(batch.batch->value<int64_t>(i));
+        }
+    }
+    for (size_t c = 0; c < 2; ++c)
+    {
+        ASSERT_EQ(values[c].size(), expected_rows.size());
+        for (size_t i = 0; i < expected_rows.size(); ++i)
+        {
+            EXPECT_EQ(values[c][i], static_cast<int64_t>(expected_rows[i] * (c + 1)));
+        }
+    }
+
+    // Nothing selected: one empty batch per chunk
+    options.columns = {"c1"};
+    options.filter = [](const std::vector<ColumnBatch> &, Bitmap &) {};
+    ParquetScanner empty(file, options);
+    size_t batches = 0;
+    while (empty.next(batch))
+    {
+        EXPECT_TRUE(batch.batch->empty());
+        EXPECT_TRUE(batch.last);
+        ++batches;
+    }
+    EXPECT_EQ(batches, kRowGroups);
+}
+
+TEST(ParquetScannerTest, FilterWithScatteredRows)
+{
+    // Two of every three rows, nulls included: every page is decoded in full and the
+    // selected rows are copied out; the scanned filter column is not decoded again unless
+    // its batches keep dictionary indices
+    auto file = writeFile("scan_scattered.parquet");
+    for (bool dictionary_indices : {false, true})
+    {
+        ScanOptions options;
+        options.threads = 2;
+        options.batch_size = 1000;
+        options.dictionary_indices = dictionary_indices;
+        options.filter_columns = {"c0"};
+        options.filter = [](const std::vector<ColumnBatch> &columns, Bitmap &selection)
+        {
+            for (size_t i = 0; i < columns[0].length(); ++i)
+            {
+                selection.setTo(i, i % 3 != 1);
+            }
+        };
+        ParquetScanner scanner(file, options);
+        std::map<size_t, std::vector<std::pair<bool, int64_t>>> values;
+        ScanBatch batch;
+        while (scanner.next(batch))
+        {
+            EXPECT_LE(batch.batch->length(), options.batch_size);
+            batch.batch->materialize();
+            for (size_t i = 0; i < batch.batch->length(); ++i)
+            {
+                bool valid = batch.batch->isValid(i);
+                values[batch.column].emplace_back(valid, valid ? batch.batch->value<int64_t>(i) : 0);
+            }
+        }
+        for (size_t c = 0; c < 2; ++c)
+        {
+            size_t i = 0;
+            for (size_t row = 0; row < kRowGroups * kRowsPerGroup; ++row)
+            {
+                if (row % kRowsPerGroup % 3 == 1)
+                {
+                    continue;
+                }
+                ASSERT_LT(i, values[c].size());
+                EXPECT_EQ(values[c][i].first, row % 7 != 0) << c << " " << row;
+                EXPECT_EQ(values[c][i].second, row % 7 != 0 ? static_cast<int64_t>(row * (c + 1)) : 0);
+                ++i;
+            }
+            EXPECT_EQ(i, values[c].size());
+        }
+    }
+}
+
+TEST(ParquetScannerTest, DestructorCancelsPendingWork)
+{
+    auto file = writeFile("scan_cancel.parquet");
+    ScanOptions options;
+    options.threads = 2;
+    ParquetScanner scanner(file, options);
+    ScanBatch batch;
+    ASSERT_TRUE(scanner.next(batch));
+}
+
+TEST(ParquetScannerTest, ReadsThroughIoUring)
+{
+    if (!IoUringFile::isSupported())
+    {
+        GTEST_SKIP() << "io_uring is not available";
+    }
+    std::string path = writePath("scan_uring.parquet");
+    auto file = std::make_shared<ParquetFileReader>(std::make_shared<IoUringFile>(path));
+    std::remove(path.c_str());
+
+    ScanOptions options;
+    options.threads = 2;
+    // Every chunk on its own read
+    options.coalesce.hole_size_limit = 0;
+    options.coalesce.range_size_limit = 1;
+    ParquetScanner scanner(file, options);
+    ScanBatch batch;
+    std::map<size_t, size_t> next_row;
+    while (scanner.next(batch))
+    {
+        size_t &row = next_row[batch.column];
+        row += checkBatch(batch, row);
+    }
+    EXPECT_EQ(next_row[0], kRowGroups * kRowsPerGroup);
+    EXPECT_EQ(next_row[1], kRowGroups * kRowsPerGroup);
+}
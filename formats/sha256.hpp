@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+/**
+ * @brief Incremental SHA-256 (FIPS 180-4).
+ */
+class Sha256
+{
+public:
+    Sha256();
+
+    void update(const uint8_t *data, size_t size);
+    void update(const std::string &data) { update(reinterpret_cast<const uint8_t *>(data.data()), data.size()); }
+
+    /**
+     * @brief Pads the message and returns the digest; the object must not be used
+     * afterwards.
+     */
+    Sha256Digest finish();
+
+private:
+    void compress(const uint8_t *block);
+
+    std::array<uint32_t, 8> state_;
+    std::array<uint8_t, 64> buffer_;
+    size_t buffered_ = 0;
+    uint64_t length_ = 0;
+};
+
+Sha256Digest sha256(const std::string &data);
+
+/**
+ * @brief HMAC-SHA256 (RFC 2104).
+ */
+Sha256Digest hmacSha256(const uint8_t *key, size_t key_size, const std::string &data);
+Sha256Digest hmacSha256(const std::string &key, const std::string &data);
+
+/**
+ * @brief Lowercase hexadecimal representation of the digest.
+ */
+std::string toHex(const Sha256Digest &digest);
@@ -0,0 +1,118 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // The pool and worker index of the current thread, used to queue follow-up tasks locally
+    thread_local const ThreadPool *current_pool = nullptr;
+    thread_local size_t current_worker = 0;
+} // namespace
+
+ThreadPool::ThreadPool(size_t threads)
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threads; ++i)
+    {
+        threads_.emplace_back([this, i]()
+                              { run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task)
+{
+    size_t index = current_pool == this ? current_worker
+                                        : next_worker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        pending_.fetch_add(1, std::memory_order_relaxed);
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::popLocal(size_t index, std::function<void()> &task)
+{
+    Worker &worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, std::function<void()> &task)
+{
+    for (size_t i = 1; i < workers_.size(); ++i)
+    {
+        Worker &victim = *workers_[(index + i) % workers_.size()];
+        std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || victim.tasks.empty())
+        {
+            continue;
+        }
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t index)
+{
+    current_pool = this;
+    current_worker = index;
+    std::function<void()> task;
+    while (true)
+    {
+        if (popLocal(index, task) || steal(index, task))
+        {
+            pending_.fetch_sub(1, std::memory_order_relaxed);
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        if (pending_.load(std::memory_order_relaxed) > 0)
+        {
+            // A task is queued, or about to be, but another worker holds its deque or is
+            // about to take it; retry instead of sleeping
+            lock.unlock();
+            std::this_thread::yield();
+            continue;
+        }
+        if (stop_)
+        {
+            return;
+        }
+        wake_.wait(lock, [this]()
+                   { return stop_ || pending_.load(std::memory_order_relaxed) > 0; });
+    }
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed size work-stealing thread pool.
+ *
+ * Every worker owns a deque. Tasks submitted from a worker go to the back of its own
+ * deque and the worker pops from the back, so follow-up work (e.g. decoding the chunk a
+ * task just read) runs next on the same core while the data is still in cache. Tasks
+ * submitted from other threads are spread round robin. An idle worker steals from the
+ * front of the other deques, i.e. the oldest and usually largest pending work.
+ *
+ * Tasks must not throw; wrap the work and hand errors back to the submitter instead.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param threads Number of workers, 0 means one per hardware thread
+     */
+    explicit ThreadPool(size_t threads = 0);
+
+    /**
+     * @brief Runs the tasks that are still queued, then joins the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    size_t size() const noexcept { return workers_.size(); }
+
+    void submit(std::function<void()> task);
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void run(size_t index);
+    bool popLocal(size_t index, std::function<void()> &task);
+    bool steal(size_t index, std::function<void()> &task);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_worker_{0};
+
+    // Sleeping workers wait for `pending_` to become non-zero. It is incremented under
+    // `sleep_mutex_` before a task is queued, so a worker cannot miss a wake-up, and
+    // decremented after one was taken, so it never drops below the number of queued tasks
+    // (and never wraps around when a worker takes a task the moment it is queued).
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0};
+    bool stop_ = false;
+};
+
+/**
+ * @brief Runs work(0) ... work(count - 1) on the pool and returns the results in order;
+ * the first error is rethrown once all work finished. Must not be called from a task of
+ * the same pool, whose workers could all end up waiting.
+ */
+template <typename T, typename F>
+std::vector<T> parallelMap(ThreadPool &pool, size_t count, const F &work)
+{
+    std::vector<std::future<T>> futures;
+    futures.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto promise = std::make_shared<std::promise<T>>();
+        futures.push_back(promise->get_future());
+        pool.submit(
+            [&work, i, promise]()
+            {
+                try
+                {
+                    promise->set_value(work(i));
+                }
+                catch (...)
+                {
+                    promise->set_exception(std::current_exception());
+                }
+            });
+    }
+    for (std::future<T> &future : futures)
+    {
+        future.wait();
+    }
+    std::vector<T> results;
+    results.reserve(count);
+    for (std::future<T> &future : futures)
+    {
+        results.push_back(future.get());
+    }
+    return results;
+}
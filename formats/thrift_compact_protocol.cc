@@ -1,6 +1,327 @@
 
 #include "thrift_compact_protocol.hpp"
 
+#include <cstring>
+
 namespace thrift
 {
-} // namespace thrift
\ No newline at end of file
+    namespace
+    {
+        // Nesting limit for skip(), protects against stack exhaustion on hostile input
+        constexpr int kMaxSkipDepth = 64;
+
+        uint64_t zigzagEncode(int64_t value)
+        {
+            return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+        }
+
+        int64_t zigzagDecode(uint64_t value)
+        {
+            return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+        }
+    } // namespace
+
+    CompactProtocolReader::CompactProtocolReader(const uint8_t *data, size_t size)
+        : begin_(data), data_(data), end_(data + size) {}
+
+    void CompactProtocolReader::readStructBegin()
+    {
+        field_id_stack_.push_back(last_field_id_);
+        last_field_id_ = 0;
+    }
+
+    void CompactProtocolReader::readStructEnd()
+    {
+        if (field_id_stack_.empty())
+        {
+            throw ProtocolException("readStructEnd() without readStructBegin()");
+        }
+        last_field_id_ = field_id_stack_.back();
+        field_id_stack_.pop_back();
+    }
+
+    bool CompactProtocolReader::readFieldBegin(int16_t &id, CompactType &type)
+    {
+        uint8_t header = readRawByte();
+        if (header == 0)
+        {
+            type = CompactType::STOP;
+            return false;
+        }
+        type = static_cast<CompactType>(header & 0x0f);
+        int16_t delta = header >> 4;
+        id = delta != 0 ? static_cast<int16_t>(last_field_id_ + delta) : readI16();
+        last_field_id_ = id;
+        return true;
+    }
+
+    std::pair<CompactType, size_t> CompactProtocolReader::readListBegin()
+    {
+        uint8_t header = readRawByte();
+        size_t size = header >> 4;
+        if (size == 15)
+        {
+            size = readVarint();
+        }
+        // Every element takes at least one byte, anything larger is corrupt
+        if (size > static_cast<size_t>(end_ - data_))
+        {
+            throw ProtocolException("List size exceeds the remaining input");
+        }
+        return {static_cast<CompactType>(header & 0x0f), size};
+    }
+
+    bool CompactProtocolReader::readBoolElement()
+    {
+        return readRawByte() == static_cast<uint8_t>(CompactType::BOOLEAN_TRUE);
+    }
+
+    int8_t CompactProtocolReader::readByte()
+    {
+        return static_cast<int8_t>(readRawByte());
+    }
+
+    int16_t CompactProtocolReader::readI16()
+    {
+        return static_cast<int16_t>(zigzagDecode(readVarint()));
+    }
+
+    int32_t CompactProtocolReader::readI32()
+    {
+        return static_cast<int32_t>(zigzagDecode(readVarint()));
+    }
+
+    int64_t CompactProtocolReader::readI64()
+    {
+        return zigzagDecode(readVarint());
+    }
+
+    double CompactProtocolReader::readDouble()
+    {
+        if (end_ - data_ < 8)
+        {
+            throw ProtocolException("Truncated double");
+        }
+        double value;
+        std::memcpy(&value, data_, sizeof(value));
+        data_ += 8;
+        return value;
+    }
+
+    std::string CompactProtocolReader::readBinary()
+    {
+        uint64_t size = readVarint();
+        if (size > static_cast<uint64_t>(end_ - data_))
+        {
+            throw ProtocolException("Truncated binary");
+        }
+        std::string value(reinterpret_cast<const char *>(data_), size);
+        data_ += size;
+        return value;
+    }
+
+    void CompactProtocolReader::skip(CompactType type, int depth)
+    {
+        if (depth > kMaxSkipDepth)
+        {
+            throw ProtocolException("Nesting too deep");
+        }
+        switch (type)
+        {
+        case CompactType::BOOLEAN_TRUE:
+        case CompactType::BOOLEAN_FALSE:
+            // Boolean fields carry their value in the field header
+            break;
+        case CompactType::BYTE:
+            readRawByte();
+            break;
+        case CompactType::I16:
+        case CompactType::I32:
+        case CompactType::I64:
+            readVarint();
+            break;
+        case CompactType::DOUBLE:
+            readDouble();
+            break;
+        case CompactType::BINARY:
+        {
+            uint64_t size = readVarint();
+            if (size > static_cast<uint64_t>(end_ - data_))
+            {
+                throw ProtocolException("Truncated binary");
+            }
+            data_ += size;
+            break;
+        }
+        case CompactType::LIST:
+        case CompactType::SET:
+        {
+            auto [element_type, size] = readListBegin();
+            for (size_t i = 0; i < size; ++i)
+            {
+                if (element_type == CompactType::BOOLEAN_TRUE || element_type == CompactType::BOOLEAN_FALSE)
+                {
+                    readRawByte();
+                }
+                else
+                {
+                    skip(element_type, depth + 1);
+                }
+            }
+            break;
+        }
+        case CompactType::MAP:
+        {
+            uint64_t size = readVarint();
+            if (size == 0)
+            {
+                break;
+            }
+            uint8_t types = readRawByte();
+            for (uint64_t i = 0; i < size; ++i)
+            {
+                skip(static_cast<CompactType>(types >> 4), depth + 1);
+                skip(static_cast<CompactType>(types & 0x0f), depth + 1);
+            }
+            break;
+        }
+        case CompactType::STRUCT:
+        {
+            readStructBegin();
+            int16_t id;
+            CompactType field_type;
+            while (readFieldBegin(id, field_type))
+            {
+                skip(field_type, depth + 1);
+            }
+            readStructEnd();
+            break;
+        }
+        default:
+            throw ProtocolException("Unknown compact type " + std::to_string(static_cast<int>(type)));
+        }
+    }
+
+    uint64_t CompactProtocolReader::readVarint()
+    {
+        uint64_t result = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t byte = readRawByte();
+            result |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+            {
+                return result;
+            }
+        }
+        throw ProtocolException("Varint is too long");
+    }
+
+    uint8_t CompactProtocolReader::readRawByte()
+    {
+        if (data_ >= end_)
+        {
+            throw ProtocolException("Unexpected end of input");
+        }
+        return *data_++;
+    }
+
+    void CompactProtocolWriter::writeStructBegin()
+    {
+        field_id_stack_.push_back(last_field_id_);
+        last_field_id_ = 0;
+    }
+
+    void CompactProtocolWriter::writeStructEnd()
+    {
+        buffer_.push_back(static_cast<uint8_t>(CompactType::STOP));
+        last_field_id_ = field_id_stack_.back();
+        field_id_stack_.pop_back();
+    }
+
+    void CompactProtocolWriter::writeFieldBegin(int16_t id, CompactType type)
+    {
+        int delta = id - last_field_id_;
+        if (delta > 0 && delta <= 15)
+        {
+            buffer_.push_back(static_cast<uint8_t>(delta << 4 | static_cast<uint8_t>(type)));
+        }
+        else
+        {
+            buffer_.push_back(static_cast<uint8_t>(type));
+            writeI16(id);
+        }
+        last_field_id_ = id;
+    }
+
+    void CompactProtocolWriter::writeBoolField(int16_t id, bool value)
+    {
+        writeFieldBegin(id, value ? CompactType::BOOLEAN_TRUE : CompactType::BOOLEAN_FALSE);
+    }
+
+    void CompactProtocolWriter::writeListBegin(CompactType element_type, size_t size)
+    {
+        if (size < 15)
+        {
+            buffer_.push_back(static_cast<uint8_t>(size << 4 | static_cast<uint8_t>(element_type)));
+        }
+        else
+        {
+            buffer_.push_back(static_cast<uint8_t>(0xf0 | static_cast<uint8_t>(element_type)));
+            writeVarint(size);
+        }
+    }
+
+    void CompactProtocolWriter::writeBoolElement(bool value)
+    {
+        buffer_.push_back(static_cast<uint8_t>(value ? CompactType::BOOLEAN_TRUE : CompactType::BOOLEAN_FALSE));
+    }
+
+    void CompactProtocolWriter::writeByte(int8_t value)
+    {
+        buffer_.push_back(static_cast<uint8_t>(value));
+    }
+
+    void CompactProtocolWriter::writeI16(int16_t value)
+    {
+        writeVarint(zigzagEncode(value));
+    }
+
+    void CompactProtocolWriter::writeI32(int32_t value)
+    {
+        writeVarint(zigzagEncode(value));
+    }
+
+    void CompactProtocolWriter::writeI64(int64_t value)
+    {
+        writeVarint(zigzagEncode(value));
+    }
+
+    void CompactProtocolWriter::writeDouble(double value)
+    {
+        uint8_t bytes[8];
+        std::memcpy(bytes, &value, sizeof(value));
+        buffer_.insert(buffer_.end(), bytes, bytes + 8);
+    }
+
+    void CompactProtocolWriter::writeBinary(const std::string &value)
+    {
+        writeBinary(reinterpret_cast<const uint8_t *>(value.data()), value.size());
+    }
+
+    void CompactProtocolWriter::writeBinary(const uint8_t *data, size_t size)
+    {
+        writeVarint(size);
+        buffer_.insert(buffer_.end(), data, data + size);
+    }
+
+    void CompactProtocolWriter::writeVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer_.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer_.push_back(static_cast<uint8_t>(value));
+    }
+} // namespace thrift
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 // Documentation:
 // https://github.com/apache/thrift/blob/master/doc/specs/thrift-compact-protocol.md
 
@@ -8,7 +15,131 @@
 
 namespace thrift
 {
-    class CompactProtocol
+    /**
+     * Type ids as they appear in compact protocol field and collection headers.
+     */
+    enum class CompactType : uint8_t
+    {
+        STOP = 0,
+        BOOLEAN_TRUE = 1,
+        BOOLEAN_FALSE = 2,
+        BYTE = 3,
+        I16 = 4,
+        I32 = 5,
+        I64 = 6,
+        DOUBLE = 7,
+        BINARY = 8,
+        LIST = 9,
+        SET = 10,
+        MAP = 11,
+        STRUCT = 12
+    };
+
+    /**
+     * Thrown when the input is not valid compact protocol data.
+     */
+    class ProtocolException : public std::runtime_error
+    {
+    public:
+        explicit ProtocolException(const std::string &message)
+            : std::runtime_error(message) {}
+    };
+
+    /**
+     * @brief Reads compact protocol values from an in-memory buffer.
+     *
+     * Generated Thrift code is not available here, so callers drive the reader by hand:
+     * readStructBegin(), then readFieldBegin() until it returns false, dispatching on the
+     * field id and skipping unknown fields, then readStructEnd().
+     */
+    class CompactProtocolReader
+    {
+    public:
+        CompactProtocolReader(const uint8_t *data, size_t size);
+
+        void readStructBegin();
+        void readStructEnd();
+
+        /**
+         * @brief Reads the next field header.
+         * @return false when the end of the struct was reached
+         */
+        bool readFieldBegin(int16_t &id, CompactType &type);
+
+        /**
+         * @brief Reads a list (or set) header and returns the element type and count.
+         */
+        std::pair<CompactType, size_t> readListBegin();
+
+        /**
+         * @brief Reads a boolean field; the value is stored in the field type itself.
+         */
+        static bool readBool(CompactType field_type) { return field_type == CompactType::BOOLEAN_TRUE; }
+
+        /**
+         * @brief Reads a boolean list element, stored as a full byte.
+         */
+        bool readBoolElement();
+
+        int8_t readByte();
+        int16_t readI16();
+        int32_t readI32();
+        int64_t readI64();
+        double readDouble();
+        std::string readBinary();
+
+        /**
+         * @brief Skips a value of the given type, including nested structs and collections.
+         */
+        void skip(CompactType type, int depth = 0);
+
+        /**
+         * @brief Number of bytes consumed so far.
+         */
+        size_t position() const noexcept { return static_cast<size_t>(data_ - begin_); }
+
+    private:
+        uint64_t readVarint();
+        uint8_t readRawByte();
+
+        const uint8_t *begin_;
+        const uint8_t *data_;
+        const uint8_t *end_;
+        int16_t last_field_id_ = 0;
+        std::vector<int16_t> field_id_stack_;
+    };
+
+    /**
+     * @brief Writes compact protocol values into a growing byte buffer.
+     */
+    class CompactProtocolWriter
     {
+    public:
+        void writeStructBegin();
+        void writeStructEnd();
+
+        void writeFieldBegin(int16_t id, CompactType type);
+        void writeBoolField(int16_t id, bool value);
+
+        void writeListBegin(CompactType element_type, size_t size);
+        void writeBoolElement(bool value);
+
+        void writeByte(int8_t value);
+        void writeI16(int16_t value);
+        void writeI32(int32_t value);
+        void writeI64(int64_t value);
+        void writeDouble(double value);
+        void writeBinary(const std::string &value);
+        void writeBinary(const uint8_t *data, size_t size);
+
+        const std::vector<uint8_t> &buffer() const noexcept { return buffer_; }
+        std::vector<uint8_t> release() noexcept { return std::move(buffer_); }
+
+    private:
+        void writeVarint(uint64_t value);
+
+        std::vector<uint8_t> buffer_;
+        int16_t last_field_id_ = 0;
+        std::vector<int16_t> field_id_stack_;
     };
-} // namespace thrift
\ No newline at end of file
+} // namespace thrift
@@ -2,3 +2,185 @@
 
 #include <gtest/gtest.h>
 
+
+#include "parquet_metadata.hpp"
+
+using thrift::CompactProtocolReader;
+using thrift::CompactProtocolWriter;
+using thrift::CompactType;
+
+TEST(CompactProtocolTest, ScalarsRoundTrip)
+{
+    CompactProtocolWriter writer;
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::I32);
+    writer.writeI32(-123456);
+    writer.writeFieldBegin(2, CompactType::I64);
+    writer.writeI64(INT64_MIN);
+    writer.writeBoolField(3, true);
+    // Delta larger than 15 forces the long field header form
+    writer.writeFieldBegin(40, CompactType::BINARY);
+    writer.writeBinary("parquet");
+    writer.writeFieldBegin(41, CompactType::DOUBLE);
+    writer.writeDouble(2.5);
+    writer.writeStructEnd();
+
+    const auto &bytes = writer.buffer();
+    CompactProtocolReader reader(bytes.data(), bytes.size());
+    int16_t id;
+    CompactType type;
+    reader.readStructBegin();
+
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    EXPECT_EQ(id, 1);
+    EXPECT_EQ(reader.readI32(), -123456);
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    EXPECT_EQ(id, 2);
+    EXPECT_EQ(reader.readI64(), INT64_MIN);
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    EXPECT_EQ(id, 3);
+    EXPECT_TRUE(CompactProtocolReader::readBool(type));
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    EXPECT_EQ(id, 40);
+    EXPECT_EQ(reader.readBinary(), "parquet");
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    EXPECT_EQ(id, 41);
+    EXPECT_EQ(reader.readDouble(), 2.5);
+    EXPECT_FALSE(reader.readFieldBegin(id, type));
+    reader.readStructEnd();
+    EXPECT_EQ(reader.position(), bytes.size());
+}
+
+TEST(CompactProtocolTest, SkipsNestedValues)
+{
+    CompactProtocolWriter writer;
+    writer.writeStructBegin();
+    writer.writeFieldBegin(1, CompactType::LIST);
+    writer.writeListBegin(CompactType::STRUCT, 20);
+    for (int i = 0; i < 20; ++i)
+    {
+        writer.writeStructBegin();
+        writer.writeFieldBegin(1, CompactType::I32);
+        writer.writeI32(i);
+        writer.writeStructEnd();
+    }
+    writer.writeFieldBegin(2, CompactType::I32);
+    writer.writeI32(7);
+    writer.writeStructEnd();
+
+    const auto &bytes = writer.buffer();
+    CompactProtocolReader reader(bytes.data(), bytes.size());
+    int16_t id;
+    CompactType type;
+    reader.readStructBegin();
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    reader.skip(type);
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    EXPECT_EQ(id, 2);
+    EXPECT_EQ(reader.readI32(), 7);
+}
+
+TEST(CompactProtocolTest, RejectsTruncatedInput)
+{
+    const uint8_t bytes[] = {0x18, 0x05, 'a', 'b'};
+    CompactProtocolReader reader(bytes, sizeof(bytes));
+    int16_t id;
+    CompactType type;
+    reader.readStructBegin();
+    ASSERT_TRUE(reader.readFieldBegin(id, type));
+    EXPECT_THROW(reader.readBinary(), thrift::ProtocolException);
+}
+
+TEST(ParquetMetadataTest, FileMetaDataRoundTrip)
+{
+    FileMetaData metadata;
+    SchemaElement root;
+    root.name = "schema";
+    root.num_children = 2;
+    SchemaElement id;
+    id.name = "id";
+    id.type = AtomicType::INT64;
+    id.repetition_type = FieldRepetitionType::REQUIRED;
+    SchemaElement name;
+    name.name = "name";
+    name.type = AtomicType::BYTE_ARRAY;
+    name.repetition_type = FieldRepetitionType::OPTIONAL;
+    metadata.schema = {root, id, name};
+    metadata.num_rows = 1000;
+    metadata.created_by = "test";
+    metadata.key_value_metadata.push_back({"k", "v"});
+
+    RowGroup row_group;
+    row_group.num_rows = 1000;
+    row_group.total_byte_size = 4096;
+    row_group.ordinal = 0;
+    ColumnChunk chunk;
+    chunk.file_offset = 4;
+    ColumnMetaData &column = chunk.meta_data.emplace();
+    column.type = AtomicType::INT64;
+    column.encodings = {Encoding::PLAIN, Encoding::RLE};
+    column.path_in_schema = {"id"};
+    column.codec = CompressionCodec::SNAPPY;
+    column.num_values = 1000;
+    column.data_page_offset = 4;
+    column.statistics.emplace().null_count = 0;
+    row_group.columns = {chunk, chunk};
+    metadata.row_groups = {row_group};
+
+    std::vector<uint8_t> bytes = serializeThrift(metadata);
+    size_t consumed = 0;
+    FileMetaData parsed = parseThrift<FileMetaData>(bytes.data(), bytes.size(), &consumed);
+    EXPECT_EQ(consumed, bytes.size());
+    EXPECT_EQ(serializeThrift(parsed), bytes);
+
+    ASSERT_EQ(parsed.schema.size(), 3u);
+    EXPECT_EQ(parsed.schema[2].name, "name");
+    EXPECT_EQ(parsed.schema[2].repetition_type, FieldRepetitionType::OPTIONAL);
+    ASSERT_EQ(parsed.row_groups.size(), 1u);
+    const ColumnMetaData &parsed_column = *parsed.row_groups[0].columns[1].meta_data;
+    EXPECT_EQ(parsed_column.codec, CompressionCodec::SNAPPY);
+    EXPECT_EQ(parsed_column.encodings, column.encodings);
+    EXPECT_EQ(parsed_column.statistics->null_count, 0);
+    EXPECT_EQ(parsed.key_value_metadata[0].value, "v");
+
+    EXPECT_THROW(parseThrift<FileMetaData>(bytes.data(), bytes.size() / 2), ParquetException);
+}
+
+TEST(ParquetMetadataTest, LeafColumnsComputeLevels)
+{
+    auto element = [](std::string name, FieldRepetitionType repetition, int32_t children)
+    {
+        SchemaElement e;
+        e.name = std::move(name);
+        e.repetition_type = repetition;
+        if (children > 0)
+        {
+            e.num_children = children;
+        }
+        else
+        {
+            e.type = AtomicType::INT32;
+        }
+        return e;
+    };
+    SchemaElement root;
+    root.name = "schema";
+    root.num_children = 2;
+    std::vector<SchemaElement> schema = {
+        root,
+        element("a", FieldRepetitionType::REQUIRED, 0),
+        element("b", FieldRepetitionType::OPTIONAL, 1),
+        element("c", FieldRepetitionType::REPEATED, 0),
+    };
+
+    auto columns = leafColumns(schema);
+    ASSERT_EQ(columns.size(), 2u);
+    EXPECT_EQ(columns[0].dottedPath(), "a");
+    EXPECT_EQ(columns[0].max_definition_level, 0);
+    EXPECT_EQ(columns[1].dottedPath(), "b.c");
+    EXPECT_EQ(columns[1].max_definition_level, 2);
+    EXPECT_EQ(columns[1].max_repetition_level, 1);
+
+    schema.pop_back();
+    EXPECT_THROW(leafColumns(schema), ParquetException);
+}
@@ -0,0 +1,1764 @@
+#include "variant.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    constexpr int kPrimitive = 0;
+    constexpr int kShortString = 1;
+    constexpr int kObject = 2;
+    constexpr int kArray = 3;
+
+    constexpr size_t kMaxShortStringSize = 63;
+    constexpr int kMaxDepth = 1000;
+
+    // Primitive type ids of the value header
+    enum PrimitiveId
+    {
+        kNull = 0,
+        kTrue = 1,
+        kFalse = 2,
+        kInt8 = 3,
+        kInt16 = 4,
+        kInt32 = 5,
+        kInt64 = 6,
+        kDouble = 7,
+        kDecimal4 = 8,
+        kDecimal8 = 9,
+        kDecimal16 = 10,
+        kDate = 11,
+        kTimestamp = 12,
+        kTimestampNtz = 13,
+        kFloat = 14,
+        kBinary = 15,
+        kString = 16,
+        kTimeNtz = 17,
+        kTimestampNanos = 18,
+        kTimestampNanosNtz = 19,
+        kUuid = 20
+    };
+
+    [[noreturn]] void corrupt(const char *what)
+    {
+        throw ParquetException(std::string("Corrupt variant: ") + what);
+    }
+
+    uint32_t readUnsigned(const uint8_t *data, uint32_t width) noexcept
+    {
+        switch (width)
+        {
+        case 1:
+            return data[0];
+        case 2:
+            return data[0] | (uint32_t{data[1]} << 8);
+        case 3:
+            return data[0] | (uint32_t{data[1]} << 8) | (uint32_t{data[2]} << 16);
+        default:
+            uint32_t value;
+            std::memcpy(&value, data, 4);
+            return value;
+        }
+    }
+
+    void writeUnsigned(uint8_t *out, size_t value, uint32_t width) noexcept
+    {
+        for (uint32_t i = 0; i < width; ++i)
+        {
+            out[i] = static_cast<uint8_t>(value >> (8 * i));
+        }
+    }
+
+    // Smallest of 1-4 bytes that holds the value
+    uint32_t widthFor(size_t value)
+    {
+        if (value > UINT32_MAX)
+        {
+            throw std::length_error("Variant values are limited to 4GB");
+        }
+        return value <= 0xFF ? 1 : value <= 0xFFFF ? 2 : value <= 0xFFFFFF ? 3 : 4;
+    }
+
+    uint8_t objectHeader(uint32_t offset_size, uint32_t id_size, bool large) noexcept
+    {
+        return static_cast<uint8_t>(kObject | (((offset_size - 1) | ((id_size - 1) << 2) | (large ? 0x10 : 0)) << 2));
+    }
+
+    template <typename T>
+    T load(const uint8_t *data) noexcept
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+
+    // Bytes after the header byte of a fixed size primitive, or -1 for variable sizes
+    int primitiveSize(int id)
+    {
+        switch (id)
+        {
+        case kNull:
+        case kTrue:
+        case kFalse:
+            return 0;
+        case kInt8:
+            return 1;
+        case kInt16:
+            return 2;
+        case kInt32:
+        case kDate:
+        case kFloat:
+            return 4;
+        case kInt64:
+        case kDouble:
+        case kTimestamp:
+        case kTimestampNtz:
+        case kTimeNtz:
+        case kTimestampNanos:
+        case kTimestampNanosNtz:
+            return 8;
+        case kDecimal4:
+            return 5;
+        case kDecimal8:
+            return 9;
+        case kUuid:
+            return 16;
+        case kDecimal16:
+            return 17;
+        case kBinary:
+        case kString:
+            return -1;
+        default:
+            throw ParquetException("Unsupported variant primitive type " + std::to_string(id));
+        }
+    }
+
+    [[noreturn]] void wrongType(const char *expected)
+    {
+        throw std::logic_error(std::string("Variant value is not ") + expected);
+    }
+
+    void appendEscaped(std::string &out, std::string_view value)
+    {
+        static const char kHex[] = "0123456789abcdef";
+        out += '"';
+        for (char c : value)
+        {
+            switch (c)
+            {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\b':
+                out += "\\b";
+                break;
+            case '\f':
+                out += "\\f";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            case '\r':
+                out += "\\r";
+                break;
+            case '\t':
+                out += "\\t";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    out += "\\u00";
+                    out += kHex[c >> 4];
+                    out += kHex[c & 15];
+                }
+                else
+                {
+                    out += c;
+                }
+            }
+        }
+        out += '"';
+    }
+
+    std::string int128ToString(__int128 value)
+    {
+        bool negative = value < 0;
+        unsigned __int128 magnitude = negative ? -static_cast<unsigned __int128>(value) : value;
+        std::string digits;
+        do
+        {
+            digits += static_cast<char>('0' + static_cast<int>(magnitude % 10));
+            magnitude /= 10;
+        } while (magnitude != 0);
+        if (negative)
+        {
+            digits += '-';
+        }
+        std::reverse(digits.begin(), digits.end());
+        return digits;
+    }
+
+    void appendDecimal(std::string &out, const VariantDecimal &decimal)
+    {
+        std::string digits = int128ToString(decimal.unscaled);
+        bool negative = digits[0] == '-';
+        if (negative)
+        {
+            out += '-';
+            digits.erase(0, 1);
+        }
+        if (digits.size() <= decimal.scale)
+        {
+            digits.insert(0, decimal.scale + 1 - digits.size(), '0');
+        }
+        size_t point = digits.size() - decimal.scale;
+        out.append(digits, 0, point);
+        if (decimal.scale > 0)
+        {
+            out += '.';
+            out.append(digits, point, std::string::npos);
+        }
+    }
+
+    template <typename T>
+    void appendFloating(std::string &out, T value)
+    {
+        if (std::isnan(value))
+        {
+            out += "\"NaN\"";
+            return;
+        }
+        if (std::isinf(value))
+        {
+            out += value > 0 ? "\"Infinity\"" : "\"-Infinity\"";
+            return;
+        }
+        char buffer[32];
+        char *end = std::to_chars(buffer, buffer + sizeof(buffer), value).ptr;
+        out.append(buffer, end);
+        // Keep it a floating point number when parsed back
+        if (std::find_if(buffer, end, [](char c)
+                         { return c == '.' || c == 'e'; }) == end)
+        {
+            out += ".0";
+        }
+    }
+
+    // Days since 1970-01-01 to a civil date (Howard Hinnant's algorithm)
+    void civilFromDays(int64_t days, int64_t &year, unsigned &month, unsigned &day) noexcept
+    {
+        days += 719468;
+        int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+        auto day_of_era = static_cast<unsigned>(days - era * 146097);
+        unsigned year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        unsigned day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        unsigned mp = (5 * day_of_year + 2) / 153;
+        day = day_of_year - (153 * mp + 2) / 5 + 1;
+        month = mp < 10 ? mp + 3 : mp - 9;
+        year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2);
+    }
+
+    int64_t floorDiv(int64_t value, int64_t divisor) noexcept
+    {
+        int64_t quotient = value / divisor;
+        return quotient * divisor > value ? quotient - 1 : quotient;
+    }
+
+    void appendDate(std::string &out, int64_t days)
+    {
+        int64_t year;
+        unsigned month, day;
+        civilFromDays(days, year, month, day);
+        char buffer[32];
+        int size = std::snprintf(buffer, sizeof(buffer), "%04lld-%02u-%02u", static_cast<long long>(year), month, day);
+        out.append(buffer, static_cast<size_t>(size));
+    }
+
+    // Time of day from units since midnight, with `digits` fractional digits
+    void appendTimeOfDay(std::string &out, int64_t units, int64_t units_per_second, int digits)
+    {
+        int64_t seconds = units / units_per_second;
+        char buffer[32];
+        int size = std::snprintf(buffer, sizeof(buffer), "%02lld:%02lld:%02lld.%0*lld",
+                                 static_cast<long long>(seconds / 3600), static_cast<long long>(seconds / 60 % 60),
+                                 static_cast<long long>(seconds % 60), digits,
+                                 static_cast<long long>(units % units_per_second));
+        out.append(buffer, static_cast<size_t>(size));
+    }
+
+    void appendTimestamp(std::string &out, int64_t value, int64_t units_per_second, int digits, bool utc)
+    {
+        int64_t units_per_day = units_per_second * 86400;
+        int64_t days = floorDiv(value, units_per_day);
+        out += '"';
+        appendDate(out, days);
+        out += 'T';
+        appendTimeOfDay(out, value - days * units_per_day, units_per_second, digits);
+        if (utc)
+        {
+            out += "+00:00";
+        }
+        out += '"';
+    }
+
+    void appendBase64(std::string &out, std::string_view bytes)
+    {
+        static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+        out += '"';
+        size_t i = 0;
+        for (; i + 3 <= bytes.size(); i += 3)
+        {
+            uint32_t group = (uint32_t{static_cast<uint8_t>(bytes[i])} << 16) |
+                             (uint32_t{static_cast<uint8_t>(bytes[i + 1])} << 8) | static_cast<uint8_t>(bytes[i + 2]);
+            out += kAlphabet[group >> 18];
+            out += kAlphabet[(group >> 12) & 63];
+            out += kAlphabet[(group >> 6) & 63];
+            out += kAlphabet[group & 63];
+        }
+        if (i < bytes.size())
+        {
+            uint32_t group = uint32_t{static_cast<uint8_t>(bytes[i])} << 16;
+            if (i + 1 < bytes.size())
+            {
+                group |= uint32_t{static_cast<uint8_t>(bytes[i + 1])} << 8;
+            }
+            out += kAlphabet[group >> 18];
+            out += kAlphabet[(group >> 12) & 63];
+            out += i + 1 < bytes.size() ? kAlphabet[(group >> 6) & 63] : '=';
+            out += '=';
+        }
+        out += '"';
+    }
+
+    void appendUuid(std::string &out, std::string_view bytes)
+    {
+        static const char kHex[] = "0123456789abcdef";
+        out += '"';
+        for (size_t i = 0; i < bytes.size(); ++i)
+        {
+            if (i == 4 || i == 6 || i == 8 || i == 10)
+            {
+                out += '-';
+            }
+            out += kHex[static_cast<uint8_t>(bytes[i]) >> 4];
+            out += kHex[static_cast<uint8_t>(bytes[i]) & 15];
+        }
+        out += '"';
+    }
+
+    class JsonParser
+    {
+    public:
+        JsonParser(std::string_view json, VariantBuilder &builder)
+            : data_(json.data()), end_(json.data() + json.size()), builder_(builder) {}
+
+        void parse()
+        {
+            parseValue(0);
+            skipWhitespace();
+            if (data_ != end_)
+            {
+                fail("trailing characters");
+            }
+        }
+
+    private:
+        [[noreturn]] void fail(const char *what) const
+        {
+            throw std::invalid_argument(std::string("Invalid JSON: ") + what);
+        }
+
+        void skipWhitespace() noexcept
+        {
+            while (data_ != end_ && (*data_ == ' ' || *data_ == '\n' || *data_ == '\r' || *data_ == '\t'))
+            {
+                ++data_;
+            }
+        }
+
+        void expectLiteral(std::string_view literal)
+        {
+            if (static_cast<size_t>(end_ - data_) < literal.size() || std::string_view(data_, literal.size()) != literal)
+            {
+                fail("unexpected character");
+            }
+            data_ += literal.size();
+        }
+
+        void parseValue(int depth)
+        {
+            skipWhitespace();
+            if (data_ == end_)
+            {
+                fail("unexpected end");
+            }
+            switch (*data_)
+            {
+            case '{':
+                parseObject(depth + 1);
+                break;
+            case '[':
+                parseArray(depth + 1);
+                break;
+            case '"':
+                builder_.appendString(parseString());
+                break;
+            case 't':
+                expectLiteral("true");
+                builder_.appendBool(true);
+                break;
+            case 'f':
+                expectLiteral("false");
+                builder_.appendBool(false);
+                break;
+            case 'n':
+                expectLiteral("null");
+                builder_.appendNull();
+                break;
+            default:
+                parseNumber();
+            }
+        }
+
+        void parseObject(int depth)
+        {
+            if (depth > kMaxDepth)
+            {
+                fail("nested too deeply");
+            }
+            ++data_;
+            builder_.beginObject();
+            skipWhitespace();
+            if (data_ != end_ && *data_ == '}')
+            {
+                ++data_;
+                builder_.endObject();
+                return;
+            }
+            while (true)
+            {
+                skipWhitespace();
+                if (data_ == end_ || *data_ != '"')
+                {
+                    fail("expected a key");
+                }
+                builder_.key(parseString());
+                skipWhitespace();
+                if (data_ == end_ || *data_ != ':')
+                {
+                    fail("expected ':'");
+                }
+                ++data_;
+                parseValue(depth);
+                skipWhitespace();
+                if (data_ != end_ && *data_ == ',')
+                {
+                    ++data_;
+                    continue;
+                }
+                if (data_ != end_ && *data_ == '}')
+                {
+                    ++data_;
+                    builder_.endObject();
+                    return;
+                }
+                fail("expected ',' or '}'");
+            }
+        }
+
+        void parseArray(int depth)
+        {
+            if (depth > kMaxDepth)
+            {
+                fail("nested too deeply");
+            }
+            ++data_;
+            builder_.beginArray();
+            skipWhitespace();
+            if (data_ != end_ && *data_ == ']')
+            {
+                ++data_;
+                builder_.endArray();
+                return;
+            }
+            while (true)
+            {
+                parseValue(depth);
+                skipWhitespace();
+                if (data_ != end_ && *data_ == ',')
+                {
+                    ++data_;
+                    continue;
+                }
+                if (data_ != end_ && *data_ == ']')
+                {
+                    ++data_;
+                    builder_.endArray();
+                    return;
+                }
+                fail("expected ',' or ']'");
+            }
+        }
+
+        uint32_t parseHex4()
+        {
+            if (end_ - data_ < 4)
+            {
+                fail("truncated \\u escape");
+            }
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i)
+            {
+                char c = *data_++;
+                value <<= 4;
+                if (c >= '0' && c <= '9')
+                {
+                    value |= static_cast<uint32_t>(c - '0');
+                }
+                else if (c >= 'a' && c <= 'f')
+                {
+                    value |= static_cast<uint32_t>(c - 'a' + 10);
+                }
+                else if (c >= 'A' && c <= 'F')
+                {
+                    value |= static_cast<uint32_t>(c - 'A' + 10);
+                }
+                else
+                {
+                    fail("invalid \\u escape");
+                }
+            }
+            return value;
+        }
+
+        void appendUtf8(uint32_t code_point)
+        {
+            if (code_point < 0x80)
+            {
+                scratch_ += static_cast<char>(code_point);
+            }
+            else if (code_point < 0x800)
+            {
+                scratch_ += static_cast<char>(0xC0 | (code_point >> 6));
+                scratch_ += static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            else if (code_point < 0x10000)
+            {
+                scratch_ += static_cast<char>(0xE0 | (code_point >> 12));
+                scratch_ += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                scratch_ += static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+            else
+            {
+                scratch_ += static_cast<char>(0xF0 | (code_point >> 18));
+                scratch_ += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                scratch_ += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                scratch_ += static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+        }
+
+        // Strings without escapes are returned as a view of the input
+        std::string_view parseString()
+        {
+            const char *start = ++data_;
+            while (data_ != end_ && *data_ != '"' && *data_ != '\\')
+            {
+                if (static_cast<unsigned char>(*data_) < 0x20)
+                {
+                    fail("control character in string");
+                }
+                ++data_;
+            }
+            if (data_ == end_)
+            {
+                fail("unterminated string");
+            }
+            if (*data_ == '"')
+            {
+                return std::string_view(start, static_cast<size_t>(data_++ - start));
+            }
+
+            scratch_.assign(start, data_);
+            while (true)
+            {
+                if (data_ == end_)
+                {
+                    fail("unterminated string");
+                }
+                char c = *data_++;
+                if (c == '"')
+                {
+                    return scratch_;
+                }
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    fail("control character in string");
+                }
+                if (c != '\\')
+                {
+                    scratch_ += c;
+                    continue;
+                }
+                if (data_ == end_)
+                {
+                    fail("unterminated string");
+                }
+                switch (*data_++)
+                {
+                case '"':
+                    scratch_ += '"';
+                    break;
+                case '\\':
+                    scratch_ += '\\';
+                    break;
+                case '/':
+                    scratch_ += '/';
+                    break;
+                case 'b':
+                    scratch_ += '\b';
+                    break;
+                case 'f':
+                    scratch_ += '\f';
+                    break;
+                case 'n':
+                    scratch_ += '\n';
+                    break;
+                case 'r':
+                    scratch_ += '\r';
+                    break;
+                case 't':
+                    scratch_ += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t code_point = parseHex4();
+                    if (code_point >= 0xDC00 && code_point <= 0xDFFF)
+                    {
+                        fail("unpaired surrogate");
+                    }
+                    if (code_point >= 0xD800 && code_point <= 0xDBFF)
+                    {
+                        if (end_ - data_ < 2 || data_[0] != '\\' || data_[1] != 'u')
+                        {
+                            fail("unpaired surrogate");
+                        }
+                        data_ += 2;
+                        uint32_t low = parseHex4();
+                        if (low < 0xDC00 || low > 0xDFFF)
+                        {
+                            fail("unpaired surrogate");
+                        }
+                        code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(code_point);
+                    break;
+                }
+                default:
+                    fail("invalid escape");
+                }
+            }
+        }
+
+        void parseNumber()
+        {
+            const char *start = data_;
+            auto digits = [this]()
+            {
+                const char *first = data_;
+                while (data_ != end_ && *data_ >= '0' && *data_ <= '9')
+                {
+                    ++data_;
+                }
+                return data_ != first;
+            };
+            if (data_ != end_ && *data_ == '-')
+            {
+                ++data_;
+            }
+            if (data_ != end_ && *data_ == '0')
+            {
+                ++data_;
+            }
+            else if (!digits())
+            {
+                fail("unexpected character");
+            }
+            bool integer = true;
+            if (data_ != end_ && *data_ == '.')
+            {
+                ++data_;
+                integer = false;
+                if (!digits())
+                {
+                    fail("expected digits after '.'");
+                }
+            }
+            if (data_ != end_ && (*data_ == 'e' || *data_ == 'E'))
+            {
+                ++data_;
+                integer = false;
+                if (data_ != end_ && (*data_ == '+' || *data_ == '-'))
+                {
+                    ++data_;
+                }
+                if (!digits())
+                {
+                    fail("expected exponent digits");
+                }
+            }
+
+            if (integer)
+            {
+                int64_t value;
+                auto result = std::from_chars(start, data_, value);
+                if (result.ec == std::errc())
+                {
+                    builder_.appendInt(value);
+                    return;
+                }
+            }
+            double value;
+            auto result = std::from_chars(start, data_, value);
+            if (result.ec != std::errc())
+            {
+                fail("number out of range");
+            }
+            builder_.appendDouble(value);
+        }
+
+        const char *data_;
+        const char *end_;
+        VariantBuilder &builder_;
+        std::string scratch_;
+    };
+} // namespace
+
+VariantMetadata::VariantMetadata(const uint8_t *data, size_t size) : data_(data), size_(size)
+{
+    if (size == 0)
+    {
+        corrupt("empty metadata");
+    }
+    uint8_t header = data[0];
+    if ((header & 0x0F) != 1)
+    {
+        throw ParquetException("Unsupported variant metadata version " + std::to_string(header & 0x0F));
+    }
+    sorted_ = (header & 0x10) != 0;
+    offset_size_ = ((header >> 6) & 3) + 1;
+    if (size < 1 + size_t{offset_size_})
+    {
+        corrupt("truncated metadata");
+    }
+    dictionary_size_ = readUnsigned(data + 1, offset_size_);
+    size_t offsets_size = (size_t{dictionary_size_} + 1) * offset_size_;
+    if (size - 1 - offset_size_ < offsets_size)
+    {
+        corrupt("truncated metadata");
+    }
+    offsets_ = data + 1 + offset_size_;
+    strings_ = offsets_ + offsets_size;
+    strings_size_ = size - static_cast<size_t>(strings_ - data);
+}
+
+std::string_view VariantMetadata::key(uint32_t id) const
+{
+    if (id >= dictionary_size_)
+    {
+        corrupt("key id out of range");
+    }
+    uint32_t start = readUnsigned(offsets_ + size_t{id} * offset_size_, offset_size_);
+    uint32_t end = readUnsigned(offsets_ + (size_t{id} + 1) * offset_size_, offset_size_);
+    if (start > end || end > strings_size_)
+    {
+        corrupt("key offset out of range");
+    }
+    return std::string_view(reinterpret_cast<const char *>(strings_) + start, end - start);
+}
+
+std::optional<uint32_t> VariantMetadata::find(std::string_view key) const
+{
+    if (!sorted_)
+    {
+        for (uint32_t id = 0; id < dictionary_size_; ++id)
+        {
+            if (this->key(id) == key)
+            {
+                return id;
+            }
+        }
+        return std::nullopt;
+    }
+    uint32_t low = 0;
+    uint32_t high = dictionary_size_;
+    while (low < high)
+    {
+        uint32_t middle = low + (high - low) / 2;
+        int order = this->key(middle).compare(key);
+        if (order == 0)
+        {
+            return middle;
+        }
+        if (order < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return std::nullopt;
+}
+
+VariantPath::VariantPath(std::string_view path)
+{
+    auto fail = [&path]()
+    {
+        throw std::invalid_argument("Invalid variant path: " + std::string(path));
+    };
+    if (path.empty() || path[0] != '$')
+    {
+        fail();
+    }
+    size_t i = 1;
+    while (i < path.size())
+    {
+        Step step;
+        if (path[i] == '.')
+        {
+            size_t end = path.find_first_of(".[", i + 1);
+            end = end == std::string_view::npos ? path.size() : end;
+            if (end == i + 1)
+            {
+                fail();
+            }
+            step.key = path.substr(i + 1, end - i - 1);
+            i = end;
+        }
+        else if (path[i] == '[' && i + 1 < path.size() && (path[i + 1] == '\'' || path[i + 1] == '"'))
+        {
+            size_t end = path.find(path[i + 1], i + 2);
+            if (end == std::string_view::npos || end + 1 >= path.size() || path[end + 1] != ']')
+            {
+                fail();
+            }
+            step.key = path.substr(i + 2, end - i - 2);
+            i = end + 2;
+        }
+        else if (path[i] == '[')
+        {
+            size_t end = path.find(']', i + 1);
+            if (end == std::string_view::npos)
+            {
+                fail();
+            }
+            auto result = std::from_chars(path.data() + i + 1, path.data() + end, step.index);
+            if (end == i + 1 || result.ec != std::errc() || result.ptr != path.data() + end)
+            {
+                fail();
+            }
+            step.is_index = true;
+            i = end + 1;
+        }
+        else
+        {
+            fail();
+        }
+        steps_.push_back(std::move(step));
+    }
+}
+
+VariantView::VariantView(const VariantMetadata &metadata, const uint8_t *value, size_t size)
+    : metadata_(metadata), value_(value), size_(size)
+{
+    if (size == 0)
+    {
+        corrupt("empty value");
+    }
+}
+
+VariantType VariantView::type() const
+{
+    switch (basicType())
+    {
+    case kShortString:
+        return VariantType::STRING;
+    case kObject:
+        return VariantType::OBJECT;
+    case kArray:
+        return VariantType::ARRAY;
+    default:
+        break;
+    }
+    int id = value_[0] >> 2;
+    switch (id)
+    {
+    case kNull:
+        return VariantType::NULL_VALUE;
+    case kTrue:
+    case kFalse:
+        return VariantType::BOOLEAN;
+    case kInt8:
+        return VariantType::INT8;
+    case kInt16:
+        return VariantType::INT16;
+    case kInt32:
+        return VariantType::INT32;
+    case kInt64:
+        return VariantType::INT64;
+    case kDouble:
+        return VariantType::DOUBLE;
+    case kDecimal4:
+        return VariantType::DECIMAL4;
+    case kDecimal8:
+        return VariantType::DECIMAL8;
+    case kDecimal16:
+        return VariantType::DECIMAL16;
+    case kDate:
+        return VariantType::DATE;
+    case kTimestamp:
+        return VariantType::TIMESTAMP;
+    case kTimestampNtz:
+        return VariantType::TIMESTAMP_NTZ;
+    case kFloat:
+        return VariantType::FLOAT;
+    case kBinary:
+        return VariantType::BINARY;
+    case kString:
+        return VariantType::STRING;
+    case kTimeNtz:
+        return VariantType::TIME_NTZ;
+    case kTimestampNanos:
+        return VariantType::TIMESTAMP_NANOS;
+    case kTimestampNanosNtz:
+        return VariantType::TIMESTAMP_NANOS_NTZ;
+    case kUuid:
+        return VariantType::UUID;
+    default:
+        throw ParquetException("Unsupported variant primitive type " + std::to_string(id));
+    }
+}
+
+const uint8_t *VariantView::primitiveData(size_t size) const
+{
+    if (size_ - 1 < size)
+    {
+        corrupt("truncated value");
+    }
+    return value_ + 1;
+}
+
+size_t VariantView::valueSize() const
+{
+    switch (basicType())
+    {
+    case kShortString:
+        primitiveData(value_[0] >> 2);
+        return 1 + (value_[0] >> 2);
+    case kObject:
+    case kArray:
+    {
+        Container c = container(basicType());
+        return static_cast<size_t>(c.values - value_) + c.values_size;
+    }
+    default:
+        break;
+    }
+    int size = primitiveSize(value_[0] >> 2);
+    if (size >= 0)
+    {
+        primitiveData(static_cast<size_t>(size));
+        return 1 + static_cast<size_t>(size);
+    }
+    size_t length = load<uint32_t>(primitiveData(4));
+    primitiveData(4 + length);
+    return 5 + length;
+}
+
+bool VariantView::isNull() const
+{
+    return value_[0] == kNull;
+}
+
+bool VariantView::getBool() const
+{
+    if (basicType() != kPrimitive || ((value_[0] >> 2) != kTrue && (value_[0] >> 2) != kFalse))
+    {
+        wrongType("a boolean");
+    }
+    return (value_[0] >> 2) == kTrue;
+}
+
+int64_t VariantView::getInt() const
+{
+    if (basicType() == kPrimitive)
+    {
+        switch (value_[0] >> 2)
+        {
+        case kInt8:
+            return static_cast<int8_t>(*primitiveData(1));
+        case kInt16:
+            return load<int16_t>(primitiveData(2));
+        case kInt32:
+        case kDate:
+            return load<int32_t>(primitiveData(4));
+        case kInt64:
+        case kTimestamp:
+        case kTimestampNtz:
+        case kTimeNtz:
+        case kTimestampNanos:
+        case kTimestampNanosNtz:
+            return load<int64_t>(primitiveData(8));
+        default:
+            break;
+        }
+    }
+    wrongType("an integer");
+}
+
+double VariantView::getDouble() const
+{
+    if (basicType() == kPrimitive && (value_[0] >> 2) == kDouble)
+    {
+        return load<double>(primitiveData(8));
+    }
+    if (basicType() == kPrimitive && (value_[0] >> 2) == kFloat)
+    {
+        return load<float>(primitiveData(4));
+    }
+    wrongType("a floating point number");
+}
+
+VariantDecimal VariantView::getDecimal() const
+{
+    VariantDecimal decimal;
+    switch (basicType() == kPrimitive ? value_[0] >> 2 : -1)
+    {
+    case kDecimal4:
+        decimal.unscaled = load<int32_t>(primitiveData(5) + 1);
+        break;
+    case kDecimal8:
+        decimal.unscaled = load<int64_t>(primitiveData(9) + 1);
+        break;
+    case kDecimal16:
+        decimal.unscaled = load<__int128>(primitiveData(17) + 1);
+        break;
+    default:
+        wrongType("a decimal");
+    }
+    decimal.scale = value_[1];
+    if (decimal.scale > 38)
+    {
+        corrupt("decimal scale above 38");
+    }
+    return decimal;
+}
+
+std::string_view VariantView::getString() const
+{
+    if (basicType() == kShortString)
+    {
+        size_t length = value_[0] >> 2;
+        return std::string_view(reinterpret_cast<const char *>(primitiveData(length)), length);
+    }
+    if (basicType() == kPrimitive && (value_[0] >> 2) == kString)
+    {
+        size_t length = load<uint32_t>(primitiveData(4));
+        return std::string_view(reinterpret_cast<const char *>(primitiveData(4 + length) + 4), length);
+    }
+    wrongType("a string");
+}
+
+std::string_view VariantView::getBinary() const
+{
+    if (basicType() == kPrimitive && (value_[0] >> 2) == kBinary)
+    {
+        size_t length = load<uint32_t>(primitiveData(4));
+        return std::string_view(reinterpret_cast<const char *>(primitiveData(4 + length) + 4), length);
+    }
+    if (basicType() == kPrimitive && (value_[0] >> 2) == kUuid)
+    {
+        return std::string_view(reinterpret_cast<const char *>(primitiveData(16)), 16);
+    }
+    wrongType("binary");
+}
+
+VariantView::Container VariantView::container(int basic_type) const
+{
+    if (basicType() != basic_type)
+    {
+        wrongType(basic_type == kObject ? "an object" : "an array");
+    }
+    uint8_t header = value_[0] >> 2;
+    Container c;
+    bool large;
+    c.offset_size = (header & 3) + 1;
+    if (basic_type == kObject)
+    {
+        c.id_size = ((header >> 2) & 3) + 1;
+        large = (header & 0x10) != 0;
+    }
+    else
+    {
+        c.id_size = 0;
+        large = (header & 0x04) != 0;
+    }
+    size_t count_size = large ? 4 : 1;
+    c.num_elements = readUnsigned(primitiveData(count_size), static_cast<uint32_t>(count_size));
+    size_t ids_size = size_t{c.num_elements} * c.id_size;
+    size_t offsets_size = (size_t{c.num_elements} + 1) * c.offset_size;
+    size_t header_size = 1 + count_size + ids_size + offsets_size;
+    primitiveData(header_size - 1);
+    c.ids = value_ + 1 + count_size;
+    c.offsets = c.ids + ids_size;
+    c.values = c.offsets + offsets_size;
+    c.values_size = readUnsigned(c.offsets + size_t{c.num_elements} * c.offset_size, c.offset_size);
+    if (c.values_size > size_ - header_size)
+    {
+        corrupt("container larger than its buffer");
+    }
+    return c;
+}
+
+VariantView VariantView::child(const Container &c, size_t i) const
+{
+    size_t offset = readUnsigned(c.offsets + i * c.offset_size, c.offset_size);
+    if (offset >= c.values_size)
+    {
+        corrupt("element offset out of range");
+    }
+    return VariantView(metadata_, c.values + offset, c.values_size - offset);
+}
+
+size_t VariantView::numElements() const
+{
+    if (basicType() != kObject && basicType() != kArray)
+    {
+        wrongType("an object or array");
+    }
+    return container(basicType()).num_elements;
+}
+
+std::optional<VariantView> VariantView::field(std::string_view key) const
+{
+    if (basicType() != kObject)
+    {
+        return std::nullopt;
+    }
+    Container c = container(kObject);
+    size_t low = 0;
+    size_t high = c.num_elements;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        uint32_t id = readUnsigned(c.ids + middle * c.id_size, c.id_size);
+        int order = metadata_.key(id).compare(key);
+        if (order == 0)
+        {
+            return child(c, middle);
+        }
+        if (order < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string_view VariantView::fieldKey(size_t i) const
+{
+    Container c = container(kObject);
+    if (i >= c.num_elements)
+    {
+        throw std::out_of_range("Variant object field " + std::to_string(i) + " out of range");
+    }
+    return metadata_.key(readUnsigned(c.ids + i * c.id_size, c.id_size));
+}
+
+uint32_t VariantView::fieldId(size_t i) const
+{
+    Container c = container(kObject);
+    if (i >= c.num_elements)
+    {
+        throw std::out_of_range("Variant object field " + std::to_string(i) + " out of range");
+    }
+    return readUnsigned(c.ids + i * c.id_size, c.id_size);
+}
+
+VariantView VariantView::fieldValue(size_t i) const
+{
+    Container c = container(kObject);
+    if (i >= c.num_elements)
+    {
+        throw std::out_of_range("Variant object field " + std::to_string(i) + " out of range");
+    }
+    return child(c, i);
+}
+
+VariantView VariantView::element(size_t i) const
+{
+    Container c = container(kArray);
+    if (i >= c.num_elements)
+    {
+        throw std::out_of_range("Variant array element " + std::to_string(i) + " out of range");
+    }
+    return child(c, i);
+}
+
+std::optional<VariantView> VariantView::find(const VariantPath &path) const
+{
+    std::optional<VariantView> current = *this;
+    for (const VariantPath::Step &step : path.steps())
+    {
+        if (!step.is_index)
+        {
+            current = current->field(step.key);
+        }
+        else if (current->basicType() == kArray)
+        {
+            Container c = current->container(kArray);
+            if (step.index >= c.num_elements)
+            {
+                return std::nullopt;
+            }
+            current = current->child(c, step.index);
+        }
+        else
+        {
+            return std::nullopt;
+        }
+        if (!current)
+        {
+            return std::nullopt;
+        }
+    }
+    return current;
+}
+
+std::string VariantView::toJson() const
+{
+    std::string out;
+    appendJson(out, 0);
+    return out;
+}
+
+void VariantView::appendJson(std::string &out, int depth) const
+{
+    if (depth > kMaxDepth)
+    {
+        corrupt("nested too deeply");
+    }
+    switch (type())
+    {
+    case VariantType::NULL_VALUE:
+        out += "null";
+        break;
+    case VariantType::BOOLEAN:
+        out += getBool() ? "true" : "false";
+        break;
+    case VariantType::INT8:
+    case VariantType::INT16:
+    case VariantType::INT32:
+    case VariantType::INT64:
+        out += std::to_string(getInt());
+        break;
+    case VariantType::DOUBLE:
+        appendFloating(out, getDouble());
+        break;
+    case VariantType::FLOAT:
+        appendFloating(out, static_cast<float>(getDouble()));
+        break;
+    case VariantType::DECIMAL4:
+    case VariantType::DECIMAL8:
+    case VariantType::DECIMAL16:
+        appendDecimal(out, getDecimal());
+        break;
+    case VariantType::DATE:
+        out += '"';
+        appendDate(out, getInt());
+        out += '"';
+        break;
+    case VariantType::TIMESTAMP:
+    case VariantType::TIMESTAMP_NTZ:
+        appendTimestamp(out, getInt(), 1000000, 6, type() == VariantType::TIMESTAMP);
+        break;
+    case VariantType::TIMESTAMP_NANOS:
+    case VariantType::TIMESTAMP_NANOS_NTZ:
+        appendTimestamp(out, getInt(), 1000000000, 9, type() == VariantType::TIMESTAMP_NANOS);
+        break;
+    case VariantType::TIME_NTZ:
+        out += '"';
+        appendTimeOfDay(out, getInt(), 1000000, 6);
+        out += '"';
+        break;
+    case VariantType::STRING:
+        appendEscaped(out, getString());
+        break;
+    case VariantType::BINARY:
+        appendBase64(out, getBinary());
+        break;
+    case VariantType::UUID:
+        appendUuid(out, getBinary());
+        break;
+    case VariantType::OBJECT:
+    {
+        Container c = container(kObject);
+        out += '{';
+        for (size_t i = 0; i < c.num_elements; ++i)
+        {
+            if (i > 0)
+            {
+                out += ',';
+            }
+            appendEscaped(out, metadata_.key(readUnsigned(c.ids + i * c.id_size, c.id_size)));
+            out += ':';
+            child(c, i).appendJson(out, depth + 1);
+        }
+        out += '}';
+        break;
+    }
+    case VariantType::ARRAY:
+    {
+        Container c = container(kArray);
+        out += '[';
+        for (size_t i = 0; i < c.num_elements; ++i)
+        {
+            if (i > 0)
+            {
+                out += ',';
+            }
+            child(c, i).appendJson(out, depth + 1);
+        }
+        out += ']';
+        break;
+    }
+    }
+}
+
+VariantView Variant::view() const
+{
+    return VariantView(VariantMetadata(metadata.data(), metadata.size()), value.data(), value.size());
+}
+
+void VariantBuilder::beginValue()
+{
+    if (frames_.empty())
+    {
+        if (complete_)
+        {
+            throw std::logic_error("A variant holds a single value, call finish() before the next one");
+        }
+        return;
+    }
+    Frame &frame = frames_.back();
+    if (frame.is_object)
+    {
+        if (!frame.has_key)
+        {
+            throw std::logic_error("Object fields need a key() before their value");
+        }
+        fields_.push_back({pending_key_, value_.size() - frame.start});
+        frame.has_key = false;
+    }
+    else
+    {
+        elements_.push_back(value_.size() - frame.start);
+    }
+}
+
+void VariantBuilder::endValue() noexcept
+{
+    complete_ = frames_.empty();
+}
+
+void VariantBuilder::appendPrimitive(int type_id, const void *data, size_t size)
+{
+    beginValue();
+    value_.push_back(static_cast<uint8_t>(type_id << 2));
+    const auto *bytes = static_cast<const uint8_t *>(data);
+    value_.insert(value_.end(), bytes, bytes + size);
+    endValue();
+}
+
+void VariantBuilder::appendNull()
+{
+    appendPrimitive(kNull, nullptr, 0);
+}
+
+void VariantBuilder::appendBool(bool value)
+{
+    appendPrimitive(value ? kTrue : kFalse, nullptr, 0);
+}
+
+void VariantBuilder::appendInt(int64_t value)
+{
+    if (value == static_cast<int8_t>(value))
+    {
+        auto narrow = static_cast<int8_t>(value);
+        appendPrimitive(kInt8, &narrow, 1);
+    }
+    else if (value == static_cast<int16_t>(value))
+    {
+        auto narrow = static_cast<int16_t>(value);
+        appendPrimitive(kInt16, &narrow, 2);
+    }
+    else if (value == static_cast<int32_t>(value))
+    {
+        auto narrow = static_cast<int32_t>(value);
+        appendPrimitive(kInt32, &narrow, 4);
+    }
+    else
+    {
+        appendPrimitive(kInt64, &value, 8);
+    }
+}
+
+void VariantBuilder::appendDouble(double value)
+{
+    appendPrimitive(kDouble, &value, 8);
+}
+
+void VariantBuilder::appendFloat(float value)
+{
+    appendPrimitive(kFloat, &value, 4);
+}
+
+void VariantBuilder::appendDecimal(__int128 unscaled, uint8_t scale)
+{
+    if (scale > 38)
+    {
+        throw std::invalid_argument("Variant decimals have a scale of at most 38");
+    }
+    unsigned __int128 magnitude = unscaled < 0 ? -static_cast<unsigned __int128>(unscaled) : unscaled;
+    int digits = 0;
+    for (unsigned __int128 limit = 1; digits < 39 && magnitude >= limit; limit *= 10)
+    {
+        ++digits;
+    }
+    int precision = std::max<int>(digits, scale);
+    if (precision > 38)
+    {
+        throw std::invalid_argument("Variant decimals have a precision of at most 38");
+    }
+    uint8_t bytes[17];
+    bytes[0] = scale;
+    if (precision <= 9)
+    {
+        auto narrow = static_cast<int32_t>(unscaled);
+        std::memcpy(bytes + 1, &narrow, 4);
+        appendPrimitive(kDecimal4, bytes, 5);
+    }
+    else if (precision <= 18)
+    {
+        auto narrow = static_cast<int64_t>(unscaled);
+        std::memcpy(bytes + 1, &narrow, 8);
+        appendPrimitive(kDecimal8, bytes, 9);
+    }
+    else
+    {
+        std::memcpy(bytes + 1, &unscaled, 16);
+        appendPrimitive(kDecimal16, bytes, 17);
+    }
+}
+
+void VariantBuilder::appendDate(int32_t days)
+{
+    appendPrimitive(kDate, &days, 4);
+}
+
+void VariantBuilder::appendTimestamp(int64_t micros, bool adjusted_to_utc)
+{
+    appendPrimitive(adjusted_to_utc ? kTimestamp : kTimestampNtz, &micros, 8);
+}
+
+void VariantBuilder::appendTimestampNanos(int64_t nanos, bool adjusted_to_utc)
+{
+    appendPrimitive(adjusted_to_utc ? kTimestampNanos : kTimestampNanosNtz, &nanos, 8);
+}
+
+void VariantBuilder::appendTime(int64_t micros)
+{
+    appendPrimitive(kTimeNtz, &micros, 8);
+}
+
+void VariantBuilder::appendString(std::string_view value)
+{
+    if (value.size() <= kMaxShortStringSize)
+    {
+        beginValue();
+        value_.push_back(static_cast<uint8_t>((value.size() << 2) | kShortString));
+        value_.insert(value_.end(), value.begin(), value.end());
+        endValue();
+        return;
+    }
+    widthFor(value.size());
+    beginValue();
+    value_.push_back(static_cast<uint8_t>(kString << 2));
+    size_t position = value_.size();
+    value_.resize(position + 4);
+    writeUnsigned(value_.data() + position, value.size(), 4);
+    value_.insert(value_.end(), value.begin(), value.end());
+    endValue();
+}
+
+void VariantBuilder::appendBinary(std::string_view value)
+{
+    widthFor(value.size());
+    beginValue();
+    value_.push_back(static_cast<uint8_t>(kBinary << 2));
+    size_t position = value_.size();
+    value_.resize(position + 4);
+    writeUnsigned(value_.data() + position, value.size(), 4);
+    value_.insert(value_.end(), value.begin(), value.end());
+    endValue();
+}
+
+void VariantBuilder::appendUuid(const uint8_t (&bytes)[16])
+{
+    appendPrimitive(kUuid, bytes, 16);
+}
+
+void VariantBuilder::appendVariant(const VariantView &value)
+{
+    switch (value.type())
+    {
+    case VariantType::OBJECT:
+        beginObject();
+        for (size_t i = 0; i < value.numElements(); ++i)
+        {
+            key(value.fieldKey(i));
+            appendVariant(value.fieldValue(i));
+        }
+        endObject();
+        break;
+    case VariantType::ARRAY:
+        beginArray();
+        for (size_t i = 0; i < value.numElements(); ++i)
+        {
+            appendVariant(value.element(i));
+        }
+        endArray();
+        break;
+    default:
+        // Scalars do not refer to the dictionary and are copied as is
+        size_t size = value.valueSize();
+        beginValue();
+        value_.insert(value_.end(), value.data(), value.data() + size);
+        endValue();
+    }
+}
+
+void VariantBuilder::beginObject()
+{
+    beginValue();
+    frames_.push_back({true, value_.size(), fields_.size(), false});
+}
+
+void VariantBuilder::key(std::string_view key)
+{
+    if (frames_.empty() || !frames_.back().is_object || frames_.back().has_key)
+    {
+        throw std::logic_error("key() is only allowed inside an object, before a field value");
+    }
+    auto it = key_ids_.find(key);
+    if (it == key_ids_.end())
+    {
+        widthFor(keys_.size() + 1);
+        it = key_ids_.emplace(std::string(key), static_cast<uint32_t>(keys_.size())).first;
+        keys_.emplace_back(key);
+    }
+    pending_key_ = it->second;
+    frames_.back().has_key = true;
+}
+
+void VariantBuilder::endObject()
+{
+    if (frames_.empty() || !frames_.back().is_object || frames_.back().has_key)
+    {
+        throw std::logic_error("endObject() without a matching beginObject() or with a key but no value");
+    }
+    Frame frame = frames_.back();
+    frames_.pop_back();
+
+    auto first = fields_.begin() + static_cast<ptrdiff_t>(frame.first);
+    std::sort(first, fields_.end(), [this](const Field &a, const Field &b)
+              { return keys_[a.id] < keys_[b.id]; });
+    uint32_t max_id = 0;
+    for (auto it = first; it != fields_.end(); ++it)
+    {
+        if (it != first && it->id == (it - 1)->id)
+        {
+            throw std::invalid_argument("Duplicate object key: " + keys_[it->id]);
+        }
+        max_id = std::max(max_id, it->id);
+    }
+
+    size_t num_fields = fields_.size() - frame.first;
+    size_t data_size = value_.size() - frame.start;
+    uint32_t id_size = widthFor(max_id);
+    uint32_t offset_size = widthFor(data_size);
+    bool large = num_fields > 0xFF;
+    uint32_t count_size = large ? 4 : 1;
+    size_t header_size = 1 + count_size + num_fields * id_size + (num_fields + 1) * offset_size;
+    value_.insert(value_.begin() + static_cast<ptrdiff_t>(frame.start), header_size, 0);
+
+    uint8_t *out = value_.data() + frame.start;
+    *out++ = objectHeader(offset_size, id_size, large);
+    writeUnsigned(out, num_fields, count_size);
+    out += count_size;
+    for (auto it = first; it != fields_.end(); ++it)
+    {
+        writeUnsigned(out, it->id, id_size);
+        out += id_size;
+    }
+    for (auto it = first; it != fields_.end(); ++it)
+    {
+        writeUnsigned(out, it->offset, offset_size);
+        out += offset_size;
+    }
+    writeUnsigned(out, data_size, offset_size);
+    fields_.resize(frame.first);
+    endValue();
+}
+
+void VariantBuilder::beginArray()
+{
+    beginValue();
+    frames_.push_back({false, value_.size(), elements_.size(), false});
+}
+
+void VariantBuilder::endArray()
+{
+    if (frames_.empty() || frames_.back().is_object)
+    {
+        throw std::logic_error("endArray() without a matching beginArray()");
+    }
+    Frame frame = frames_.back();
+    frames_.pop_back();
+
+    size_t num_elements = elements_.size() - frame.first;
+    size_t data_size = value_.size() - frame.start;
+    uint32_t offset_size = widthFor(data_size);
+    bool large = num_elements > 0xFF;
+    uint32_t count_size = large ? 4 : 1;
+    size_t header_size = 1 + count_size + (num_elements + 1) * offset_size;
+    value_.insert(value_.begin() + static_cast<ptrdiff_t>(frame.start), header_size, 0);
+
+    uint8_t *out = value_.data() + frame.start;
+    *out++ = static_cast<uint8_t>(kArray | (((offset_size - 1) | (large ? 0x04 : 0)) << 2));
+    writeUnsigned(out, num_elements, count_size);
+    out += count_size;
+    for (size_t i = frame.first; i < elements_.size(); ++i)
+    {
+        writeUnsigned(out, elements_[i], offset_size);
+        out += offset_size;
+    }
+    writeUnsigned(out, data_size, offset_size);
+    elements_.resize(frame.first);
+    endValue();
+}
+
+Variant VariantBuilder::finish()
+{
+    if (!complete_ || !frames_.empty())
+    {
+        throw std::logic_error("finish() needs exactly one complete value");
+    }
+    size_t strings_size = 0;
+    for (const std::string &key : keys_)
+    {
+        strings_size += key.size();
+    }
+    bool sorted = std::is_sorted(keys_.begin(), keys_.end());
+    uint32_t offset_size = widthFor(std::max(strings_size, keys_.size()));
+
+    Variant variant;
+    variant.metadata.resize(1 + offset_size + (keys_.size() + 1) * offset_size + strings_size);
+    uint8_t *out = variant.metadata.data();
+    *out++ = static_cast<uint8_t>(1 | (sorted ? 0x10 : 0) | ((offset_size - 1) << 6));
+    writeUnsigned(out, keys_.size(), offset_size);
+    out += offset_size;
+    size_t offset = 0;
+    for (const std::string &key : keys_)
+    {
+        writeUnsigned(out, offset, offset_size);
+        out += offset_size;
+        offset += key.size();
+    }
+    writeUnsigned(out, offset, offset_size);
+    out += offset_size;
+    for (const std::string &key : keys_)
+    {
+        std::memcpy(out, key.data(), key.size());
+        out += key.size();
+    }
+    variant.value.assign(value_.begin(), value_.end());
+
+    value_.clear();
+    keys_.clear();
+    key_ids_.clear();
+    complete_ = false;
+    return variant;
+}
+
+void encodeVariantObject(const std::vector<std::pair<uint32_t, std::string_view>> &fields, std::vector<uint8_t> &out)
+{
+    uint32_t max_id = 0;
+    size_t data_size = 0;
+    for (const auto &[id, value] : fields)
+    {
+        max_id = std::max(max_id, id);
+        data_size += value.size();
+    }
+    uint32_t id_size = widthFor(max_id);
+    uint32_t offset_size = widthFor(data_size);
+    bool large = fields.size() > 0xFF;
+    uint32_t count_size = large ? 4 : 1;
+    size_t start = out.size();
+    out.resize(start + 1 + count_size + fields.size() * id_size + (fields.size() + 1) * offset_size);
+    uint8_t *header = out.data() + start;
+    *header++ = objectHeader(offset_size, id_size, large);
+    writeUnsigned(header, fields.size(), count_size);
+    header += count_size;
+    for (const auto &field : fields)
+    {
+        writeUnsigned(header, field.first, id_size);
+        header += id_size;
+    }
+    size_t offset = 0;
+    for (const auto &field : fields)
+    {
+        writeUnsigned(header, offset, offset_size);
+        header += offset_size;
+        offset += field.second.size();
+    }
+    writeUnsigned(header, offset, offset_size);
+    for (const auto &field : fields)
+    {
+        out.insert(out.end(), field.second.begin(), field.second.end());
+    }
+}
+
+void VariantBuilder::appendJson(std::string_view json)
+{
+    JsonParser(json, *this).parse();
+}
+
+Variant variantFromJson(std::string_view json)
+{
+    VariantBuilder builder;
+    builder.appendJson(json);
+    return builder.finish();
+}
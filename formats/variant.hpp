@@ -0,0 +1,373 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "parquet.hpp"
+
+// Variant binary encoding for semi-structured data:
+// https://github.com/apache/parquet-format/blob/master/VariantEncoding.md
+//
+// A variant is a pair of buffers: the metadata (a dictionary of the object keys) and the
+// value, which refers to keys by their index in the dictionary. Corrupt buffers raise
+// ParquetException, like any other undecodable Parquet data.
+
+enum class VariantType
+{
+    NULL_VALUE,
+    BOOLEAN,
+    INT8,
+    INT16,
+    INT32,
+    INT64,
+    DOUBLE,
+    DECIMAL4,
+    DECIMAL8,
+    DECIMAL16,
+
+    /// Days since the Unix epoch
+    DATE,
+
+    /// Microseconds since the Unix epoch, UTC adjusted (TIMESTAMP) or local (TIMESTAMP_NTZ)
+    TIMESTAMP,
+    TIMESTAMP_NTZ,
+
+    FLOAT,
+    BINARY,
+    STRING,
+
+    /// Microseconds since midnight
+    TIME_NTZ,
+
+    /// Nanoseconds since the Unix epoch
+    TIMESTAMP_NANOS,
+    TIMESTAMP_NANOS_NTZ,
+
+    UUID,
+    OBJECT,
+    ARRAY
+};
+
+struct VariantDecimal
+{
+    __int128 unscaled = 0;
+    uint8_t scale = 0;
+};
+
+/**
+ * @brief A view over a variant metadata buffer, which must outlive it.
+ */
+class VariantMetadata
+{
+public:
+    /**
+     * @throws ParquetException for an unsupported version or a truncated buffer
+     */
+    VariantMetadata(const uint8_t *data, size_t size);
+
+    const uint8_t *data() const noexcept { return data_; }
+    size_t byteSize() const noexcept { return size_; }
+
+    /**
+     * @brief Number of keys in the dictionary.
+     */
+    size_t size() const noexcept { return dictionary_size_; }
+
+    /**
+     * @brief Whether the keys are unique and sorted, which makes find() a binary search.
+     */
+    bool sorted() const noexcept { return sorted_; }
+
+    /**
+     * @throws ParquetException if the id is not in the dictionary
+     */
+    std::string_view key(uint32_t id) const;
+
+    std::optional<uint32_t> find(std::string_view key) const;
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+    uint32_t offset_size_;
+    uint32_t dictionary_size_;
+    bool sorted_;
+    const uint8_t *offsets_;
+    const uint8_t *strings_;
+    size_t strings_size_;
+};
+
+/**
+ * @brief A parsed path into a variant: `$` followed by `.key`, `['key']` and `[index]`
+ * steps, e.g. `$.a.b[3].c`.
+ */
+class VariantPath
+{
+public:
+    struct Step
+    {
+        std::string key;
+
+        /// Array index, used when `key` is empty and is_index is set
+        size_t index = 0;
+        bool is_index = false;
+    };
+
+    /**
+     * @throws std::invalid_argument for malformed paths
+     */
+    explicit VariantPath(std::string_view path);
+
+    const std::vector<Step> &steps() const noexcept { return steps_; }
+
+private:
+    std::vector<Step> steps_;
+};
+
+/**
+ * @brief A zero-copy view over one variant value, e.g. a whole variant or a field of an
+ * object. Both buffers must outlive the view.
+ *
+ * Objects keep their fields sorted by key, so field() is a binary search; arrays keep an
+ * offset per element, so element() is constant time. Nothing is validated up front, the
+ * bytes are checked as they are accessed.
+ *
+ * The get* accessors throw std::logic_error when called on a value of another type.
+ */
+class VariantView
+{
+public:
+    /**
+     * @param size Bytes available at `value`; the value itself may be shorter
+     * @throws ParquetException if `size` is 0
+     */
+    VariantView(const VariantMetadata &metadata, const uint8_t *value, size_t size);
+
+    const VariantMetadata &metadata() const noexcept { return metadata_; }
+    const uint8_t *data() const noexcept { return value_; }
+
+    VariantType type() const;
+
+    /**
+     * @brief Size of the encoded value in bytes.
+     */
+    size_t valueSize() const;
+
+    bool isNull() const;
+    bool getBool() const;
+
+    /**
+     * @brief The value of any integer type, or the raw integer of a DATE, TIME_NTZ or
+     * timestamp.
+     */
+    int64_t getInt() const;
+
+    /**
+     * @brief The value of a DOUBLE or FLOAT.
+     */
+    double getDouble() const;
+
+    VariantDecimal getDecimal() const;
+
+    std::string_view getString() const;
+
+    /**
+     * @brief The bytes of a BINARY, or the 16 big-endian bytes of a UUID.
+     */
+    std::string_view getBinary() const;
+
+    /**
+     * @brief Number of fields of an object or elements of an array.
+     */
+    size_t numElements() const;
+
+    /**
+     * @return The field's value, or nothing if there is no such field or this is not an
+     * object
+     */
+    std::optional<VariantView> field(std::string_view key) const;
+
+    /**
+     * @brief Key and value of the i-th field of an object, in key order.
+     * @throws std::out_of_range if i >= numElements()
+     */
+    std::string_view fieldKey(size_t i) const;
+    uint32_t fieldId(size_t i) const;
+    VariantView fieldValue(size_t i) const;
+
+    /**
+     * @throws std::out_of_range if i >= numElements()
+     */
+    VariantView element(size_t i) const;
+
+    /**
+     * @return The value at the path, or nothing if a step does not match (missing field,
+     * index out of bounds or a value of another type)
+     */
+    std::optional<VariantView> find(const VariantPath &path) const;
+
+    /**
+     * @brief Renders the value as JSON. Dates, times, timestamps and UUIDs become strings,
+     * binary values base64 strings and non-finite floats the strings "NaN", "Infinity"
+     * and "-Infinity".
+     */
+    std::string toJson() const;
+
+private:
+    struct Container
+    {
+        uint32_t num_elements;
+        uint32_t id_size;
+        uint32_t offset_size;
+        const uint8_t *ids;
+        const uint8_t *offsets;
+        const uint8_t *values;
+        size_t values_size;
+    };
+
+    int basicType() const noexcept { return value_[0] & 3; }
+    Container container(int basic_type) const;
+    VariantView child(const Container &container, size_t i) const;
+    const uint8_t *primitiveData(size_t size) const;
+    void appendJson(std::string &out, int depth) const;
+
+    VariantMetadata metadata_;
+    const uint8_t *value_;
+    size_t size_;
+};
+
+/**
+ * @brief The two buffers of an encoded variant.
+ */
+struct Variant
+{
+    std::vector<uint8_t> metadata;
+    std::vector<uint8_t> value;
+
+    /**
+     * @throws ParquetException if a buffer is corrupt
+     */
+    VariantView view() const;
+};
+
+/**
+ * @brief Encodes one variant value at a time.
+ *
+ * Values are appended in document order: scalars directly, objects between beginObject()
+ * and endObject() with a key() before each field, arrays between beginArray() and
+ * endArray(). Keys are deduplicated into the metadata dictionary, and the fields of each
+ * object are sorted by key when the object ends. finish() returns the variant and resets
+ * the builder, which keeps its memory for the next value.
+ *
+ * Misuse (a value where a key is expected, unbalanced containers) throws
+ * std::logic_error, a key appearing twice in one object std::invalid_argument.
+ */
+class VariantBuilder
+{
+public:
+    void appendNull();
+    void appendBool(bool value);
+
+    /**
+     * @brief Appends an integer with the narrowest integer type that holds it.
+     */
+    void appendInt(int64_t value);
+
+    void appendDouble(double value);
+    void appendFloat(float value);
+
+    /**
+     * @brief Appends a decimal with the narrowest decimal type that holds it.
+     * @throws std::invalid_argument if the scale is above 38
+     */
+    void appendDecimal(__int128 unscaled, uint8_t scale);
+
+    void appendDate(int32_t days);
+    void appendTimestamp(int64_t micros, bool adjusted_to_utc = true);
+    void appendTimestampNanos(int64_t nanos, bool adjusted_to_utc = true);
+    void appendTime(int64_t micros);
+    void appendString(std::string_view value);
+    void appendBinary(std::string_view value);
+    void appendUuid(const uint8_t (&bytes)[16]);
+
+    /**
+     * @brief Copies a value of another variant, re-mapping its keys to this builder's
+     * dictionary.
+     */
+    void appendVariant(const VariantView &value);
+
+    /**
+     * @brief Appends the value of a JSON document, see variantFromJson().
+     * @throws std::invalid_argument for malformed JSON
+     */
+    void appendJson(std::string_view json);
+
+    void beginObject();
+    void key(std::string_view key);
+    void endObject();
+
+    void beginArray();
+    void endArray();
+
+    /**
+     * @throws std::logic_error unless exactly one complete value was appended
+     */
+    Variant finish();
+
+private:
+    struct Field
+    {
+        uint32_t id;
+        size_t offset;
+    };
+
+    struct Frame
+    {
+        bool is_object;
+        size_t start;
+
+        // Index of the frame's first entry in fields_ or elements_
+        size_t first;
+        bool has_key;
+    };
+
+    struct KeyHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view key) const noexcept { return std::hash<std::string_view>()(key); }
+    };
+
+    void beginValue();
+    void endValue() noexcept;
+    void appendPrimitive(int type_id, const void *data, size_t size);
+
+    std::vector<uint8_t> value_;
+    std::vector<std::string> keys_;
+    std::unordered_map<std::string, uint32_t, KeyHash, std::equal_to<>> key_ids_;
+    std::vector<Frame> frames_;
+    std::vector<Field> fields_;
+    std::vector<size_t> elements_;
+    uint32_t pending_key_ = 0;
+    bool complete_ = false;
+};
+
+/**
+ * @brief Encodes an object from values that are already encoded against a metadata
+ * dictionary, as when shredded fields are put back together.
+ * @param fields Key id and encoded value of every field, sorted by key
+ */
+void encodeVariantObject(const std::vector<std::pair<uint32_t, std::string_view>> &fields, std::vector<uint8_t> &out);
+
+/**
+ * @brief Parses JSON text into a variant. Integers that fit int64 become integers, other
+ * numbers doubles.
+ * @throws std::invalid_argument for malformed JSON, duplicate keys or nesting deeper
+ * than 1000 levels
+ */
+Variant variantFromJson(std::string_view json);
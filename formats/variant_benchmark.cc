@@ -0,0 +1,118 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "variant.hpp"
+
+// Extracting `$.a.b[3].c` from JSON events, either by parsing the JSON text of every
+// event or by navigating the variant encoding of the events. The events (1M by default,
+// VARIANT_BENCHMARK_EVENTS overrides it) are generated once per process and kept back
+// to back in one buffer per representation, like the pages of a column.
+
+namespace
+{
+    struct Events
+    {
+        std::string json;
+        std::vector<size_t> json_offsets{0};
+        std::vector<uint8_t> metadata;
+        std::vector<size_t> metadata_offsets{0};
+        std::vector<uint8_t> values;
+        std::vector<size_t> value_offsets{0};
+
+        size_t size() const noexcept { return json_offsets.size() - 1; }
+    };
+
+    std::string makeEvent(std::mt19937_64 &rng, size_t i)
+    {
+        static const char *kCountries[] = {"US", "DE", "FR", "JP", "BR"};
+        std::string event = "{\"id\":" + std::to_string(i) + ",\"ts\":\"2024-05-" + std::to_string(10 + rng() % 20) +
+                            "T12:00:00Z\",\"user\":{\"name\":\"user" + std::to_string(rng() % 100000) +
+                            "\",\"country\":\"" + kCountries[rng() % 5] + "\",\"premium\":" +
+                            (rng() % 2 ? "true" : "false") + "},\"a\":{\"kind\":\"click\",\"b\":[";
+        size_t elements = 4 + rng() % 4;
+        for (size_t e = 0; e < elements; ++e)
+        {
+            event += (e ? ",{\"c\":" : "{\"c\":") + std::to_string(rng() % 1000) + ",\"w\":" +
+                     std::to_string(static_cast<double>(rng() % 10000) / 100) + "}";
+        }
+        event += "]},\"tags\":[\"t" + std::to_string(rng() % 50) + "\",\"t" + std::to_string(rng() % 50) + "\"]}";
+        return event;
+    }
+
+    const Events &events()
+    {
+        static Events events = []()
+        {
+            const char *count = std::getenv("VARIANT_BENCHMARK_EVENTS");
+            size_t num_events = count ? std::strtoull(count, nullptr, 10) : 1000000;
+            Events events;
+            std::mt19937_64 rng(42);
+            VariantBuilder builder;
+            for (size_t i = 0; i < num_events; ++i)
+            {
+                std::string event = makeEvent(rng, i);
+                events.json += event;
+                events.json_offsets.push_back(events.json.size());
+                builder.appendJson(event);
+                Variant variant = builder.finish();
+                events.metadata.insert(events.metadata.end(), variant.metadata.begin(), variant.metadata.end());
+                events.metadata_offsets.push_back(events.metadata.size());
+                events.values.insert(events.values.end(), variant.value.begin(), variant.value.end());
+                events.value_offsets.push_back(events.values.size());
+            }
+            return events;
+        }();
+        return events;
+    }
+} // namespace
+
+static void BM_ExtractFromJson(benchmark::State &state)
+{
+    const Events &input = events();
+    VariantPath path("$.a.b[3].c");
+    VariantBuilder builder;
+    for (auto _ : state)
+    {
+        int64_t sum = 0;
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            builder.appendJson(std::string_view(input.json).substr(input.json_offsets[i],
+                                                                   input.json_offsets[i + 1] - input.json_offsets[i]));
+            Variant variant = builder.finish();
+            sum += variant.view().find(path)->getInt();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.json.size()));
+}
+
+static void BM_ExtractFromVariant(benchmark::State &state)
+{
+    const Events &input = events();
+    VariantPath path("$.a.b[3].c");
+    for (auto _ : state)
+    {
+        int64_t sum = 0;
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            VariantMetadata metadata(input.metadata.data() + input.metadata_offsets[i],
+                                     input.metadata_offsets[i + 1] - input.metadata_offsets[i]);
+            VariantView view(metadata, input.values.data() + input.value_offsets[i],
+                             input.value_offsets[i + 1] - input.value_offsets[i]);
+            sum += view.find(path)->getInt();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * (input.metadata.size() + input.values.size())));
+}
+
+BENCHMARK(BM_ExtractFromJson)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ExtractFromVariant)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
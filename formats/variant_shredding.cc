@@ -0,0 +1,757 @@
+#include "variant_shredding.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+
+// One level of the layout: a field (or the variant itself) with its value column and
+// either a typed_value column or the levels of its shredded fields
+struct ShreddedColumn
+{
+    static constexpr size_t kNoColumn = SIZE_MAX;
+
+    std::string name;
+
+    /// Definition level at which the level's group is present
+    int16_t level = 0;
+
+    size_t value_column = kNoColumn;
+    std::optional<AtomicType> type;
+    size_t typed_column = kNoColumn;
+
+    /// Sorted by name
+    std::vector<ShreddedColumn> fields;
+};
+
+namespace
+{
+    bool isSupportedType(AtomicType type)
+    {
+        return type == AtomicType::INT64 || type == AtomicType::DOUBLE || type == AtomicType::BYTE_ARRAY ||
+               type == AtomicType::BOOLEAN;
+    }
+
+    // The typed_value type a variant value is shredded into, if any
+    std::optional<AtomicType> typeFamily(VariantType type)
+    {
+        switch (type)
+        {
+        case VariantType::INT8:
+        case VariantType::INT16:
+        case VariantType::INT32:
+        case VariantType::INT64:
+            return AtomicType::INT64;
+        case VariantType::DOUBLE:
+            return AtomicType::DOUBLE;
+        case VariantType::STRING:
+            return AtomicType::BYTE_ARRAY;
+        case VariantType::BOOLEAN:
+            return AtomicType::BOOLEAN;
+        default:
+            return std::nullopt;
+        }
+    }
+
+    std::string_view encoded(const VariantView &value)
+    {
+        return std::string_view(reinterpret_cast<const char *>(value.data()), value.valueSize());
+    }
+
+    // Appends a variant value to a batch of its type family
+    void appendTyped(ColumnBatch &batch, const VariantView &value)
+    {
+        switch (batch.type())
+        {
+        case AtomicType::INT64:
+            *batch.appendValues<int64_t>(1) = value.getInt();
+            break;
+        case AtomicType::DOUBLE:
+            *batch.appendValues<double>(1) = value.getDouble();
+            break;
+        case AtomicType::BOOLEAN:
+            *batch.appendValues<uint8_t>(1) = value.getBool();
+            break;
+        default:
+        {
+            std::string_view string = value.getString();
+            batch.appendByteArray(reinterpret_cast<const uint8_t *>(string.data()), string.size());
+        }
+        }
+    }
+
+    std::string_view bytesAt(const ColumnBatch &batch, size_t i)
+    {
+        if (batch.isDictionaryEncoded())
+        {
+            return batch.dictionary()->byteArray(static_cast<size_t>(batch.indices()[i]));
+        }
+        return batch.byteArray(i);
+    }
+
+    template <typename T>
+    T valueAt(const ColumnBatch &batch, size_t i)
+    {
+        if (batch.isDictionaryEncoded())
+        {
+            return batch.dictionary()->value<T>(static_cast<size_t>(batch.indices()[i]));
+        }
+        return batch.value<T>(i);
+    }
+
+    // Appends the variant encoding of slot i of a typed_value batch
+    void appendScalar(VariantBuilder &builder, const ColumnBatch &batch, size_t i)
+    {
+        switch (batch.type())
+        {
+        case AtomicType::INT64:
+            builder.appendInt(valueAt<int64_t>(batch, i));
+            break;
+        case AtomicType::DOUBLE:
+            builder.appendDouble(valueAt<double>(batch, i));
+            break;
+        case AtomicType::BOOLEAN:
+            builder.appendBool(valueAt<uint8_t>(batch, i) != 0);
+            break;
+        default:
+            builder.appendString(bytesAt(batch, i));
+        }
+    }
+
+    void addFields(const std::vector<ShreddedField> &fields, std::vector<SchemaElement> &schema)
+    {
+        for (size_t i = 0; i < fields.size(); ++i)
+        {
+            const ShreddedField &field = fields[i];
+            if (i > 0 && fields[i - 1].name >= field.name)
+            {
+                throw std::invalid_argument("Shredded fields must be sorted by name and unique: " + field.name);
+            }
+            if (field.type ? !isSupportedType(*field.type) || !field.fields.empty() : field.fields.empty())
+            {
+                throw std::invalid_argument("Shredded field " + field.name +
+                                            " needs either a supported type or shredded fields");
+            }
+            SchemaElement group;
+            group.name = field.name;
+            group.repetition_type = FieldRepetitionType::REQUIRED;
+            group.num_children = 2;
+            schema.push_back(std::move(group));
+
+            SchemaElement value;
+            value.name = "value";
+            value.type = AtomicType::BYTE_ARRAY;
+            value.repetition_type = FieldRepetitionType::OPTIONAL;
+            schema.push_back(std::move(value));
+
+            SchemaElement typed;
+            typed.name = "typed_value";
+            typed.repetition_type = FieldRepetitionType::OPTIONAL;
+            if (field.type)
+            {
+                typed.type = *field.type;
+                schema.push_back(std::move(typed));
+            }
+            else
+            {
+                typed.num_children = static_cast<int32_t>(field.fields.size());
+                schema.push_back(std::move(typed));
+                addFields(field.fields, schema);
+            }
+        }
+    }
+
+    // Builds the level at `prefix` from the leaf columns of a file
+    ShreddedColumn buildColumn(const std::vector<ColumnDescriptor> &columns, std::vector<std::string> prefix,
+                               int16_t level)
+    {
+        ShreddedColumn node;
+        node.name = prefix.size() > 1 ? prefix.back() : std::string();
+        node.level = level;
+        std::map<std::string, bool> fields;
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            const std::vector<std::string> &path = columns[i].path;
+            if (path.size() <= prefix.size() || !std::equal(prefix.begin(), prefix.end(), path.begin()))
+            {
+                continue;
+            }
+            const std::string &child = path[prefix.size()];
+            if (child == "value" && path.size() == prefix.size() + 1)
+            {
+                if (columns[i].type != AtomicType::BYTE_ARRAY)
+                {
+                    throw ParquetException("Variant value column " + columns[i].dottedPath() + " is not binary");
+                }
+                node.value_column = i;
+            }
+            else if (child == "typed_value" && path.size() == prefix.size() + 1)
+            {
+                if (!isSupportedType(columns[i].type))
+                {
+                    throw ParquetException("Unsupported shredded type of column " + columns[i].dottedPath());
+                }
+                node.type = columns[i].type;
+                node.typed_column = i;
+            }
+            else if (child == "typed_value" && path.size() > prefix.size() + 2)
+            {
+                fields[path[prefix.size() + 1]] = true;
+            }
+        }
+        if (node.type && !fields.empty())
+        {
+            throw ParquetException("Shredded variant column has a typed_value that is both a leaf and a group");
+        }
+        if (node.value_column == ShreddedColumn::kNoColumn && !node.type && fields.empty())
+        {
+            throw ParquetException("Shredded variant field " + node.name + " has neither value nor typed_value");
+        }
+        prefix.push_back("typed_value");
+        for (const auto &field : fields)
+        {
+            prefix.push_back(field.first);
+            node.fields.push_back(buildColumn(columns, prefix, static_cast<int16_t>(level + 1)));
+            prefix.pop_back();
+        }
+        return node;
+    }
+
+    std::vector<ShreddedField> schemaOf(const std::vector<ShreddedColumn> &columns)
+    {
+        std::vector<ShreddedField> fields;
+        for (const ShreddedColumn &column : columns)
+        {
+            fields.push_back({column.name, column.type, schemaOf(column.fields)});
+        }
+        return fields;
+    }
+
+    struct FieldStats
+    {
+        // Occurrences per type family, objects counted under OBJECT
+        std::map<std::optional<AtomicType>, size_t> scalars;
+        std::vector<VariantView> objects;
+    };
+
+    std::vector<ShreddedField> inferFields(const std::vector<VariantView> &sample, size_t depth,
+                                           const ShreddingOptions &options, size_t &columns)
+    {
+        std::map<std::string, FieldStats, std::less<>> stats;
+        for (const VariantView &value : sample)
+        {
+            if (value.type() != VariantType::OBJECT)
+            {
+                continue;
+            }
+            for (size_t i = 0; i < value.numElements(); ++i)
+            {
+                FieldStats &field = stats[std::string(value.fieldKey(i))];
+                VariantView field_value = value.fieldValue(i);
+                if (field_value.type() == VariantType::OBJECT)
+                {
+                    field.objects.push_back(field_value);
+                }
+                else
+                {
+                    ++field.scalars[typeFamily(field_value.type())];
+                }
+            }
+        }
+
+        // Candidates by frequency: name, occurrences and type (unset for objects)
+        struct Candidate
+        {
+            std::string name;
+            size_t count;
+            std::optional<AtomicType> type;
+        };
+        std::vector<Candidate> candidates;
+        auto threshold = static_cast<size_t>(options.min_frequency * static_cast<double>(sample.size()));
+        for (const auto &[name, field] : stats)
+        {
+            Candidate best{name, field.objects.size(), std::nullopt};
+            for (const auto &[type, count] : field.scalars)
+            {
+                if (type && count > best.count)
+                {
+                    best = {name, count, type};
+                }
+            }
+            if (best.count > 0 && best.count >= threshold)
+            {
+                candidates.push_back(std::move(best));
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b)
+                         { return a.count > b.count; });
+
+        std::vector<ShreddedField> fields;
+        for (const Candidate &candidate : candidates)
+        {
+            if (columns >= options.max_columns)
+            {
+                break;
+            }
+            ShreddedField field;
+            field.name = candidate.name;
+            if (candidate.type)
+            {
+                field.type = candidate.type;
+                ++columns;
+            }
+            else if (depth < options.max_depth)
+            {
+                // Nested frequencies are relative to the whole sample
+                std::vector<VariantView> objects = stats.find(candidate.name)->second.objects;
+                size_t total = sample.size();
+                ShreddingOptions nested = options;
+                nested.min_frequency = objects.empty() ? 1 : options.min_frequency * static_cast<double>(total) /
+                                                                 static_cast<double>(objects.size());
+                field.fields = inferFields(objects, depth + 1, nested, columns);
+            }
+            if (field.type || !field.fields.empty())
+            {
+                fields.push_back(std::move(field));
+            }
+        }
+        std::sort(fields.begin(), fields.end(), [](const ShreddedField &a, const ShreddedField &b)
+                  { return a.name < b.name; });
+        return fields;
+    }
+
+    template <typename T>
+    bool overlaps(const Statistics &statistics, T min, T max)
+    {
+        if (statistics.min_value->size() != sizeof(T) || statistics.max_value->size() != sizeof(T))
+        {
+            return true;
+        }
+        T chunk_min;
+        T chunk_max;
+        std::memcpy(&chunk_min, statistics.min_value->data(), sizeof(T));
+        std::memcpy(&chunk_max, statistics.max_value->data(), sizeof(T));
+        return !(chunk_max < min || chunk_min > max);
+    }
+
+    // Rebuilds the value of one level for one row; false if the level has no value
+    bool rebuild(const ShreddedColumn &node, size_t row, const VariantMetadata &metadata,
+                 const std::vector<std::unique_ptr<ColumnBatch>> &batches, VariantBuilder &scalars,
+                 std::vector<uint8_t> &out)
+    {
+        std::optional<std::string_view> value;
+        if (node.value_column != ShreddedColumn::kNoColumn && batches[node.value_column]->isValid(row))
+        {
+            value = bytesAt(*batches[node.value_column], row);
+        }
+        if (node.type)
+        {
+            const ColumnBatch &typed = *batches[node.typed_column];
+            if (typed.isValid(row))
+            {
+                appendScalar(scalars, typed, row);
+                Variant scalar = scalars.finish();
+                out.insert(out.end(), scalar.value.begin(), scalar.value.end());
+                return true;
+            }
+        }
+        else
+        {
+            std::vector<std::pair<std::string_view, std::vector<uint8_t>>> shredded;
+            for (const ShreddedColumn &field : node.fields)
+            {
+                std::vector<uint8_t> bytes;
+                if (rebuild(field, row, metadata, batches, scalars, bytes))
+                {
+                    shredded.emplace_back(field.name, std::move(bytes));
+                }
+            }
+            if (!shredded.empty())
+            {
+                // Key, id and encoded value of every field of the object
+                std::vector<std::tuple<std::string_view, uint32_t, std::string_view>> fields;
+                if (value)
+                {
+                    VariantView residual(metadata, reinterpret_cast<const uint8_t *>(value->data()), value->size());
+                    if (residual.type() != VariantType::OBJECT)
+                    {
+                        throw ParquetException("Residual value of a shredded object is not an object");
+                    }
+                    for (size_t i = 0; i < residual.numElements(); ++i)
+                    {
+                        fields.emplace_back(residual.fieldKey(i), residual.fieldId(i), encoded(residual.fieldValue(i)));
+                    }
+                }
+                for (const auto &[name, bytes] : shredded)
+                {
+                    std::optional<uint32_t> id = metadata.find(name);
+                    if (!id)
+                    {
+                        throw ParquetException("Shredded field " + std::string(name) + " is not in the metadata");
+                    }
+                    fields.emplace_back(name, *id,
+                                        std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+                }
+                std::sort(fields.begin(), fields.end(), [](const auto &a, const auto &b)
+                          { return std::get<0>(a) < std::get<0>(b); });
+                std::vector<std::pair<uint32_t, std::string_view>> encoded_fields;
+                for (size_t i = 0; i < fields.size(); ++i)
+                {
+                    if (i > 0 && std::get<0>(fields[i]) == std::get<0>(fields[i - 1]))
+                    {
+                        throw ParquetException("Shredded field " + std::string(std::get<0>(fields[i])) +
+                                               " is also in the residual value");
+                    }
+                    encoded_fields.emplace_back(std::get<1>(fields[i]), std::get<2>(fields[i]));
+                }
+                encodeVariantObject(encoded_fields, out);
+                return true;
+            }
+        }
+        if (value)
+        {
+            out.insert(out.end(), value->begin(), value->end());
+            return true;
+        }
+        return false;
+    }
+} // namespace
+
+ShreddingSchema inferShreddingSchema(const std::vector<VariantView> &sample, const ShreddingOptions &options)
+{
+    size_t columns = 0;
+    return ShreddingSchema{inferFields(sample, 1, options, columns)};
+}
+
+std::vector<SchemaElement> shreddedSchema(const std::string &column, const ShreddingSchema &shredding)
+{
+    std::vector<SchemaElement> schema(2);
+    schema[0].name = "schema";
+    schema[0].num_children = 1;
+    schema[1].name = column;
+    schema[1].repetition_type = FieldRepetitionType::REQUIRED;
+    schema[1].num_children = shredding.fields.empty() ? 2 : 3;
+
+    SchemaElement metadata;
+    metadata.name = "metadata";
+    metadata.type = AtomicType::BYTE_ARRAY;
+    metadata.repetition_type = FieldRepetitionType::REQUIRED;
+    schema.push_back(std::move(metadata));
+
+    SchemaElement value;
+    value.name = "value";
+    value.type = AtomicType::BYTE_ARRAY;
+    value.repetition_type = FieldRepetitionType::OPTIONAL;
+    schema.push_back(std::move(value));
+
+    if (!shredding.fields.empty())
+    {
+        SchemaElement typed;
+        typed.name = "typed_value";
+        typed.repetition_type = FieldRepetitionType::OPTIONAL;
+        typed.num_children = static_cast<int32_t>(shredding.fields.size());
+        schema.push_back(std::move(typed));
+        addFields(shredding.fields, schema);
+    }
+    return schema;
+}
+
+ShreddedVariantWriter::ShreddedVariantWriter(const std::string &path, const std::string &column,
+                                             ShreddingSchema shredding, WriterOptions options)
+    : writer_(path, shreddedSchema(column, shredding), std::move(options))
+{
+    std::vector<ColumnDescriptor> columns = leafColumns(shreddedSchema(column, shredding));
+    root_ = std::make_unique<ShreddedColumn>(buildColumn(columns, {column}, 0));
+    for (const ColumnDescriptor &descriptor : columns)
+    {
+        batches_.emplace_back(descriptor.type);
+        levels_.emplace_back();
+        max_levels_.push_back(descriptor.max_definition_level);
+    }
+    metadata_column_ = 0;
+}
+
+ShreddedVariantWriter::~ShreddedVariantWriter() = default;
+
+void ShreddedVariantWriter::appendNull(size_t column, int16_t level)
+{
+    batches_[column].appendNulls(1);
+    levels_[column].push_back(level);
+}
+
+void ShreddedVariantWriter::appendBytes(size_t column, std::string_view bytes)
+{
+    batches_[column].appendByteArray(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+    levels_[column].push_back(max_levels_[column]);
+}
+
+void ShreddedVariantWriter::appendNulls(const ShreddedColumn &node, int16_t level)
+{
+    appendNull(node.value_column, level);
+    if (node.type)
+    {
+        appendNull(node.typed_column, level);
+    }
+    for (const ShreddedColumn &field : node.fields)
+    {
+        appendNulls(field, level);
+    }
+}
+
+void ShreddedVariantWriter::shred(const ShreddedColumn &node, const std::optional<VariantView> &value)
+{
+    if (!value)
+    {
+        appendNulls(node, node.level);
+        return;
+    }
+    if (node.type)
+    {
+        if (typeFamily(value->type()) == node.type)
+        {
+            appendNull(node.value_column, node.level);
+            appendTyped(batches_[node.typed_column], *value);
+            levels_[node.typed_column].push_back(max_levels_[node.typed_column]);
+        }
+        else
+        {
+            appendBytes(node.value_column, encoded(*value));
+            appendNull(node.typed_column, node.level);
+        }
+        return;
+    }
+
+    std::vector<std::optional<VariantView>> fields(node.fields.size());
+    bool shredded = false;
+    if (value->type() == VariantType::OBJECT)
+    {
+        for (size_t i = 0; i < node.fields.size(); ++i)
+        {
+            fields[i] = value->field(node.fields[i].name);
+            shredded = shredded || fields[i];
+        }
+    }
+    if (!shredded)
+    {
+        // Not an object, or none of the shredded fields: the whole value stays binary
+        appendBytes(node.value_column, encoded(*value));
+        for (const ShreddedColumn &field : node.fields)
+        {
+            appendNulls(field, node.level);
+        }
+        return;
+    }
+
+    // Both field lists are sorted by key, the residual is what the shredded list lacks
+    std::vector<std::pair<uint32_t, std::string_view>> residual;
+    size_t next = 0;
+    for (size_t i = 0; i < value->numElements(); ++i)
+    {
+        std::string_view key = value->fieldKey(i);
+        while (next < node.fields.size() && node.fields[next].name < key)
+        {
+            ++next;
+        }
+        if (next == node.fields.size() || node.fields[next].name != key)
+        {
+            residual.emplace_back(value->fieldId(i), encoded(value->fieldValue(i)));
+        }
+    }
+    if (residual.empty())
+    {
+        appendNull(node.value_column, node.level);
+    }
+    else
+    {
+        std::vector<uint8_t> bytes;
+        encodeVariantObject(residual, bytes);
+        appendBytes(node.value_column,
+                    std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size()));
+    }
+    for (size_t i = 0; i < node.fields.size(); ++i)
+    {
+        shred(node.fields[i], fields[i]);
+    }
+}
+
+void ShreddedVariantWriter::writeRowGroup(const std::vector<VariantView> &rows)
+{
+    for (size_t i = 0; i < batches_.size(); ++i)
+    {
+        batches_[i].clear();
+        levels_[i].clear();
+    }
+    for (const VariantView &row : rows)
+    {
+        const VariantMetadata &metadata = row.metadata();
+        appendBytes(metadata_column_,
+                    std::string_view(reinterpret_cast<const char *>(metadata.data()), metadata.byteSize()));
+        shred(*root_, row);
+    }
+
+    std::vector<const ColumnBatch *> batches;
+    std::vector<const int16_t *> levels;
+    for (size_t i = 0; i < batches_.size(); ++i)
+    {
+        batches.push_back(&batches_[i]);
+        levels.push_back(levels_[i].data());
+    }
+    writer_.writeRowGroup(batches, levels);
+}
+
+void ShreddedVariantWriter::close()
+{
+    writer_.close();
+}
+
+ShreddedVariantReader::ShreddedVariantReader(std::shared_ptr<const ParquetFileReader> file, const std::string &column)
+    : file_(std::move(file))
+{
+    const std::vector<ColumnDescriptor> &columns = file_->columns();
+    auto metadata = std::find_if(columns.begin(), columns.end(), [&column](const ColumnDescriptor &descriptor)
+                                 { return descriptor.path == std::vector<std::string>{column, "metadata"}; });
+    if (metadata == columns.end() || metadata->type != AtomicType::BYTE_ARRAY)
+    {
+        throw std::invalid_argument("No variant column " + column);
+    }
+    metadata_column_ = static_cast<size_t>(metadata - columns.begin());
+    root_ = std::make_unique<ShreddedColumn>(buildColumn(columns, {column}, 0));
+    shredding_.fields = schemaOf(root_->fields);
+}
+
+ShreddedVariantReader::~ShreddedVariantReader() = default;
+
+ColumnBatch ShreddedVariantReader::readColumn(size_t row_group, size_t column) const
+{
+    const ColumnDescriptor &descriptor = file_->columns()[column];
+    ColumnBatch batch(descriptor.type, descriptor.type_length);
+    ColumnChunkReader reader = file_->columnChunk(row_group, column);
+    while (reader.readBatch(batch, kDefaultBatchSize) > 0)
+    {
+    }
+    return batch;
+}
+
+std::vector<Variant> ShreddedVariantReader::readRowGroup(size_t row_group) const
+{
+    std::vector<std::unique_ptr<ColumnBatch>> batches(file_->columns().size());
+    const std::vector<std::string> &root_path = file_->columns()[metadata_column_].path;
+    for (size_t i = 0; i < batches.size(); ++i)
+    {
+        if (file_->columns()[i].path[0] == root_path[0])
+        {
+            batches[i] = std::make_unique<ColumnBatch>(readColumn(row_group, i));
+        }
+    }
+
+    const ColumnBatch &metadata_batch = *batches[metadata_column_];
+    std::vector<Variant> rows(metadata_batch.length());
+    VariantBuilder scalars;
+    for (size_t row = 0; row < rows.size(); ++row)
+    {
+        std::string_view metadata_bytes = bytesAt(metadata_batch, row);
+        rows[row].metadata.assign(metadata_bytes.begin(), metadata_bytes.end());
+        VariantMetadata metadata(rows[row].metadata.data(), rows[row].metadata.size());
+        if (!rebuild(*root_, row, metadata, batches, scalars, rows[row].value))
+        {
+            throw ParquetException("Variant row " + std::to_string(row) + " has neither value nor typed_value");
+        }
+    }
+    return rows;
+}
+
+const ShreddedColumn *ShreddedVariantReader::shreddedColumn(const VariantPath &path, AtomicType type) const
+{
+    const ShreddedColumn *node = root_.get();
+    for (const VariantPath::Step &step : path.steps())
+    {
+        if (step.is_index)
+        {
+            return nullptr;
+        }
+        auto it = std::lower_bound(node->fields.begin(), node->fields.end(), step.key,
+                                   [](const ShreddedColumn &field, const std::string &key)
+                                   { return field.name < key; });
+        if (it == node->fields.end() || it->name != step.key)
+        {
+            return nullptr;
+        }
+        node = &*it;
+    }
+    return node->type == type ? node : nullptr;
+}
+
+ColumnBatch ShreddedVariantReader::readPath(size_t row_group, const VariantPath &path, AtomicType type) const
+{
+    if (!isSupportedType(type))
+    {
+        throw std::invalid_argument("Variant paths can be read as INT64, DOUBLE, BYTE_ARRAY or BOOLEAN");
+    }
+    // Values of the shredded type family are never left in the binary value columns
+    if (const ShreddedColumn *node = shreddedColumn(path, type))
+    {
+        return readColumn(row_group, node->typed_column);
+    }
+
+    ColumnBatch batch(type);
+    for (const Variant &row : readRowGroup(row_group))
+    {
+        std::optional<VariantView> value = row.view().find(path);
+        if (value && typeFamily(value->type()) == type)
+        {
+            appendTyped(batch, *value);
+        }
+        else
+        {
+            batch.appendNulls(1);
+        }
+    }
+    return batch;
+}
+
+std::vector<size_t> ShreddedVariantReader::rowGroupsInRange(
+    const VariantPath &path, AtomicType type, const std::function<bool(const Statistics &)> &may_match) const
+{
+    const ShreddedColumn *node = shreddedColumn(path, type);
+    std::vector<size_t> row_groups;
+    for (size_t row_group = 0; row_group < numRowGroups(); ++row_group)
+    {
+        if (node)
+        {
+            const ColumnMetaData &metadata = file_->columnMetaData(row_group, node->typed_column);
+            if (metadata.statistics)
+            {
+                const Statistics &statistics = *metadata.statistics;
+                if (statistics.null_count && *statistics.null_count == metadata.num_values)
+                {
+                    continue;
+                }
+                if (statistics.min_value && statistics.max_value && !may_match(statistics))
+                {
+                    continue;
+                }
+            }
+        }
+        row_groups.push_back(row_group);
+    }
+    return row_groups;
+}
+
+std::vector<size_t> ShreddedVariantReader::rowGroupsInRange(const VariantPath &path, int64_t min, int64_t max) const
+{
+    return rowGroupsInRange(path, AtomicType::INT64, [min, max](const Statistics &statistics)
+                            { return overlaps(statistics, min, max); });
+}
+
+std::vector<size_t> ShreddedVariantReader::rowGroupsInRange(const VariantPath &path, double min, double max) const
+{
+    return rowGroupsInRange(path, AtomicType::DOUBLE, [min, max](const Statistics &statistics)
+                            { return overlaps(statistics, min, max); });
+}
+
+std::vector<size_t> ShreddedVariantReader::rowGroupsInRange(const VariantPath &path, std::string_view min,
+                                                            std::string_view max) const
+{
+    return rowGroupsInRange(path, AtomicType::BYTE_ARRAY, [min, max](const Statistics &statistics)
+                            { return !(*statistics.max_value < min || *statistics.min_value > max); });
+}
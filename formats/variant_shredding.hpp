@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "column_batch.hpp"
+#include "parquet_metadata.hpp"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+#include "variant.hpp"
+
+// Variant shredding: common fields of variant objects are stored in typed columns next
+// to the variant's residual value.
+// https://github.com/apache/parquet-format/blob/master/VariantShredding.md
+//
+// A shredded variant column `v` has this layout (shown for a field `a` shredded as an
+// integer and a field `b` shredded as an object with a string field `c`):
+//
+//   required group v {
+//     required binary metadata;
+//     optional binary value;
+//     optional group typed_value {
+//       required group a { optional binary value; optional int64 typed_value; }
+//       required group b {
+//         optional binary value;
+//         optional group typed_value {
+//           required group c { optional binary value; optional binary typed_value; }
+//         }
+//       }
+//     }
+//   }
+//
+// Every value column is encoded against the row's metadata. For a field, typed_value
+// holds values of the shredded type and value everything else; both are null when the
+// field is missing. For an object, typed_value holds the shredded fields and value the
+// others (a partially shredded object), or value holds the whole variant if it is not an
+// object or has none of the shredded fields.
+//
+// Values are shredded by type family: INT64 columns take every integer width, DOUBLE
+// columns doubles, BYTE_ARRAY columns strings and BOOLEAN columns booleans. Integers come
+// back with the narrowest width that holds them, as VariantBuilder writes them.
+
+struct ShreddedField
+{
+    std::string name;
+
+    /// Type of the field's typed_value column; unset for an object field, whose own
+    /// fields are shredded in turn
+    std::optional<AtomicType> type;
+    std::vector<ShreddedField> fields;
+};
+
+/**
+ * @brief The shredded fields of the top level object, sorted by name.
+ */
+struct ShreddingSchema
+{
+    std::vector<ShreddedField> fields;
+};
+
+/// The leaf columns of one level of a shredded variant column, see variant_shredding.cc
+struct ShreddedColumn;
+
+struct ShreddingOptions
+{
+    /// Share of the sampled variants a field must appear in, with one type family, to be
+    /// shredded
+    double min_frequency = 0.5;
+
+    /// Upper bound of the shredded (typed_value) columns
+    size_t max_columns = 256;
+
+    /// Depth of the nested objects whose fields are shredded as well, 1 for top level
+    /// fields only
+    size_t max_depth = 3;
+};
+
+/**
+ * @brief Picks the fields to shred from a sample of the data: the fields that appear
+ * often enough with one type family, most frequent first.
+ */
+ShreddingSchema inferShreddingSchema(const std::vector<VariantView> &sample, const ShreddingOptions &options = {});
+
+/**
+ * @brief The Parquet schema of a file holding one shredded variant column.
+ * @throws std::invalid_argument for unsupported shredded types, unsorted or duplicate
+ * field names, or object fields without fields
+ */
+std::vector<SchemaElement> shreddedSchema(const std::string &column, const ShreddingSchema &shredding);
+
+/**
+ * @brief Writes variants to a Parquet file with one shredded variant column.
+ */
+class ShreddedVariantWriter
+{
+public:
+    /**
+     * @throws std::invalid_argument for an invalid shredding schema
+     * @throws std::system_error if the file cannot be created
+     */
+    ShreddedVariantWriter(const std::string &path, const std::string &column, ShreddingSchema shredding,
+                          WriterOptions options = {});
+
+    ~ShreddedVariantWriter();
+
+    ShreddedVariantWriter(const ShreddedVariantWriter &) = delete;
+    ShreddedVariantWriter &operator=(const ShreddedVariantWriter &) = delete;
+
+    /**
+     * @brief Shreds the variants into one row group.
+     * @throws ParquetException if a variant is corrupt
+     * @throws std::system_error on I/O errors
+     */
+    void writeRowGroup(const std::vector<VariantView> &rows);
+
+    void close();
+
+private:
+    void appendNull(size_t column, int16_t level);
+    void appendBytes(size_t column, std::string_view bytes);
+    void appendNulls(const ShreddedColumn &node, int16_t level);
+    void shred(const ShreddedColumn &node, const std::optional<VariantView> &value);
+
+    ParquetFileWriter writer_;
+    std::unique_ptr<ShreddedColumn> root_;
+    size_t metadata_column_ = 0;
+    std::vector<ColumnBatch> batches_;
+    std::vector<std::vector<int16_t>> levels_;
+    std::vector<int16_t> max_levels_;
+};
+
+/**
+ * @brief Reads a shredded (or unshredded) variant column of a Parquet file.
+ *
+ * readRowGroup() rebuilds the variants. readPath() extracts the values of one path and
+ * type, and reads nothing but the typed_value column when the path is shredded with that
+ * type; other paths fall back to rebuilding the variants. rowGroupsInRange() prunes row
+ * groups with the statistics of the typed_value columns.
+ */
+class ShreddedVariantReader
+{
+public:
+    /**
+     * @throws std::invalid_argument if the file has no variant column of that name
+     * @throws ParquetException if the column's layout is malformed
+     */
+    ShreddedVariantReader(std::shared_ptr<const ParquetFileReader> file, const std::string &column);
+
+    ~ShreddedVariantReader();
+
+    const ShreddingSchema &shredding() const noexcept { return shredding_; }
+    size_t numRowGroups() const noexcept { return file_->numRowGroups(); }
+
+    /**
+     * @throws ParquetException for corrupt data
+     */
+    std::vector<Variant> readRowGroup(size_t row_group) const;
+
+    /**
+     * @brief The value at an object path (`$.a.b`, or with array steps when not
+     * shredded) of every row, as a batch of `type`: the values of its type family, null
+     * where the path is missing or holds another type.
+     * @param type INT64, DOUBLE, BYTE_ARRAY (strings) or BOOLEAN
+     * @throws std::invalid_argument for other types
+     * @throws ParquetException for corrupt data
+     */
+    ColumnBatch readPath(size_t row_group, const VariantPath &path, AtomicType type) const;
+
+    /**
+     * @brief The row groups that may hold a value in [min, max] of the matching type
+     * family at the path; all row groups unless the path is shredded with that type.
+     */
+    std::vector<size_t> rowGroupsInRange(const VariantPath &path, int64_t min, int64_t max) const;
+    std::vector<size_t> rowGroupsInRange(const VariantPath &path, double min, double max) const;
+    std::vector<size_t> rowGroupsInRange(const VariantPath &path, std::string_view min, std::string_view max) const;
+
+private:
+    const ShreddedColumn *shreddedColumn(const VariantPath &path, AtomicType type) const;
+    ColumnBatch readColumn(size_t row_group, size_t column) const;
+    std::vector<size_t> rowGroupsInRange(const VariantPath &path, AtomicType type,
+                                         const std::function<bool(const Statistics &)> &may_match) const;
+
+    std::shared_ptr<const ParquetFileReader> file_;
+    ShreddingSchema shredding_;
+    std::unique_ptr<ShreddedColumn> root_;
+    size_t metadata_column_ = 0;
+};
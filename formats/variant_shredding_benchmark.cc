@@ -0,0 +1,159 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "variant_shredding.hpp"
+
+// Projecting one hot field out of wide variant events (50 fields each), from a file where
+// the variant column is shredded with an inferred schema and from one where it is not, and
+// the same with a range predicate on a monotonically increasing field, which lets the
+// shredded file skip row groups by their statistics. The events (100K by default,
+// VARIANT_SHREDDING_BENCHMARK_EVENTS overrides it) are written once per process, 10K per
+// row group.
+
+namespace
+{
+    constexpr size_t kRowGroupSize = 10000;
+    constexpr size_t kNumFields = 50;
+
+    std::string makeEvent(std::mt19937_64 &rng, size_t i)
+    {
+        std::string event = "{\"seq\":" + std::to_string(i) + ",\"latency\":" + std::to_string(rng() % 5000);
+        for (size_t field = 2; field < kNumFields; ++field)
+        {
+            event += ",\"f" + std::to_string(field) + "\":";
+            switch (field % 3)
+            {
+            case 0:
+                event += std::to_string(rng() % 1000000);
+                break;
+            case 1:
+                event += "\"value" + std::to_string(rng() % 1000) + "\"";
+                break;
+            default:
+                event += std::to_string(static_cast<double>(rng() % 100000) / 100);
+            }
+        }
+        return event + "}";
+    }
+
+    struct Files
+    {
+        std::string shredded = "/tmp/variant_shredding_benchmark_shredded.parquet";
+        std::string unshredded = "/tmp/variant_shredding_benchmark_unshredded.parquet";
+        size_t num_events = 0;
+
+        ~Files()
+        {
+            std::remove(shredded.c_str());
+            std::remove(unshredded.c_str());
+        }
+    };
+
+    const Files &files()
+    {
+        static Files files = []()
+        {
+            const char *count = std::getenv("VARIANT_SHREDDING_BENCHMARK_EVENTS");
+            Files files;
+            files.num_events = count ? std::strtoull(count, nullptr, 10) : 100000;
+            std::mt19937_64 rng(42);
+            std::vector<Variant> events;
+            for (size_t i = 0; i < files.num_events; ++i)
+            {
+                events.push_back(variantFromJson(makeEvent(rng, i)));
+            }
+            std::vector<VariantView> sample;
+            for (size_t i = 0; i < std::min<size_t>(events.size(), 1000); ++i)
+            {
+                sample.push_back(events[i].view());
+            }
+            ShreddedVariantWriter shredded(files.shredded, "event", inferShreddingSchema(sample));
+            ShreddedVariantWriter unshredded(files.unshredded, "event", ShreddingSchema());
+            for (size_t first = 0; first < events.size(); first += kRowGroupSize)
+            {
+                std::vector<VariantView> rows;
+                for (size_t i = first; i < std::min(events.size(), first + kRowGroupSize); ++i)
+                {
+                    rows.push_back(events[i].view());
+                }
+                shredded.writeRowGroup(rows);
+                unshredded.writeRowGroup(rows);
+            }
+            shredded.close();
+            unshredded.close();
+            return files;
+        }();
+        return files;
+    }
+
+    int64_t sumColumn(const ColumnBatch &batch)
+    {
+        int64_t sum = 0;
+        for (size_t i = 0; i < batch.length(); ++i)
+        {
+            sum += batch.isValid(i) ? batch.value<int64_t>(i) : 0;
+        }
+        return sum;
+    }
+} // namespace
+
+static void BM_ProjectHotField(benchmark::State &state)
+{
+    const Files &input = files();
+    ShreddedVariantReader reader(
+        std::make_shared<const ParquetFileReader>(state.range(0) ? input.shredded : input.unshredded), "event");
+    VariantPath path("$.latency");
+    for (auto _ : state)
+    {
+        int64_t sum = 0;
+        for (size_t row_group = 0; row_group < reader.numRowGroups(); ++row_group)
+        {
+            sum += sumColumn(reader.readPath(row_group, path, AtomicType::INT64));
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * input.num_events));
+}
+
+static void BM_ProjectWithRangeFilter(benchmark::State &state)
+{
+    const Files &input = files();
+    ShreddedVariantReader reader(
+        std::make_shared<const ParquetFileReader>(state.range(0) ? input.shredded : input.unshredded), "event");
+    VariantPath path("$.latency");
+    VariantPath filter("$.seq");
+    // The last 5% of the events
+    auto min = static_cast<int64_t>(input.num_events - input.num_events / 20);
+    auto max = static_cast<int64_t>(input.num_events);
+    for (auto _ : state)
+    {
+        int64_t sum = 0;
+        for (size_t row_group : reader.rowGroupsInRange(filter, min, max))
+        {
+            ColumnBatch seq = reader.readPath(row_group, filter, AtomicType::INT64);
+            ColumnBatch latency = reader.readPath(row_group, path, AtomicType::INT64);
+            for (size_t i = 0; i < seq.length(); ++i)
+            {
+                if (seq.isValid(i) && seq.value<int64_t>(i) >= min && seq.value<int64_t>(i) <= max &&
+                    latency.isValid(i))
+                {
+                    sum += latency.value<int64_t>(i);
+                }
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * input.num_events));
+}
+
+BENCHMARK(BM_ProjectHotField)->ArgName("shredded")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ProjectWithRangeFilter)->ArgName("shredded")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "variant_shredding.hpp"
+
+namespace
+{
+    std::vector<Variant> parse(const std::vector<std::string> &documents)
+    {
+        std::vector<Variant> variants;
+        for (const std::string &document : documents)
+        {
+            variants.push_back(variantFromJson(document));
+        }
+        return variants;
+    }
+
+    std::vector<VariantView> views(const std::vector<Variant> &variants)
+    {
+        std::vector<VariantView> result;
+        for (const Variant &variant : variants)
+        {
+            result.push_back(variant.view());
+        }
+        return result;
+    }
+
+    std::string tempPath(const std::string &name)
+    {
+        return testing::TempDir() + "/" + name;
+    }
+
+    ShreddingSchema eventSchema()
+    {
+        ShreddingSchema shredding;
+        shredding.fields.push_back({"id", AtomicType::INT64, {}});
+        shredding.fields.push_back({"ok", AtomicType::BOOLEAN, {}});
+        ShreddedField user{"user", std::nullopt, {}};
+        user.fields.push_back({"name", AtomicType::BYTE_ARRAY, {}});
+        user.fields.push_back({"score", AtomicType::DOUBLE, {}});
+        shredding.fields.push_back(std::move(user));
+        return shredding;
+    }
+} // namespace
+
+TEST(VariantShreddingTest, RoundTripsMixedValues)
+{
+    std::vector<Variant> events = parse({
+        R"({"id":1,"ok":true,"user":{"name":"ada","score":1.5}})",
+        R"({"id":300000,"extra":[1,2],"user":{"name":"bob","age":3}})",
+        R"({"id":"not a number","user":"anonymous"})",
+        R"({"other":1})",
+        R"(42)",
+        R"(null)",
+        R"({"id":null,"ok":false,"user":{"score":-0.5,"tags":{"a":1}}})",
+        R"({})",
+        R"([{"id":1}])",
+    });
+    std::string path = tempPath("shredded.parquet");
+    ShreddedVariantWriter writer(path, "v", eventSchema());
+    writer.writeRowGroup(views(events));
+    writer.writeRowGroup(views(parse({R"({"id":7})"})));
+    writer.close();
+
+    auto file = std::make_shared<const ParquetFileReader>(path);
+    EXPECT_EQ(file->columns().size(), 11u);
+    ShreddedVariantReader reader(file, "v");
+    ASSERT_EQ(reader.shredding().fields.size(), 3u);
+    EXPECT_EQ(reader.shredding().fields[2].fields[1].type, AtomicType::DOUBLE);
+    ASSERT_EQ(reader.numRowGroups(), 2u);
+
+    std::vector<Variant> rows = reader.readRowGroup(0);
+    ASSERT_EQ(rows.size(), events.size());
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        EXPECT_EQ(rows[i].view().toJson(), events[i].view().toJson()) << i;
+    }
+    EXPECT_EQ(reader.readRowGroup(1)[0].view().toJson(), R"({"id":7})");
+
+    // Shredded paths are read from their typed_value column alone
+    ColumnBatch ids = reader.readPath(0, VariantPath("$.id"), AtomicType::INT64);
+    ASSERT_EQ(ids.length(), events.size());
+    EXPECT_EQ(ids.value<int64_t>(1), 300000);
+    EXPECT_FALSE(ids.isValid(2));
+    EXPECT_FALSE(ids.isValid(6));
+    ColumnBatch names = reader.readPath(0, VariantPath("$.user.name"), AtomicType::BYTE_ARRAY);
+    EXPECT_EQ(names.byteArray(1), "bob");
+    EXPECT_FALSE(names.isValid(2));
+
+    // Other paths and types rebuild the variants
+    ColumnBatch ages = reader.readPath(0, VariantPath("$.user.age"), AtomicType::INT64);
+    EXPECT_EQ(ages.value<int64_t>(1), 3);
+    EXPECT_EQ(ages.nullCount(), events.size() - 1);
+    ColumnBatch id_strings = reader.readPath(0, VariantPath("$.id"), AtomicType::BYTE_ARRAY);
+    EXPECT_EQ(id_strings.byteArray(2), "not a number");
+    EXPECT_EQ(reader.readPath(0, VariantPath("$[0].id"), AtomicType::INT64).value<int64_t>(8), 1);
+    EXPECT_THROW(reader.readPath(0, VariantPath("$.id"), AtomicType::INT32), std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+TEST(VariantShreddingTest, ReadsUnshreddedColumns)
+{
+    std::vector<Variant> events = parse({R"({"a":1})", R"("x")"});
+    std::string path = tempPath("unshredded.parquet");
+    ShreddedVariantWriter writer(path, "v", ShreddingSchema());
+    writer.writeRowGroup(views(events));
+    writer.close();
+
+    ShreddedVariantReader reader(std::make_shared<const ParquetFileReader>(path), "v");
+    EXPECT_TRUE(reader.shredding().fields.empty());
+    EXPECT_EQ(reader.readRowGroup(0)[1].view().getString(), "x");
+    EXPECT_EQ(reader.readPath(0, VariantPath("$.a"), AtomicType::INT64).value<int64_t>(0), 1);
+    EXPECT_EQ(reader.rowGroupsInRange(VariantPath("$.a"), int64_t{5}, int64_t{6}), std::vector<size_t>{0});
+    EXPECT_THROW(ShreddedVariantReader(std::make_shared<const ParquetFileReader>(path), "w"),
+                 std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+TEST(VariantShreddingTest, PrunesRowGroupsWithStatistics)
+{
+    std::string path = tempPath("pruned.parquet");
+    ShreddedVariantWriter writer(path, "v", eventSchema());
+    for (int group = 0; group < 4; ++group)
+    {
+        std::vector<std::string> documents;
+        for (int i = 0; i < 10; ++i)
+        {
+            int id = group * 10 + i;
+            documents.push_back(R"({"id":)" + std::to_string(id) + R"(,"user":{"name":"u)" +
+                                std::to_string(group) + R"(","score":)" + std::to_string(id) + ".5}}");
+        }
+        if (group == 3)
+        {
+            documents = {R"({"id":"x"})", R"(1)"};
+        }
+        writer.writeRowGroup(views(parse(documents)));
+    }
+    writer.close();
+
+    ShreddedVariantReader reader(std::make_shared<const ParquetFileReader>(path), "v");
+    EXPECT_EQ(reader.rowGroupsInRange(VariantPath("$.id"), int64_t{12}, int64_t{21}), (std::vector<size_t>{1, 2}));
+    EXPECT_EQ(reader.rowGroupsInRange(VariantPath("$.id"), int64_t{100}, int64_t{200}), std::vector<size_t>{});
+    EXPECT_EQ(reader.rowGroupsInRange(VariantPath("$.user.score"), 9.0, 10.0), std::vector<size_t>{0});
+    EXPECT_EQ(reader.rowGroupsInRange(VariantPath("$.user.name"), "u2", "u9"), std::vector<size_t>{2});
+    // Not shredded with that type: nothing can be pruned
+    EXPECT_EQ(reader.rowGroupsInRange(VariantPath("$.id"), 100.0, 200.0).size(), 4u);
+    EXPECT_EQ(reader.rowGroupsInRange(VariantPath("$.missing"), int64_t{0}, int64_t{0}).size(), 4u);
+    std::remove(path.c_str());
+}
+
+TEST(VariantShreddingTest, InfersFrequentFields)
+{
+    std::vector<std::string> documents;
+    for (int i = 0; i < 10; ++i)
+    {
+        std::string document = R"({"ts":)" + std::to_string(i * 1000) + R"(,"kind":"k","nested":{"depth":)" +
+                               std::to_string(i) + R"(,"deeper":{"x":1.5}})";
+        if (i < 3)
+        {
+            document += R"(,"rare":1)";
+        }
+        document += i < 6 ? R"(,"mixed":1)" : R"(,"mixed":"one")";
+        documents.push_back(document + "}");
+    }
+    documents.push_back("[1]");
+    std::vector<Variant> sample = parse(documents);
+
+    ShreddingSchema shredding = inferShreddingSchema(views(sample));
+    ASSERT_EQ(shredding.fields.size(), 4u);
+    EXPECT_EQ(shredding.fields[0].name, "kind");
+    EXPECT_EQ(shredding.fields[0].type, AtomicType::BYTE_ARRAY);
+    EXPECT_EQ(shredding.fields[1].name, "mixed");
+    EXPECT_EQ(shredding.fields[1].type, AtomicType::INT64);
+    EXPECT_EQ(shredding.fields[2].name, "nested");
+    ASSERT_EQ(shredding.fields[2].fields.size(), 2u);
+    EXPECT_EQ(shredding.fields[2].fields[0].fields[0].type, AtomicType::DOUBLE);
+    EXPECT_EQ(shredding.fields[3].name, "ts");
+
+    ShreddingOptions options;
+    options.max_depth = 1;
+    options.max_columns = 2;
+    options.min_frequency = 0.8;
+    shredding = inferShreddingSchema(views(sample), options);
+    ASSERT_EQ(shredding.fields.size(), 2u);
+    EXPECT_EQ(shredding.fields[0].name, "kind");
+    EXPECT_EQ(shredding.fields[1].name, "ts");
+    EXPECT_NO_THROW(shreddedSchema("v", inferShreddingSchema(views(sample))));
+}
+
+TEST(VariantShreddingTest, RejectsInvalidSchemas)
+{
+    ShreddingSchema unsorted;
+    unsorted.fields.push_back({"b", AtomicType::INT64, {}});
+    unsorted.fields.push_back({"a", AtomicType::INT64, {}});
+    EXPECT_THROW(shreddedSchema("v", unsorted), std::invalid_argument);
+
+    ShreddingSchema unsupported;
+    unsupported.fields.push_back({"a", AtomicType::FLOAT, {}});
+    EXPECT_THROW(shreddedSchema("v", unsupported), std::invalid_argument);
+
+    ShreddingSchema empty_object;
+    empty_object.fields.push_back({"a", std::nullopt, {}});
+    EXPECT_THROW(ShreddedVariantWriter(tempPath("invalid.parquet"), "v", empty_object), std::invalid_argument);
+
+    std::vector<SchemaElement> schema = shreddedSchema("v", ShreddingSchema{{{"a", AtomicType::INT64, {}}}});
+    EXPECT_EQ(leafColumns(schema).size(), 4u);
+}
@@ -0,0 +1,214 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+
+#include "variant.hpp"
+
+TEST(VariantTest, EncodesLikeTheSpecification)
+{
+    Variant variant = variantFromJson(R"({"a": 1})");
+    EXPECT_EQ(variant.metadata, (std::vector<uint8_t>{0x11, 0x01, 0x00, 0x01, 'a'}));
+    EXPECT_EQ(variant.value, (std::vector<uint8_t>{0x02, 0x01, 0x00, 0x00, 0x02, 0x0C, 0x01}));
+
+    variant = variantFromJson(R"(["x", null, true])");
+    EXPECT_EQ(variant.metadata, (std::vector<uint8_t>{0x11, 0x00, 0x00}));
+    EXPECT_EQ(variant.value, (std::vector<uint8_t>{0x03, 0x03, 0x00, 0x02, 0x03, 0x04, 0x05, 'x', 0x00, 0x04}));
+}
+
+TEST(VariantTest, RoundTripsJson)
+{
+    std::string json = R"({"user":{"name":"ada","tags":["a","b"],"age":36},"score":-2.5,"ok":false,)"
+                       R"("n":null,"big":9007199254740993,"esc":"q\"\\\n\u0001\u00e9\ud83d\ude00"})";
+    Variant variant = variantFromJson(json);
+    VariantView view = variant.view();
+    EXPECT_EQ(view.type(), VariantType::OBJECT);
+    EXPECT_EQ(view.toJson(), R"({"big":9007199254740993,"esc":"q\"\\\n\u0001é😀","n":null,"ok":false,)"
+                             R"("score":-2.5,"user":{"age":36,"name":"ada","tags":["a","b"]}})");
+    EXPECT_EQ(variantFromJson(view.toJson()).view().toJson(), view.toJson());
+
+    EXPECT_EQ(view.field("big")->type(), VariantType::INT64);
+    EXPECT_EQ(view.field("user")->field("age")->type(), VariantType::INT8);
+    EXPECT_EQ(view.field("score")->getDouble(), -2.5);
+    EXPECT_TRUE(view.field("n")->isNull());
+    EXPECT_EQ(view.field("esc")->getString(), "q\"\\\n\x01\xC3\xA9\xF0\x9F\x98\x80");
+    EXPECT_EQ(variantFromJson("1.0").view().toJson(), "1.0");
+    EXPECT_EQ(variantFromJson(" [ ] ").view().toJson(), "[]");
+}
+
+TEST(VariantTest, DeduplicatesKeys)
+{
+    Variant variant = variantFromJson(R"([{"b":1,"a":2},{"a":3,"b":4},{"c":{"a":5}}])");
+    VariantMetadata metadata(variant.metadata.data(), variant.metadata.size());
+    ASSERT_EQ(metadata.size(), 3u);
+    EXPECT_FALSE(metadata.sorted());
+    EXPECT_EQ(metadata.key(0), "b");
+    EXPECT_EQ(metadata.find("c"), 2u);
+    EXPECT_EQ(metadata.find("d"), std::nullopt);
+
+    VariantView view = variant.view();
+    EXPECT_EQ(view.element(0).fieldKey(0), "a");
+    EXPECT_EQ(view.element(0).fieldValue(0).getInt(), 2);
+    EXPECT_EQ(view.element(1).field("b")->getInt(), 4);
+    EXPECT_THROW(view.element(3), std::out_of_range);
+}
+
+TEST(VariantTest, FindsPaths)
+{
+    Variant variant = variantFromJson(R"({"a":{"b":[{"c":0},{"c":1},{"c":2},{"c":3,"d":"x"}]},"k.e":7})");
+    VariantView view = variant.view();
+    EXPECT_EQ(view.find(VariantPath("$.a.b[3].c"))->getInt(), 3);
+    EXPECT_EQ(view.find(VariantPath("$['a'].b[3][\"d\"]"))->getString(), "x");
+    EXPECT_EQ(view.find(VariantPath("$['k.e']"))->getInt(), 7);
+    EXPECT_EQ(view.find(VariantPath("$"))->type(), VariantType::OBJECT);
+    EXPECT_EQ(view.find(VariantPath("$.a.b[4].c")), std::nullopt);
+    EXPECT_EQ(view.find(VariantPath("$.a[0]")), std::nullopt);
+    EXPECT_EQ(view.find(VariantPath("$.a.b.c")), std::nullopt);
+    EXPECT_EQ(view.find(VariantPath("$.x")), std::nullopt);
+
+    EXPECT_THROW(VariantPath("a.b"), std::invalid_argument);
+    EXPECT_THROW(VariantPath("$.a["), std::invalid_argument);
+    EXPECT_THROW(VariantPath("$.a[x]"), std::invalid_argument);
+    EXPECT_THROW(VariantPath("$..a"), std::invalid_argument);
+}
+
+TEST(VariantTest, UsesWiderOffsetsForLargeContainers)
+{
+    VariantBuilder builder;
+    builder.beginObject();
+    for (int i = 0; i < 300; ++i)
+    {
+        builder.key("key" + std::to_string(i));
+        builder.appendString(std::string(static_cast<size_t>(i), 'v'));
+    }
+    builder.endObject();
+    Variant variant = builder.finish();
+    VariantView view = variant.view();
+    ASSERT_EQ(view.numElements(), 300u);
+    EXPECT_EQ(view.field("key299")->getString(), std::string(299, 'v'));
+    EXPECT_EQ(view.field("key0")->getString(), "");
+    EXPECT_EQ(view.valueSize(), variant.value.size());
+
+    builder.beginArray();
+    for (int i = 0; i < 70000; ++i)
+    {
+        builder.appendInt(i);
+    }
+    builder.endArray();
+    variant = builder.finish();
+    view = variant.view();
+    EXPECT_EQ(view.numElements(), 70000u);
+    EXPECT_EQ(view.element(69999).getInt(), 69999);
+    EXPECT_EQ(view.valueSize(), variant.value.size());
+}
+
+TEST(VariantTest, EncodesEveryPrimitiveType)
+{
+    const uint8_t uuid[16] = {0x12, 0x3e, 0x45, 0x67, 0xe8, 0x9b, 0x12, 0xd3, 0xa4, 0x56, 0x42, 0x66, 0x14, 0x17, 0x40, 0x00};
+    VariantBuilder builder;
+    builder.beginArray();
+    builder.appendInt(-200);
+    builder.appendInt(int64_t{1} << 40);
+    builder.appendFloat(0.5f);
+    builder.appendDecimal(-12345, 2);
+    builder.appendDecimal(static_cast<__int128>(1) << 70, 3);
+    builder.appendDecimal(5, 20);
+    builder.appendDate(19000);
+    builder.appendTimestamp(-1);
+    builder.appendTimestamp(86400000001, false);
+    builder.appendTimestampNanos(1500000000, true);
+    builder.appendTime(3723000004);
+    builder.appendBinary("hello");
+    builder.appendUuid(uuid);
+    builder.appendString(std::string(100, 's'));
+    builder.appendDouble(std::numeric_limits<double>::infinity());
+    builder.endArray();
+    Variant variant = builder.finish();
+    VariantView view = variant.view();
+
+    EXPECT_EQ(view.element(0).type(), VariantType::INT16);
+    EXPECT_EQ(view.element(1).type(), VariantType::INT64);
+    EXPECT_EQ(view.element(2).getDouble(), 0.5);
+    EXPECT_EQ(view.element(3).type(), VariantType::DECIMAL4);
+    EXPECT_EQ(view.element(4).type(), VariantType::DECIMAL16);
+    EXPECT_EQ(view.element(4).getDecimal().unscaled, static_cast<__int128>(1) << 70);
+    EXPECT_EQ(view.element(5).type(), VariantType::DECIMAL16);
+    EXPECT_EQ(view.element(6).getInt(), 19000);
+    EXPECT_EQ(view.element(11).getBinary(), "hello");
+    EXPECT_EQ(view.element(13).type(), VariantType::STRING);
+    EXPECT_EQ(view.toJson(), "[-200,1099511627776,0.5,-123.45,1180591620717411303.424,0.00000000000000000005,"
+                             "\"2022-01-08\",\"1969-12-31T23:59:59.999999+00:00\",\"1970-01-02T00:00:00.000001\","
+                             "\"1970-01-01T00:00:01.500000000+00:00\",\"01:02:03.000004\",\"aGVsbG8=\","
+                             "\"123e4567-e89b-12d3-a456-426614174000\",\"" +
+                                 std::string(100, 's') + "\",\"Infinity\"]");
+
+    EXPECT_THROW(view.element(0).getString(), std::logic_error);
+    EXPECT_THROW(view.element(2).getInt(), std::logic_error);
+    EXPECT_THROW(view.getBool(), std::logic_error);
+    EXPECT_THROW(view.fieldKey(0), std::logic_error);
+    EXPECT_EQ(view.field("a"), std::nullopt);
+    EXPECT_THROW(builder.appendDecimal(1, 39), std::invalid_argument);
+}
+
+TEST(VariantTest, CopiesValuesBetweenDictionaries)
+{
+    Variant source = variantFromJson(R"({"z":{"y":[1,"two",{"x":3.5}]},"w":true})");
+    VariantBuilder builder;
+    builder.beginObject();
+    builder.key("x");
+    builder.appendInt(0);
+    builder.key("copy");
+    builder.appendVariant(*source.view().field("z"));
+    builder.endObject();
+    Variant copy = builder.finish();
+    EXPECT_EQ(copy.view().toJson(), R"({"copy":{"y":[1,"two",{"x":3.5}]},"x":0})");
+    EXPECT_EQ(VariantMetadata(copy.metadata.data(), copy.metadata.size()).size(), 3u);
+}
+
+TEST(VariantTest, RejectsMisuseAndMalformedInput)
+{
+    EXPECT_THROW(variantFromJson(R"({"a":1,"a":2})"), std::invalid_argument);
+    EXPECT_THROW(variantFromJson(R"({"a":1,})"), std::invalid_argument);
+    EXPECT_THROW(variantFromJson("[1 2]"), std::invalid_argument);
+    EXPECT_THROW(variantFromJson("01"), std::invalid_argument);
+    EXPECT_THROW(variantFromJson("\"\\ud800\""), std::invalid_argument);
+    EXPECT_THROW(variantFromJson("\"tab\there\""), std::invalid_argument);
+    EXPECT_THROW(variantFromJson("tru"), std::invalid_argument);
+    EXPECT_THROW(variantFromJson("1e999"), std::invalid_argument);
+    EXPECT_THROW(variantFromJson(std::string(2000, '[') + std::string(2000, ']')), std::invalid_argument);
+
+    VariantBuilder builder;
+    EXPECT_THROW(builder.finish(), std::logic_error);
+    builder.beginObject();
+    EXPECT_THROW(builder.appendInt(1), std::logic_error);
+    EXPECT_THROW(builder.endArray(), std::logic_error);
+    builder.key("a");
+    EXPECT_THROW(builder.key("b"), std::logic_error);
+    EXPECT_THROW(builder.endObject(), std::logic_error);
+    builder.appendInt(1);
+    builder.endObject();
+    EXPECT_THROW(builder.appendInt(2), std::logic_error);
+    EXPECT_EQ(builder.finish().view().toJson(), R"({"a":1})");
+}
+
+TEST(VariantTest, RejectsCorruptBuffers)
+{
+    Variant variant = variantFromJson(R"({"a":[1,2,3]})");
+    EXPECT_THROW(VariantMetadata(variant.metadata.data(), 0), ParquetException);
+    std::vector<uint8_t> bad_version = variant.metadata;
+    bad_version[0] = 0x12;
+    EXPECT_THROW(VariantMetadata(bad_version.data(), bad_version.size()), ParquetException);
+    EXPECT_THROW(VariantMetadata(variant.metadata.data(), 3), ParquetException);
+
+    VariantMetadata metadata(variant.metadata.data(), variant.metadata.size());
+    for (size_t size = 1; size < variant.value.size(); ++size)
+    {
+        VariantView truncated(metadata, variant.value.data(), size);
+        EXPECT_THROW(truncated.toJson(), ParquetException) << size;
+    }
+    std::vector<uint8_t> bad_id = variant.value;
+    bad_id[2] = 5;
+    EXPECT_THROW(VariantView(metadata, bad_id.data(), bad_id.size()).field("a"), ParquetException);
+    std::vector<uint8_t> bad_type = {static_cast<uint8_t>(30 << 2)};
+    EXPECT_THROW(VariantView(metadata, bad_type.data(), bad_type.size()).type(), ParquetException);
+    EXPECT_THROW(VariantView(metadata, bad_type.data(), 0), ParquetException);
+}
@@ -0,0 +1,270 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+#include "basics/benchmark_data.h"
+#include "parquet_reader.hpp"
+#include "parquet_writer.hpp"
+
+// File size and scan speed of adaptive encoding against fixed encodings, on 1M rows in
+// row groups of 128K rows, uncompressed and Snappy compressed. The columns cover what the
+// candidates are good at:
+// - id: ascending INT64 with steps below 10 (DELTA_BINARY_PACKED)
+// - quantity: INT32 drawn from 100 values, Zipfian (RLE_DICTIONARY)
+// - price: DOUBLE with two decimals in [0, 1000), 100K distinct (PLAIN)
+// - reading: uniform DOUBLE in [0, 1) (BYTE_STREAM_SPLIT under compression)
+// - name: optional BYTE_ARRAY, 10% nulls, 1000 distinct strings (RLE_DICTIONARY)
+// - url: sorted BYTE_ARRAY sharing long prefixes (DELTA_BYTE_ARRAY)
+//
+// Modes: plain (the writer's default), dictionary (RLE_DICTIONARY pinned on every column,
+// falling back to PLAIN where the dictionary outgrows 1MB), adaptive (default
+// decode_cost_weight) and smallest (weight 0, size only). BM_WriteFile reports
+// file_bytes, BM_ScanFile reads every column through ColumnChunkReader, BM_ReadColumn
+// one column at a time with its size as column_bytes.
+
+namespace
+{
+    constexpr size_t kRows = 1000000;
+    constexpr size_t kRowGroupRows = 128 * 1024;
+
+    enum Mode
+    {
+        kPlain,
+        kDictionary,
+        kAdaptive,
+        kSmallest
+    };
+
+    std::vector<ColumnDescriptor> benchmarkColumns()
+    {
+        std::vector<ColumnDescriptor> columns(6);
+        const std::tuple<const char *, AtomicType> fields[] = {
+            {"id", AtomicType::INT64},        {"quantity", AtomicType::INT32},  {"price", AtomicType::DOUBLE},
+            {"reading", AtomicType::DOUBLE}, {"name", AtomicType::BYTE_ARRAY}, {"url", AtomicType::BYTE_ARRAY},
+        };
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            columns[i].path = {std::get<0>(fields[i])};
+            columns[i].type = std::get<1>(fields[i]);
+        }
+        columns[4].max_definition_level = 1;
+        return columns;
+    }
+
+    std::vector<std::vector<ColumnBatch>> benchmarkRowGroups()
+    {
+        std::vector<int64_t> ids = ascendingIntegers(kRows, 10, 1);
+        std::vector<uint64_t> quantities = zipfianIntegers(kRows, 100, 1.0, 2);
+        std::vector<uint64_t> cents = uniformIntegers(kRows, 100000, 3);
+        std::vector<double> readings = uniformDoubles(kRows, 4);
+        std::vector<std::string> names = randomStrings(kRows, 1000, 8, 24, 5);
+        std::vector<uint64_t> nulls = uniformIntegers(kRows, 10, 6);
+        std::vector<std::string> urls = urlStrings(kRows);
+        std::vector<std::vector<ColumnBatch>> row_groups;
+        for (size_t first = 0; first < kRows; first += kRowGroupRows)
+        {
+            size_t count = std::min(kRowGroupRows, kRows - first);
+            std::vector<ColumnBatch> &batches = row_groups.emplace_back();
+            for (const ColumnDescriptor &column : benchmarkColumns())
+            {
+                batches.emplace_back(column.type);
+            }
+            std::copy_n(ids.begin() + first, count, batches[0].appendValues<int64_t>(count));
+            int32_t *quantity = batches[1].appendValues<int32_t>(count);
+            double *price = batches[2].appendValues<double>(count);
+            std::copy_n(readings.begin() + first, count, batches[3].appendValues<double>(count));
+            for (size_t i = first; i < first + count; ++i)
+            {
+                quantity[i - first] = static_cast<int32_t>(quantities[i]) + 1;
+                price[i - first] = static_cast<double>(cents[i]) / 100;
+                if (nulls[i] == 0)
+                {
+                    batches[4].appendNulls(1);
+                }
+                else
+                {
+                    batches[4].appendByteArray(reinterpret_cast<const uint8_t *>(names[i].data()), names[i].size());
+                }
+                batches[5].appendByteArray(reinterpret_cast<const uint8_t *>(urls[i].data()), urls[i].size());
+            }
+        }
+        return row_groups;
+    }
+
+    const std::vector<std::vector<ColumnBatch>> &rowGroups()
+    {
+        static const std::vector<std::vector<ColumnBatch>> row_groups = benchmarkRowGroups();
+        return row_groups;
+    }
+
+    WriterOptions writerOptions(int64_t mode, int64_t codec)
+    {
+        WriterOptions options;
+        options.codec = static_cast<CompressionCodec>(codec);
+        switch (mode)
+        {
+        case kDictionary:
+            for (const ColumnDescriptor &column : benchmarkColumns())
+            {
+                options.column_encodings[column.dottedPath()] = Encoding::RLE_DICTIONARY;
+            }
+            break;
+        case kAdaptive:
+            options.adaptive_encoding = true;
+            break;
+        case kSmallest:
+            options.adaptive_encoding = true;
+            options.decode_cost_weight = 0;
+            break;
+        default:
+            break;
+        }
+        return options;
+    }
+
+    void writeFile(const std::string &path, int64_t mode, int64_t codec)
+    {
+        ParquetFileWriter writer(path, benchmarkColumns(), writerOptions(mode, codec));
+        for (const std::vector<ColumnBatch> &batches : rowGroups())
+        {
+            std::vector<const ColumnBatch *> pointers;
+            for (const ColumnBatch &batch : batches)
+            {
+                pointers.push_back(&batch);
+            }
+            writer.writeRowGroup(pointers);
+        }
+        writer.close();
+    }
+
+    std::string benchmarkPath(int64_t mode, int64_t codec)
+    {
+        return "/tmp/writer_encoding_benchmark_" + std::to_string(::getpid()) + "_" + std::to_string(mode) + "_" +
+               std::to_string(codec) + ".parquet";
+    }
+
+    /**
+     * @brief Writes each (mode, codec) file once per process and removes them at exit.
+     */
+    class BenchmarkFiles
+    {
+    public:
+        ~BenchmarkFiles()
+        {
+            for (const auto &[key, path] : paths_)
+            {
+                std::remove(path.c_str());
+            }
+        }
+
+        const std::string &path(int64_t mode, int64_t codec)
+        {
+            auto [it, inserted] = paths_.try_emplace({mode, codec}, benchmarkPath(mode, codec));
+            if (inserted)
+            {
+                writeFile(it->second, mode, codec);
+            }
+            return it->second;
+        }
+
+    private:
+        std::map<std::pair<int64_t, int64_t>, std::string> paths_;
+    };
+
+    BenchmarkFiles &benchmarkFiles()
+    {
+        static BenchmarkFiles files;
+        return files;
+    }
+
+    void readColumn(const ParquetFileReader &reader, size_t column)
+    {
+        for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+        {
+            ColumnChunkReader chunk = reader.columnChunk(rg, column);
+            ColumnBatch batch(reader.columns()[column].type);
+            while (chunk.hasNext())
+            {
+                batch.clear();
+                chunk.readBatch(batch, kDefaultBatchSize);
+                benchmark::DoNotOptimize(batch.data());
+            }
+        }
+    }
+
+    void fileArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"mode", "codec"});
+        benchmark->ArgsProduct({{kPlain, kDictionary, kAdaptive, kSmallest},
+                                {static_cast<int64_t>(CompressionCodec::UNCOMPRESSED),
+                                 static_cast<int64_t>(CompressionCodec::SNAPPY)}});
+        benchmark->Unit(benchmark::kMillisecond);
+    }
+
+    void columnArgs(benchmark::internal::Benchmark *benchmark)
+    {
+        benchmark->ArgNames({"mode", "codec", "column"});
+        benchmark->ArgsProduct({{kPlain, kDictionary, kAdaptive, kSmallest},
+                                {static_cast<int64_t>(CompressionCodec::UNCOMPRESSED),
+                                 static_cast<int64_t>(CompressionCodec::SNAPPY)},
+                                benchmark::CreateDenseRange(0, 5, 1)});
+        benchmark->Unit(benchmark::kMicrosecond);
+    }
+} // namespace
+
+static void BM_WriteFile(benchmark::State &state)
+{
+    rowGroups();
+    std::string path = benchmarkPath(state.range(0), state.range(1)) + ".write";
+    for (auto _ : state)
+    {
+        writeFile(path, state.range(0), state.range(1));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kRows));
+    state.counters["file_bytes"] = static_cast<double>(ParquetFileReader(path).size());
+    std::remove(path.c_str());
+}
+
+static void BM_ScanFile(benchmark::State &state)
+{
+    ParquetFileReader reader(benchmarkFiles().path(state.range(0), state.range(1)));
+    for (auto _ : state)
+    {
+        for (size_t column = 0; column < reader.columns().size(); ++column)
+        {
+            readColumn(reader, column);
+        }
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kRows * reader.columns().size()));
+    state.counters["file_bytes"] = static_cast<double>(reader.size());
+}
+
+static void BM_ReadColumn(benchmark::State &state)
+{
+    ParquetFileReader reader(benchmarkFiles().path(state.range(0), state.range(1)));
+    auto column = static_cast<size_t>(state.range(2));
+    uint64_t bytes = 0;
+    for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+    {
+        bytes += reader.columnChunkRange(rg, column).length;
+    }
+    for (auto _ : state)
+    {
+        readColumn(reader, column);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kRows));
+    state.counters["column_bytes"] = static_cast<double>(bytes);
+    state.SetLabel(reader.columns()[column].dottedPath());
+}
+
+BENCHMARK(BM_WriteFile)->Apply(fileArgs);
+BENCHMARK(BM_ScanFile)->Apply(fileArgs);
+BENCHMARK(BM_ReadColumn)->Apply(columnArgs);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,303 @@
+#include "catalog.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <filesystem>
+#include <random>
+#include <sys/file.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "expression.hpp"
+#include "formats/io.hpp"
+#include "formats/variant.hpp"
+
+namespace
+{
+    void writeFile(const std::string &path, std::string_view content)
+    {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "Cannot create " + path);
+        }
+        for (size_t written = 0; written < content.size();)
+        {
+            ssize_t n = ::write(fd, content.data() + written, content.size() - written);
+            if (n < 0 && errno != EINTR)
+            {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "Cannot write " + path);
+            }
+            written += n > 0 ? static_cast<size_t>(n) : 0;
+        }
+        if (::close(fd) != 0)
+        {
+            throw std::system_error(errno, std::generic_category(), "Cannot close " + path);
+        }
+    }
+
+    std::string pointerJson(const std::string &metadata_location)
+    {
+        VariantBuilder builder;
+        builder.beginObject();
+        builder.key("metadata-location");
+        builder.appendString(metadata_location);
+        builder.endObject();
+        return builder.finish().view().toJson();
+    }
+
+    /**
+     * @brief The version a metadata file name starts with, e.g. 3 for
+     * "00003-<uuid>.metadata.json"; -1 for other names.
+     */
+    int64_t metadataVersion(const std::string &location)
+    {
+        std::string name = std::filesystem::path(location).filename();
+        int64_t version = 0;
+        auto [end, error] = std::from_chars(name.data(), name.data() + name.size(), version);
+        return error == std::errc() && end < name.data() + name.size() && *end == '-' ? version : -1;
+    }
+
+    int64_t nowMillis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+} // namespace
+
+std::string randomUuid()
+{
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    uint64_t high = rng();
+    uint64_t low = rng();
+    high = (high & ~uint64_t{0xf000}) | 0x4000;                          // version 4
+    low = (low & ~(uint64_t{0xc} << 60)) | (uint64_t{0x8} << 60);        // variant 1
+    char text[37];
+    std::snprintf(text, sizeof(text), "%08x-%04x-%04x-%04x-%012llx", static_cast<unsigned>(high >> 32),
+                  static_cast<unsigned>((high >> 16) & 0xffff), static_cast<unsigned>(high & 0xffff),
+                  static_cast<unsigned>(low >> 48), static_cast<unsigned long long>(low & 0xffffffffffffULL));
+    return text;
+}
+
+FileCatalog::FileCatalog(std::string root) : root_(std::move(root))
+{
+    std::filesystem::create_directories(root_);
+}
+
+void FileCatalog::createNamespace(const std::string &ns)
+{
+    std::filesystem::create_directories(root_ + "/" + ns);
+}
+
+std::vector<std::string> FileCatalog::listNamespaces() const
+{
+    std::vector<std::string> result;
+    for (const auto &entry : std::filesystem::directory_iterator(root_))
+    {
+        if (entry.is_directory())
+        {
+            result.push_back(entry.path().filename());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+std::vector<std::string> FileCatalog::listTables(const std::string &ns) const
+{
+    std::vector<std::string> result;
+    for (const auto &entry : std::filesystem::directory_iterator(root_ + "/" + ns))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".json")
+        {
+            result.push_back(entry.path().stem());
+        }
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+LoadTableResult FileCatalog::createTable(const TableIdentifier &table, const Schema &schema,
+                                         const PartitionSpec &spec,
+                                         std::vector<std::pair<std::string, std::string>> properties)
+{
+    auto metadata = std::make_shared<TableMetadata>();
+    metadata->table_uuid = randomUuid();
+    metadata->location = root_ + "/" + table.ns + "/" + table.name;
+    metadata->last_updated_ms = nowMillis();
+    metadata->current_schema_id = schema.schema_id;
+    metadata->schemas = {schema};
+    metadata->default_spec_id = spec.spec_id;
+    metadata->specs = {spec};
+    metadata->properties = std::move(properties);
+    for (const NestedField &field : schema.fields)
+    {
+        metadata->last_column_id = std::max(metadata->last_column_id, field.id);
+    }
+    for (const PartitionField &field : spec.fields)
+    {
+        const NestedField *source = schema.findById(field.source_id);
+        if (!source)
+        {
+            throw IcebergException("Partition field " + field.name + " of an unknown column");
+        }
+        try
+        {
+            Transform::parse(field.transform).resultType(source->type);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            throw IcebergException(e.what());
+        }
+        metadata->last_partition_id = std::max(metadata->last_partition_id, field.field_id);
+    }
+
+    std::filesystem::create_directories(metadata->location + "/metadata");
+    std::string metadata_location =
+        metadata->location + "/metadata/00000-" + randomUuid() + ".metadata.json";
+    writeTableMetadata(metadata_location, *metadata);
+    registerTable(table, metadata_location);
+    return {metadata_location, std::move(metadata)};
+}
+
+void FileCatalog::registerTable(const TableIdentifier &table, const std::string &metadata_location)
+{
+    // Written aside and linked into place, so the pointer appears complete or not at all
+    std::string pointer = pointerPath(table);
+    std::string temporary = pointer + "." + randomUuid() + ".tmp";
+    writeFile(temporary, pointerJson(metadata_location));
+    int result = ::link(temporary.c_str(), pointer.c_str());
+    int error = errno;
+    ::unlink(temporary.c_str());
+    if (result != 0)
+    {
+        if (error == EEXIST)
+        {
+            throw IcebergException("Table " + table.toString() + " exists");
+        }
+        throw std::system_error(error, std::generic_category(), "Cannot create " + pointer);
+    }
+}
+
+LoadTableResult FileCatalog::loadTable(const TableIdentifier &table) const
+{
+    LoadTableResult result;
+    result.metadata_location = readPointer(table);
+    result.metadata = std::make_shared<const TableMetadata>(readTableMetadata(result.metadata_location));
+    return result;
+}
+
+std::string FileCatalog::pointerPath(const TableIdentifier &table) const
+{
+    return root_ + "/" + table.ns + "/" + table.name + ".json";
+}
+
+std::string FileCatalog::readPointer(const TableIdentifier &table) const
+{
+    std::string json;
+    try
+    {
+        LocalFile file(pointerPath(table));
+        json.resize(file.size());
+        file.readAt(0, json.size(), reinterpret_cast<uint8_t *>(json.data()));
+    }
+    catch (const std::system_error &e)
+    {
+        if (e.code() == std::errc::no_such_file_or_directory)
+        {
+            throw NoSuchTableException(table);
+        }
+        throw;
+    }
+    try
+    {
+        Variant pointer = variantFromJson(json);
+        std::optional<VariantView> location = pointer.view().field("metadata-location");
+        if (!location)
+        {
+            throw IcebergException("Catalog entry of " + table.toString() + " without a metadata location");
+        }
+        return std::string(location->getString());
+    }
+    catch (const std::logic_error &e)
+    {
+        throw IcebergException("Malformed catalog entry of " + table.toString() + ": " + e.what());
+    }
+}
+
+LoadTableResult FileCatalog::commitTable(const TableIdentifier &table, const LoadTableResult &base,
+                                         TableMetadata metadata)
+{
+    metadata.last_updated_ms = std::max(nowMillis(), base.metadata->last_updated_ms);
+    metadata.metadata_log.emplace_back(base.metadata->last_updated_ms, base.metadata_location);
+    auto max_log = static_cast<size_t>(
+        std::max<int64_t>(metadata.propertyAsLong("write.metadata.previous-versions-max", 100), 1));
+    if (metadata.metadata_log.size() > max_log)
+    {
+        metadata.metadata_log.erase(metadata.metadata_log.begin(),
+                                    metadata.metadata_log.end() - static_cast<ptrdiff_t>(max_log));
+    }
+
+    char version[24];
+    std::snprintf(version, sizeof(version), "%05lld",
+                  static_cast<long long>(metadataVersion(base.metadata_location) + 1));
+    std::string metadata_location = metadata.location + "/metadata/" + version + "-" + randomUuid() + ".metadata.json";
+    writeTableMetadata(metadata_location, metadata);
+    try
+    {
+        TableLock lock(*this, table);
+        if (readPointer(table) != base.metadata_location)
+        {
+            throw CommitFailedException("Cannot commit " + table.toString() + ": its metadata changed since " +
+                                        base.metadata_location);
+        }
+        std::string pointer = pointerPath(table);
+        std::string temporary = pointer + "." + randomUuid() + ".tmp";
+        writeFile(temporary, pointerJson(metadata_location));
+        if (::rename(temporary.c_str(), pointer.c_str()) != 0)
+        {
+            int error = errno;
+            ::unlink(temporary.c_str());
+            throw std::system_error(error, std::generic_category(), "Cannot replace " + pointer);
+        }
+    }
+    catch (...)
+    {
+        std::error_code ignored;
+        std::filesystem::remove(metadata_location, ignored);
+        throw;
+    }
+    return {std::move(metadata_location), std::make_shared<const TableMetadata>(std::move(metadata))};
+}
+
+FileCatalog::TableLock::TableLock(const FileCatalog &catalog, const TableIdentifier &table)
+{
+    std::string path = catalog.root_ + "/" + table.ns + "/" + table.name + ".lock";
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+    }
+    while (::flock(fd_, LOCK_EX) != 0)
+    {
+        if (errno != EINTR)
+        {
+            int error = errno;
+            ::close(fd_);
+            throw std::system_error(error, std::generic_category(), "Cannot lock " + path);
+        }
+    }
+}
+
+FileCatalog::TableLock::~TableLock()
+{
+    // Closing the descriptor releases the lock
+    ::close(fd_);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "table_metadata.hpp"
+
+// A catalog keeps the pointer from a table name to the table's current metadata file;
+// swapping that pointer is how commits become visible.
+
+struct TableIdentifier
+{
+    std::string ns;
+    std::string name;
+
+    std::string toString() const { return ns + "." + name; }
+};
+
+class NoSuchTableException : public IcebergException
+{
+public:
+    explicit NoSuchTableException(const TableIdentifier &table)
+        : IcebergException("Table " + table.toString() + " does not exist") {}
+};
+
+/**
+ * @brief The table changed since the metadata a commit was based on; the commit can be
+ * retried on top of the new metadata.
+ */
+class CommitFailedException : public IcebergException
+{
+public:
+    using IcebergException::IcebergException;
+};
+
+struct LoadTableResult
+{
+    std::string metadata_location;
+    std::shared_ptr<const TableMetadata> metadata;
+};
+
+/**
+ * @brief A local file backed stand-in for an Iceberg REST catalog, for tests and
+ * benchmarks. Namespaces are directories under the root; each table has a pointer file
+ * `<root>/<namespace>/<table>.json` holding {"metadata-location": ...}, the part of the
+ * REST LoadTableResponse that matters, and new tables keep their data and metadata in
+ * `<root>/<namespace>/<table>/`.
+ */
+class FileCatalog
+{
+public:
+    /**
+     * @throws std::system_error if the root cannot be created
+     */
+    explicit FileCatalog(std::string root);
+
+    const std::string &root() const noexcept { return root_; }
+
+    /**
+     * @brief Creates a namespace unless it exists.
+     */
+    void createNamespace(const std::string &ns);
+
+    std::vector<std::string> listNamespaces() const;
+    std::vector<std::string> listTables(const std::string &ns) const;
+
+    /**
+     * @brief Creates a format version 2 table without snapshots.
+     * @throws IcebergException if the table exists or the spec does not fit the schema
+     */
+    LoadTableResult createTable(const TableIdentifier &table, const Schema &schema, const PartitionSpec &spec,
+                                std::vector<std::pair<std::string, std::string>> properties = {});
+
+    /**
+     * @brief Adds a table whose metadata file was written elsewhere.
+     * @throws IcebergException if the table exists
+     */
+    void registerTable(const TableIdentifier &table, const std::string &metadata_location);
+
+    /**
+     * @throws NoSuchTableException for unknown tables
+     * @throws IcebergException for malformed metadata
+     */
+    LoadTableResult loadTable(const TableIdentifier &table) const;
+
+    /**
+     * @brief Writes `metadata` as the next metadata file of the table and makes it current,
+     * provided the table is still at `base`: the compare-and-swap every commit goes
+     * through. `base` is appended to the metadata log, which keeps the last
+     * `write.metadata.previous-versions-max` (100) entries.
+     * @throws CommitFailedException if the table moved on from `base`; nothing changed
+     * @throws NoSuchTableException for unknown tables
+     * @throws std::system_error on I/O errors
+     */
+    LoadTableResult commitTable(const TableIdentifier &table, const LoadTableResult &base, TableMetadata metadata);
+
+protected:
+    std::string pointerPath(const TableIdentifier &table) const;
+
+    /**
+     * @brief The metadata location the table's pointer file holds.
+     */
+    std::string readPointer(const TableIdentifier &table) const;
+
+    /**
+     * @brief Holds an exclusive lock on `<root>/<namespace>/<table>.lock`, which serializes
+     * the commits to a table across threads and processes. The pointer file itself is
+     * replaced by every commit, so it cannot carry the lock.
+     */
+    class TableLock
+    {
+    public:
+        TableLock(const FileCatalog &catalog, const TableIdentifier &table);
+        ~TableLock();
+
+        TableLock(const TableLock &) = delete;
+        TableLock &operator=(const TableLock &) = delete;
+
+    private:
+        int fd_;
+    };
+
+private:
+    std::string root_;
+};
+
+/**
+ * @brief A random version 4 UUID in its text form.
+ */
+std::string randomUuid();
@@ -0,0 +1,186 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "compaction.hpp"
+#include "data_file_writer.hpp"
+#include "formats/scanner.hpp"
+#include "snapshot_update.hpp"
+#include "table_scan.hpp"
+
+// Commit throughput of 1, 2 and 4 writers appending one file per commit to the same table
+// of the file catalog: every iteration starts a new table and each writer commits 25
+// times, so conflicts are retried (with 1-5 ms backoff) and the commit cost includes
+// writing the manifest, the manifest list and the metadata file. Then the time to plan
+// and scan every column of a table of 2048 files of 512 rows (as left by frequent small
+// appends, e.g. of a replication sink), as appended and after compaction into one file
+// of 128K row groups (the target size fits the whole table).
+
+namespace
+{
+    constexpr int kCommitsPerWriter = 25;
+    constexpr int64_t kSmallFiles = 2048;
+    constexpr int64_t kRowsPerFile = 512;
+
+    std::string benchmarkRoot(const std::string &name)
+    {
+        return "/tmp/commit_benchmark_" + std::to_string(::getpid()) + "_" + name;
+    }
+
+    Schema benchmarkSchema()
+    {
+        return Schema::fromFields(
+            0, {{1, "id", "long", true}, {2, "value", "double", true}, {3, "name", "string", false}});
+    }
+
+    class CompactionTable
+    {
+    public:
+        explicit CompactionTable(bool compacted) : root_(benchmarkRoot(compacted ? "compacted" : "small"))
+        {
+            std::filesystem::remove_all(root_);
+            catalog_ = std::make_unique<FileCatalog>(root_);
+            catalog_->createNamespace("db");
+            Schema schema = benchmarkSchema();
+            PartitionSpec spec{0, {}};
+            std::string location = catalog_->createTable({"db", "t"}, schema, spec).metadata->location;
+
+            AppendFiles append(*catalog_, {"db", "t"});
+            for (int64_t f = 0; f < kSmallFiles; ++f)
+            {
+                DataFileWriter writer(location + "/data/" + std::to_string(f) + ".parquet", schema, spec, {});
+                ColumnBatch ids(AtomicType::INT64);
+                ColumnBatch values(AtomicType::DOUBLE);
+                ColumnBatch names(AtomicType::BYTE_ARRAY);
+                for (int64_t r = 0; r < kRowsPerFile; ++r)
+                {
+                    int64_t id = f * kRowsPerFile + r;
+                    *ids.appendValues<int64_t>(1) = id;
+                    *values.appendValues<double>(1) = static_cast<double>(id) / 3;
+                    std::string name = "name-" + std::to_string(id % 1000);
+                    names.appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+                }
+                writer.writeRowGroup({&ids, &values, &names});
+                append.appendFile(writer.close());
+            }
+            append.commit();
+            if (compacted)
+            {
+                CompactionOptions options;
+                options.min_input_files = 2;
+                options.row_group_rows = 1 << 17;
+                rewriteDataFiles(*catalog_, {"db", "t"}, options);
+            }
+        }
+
+        ~CompactionTable() { std::filesystem::remove_all(root_); }
+
+        FileCatalog &catalog() const noexcept { return *catalog_; }
+
+    private:
+        std::string root_;
+        std::unique_ptr<FileCatalog> catalog_;
+    };
+} // namespace
+
+static void BM_ConcurrentAppends(benchmark::State &state)
+{
+    const auto writers = static_cast<int>(state.range(0));
+    std::string root = benchmarkRoot("commits");
+    std::filesystem::remove_all(root);
+    FileCatalog catalog(root);
+    catalog.createNamespace("db");
+    size_t tables = 0;
+    size_t attempts = 0;
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        TableIdentifier table{"db", "t"};
+        table.name += std::to_string(tables++);
+        catalog.createTable(table, benchmarkSchema(), PartitionSpec{0, {}},
+                            {{"commit.retry.num-retries", "1000"},
+                             {"commit.retry.min-wait-ms", "1"},
+                             {"commit.retry.max-wait-ms", "5"}});
+        state.ResumeTiming();
+
+        std::atomic<size_t> iteration_attempts{0};
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writers; ++w)
+        {
+            threads.emplace_back(
+                [&, w]()
+                {
+                    for (int c = 0; c < kCommitsPerWriter; ++c)
+                    {
+                        DataFile file;
+                        file.file_path = std::to_string(w) + "-" + std::to_string(c) + ".parquet";
+                        file.record_count = 1000;
+                        file.file_size_in_bytes = 1 << 20;
+                        AppendFiles append(catalog, table);
+                        append.appendFile(std::move(file));
+                        append.commit();
+                        iteration_attempts += append.attempts();
+                    }
+                });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        attempts += iteration_attempts;
+    }
+    std::filesystem::remove_all(root);
+    auto commits = static_cast<double>(state.iterations()) * writers * kCommitsPerWriter;
+    state.counters["commits/s"] = benchmark::Counter(commits, benchmark::Counter::kIsRate);
+    state.counters["retries/commit"] = (static_cast<double>(attempts) - commits) / commits;
+}
+
+BENCHMARK(BM_ConcurrentAppends)
+    ->ArgName("writers")
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_ScanTable(benchmark::State &state)
+{
+    CompactionTable table(state.range(0) == 1);
+    ThreadPool pool(1);
+    size_t files = 0;
+    size_t rows = 0;
+    for (auto _ : state)
+    {
+        TableScanOptions options;
+        options.cache = nullptr;
+        options.pool = &pool;
+        std::vector<FileScanTask> tasks = TableScan(table.catalog().loadTable({"db", "t"}).metadata, options).plan();
+        files = tasks.size();
+        rows = 0;
+        for (const FileScanTask &task : tasks)
+        {
+            auto reader = std::make_shared<ParquetFileReader>(std::make_shared<LocalFile>(task.file->file_path));
+            ScanOptions scan_options = scanOptions(task);
+            scan_options.pool = &pool;
+            ParquetScanner scanner(reader, scan_options);
+            ScanBatch batch;
+            while (scanner.next(batch))
+            {
+                rows += batch.column == 0 ? batch.batch->length() : 0;
+            }
+        }
+        benchmark::DoNotOptimize(rows);
+    }
+    state.counters["files"] = static_cast<double>(files);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rows));
+}
+
+BENCHMARK(BM_ScanTable)->ArgName("compacted")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+BENCHMARK_MAIN();
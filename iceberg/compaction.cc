@@ -0,0 +1,284 @@
+#include "compaction.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <map>
+
+#include "data_file_writer.hpp"
+#include "snapshot_update.hpp"
+#include "table_scan.hpp"
+
+namespace
+{
+    struct FileGroup
+    {
+        int32_t spec_id = 0;
+        std::vector<Literal> partition;
+        std::vector<std::shared_ptr<const DataFile>> files;
+        int64_t bytes = 0;
+    };
+
+    /**
+     * @brief Bin-packs the files of one partition, largest first, into groups of at most
+     * `target` bytes (a single larger file gets a group of its own).
+     */
+    std::vector<FileGroup> pack(std::vector<std::shared_ptr<const DataFile>> files, int64_t target)
+    {
+        std::sort(files.begin(), files.end(),
+                  [](const auto &a, const auto &b) { return a->file_size_in_bytes > b->file_size_in_bytes; });
+        std::vector<FileGroup> groups;
+        for (std::shared_ptr<const DataFile> &file : files)
+        {
+            auto group = std::find_if(groups.begin(), groups.end(), [&](const FileGroup &g)
+                                      { return g.bytes + file->file_size_in_bytes <= target; });
+            if (group == groups.end())
+            {
+                group = groups.insert(groups.end(), FileGroup{file->spec_id, file->partition, {}, 0});
+            }
+            group->bytes += file->file_size_in_bytes;
+            group->files.push_back(std::move(file));
+        }
+        return groups;
+    }
+
+    /**
+     * @brief Writes the rows of a group to `location`, appending row group after row group
+     * of the inputs and flushing once `row_group_rows` rows are buffered.
+     */
+    DataFile rewriteGroup(const FileGroup &group, const std::string &location, const TableMetadata &metadata,
+                          const CompactionOptions &options)
+    {
+        const Schema &schema = metadata.schema();
+        std::vector<SchemaElement> elements = parquetSchema(schema);
+        std::vector<ColumnBatch> batches;
+        std::vector<const ColumnBatch *> pointers;
+        for (size_t f = 0; f < schema.fields.size(); ++f)
+        {
+            batches.emplace_back(*elements[f + 1].type, elements[f + 1].type_length.value_or(0));
+        }
+        for (const ColumnBatch &batch : batches)
+        {
+            pointers.push_back(&batch);
+        }
+
+        DataFileWriter writer(location, schema, metadata.spec(group.spec_id), group.partition, options.writer);
+        auto flush = [&]()
+        {
+            writer.writeRowGroup(pointers);
+            for (ColumnBatch &batch : batches)
+            {
+                batch.clear();
+            }
+        };
+        for (const std::shared_ptr<const DataFile> &file : group.files)
+        {
+            ParquetFileReader reader(localPath(file->file_path));
+            std::vector<std::optional<size_t>> columns = fileColumns(reader, schema);
+            for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+            {
+                auto rows = static_cast<size_t>(reader.metadata().row_groups[rg].num_rows);
+                for (size_t f = 0; f < schema.fields.size(); ++f)
+                {
+                    if (!columns[f])
+                    {
+                        if (schema.fields[f].required)
+                        {
+                            throw IcebergException(file->file_path + " lacks required column " + schema.fields[f].name);
+                        }
+                        batches[f].appendNulls(rows);
+                        continue;
+                    }
+                    if (reader.columns()[*columns[f]].type != batches[f].type())
+                    {
+                        throw IcebergException("Column " + schema.fields[f].name + " of " + file->file_path +
+                                               " has another type than the table");
+                    }
+                    ColumnChunkReader chunk = reader.columnChunk(rg, *columns[f]);
+                    for (size_t read = 0; read < rows;)
+                    {
+                        size_t n = chunk.readBatch(batches[f], rows - read);
+                        if (n == 0)
+                        {
+                            throw IcebergException("Column " + schema.fields[f].name + " of " + file->file_path +
+                                                   " has fewer values than rows");
+                        }
+                        read += n;
+                    }
+                }
+                if (!batches.empty() && batches[0].length() >= options.row_group_rows)
+                {
+                    flush();
+                }
+            }
+        }
+        if (!batches.empty() && !batches[0].empty())
+        {
+            flush();
+        }
+        return writer.close();
+    }
+} // namespace
+
+CompactionResult rewriteDataFiles(FileCatalog &catalog, const TableIdentifier &table,
+                                  const CompactionOptions &options)
+{
+    LoadTableResult loaded = catalog.loadTable(table);
+    const TableMetadata &metadata = *loaded.metadata;
+    const Snapshot *snapshot = metadata.currentSnapshot();
+    if (!snapshot)
+    {
+        return {};
+    }
+    std::unique_ptr<ThreadPool> owned_pool;
+    ThreadPool *pool = options.pool;
+    if (!pool)
+    {
+        owned_pool = std::make_unique<ThreadPool>(options.threads);
+        pool = owned_pool.get();
+    }
+
+    TableScanOptions scan_options;
+    scan_options.snapshot_id = snapshot->snapshot_id;
+    scan_options.pool = pool;
+    int64_t min_size = options.min_file_size_bytes > 0 ? options.min_file_size_bytes
+                                                       : options.target_file_size_bytes / 4 * 3;
+    std::map<std::pair<int32_t, std::vector<Literal>>, std::vector<std::shared_ptr<const DataFile>>> partitions;
+    for (FileScanTask &task : TableScan(loaded.metadata, scan_options).plan())
+    {
+        if (task.deletes.empty() && task.file->file_size_in_bytes < min_size)
+        {
+            partitions[{task.file->spec_id, task.file->partition}].push_back(std::move(task.file));
+        }
+    }
+    std::vector<FileGroup> groups;
+    for (auto &[partition, files] : partitions)
+    {
+        for (FileGroup &group : pack(std::move(files), options.target_file_size_bytes))
+        {
+            if (group.files.size() > 1 && (group.files.size() >= options.min_input_files || group.bytes >= min_size))
+            {
+                groups.push_back(std::move(group));
+            }
+        }
+    }
+    if (groups.empty())
+    {
+        return {};
+    }
+
+    std::vector<std::string> locations;
+    for (size_t g = 0; g < groups.size(); ++g)
+    {
+        locations.push_back(metadata.location + "/data/" + randomUuid() + ".parquet");
+    }
+    try
+    {
+        std::vector<DataFile> added = parallelMap<DataFile>(
+            *pool, groups.size(), [&](size_t g) { return rewriteGroup(groups[g], locations[g], metadata, options); });
+
+        CompactionResult result;
+        RewriteFiles rewrite(catalog, table);
+        rewrite.validateFromSnapshot(snapshot->snapshot_id);
+        for (size_t g = 0; g < groups.size(); ++g)
+        {
+            for (const std::shared_ptr<const DataFile> &file : groups[g].files)
+            {
+                rewrite.deleteFile(*file);
+            }
+            result.rewritten_files += groups[g].files.size();
+            result.rewritten_bytes += groups[g].bytes;
+            result.added_bytes += added[g].file_size_in_bytes;
+            rewrite.addFile(std::move(added[g]));
+        }
+        result.groups = groups.size();
+        LoadTableResult committed = rewrite.commit();
+        result.snapshot_id = committed.metadata->current_snapshot_id;
+        return result;
+    }
+    catch (...)
+    {
+        for (const std::string &location : locations)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(localPath(location), ignored);
+        }
+        throw;
+    }
+}
+
+CompactionJob::CompactionJob(FileCatalog &catalog, TableIdentifier table, std::chrono::milliseconds interval,
+                             CompactionOptions options)
+    : catalog_(catalog), table_(std::move(table)), interval_(interval), options_(std::move(options)),
+      thread_([this]() { run(); })
+{
+}
+
+CompactionJob::~CompactionJob()
+{
+    stop();
+}
+
+void CompactionJob::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+    {
+        thread_.join();
+    }
+}
+
+void CompactionJob::waitForRuns(size_t count)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, [&]() { return runs_ >= count || stop_; });
+}
+
+size_t CompactionJob::runs() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return runs_;
+}
+
+CompactionResult CompactionJob::lastResult() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_result_;
+}
+
+std::exception_ptr CompactionJob::lastError() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_error_;
+}
+
+void CompactionJob::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_)
+    {
+        lock.unlock();
+        std::optional<CompactionResult> result;
+        std::exception_ptr error;
+        try
+        {
+            result = rewriteDataFiles(catalog_, table_, options_);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        lock.lock();
+        if (result)
+        {
+            last_result_ = *result;
+        }
+        last_error_ = error;
+        ++runs_;
+        wake_.notify_all();
+        wake_.wait_for(lock, interval_, [this]() { return stop_; });
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include "catalog.hpp"
+#include "formats/parquet_writer.hpp"
+#include "formats/thread_pool.hpp"
+
+struct CompactionOptions
+{
+    /// Size the rewritten files aim for, write.target-file-size-bytes in Iceberg
+    int64_t target_file_size_bytes = int64_t{512} << 20;
+
+    /// Files below this size are rewritten; 0 means 75% of the target size
+    int64_t min_file_size_bytes = 0;
+
+    /// Fewest files a group needs to be rewritten, unless it adds up to a file that is no
+    /// longer small
+    size_t min_input_files = 5;
+
+    /// Rows per row group of the rewritten files; input row groups are not split
+    size_t row_group_rows = size_t{1} << 20;
+
+    WriterOptions writer;
+
+    /// Pool to plan and rewrite on; when null the compaction starts its own pool of
+    /// `threads` workers
+    ThreadPool *pool = nullptr;
+    size_t threads = 0;
+};
+
+struct CompactionResult
+{
+    /// Groups of small files, each rewritten into one file
+    size_t groups = 0;
+    size_t rewritten_files = 0;
+    int64_t rewritten_bytes = 0;
+    int64_t added_bytes = 0;
+
+    /// The snapshot that replaced the files, unset if nothing was worth rewriting
+    std::optional<int64_t> snapshot_id;
+};
+
+/**
+ * @brief Compacts the small data files of a table.
+ *
+ * Data files below the minimum size are grouped by partition and bin-packed, largest
+ * first, into groups of up to the target size. The groups are rewritten in parallel, each
+ * into one Parquet file whose rows are the concatenated row groups of its inputs, and
+ * replace their inputs in one RewriteFiles commit. Files with delete files attached are
+ * left alone, and the commit fails if delete files were added concurrently.
+ *
+ * @throws ValidationException if a concurrent commit removed the files or added deletes;
+ * the rewritten files are deleted again
+ * @throws CommitFailedException, IcebergException or std::system_error as
+ * SnapshotUpdate::commit() does
+ */
+CompactionResult rewriteDataFiles(FileCatalog &catalog, const TableIdentifier &table,
+                                  const CompactionOptions &options = {});
+
+/**
+ * @brief Runs rewriteDataFiles() on a table in the background: right away, then every
+ * `interval` until stopped. Failed runs are recorded and retried at the next interval.
+ */
+class CompactionJob
+{
+public:
+    CompactionJob(FileCatalog &catalog, TableIdentifier table, std::chrono::milliseconds interval,
+                  CompactionOptions options = {});
+
+    /**
+     * @brief Stops the job, waiting for a running compaction.
+     */
+    ~CompactionJob();
+
+    CompactionJob(const CompactionJob &) = delete;
+    CompactionJob &operator=(const CompactionJob &) = delete;
+
+    void stop();
+
+    /**
+     * @brief Waits until `count` runs finished.
+     */
+    void waitForRuns(size_t count);
+
+    /// Runs finished so far
+    size_t runs() const;
+
+    /// The result of the last successful run, and the error of the last run if it failed
+    CompactionResult lastResult() const;
+    std::exception_ptr lastError() const;
+
+private:
+    void run();
+
+    FileCatalog &catalog_;
+    TableIdentifier table_;
+    std::chrono::milliseconds interval_;
+    CompactionOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+    size_t runs_ = 0;
+    CompactionResult last_result_;
+    std::exception_ptr last_error_;
+    std::thread thread_;
+};
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "compaction.hpp"
+#include "data_file_writer.hpp"
+#include "formats/scanner.hpp"
+#include "snapshot_update.hpp"
+#include "table_scan.hpp"
+
+namespace
+{
+    const TableIdentifier kTable{"db", "events"};
+
+    /**
+     * @brief A table partitioned by category holding small files of 10 rows each: six in
+     * "a", five in "b" and one in "c". File f has ids 10 * f ... + 9.
+     */
+    class CompactionTest : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            std::string root = testing::TempDir() + "/compaction_catalog";
+            std::filesystem::remove_all(root);
+            catalog = std::make_unique<FileCatalog>(root);
+            catalog->createNamespace("db");
+            Schema schema = Schema::fromFields(
+                0, {{1, "id", "long", true}, {2, "category", "string", true}, {3, "name", "string", false}});
+            PartitionSpec spec{0, {{2, 1000, "category", "identity"}}};
+            std::string location = catalog->createTable(kTable, schema, spec).metadata->location;
+
+            AppendFiles append(*catalog, kTable);
+            int64_t f = 0;
+            for (auto [category, files] : {std::pair<std::string, int>{"a", 6}, {"b", 5}, {"c", 1}})
+            {
+                for (int i = 0; i < files; ++i, ++f)
+                {
+                    std::string path = location + "/data/" + category + std::to_string(i) + ".parquet";
+                    DataFileWriter writer(path, schema, spec, {category});
+                    ColumnBatch ids(AtomicType::INT64);
+                    ColumnBatch categories(AtomicType::BYTE_ARRAY);
+                    ColumnBatch names(AtomicType::BYTE_ARRAY);
+                    for (int64_t r = 0; r < 10; ++r)
+                    {
+                        *ids.appendValues<int64_t>(1) = 10 * f + r;
+                        categories.appendByteArray(reinterpret_cast<const uint8_t *>(category.data()), category.size());
+                        std::string name = "n" + std::to_string(r);
+                        if (r % 3 == 0)
+                        {
+                            names.appendNulls(1);
+                        }
+                        else
+                        {
+                            names.appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+                        }
+                    }
+                    writer.writeRowGroup({&ids, &categories, &names});
+                    append.appendFile(writer.close());
+                }
+            }
+            append.commit();
+        }
+
+        std::vector<FileScanTask> plan()
+        {
+            TableScanOptions options;
+            options.cache = nullptr;
+            return TableScan(catalog->loadTable(kTable).metadata, options).plan();
+        }
+
+        std::unique_ptr<FileCatalog> catalog;
+    };
+} // namespace
+
+TEST_F(CompactionTest, RewritesSmallFilesPerPartition)
+{
+    CompactionOptions options;
+    options.target_file_size_bytes = 1 << 20;
+    options.min_input_files = 2;
+    options.threads = 2;
+    CompactionResult result = rewriteDataFiles(*catalog, kTable, options);
+    EXPECT_EQ(result.groups, 2u);
+    EXPECT_EQ(result.rewritten_files, 11u);
+    EXPECT_GT(result.added_bytes, 0);
+    EXPECT_LT(result.added_bytes, result.rewritten_bytes);
+    ASSERT_TRUE(result.snapshot_id);
+
+    LoadTableResult loaded = catalog->loadTable(kTable);
+    EXPECT_EQ(loaded.metadata->current_snapshot_id, *result.snapshot_id);
+    const Snapshot &snapshot = *loaded.metadata->currentSnapshot();
+    EXPECT_EQ(snapshot.summaryValue("operation"), "replace");
+    EXPECT_EQ(snapshot.summaryValue("total-data-files"), "3");
+    EXPECT_EQ(snapshot.summaryValue("total-records"), "120");
+
+    std::vector<FileScanTask> tasks = plan();
+    ASSERT_EQ(tasks.size(), 3u);
+    std::vector<int64_t> ids;
+    size_t null_names = 0;
+    for (const FileScanTask &task : tasks)
+    {
+        auto reader = std::make_shared<ParquetFileReader>(std::make_shared<LocalFile>(task.file->file_path));
+        EXPECT_EQ(reader->metadata().num_rows, task.file->record_count);
+        ParquetScanner scanner(reader);
+        ScanBatch batch;
+        while (scanner.next(batch))
+        {
+            if (batch.column == 0)
+            {
+                const int64_t *values = batch.batch->values<int64_t>();
+                ids.insert(ids.end(), values, values + batch.batch->length());
+            }
+            else if (batch.column == 2)
+            {
+                null_names += batch.batch->nullCount();
+            }
+        }
+        EXPECT_EQ(task.file->findMetrics(3)->null_value_count, task.file->record_count / 10 * 4);
+    }
+    std::sort(ids.begin(), ids.end());
+    ASSERT_EQ(ids.size(), 120u);
+    for (int64_t i = 0; i < 120; ++i)
+    {
+        EXPECT_EQ(ids[i], i);
+    }
+    EXPECT_EQ(null_names, 48u);
+
+    // Nothing is left to rewrite: the partitions hold one file each
+    CompactionResult again = rewriteDataFiles(*catalog, kTable, options);
+    EXPECT_EQ(again.groups, 0u);
+    EXPECT_FALSE(again.snapshot_id);
+}
+
+TEST_F(CompactionTest, HonorsMinimumGroupSize)
+{
+    CompactionOptions options;
+    options.target_file_size_bytes = 1 << 20;
+    options.min_input_files = 6;
+    EXPECT_EQ(rewriteDataFiles(*catalog, kTable, options).rewritten_files, 6u);
+    EXPECT_EQ(plan().size(), 7u);
+
+    // Files of at least the minimum size stay as they are
+    options.min_input_files = 2;
+    options.min_file_size_bytes = 1;
+    EXPECT_EQ(rewriteDataFiles(*catalog, kTable, options).groups, 0u);
+}
+
+TEST_F(CompactionTest, RunsInTheBackground)
+{
+    CompactionOptions options;
+    options.target_file_size_bytes = 1 << 20;
+    options.min_input_files = 2;
+    CompactionJob job(*catalog, kTable, std::chrono::milliseconds(10), options);
+    job.waitForRuns(2);
+    EXPECT_FALSE(job.lastError());
+    EXPECT_GE(job.runs(), 2u);
+    job.stop();
+    EXPECT_EQ(plan().size(), 3u);
+}
@@ -0,0 +1,274 @@
+#include "data_file_writer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+namespace
+{
+    // ConvertedType values from parquet.thrift
+    constexpr int32_t kUtf8 = 0;
+    constexpr int32_t kDecimal = 5;
+    constexpr int32_t kDate = 6;
+    constexpr int32_t kTimeMicros = 8;
+    constexpr int32_t kTimestampMicros = 10;
+
+    void setType(SchemaElement &element, const std::string &type)
+    {
+        int precision = 0;
+        int scale = 0;
+        int length = 0;
+        if (type == "boolean")
+        {
+            element.type = AtomicType::BOOLEAN;
+        }
+        else if (type == "int" || type == "date")
+        {
+            element.type = AtomicType::INT32;
+            if (type == "date")
+            {
+                element.converted_type = kDate;
+            }
+        }
+        else if (type == "long" || type == "time" || type == "timestamp" || type == "timestamptz")
+        {
+            element.type = AtomicType::INT64;
+            if (type == "time")
+            {
+                element.converted_type = kTimeMicros;
+            }
+            else if (type != "long")
+            {
+                element.converted_type = kTimestampMicros;
+            }
+        }
+        else if (type == "float")
+        {
+            element.type = AtomicType::FLOAT;
+        }
+        else if (type == "double")
+        {
+            element.type = AtomicType::DOUBLE;
+        }
+        else if (type == "string" || type == "binary")
+        {
+            element.type = AtomicType::BYTE_ARRAY;
+            if (type == "string")
+            {
+                element.converted_type = kUtf8;
+            }
+        }
+        else if (type == "uuid")
+        {
+            element.type = AtomicType::FIXED_LEN_BYTE_ARRAY;
+            element.type_length = 16;
+        }
+        else if (std::sscanf(type.c_str(), "fixed[%d]", &length) == 1 && length > 0)
+        {
+            element.type = AtomicType::FIXED_LEN_BYTE_ARRAY;
+            element.type_length = length;
+        }
+        else if (std::sscanf(type.c_str(), "decimal(%d,%d)", &precision, &scale) == 2 && precision > 0 &&
+                 precision <= 38)
+        {
+            // The fewest bytes whose two's complement holds every unscaled value
+            element.type = AtomicType::FIXED_LEN_BYTE_ARRAY;
+            element.type_length = static_cast<int32_t>(std::ceil((precision * std::log2(10.0) + 1) / 8));
+            element.converted_type = kDecimal;
+            element.precision = precision;
+            element.scale = scale;
+        }
+        else
+        {
+            throw IcebergException("Cannot write columns of type " + type + " to Parquet");
+        }
+    }
+
+    /**
+     * @brief Types whose Parquet PLAIN statistics are their Iceberg single-value bounds;
+     * decimals are stored with another width.
+     */
+    bool sameBounds(const std::string &type)
+    {
+        return type.compare(0, 7, "decimal") != 0;
+    }
+
+    std::string withParentDirectory(std::string location)
+    {
+        std::filesystem::create_directories(std::filesystem::path(localPath(location)).parent_path());
+        return location;
+    }
+
+    std::vector<Literal> checkPartition(std::vector<Literal> partition, const PartitionSpec &spec,
+                                        const std::string &location)
+    {
+        if (partition.size() != spec.fields.size())
+        {
+            throw std::invalid_argument("Partition of " + location + " does not match the spec");
+        }
+        return partition;
+    }
+} // namespace
+
+std::vector<SchemaElement> parquetSchema(const Schema &schema)
+{
+    std::vector<SchemaElement> elements(1);
+    elements[0].name = "table";
+    elements[0].num_children = static_cast<int32_t>(schema.fields.size());
+    for (const NestedField &field : schema.fields)
+    {
+        if (field.name.find('.') != std::string::npos)
+        {
+            throw IcebergException("Cannot write nested column " + field.name + " to Parquet");
+        }
+        SchemaElement &element = elements.emplace_back();
+        element.name = field.name;
+        element.field_id = field.id;
+        element.repetition_type = field.required ? FieldRepetitionType::REQUIRED : FieldRepetitionType::OPTIONAL;
+        setType(element, field.type);
+    }
+    return elements;
+}
+
+std::vector<std::optional<size_t>> fileColumns(const ParquetFileReader &reader, const Schema &schema)
+{
+    std::vector<std::optional<int32_t>> field_ids;
+    const std::vector<SchemaElement> &elements = reader.metadata().schema;
+    for (size_t i = 1; i < elements.size(); ++i)
+    {
+        if (!elements[i].num_children || *elements[i].num_children == 0)
+        {
+            field_ids.push_back(elements[i].field_id);
+        }
+    }
+    std::vector<std::optional<size_t>> columns;
+    columns.reserve(schema.fields.size());
+    for (const NestedField &field : schema.fields)
+    {
+        std::optional<size_t> column;
+        for (size_t c = 0; c < reader.columns().size() && !column; ++c)
+        {
+            bool by_id = c < field_ids.size() && field_ids[c];
+            if (by_id ? *field_ids[c] == field.id : reader.columns()[c].dottedPath() == field.name)
+            {
+                column = c;
+            }
+        }
+        columns.push_back(column);
+    }
+    return columns;
+}
+
+DataFile parquetDataFile(const std::string &location, const ParquetFileReader &reader, const Schema &schema,
+                         const PartitionSpec &spec, std::vector<Literal> partition)
+{
+    DataFile file;
+    file.file_path = location;
+    file.spec_id = spec.spec_id;
+    file.partition = std::move(partition);
+    file.record_count = reader.metadata().num_rows;
+    file.file_size_in_bytes = static_cast<int64_t>(reader.size());
+    for (const RowGroup &row_group : reader.metadata().row_groups)
+    {
+        if (row_group.file_offset)
+        {
+            file.split_offsets.push_back(*row_group.file_offset);
+        }
+        else if (!row_group.columns.empty() && row_group.columns[0].meta_data)
+        {
+            const ColumnMetaData &first = *row_group.columns[0].meta_data;
+            file.split_offsets.push_back(first.dictionary_page_offset.value_or(first.data_page_offset));
+        }
+    }
+
+    std::vector<std::optional<size_t>> columns = fileColumns(reader, schema);
+    for (size_t f = 0; f < schema.fields.size(); ++f)
+    {
+        if (!columns[f])
+        {
+            continue;
+        }
+        const NestedField &field = schema.fields[f];
+        ColumnMetrics metrics;
+        metrics.field_id = field.id;
+        int64_t size = 0;
+        int64_t values = 0;
+        int64_t nulls = 0;
+        bool null_counts = true;
+        bool bounds = sameBounds(field.type);
+        Literal lower;
+        Literal upper;
+        for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+        {
+            const ColumnMetaData &column = reader.columnMetaData(rg, *columns[f]);
+            size += column.total_compressed_size;
+            values += column.num_values;
+            const std::optional<Statistics> &statistics = column.statistics;
+            null_counts = null_counts && statistics && statistics->null_count;
+            nulls += null_counts ? *statistics->null_count : 0;
+            int64_t present = column.num_values - (statistics ? statistics->null_count.value_or(0) : 0);
+            if (!bounds || present == 0)
+            {
+                continue;
+            }
+            if (!statistics || !statistics->min_value || !statistics->max_value)
+            {
+                bounds = false;
+                continue;
+            }
+            Literal min = decodeValue(field.type, *statistics->min_value);
+            Literal max = decodeValue(field.type, *statistics->max_value);
+            if (isNull(min) || isNull(max))
+            {
+                bounds = false;
+                continue;
+            }
+            if (isNull(lower) || compareLiterals(min, lower) < 0)
+            {
+                lower = std::move(min);
+                metrics.lower_bound = *statistics->min_value;
+            }
+            if (isNull(upper) || compareLiterals(max, upper) > 0)
+            {
+                upper = std::move(max);
+                metrics.upper_bound = *statistics->max_value;
+            }
+        }
+        metrics.column_size = size;
+        metrics.value_count = values;
+        if (null_counts)
+        {
+            metrics.null_value_count = nulls;
+        }
+        if (!bounds)
+        {
+            metrics.lower_bound.reset();
+            metrics.upper_bound.reset();
+        }
+        file.metrics.push_back(std::move(metrics));
+    }
+    std::sort(file.metrics.begin(), file.metrics.end(),
+              [](const ColumnMetrics &a, const ColumnMetrics &b) { return a.field_id < b.field_id; });
+    return file;
+}
+
+DataFileWriter::DataFileWriter(std::string location, const Schema &schema, const PartitionSpec &spec,
+                               std::vector<Literal> partition, WriterOptions options)
+    : location_(withParentDirectory(std::move(location))), schema_(schema), spec_(spec),
+      partition_(checkPartition(std::move(partition), spec, location_)),
+      writer_(localPath(location_), parquetSchema(schema), std::move(options)) {}
+
+void DataFileWriter::writeRowGroup(const std::vector<const ColumnBatch *> &batches)
+{
+    writer_.writeRowGroup(batches);
+    record_count_ += batches.empty() ? 0 : static_cast<int64_t>(batches[0]->length());
+}
+
+DataFile DataFileWriter::close()
+{
+    writer_.close();
+    ParquetFileReader reader(localPath(location_));
+    return parquetDataFile(location_, reader, schema_, spec_, partition_);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "expression.hpp"
+#include "formats/parquet_reader.hpp"
+#include "formats/parquet_writer.hpp"
+#include "manifest.hpp"
+#include "table_metadata.hpp"
+
+/**
+ * @brief The Parquet schema of a table schema: one column per field, carrying the field
+ * id, with the physical and converted type of the Iceberg type (e.g. INT64 with
+ * TIMESTAMP_MICROS for timestamptz, FIXED_LEN_BYTE_ARRAY with DECIMAL for decimals).
+ * @throws IcebergException for nested fields and types without a mapping
+ */
+std::vector<SchemaElement> parquetSchema(const Schema &schema);
+
+/**
+ * @brief The file column of every schema field, matched by field id, or by name where
+ * the file has no field ids; nothing for fields the file lacks.
+ */
+std::vector<std::optional<size_t>> fileColumns(const ParquetFileReader &reader, const Schema &schema);
+
+/**
+ * @brief The manifest entry of a Parquet file of the table, from its footer: record count,
+ * size, row group offsets as split offsets and the metrics of every column (sizes, value
+ * and null counts, and bounds merged from the row group statistics).
+ */
+DataFile parquetDataFile(const std::string &location, const ParquetFileReader &reader, const Schema &schema,
+                         const PartitionSpec &spec, std::vector<Literal> partition);
+
+/**
+ * @brief Writes one Parquet data file of a table partition and describes it for a
+ * manifest. Rows go in by row group, one batch per schema field in schema order.
+ */
+class DataFileWriter
+{
+public:
+    /**
+     * @brief Creates the file, and its directory if missing.
+     * @throws IcebergException if the schema cannot be written to Parquet
+     * @throws std::system_error if the file cannot be created
+     */
+    DataFileWriter(std::string location, const Schema &schema, const PartitionSpec &spec,
+                   std::vector<Literal> partition, WriterOptions options = {});
+
+    /**
+     * @throws std::invalid_argument if the batches do not match the schema
+     * @throws std::system_error on I/O errors
+     */
+    void writeRowGroup(const std::vector<const ColumnBatch *> &batches);
+
+    /**
+     * @brief Closes the file and returns its entry.
+     * @throws std::system_error on I/O errors
+     */
+    DataFile close();
+
+    /// Rows written so far
+    int64_t recordCount() const noexcept { return record_count_; }
+
+private:
+    std::string location_;
+    Schema schema_;
+    PartitionSpec spec_;
+    std::vector<Literal> partition_;
+    ParquetFileWriter writer_;
+    int64_t record_count_ = 0;
+};
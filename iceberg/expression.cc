@@ -0,0 +1,543 @@
+#include "expression.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+    constexpr int64_t kMicrosPerHour = int64_t{3600} * 1000000;
+    constexpr int64_t kMicrosPerDay = 24 * kMicrosPerHour;
+
+    bool isIntegerType(std::string_view type)
+    {
+        return type == "int" || type == "long" || type == "date" || type == "time" || type == "timestamp" ||
+               type == "timestamptz" || type == "timestamp_ns" || type == "timestamptz_ns";
+    }
+
+    bool isBytesType(std::string_view type)
+    {
+        return type == "string" || type == "binary" || type == "uuid" || type.starts_with("fixed[");
+    }
+
+    bool isTimestampType(std::string_view type)
+    {
+        return type == "timestamp" || type == "timestamptz";
+    }
+
+    template <typename T>
+    T readLittleEndian(std::string_view bytes)
+    {
+        T value;
+        std::memcpy(&value, bytes.data(), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    std::string littleEndian(T value)
+    {
+        return std::string(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    int64_t floorDiv(int64_t a, int64_t b)
+    {
+        int64_t quotient = a / b;
+        return quotient * b > a ? quotient - 1 : quotient;
+    }
+
+    /**
+     * @brief Year and month (1-12) of a day count since 1970-01-01.
+     */
+    std::pair<int64_t, int64_t> civilFromDays(int64_t days)
+    {
+        int64_t z = days + 719468;
+        int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+        int64_t day_of_era = z - era * 146097;
+        int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+        int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+        int64_t shifted_month = (5 * day_of_year + 2) / 153;
+        int64_t month = shifted_month < 10 ? shifted_month + 3 : shifted_month - 9;
+        return {year_of_era + era * 400 + (month <= 2), month};
+    }
+
+    uint32_t rotateLeft(uint32_t value, int bits)
+    {
+        return (value << bits) | (value >> (32 - bits));
+    }
+
+    uint32_t murmur3(const uint8_t *data, size_t size)
+    {
+        constexpr uint32_t c1 = 0xcc9e2d51;
+        constexpr uint32_t c2 = 0x1b873593;
+        uint32_t hash = 0;
+        size_t blocks = size / 4;
+        for (size_t i = 0; i < blocks; ++i)
+        {
+            uint32_t k;
+            std::memcpy(&k, data + i * 4, 4);
+            k = rotateLeft(k * c1, 15) * c2;
+            hash = rotateLeft(hash ^ k, 13) * 5 + 0xe6546b64;
+        }
+        const uint8_t *tail = data + blocks * 4;
+        uint32_t k = 0;
+        switch (size & 3)
+        {
+        case 3:
+            k ^= static_cast<uint32_t>(tail[2]) << 16;
+            [[fallthrough]];
+        case 2:
+            k ^= static_cast<uint32_t>(tail[1]) << 8;
+            [[fallthrough]];
+        case 1:
+            k ^= tail[0];
+            hash ^= rotateLeft(k * c1, 15) * c2;
+        }
+        hash ^= static_cast<uint32_t>(size);
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6b;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    /**
+     * @brief The first `count` code points of a UTF-8 string.
+     */
+    std::string truncateUtf8(const std::string &value, size_t count)
+    {
+        size_t end = 0;
+        for (size_t points = 0; end < value.size() && points < count; ++points)
+        {
+            ++end;
+            while (end < value.size() && (static_cast<uint8_t>(value[end]) & 0xc0) == 0x80)
+            {
+                ++end;
+            }
+        }
+        return value.substr(0, end);
+    }
+
+    bool isNaN(const Literal &value)
+    {
+        return std::holds_alternative<double>(value) && std::isnan(std::get<double>(value));
+    }
+} // namespace
+
+int compareLiterals(const Literal &a, const Literal &b)
+{
+    if (a.index() != b.index() || isNull(a))
+    {
+        throw std::invalid_argument("Cannot compare literals of different kinds");
+    }
+    if (const auto *x = std::get_if<std::string>(&a))
+    {
+        int result = x->compare(std::get<std::string>(b));
+        return (result > 0) - (result < 0);
+    }
+    return std::visit(
+        [&](const auto &x) -> int
+        {
+            using T = std::decay_t<decltype(x)>;
+            if constexpr (std::is_same_v<T, std::monostate> || std::is_same_v<T, std::string>)
+            {
+                return 0;
+            }
+            else
+            {
+                const T &y = std::get<T>(b);
+                return (x > y) - (x < y);
+            }
+        },
+        a);
+}
+
+Literal decodeValue(std::string_view type, std::string_view bytes)
+{
+    if (type == "boolean")
+    {
+        return bytes.size() == 1 ? Literal(bytes[0] != 0) : Literal();
+    }
+    if (isIntegerType(type))
+    {
+        // Bounds of a long column promoted from int may still be 4 bytes
+        if (bytes.size() == 4)
+        {
+            return static_cast<int64_t>(readLittleEndian<int32_t>(bytes));
+        }
+        return bytes.size() == 8 ? Literal(readLittleEndian<int64_t>(bytes)) : Literal();
+    }
+    if (type == "float" || type == "double")
+    {
+        if (bytes.size() == 4)
+        {
+            return static_cast<double>(readLittleEndian<float>(bytes));
+        }
+        return bytes.size() == 8 ? Literal(readLittleEndian<double>(bytes)) : Literal();
+    }
+    if (isBytesType(type))
+    {
+        return std::string(bytes);
+    }
+    return {};
+}
+
+std::string encodeValue(std::string_view type, const Literal &value)
+{
+    Literal coerced = coerceLiteral(type, value);
+    if (isNull(coerced))
+    {
+        throw std::invalid_argument("Cannot encode the value as " + std::string(type));
+    }
+    if (type == "boolean")
+    {
+        return std::string(1, std::get<bool>(coerced) ? 1 : 0);
+    }
+    if (type == "int" || type == "date")
+    {
+        return littleEndian(static_cast<int32_t>(std::get<int64_t>(coerced)));
+    }
+    if (isIntegerType(type))
+    {
+        return littleEndian(std::get<int64_t>(coerced));
+    }
+    if (type == "float")
+    {
+        return littleEndian(static_cast<float>(std::get<double>(coerced)));
+    }
+    if (type == "double")
+    {
+        return littleEndian(std::get<double>(coerced));
+    }
+    return std::get<std::string>(coerced);
+}
+
+Literal coerceLiteral(std::string_view type, const Literal &value)
+{
+    if (type == "boolean")
+    {
+        return std::holds_alternative<bool>(value) ? value : Literal();
+    }
+    if (isIntegerType(type))
+    {
+        const auto *integer = std::get_if<int64_t>(&value);
+        if (!integer)
+        {
+            return {};
+        }
+        bool narrow = type == "int" || type == "date";
+        if (narrow && (*integer < std::numeric_limits<int32_t>::min() || *integer > std::numeric_limits<int32_t>::max()))
+        {
+            return {};
+        }
+        return value;
+    }
+    if (type == "float" || type == "double")
+    {
+        if (const auto *integer = std::get_if<int64_t>(&value))
+        {
+            return static_cast<double>(*integer);
+        }
+        return std::holds_alternative<double>(value) ? value : Literal();
+    }
+    if (isBytesType(type))
+    {
+        return std::holds_alternative<std::string>(value) ? value : Literal();
+    }
+    return {};
+}
+
+Transform Transform::parse(std::string_view text)
+{
+    auto parameter = [&](std::string_view prefix) -> std::optional<int32_t>
+    {
+        if (!text.starts_with(prefix) || !text.ends_with("]"))
+        {
+            return std::nullopt;
+        }
+        std::string digits(text.substr(prefix.size(), text.size() - prefix.size() - 1));
+        size_t end = 0;
+        int value = 0;
+        try
+        {
+            value = std::stoi(digits, &end);
+        }
+        catch (const std::exception &)
+        {
+            end = std::string::npos;
+        }
+        if (end != digits.size() || value <= 0)
+        {
+            throw std::invalid_argument("Invalid transform " + std::string(text));
+        }
+        return value;
+    };
+    static const std::pair<std::string_view, Kind> kNames[] = {
+        {"identity", kIdentity}, {"year", kYear}, {"month", kMonth}, {"day", kDay}, {"hour", kHour}, {"void", kVoid},
+    };
+    for (const auto &[name, kind] : kNames)
+    {
+        if (text == name)
+        {
+            return {kind, 0};
+        }
+    }
+    if (std::optional<int32_t> buckets = parameter("bucket["))
+    {
+        return {kBucket, *buckets};
+    }
+    if (std::optional<int32_t> width = parameter("truncate["))
+    {
+        return {kTruncate, *width};
+    }
+    throw std::invalid_argument("Unknown transform " + std::string(text));
+}
+
+std::string Transform::toString() const
+{
+    switch (kind)
+    {
+    case kIdentity:
+        return "identity";
+    case kYear:
+        return "year";
+    case kMonth:
+        return "month";
+    case kDay:
+        return "day";
+    case kHour:
+        return "hour";
+    case kBucket:
+        return "bucket[" + std::to_string(parameter) + "]";
+    case kTruncate:
+        return "truncate[" + std::to_string(parameter) + "]";
+    case kVoid:
+        return "void";
+    }
+    return "void";
+}
+
+std::string Transform::resultType(std::string_view source_type) const
+{
+    switch (kind)
+    {
+    case kYear:
+    case kMonth:
+    case kDay:
+    case kHour:
+    case kBucket:
+        return "int";
+    default:
+        return std::string(source_type);
+    }
+}
+
+Literal Transform::apply(std::string_view source_type, const Literal &value) const
+{
+    if (isNull(value) || kind == kVoid)
+    {
+        return {};
+    }
+    auto unsupported = [&]()
+    { return std::invalid_argument("Transform " + toString() + " does not apply to " + std::string(source_type)); };
+    switch (kind)
+    {
+    case kIdentity:
+        return value;
+    case kBucket:
+        return static_cast<int64_t>((bucketHash(source_type, value) & std::numeric_limits<int32_t>::max()) % parameter);
+    case kTruncate:
+        if (const auto *integer = std::get_if<int64_t>(&value);
+            integer && (source_type == "int" || source_type == "long"))
+        {
+            return *integer - (((*integer % parameter) + parameter) % parameter);
+        }
+        if (const auto *bytes = std::get_if<std::string>(&value))
+        {
+            if (source_type == "string")
+            {
+                return truncateUtf8(*bytes, static_cast<size_t>(parameter));
+            }
+            if (source_type == "binary")
+            {
+                return bytes->substr(0, static_cast<size_t>(parameter));
+            }
+        }
+        throw unsupported();
+    default:
+        break;
+    }
+
+    // Year, month, day and hour
+    const auto *integer = std::get_if<int64_t>(&value);
+    bool timestamp = isTimestampType(source_type);
+    if (!integer || (!timestamp && source_type != "date") || (kind == kHour && !timestamp))
+    {
+        throw unsupported();
+    }
+    if (kind == kHour)
+    {
+        return floorDiv(*integer, kMicrosPerHour);
+    }
+    int64_t days = timestamp ? floorDiv(*integer, kMicrosPerDay) : *integer;
+    if (kind == kDay)
+    {
+        return days;
+    }
+    auto [year, month] = civilFromDays(days);
+    return kind == kYear ? year - 1970 : (year - 1970) * 12 + month - 1;
+}
+
+bool evaluate(Operation op, const std::vector<Literal> &values, const Literal &value)
+{
+    if (op == Operation::kIsNull || op == Operation::kNotNull)
+    {
+        return isNull(value) == (op == Operation::kIsNull);
+    }
+    if (isNull(value) || isNaN(value))
+    {
+        return false;
+    }
+    if (op == Operation::kIn)
+    {
+        for (const Literal &candidate : values)
+        {
+            if (compareLiterals(value, candidate) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    int order = compareLiterals(value, values.at(0));
+    switch (op)
+    {
+    case Operation::kEq:
+        return order == 0;
+    case Operation::kNotEq:
+        return order != 0;
+    case Operation::kLt:
+        return order < 0;
+    case Operation::kLtEq:
+        return order <= 0;
+    case Operation::kGt:
+        return order > 0;
+    case Operation::kGtEq:
+        return order >= 0;
+    default:
+        return true;
+    }
+}
+
+bool mightMatch(Operation op, const std::vector<Literal> &values, const Literal &lower, const Literal &upper,
+                int64_t null_count, int64_t value_count)
+{
+    bool all_null = null_count >= 0 && value_count >= 0 && null_count >= value_count;
+    if (op == Operation::kIsNull)
+    {
+        return null_count != 0;
+    }
+    if (op == Operation::kNotNull || all_null)
+    {
+        return !all_null;
+    }
+    for (const Literal &value : values)
+    {
+        if (isNaN(value))
+        {
+            return true;
+        }
+    }
+    auto below = [&](const Literal &value) { return !isNull(lower) && compareLiterals(value, lower) < 0; };
+    auto above = [&](const Literal &value) { return !isNull(upper) && compareLiterals(value, upper) > 0; };
+    switch (op)
+    {
+    case Operation::kEq:
+        return !below(values.at(0)) && !above(values.at(0));
+    case Operation::kNotEq:
+        return isNull(lower) || isNull(upper) || compareLiterals(lower, upper) != 0 ||
+               compareLiterals(lower, values.at(0)) != 0;
+    case Operation::kLt:
+        return isNull(lower) || compareLiterals(lower, values.at(0)) < 0;
+    case Operation::kLtEq:
+        return isNull(lower) || compareLiterals(lower, values.at(0)) <= 0;
+    case Operation::kGt:
+        return isNull(upper) || compareLiterals(upper, values.at(0)) > 0;
+    case Operation::kGtEq:
+        return isNull(upper) || compareLiterals(upper, values.at(0)) >= 0;
+    case Operation::kIn:
+        for (const Literal &value : values)
+        {
+            if (!below(value) && !above(value))
+            {
+                return true;
+            }
+        }
+        return false;
+    default:
+        return true;
+    }
+}
+
+std::optional<Predicate> projectPredicate(const Predicate &predicate, std::string_view source_type,
+                                          const Transform &transform)
+{
+    if (transform.kind == Transform::kVoid)
+    {
+        return std::nullopt;
+    }
+    Predicate projected{predicate.column, predicate.op, {}};
+    if (predicate.op == Operation::kIsNull || predicate.op == Operation::kNotNull)
+    {
+        return projected;
+    }
+    if (transform.kind == Transform::kIdentity)
+    {
+        projected.values = predicate.values;
+        return projected;
+    }
+    if (predicate.op == Operation::kEq || predicate.op == Operation::kIn)
+    {
+        for (const Literal &value : predicate.values)
+        {
+            projected.values.push_back(transform.apply(source_type, value));
+        }
+        return projected;
+    }
+    if (!transform.preservesOrder() || predicate.op == Operation::kNotEq)
+    {
+        return std::nullopt;
+    }
+    // col < v is col <= v - 1 for integers, so the partition value is at most that of v - 1
+    Literal bound = predicate.values.at(0);
+    if (const auto *integer = std::get_if<int64_t>(&bound))
+    {
+        if (predicate.op == Operation::kLt && *integer > std::numeric_limits<int64_t>::min())
+        {
+            bound = *integer - 1;
+        }
+        if (predicate.op == Operation::kGt && *integer < std::numeric_limits<int64_t>::max())
+        {
+            bound = *integer + 1;
+        }
+    }
+    bool upper = predicate.op == Operation::kLt || predicate.op == Operation::kLtEq;
+    projected.op = upper ? Operation::kLtEq : Operation::kGtEq;
+    projected.values.push_back(transform.apply(source_type, bound));
+    return projected;
+}
+
+int32_t bucketHash(std::string_view type, const Literal &value)
+{
+    if (const auto *integer = std::get_if<int64_t>(&value); integer && isIntegerType(type))
+    {
+        int64_t wide = *integer;
+        return static_cast<int32_t>(murmur3(reinterpret_cast<const uint8_t *>(&wide), sizeof(wide)));
+    }
+    if (const auto *bytes = std::get_if<std::string>(&value); bytes && isBytesType(type))
+    {
+        return static_cast<int32_t>(murmur3(reinterpret_cast<const uint8_t *>(bytes->data()), bytes->size()));
+    }
+    throw std::invalid_argument("Cannot bucket a value of type " + std::string(type));
+}
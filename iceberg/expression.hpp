@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// Values, partition transforms and filter predicates.
+//
+// A Literal is null (monostate), a boolean, an integer (int, long, date, time and
+// timestamps, in their Iceberg units), a double (float and double) or a string of bytes
+// (string, binary, fixed and uuid). Values of other types (decimals) are not modeled and
+// never prune anything.
+
+using Literal = std::variant<std::monostate, bool, int64_t, double, std::string>;
+
+inline bool isNull(const Literal &value) noexcept { return std::holds_alternative<std::monostate>(value); }
+
+/**
+ * @brief Compares two non-null literals of the same kind; strings compare as unsigned bytes.
+ * @throws std::invalid_argument if the kinds differ
+ */
+int compareLiterals(const Literal &a, const Literal &b);
+
+/**
+ * @brief Decodes Iceberg's single-value serialization of a value of `type`, as used for
+ * column bounds and partition summaries. Returns null for unsupported types or sizes.
+ */
+Literal decodeValue(std::string_view type, std::string_view bytes);
+
+/**
+ * @brief The single-value serialization of a non-null value of `type`.
+ * @throws std::invalid_argument if the value does not fit the type
+ */
+std::string encodeValue(std::string_view type, const Literal &value);
+
+/**
+ * @brief Converts a literal to the kind of `type` (integers to doubles for floating point
+ * columns), or returns null if it does not fit.
+ */
+Literal coerceLiteral(std::string_view type, const Literal &value);
+
+/**
+ * @brief A partition transform: https://iceberg.apache.org/spec/#partition-transforms
+ */
+struct Transform
+{
+    enum Kind
+    {
+        kIdentity,
+        kYear,
+        kMonth,
+        kDay,
+        kHour,
+        kBucket,
+        kTruncate,
+        kVoid,
+    };
+
+    Kind kind = kIdentity;
+    /// N of bucket[N], W of truncate[W]
+    int32_t parameter = 0;
+
+    /**
+     * @throws std::invalid_argument for unknown transforms
+     */
+    static Transform parse(std::string_view text);
+
+    std::string toString() const;
+
+    /**
+     * @brief The type of the partition values for a source column of `source_type`.
+     */
+    std::string resultType(std::string_view source_type) const;
+
+    /**
+     * @brief The partition value of a source value; null stays null. Year, month, day and
+     * hour count from 1970-01-01 00:00 UTC.
+     * @throws std::invalid_argument if the transform does not apply to the type
+     */
+    Literal apply(std::string_view source_type, const Literal &value) const;
+
+    /**
+     * @brief Whether a <= b implies apply(a) <= apply(b), which lets range predicates be
+     * projected onto the partition values.
+     */
+    bool preservesOrder() const noexcept { return kind != kBucket && kind != kVoid; }
+};
+
+enum class Operation
+{
+    kEq,
+    kNotEq,
+    kLt,
+    kLtEq,
+    kGt,
+    kGtEq,
+    kIn,
+    kIsNull,
+    kNotNull,
+};
+
+/**
+ * @brief `column op value(s)`, where the column is a (dotted) field name of the table
+ * schema. Filters are conjunctions of predicates.
+ */
+struct Predicate
+{
+    std::string column;
+    Operation op = Operation::kEq;
+    /// One for comparisons, any number for kIn, none for kIsNull and kNotNull
+    std::vector<Literal> values;
+
+    static Predicate equal(std::string column, Literal value)
+    {
+        return {std::move(column), Operation::kEq, {std::move(value)}};
+    }
+    static Predicate notEqual(std::string column, Literal value)
+    {
+        return {std::move(column), Operation::kNotEq, {std::move(value)}};
+    }
+    static Predicate lessThan(std::string column, Literal value)
+    {
+        return {std::move(column), Operation::kLt, {std::move(value)}};
+    }
+    static Predicate lessThanOrEqual(std::string column, Literal value)
+    {
+        return {std::move(column), Operation::kLtEq, {std::move(value)}};
+    }
+    static Predicate greaterThan(std::string column, Literal value)
+    {
+        return {std::move(column), Operation::kGt, {std::move(value)}};
+    }
+    static Predicate greaterThanOrEqual(std::string column, Literal value)
+    {
+        return {std::move(column), Operation::kGtEq, {std::move(value)}};
+    }
+    static Predicate in(std::string column, std::vector<Literal> values)
+    {
+        return {std::move(column), Operation::kIn, std::move(values)};
+    }
+    static Predicate isNull(std::string column)
+    {
+        return {std::move(column), Operation::kIsNull, {}};
+    }
+    static Predicate notNull(std::string column)
+    {
+        return {std::move(column), Operation::kNotNull, {}};
+    }
+};
+
+/**
+ * @brief Whether `op values` holds for a single value (null never compares).
+ */
+bool evaluate(Operation op, const std::vector<Literal> &values, const Literal &value);
+
+/**
+ * @brief Whether `op values` may hold for some value in a column chunk, file or manifest
+ * with the given bounds. Null bounds mean unknown; `null_count` and `value_count` are -1
+ * when unknown.
+ */
+bool mightMatch(Operation op, const std::vector<Literal> &values, const Literal &lower, const Literal &upper,
+                int64_t null_count, int64_t value_count);
+
+/**
+ * @brief Projects `column op values` onto the partition values of a transform of the
+ * column: the result holds for the partition value of every row the predicate holds for.
+ * @return nothing if the transform keeps too little of the value to prune with the
+ * predicate (e.g. ranges over a bucket)
+ */
+std::optional<Predicate> projectPredicate(const Predicate &predicate, std::string_view source_type,
+                                          const Transform &transform);
+
+/**
+ * @brief Murmur3 (x86, 32 bit) of a value as Iceberg's bucket transform hashes it.
+ */
+int32_t bucketHash(std::string_view type, const Literal &value);
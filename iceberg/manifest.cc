@@ -0,0 +1,1014 @@
+#include "manifest.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "formats/variant.hpp"
+
+namespace
+{
+    constexpr std::string_view kManifestListSchema = R"({"type":"record","name":"manifest_file","fields":[
+{"name":"manifest_path","type":"string","field-id":500},
+{"name":"manifest_length","type":"long","field-id":501},
+{"name":"partition_spec_id","type":"int","field-id":502},
+{"name":"content","type":"int","field-id":517},
+{"name":"sequence_number","type":"long","field-id":515},
+{"name":"min_sequence_number","type":"long","field-id":516},
+{"name":"added_snapshot_id","type":"long","field-id":503},
+{"name":"added_files_count","type":"int","field-id":504},
+{"name":"existing_files_count","type":"int","field-id":505},
+{"name":"deleted_files_count","type":"int","field-id":506},
+{"name":"added_rows_count","type":"long","field-id":512},
+{"name":"existing_rows_count","type":"long","field-id":513},
+{"name":"deleted_rows_count","type":"long","field-id":514},
+{"name":"partitions","type":["null",{"type":"array","items":{"type":"record","name":"r508","fields":[
+{"name":"contains_null","type":"boolean","field-id":509},
+{"name":"contains_nan","type":["null","boolean"],"default":null,"field-id":518},
+{"name":"lower_bound","type":["null","bytes"],"default":null,"field-id":510},
+{"name":"upper_bound","type":["null","bytes"],"default":null,"field-id":511}]},"element-id":508}],
+"default":null,"field-id":507},
+{"name":"key_metadata","type":["null","bytes"],"default":null,"field-id":519}]})";
+
+    // The partition record is spliced in between the two halves
+    constexpr std::string_view kManifestEntrySchemaHead = R"({"type":"record","name":"manifest_entry","fields":[
+{"name":"status","type":"int","field-id":0},
+{"name":"snapshot_id","type":["null","long"],"default":null,"field-id":1},
+{"name":"sequence_number","type":["null","long"],"default":null,"field-id":3},
+{"name":"file_sequence_number","type":["null","long"],"default":null,"field-id":4},
+{"name":"data_file","type":{"type":"record","name":"r2","fields":[
+{"name":"content","type":"int","field-id":134},
+{"name":"file_path","type":"string","field-id":100},
+{"name":"file_format","type":"string","field-id":101},
+{"name":"partition","field-id":102,"type":)";
+
+    constexpr std::string_view kManifestEntrySchemaTail = R"(},
+{"name":"record_count","type":"long","field-id":103},
+{"name":"file_size_in_bytes","type":"long","field-id":104},
+{"name":"column_sizes","type":["null",{"type":"array","logicalType":"map","items":{"type":"record","name":"k117_v118",
+"fields":[{"name":"key","type":"int","field-id":117},{"name":"value","type":"long","field-id":118}]}}],
+"default":null,"field-id":108},
+{"name":"value_counts","type":["null",{"type":"array","logicalType":"map","items":{"type":"record","name":"k119_v120",
+"fields":[{"name":"key","type":"int","field-id":119},{"name":"value","type":"long","field-id":120}]}}],
+"default":null,"field-id":109},
+{"name":"null_value_counts","type":["null",{"type":"array","logicalType":"map","items":{"type":"record",
+"name":"k121_v122","fields":[{"name":"key","type":"int","field-id":121},{"name":"value","type":"long","field-id":122}]}}],
+"default":null,"field-id":110},
+{"name":"nan_value_counts","type":["null",{"type":"array","logicalType":"map","items":{"type":"record",
+"name":"k138_v139","fields":[{"name":"key","type":"int","field-id":138},{"name":"value","type":"long","field-id":139}]}}],
+"default":null,"field-id":137},
+{"name":"lower_bounds","type":["null",{"type":"array","logicalType":"map","items":{"type":"record","name":"k126_v127",
+"fields":[{"name":"key","type":"int","field-id":126},{"name":"value","type":"bytes","field-id":127}]}}],
+"default":null,"field-id":125},
+{"name":"upper_bounds","type":["null",{"type":"array","logicalType":"map","items":{"type":"record","name":"k129_v130",
+"fields":[{"name":"key","type":"int","field-id":129},{"name":"value","type":"bytes","field-id":130}]}}],
+"default":null,"field-id":128},
+{"name":"key_metadata","type":["null","bytes"],"default":null,"field-id":131},
+{"name":"split_offsets","type":["null",{"type":"array","items":"long","element-id":133}],"default":null,
+"field-id":132},
+{"name":"equality_ids","type":["null",{"type":"array","items":"int","element-id":136}],"default":null,
+"field-id":135},
+{"name":"sort_order_id","type":["null","int"],"default":null,"field-id":140}]},"field-id":2}]})";
+
+    std::string quoted(std::string_view text)
+    {
+        VariantBuilder builder;
+        builder.appendString(text);
+        return builder.finish().view().toJson();
+    }
+
+    /**
+     * @brief The Avro type of partition values of an Iceberg type.
+     */
+    std::string avroType(const std::string &type)
+    {
+        if (type == "boolean" || type == "int" || type == "long" || type == "float" || type == "double" ||
+            type == "string")
+        {
+            return quoted(type);
+        }
+        if (type == "date")
+        {
+            return R"({"type":"int","logicalType":"date"})";
+        }
+        if (type == "time")
+        {
+            return R"({"type":"long","logicalType":"time-micros"})";
+        }
+        if (type == "timestamp" || type == "timestamptz")
+        {
+            return std::string(R"({"type":"long","logicalType":"timestamp-micros","adjust-to-utc":)") +
+                   (type == "timestamptz" ? "true}" : "false}");
+        }
+        if (type == "binary")
+        {
+            return R"("bytes")";
+        }
+        if (type == "uuid")
+        {
+            return R"({"type":"fixed","name":"uuid_fixed","size":16,"logicalType":"uuid"})";
+        }
+        if (type.starts_with("fixed[") && type.ends_with("]"))
+        {
+            std::string size = type.substr(6, type.size() - 7);
+            return R"({"type":"fixed","name":"fixed_)" + size + R"(","size":)" + size + "}";
+        }
+        throw IcebergException("Unsupported partition type " + type);
+    }
+
+    std::string partitionSpecJson(const PartitionSpec &spec)
+    {
+        VariantBuilder builder;
+        builder.beginArray();
+        for (const PartitionField &field : spec.fields)
+        {
+            builder.beginObject();
+            builder.key("name");
+            builder.appendString(field.name);
+            builder.key("transform");
+            builder.appendString(field.transform);
+            builder.key("source-id");
+            builder.appendInt(field.source_id);
+            builder.key("field-id");
+            builder.appendInt(field.field_id);
+            builder.endObject();
+        }
+        builder.endArray();
+        return builder.finish().view().toJson();
+    }
+
+    /**
+     * @brief Reads a primitive value, or the value of a union's branch.
+     */
+    Literal readValue(const AvroNode &node, AvroDecoder &decoder)
+    {
+        switch (node.type)
+        {
+        case AvroType::NULL_TYPE:
+            return {};
+        case AvroType::BOOLEAN:
+            return decoder.readBool();
+        case AvroType::INT:
+        case AvroType::LONG:
+        case AvroType::ENUM:
+            return decoder.readLong();
+        case AvroType::FLOAT:
+            return static_cast<double>(decoder.readFloat());
+        case AvroType::DOUBLE:
+            return decoder.readDouble();
+        case AvroType::BYTES:
+        case AvroType::STRING:
+            return std::string(decoder.readBytes());
+        case AvroType::FIXED:
+            return std::string(decoder.readFixed(node.size));
+        case AvroType::UNION:
+            return readValue(*node.branches[decoder.readUnionIndex(node)], decoder);
+        default:
+            throw AvroException("Expected a primitive Avro value");
+        }
+    }
+
+    /**
+     * @brief The type of the value that follows: the branch of a union, null for a null.
+     */
+    const AvroNode *readPresent(const AvroNode &node, AvroDecoder &decoder)
+    {
+        const AvroNode *value = &node;
+        if (node.type == AvroType::UNION)
+        {
+            value = node.branches[decoder.readUnionIndex(node)];
+        }
+        return value->type == AvroType::NULL_TYPE ? nullptr : value;
+    }
+
+    std::optional<int64_t> readOptionalInt(const AvroNode &node, AvroDecoder &decoder, std::string_view name)
+    {
+        Literal value = readValue(node, decoder);
+        if (isNull(value))
+        {
+            return std::nullopt;
+        }
+        if (const auto *integer = std::get_if<int64_t>(&value))
+        {
+            return *integer;
+        }
+        throw IcebergException("Manifest field " + std::string(name) + " is not an integer");
+    }
+
+    int64_t readInt(const AvroNode &node, AvroDecoder &decoder, std::string_view name)
+    {
+        std::optional<int64_t> value = readOptionalInt(node, decoder, name);
+        if (!value)
+        {
+            throw IcebergException("Manifest field " + std::string(name) + " is null");
+        }
+        return *value;
+    }
+
+    std::string readString(const AvroNode &node, AvroDecoder &decoder, std::string_view name)
+    {
+        Literal value = readValue(node, decoder);
+        if (auto *text = std::get_if<std::string>(&value))
+        {
+            return std::move(*text);
+        }
+        throw IcebergException("Manifest field " + std::string(name) + " is not a string");
+    }
+
+    /**
+     * @brief Calls `item(decoder)` for every item of an (optional) array.
+     */
+    template <typename F>
+    void readArray(const AvroNode &node, AvroDecoder &decoder, std::string_view name, F &&item)
+    {
+        const AvroNode *array = readPresent(node, decoder);
+        if (!array)
+        {
+            return;
+        }
+        if (array->type != AvroType::ARRAY)
+        {
+            throw IcebergException("Manifest field " + std::string(name) + " is not an array");
+        }
+        while (size_t count = decoder.readBlockCount())
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                item(*array->items);
+            }
+        }
+    }
+
+    /**
+     * @brief Calls `entry(key, value)` for every entry of an (optional) int keyed map,
+     * which Iceberg writes as an array of key-value records.
+     */
+    template <typename F>
+    void readIntMap(const AvroNode &node, AvroDecoder &decoder, std::string_view name, F &&entry)
+    {
+        readArray(node, decoder, name,
+                  [&](const AvroNode &item)
+                  {
+                      if (item.type != AvroType::RECORD || item.fields.size() != 2)
+                      {
+                          throw IcebergException("Manifest field " + std::string(name) + " is not a map");
+                      }
+                      bool key_first = item.fields[0].name == "key";
+                      const AvroNode &key_node = *item.fields[key_first ? 0 : 1].type;
+                      const AvroNode &value_node = *item.fields[key_first ? 1 : 0].type;
+                      int64_t key = 0;
+                      Literal value;
+                      if (key_first)
+                      {
+                          key = readInt(key_node, decoder, name);
+                          value = readValue(value_node, decoder);
+                      }
+                      else
+                      {
+                          value = readValue(value_node, decoder);
+                          key = readInt(key_node, decoder, name);
+                      }
+                      entry(static_cast<int32_t>(key), std::move(value));
+                  });
+    }
+
+    /**
+     * @brief The index of each field's name in `names`, -1 for fields to skip.
+     */
+    std::vector<int> fieldCodes(const AvroNode &record, std::initializer_list<std::string_view> names)
+    {
+        if (record.type != AvroType::RECORD)
+        {
+            throw IcebergException("Manifest records are not Avro records");
+        }
+        std::vector<int> codes;
+        for (const AvroField &field : record.fields)
+        {
+            auto it = std::find(names.begin(), names.end(), field.name);
+            codes.push_back(it == names.end() ? -1 : static_cast<int>(it - names.begin()));
+        }
+        return codes;
+    }
+
+    ColumnMetrics &metricsFor(std::vector<ColumnMetrics> &metrics, int32_t field_id)
+    {
+        // Maps list the columns in the same order, so the entry usually goes to the end
+        if (metrics.empty() || metrics.back().field_id < field_id)
+        {
+            ColumnMetrics &added = metrics.emplace_back();
+            added.field_id = field_id;
+            return added;
+        }
+        auto it = std::lower_bound(metrics.begin(), metrics.end(), field_id,
+                                   [](const ColumnMetrics &m, int32_t id) { return m.field_id < id; });
+        if (it == metrics.end() || it->field_id != field_id)
+        {
+            it = metrics.insert(it, ColumnMetrics());
+            it->field_id = field_id;
+        }
+        return *it;
+    }
+
+    std::optional<int64_t> countOf(Literal value)
+    {
+        const auto *integer = std::get_if<int64_t>(&value);
+        return integer ? std::optional<int64_t>(*integer) : std::nullopt;
+    }
+
+    std::optional<std::string> bytesOf(Literal value)
+    {
+        auto *bytes = std::get_if<std::string>(&value);
+        return bytes ? std::optional<std::string>(std::move(*bytes)) : std::nullopt;
+    }
+
+    enum DataFileField
+    {
+        kContent,
+        kFilePath,
+        kFileFormat,
+        kPartition,
+        kRecordCount,
+        kFileSize,
+        kColumnSizes,
+        kValueCounts,
+        kNullValueCounts,
+        kNanValueCounts,
+        kLowerBounds,
+        kUpperBounds,
+        kSplitOffsets,
+        kEqualityIds,
+        kSortOrderId,
+    };
+
+    /**
+     * @brief Decodes the records of a manifest, with the field codes of its schema
+     * computed once per file.
+     */
+    class EntryDecoder
+    {
+    public:
+        EntryDecoder(const AvroNode &entry, const ManifestFile &manifest) : entry_(entry), manifest_(manifest)
+        {
+            entry_codes_ = fieldCodes(entry, {"status", "snapshot_id", "sequence_number", "file_sequence_number",
+                                              "data_file"});
+            std::optional<size_t> data_file = entry.findField("data_file");
+            if (!data_file)
+            {
+                throw IcebergException("Manifest entries without data_file");
+            }
+            const AvroNode &file = entry.fields[*data_file].type->nonNull();
+            file_codes_ = fieldCodes(file, {"content", "file_path", "file_format", "partition", "record_count",
+                                            "file_size_in_bytes", "column_sizes", "value_counts",
+                                            "null_value_counts", "nan_value_counts", "lower_bounds",
+                                            "upper_bounds", "split_offsets", "equality_ids", "sort_order_id"});
+        }
+
+        ManifestEntry decode(AvroDecoder &decoder) const
+        {
+            ManifestEntry entry;
+            std::optional<int64_t> snapshot_id;
+            std::optional<int64_t> sequence_number;
+            std::optional<int64_t> file_sequence_number;
+            for (size_t i = 0; i < entry_.fields.size(); ++i)
+            {
+                const AvroField &field = entry_.fields[i];
+                switch (entry_codes_[i])
+                {
+                case 0:
+                {
+                    int64_t status = readInt(*field.type, decoder, field.name);
+                    if (status < 0 || status > 2)
+                    {
+                        throw IcebergException("Invalid manifest entry status");
+                    }
+                    entry.status = static_cast<ManifestEntryStatus>(status);
+                    break;
+                }
+                case 1:
+                    snapshot_id = readOptionalInt(*field.type, decoder, field.name);
+                    break;
+                case 2:
+                    sequence_number = readOptionalInt(*field.type, decoder, field.name);
+                    break;
+                case 3:
+                    file_sequence_number = readOptionalInt(*field.type, decoder, field.name);
+                    break;
+                case 4:
+                    entry.data_file = decodeFile(field.type->nonNull(), decoder);
+                    break;
+                default:
+                    decoder.skip(*field.type);
+                }
+            }
+            if (!entry.data_file)
+            {
+                throw IcebergException("Manifest entry without data_file");
+            }
+            // Added files inherit from the manifest; others carry their numbers from the
+            // manifest that added them, except in version 1 files, where they are all 0
+            entry.snapshot_id = snapshot_id.value_or(manifest_.added_snapshot_id);
+            entry.sequence_number = sequence_number.value_or(manifest_.sequence_number);
+            entry.file_sequence_number = file_sequence_number.value_or(manifest_.sequence_number);
+            return entry;
+        }
+
+    private:
+        std::shared_ptr<const DataFile> decodeFile(const AvroNode &node, AvroDecoder &decoder) const
+        {
+            auto file = std::make_shared<DataFile>();
+            file->spec_id = manifest_.partition_spec_id;
+            for (size_t i = 0; i < node.fields.size(); ++i)
+            {
+                const AvroField &field = node.fields[i];
+                const AvroNode &type = *field.type;
+                switch (file_codes_[i])
+                {
+                case kContent:
+                {
+                    int64_t content = readInt(type, decoder, field.name);
+                    if (content < 0 || content > 2)
+                    {
+                        throw IcebergException("Invalid data file content");
+                    }
+                    file->content = static_cast<DataFileContent>(content);
+                    break;
+                }
+                case kFilePath:
+                    file->file_path = readString(type, decoder, field.name);
+                    break;
+                case kFileFormat:
+                    file->file_format = readString(type, decoder, field.name);
+                    break;
+                case kPartition:
+                {
+                    const AvroNode &partition = type.nonNull();
+                    if (partition.type != AvroType::RECORD)
+                    {
+                        throw IcebergException("Manifest partition is not a record");
+                    }
+                    file->partition.reserve(partition.fields.size());
+                    for (const AvroField &value : partition.fields)
+                    {
+                        file->partition.push_back(readValue(*value.type, decoder));
+                    }
+                    break;
+                }
+                case kRecordCount:
+                    file->record_count = readInt(type, decoder, field.name);
+                    break;
+                case kFileSize:
+                    file->file_size_in_bytes = readInt(type, decoder, field.name);
+                    break;
+                case kColumnSizes:
+                    readIntMap(type, decoder, field.name, [&](int32_t id, Literal value)
+                               { metricsFor(file->metrics, id).column_size = countOf(std::move(value)); });
+                    break;
+                case kValueCounts:
+                    readIntMap(type, decoder, field.name, [&](int32_t id, Literal value)
+                               { metricsFor(file->metrics, id).value_count = countOf(std::move(value)); });
+                    break;
+                case kNullValueCounts:
+                    readIntMap(type, decoder, field.name, [&](int32_t id, Literal value)
+                               { metricsFor(file->metrics, id).null_value_count = countOf(std::move(value)); });
+                    break;
+                case kNanValueCounts:
+                    readIntMap(type, decoder, field.name, [&](int32_t id, Literal value)
+                               { metricsFor(file->metrics, id).nan_value_count = countOf(std::move(value)); });
+                    break;
+                case kLowerBounds:
+                    readIntMap(type, decoder, field.name, [&](int32_t id, Literal value)
+                               { metricsFor(file->metrics, id).lower_bound = bytesOf(std::move(value)); });
+                    break;
+                case kUpperBounds:
+                    readIntMap(type, decoder, field.name, [&](int32_t id, Literal value)
+                               { metricsFor(file->metrics, id).upper_bound = bytesOf(std::move(value)); });
+                    break;
+                case kSplitOffsets:
+                    readArray(type, decoder, field.name, [&](const AvroNode &item)
+                              { file->split_offsets.push_back(readInt(item, decoder, field.name)); });
+                    break;
+                case kEqualityIds:
+                    readArray(type, decoder, field.name,
+                              [&](const AvroNode &item)
+                              {
+                                  int64_t id = readInt(item, decoder, field.name);
+                                  file->equality_ids.push_back(static_cast<int32_t>(id));
+                              });
+                    break;
+                case kSortOrderId:
+                    if (std::optional<int64_t> id = readOptionalInt(type, decoder, field.name))
+                    {
+                        file->sort_order_id = static_cast<int32_t>(*id);
+                    }
+                    break;
+                default:
+                    decoder.skip(type);
+                }
+            }
+            return file;
+        }
+
+        const AvroNode &entry_;
+        const ManifestFile &manifest_;
+        std::vector<int> entry_codes_;
+        std::vector<int> file_codes_;
+    };
+
+    FieldSummary decodeSummary(const AvroNode &node, AvroDecoder &decoder)
+    {
+        if (node.type != AvroType::RECORD)
+        {
+            throw IcebergException("Partition summary is not a record");
+        }
+        FieldSummary summary;
+        for (const AvroField &field : node.fields)
+        {
+            if (field.name == "contains_null")
+            {
+                Literal value = readValue(*field.type, decoder);
+                summary.contains_null = !std::holds_alternative<bool>(value) || std::get<bool>(value);
+            }
+            else if (field.name == "contains_nan")
+            {
+                Literal value = readValue(*field.type, decoder);
+                if (std::holds_alternative<bool>(value))
+                {
+                    summary.contains_nan = std::get<bool>(value);
+                }
+            }
+            else if (field.name == "lower_bound")
+            {
+                summary.lower_bound = bytesOf(readValue(*field.type, decoder));
+            }
+            else if (field.name == "upper_bound")
+            {
+                summary.upper_bound = bytesOf(readValue(*field.type, decoder));
+            }
+            else
+            {
+                decoder.skip(*field.type);
+            }
+        }
+        return summary;
+    }
+
+    void writeOptionalLong(AvroEncoder &encoder, std::optional<int64_t> value)
+    {
+        encoder.writeUnionIndex(value ? 1 : 0);
+        if (value)
+        {
+            encoder.writeLong(*value);
+        }
+    }
+
+    void writeOptionalBytes(AvroEncoder &encoder, const std::optional<std::string> &value)
+    {
+        encoder.writeUnionIndex(value ? 1 : 0);
+        if (value)
+        {
+            encoder.writeBytes(*value);
+        }
+    }
+
+    /**
+     * @brief Writes the metrics of one kind as a nullable array of key-value records.
+     */
+    template <typename T, typename F>
+    void writeMetrics(AvroEncoder &encoder, const std::vector<ColumnMetrics> &metrics,
+                      std::optional<T> ColumnMetrics::*member, F &&write_value)
+    {
+        size_t count = std::count_if(metrics.begin(), metrics.end(),
+                                     [&](const ColumnMetrics &m) { return (m.*member).has_value(); });
+        if (count == 0)
+        {
+            encoder.writeUnionIndex(0);
+            return;
+        }
+        encoder.writeUnionIndex(1);
+        encoder.writeBlockCount(count);
+        for (const ColumnMetrics &m : metrics)
+        {
+            if ((m.*member).has_value())
+            {
+                encoder.writeInt(m.field_id);
+                write_value(*(m.*member));
+            }
+        }
+        encoder.writeBlockCount(0);
+    }
+
+    /**
+     * @brief Writes a non-null partition value as the Avro type of its Iceberg type.
+     */
+    void writePartitionValue(AvroEncoder &encoder, const std::string &type, const Literal &value)
+    {
+        if (type == "boolean")
+        {
+            encoder.writeBool(std::get<bool>(value));
+        }
+        else if (type == "int" || type == "date")
+        {
+            encoder.writeInt(static_cast<int32_t>(std::get<int64_t>(value)));
+        }
+        else if (type == "long" || type == "time" || type == "timestamp" || type == "timestamptz")
+        {
+            encoder.writeLong(std::get<int64_t>(value));
+        }
+        else if (type == "float")
+        {
+            encoder.writeFloat(static_cast<float>(std::get<double>(value)));
+        }
+        else if (type == "double")
+        {
+            encoder.writeDouble(std::get<double>(value));
+        }
+        else if (type == "string" || type == "binary")
+        {
+            encoder.writeBytes(std::get<std::string>(value));
+        }
+        else
+        {
+            encoder.writeFixed(std::get<std::string>(value));
+        }
+    }
+
+    bool isNaN(const Literal &value)
+    {
+        return std::holds_alternative<double>(value) && std::isnan(std::get<double>(value));
+    }
+} // namespace
+
+const ColumnMetrics *DataFile::findMetrics(int32_t field_id) const
+{
+    auto it = std::lower_bound(metrics.begin(), metrics.end(), field_id,
+                               [](const ColumnMetrics &m, int32_t id) { return m.field_id < id; });
+    return it != metrics.end() && it->field_id == field_id ? &*it : nullptr;
+}
+
+std::vector<ManifestFile> readManifestList(const std::string &location)
+{
+    AvroFileReader reader(LocalFile(localPath(location)));
+    const AvroNode &root = reader.schema().root();
+    std::vector<int> codes =
+        fieldCodes(root, {"manifest_path", "manifest_length", "partition_spec_id", "content", "sequence_number",
+                          "min_sequence_number", "added_snapshot_id", "added_files_count", "added_data_files_count",
+                          "existing_files_count", "existing_data_files_count", "deleted_files_count",
+                          "deleted_data_files_count", "added_rows_count", "existing_rows_count",
+                          "deleted_rows_count", "partitions"});
+
+    std::vector<ManifestFile> manifests;
+    AvroDecoder records;
+    size_t count = 0;
+    while (reader.nextBlock(records, count))
+    {
+        for (size_t r = 0; r < count; ++r)
+        {
+            ManifestFile &manifest = manifests.emplace_back();
+            for (size_t i = 0; i < root.fields.size(); ++i)
+            {
+                const AvroField &field = root.fields[i];
+                const AvroNode &type = *field.type;
+                auto count_of = [&]
+                { return static_cast<int32_t>(readOptionalInt(type, records, field.name).value_or(0)); };
+                switch (codes[i])
+                {
+                case 0:
+                    manifest.manifest_path = readString(type, records, field.name);
+                    break;
+                case 1:
+                    manifest.manifest_length = readInt(type, records, field.name);
+                    break;
+                case 2:
+                    manifest.partition_spec_id = static_cast<int32_t>(readInt(type, records, field.name));
+                    break;
+                case 3:
+                    manifest.content = readInt(type, records, field.name) == 1 ? ManifestContent::DELETES
+                                                                               : ManifestContent::DATA;
+                    break;
+                case 4:
+                    manifest.sequence_number = readOptionalInt(type, records, field.name).value_or(0);
+                    break;
+                case 5:
+                    manifest.min_sequence_number = readOptionalInt(type, records, field.name).value_or(0);
+                    break;
+                case 6:
+                    manifest.added_snapshot_id = readInt(type, records, field.name);
+                    break;
+                case 7:
+                case 8:
+                    manifest.added_files_count = count_of();
+                    break;
+                case 9:
+                case 10:
+                    manifest.existing_files_count = count_of();
+                    break;
+                case 11:
+                case 12:
+                    manifest.deleted_files_count = count_of();
+                    break;
+                case 13:
+                    manifest.added_rows_count = readOptionalInt(type, records, field.name).value_or(0);
+                    break;
+                case 14:
+                    manifest.existing_rows_count = readOptionalInt(type, records, field.name).value_or(0);
+                    break;
+                case 15:
+                    manifest.deleted_rows_count = readOptionalInt(type, records, field.name).value_or(0);
+                    break;
+                case 16:
+                    readArray(type, records, field.name, [&](const AvroNode &item)
+                              { manifest.partitions.push_back(decodeSummary(item, records)); });
+                    break;
+                default:
+                    records.skip(type);
+                }
+            }
+            if (manifest.manifest_path.empty())
+            {
+                throw IcebergException("Manifest list entry without manifest_path");
+            }
+        }
+    }
+    return manifests;
+}
+
+std::vector<ManifestEntry> readManifest(const std::string &location, const ManifestFile &manifest)
+{
+    return readManifest(LocalFile(localPath(location)), manifest);
+}
+
+std::vector<ManifestEntry> readManifest(const RandomAccessFile &file, const ManifestFile &manifest)
+{
+    AvroFileReader reader(file);
+    EntryDecoder decoder(reader.schema().root(), manifest);
+    std::vector<ManifestEntry> entries;
+    AvroDecoder records;
+    size_t count = 0;
+    while (reader.nextBlock(records, count))
+    {
+        entries.reserve(entries.size() + count);
+        for (size_t r = 0; r < count; ++r)
+        {
+            entries.push_back(decoder.decode(records));
+        }
+    }
+    return entries;
+}
+
+ManifestWriter::ManifestWriter(const std::string &location, const Schema &schema, const PartitionSpec &spec,
+                               int64_t snapshot_id, ManifestContent content)
+{
+    std::string partition = R"({"type":"record","name":"r102","fields":[)";
+    for (const PartitionField &field : spec.fields)
+    {
+        const NestedField *source = schema.findById(field.source_id);
+        if (!source)
+        {
+            throw IcebergException("Partition field " + field.name + " of an unknown column");
+        }
+        std::string type;
+        try
+        {
+            type = Transform::parse(field.transform).resultType(source->type);
+        }
+        catch (const std::invalid_argument &e)
+        {
+            throw IcebergException(e.what());
+        }
+        if (&field != &spec.fields.front())
+        {
+            partition += ",";
+        }
+        partition += R"({"name":)" + quoted(field.name) + R"(,"type":["null",)" + avroType(type) +
+                     R"(],"default":null,"field-id":)" + std::to_string(field.field_id) + "}";
+        partition_types_.push_back(std::move(type));
+    }
+    partition += "]}";
+
+    manifest_.manifest_path = location;
+    manifest_.partition_spec_id = spec.spec_id;
+    manifest_.content = content;
+    manifest_.sequence_number = kUnassignedSequenceNumber;
+    manifest_.min_sequence_number = kUnassignedSequenceNumber;
+    manifest_.added_snapshot_id = snapshot_id;
+    manifest_.partitions.resize(spec.fields.size());
+    lower_.resize(spec.fields.size());
+    upper_.resize(spec.fields.size());
+
+    std::vector<std::pair<std::string, std::string>> metadata = {
+        {"schema", schema.json},
+        {"schema-id", std::to_string(schema.schema_id)},
+        {"partition-spec", partitionSpecJson(spec)},
+        {"partition-spec-id", std::to_string(spec.spec_id)},
+        {"format-version", "2"},
+        {"content", content == ManifestContent::DATA ? "data" : "deletes"},
+    };
+    std::string avro_schema =
+        std::string(kManifestEntrySchemaHead) + partition + std::string(kManifestEntrySchemaTail);
+    writer_ = std::make_unique<AvroFileWriter>(localPath(location), avro_schema, metadata);
+}
+
+void ManifestWriter::add(const DataFile &file)
+{
+    write(ManifestEntryStatus::ADDED, manifest_.added_snapshot_id, std::nullopt, std::nullopt, file);
+    ++manifest_.added_files_count;
+    manifest_.added_rows_count += file.record_count;
+}
+
+void ManifestWriter::existing(const ManifestEntry &entry)
+{
+    write(ManifestEntryStatus::EXISTING, entry.snapshot_id, entry.sequence_number, entry.file_sequence_number,
+          *entry.data_file);
+    ++manifest_.existing_files_count;
+    manifest_.existing_rows_count += entry.data_file->record_count;
+}
+
+void ManifestWriter::remove(const ManifestEntry &entry)
+{
+    write(ManifestEntryStatus::DELETED, manifest_.added_snapshot_id, entry.sequence_number,
+          entry.file_sequence_number, *entry.data_file);
+    ++manifest_.deleted_files_count;
+    manifest_.deleted_rows_count += entry.data_file->record_count;
+}
+
+void ManifestWriter::write(ManifestEntryStatus status, std::optional<int64_t> snapshot_id,
+                           std::optional<int64_t> sequence_number, std::optional<int64_t> file_sequence_number,
+                           const DataFile &file)
+{
+    if (file.partition.size() != partition_types_.size())
+    {
+        throw std::invalid_argument("Partition of " + file.file_path + " does not match the spec");
+    }
+    std::vector<Literal> partition;
+    partition.reserve(file.partition.size());
+    for (size_t i = 0; i < file.partition.size(); ++i)
+    {
+        Literal value = coerceLiteral(partition_types_[i], file.partition[i]);
+        if (isNull(value) && !isNull(file.partition[i]))
+        {
+            throw std::invalid_argument("Partition of " + file.file_path + " does not match the spec");
+        }
+        partition.push_back(std::move(value));
+    }
+    if (sequence_number && *sequence_number != kUnassignedSequenceNumber &&
+        (manifest_.min_sequence_number == kUnassignedSequenceNumber ||
+         *sequence_number < manifest_.min_sequence_number))
+    {
+        manifest_.min_sequence_number = *sequence_number;
+    }
+    if (sequence_number == kUnassignedSequenceNumber)
+    {
+        sequence_number.reset();
+    }
+    if (file_sequence_number == kUnassignedSequenceNumber)
+    {
+        file_sequence_number.reset();
+    }
+
+    AvroEncoder &out = writer_->encoder();
+    out.writeInt(static_cast<int32_t>(status));
+    writeOptionalLong(out, snapshot_id);
+    writeOptionalLong(out, sequence_number);
+    writeOptionalLong(out, file_sequence_number);
+
+    out.writeInt(static_cast<int32_t>(file.content));
+    out.writeString(file.file_path);
+    out.writeString(file.file_format);
+    for (size_t i = 0; i < partition.size(); ++i)
+    {
+        const Literal &value = partition[i];
+        FieldSummary &summary = manifest_.partitions[i];
+        if (isNull(value))
+        {
+            out.writeUnionIndex(0);
+            summary.contains_null = true;
+            continue;
+        }
+        out.writeUnionIndex(1);
+        writePartitionValue(out, partition_types_[i], value);
+        if (isNaN(value))
+        {
+            summary.contains_nan = true;
+            continue;
+        }
+        if (isNull(lower_[i]) || compareLiterals(value, lower_[i]) < 0)
+        {
+            lower_[i] = value;
+        }
+        if (isNull(upper_[i]) || compareLiterals(value, upper_[i]) > 0)
+        {
+            upper_[i] = value;
+        }
+    }
+    out.writeLong(file.record_count);
+    out.writeLong(file.file_size_in_bytes);
+    auto write_long = [&](int64_t value) { out.writeLong(value); };
+    auto write_bytes = [&](const std::string &value) { out.writeBytes(value); };
+    writeMetrics(out, file.metrics, &ColumnMetrics::column_size, write_long);
+    writeMetrics(out, file.metrics, &ColumnMetrics::value_count, write_long);
+    writeMetrics(out, file.metrics, &ColumnMetrics::null_value_count, write_long);
+    writeMetrics(out, file.metrics, &ColumnMetrics::nan_value_count, write_long);
+    writeMetrics(out, file.metrics, &ColumnMetrics::lower_bound, write_bytes);
+    writeMetrics(out, file.metrics, &ColumnMetrics::upper_bound, write_bytes);
+    out.writeUnionIndex(0); // key_metadata
+    if (file.split_offsets.empty())
+    {
+        out.writeUnionIndex(0);
+    }
+    else
+    {
+        out.writeUnionIndex(1);
+        out.writeBlockCount(file.split_offsets.size());
+        for (int64_t offset : file.split_offsets)
+        {
+            out.writeLong(offset);
+        }
+        out.writeBlockCount(0);
+    }
+    if (file.equality_ids.empty())
+    {
+        out.writeUnionIndex(0);
+    }
+    else
+    {
+        out.writeUnionIndex(1);
+        out.writeBlockCount(file.equality_ids.size());
+        for (int32_t id : file.equality_ids)
+        {
+            out.writeInt(id);
+        }
+        out.writeBlockCount(0);
+    }
+    writeOptionalLong(out, file.sort_order_id);
+    writer_->endRecord();
+}
+
+ManifestFile ManifestWriter::close()
+{
+    writer_->close();
+    manifest_.manifest_length = static_cast<int64_t>(writer_->size());
+    for (size_t i = 0; i < partition_types_.size(); ++i)
+    {
+        FieldSummary &summary = manifest_.partitions[i];
+        if (!isNull(lower_[i]))
+        {
+            summary.lower_bound = encodeValue(partition_types_[i], lower_[i]);
+            summary.upper_bound = encodeValue(partition_types_[i], upper_[i]);
+        }
+        if (!summary.contains_nan && (partition_types_[i] == "float" || partition_types_[i] == "double"))
+        {
+            summary.contains_nan = false;
+        }
+    }
+    return manifest_;
+}
+
+void writeManifestList(const std::string &location, const std::vector<ManifestFile> &manifests, int64_t snapshot_id,
+                       std::optional<int64_t> parent_snapshot_id, int64_t sequence_number)
+{
+    std::vector<std::pair<std::string, std::string>> metadata = {
+        {"snapshot-id", std::to_string(snapshot_id)},
+        {"parent-snapshot-id", parent_snapshot_id ? std::to_string(*parent_snapshot_id) : "null"},
+        {"sequence-number", std::to_string(sequence_number)},
+        {"format-version", "2"},
+    };
+    AvroFileWriter writer(localPath(location), kManifestListSchema, metadata);
+    AvroEncoder &out = writer.encoder();
+    for (const ManifestFile &manifest : manifests)
+    {
+        auto assigned = [&](int64_t value) { return value == kUnassignedSequenceNumber ? sequence_number : value; };
+        out.writeString(manifest.manifest_path);
+        out.writeLong(manifest.manifest_length);
+        out.writeInt(manifest.partition_spec_id);
+        out.writeInt(static_cast<int32_t>(manifest.content));
+        out.writeLong(assigned(manifest.sequence_number));
+        out.writeLong(assigned(manifest.min_sequence_number));
+        out.writeLong(manifest.added_snapshot_id);
+        out.writeInt(manifest.added_files_count);
+        out.writeInt(manifest.existing_files_count);
+        out.writeInt(manifest.deleted_files_count);
+        out.writeLong(manifest.added_rows_count);
+        out.writeLong(manifest.existing_rows_count);
+        out.writeLong(manifest.deleted_rows_count);
+        out.writeUnionIndex(1);
+        out.writeBlockCount(manifest.partitions.size());
+        for (const FieldSummary &summary : manifest.partitions)
+        {
+            out.writeBool(summary.contains_null);
+            out.writeUnionIndex(summary.contains_nan ? 1 : 0);
+            if (summary.contains_nan)
+            {
+                out.writeBool(*summary.contains_nan);
+            }
+            writeOptionalBytes(out, summary.lower_bound);
+            writeOptionalBytes(out, summary.upper_bound);
+        }
+        if (!manifest.partitions.empty())
+        {
+            out.writeBlockCount(0);
+        }
+        out.writeUnionIndex(0); // key_metadata
+        writer.endRecord();
+    }
+    writer.close();
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "expression.hpp"
+#include "formats/avro.hpp"
+#include "formats/io.hpp"
+#include "table_metadata.hpp"
+
+// Manifest lists and manifests, the Avro files that list a snapshot's data files:
+// https://iceberg.apache.org/spec/#manifests
+//
+// Records are decoded by field name against the schema stored in each file, so files
+// written by other implementations (with more fields, or in another order) and format
+// version 1 files are read too. Files are written in format version 2.
+
+/// The sequence number of manifests and entries that are not committed yet
+constexpr int64_t kUnassignedSequenceNumber = -1;
+
+enum class ManifestContent
+{
+    DATA = 0,
+    DELETES = 1
+};
+
+enum class DataFileContent
+{
+    DATA = 0,
+    POSITION_DELETES = 1,
+    EQUALITY_DELETES = 2
+};
+
+enum class ManifestEntryStatus
+{
+    EXISTING = 0,
+    ADDED = 1,
+    DELETED = 2
+};
+
+/**
+ * @brief The metrics of one column of a data file; absent values are unknown.
+ */
+struct ColumnMetrics
+{
+    int32_t field_id = 0;
+    std::optional<int64_t> column_size;
+    std::optional<int64_t> value_count;
+    std::optional<int64_t> null_value_count;
+    std::optional<int64_t> nan_value_count;
+    /// Single-value serialized bounds
+    std::optional<std::string> lower_bound;
+    std::optional<std::string> upper_bound;
+};
+
+struct DataFile
+{
+    DataFileContent content = DataFileContent::DATA;
+    std::string file_path;
+    std::string file_format = "PARQUET";
+    /// The spec of the manifest the file is listed in
+    int32_t spec_id = 0;
+    /// One value per field of the partition spec
+    std::vector<Literal> partition;
+    int64_t record_count = 0;
+    int64_t file_size_in_bytes = 0;
+    /// Sorted by field id
+    std::vector<ColumnMetrics> metrics;
+    std::vector<int64_t> split_offsets;
+    /// Columns of equality delete files
+    std::vector<int32_t> equality_ids;
+    std::optional<int32_t> sort_order_id;
+
+    const ColumnMetrics *findMetrics(int32_t field_id) const;
+};
+
+struct ManifestEntry
+{
+    ManifestEntryStatus status = ManifestEntryStatus::ADDED;
+    /// Inherited from the manifest when the file leaves them out
+    int64_t snapshot_id = 0;
+    /// The data sequence number, which orders the file against delete files
+    int64_t sequence_number = 0;
+    int64_t file_sequence_number = 0;
+    std::shared_ptr<const DataFile> data_file;
+};
+
+/**
+ * @brief The summary of one partition field over the files of a manifest.
+ */
+struct FieldSummary
+{
+    bool contains_null = false;
+    std::optional<bool> contains_nan;
+    std::optional<std::string> lower_bound;
+    std::optional<std::string> upper_bound;
+};
+
+/**
+ * @brief An entry of a manifest list.
+ */
+struct ManifestFile
+{
+    std::string manifest_path;
+    int64_t manifest_length = 0;
+    int32_t partition_spec_id = 0;
+    ManifestContent content = ManifestContent::DATA;
+    /// 0 in format version 1 manifest lists
+    int64_t sequence_number = 0;
+    int64_t min_sequence_number = 0;
+    int64_t added_snapshot_id = 0;
+    int32_t added_files_count = 0;
+    int32_t existing_files_count = 0;
+    int32_t deleted_files_count = 0;
+    int64_t added_rows_count = 0;
+    int64_t existing_rows_count = 0;
+    int64_t deleted_rows_count = 0;
+    std::vector<FieldSummary> partitions;
+};
+
+/**
+ * @throws AvroException or IcebergException for malformed files
+ * @throws std::system_error on I/O errors
+ */
+std::vector<ManifestFile> readManifestList(const std::string &location);
+
+/**
+ * @brief Reads every entry of a manifest, deleted ones included. Snapshot ids and sequence
+ * numbers the entries leave out are inherited from `manifest`.
+ * @throws AvroException or IcebergException for malformed files
+ * @throws std::system_error on I/O errors
+ */
+std::vector<ManifestEntry> readManifest(const std::string &location, const ManifestFile &manifest);
+std::vector<ManifestEntry> readManifest(const RandomAccessFile &file, const ManifestFile &manifest);
+
+/**
+ * @brief Writes a manifest of one partition spec. Sequence numbers of added files are left
+ * for readers to inherit from the manifest list entry, as the spec requires, so the
+ * manifest can be committed with whatever sequence number the commit gets.
+ */
+class ManifestWriter
+{
+public:
+    /**
+     * @throws IcebergException if the spec references unknown columns
+     * @throws std::system_error if the file cannot be created
+     */
+    ManifestWriter(const std::string &location, const Schema &schema, const PartitionSpec &spec,
+                   int64_t snapshot_id, ManifestContent content = ManifestContent::DATA);
+
+    /**
+     * @brief Lists a file added by this snapshot.
+     * @throws std::invalid_argument if its partition does not match the spec
+     */
+    void add(const DataFile &file);
+
+    /**
+     * @brief Carries over a live entry of an earlier manifest.
+     */
+    void existing(const ManifestEntry &entry);
+
+    /**
+     * @brief Marks an entry of an earlier manifest deleted by this snapshot.
+     */
+    void remove(const ManifestEntry &entry);
+
+    /**
+     * @brief Closes the file and returns its manifest list entry, with the sequence
+     * numbers still to be assigned.
+     * @throws std::system_error on I/O errors
+     */
+    ManifestFile close();
+
+    /// Entries written so far
+    size_t size() const noexcept
+    {
+        return static_cast<size_t>(manifest_.added_files_count) + manifest_.existing_files_count +
+               manifest_.deleted_files_count;
+    }
+
+private:
+    void write(ManifestEntryStatus status, std::optional<int64_t> snapshot_id, std::optional<int64_t> sequence_number,
+               std::optional<int64_t> file_sequence_number, const DataFile &file);
+
+    std::vector<std::string> partition_types_;
+    ManifestFile manifest_;
+    std::vector<Literal> lower_;
+    std::vector<Literal> upper_;
+    std::unique_ptr<AvroFileWriter> writer_;
+};
+
+/**
+ * @brief Writes a snapshot's manifest list. Unassigned sequence numbers of the manifests
+ * become `sequence_number`, the snapshot's.
+ * @throws std::system_error on I/O errors
+ */
+void writeManifestList(const std::string &location, const std::vector<ManifestFile> &manifests, int64_t snapshot_id,
+                       std::optional<int64_t> parent_snapshot_id, int64_t sequence_number);
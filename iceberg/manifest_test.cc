@@ -0,0 +1,330 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "catalog.hpp"
+#include "expression.hpp"
+#include "manifest.hpp"
+#include "table_metadata.hpp"
+
+namespace
+{
+    std::string tempPath(const std::string &name)
+    {
+        return testing::TempDir() + "/" + name;
+    }
+
+    constexpr std::string_view kMetadata = R"json({
+        "format-version": 2,
+        "table-uuid": "9c12d441-03fe-4693-9a96-a0705ddf69c1",
+        "location": "file:///warehouse/db/events",
+        "last-sequence-number": 2,
+        "last-updated-ms": 1700000002000,
+        "last-column-id": 5,
+        "current-schema-id": 1,
+        "schemas": [
+            {"type": "struct", "schema-id": 0, "fields": [{"id": 1, "name": "id", "required": true, "type": "long"}]},
+            {"type": "struct", "schema-id": 1, "identifier-field-ids": [1], "fields": [
+                {"id": 1, "name": "id", "required": true, "type": "long"},
+                {"id": 2, "name": "ts", "required": false, "type": "timestamptz", "doc": "event time"},
+                {"id": 3, "name": "point", "required": false, "type": {"type": "struct", "fields": [
+                    {"id": 4, "name": "x", "required": true, "type": "double"},
+                    {"id": 5, "name": "y", "required": true, "type": "decimal(10, 2)"}]}}]}
+        ],
+        "default-spec-id": 1,
+        "partition-specs": [
+            {"spec-id": 0, "fields": []},
+            {"spec-id": 1, "fields": [{"name": "ts_day", "transform": "day", "source-id": 2, "field-id": 1000}]}
+        ],
+        "last-partition-id": 1000,
+        "default-sort-order-id": 0,
+        "sort-orders": [{"order-id": 0, "fields": []}],
+        "properties": {"owner": "ada", "commit.retry.num-retries": "4"},
+        "current-snapshot-id": 22,
+        "snapshots": [
+            {"snapshot-id": 11, "sequence-number": 1, "timestamp-ms": 1700000001000,
+             "manifest-list": "file:///warehouse/db/events/metadata/snap-11.avro",
+             "summary": {"operation": "append", "added-data-files": "3"}, "schema-id": 0},
+            {"snapshot-id": 22, "parent-snapshot-id": 11, "sequence-number": 2, "timestamp-ms": 1700000002000,
+             "manifest-list": "file:///warehouse/db/events/metadata/snap-22.avro",
+             "summary": {"operation": "overwrite"}, "schema-id": 1}
+        ],
+        "snapshot-log": [{"timestamp-ms": 1700000001000, "snapshot-id": 11},
+                         {"timestamp-ms": 1700000002000, "snapshot-id": 22}],
+        "metadata-log": [{"timestamp-ms": 1700000001000, "metadata-file": "file:///warehouse/db/events/v1.json"}]
+    })json";
+
+    Schema eventSchema()
+    {
+        return Schema::fromFields(0, {{1, "id", "long", true}, {2, "ts", "timestamptz", false},
+                                      {3, "category", "string", false}});
+    }
+
+    PartitionSpec eventSpec()
+    {
+        return {0, {{2, 1000, "ts_day", "day"}, {3, 1001, "category_bucket", "bucket[4]"}}};
+    }
+
+    DataFile dataFile(std::string path, std::vector<Literal> partition, int64_t min_id, int64_t max_id)
+    {
+        DataFile file;
+        file.file_path = std::move(path);
+        file.partition = std::move(partition);
+        file.record_count = max_id - min_id + 1;
+        file.file_size_in_bytes = 1000 + file.record_count;
+        ColumnMetrics &id = file.metrics.emplace_back();
+        id.field_id = 1;
+        id.value_count = file.record_count;
+        id.null_value_count = 0;
+        id.lower_bound = encodeValue("long", min_id);
+        id.upper_bound = encodeValue("long", max_id);
+        ColumnMetrics &category = file.metrics.emplace_back();
+        category.field_id = 3;
+        category.column_size = 77;
+        category.null_value_count = file.record_count;
+        file.split_offsets = {4};
+        return file;
+    }
+} // namespace
+
+TEST(TableMetadataTest, ParsesAndWritesMetadata)
+{
+    TableMetadata metadata = TableMetadata::parse(kMetadata);
+    EXPECT_EQ(metadata.format_version, 2);
+    EXPECT_EQ(metadata.location, "file:///warehouse/db/events");
+    EXPECT_EQ(localPath(metadata.location), "/warehouse/db/events");
+    EXPECT_THROW(localPath("s3://bucket/events"), IcebergException);
+    EXPECT_EQ(metadata.last_sequence_number, 2);
+
+    const Schema &schema = metadata.schema();
+    EXPECT_EQ(schema.schema_id, 1);
+    ASSERT_EQ(schema.fields.size(), 5u);
+    ASSERT_TRUE(schema.find("point.y"));
+    EXPECT_EQ(schema.find("point.y")->type, "decimal(10, 2)");
+    EXPECT_EQ(schema.findById(2)->name, "ts");
+    EXPECT_FALSE(schema.find("missing"));
+
+    EXPECT_TRUE(metadata.spec(0).unpartitioned());
+    EXPECT_EQ(metadata.defaultSpec().fields.at(0).transform, "day");
+    EXPECT_THROW(metadata.spec(7), IcebergException);
+    EXPECT_EQ(metadata.property("owner"), "ada");
+
+    ASSERT_TRUE(metadata.currentSnapshot());
+    EXPECT_EQ(metadata.currentSnapshot()->parent_snapshot_id, 11);
+    EXPECT_EQ(metadata.currentSnapshot()->summaryValue("operation"), "overwrite");
+    EXPECT_EQ(metadata.snapshot(11)->summaryValue("added-data-files"), "3");
+    EXPECT_FALSE(metadata.snapshot(33));
+    EXPECT_FALSE(metadata.snapshotAsOf(1600000000000));
+    EXPECT_EQ(metadata.snapshotAsOf(1700000001500)->snapshot_id, 11);
+    EXPECT_EQ(metadata.snapshotAsOf(1800000000000)->snapshot_id, 22);
+
+    TableMetadata copy = TableMetadata::parse(metadata.toJson());
+    EXPECT_EQ(copy.toJson(), metadata.toJson());
+    EXPECT_EQ(copy.schema().json, schema.json);
+    EXPECT_EQ(copy.metadata_log, metadata.metadata_log);
+
+    // Version 1 keeps a single schema and spec
+    TableMetadata v1 = TableMetadata::parse(R"({"format-version": 1, "location": "/t", "last-column-id": 1,
+        "schema": {"type": "struct", "fields": [{"id": 1, "name": "a", "required": false, "type": "int"}]},
+        "partition-spec": [{"name": "a", "transform": "identity", "source-id": 1, "field-id": 1000}]})");
+    EXPECT_EQ(v1.schema().fields.at(0).name, "a");
+    EXPECT_EQ(v1.defaultSpec().fields.at(0).field_id, 1000);
+    EXPECT_FALSE(v1.currentSnapshot());
+
+    EXPECT_THROW(TableMetadata::parse(R"({"format-version": 3, "location": "/t"})"), IcebergException);
+    EXPECT_THROW(TableMetadata::parse(R"({"format-version": 2})"), IcebergException);
+    EXPECT_THROW(TableMetadata::parse("[1"), IcebergException);
+}
+
+TEST(ExpressionTest, AppliesTransforms)
+{
+    // Test vectors of the specification's bucket transform
+    EXPECT_EQ(bucketHash("int", int64_t{34}), 2017239379);
+    EXPECT_EQ(bucketHash("long", int64_t{34}), 2017239379);
+    EXPECT_EQ(bucketHash("string", std::string("iceberg")), 1210000089);
+    EXPECT_EQ(bucketHash("date", int64_t{17486}), -653330422);
+
+    int64_t ts = 1700000000123456; // 2023-11-14 22:13:20.123456 UTC
+    EXPECT_EQ(Transform::parse("hour").apply("timestamptz", ts), Literal(int64_t{472222}));
+    EXPECT_EQ(Transform::parse("day").apply("timestamptz", ts), Literal(int64_t{19675}));
+    EXPECT_EQ(Transform::parse("month").apply("timestamptz", ts), Literal(int64_t{53 * 12 + 10}));
+    EXPECT_EQ(Transform::parse("year").apply("date", int64_t{19675}), Literal(int64_t{53}));
+    EXPECT_EQ(Transform::parse("day").apply("timestamp", int64_t{-1}), Literal(int64_t{-1}));
+    EXPECT_EQ(Transform::parse("month").apply("date", int64_t{-1}), Literal(int64_t{-1}));
+    EXPECT_EQ(Transform::parse("truncate[10]").apply("long", int64_t{-1}), Literal(int64_t{-10}));
+    EXPECT_EQ(Transform::parse("truncate[2]").apply("string", std::string("héllo")), Literal(std::string("hé")));
+    EXPECT_EQ(Transform::parse("bucket[16]").apply("int", int64_t{34}), Literal(int64_t{2017239379 % 16}));
+    EXPECT_TRUE(isNull(Transform::parse("void").apply("long", int64_t{1})));
+    EXPECT_TRUE(isNull(Transform::parse("day").apply("date", Literal())));
+    EXPECT_EQ(Transform::parse("bucket[16]").resultType("string"), "int");
+    EXPECT_EQ(Transform::parse("truncate[3]").toString(), "truncate[3]");
+    EXPECT_THROW(Transform::parse("bucket[0]"), std::invalid_argument);
+    EXPECT_THROW(Transform::parse("zorder"), std::invalid_argument);
+    EXPECT_THROW(Transform::parse("hour").apply("date", int64_t{1}), std::invalid_argument);
+
+    EXPECT_EQ(encodeValue("int", int64_t{1000}), std::string("\xe8\x03\0\0", 4));
+    EXPECT_EQ(decodeValue("long", encodeValue("long", int64_t{-5})), Literal(int64_t{-5}));
+    EXPECT_EQ(decodeValue("long", encodeValue("int", int64_t{7})), Literal(int64_t{7}));
+    EXPECT_EQ(decodeValue("float", encodeValue("float", 0.5)), Literal(0.5));
+    EXPECT_EQ(decodeValue("string", "abc"), Literal(std::string("abc")));
+    EXPECT_TRUE(isNull(decodeValue("decimal(9, 2)", "\x01")));
+    EXPECT_EQ(coerceLiteral("double", int64_t{2}), Literal(2.0));
+    EXPECT_TRUE(isNull(coerceLiteral("int", int64_t{1} << 40)));
+    EXPECT_THROW(encodeValue("long", std::string("x")), std::invalid_argument);
+}
+
+TEST(ExpressionTest, PrunesWithBoundsAndProjections)
+{
+    Literal lower = int64_t{10};
+    Literal upper = int64_t{20};
+    auto might = [&](const Predicate &p, int64_t nulls = 0, int64_t values = 100)
+    { return mightMatch(p.op, p.values, lower, upper, nulls, values); };
+    EXPECT_TRUE(might(Predicate::equal("x", int64_t{10})));
+    EXPECT_FALSE(might(Predicate::equal("x", int64_t{21})));
+    EXPECT_FALSE(might(Predicate::lessThan("x", int64_t{10})));
+    EXPECT_TRUE(might(Predicate::lessThanOrEqual("x", int64_t{10})));
+    EXPECT_FALSE(might(Predicate::greaterThan("x", int64_t{20})));
+    EXPECT_TRUE(might(Predicate::greaterThanOrEqual("x", int64_t{20})));
+    EXPECT_TRUE(might(Predicate::in("x", {int64_t{1}, int64_t{15}})));
+    EXPECT_FALSE(might(Predicate::in("x", {int64_t{1}, int64_t{25}})));
+    EXPECT_TRUE(might(Predicate::notEqual("x", int64_t{10})));
+    EXPECT_FALSE(might(Predicate::isNull("x")));
+    EXPECT_TRUE(might(Predicate::isNull("x"), -1));
+    EXPECT_TRUE(might(Predicate::notNull("x")));
+    EXPECT_FALSE(might(Predicate::notNull("x"), 100));
+    EXPECT_FALSE(might(Predicate::equal("x", int64_t{15}), 100));
+    lower = Literal();
+    EXPECT_TRUE(might(Predicate::lessThan("x", int64_t{-100})));
+    EXPECT_FALSE(mightMatch(Operation::kNotEq, {int64_t{5}}, int64_t{5}, int64_t{5}, 0, 10));
+
+    EXPECT_TRUE(evaluate(Operation::kIn, {int64_t{1}, int64_t{2}}, int64_t{2}));
+    EXPECT_FALSE(evaluate(Operation::kNotEq, {int64_t{1}}, Literal()));
+    EXPECT_TRUE(evaluate(Operation::kIsNull, {}, Literal()));
+
+    // ts < 2023-11-15 00:00 is day(ts) <= 19675
+    int64_t midnight = int64_t{19676} * 86400 * 1000000;
+    std::optional<Predicate> projected =
+        projectPredicate(Predicate::lessThan("ts", midnight), "timestamptz", Transform::parse("day"));
+    ASSERT_TRUE(projected);
+    EXPECT_EQ(projected->op, Operation::kLtEq);
+    EXPECT_EQ(projected->values, std::vector<Literal>{int64_t{19675}});
+    projected = projectPredicate(Predicate::greaterThan("ts", midnight - 1), "timestamptz", Transform::parse("day"));
+    EXPECT_EQ(projected->op, Operation::kGtEq);
+    EXPECT_EQ(projected->values, std::vector<Literal>{int64_t{19676}});
+    projected = projectPredicate(Predicate::equal("c", std::string("iceberg")), "string", Transform::parse("bucket[4]"));
+    EXPECT_EQ(projected->values, std::vector<Literal>{int64_t{1210000089 % 4}});
+    EXPECT_FALSE(projectPredicate(Predicate::lessThan("c", std::string("x")), "string", Transform::parse("bucket[4]")));
+    EXPECT_FALSE(projectPredicate(Predicate::notEqual("t", int64_t{1}), "date", Transform::parse("month")));
+    EXPECT_TRUE(projectPredicate(Predicate::isNull("t"), "date", Transform::parse("month")));
+}
+
+TEST(ManifestTest, RoundTripsManifestsAndLists)
+{
+    std::string manifest_path = tempPath("manifest.avro");
+    std::string list_path = tempPath("snap.avro");
+    std::filesystem::remove(manifest_path);
+
+    ManifestEntry existing{ManifestEntryStatus::EXISTING, 5, 3, 3,
+                           std::make_shared<DataFile>(dataFile("c.parquet", {int64_t{19001}, int64_t{3}}, 200, 299))};
+    ManifestEntry removed{ManifestEntryStatus::EXISTING, 4, 2, 2,
+                          std::make_shared<DataFile>(dataFile("d.parquet", {int64_t{18999}, Literal()}, 0, 9))};
+    ManifestWriter writer(manifest_path, eventSchema(), eventSpec(), 7);
+    writer.add(dataFile("a.parquet", {int64_t{19000}, int64_t{1}}, 0, 99));
+    writer.add(dataFile("b.parquet", {Literal(), int64_t{2}}, 100, 199));
+    writer.existing(existing);
+    writer.remove(removed);
+    EXPECT_THROW(writer.add(dataFile("e.parquet", {int64_t{1}}, 0, 1)), std::invalid_argument);
+    EXPECT_THROW(writer.add(dataFile("e.parquet", {std::string("x"), int64_t{1}}, 0, 1)), std::invalid_argument);
+    EXPECT_EQ(writer.size(), 4u);
+    ManifestFile manifest = writer.close();
+    EXPECT_EQ(manifest.sequence_number, kUnassignedSequenceNumber);
+    EXPECT_EQ(manifest.min_sequence_number, 2);
+    EXPECT_EQ(manifest.added_files_count, 2);
+    EXPECT_EQ(manifest.added_rows_count, 200);
+    EXPECT_EQ(manifest.existing_rows_count, 100);
+    EXPECT_EQ(manifest.deleted_files_count, 1);
+    EXPECT_EQ(manifest.manifest_length, static_cast<int64_t>(std::filesystem::file_size(manifest_path)));
+    ASSERT_EQ(manifest.partitions.size(), 2u);
+    EXPECT_TRUE(manifest.partitions[0].contains_null);
+    EXPECT_EQ(manifest.partitions[0].lower_bound, encodeValue("int", int64_t{18999}));
+    EXPECT_EQ(manifest.partitions[0].upper_bound, encodeValue("int", int64_t{19001}));
+    EXPECT_TRUE(manifest.partitions[1].contains_null);
+
+    writeManifestList(list_path, {manifest}, 7, 6, 9);
+    std::vector<ManifestFile> manifests = readManifestList(list_path);
+    ASSERT_EQ(manifests.size(), 1u);
+    const ManifestFile &read = manifests[0];
+    EXPECT_EQ(read.manifest_path, manifest_path);
+    EXPECT_EQ(read.sequence_number, 9);
+    EXPECT_EQ(read.min_sequence_number, 2);
+    EXPECT_EQ(read.added_snapshot_id, 7);
+    EXPECT_EQ(read.existing_files_count, 1);
+    EXPECT_EQ(read.partitions[0].upper_bound, manifest.partitions[0].upper_bound);
+    EXPECT_FALSE(read.partitions[1].contains_nan);
+
+    std::vector<ManifestEntry> entries = readManifest(manifest_path, read);
+    ASSERT_EQ(entries.size(), 4u);
+    // Added files inherit the snapshot and sequence number of the manifest
+    EXPECT_EQ(entries[0].status, ManifestEntryStatus::ADDED);
+    EXPECT_EQ(entries[0].snapshot_id, 7);
+    EXPECT_EQ(entries[0].sequence_number, 9);
+    EXPECT_EQ(entries[0].file_sequence_number, 9);
+    EXPECT_EQ(entries[2].status, ManifestEntryStatus::EXISTING);
+    EXPECT_EQ(entries[2].snapshot_id, 5);
+    EXPECT_EQ(entries[2].sequence_number, 3);
+    EXPECT_EQ(entries[3].status, ManifestEntryStatus::DELETED);
+    EXPECT_EQ(entries[3].snapshot_id, 7);
+    EXPECT_EQ(entries[3].sequence_number, 2);
+
+    const DataFile &a = *entries[0].data_file;
+    EXPECT_EQ(a.file_path, "a.parquet");
+    EXPECT_EQ(a.file_format, "PARQUET");
+    EXPECT_EQ(a.partition, (std::vector<Literal>{int64_t{19000}, int64_t{1}}));
+    EXPECT_EQ(a.record_count, 100);
+    EXPECT_EQ(a.split_offsets, std::vector<int64_t>{4});
+    ASSERT_EQ(a.metrics.size(), 2u);
+    ASSERT_TRUE(a.findMetrics(1));
+    EXPECT_EQ(a.findMetrics(1)->upper_bound, encodeValue("long", int64_t{99}));
+    EXPECT_EQ(a.findMetrics(1)->value_count, 100);
+    EXPECT_FALSE(a.findMetrics(1)->column_size);
+    EXPECT_EQ(a.findMetrics(3)->column_size, 77);
+    EXPECT_FALSE(a.findMetrics(2));
+    EXPECT_TRUE(isNull(entries[1].data_file->partition[0]));
+
+    EXPECT_THROW(readManifestList(tempPath("missing.avro")), std::system_error);
+}
+
+TEST(FileCatalogTest, CreatesLoadsAndRegistersTables)
+{
+    std::string root = tempPath("catalog");
+    std::filesystem::remove_all(root);
+    FileCatalog catalog(root);
+    catalog.createNamespace("db");
+    catalog.createNamespace("db");
+    EXPECT_EQ(catalog.listNamespaces(), std::vector<std::string>{"db"});
+
+    TableIdentifier events{"db", "events"};
+    LoadTableResult created = catalog.createTable(events, eventSchema(), eventSpec(), {{"owner", "ada"}});
+    EXPECT_EQ(created.metadata->last_column_id, 3);
+    EXPECT_EQ(created.metadata->last_partition_id, 1001);
+    EXPECT_FALSE(created.metadata->currentSnapshot());
+    EXPECT_THROW(catalog.createTable(events, eventSchema(), eventSpec()), IcebergException);
+    PartitionSpec bad{0, {{9, 1000, "nope", "identity"}}};
+    EXPECT_THROW(catalog.createTable({"db", "bad"}, eventSchema(), bad), IcebergException);
+
+    LoadTableResult loaded = catalog.loadTable(events);
+    EXPECT_EQ(loaded.metadata_location, created.metadata_location);
+    EXPECT_EQ(loaded.metadata->table_uuid, created.metadata->table_uuid);
+    EXPECT_EQ(loaded.metadata->property("owner"), "ada");
+    EXPECT_EQ(loaded.metadata->defaultSpec().fields.size(), 2u);
+
+    catalog.registerTable({"db", "alias"}, created.metadata_location);
+    EXPECT_EQ(catalog.loadTable({"db", "alias"}).metadata->table_uuid, created.metadata->table_uuid);
+    EXPECT_EQ(catalog.listTables("db"), (std::vector<std::string>{"alias", "events"}));
+    EXPECT_THROW(catalog.loadTable({"db", "missing"}), NoSuchTableException);
+
+    // A second catalog on the same root sees the tables
+    EXPECT_EQ(FileCatalog(root).loadTable(events).metadata_location, created.metadata_location);
+}
@@ -0,0 +1,444 @@
+#include "snapshot_update.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+    std::mt19937_64 &generator()
+    {
+        thread_local std::mt19937_64 rng(std::random_device{}());
+        return rng;
+    }
+
+    int64_t nowMillis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void deleteFiles(std::vector<std::string> &locations)
+    {
+        for (const std::string &location : locations)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(localPath(location), ignored);
+        }
+        locations.clear();
+    }
+
+    /**
+     * @brief The wait before the next attempt: exponential from commit.retry.min-wait-ms up
+     * to commit.retry.max-wait-ms, with up to 10% of jitter.
+     */
+    std::chrono::milliseconds backoff(const TableMetadata &metadata, size_t attempts)
+    {
+        int64_t min_wait = std::max<int64_t>(metadata.propertyAsLong("commit.retry.min-wait-ms", 100), 0);
+        int64_t max_wait = std::max<int64_t>(metadata.propertyAsLong("commit.retry.max-wait-ms", 60000), min_wait);
+        int64_t wait = max_wait;
+        if (attempts <= 30 && min_wait <= (max_wait >> (attempts - 1)))
+        {
+            wait = min_wait << (attempts - 1);
+        }
+        wait += static_cast<int64_t>(generator()() % static_cast<uint64_t>(wait / 10 + 1));
+        return std::chrono::milliseconds(wait);
+    }
+
+    bool isLive(const ManifestEntry &entry)
+    {
+        return entry.status != ManifestEntryStatus::DELETED;
+    }
+} // namespace
+
+SnapshotUpdate::SnapshotUpdate(FileCatalog &catalog, TableIdentifier table)
+    : catalog_(catalog), table_(std::move(table)),
+      snapshot_id_(static_cast<int64_t>(generator()() >> 1))
+{
+}
+
+SnapshotUpdate::~SnapshotUpdate()
+{
+    deleteFiles(attempt_files_);
+    if (!committed_)
+    {
+        deleteFiles(update_files_);
+    }
+}
+
+LoadTableResult SnapshotUpdate::commit()
+{
+    if (committed_)
+    {
+        throw std::logic_error("The update of " + table_.toString() + " was committed already");
+    }
+    auto start = std::chrono::steady_clock::now();
+    attempts_ = 0;
+    for (;;)
+    {
+        LoadTableResult base = catalog_.loadTable(table_);
+        const TableMetadata &metadata = *base.metadata;
+        ++attempts_;
+        try
+        {
+            std::vector<ManifestFile> manifests = apply(metadata, snapshot_id_);
+
+            const Snapshot *parent = metadata.currentSnapshot();
+            Snapshot snapshot;
+            snapshot.snapshot_id = snapshot_id_;
+            if (parent)
+            {
+                snapshot.parent_snapshot_id = parent->snapshot_id;
+            }
+            snapshot.sequence_number = metadata.last_sequence_number + 1;
+            snapshot.timestamp_ms = std::max(nowMillis(), metadata.last_updated_ms);
+            snapshot.manifest_list = metadata.location + "/metadata/snap-" + std::to_string(snapshot_id_) + "-" +
+                                     std::to_string(attempts_) + "-" + randomUuid() + ".avro";
+            snapshot.summary = summary(parent);
+            snapshot.schema_id = metadata.current_schema_id;
+            attempt_files_.push_back(snapshot.manifest_list);
+            writeManifestList(snapshot.manifest_list, manifests, snapshot.snapshot_id, snapshot.parent_snapshot_id,
+                              snapshot.sequence_number);
+
+            TableMetadata updated = metadata;
+            updated.last_sequence_number = snapshot.sequence_number;
+            updated.last_updated_ms = snapshot.timestamp_ms;
+            updated.current_snapshot_id = snapshot.snapshot_id;
+            updated.snapshot_log.emplace_back(snapshot.timestamp_ms, snapshot.snapshot_id);
+            updated.snapshots.push_back(std::move(snapshot));
+            LoadTableResult committed = catalog_.commitTable(table_, base, std::move(updated));
+
+            // Manifests of the update that ended up merged into others are not referenced
+            committed_ = true;
+            attempt_files_.clear();
+            std::erase_if(update_files_,
+                          [&](const std::string &location)
+                          {
+                              return std::any_of(manifests.begin(), manifests.end(), [&](const ManifestFile &m)
+                                                 { return m.manifest_path == location; });
+                          });
+            deleteFiles(update_files_);
+            return committed;
+        }
+        catch (const CommitFailedException &)
+        {
+            deleteFiles(attempt_files_);
+            auto retries = std::max<int64_t>(metadata.propertyAsLong("commit.retry.num-retries", 4), 0);
+            int64_t timeout = metadata.propertyAsLong("commit.retry.total-timeout-ms", 1800000);
+            if (static_cast<int64_t>(attempts_) > retries || std::chrono::steady_clock::now() - start >=
+                                                                  std::chrono::milliseconds(timeout))
+            {
+                throw;
+            }
+            std::this_thread::sleep_for(backoff(metadata, attempts_));
+        }
+        catch (...)
+        {
+            deleteFiles(attempt_files_);
+            throw;
+        }
+    }
+}
+
+std::string SnapshotUpdate::newManifestLocation(const TableMetadata &base, bool attempt)
+{
+    std::vector<std::string> &files = attempt ? attempt_files_ : update_files_;
+    std::string location = base.location + "/metadata/" + randomUuid() + "-m" +
+                           std::to_string(attempt_files_.size() + update_files_.size()) + ".avro";
+    files.push_back(location);
+    return location;
+}
+
+std::vector<ManifestFile> SnapshotUpdate::writeManifests(const TableMetadata &base, const std::vector<DataFile> &files,
+                                                         int64_t snapshot_id)
+{
+    std::map<int32_t, std::vector<const DataFile *>> by_spec;
+    for (const DataFile &file : files)
+    {
+        by_spec[file.spec_id].push_back(&file);
+    }
+    std::vector<ManifestFile> manifests;
+    for (const auto &[spec_id, spec_files] : by_spec)
+    {
+        ManifestWriter writer(newManifestLocation(base, false), base.schema(), base.spec(spec_id), snapshot_id);
+        for (const DataFile *file : spec_files)
+        {
+            writer.add(*file);
+        }
+        manifests.push_back(writer.close());
+    }
+    return manifests;
+}
+
+std::vector<std::pair<std::string, std::string>> SnapshotUpdate::summary(const Snapshot *parent) const
+{
+    std::vector<std::pair<std::string, std::string>> summary = {{"operation", operation()}};
+    auto add = [&](const char *key, int64_t value)
+    {
+        if (value != 0)
+        {
+            summary.emplace_back(key, std::to_string(value));
+        }
+    };
+    add("added-data-files", added_files_);
+    add("deleted-data-files", deleted_files_);
+    add("added-records", added_records_);
+    add("deleted-records", deleted_records_);
+    add("added-files-size", added_size_);
+    add("removed-files-size", removed_size_);
+
+    // Totals carry on from the parent's, if it has them
+    auto total = [&](const char *key, int64_t change)
+    {
+        int64_t value = 0;
+        if (parent)
+        {
+            std::optional<std::string_view> text = parent->summaryValue(key);
+            if (!text || std::from_chars(text->data(), text->data() + text->size(), value).ec != std::errc())
+            {
+                return;
+            }
+        }
+        summary.emplace_back(key, std::to_string(value + change));
+    };
+    total("total-data-files", added_files_ - deleted_files_);
+    total("total-records", added_records_ - deleted_records_);
+    total("total-files-size", added_size_ - removed_size_);
+    return summary;
+}
+
+AppendFiles &AppendFiles::appendFile(DataFile file)
+{
+    if (file.content != DataFileContent::DATA)
+    {
+        throw std::invalid_argument("Cannot append delete file " + file.file_path);
+    }
+    if (!manifests_.empty())
+    {
+        throw std::logic_error("Cannot append files once the update was applied");
+    }
+    ++added_files_;
+    added_records_ += file.record_count;
+    added_size_ += file.file_size_in_bytes;
+    files_.push_back(std::move(file));
+    return *this;
+}
+
+std::vector<ManifestFile> AppendFiles::apply(const TableMetadata &base, int64_t snapshot_id)
+{
+    if (manifests_.empty() && !files_.empty())
+    {
+        manifests_ = writeManifests(base, files_, snapshot_id);
+    }
+    std::vector<ManifestFile> data = manifests_;
+    std::vector<ManifestFile> deletes;
+    if (const Snapshot *parent = base.currentSnapshot())
+    {
+        for (ManifestFile &manifest : readManifestList(parent->manifest_list))
+        {
+            (manifest.content == ManifestContent::DATA ? data : deletes).push_back(std::move(manifest));
+        }
+    }
+    if (base.property("commit.manifest-merge.enabled").value_or("true") != "false")
+    {
+        data = merge(base, snapshot_id, std::move(data));
+    }
+    data.insert(data.end(), deletes.begin(), deletes.end());
+    return data;
+}
+
+std::vector<ManifestFile> AppendFiles::merge(const TableMetadata &base, int64_t snapshot_id,
+                                             std::vector<ManifestFile> manifests)
+{
+    auto min_count =
+        static_cast<size_t>(std::max<int64_t>(base.propertyAsLong("commit.manifest.min-count-to-merge", 100), 2));
+    int64_t target = base.propertyAsLong("commit.manifest.target-size-bytes", int64_t{8} << 20);
+    std::map<int32_t, std::vector<const ManifestFile *>> by_spec;
+    for (const ManifestFile &manifest : manifests)
+    {
+        by_spec[manifest.partition_spec_id].push_back(&manifest);
+    }
+
+    std::vector<ManifestFile> result;
+    for (const auto &[spec_id, spec_manifests] : by_spec)
+    {
+        if (spec_manifests.size() < min_count)
+        {
+            for (const ManifestFile *manifest : spec_manifests)
+            {
+                result.push_back(*manifest);
+            }
+            continue;
+        }
+        for (size_t begin = 0, end = 0; begin < spec_manifests.size(); begin = end)
+        {
+            int64_t bytes = spec_manifests[begin]->manifest_length;
+            for (end = begin + 1; end < spec_manifests.size(); ++end)
+            {
+                if (bytes + spec_manifests[end]->manifest_length > target)
+                {
+                    break;
+                }
+                bytes += spec_manifests[end]->manifest_length;
+            }
+            if (end - begin == 1)
+            {
+                result.push_back(*spec_manifests[begin]);
+                continue;
+            }
+            ManifestWriter writer(newManifestLocation(base, true), base.schema(), base.spec(spec_id),
+                                  snapshot_id);
+            for (size_t i = begin; i < end; ++i)
+            {
+                const ManifestFile &manifest = *spec_manifests[i];
+                bool own = std::any_of(manifests_.begin(), manifests_.end(), [&](const ManifestFile &m)
+                                       { return m.manifest_path == manifest.manifest_path; });
+                if (own)
+                {
+                    // Its entries have no sequence numbers yet, added files stay added
+                    for (const DataFile &file : files_)
+                    {
+                        if (file.spec_id == spec_id)
+                        {
+                            writer.add(file);
+                        }
+                    }
+                    continue;
+                }
+                for (const ManifestEntry &entry : readManifest(manifest.manifest_path, manifest))
+                {
+                    if (isLive(entry))
+                    {
+                        writer.existing(entry);
+                    }
+                }
+            }
+            result.push_back(writer.close());
+        }
+    }
+    return result;
+}
+
+RewriteFiles &RewriteFiles::deleteFile(const DataFile &file)
+{
+    if (deleted_.insert(file.file_path).second)
+    {
+        ++deleted_files_;
+        deleted_records_ += file.record_count;
+        removed_size_ += file.file_size_in_bytes;
+    }
+    return *this;
+}
+
+RewriteFiles &RewriteFiles::addFile(DataFile file)
+{
+    if (file.content != DataFileContent::DATA)
+    {
+        throw std::invalid_argument("Cannot add delete file " + file.file_path);
+    }
+    if (!manifests_.empty())
+    {
+        throw std::logic_error("Cannot add files once the update was applied");
+    }
+    ++added_files_;
+    added_records_ += file.record_count;
+    added_size_ += file.file_size_in_bytes;
+    added_.push_back(std::move(file));
+    return *this;
+}
+
+RewriteFiles &RewriteFiles::validateFromSnapshot(int64_t snapshot_id)
+{
+    starting_snapshot_id_ = snapshot_id;
+    return *this;
+}
+
+std::vector<ManifestFile> RewriteFiles::apply(const TableMetadata &base, int64_t snapshot_id)
+{
+    if (manifests_.empty() && !added_.empty())
+    {
+        manifests_ = writeManifests(base, added_, snapshot_id);
+    }
+    std::vector<ManifestFile> listed;
+    if (const Snapshot *parent = base.currentSnapshot())
+    {
+        listed = readManifestList(parent->manifest_list);
+    }
+
+    if (starting_snapshot_id_)
+    {
+        const Snapshot *start = base.snapshot(*starting_snapshot_id_);
+        if (!start)
+        {
+            throw ValidationException("Cannot replace files: snapshot " + std::to_string(*starting_snapshot_id_) +
+                                      " they were read at no longer exists");
+        }
+        std::unordered_set<std::string> known;
+        for (const ManifestFile &manifest : readManifestList(start->manifest_list))
+        {
+            known.insert(manifest.manifest_path);
+        }
+        for (const ManifestFile &manifest : listed)
+        {
+            if (manifest.content == ManifestContent::DELETES && !known.count(manifest.manifest_path) &&
+                manifest.added_files_count + manifest.existing_files_count > 0)
+            {
+                throw ValidationException("Cannot replace files: delete files were added since snapshot " +
+                                          std::to_string(*starting_snapshot_id_));
+            }
+        }
+    }
+
+    std::vector<ManifestFile> result = manifests_;
+    size_t found = 0;
+    for (const ManifestFile &manifest : listed)
+    {
+        if (manifest.content != ManifestContent::DATA || deleted_.empty())
+        {
+            result.push_back(manifest);
+            continue;
+        }
+        std::vector<ManifestEntry> entries = readManifest(manifest.manifest_path, manifest);
+        auto matches = static_cast<size_t>(std::count_if(entries.begin(), entries.end(),
+                                                         [&](const ManifestEntry &entry) {
+                                                             return isLive(entry) &&
+                                                                    deleted_.count(entry.data_file->file_path);
+                                                         }));
+        if (matches == 0)
+        {
+            result.push_back(manifest);
+            continue;
+        }
+        found += matches;
+        ManifestWriter writer(newManifestLocation(base, true), base.schema(),
+                              base.spec(manifest.partition_spec_id), snapshot_id);
+        for (const ManifestEntry &entry : entries)
+        {
+            if (!isLive(entry))
+            {
+                continue;
+            }
+            if (deleted_.count(entry.data_file->file_path))
+            {
+                writer.remove(entry);
+            }
+            else
+            {
+                writer.existing(entry);
+            }
+        }
+        result.push_back(writer.close());
+    }
+    if (found != deleted_.size())
+    {
+        throw ValidationException("Cannot replace files: " + std::to_string(deleted_.size() - found) +
+                                  " of them are no longer in the table");
+    }
+    return result;
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "catalog.hpp"
+#include "manifest.hpp"
+
+/**
+ * @brief An update conflicts with what a concurrent commit did, e.g. a rewrite of files
+ * another commit already removed; unlike CommitFailedException, retrying cannot help.
+ */
+class ValidationException : public IcebergException
+{
+public:
+    using IcebergException::IcebergException;
+};
+
+/**
+ * @brief Produces a snapshot and commits it with optimistic concurrency.
+ *
+ * An attempt loads the table, applies the update on top of its current snapshot, writes
+ * the manifest list and swaps in the new metadata with FileCatalog::commitTable. If
+ * another writer committed in between, the swap fails and the update is applied again on
+ * the new state after an exponential backoff, as configured by the table properties
+ * commit.retry.num-retries (4), commit.retry.min-wait-ms (100), commit.retry.max-wait-ms
+ * (60000) and commit.retry.total-timeout-ms (1800000). Manifests of the update's own files
+ * are written once and shared by all attempts; what a failed attempt wrote is deleted.
+ *
+ * Snapshots get summaries with the added and removed files, records and bytes, and the
+ * table totals where the parent snapshot has them.
+ */
+class SnapshotUpdate
+{
+public:
+    SnapshotUpdate(FileCatalog &catalog, TableIdentifier table);
+
+    /**
+     * @brief Deletes the manifests written for an update that was never committed.
+     */
+    virtual ~SnapshotUpdate();
+
+    SnapshotUpdate(const SnapshotUpdate &) = delete;
+    SnapshotUpdate &operator=(const SnapshotUpdate &) = delete;
+
+    /**
+     * @return The table as committed
+     * @throws CommitFailedException once the retries are exhausted
+     * @throws ValidationException if the update conflicts with a concurrent commit
+     * @throws IcebergException for malformed metadata
+     * @throws std::system_error on I/O errors
+     */
+    LoadTableResult commit();
+
+    /// Attempts the last commit() made, 1 if the first one succeeded
+    size_t attempts() const noexcept { return attempts_; }
+
+protected:
+    /**
+     * @brief The manifests of the new snapshot on top of `base`, whose current snapshot is
+     * the parent (none for the first snapshot).
+     */
+    virtual std::vector<ManifestFile> apply(const TableMetadata &base, int64_t snapshot_id) = 0;
+
+    virtual std::string operation() const = 0;
+
+    /**
+     * @brief A new manifest location in the table's metadata directory. Manifests of one
+     * attempt are deleted when the attempt fails, the others when the update is dropped.
+     */
+    std::string newManifestLocation(const TableMetadata &base, bool attempt);
+
+    /**
+     * @brief Writes a manifest of `files`, grouped by partition spec.
+     */
+    std::vector<ManifestFile> writeManifests(const TableMetadata &base, const std::vector<DataFile> &files,
+                                             int64_t snapshot_id);
+
+    /// Summary counts of the update
+    int64_t added_files_ = 0;
+    int64_t added_records_ = 0;
+    int64_t added_size_ = 0;
+    int64_t deleted_files_ = 0;
+    int64_t deleted_records_ = 0;
+    int64_t removed_size_ = 0;
+
+private:
+    std::vector<std::pair<std::string, std::string>> summary(const Snapshot *parent) const;
+
+    FileCatalog &catalog_;
+    TableIdentifier table_;
+    int64_t snapshot_id_;
+    size_t attempts_ = 0;
+    bool committed_ = false;
+    std::vector<std::string> attempt_files_;
+    std::vector<std::string> update_files_;
+};
+
+/**
+ * @brief Adds data files to a table.
+ *
+ * Every append adds a manifest, so manifests are merged once a spec has
+ * commit.manifest.min-count-to-merge (100) of them: consecutive manifests are packed into
+ * new ones of up to commit.manifest.target-size-bytes (8MB), unless
+ * commit.manifest-merge.enabled is false.
+ */
+class AppendFiles : public SnapshotUpdate
+{
+public:
+    using SnapshotUpdate::SnapshotUpdate;
+
+    /**
+     * @throws std::invalid_argument for delete files
+     */
+    AppendFiles &appendFile(DataFile file);
+
+protected:
+    std::vector<ManifestFile> apply(const TableMetadata &base, int64_t snapshot_id) override;
+    std::string operation() const override { return "append"; }
+
+private:
+    std::vector<ManifestFile> merge(const TableMetadata &base, int64_t snapshot_id,
+                                    std::vector<ManifestFile> manifests);
+
+    std::vector<DataFile> files_;
+    std::vector<ManifestFile> manifests_;
+};
+
+/**
+ * @brief Replaces data files with others holding the same rows, e.g. compacted ones.
+ *
+ * Concurrent appends are kept; the commit fails with a ValidationException if a file to
+ * replace is no longer live, or, with validateFromSnapshot(), if delete files were added
+ * since the rows were read, which could otherwise be lost.
+ */
+class RewriteFiles : public SnapshotUpdate
+{
+public:
+    using SnapshotUpdate::SnapshotUpdate;
+
+    RewriteFiles &deleteFile(const DataFile &file);
+
+    /**
+     * @throws std::invalid_argument for delete files
+     */
+    RewriteFiles &addFile(DataFile file);
+
+    /**
+     * @brief The snapshot the replaced files were read at.
+     */
+    RewriteFiles &validateFromSnapshot(int64_t snapshot_id);
+
+protected:
+    std::vector<ManifestFile> apply(const TableMetadata &base, int64_t snapshot_id) override;
+    std::string operation() const override { return "replace"; }
+
+private:
+    std::unordered_set<std::string> deleted_;
+    std::vector<DataFile> added_;
+    std::vector<ManifestFile> manifests_;
+    std::optional<int64_t> starting_snapshot_id_;
+};
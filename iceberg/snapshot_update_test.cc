@@ -0,0 +1,278 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "data_file_writer.hpp"
+#include "snapshot_update.hpp"
+#include "table_scan.hpp"
+
+namespace
+{
+    const TableIdentifier kTable{"db", "events"};
+
+    class SnapshotUpdateTest : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            root = testing::TempDir() + "/commit_catalog";
+            std::filesystem::remove_all(root);
+            catalog = std::make_unique<FileCatalog>(root);
+            catalog->createNamespace("db");
+        }
+
+        void createTable(std::vector<std::pair<std::string, std::string>> properties)
+        {
+            Schema schema = Schema::fromFields(0, {{1, "id", "long", true}, {2, "name", "string", false}});
+            properties.emplace_back("commit.retry.min-wait-ms", "1");
+            properties.emplace_back("commit.retry.max-wait-ms", "5");
+            catalog->createTable(kTable, schema, PartitionSpec{0, {}}, std::move(properties));
+        }
+
+        static DataFile dataFile(const std::string &path, int64_t records = 10)
+        {
+            DataFile file;
+            file.file_path = path;
+            file.record_count = records;
+            file.file_size_in_bytes = 100 * records;
+            return file;
+        }
+
+        std::vector<std::string> livePaths(std::optional<int64_t> snapshot_id = std::nullopt)
+        {
+            TableScanOptions options;
+            options.snapshot_id = snapshot_id;
+            options.cache = nullptr;
+            std::vector<std::string> paths;
+            for (const FileScanTask &task : TableScan(catalog->loadTable(kTable).metadata, options).plan())
+            {
+                paths.push_back(task.file->file_path);
+            }
+            std::sort(paths.begin(), paths.end());
+            return paths;
+        }
+
+        size_t metadataFiles()
+        {
+            size_t count = 0;
+            for (const auto &entry : std::filesystem::directory_iterator(root + "/db/events/metadata"))
+            {
+                count += entry.path().string().ends_with(".metadata.json");
+            }
+            return count;
+        }
+
+        std::string root;
+        std::unique_ptr<FileCatalog> catalog;
+    };
+} // namespace
+
+TEST(DataFileWriterTest, WritesParquetFilesWithMetrics)
+{
+    std::string location = testing::TempDir() + "/data_file_writer/sub/file.parquet";
+    std::filesystem::remove_all(testing::TempDir() + "/data_file_writer");
+    Schema schema = Schema::fromFields(
+        0, {{1, "id", "long", true}, {2, "name", "string", false}, {3, "day", "date", false}});
+    PartitionSpec spec{0, {{3, 1000, "day", "identity"}}};
+    DataFileWriter writer(location, schema, spec, {int64_t{19000}});
+    for (int64_t g = 0; g < 2; ++g)
+    {
+        ColumnBatch ids(AtomicType::INT64);
+        ColumnBatch names(AtomicType::BYTE_ARRAY);
+        ColumnBatch days(AtomicType::INT32);
+        for (int64_t i = 0; i < 10; ++i)
+        {
+            *ids.appendValues<int64_t>(1) = 100 * g + i;
+            std::string name = "n" + std::to_string(i);
+            if (i % 5 == 0)
+            {
+                names.appendNulls(1);
+            }
+            else
+            {
+                names.appendByteArray(reinterpret_cast<const uint8_t *>(name.data()), name.size());
+            }
+            days.appendNulls(1);
+        }
+        writer.writeRowGroup({&ids, &names, &days});
+    }
+    EXPECT_EQ(writer.recordCount(), 20);
+    DataFile file = writer.close();
+
+    EXPECT_EQ(file.file_path, location);
+    EXPECT_EQ(file.record_count, 20);
+    EXPECT_EQ(file.file_size_in_bytes, static_cast<int64_t>(std::filesystem::file_size(location)));
+    EXPECT_EQ(file.partition, std::vector<Literal>{int64_t{19000}});
+    EXPECT_EQ(file.split_offsets.size(), 2u);
+    EXPECT_EQ(file.split_offsets[0], 4);
+    ASSERT_EQ(file.metrics.size(), 3u);
+    const ColumnMetrics *id = file.findMetrics(1);
+    EXPECT_EQ(id->value_count, 20);
+    EXPECT_EQ(id->null_value_count, 0);
+    EXPECT_EQ(decodeValue("long", *id->lower_bound), Literal(int64_t{0}));
+    EXPECT_EQ(decodeValue("long", *id->upper_bound), Literal(int64_t{109}));
+    const ColumnMetrics *name = file.findMetrics(2);
+    EXPECT_EQ(name->null_value_count, 4);
+    EXPECT_EQ(name->lower_bound, "n1");
+    EXPECT_EQ(name->upper_bound, "n9");
+    // All null, so no bounds
+    const ColumnMetrics *day = file.findMetrics(3);
+    EXPECT_EQ(day->null_value_count, 20);
+    EXPECT_FALSE(day->lower_bound);
+
+    ParquetFileReader reader(location);
+    EXPECT_EQ(reader.metadata().schema[1].field_id, 1);
+    EXPECT_EQ(reader.metadata().schema[3].converted_type, 6);
+    EXPECT_EQ(fileColumns(reader, schema), (std::vector<std::optional<size_t>>{0, 1, 2}));
+
+    EXPECT_THROW(parquetSchema(Schema::fromFields(0, {{1, "tags", "list", false}})), IcebergException);
+    EXPECT_THROW(DataFileWriter(location, schema, spec, {}), std::invalid_argument);
+}
+
+TEST_F(SnapshotUpdateTest, CommitsAppendsAndDetectsConflicts)
+{
+    createTable({});
+    AppendFiles first(*catalog, kTable);
+    first.appendFile(dataFile("a")).appendFile(dataFile("b", 5));
+    LoadTableResult committed = first.commit();
+    EXPECT_EQ(first.attempts(), 1u);
+    EXPECT_THROW(first.commit(), std::logic_error);
+    DataFile deletes = dataFile("d");
+    deletes.content = DataFileContent::POSITION_DELETES;
+    EXPECT_THROW(AppendFiles(*catalog, kTable).appendFile(deletes), std::invalid_argument);
+
+    const TableMetadata &metadata = *committed.metadata;
+    EXPECT_EQ(catalog->loadTable(kTable).metadata_location, committed.metadata_location);
+    EXPECT_EQ(metadata.last_sequence_number, 1);
+    ASSERT_EQ(metadata.snapshots.size(), 1u);
+    const Snapshot &snapshot = metadata.snapshots[0];
+    EXPECT_EQ(snapshot.summaryValue("operation"), "append");
+    EXPECT_EQ(snapshot.summaryValue("added-records"), "15");
+    EXPECT_EQ(snapshot.summaryValue("total-data-files"), "2");
+    EXPECT_EQ(metadata.metadata_log.size(), 1u);
+    EXPECT_EQ(std::filesystem::path(committed.metadata_location).filename().string().substr(0, 6), "00001-");
+
+    // A commit based on stale metadata fails and leaves nothing behind
+    LoadTableResult stale = catalog->loadTable(kTable);
+    AppendFiles second(*catalog, kTable);
+    second.appendFile(dataFile("c"));
+    LoadTableResult current = second.commit();
+    EXPECT_EQ(current.metadata->snapshots.back().summaryValue("total-data-files"), "3");
+    EXPECT_EQ(current.metadata->snapshots.back().parent_snapshot_id, snapshot.snapshot_id);
+    size_t files = metadataFiles();
+    EXPECT_THROW(catalog->commitTable(kTable, stale, *stale.metadata), CommitFailedException);
+    EXPECT_EQ(metadataFiles(), files);
+    EXPECT_EQ(catalog->loadTable(kTable).metadata_location, current.metadata_location);
+    EXPECT_THROW(catalog->commitTable({"db", "missing"}, stale, *stale.metadata), NoSuchTableException);
+
+    EXPECT_EQ(livePaths(), (std::vector<std::string>{"a", "b", "c"}));
+    EXPECT_EQ(livePaths(snapshot.snapshot_id), (std::vector<std::string>{"a", "b"}));
+}
+
+TEST_F(SnapshotUpdateTest, RetriesConcurrentAppends)
+{
+    createTable({{"commit.retry.num-retries", "1000"}});
+    constexpr int kThreads = 4;
+    constexpr int kCommits = 10;
+    std::atomic<size_t> attempts{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t)
+    {
+        threads.emplace_back(
+            [&, t]()
+            {
+                for (int c = 0; c < kCommits; ++c)
+                {
+                    AppendFiles append(*catalog, kTable);
+                    append.appendFile(dataFile(std::to_string(t) + "-" + std::to_string(c)));
+                    append.commit();
+                    attempts += append.attempts();
+                }
+            });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_GE(attempts.load(), size_t{kThreads * kCommits});
+
+    std::shared_ptr<const TableMetadata> metadata = catalog->loadTable(kTable).metadata;
+    EXPECT_EQ(metadata->snapshots.size(), size_t{kThreads * kCommits});
+    EXPECT_EQ(metadata->last_sequence_number, kThreads * kCommits);
+    EXPECT_EQ(metadata->currentSnapshot()->summaryValue("total-data-files"), std::to_string(kThreads * kCommits));
+    EXPECT_EQ(livePaths().size(), size_t{kThreads * kCommits});
+}
+
+TEST_F(SnapshotUpdateTest, MergesManifests)
+{
+    createTable({{"commit.manifest.min-count-to-merge", "3"}});
+    for (int i = 0; i < 5; ++i)
+    {
+        AppendFiles append(*catalog, kTable);
+        append.appendFile(dataFile("f" + std::to_string(i)));
+        append.commit();
+    }
+    std::shared_ptr<const TableMetadata> metadata = catalog->loadTable(kTable).metadata;
+    // Appends 3 and 5 merge the manifests: 1, 2, 3 -> 1, 2, 3 -> 1
+    std::vector<ManifestFile> manifests = readManifestList(metadata->currentSnapshot()->manifest_list);
+    ASSERT_EQ(manifests.size(), 1u);
+    EXPECT_EQ(manifests[0].added_files_count, 1);
+    EXPECT_EQ(manifests[0].existing_files_count, 4);
+    EXPECT_EQ(manifests[0].sequence_number, 5);
+    EXPECT_EQ(manifests[0].min_sequence_number, 1);
+
+    TableScanOptions options;
+    options.cache = nullptr;
+    std::vector<FileScanTask> tasks = TableScan(metadata, options).plan();
+    ASSERT_EQ(tasks.size(), 5u);
+    for (const FileScanTask &task : tasks)
+    {
+        // Files keep the sequence number of the append that added them
+        EXPECT_EQ("f" + std::to_string(task.sequence_number - 1), task.file->file_path);
+    }
+    // The manifests of appends 3 and 5 were merged right away, so only the merged ones
+    // were kept
+    size_t manifest_files = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(root + "/db/events/metadata"))
+    {
+        manifest_files += entry.path().filename().string().find("-m") != std::string::npos;
+    }
+    EXPECT_EQ(manifest_files, 5u);
+}
+
+TEST_F(SnapshotUpdateTest, RewritesFilesAndValidatesConflicts)
+{
+    createTable({});
+    AppendFiles append(*catalog, kTable);
+    append.appendFile(dataFile("a")).appendFile(dataFile("b")).appendFile(dataFile("c"));
+    int64_t start = *append.commit().metadata->current_snapshot_id;
+
+    RewriteFiles rewrite(*catalog, kTable);
+    rewrite.deleteFile(dataFile("a")).deleteFile(dataFile("b")).addFile(dataFile("ab", 20));
+    rewrite.validateFromSnapshot(start);
+    // A concurrent append does not conflict
+    AppendFiles concurrent(*catalog, kTable);
+    concurrent.appendFile(dataFile("d"));
+    concurrent.commit();
+    LoadTableResult committed = rewrite.commit();
+    EXPECT_EQ(livePaths(), (std::vector<std::string>{"ab", "c", "d"}));
+    const Snapshot &snapshot = *committed.metadata->currentSnapshot();
+    EXPECT_EQ(snapshot.summaryValue("operation"), "replace");
+    EXPECT_EQ(snapshot.summaryValue("deleted-data-files"), "2");
+    EXPECT_EQ(snapshot.summaryValue("total-data-files"), "3");
+    EXPECT_EQ(snapshot.summaryValue("total-records"), "40");
+
+    // The files are gone now
+    RewriteFiles again(*catalog, kTable);
+    again.deleteFile(dataFile("a")).addFile(dataFile("a2"));
+    EXPECT_THROW(again.commit(), ValidationException);
+    RewriteFiles expired(*catalog, kTable);
+    expired.deleteFile(dataFile("c")).addFile(dataFile("c2")).validateFromSnapshot(12345);
+    EXPECT_THROW(expired.commit(), ValidationException);
+    EXPECT_EQ(livePaths(), (std::vector<std::string>{"ab", "c", "d"}));
+}
@@ -0,0 +1,561 @@
+#include "table_metadata.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <fcntl.h>
+#include <system_error>
+#include <unistd.h>
+
+#include "formats/io.hpp"
+#include "formats/variant.hpp"
+
+namespace
+{
+    VariantView requiredField(const VariantView &object, std::string_view key)
+    {
+        std::optional<VariantView> value = object.field(key);
+        if (!value || value->isNull())
+        {
+            throw IcebergException("Table metadata without \"" + std::string(key) + "\"");
+        }
+        return *value;
+    }
+
+    std::optional<int64_t> optionalInt(const VariantView &object, std::string_view key)
+    {
+        std::optional<VariantView> value = object.field(key);
+        if (!value || value->isNull())
+        {
+            return std::nullopt;
+        }
+        return value->getInt();
+    }
+
+    std::string optionalString(const VariantView &object, std::string_view key)
+    {
+        std::optional<VariantView> value = object.field(key);
+        return value && !value->isNull() ? std::string(value->getString()) : std::string();
+    }
+
+    std::vector<std::pair<std::string, std::string>> stringMap(const std::optional<VariantView> &object)
+    {
+        std::vector<std::pair<std::string, std::string>> result;
+        for (size_t i = 0; object && i < object->numElements(); ++i)
+        {
+            VariantView value = object->fieldValue(i);
+            result.emplace_back(object->fieldKey(i),
+                                value.type() == VariantType::STRING ? std::string(value.getString()) : value.toJson());
+        }
+        return result;
+    }
+
+    void flattenFields(const VariantView &fields, const std::string &prefix, std::vector<NestedField> &out)
+    {
+        for (size_t i = 0; i < fields.numElements(); ++i)
+        {
+            VariantView field = fields.element(i);
+            NestedField &nested = out.emplace_back();
+            nested.id = static_cast<int32_t>(requiredField(field, "id").getInt());
+            nested.name = prefix + std::string(requiredField(field, "name").getString());
+            nested.required = requiredField(field, "required").getBool();
+            VariantView type = requiredField(field, "type");
+            if (type.type() == VariantType::STRING)
+            {
+                nested.type = type.getString();
+                continue;
+            }
+            nested.type = requiredField(type, "type").getString();
+            if (nested.type == "struct")
+            {
+                std::string name = nested.name + ".";
+                flattenFields(requiredField(type, "fields"), name, out);
+            }
+        }
+    }
+
+    Schema parseSchema(const VariantView &json)
+    {
+        Schema schema;
+        schema.schema_id = static_cast<int32_t>(optionalInt(json, "schema-id").value_or(0));
+        flattenFields(requiredField(json, "fields"), "", schema.fields);
+        schema.json = json.toJson();
+        return schema;
+    }
+
+    PartitionSpec parseSpec(int32_t spec_id, const VariantView &fields)
+    {
+        PartitionSpec spec;
+        spec.spec_id = spec_id;
+        for (size_t i = 0; i < fields.numElements(); ++i)
+        {
+            VariantView field = fields.element(i);
+            PartitionField &out = spec.fields.emplace_back();
+            out.source_id = static_cast<int32_t>(requiredField(field, "source-id").getInt());
+            // Version 1 specs may leave out field ids, which are then assigned from 1000
+            out.field_id = static_cast<int32_t>(optionalInt(field, "field-id").value_or(1000 + static_cast<int64_t>(i)));
+            out.name = requiredField(field, "name").getString();
+            out.transform = requiredField(field, "transform").getString();
+        }
+        return spec;
+    }
+
+    void appendStringMap(VariantBuilder &builder, const std::vector<std::pair<std::string, std::string>> &map)
+    {
+        builder.beginObject();
+        for (const auto &[key, value] : map)
+        {
+            builder.key(key);
+            builder.appendString(value);
+        }
+        builder.endObject();
+    }
+} // namespace
+
+Schema Schema::fromFields(int32_t schema_id, std::vector<NestedField> fields)
+{
+    Schema schema;
+    schema.schema_id = schema_id;
+    VariantBuilder builder;
+    builder.beginObject();
+    builder.key("type");
+    builder.appendString("struct");
+    builder.key("schema-id");
+    builder.appendInt(schema_id);
+    builder.key("fields");
+    builder.beginArray();
+    for (const NestedField &field : fields)
+    {
+        builder.beginObject();
+        builder.key("id");
+        builder.appendInt(field.id);
+        builder.key("name");
+        builder.appendString(field.name);
+        builder.key("required");
+        builder.appendBool(field.required);
+        builder.key("type");
+        builder.appendString(field.type);
+        builder.endObject();
+    }
+    builder.endArray();
+    builder.endObject();
+    schema.json = builder.finish().view().toJson();
+    schema.fields = std::move(fields);
+    return schema;
+}
+
+const NestedField *Schema::find(std::string_view name) const
+{
+    for (const NestedField &field : fields)
+    {
+        if (field.name == name)
+        {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+const NestedField *Schema::findById(int32_t id) const
+{
+    for (const NestedField &field : fields)
+    {
+        if (field.id == id)
+        {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+std::optional<std::string_view> Snapshot::summaryValue(std::string_view key) const
+{
+    for (const auto &[name, value] : summary)
+    {
+        if (name == key)
+        {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+TableMetadata TableMetadata::parse(std::string_view json)
+{
+    TableMetadata metadata;
+    try
+    {
+        Variant parsed = variantFromJson(json);
+        VariantView root = parsed.view();
+        metadata.format_version = static_cast<int32_t>(requiredField(root, "format-version").getInt());
+        if (metadata.format_version < 1 || metadata.format_version > 2)
+        {
+            throw IcebergException("Unsupported table format version " + std::to_string(metadata.format_version));
+        }
+        metadata.table_uuid = optionalString(root, "table-uuid");
+        metadata.location = requiredField(root, "location").getString();
+        metadata.last_sequence_number = optionalInt(root, "last-sequence-number").value_or(0);
+        metadata.last_updated_ms = optionalInt(root, "last-updated-ms").value_or(0);
+        metadata.last_column_id = static_cast<int32_t>(optionalInt(root, "last-column-id").value_or(0));
+
+        if (std::optional<VariantView> schemas = root.field("schemas"))
+        {
+            for (size_t i = 0; i < schemas->numElements(); ++i)
+            {
+                metadata.schemas.push_back(parseSchema(schemas->element(i)));
+            }
+            metadata.current_schema_id = static_cast<int32_t>(requiredField(root, "current-schema-id").getInt());
+        }
+        else
+        {
+            metadata.schemas.push_back(parseSchema(requiredField(root, "schema")));
+            metadata.current_schema_id = metadata.schemas[0].schema_id;
+        }
+
+        if (std::optional<VariantView> specs = root.field("partition-specs"))
+        {
+            for (size_t i = 0; i < specs->numElements(); ++i)
+            {
+                VariantView spec = specs->element(i);
+                metadata.specs.push_back(parseSpec(static_cast<int32_t>(requiredField(spec, "spec-id").getInt()),
+                                                   requiredField(spec, "fields")));
+            }
+            metadata.default_spec_id = static_cast<int32_t>(requiredField(root, "default-spec-id").getInt());
+        }
+        else
+        {
+            metadata.specs.push_back(parseSpec(0, requiredField(root, "partition-spec")));
+        }
+        int32_t last_partition_id = 999;
+        for (const PartitionSpec &spec : metadata.specs)
+        {
+            for (const PartitionField &field : spec.fields)
+            {
+                last_partition_id = std::max(last_partition_id, field.field_id);
+            }
+        }
+        metadata.last_partition_id =
+            static_cast<int32_t>(optionalInt(root, "last-partition-id").value_or(last_partition_id));
+
+        metadata.properties = stringMap(root.field("properties"));
+        std::optional<int64_t> current = optionalInt(root, "current-snapshot-id");
+        if (current && *current != -1)
+        {
+            metadata.current_snapshot_id = current;
+        }
+        if (std::optional<VariantView> snapshots = root.field("snapshots"))
+        {
+            for (size_t i = 0; i < snapshots->numElements(); ++i)
+            {
+                VariantView json_snapshot = snapshots->element(i);
+                Snapshot &snapshot = metadata.snapshots.emplace_back();
+                snapshot.snapshot_id = requiredField(json_snapshot, "snapshot-id").getInt();
+                snapshot.parent_snapshot_id = optionalInt(json_snapshot, "parent-snapshot-id");
+                snapshot.sequence_number = optionalInt(json_snapshot, "sequence-number").value_or(0);
+                snapshot.timestamp_ms = requiredField(json_snapshot, "timestamp-ms").getInt();
+                if (!json_snapshot.field("manifest-list"))
+                {
+                    throw IcebergException("Snapshots without a manifest list are not supported");
+                }
+                snapshot.manifest_list = requiredField(json_snapshot, "manifest-list").getString();
+                snapshot.summary = stringMap(json_snapshot.field("summary"));
+                if (std::optional<int64_t> schema_id = optionalInt(json_snapshot, "schema-id"))
+                {
+                    snapshot.schema_id = static_cast<int32_t>(*schema_id);
+                }
+            }
+        }
+        if (std::optional<VariantView> log = root.field("snapshot-log"))
+        {
+            for (size_t i = 0; i < log->numElements(); ++i)
+            {
+                metadata.snapshot_log.emplace_back(requiredField(log->element(i), "timestamp-ms").getInt(),
+                                                   requiredField(log->element(i), "snapshot-id").getInt());
+            }
+        }
+        if (std::optional<VariantView> log = root.field("metadata-log"))
+        {
+            for (size_t i = 0; i < log->numElements(); ++i)
+            {
+                metadata.metadata_log.emplace_back(requiredField(log->element(i), "timestamp-ms").getInt(),
+                                                   requiredField(log->element(i), "metadata-file").getString());
+            }
+        }
+    }
+    catch (const std::logic_error &e)
+    {
+        throw IcebergException(std::string("Invalid table metadata: ") + e.what());
+    }
+    metadata.schema();
+    metadata.defaultSpec();
+    if (metadata.current_snapshot_id && !metadata.currentSnapshot())
+    {
+        throw IcebergException("The current snapshot of the table is missing");
+    }
+    return metadata;
+}
+
+std::string TableMetadata::toJson() const
+{
+    VariantBuilder builder;
+    builder.beginObject();
+    builder.key("format-version");
+    builder.appendInt(format_version);
+    builder.key("table-uuid");
+    builder.appendString(table_uuid);
+    builder.key("location");
+    builder.appendString(location);
+    builder.key("last-sequence-number");
+    builder.appendInt(last_sequence_number);
+    builder.key("last-updated-ms");
+    builder.appendInt(last_updated_ms);
+    builder.key("last-column-id");
+    builder.appendInt(last_column_id);
+    builder.key("current-schema-id");
+    builder.appendInt(current_schema_id);
+    builder.key("schemas");
+    builder.beginArray();
+    for (const Schema &schema : schemas)
+    {
+        builder.appendJson(schema.json);
+    }
+    builder.endArray();
+    builder.key("default-spec-id");
+    builder.appendInt(default_spec_id);
+    builder.key("partition-specs");
+    builder.beginArray();
+    for (const PartitionSpec &spec : specs)
+    {
+        builder.beginObject();
+        builder.key("spec-id");
+        builder.appendInt(spec.spec_id);
+        builder.key("fields");
+        builder.beginArray();
+        for (const PartitionField &field : spec.fields)
+        {
+            builder.beginObject();
+            builder.key("source-id");
+            builder.appendInt(field.source_id);
+            builder.key("field-id");
+            builder.appendInt(field.field_id);
+            builder.key("name");
+            builder.appendString(field.name);
+            builder.key("transform");
+            builder.appendString(field.transform);
+            builder.endObject();
+        }
+        builder.endArray();
+        builder.endObject();
+    }
+    builder.endArray();
+    builder.key("last-partition-id");
+    builder.appendInt(last_partition_id);
+    builder.key("default-sort-order-id");
+    builder.appendInt(0);
+    builder.key("sort-orders");
+    builder.appendJson(R"([{"order-id": 0, "fields": []}])");
+    builder.key("properties");
+    appendStringMap(builder, properties);
+    builder.key("current-snapshot-id");
+    builder.appendInt(current_snapshot_id.value_or(-1));
+    if (current_snapshot_id)
+    {
+        builder.key("refs");
+        builder.beginObject();
+        builder.key("main");
+        builder.beginObject();
+        builder.key("snapshot-id");
+        builder.appendInt(*current_snapshot_id);
+        builder.key("type");
+        builder.appendString("branch");
+        builder.endObject();
+        builder.endObject();
+    }
+    builder.key("snapshots");
+    builder.beginArray();
+    for (const Snapshot &snapshot : snapshots)
+    {
+        builder.beginObject();
+        builder.key("snapshot-id");
+        builder.appendInt(snapshot.snapshot_id);
+        if (snapshot.parent_snapshot_id)
+        {
+            builder.key("parent-snapshot-id");
+            builder.appendInt(*snapshot.parent_snapshot_id);
+        }
+        builder.key("sequence-number");
+        builder.appendInt(snapshot.sequence_number);
+        builder.key("timestamp-ms");
+        builder.appendInt(snapshot.timestamp_ms);
+        builder.key("manifest-list");
+        builder.appendString(snapshot.manifest_list);
+        builder.key("summary");
+        appendStringMap(builder, snapshot.summary);
+        if (snapshot.schema_id)
+        {
+            builder.key("schema-id");
+            builder.appendInt(*snapshot.schema_id);
+        }
+        builder.endObject();
+    }
+    builder.endArray();
+    builder.key("snapshot-log");
+    builder.beginArray();
+    for (const auto &[timestamp, snapshot_id] : snapshot_log)
+    {
+        builder.beginObject();
+        builder.key("timestamp-ms");
+        builder.appendInt(timestamp);
+        builder.key("snapshot-id");
+        builder.appendInt(snapshot_id);
+        builder.endObject();
+    }
+    builder.endArray();
+    builder.key("metadata-log");
+    builder.beginArray();
+    for (const auto &[timestamp, file] : metadata_log)
+    {
+        builder.beginObject();
+        builder.key("timestamp-ms");
+        builder.appendInt(timestamp);
+        builder.key("metadata-file");
+        builder.appendString(file);
+        builder.endObject();
+    }
+    builder.endArray();
+    builder.endObject();
+    return builder.finish().view().toJson();
+}
+
+const Schema &TableMetadata::schema() const
+{
+    for (const Schema &schema : schemas)
+    {
+        if (schema.schema_id == current_schema_id)
+        {
+            return schema;
+        }
+    }
+    throw IcebergException("The current schema " + std::to_string(current_schema_id) + " of the table is missing");
+}
+
+const PartitionSpec &TableMetadata::spec(int32_t spec_id) const
+{
+    for (const PartitionSpec &spec : specs)
+    {
+        if (spec.spec_id == spec_id)
+        {
+            return spec;
+        }
+    }
+    throw IcebergException("Unknown partition spec " + std::to_string(spec_id));
+}
+
+const Snapshot *TableMetadata::snapshot(int64_t snapshot_id) const
+{
+    for (const Snapshot &snapshot : snapshots)
+    {
+        if (snapshot.snapshot_id == snapshot_id)
+        {
+            return &snapshot;
+        }
+    }
+    return nullptr;
+}
+
+const Snapshot *TableMetadata::currentSnapshot() const
+{
+    return current_snapshot_id ? snapshot(*current_snapshot_id) : nullptr;
+}
+
+const Snapshot *TableMetadata::snapshotAsOf(int64_t timestamp_ms) const
+{
+    const Snapshot *result = nullptr;
+    for (const auto &[timestamp, snapshot_id] : snapshot_log)
+    {
+        if (timestamp <= timestamp_ms)
+        {
+            result = snapshot(snapshot_id);
+        }
+    }
+    return result;
+}
+
+std::optional<std::string_view> TableMetadata::property(std::string_view key) const
+{
+    for (const auto &[name, value] : properties)
+    {
+        if (name == key)
+        {
+            return value;
+        }
+    }
+    return std::nullopt;
+}
+
+int64_t TableMetadata::propertyAsLong(std::string_view key, int64_t default_value) const
+{
+    std::optional<std::string_view> text = property(key);
+    if (!text)
+    {
+        return default_value;
+    }
+    int64_t value = 0;
+    auto [end, error] = std::from_chars(text->data(), text->data() + text->size(), value);
+    if (error != std::errc() || end != text->data() + text->size())
+    {
+        throw IcebergException("Property " + std::string(key) + " is not an integer: " + std::string(*text));
+    }
+    return value;
+}
+
+std::string localPath(std::string_view location)
+{
+    if (location.starts_with("file://"))
+    {
+        return std::string(location.substr(7));
+    }
+    if (location.starts_with("file:"))
+    {
+        return std::string(location.substr(5));
+    }
+    if (location.find("://") != std::string_view::npos)
+    {
+        throw IcebergException("Unsupported location " + std::string(location));
+    }
+    return std::string(location);
+}
+
+TableMetadata readTableMetadata(const std::string &location)
+{
+    LocalFile file(localPath(location));
+    std::string json(file.size(), '\0');
+    file.readAt(0, json.size(), reinterpret_cast<uint8_t *>(json.data()));
+    return TableMetadata::parse(json);
+}
+
+void writeTableMetadata(const std::string &location, const TableMetadata &metadata)
+{
+    std::string path = localPath(location);
+    std::string json = metadata.toJson();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot create " + path);
+    }
+    for (size_t written = 0; written < json.size();)
+    {
+        ssize_t n = ::write(fd, json.data() + written, json.size() - written);
+        if (n < 0 && errno != EINTR)
+        {
+            int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::generic_category(), "Cannot write " + path);
+        }
+        written += n > 0 ? static_cast<size_t>(n) : 0;
+    }
+    if (::close(fd) != 0)
+    {
+        throw std::system_error(errno, std::generic_category(), "Cannot close " + path);
+    }
+}
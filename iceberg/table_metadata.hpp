@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Iceberg table metadata, the JSON file a catalog points to (format versions 1 and 2):
+// https://iceberg.apache.org/spec/#table-metadata
+//
+// Only the parts that planning and appending need are modeled; sort orders and
+// statistics files are not kept.
+
+class IcebergException : public std::runtime_error
+{
+public:
+    explicit IcebergException(const std::string &message)
+        : std::runtime_error(message) {}
+};
+
+/**
+ * @brief A field of a schema. Fields of nested structs are flattened into dotted names;
+ * lists and maps are leaves of type "list" and "map" whose children are not listed.
+ */
+struct NestedField
+{
+    int32_t id = 0;
+    std::string name;
+    /// The primitive type, e.g. "long", "timestamptz" or "decimal(10, 2)"
+    std::string type;
+    bool required = false;
+};
+
+struct Schema
+{
+    int32_t schema_id = 0;
+    std::vector<NestedField> fields;
+    /// The schema as it appears in the metadata JSON
+    std::string json;
+
+    /**
+     * @brief A schema of top level primitive fields.
+     */
+    static Schema fromFields(int32_t schema_id, std::vector<NestedField> fields);
+
+    const NestedField *find(std::string_view name) const;
+    const NestedField *findById(int32_t id) const;
+};
+
+struct PartitionField
+{
+    int32_t source_id = 0;
+    int32_t field_id = 0;
+    std::string name;
+    /// "identity", "year", "month", "day", "hour", "bucket[N]", "truncate[W]" or "void"
+    std::string transform;
+};
+
+struct PartitionSpec
+{
+    int32_t spec_id = 0;
+    std::vector<PartitionField> fields;
+
+    bool unpartitioned() const noexcept { return fields.empty(); }
+};
+
+struct Snapshot
+{
+    int64_t snapshot_id = 0;
+    std::optional<int64_t> parent_snapshot_id;
+    int64_t sequence_number = 0;
+    int64_t timestamp_ms = 0;
+    std::string manifest_list;
+    /// "operation" ("append", "replace", "overwrite", "delete") and counters
+    std::vector<std::pair<std::string, std::string>> summary;
+    std::optional<int32_t> schema_id;
+
+    std::optional<std::string_view> summaryValue(std::string_view key) const;
+};
+
+struct TableMetadata
+{
+    int32_t format_version = 2;
+    std::string table_uuid;
+    std::string location;
+    int64_t last_sequence_number = 0;
+    int64_t last_updated_ms = 0;
+    int32_t last_column_id = 0;
+    int32_t current_schema_id = 0;
+    std::vector<Schema> schemas;
+    int32_t default_spec_id = 0;
+    std::vector<PartitionSpec> specs;
+    int32_t last_partition_id = 999;
+    std::vector<std::pair<std::string, std::string>> properties;
+    std::optional<int64_t> current_snapshot_id;
+    std::vector<Snapshot> snapshots;
+    /// (timestamp-ms, snapshot-id) of every change of the current snapshot
+    std::vector<std::pair<int64_t, int64_t>> snapshot_log;
+    /// (timestamp-ms, metadata-file) of the previous metadata files
+    std::vector<std::pair<int64_t, std::string>> metadata_log;
+
+    /**
+     * @throws IcebergException for malformed or unsupported metadata
+     */
+    static TableMetadata parse(std::string_view json);
+
+    std::string toJson() const;
+
+    /**
+     * @throws IcebergException if the current schema is missing
+     */
+    const Schema &schema() const;
+
+    /**
+     * @throws IcebergException for unknown specs
+     */
+    const PartitionSpec &spec(int32_t spec_id) const;
+    const PartitionSpec &defaultSpec() const { return spec(default_spec_id); }
+
+    /// null for unknown snapshots
+    const Snapshot *snapshot(int64_t snapshot_id) const;
+
+    /// null if the table has no snapshot yet
+    const Snapshot *currentSnapshot() const;
+
+    /**
+     * @brief The snapshot that was current at `timestamp_ms`, following the snapshot log.
+     */
+    const Snapshot *snapshotAsOf(int64_t timestamp_ms) const;
+
+    std::optional<std::string_view> property(std::string_view key) const;
+
+    /**
+     * @throws IcebergException if the property is set but not an integer
+     */
+    int64_t propertyAsLong(std::string_view key, int64_t default_value) const;
+};
+
+/**
+ * @brief The local path of a location: "file:" URIs lose their scheme, plain paths are
+ * kept. Other schemes throw IcebergException.
+ */
+std::string localPath(std::string_view location);
+
+/**
+ * @throws std::system_error if the file cannot be read
+ * @throws IcebergException for malformed or unsupported metadata
+ */
+TableMetadata readTableMetadata(const std::string &location);
+
+/**
+ * @brief Writes the metadata to a new file; an existing file is never replaced, since
+ * metadata files are immutable once a catalog may point to them.
+ * @throws std::system_error if the file exists or cannot be written
+ */
+void writeTableMetadata(const std::string &location, const TableMetadata &metadata);
@@ -0,0 +1,473 @@
+#include "table_scan.hpp"
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "data_file_writer.hpp"
+#include "formats/io.hpp"
+#include "formats/parquet_reader.hpp"
+
+namespace
+{
+    /**
+     * @brief A predicate resolved against the schema, with literals of the column's kind.
+     */
+    struct BoundPredicate
+    {
+        const NestedField *field;
+        Operation op;
+        std::vector<Literal> values;
+    };
+
+    /**
+     * @brief A predicate projected onto a partition field.
+     */
+    struct PartitionPredicate
+    {
+        size_t index;
+        /// Type of the partition values
+        std::string type;
+        Operation op;
+        std::vector<Literal> values;
+    };
+
+    std::vector<BoundPredicate> bindFilter(const Schema &schema, const std::vector<Predicate> &filter)
+    {
+        std::vector<BoundPredicate> bound;
+        for (const Predicate &predicate : filter)
+        {
+            const NestedField *field = schema.find(predicate.column);
+            if (!field)
+            {
+                throw IcebergException("Filter on unknown column " + predicate.column);
+            }
+            if (predicate.op != Operation::kIsNull && predicate.op != Operation::kNotNull &&
+                predicate.values.empty())
+            {
+                throw IcebergException("Filter on " + predicate.column + " without a value");
+            }
+            BoundPredicate &result = bound.emplace_back(BoundPredicate{field, predicate.op, {}});
+            for (const Literal &value : predicate.values)
+            {
+                Literal coerced = coerceLiteral(field->type, value);
+                if (isNull(coerced))
+                {
+                    throw IcebergException("Filter value does not fit column " + field->name + " of type " +
+                                           field->type);
+                }
+                result.values.push_back(std::move(coerced));
+            }
+        }
+        return bound;
+    }
+
+    std::vector<PartitionPredicate> project(const PartitionSpec &spec, const std::vector<BoundPredicate> &filter)
+    {
+        std::vector<PartitionPredicate> projected;
+        for (const BoundPredicate &predicate : filter)
+        {
+            for (size_t i = 0; i < spec.fields.size(); ++i)
+            {
+                const PartitionField &field = spec.fields[i];
+                if (field.source_id != predicate.field->id)
+                {
+                    continue;
+                }
+                try
+                {
+                    Transform transform = Transform::parse(field.transform);
+                    Predicate source{predicate.field->name, predicate.op, predicate.values};
+                    if (std::optional<Predicate> result = projectPredicate(source, predicate.field->type, transform))
+                    {
+                        projected.push_back(PartitionPredicate{i, transform.resultType(predicate.field->type),
+                                                               result->op, std::move(result->values)});
+                    }
+                }
+                catch (const std::invalid_argument &)
+                {
+                    // A transform that does not apply to the column prunes nothing
+                }
+            }
+        }
+        return projected;
+    }
+
+    bool manifestMightMatch(const ManifestFile &manifest, const std::vector<PartitionPredicate> &filter)
+    {
+        for (const PartitionPredicate &predicate : filter)
+        {
+            if (predicate.index >= manifest.partitions.size())
+            {
+                continue;
+            }
+            const FieldSummary &summary = manifest.partitions[predicate.index];
+            Literal lower = summary.lower_bound ? decodeValue(predicate.type, *summary.lower_bound) : Literal();
+            Literal upper = summary.upper_bound ? decodeValue(predicate.type, *summary.upper_bound) : Literal();
+            // Without bounds or NaNs every value is null, if there are values at all
+            bool all_null = summary.contains_null && !summary.lower_bound && !summary.upper_bound &&
+                            !summary.contains_nan.value_or(false);
+            int64_t null_count = all_null ? 1 : (summary.contains_null ? -1 : 0);
+            if (!mightMatch(predicate.op, predicate.values, lower, upper, null_count, all_null ? 1 : -1))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool partitionMatches(const std::vector<Literal> &partition, const std::vector<PartitionPredicate> &filter)
+    {
+        for (const PartitionPredicate &predicate : filter)
+        {
+            if (predicate.index < partition.size() &&
+                !evaluate(predicate.op, predicate.values, partition[predicate.index]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool metricsMightMatch(const DataFile &file, const std::vector<BoundPredicate> &filter)
+    {
+        for (const BoundPredicate &predicate : filter)
+        {
+            const ColumnMetrics *metrics = file.findMetrics(predicate.field->id);
+            if (!metrics)
+            {
+                continue;
+            }
+            const std::string &type = predicate.field->type;
+            Literal lower = metrics->lower_bound ? decodeValue(type, *metrics->lower_bound) : Literal();
+            Literal upper = metrics->upper_bound ? decodeValue(type, *metrics->upper_bound) : Literal();
+            if (!mightMatch(predicate.op, predicate.values, lower, upper, metrics->null_value_count.value_or(-1),
+                            metrics->value_count.value_or(-1)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief The row groups of a Parquet file whose statistics may match the filter.
+     * Columns are matched by field id, or by name in files without field ids.
+     */
+    std::vector<size_t> matchingRowGroups(const ParquetFileReader &reader, const Schema &schema,
+                                          const std::vector<BoundPredicate> &filter)
+    {
+        std::vector<std::optional<size_t>> fields = fileColumns(reader, schema);
+        std::vector<std::optional<size_t>> columns;
+        for (const BoundPredicate &predicate : filter)
+        {
+            columns.push_back(fields[static_cast<size_t>(predicate.field - schema.fields.data())]);
+        }
+
+        std::vector<size_t> row_groups;
+        for (size_t rg = 0; rg < reader.numRowGroups(); ++rg)
+        {
+            bool match = true;
+            for (size_t p = 0; p < filter.size() && match; ++p)
+            {
+                if (!columns[p])
+                {
+                    continue;
+                }
+                const ColumnMetaData &column = reader.columnMetaData(rg, *columns[p]);
+                if (!column.statistics)
+                {
+                    continue;
+                }
+                const Statistics &statistics = *column.statistics;
+                const std::string &type = filter[p].field->type;
+                Literal lower = statistics.min_value ? decodeValue(type, *statistics.min_value) : Literal();
+                Literal upper = statistics.max_value ? decodeValue(type, *statistics.max_value) : Literal();
+                match = mightMatch(filter[p].op, filter[p].values, lower, upper, statistics.null_count.value_or(-1),
+                                   column.num_values);
+            }
+            if (match)
+            {
+                row_groups.push_back(rg);
+            }
+        }
+        return row_groups;
+    }
+
+    size_t charge(const std::vector<ManifestEntry> &entries)
+    {
+        size_t bytes = entries.capacity() * sizeof(ManifestEntry);
+        for (const ManifestEntry &entry : entries)
+        {
+            const DataFile &file = *entry.data_file;
+            bytes += sizeof(DataFile) + file.file_path.size() + file.partition.size() * sizeof(Literal) +
+                     file.metrics.size() * sizeof(ColumnMetrics) + file.split_offsets.size() * sizeof(int64_t);
+            for (const ColumnMetrics &metrics : file.metrics)
+            {
+                bytes += metrics.lower_bound.value_or("").size() + metrics.upper_bound.value_or("").size();
+            }
+        }
+        return bytes;
+    }
+
+    std::shared_ptr<const std::vector<ManifestEntry>> loadManifest(const ManifestFile &manifest,
+                                                                   const std::shared_ptr<MetadataCache> &cache,
+                                                                   bool &hit)
+    {
+        LocalFile file(localPath(manifest.manifest_path));
+        hit = false;
+        if (!cache)
+        {
+            return std::make_shared<const std::vector<ManifestEntry>>(readManifest(file, manifest));
+        }
+        // Entries inherit from the manifest list entry, so it is part of the key
+        std::string key = MetadataCache::fileKey(file) + "#manifest:" + std::to_string(manifest.sequence_number) +
+                          ":" + std::to_string(manifest.added_snapshot_id);
+        hit = true;
+        return cache->getOrLoad<std::vector<ManifestEntry>>(
+            key,
+            [&](size_t &bytes)
+            {
+                hit = false;
+                auto entries = std::make_shared<const std::vector<ManifestEntry>>(readManifest(file, manifest));
+                bytes = charge(*entries);
+                return entries;
+            });
+    }
+
+    /**
+     * @brief Delete files must share the spec and partition of the data files they apply
+     * to; equality deletes of an unpartitioned spec apply to the whole table.
+     */
+    std::string partitionKey(int32_t spec_id, const std::vector<Literal> &partition)
+    {
+        std::string key = std::to_string(spec_id);
+        for (const Literal &value : partition)
+        {
+            key += static_cast<char>(value.index());
+            std::visit(
+                [&](const auto &x)
+                {
+                    using T = std::decay_t<decltype(x)>;
+                    if constexpr (std::is_same_v<T, std::string>)
+                    {
+                        key += std::to_string(x.size());
+                        key += ':';
+                        key += x;
+                    }
+                    else if constexpr (!std::is_same_v<T, std::monostate>)
+                    {
+                        key += std::to_string(x);
+                        key += ':';
+                    }
+                },
+                value);
+        }
+        return key;
+    }
+
+    bool appliesTo(const ManifestEntry &deletes, int64_t data_sequence_number)
+    {
+        if (deletes.data_file->content == DataFileContent::POSITION_DELETES)
+        {
+            return deletes.sequence_number >= data_sequence_number;
+        }
+        return deletes.sequence_number > data_sequence_number;
+    }
+} // namespace
+
+TableScan::TableScan(std::shared_ptr<const TableMetadata> metadata, TableScanOptions options)
+    : metadata_(std::move(metadata)), options_(std::move(options))
+{
+}
+
+std::vector<FileScanTask> TableScan::plan()
+{
+    stats_ = {};
+    const TableMetadata &metadata = *metadata_;
+    const Snapshot *snapshot =
+        options_.snapshot_id ? metadata.snapshot(*options_.snapshot_id) : metadata.currentSnapshot();
+    if (options_.snapshot_id && !snapshot)
+    {
+        throw IcebergException("Unknown snapshot " + std::to_string(*options_.snapshot_id));
+    }
+    if (!snapshot)
+    {
+        return {};
+    }
+    const Schema *schema = &metadata.schema();
+    for (const Schema &candidate : metadata.schemas)
+    {
+        if (snapshot->schema_id && candidate.schema_id == *snapshot->schema_id)
+        {
+            schema = &candidate;
+        }
+    }
+    std::vector<BoundPredicate> filter = bindFilter(*schema, options_.filter);
+
+    std::vector<ManifestFile> manifests = readManifestList(snapshot->manifest_list);
+    stats_.manifests = manifests.size();
+    std::map<int32_t, std::vector<PartitionPredicate>> projections;
+    std::vector<const ManifestFile *> scanned;
+    for (const ManifestFile &manifest : manifests)
+    {
+        auto projection = projections.find(manifest.partition_spec_id);
+        if (projection == projections.end())
+        {
+            projection = projections
+                             .emplace(manifest.partition_spec_id,
+                                      project(metadata.spec(manifest.partition_spec_id), filter))
+                             .first;
+        }
+        if (manifestMightMatch(manifest, projection->second))
+        {
+            scanned.push_back(&manifest);
+        }
+        else
+        {
+            ++stats_.skipped_manifests;
+        }
+    }
+
+    std::unique_ptr<ThreadPool> owned_pool;
+    ThreadPool *pool = options_.pool;
+    if (!pool)
+    {
+        owned_pool = std::make_unique<ThreadPool>(options_.threads);
+        pool = owned_pool.get();
+    }
+
+    struct ManifestResult
+    {
+        std::vector<ManifestEntry> entries;
+        size_t live = 0;
+        bool hit = false;
+    };
+    std::vector<ManifestResult> results = parallelMap<ManifestResult>(
+        *pool, scanned.size(),
+        [&](size_t i)
+        {
+            const ManifestFile &manifest = *scanned[i];
+            const std::vector<PartitionPredicate> &partition_filter = projections.at(manifest.partition_spec_id);
+            bool data = manifest.content == ManifestContent::DATA;
+            ManifestResult result;
+            std::shared_ptr<const std::vector<ManifestEntry>> entries =
+                loadManifest(manifest, options_.cache, result.hit);
+            for (const ManifestEntry &entry : *entries)
+            {
+                if (entry.status == ManifestEntryStatus::DELETED)
+                {
+                    continue;
+                }
+                result.live += data;
+                if (partitionMatches(entry.data_file->partition, partition_filter) &&
+                    (!data || metricsMightMatch(*entry.data_file, filter)))
+                {
+                    result.entries.push_back(entry);
+                }
+            }
+            return result;
+        });
+
+    std::vector<FileScanTask> tasks;
+    std::unordered_map<std::string, std::vector<const ManifestEntry *>> partition_deletes;
+    std::vector<const ManifestEntry *> global_deletes;
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const ManifestResult &result = results[i];
+        stats_.manifest_cache_hits += result.hit;
+        if (scanned[i]->content == ManifestContent::DELETES)
+        {
+            for (const ManifestEntry &entry : result.entries)
+            {
+                const DataFile &file = *entry.data_file;
+                if (file.content == DataFileContent::EQUALITY_DELETES && metadata.spec(file.spec_id).unpartitioned())
+                {
+                    global_deletes.push_back(&entry);
+                }
+                else
+                {
+                    partition_deletes[partitionKey(file.spec_id, file.partition)].push_back(&entry);
+                }
+            }
+            continue;
+        }
+        stats_.data_files += result.live;
+        stats_.skipped_data_files += result.live - result.entries.size();
+        for (const ManifestEntry &entry : result.entries)
+        {
+            tasks.push_back(FileScanTask{entry.data_file, {}, {}, entry.sequence_number});
+        }
+    }
+
+    if (options_.prune_row_groups && !filter.empty())
+    {
+        std::vector<std::pair<size_t, std::vector<size_t>>> row_groups =
+            parallelMap<std::pair<size_t, std::vector<size_t>>>(
+                *pool, tasks.size(),
+                [&](size_t i)
+                {
+                    auto file = std::make_shared<LocalFile>(localPath(tasks[i].file->file_path));
+                    ParquetFileReader reader(std::move(file), options_.cache);
+                    return std::make_pair(reader.numRowGroups(), matchingRowGroups(reader, *schema, filter));
+                });
+        size_t kept = 0;
+        for (size_t i = 0; i < tasks.size(); ++i)
+        {
+            auto &[total, matching] = row_groups[i];
+            stats_.row_groups += total;
+            stats_.skipped_row_groups += total - matching.size();
+            if (matching.empty())
+            {
+                ++stats_.skipped_data_files;
+                continue;
+            }
+            if (matching.size() < total)
+            {
+                tasks[i].row_groups = std::move(matching);
+            }
+            if (kept != i)
+            {
+                tasks[kept] = std::move(tasks[i]);
+            }
+            ++kept;
+        }
+        tasks.resize(kept);
+    }
+
+    if (!partition_deletes.empty() || !global_deletes.empty())
+    {
+        std::unordered_set<const ManifestEntry *> attached;
+        for (FileScanTask &task : tasks)
+        {
+            auto attach = [&](const ManifestEntry *deletes)
+            {
+                if (appliesTo(*deletes, task.sequence_number))
+                {
+                    task.deletes.push_back(deletes->data_file);
+                    attached.insert(deletes);
+                }
+            };
+            auto found = partition_deletes.find(partitionKey(task.file->spec_id, task.file->partition));
+            if (found != partition_deletes.end())
+            {
+                for (const ManifestEntry *deletes : found->second)
+                {
+                    attach(deletes);
+                }
+            }
+            for (const ManifestEntry *deletes : global_deletes)
+            {
+                attach(deletes);
+            }
+        }
+        stats_.delete_files = attached.size();
+    }
+    return tasks;
+}
+
+ScanOptions scanOptions(const FileScanTask &task, ScanOptions options)
+{
+    options.row_groups = task.row_groups;
+    return options;
+}
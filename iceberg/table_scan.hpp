@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "expression.hpp"
+#include "formats/metadata_cache.hpp"
+#include "formats/scanner.hpp"
+#include "formats/thread_pool.hpp"
+#include "manifest.hpp"
+#include "table_metadata.hpp"
+
+struct TableScanOptions
+{
+    /// Conjunction of predicates on columns of the snapshot's schema
+    std::vector<Predicate> filter;
+
+    /// The snapshot to plan, the current one when unset
+    std::optional<int64_t> snapshot_id;
+
+    /// Also prune row groups by the statistics in the Parquet footers, which opens every
+    /// data file that survives the manifest level pruning
+    bool prune_row_groups = false;
+
+    /// Cache of decoded manifests and Parquet footers; null disables caching
+    std::shared_ptr<MetadataCache> cache = MetadataCache::global();
+
+    /// Pool to decode manifests on; when null the scan starts its own pool of `threads`
+    /// workers
+    ThreadPool *pool = nullptr;
+    size_t threads = 0;
+};
+
+/**
+ * @brief A data file to read, with the delete files that apply to it.
+ */
+struct FileScanTask
+{
+    std::shared_ptr<const DataFile> file;
+
+    /// Row groups that may hold matching rows, all row groups when empty
+    std::vector<size_t> row_groups;
+
+    /// Position and equality delete files whose rows must be removed from the file
+    std::vector<std::shared_ptr<const DataFile>> deletes;
+
+    /// Data sequence number of the file
+    int64_t sequence_number = 0;
+};
+
+struct ScanPlanStats
+{
+    /// Manifests listed by the snapshot, and those pruned by their partition summaries
+    size_t manifests = 0;
+    size_t skipped_manifests = 0;
+
+    /// Manifests whose entries came from the cache
+    size_t manifest_cache_hits = 0;
+
+    /// Live data files of the scanned manifests, and those pruned by partition values,
+    /// column metrics or row group statistics
+    size_t data_files = 0;
+    size_t skipped_data_files = 0;
+
+    /// Delete files attached to at least one task
+    size_t delete_files = 0;
+
+    /// Row groups of the files opened for row group pruning, and those pruned
+    size_t row_groups = 0;
+    size_t skipped_row_groups = 0;
+};
+
+/**
+ * @brief Plans a scan of an Iceberg table: the data files, and row groups of them, that
+ * may hold rows matching a filter.
+ *
+ * The filter prunes at every level of metadata. Predicates are projected through the
+ * partition transforms of each spec and tested against the partition summaries of the
+ * manifest list, skipping whole manifests, then against the partition values of each
+ * entry; column predicates are tested against the lower and upper bounds and null
+ * counts of each data file, and optionally against the row group statistics of its
+ * Parquet footer.
+ *
+ * Manifests are decoded in parallel on a ThreadPool and cached in a MetadataCache keyed
+ * by file version, so planning again (e.g. with another filter) decodes only manifests
+ * added since. Tasks come out in manifest order, files in the order of their manifests.
+ */
+class TableScan
+{
+public:
+    TableScan(std::shared_ptr<const TableMetadata> metadata, TableScanOptions options = {});
+
+    /**
+     * @throws IcebergException for unknown snapshots, filters on unknown columns or
+     * literals that do not fit the column type, and malformed manifests
+     * @throws std::system_error on I/O errors
+     */
+    std::vector<FileScanTask> plan();
+
+    /**
+     * @brief Counters of the last plan().
+     */
+    const ScanPlanStats &stats() const noexcept { return stats_; }
+
+private:
+    std::shared_ptr<const TableMetadata> metadata_;
+    TableScanOptions options_;
+    ScanPlanStats stats_;
+};
+
+/**
+ * @brief The ParquetScanner options that read the row groups of a task.
+ */
+ScanOptions scanOptions(const FileScanTask &task, ScanOptions options = {});
@@ -0,0 +1,141 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unistd.h>
+
+#include "catalog.hpp"
+#include "table_scan.hpp"
+
+// Planning latency on a table of 100K data files: 100 manifests of 1000 files, one per
+// day partition, each file covering 1000 ids. Planned without a manifest cache (every
+// manifest is read and decoded) and with a warm one, on 1 and 4 threads, with no filter,
+// a one day filter (pruned by the manifest list) and an id point filter (scans every
+// manifest, pruned by the column metrics of each entry). The files stay in the page
+// cache, so cold numbers are the decode cost rather than I/O.
+
+namespace
+{
+    constexpr int64_t kManifests = 100;
+    constexpr int64_t kFilesPerManifest = 1000;
+    constexpr int64_t kIdsPerFile = 1000;
+    constexpr int64_t kFirstDay = 19000;
+    constexpr int64_t kMicrosPerDay = int64_t{86400} * 1000000;
+
+    class BenchmarkTable
+    {
+    public:
+        BenchmarkTable()
+        {
+            root_ = "/tmp/table_scan_benchmark_" + std::to_string(::getpid());
+            FileCatalog catalog(root_);
+            catalog.createNamespace("db");
+            Schema schema = Schema::fromFields(
+                0, {{1, "id", "long", true}, {2, "ts", "timestamptz", true}, {3, "category", "string", false}});
+            PartitionSpec spec{0, {{2, 1000, "ts_day", "day"}}};
+            auto metadata = std::make_shared<TableMetadata>(*catalog.createTable({"db", "t"}, schema, spec).metadata);
+
+            std::vector<ManifestFile> manifests;
+            for (int64_t m = 0; m < kManifests; ++m)
+            {
+                ManifestWriter writer(metadata->location + "/metadata/m" + std::to_string(m) + ".avro", schema, spec, 1);
+                for (int64_t f = 0; f < kFilesPerManifest; ++f)
+                {
+                    int64_t min_id = (m * kFilesPerManifest + f) * kIdsPerFile;
+                    DataFile file;
+                    file.file_path = metadata->location + "/data/" + std::to_string(m) + "/" + std::to_string(f) +
+                                     ".parquet";
+                    file.partition = {kFirstDay + m};
+                    file.record_count = kIdsPerFile;
+                    file.file_size_in_bytes = 64 << 20;
+                    for (int32_t id = 1; id <= 3; ++id)
+                    {
+                        ColumnMetrics &metrics = file.metrics.emplace_back();
+                        metrics.field_id = id;
+                        metrics.value_count = kIdsPerFile;
+                        metrics.null_value_count = 0;
+                    }
+                    file.metrics[0].lower_bound = encodeValue("long", min_id);
+                    file.metrics[0].upper_bound = encodeValue("long", min_id + kIdsPerFile - 1);
+                    file.metrics[1].lower_bound = encodeValue("timestamptz", (kFirstDay + m) * kMicrosPerDay);
+                    file.metrics[1].upper_bound = encodeValue("timestamptz", (kFirstDay + m + 1) * kMicrosPerDay - 1);
+                    file.metrics[2].lower_bound = "a";
+                    file.metrics[2].upper_bound = "z";
+                    writer.add(file);
+                }
+                manifests.push_back(writer.close());
+            }
+
+            Snapshot snapshot;
+            snapshot.snapshot_id = 1;
+            snapshot.sequence_number = ++metadata->last_sequence_number;
+            snapshot.manifest_list = metadata->location + "/metadata/snap-1.avro";
+            snapshot.summary = {{"operation", "append"}};
+            writeManifestList(snapshot.manifest_list, manifests, snapshot.snapshot_id, std::nullopt, 1);
+            metadata->current_snapshot_id = 1;
+            metadata->snapshots.push_back(std::move(snapshot));
+            metadata_ = std::move(metadata);
+        }
+
+        ~BenchmarkTable() { std::filesystem::remove_all(root_); }
+
+        std::shared_ptr<const TableMetadata> metadata() const noexcept { return metadata_; }
+
+    private:
+        std::string root_;
+        std::shared_ptr<const TableMetadata> metadata_;
+    };
+
+    const BenchmarkTable &benchmarkTable()
+    {
+        static BenchmarkTable table;
+        return table;
+    }
+
+    std::vector<Predicate> benchmarkFilter(int64_t kind)
+    {
+        switch (kind)
+        {
+        case 1:
+        {
+            int64_t day = (kFirstDay + kManifests / 2) * kMicrosPerDay;
+            return {Predicate::greaterThanOrEqual("ts", day), Predicate::lessThan("ts", day + kMicrosPerDay)};
+        }
+        case 2:
+            return {Predicate::equal("id", int64_t{12345678})};
+        default:
+            return {};
+        }
+    }
+} // namespace
+
+static void BM_Plan(benchmark::State &state)
+{
+    std::shared_ptr<const TableMetadata> metadata = benchmarkTable().metadata();
+    ThreadPool pool(static_cast<size_t>(state.range(2)));
+    TableScanOptions options;
+    options.filter = benchmarkFilter(state.range(0));
+    options.cache = state.range(1) == 1 ? std::make_shared<MetadataCache>(size_t{1} << 30) : nullptr;
+    options.pool = &pool;
+    if (options.cache)
+    {
+        TableScan(metadata, options).plan();
+    }
+    size_t files = 0;
+    for (auto _ : state)
+    {
+        TableScan scan(metadata, options);
+        files = scan.plan().size();
+        benchmark::DoNotOptimize(files);
+    }
+    state.counters["files"] = static_cast<double>(files);
+}
+
+BENCHMARK(BM_Plan)
+    ->ArgNames({"filter", "cached", "threads"})
+    ->ArgsProduct({{0, 1, 2}, {0, 1}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,273 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "catalog.hpp"
+#include "formats/parquet_writer.hpp"
+#include "formats/scanner.hpp"
+#include "table_scan.hpp"
+
+namespace
+{
+    constexpr int64_t kMicrosPerDay = int64_t{86400} * 1000000;
+
+    std::string tempPath(const std::string &name)
+    {
+        return testing::TempDir() + "/" + name;
+    }
+
+    /**
+     * @brief Makes `manifests` the table's next snapshot.
+     */
+    void appendSnapshot(TableMetadata &metadata, const std::vector<ManifestFile> &manifests)
+    {
+        Snapshot snapshot;
+        snapshot.snapshot_id = static_cast<int64_t>(metadata.snapshots.size()) + 1;
+        snapshot.parent_snapshot_id = metadata.current_snapshot_id;
+        snapshot.sequence_number = ++metadata.last_sequence_number;
+        snapshot.timestamp_ms = 1000 * snapshot.snapshot_id;
+        snapshot.manifest_list = metadata.location + "/metadata/snap-" + std::to_string(snapshot.snapshot_id) + ".avro";
+        snapshot.summary = {{"operation", "append"}};
+        writeManifestList(snapshot.manifest_list, manifests, snapshot.snapshot_id, snapshot.parent_snapshot_id,
+                          snapshot.sequence_number);
+        metadata.current_snapshot_id = snapshot.snapshot_id;
+        metadata.snapshot_log.emplace_back(snapshot.timestamp_ms, snapshot.snapshot_id);
+        metadata.snapshots.push_back(std::move(snapshot));
+    }
+
+    DataFile dataFile(const std::string &path, std::vector<Literal> partition, int64_t min_id, int64_t max_id,
+                      DataFileContent content = DataFileContent::DATA)
+    {
+        DataFile file;
+        file.content = content;
+        file.file_path = path;
+        file.partition = std::move(partition);
+        file.record_count = max_id - min_id + 1;
+        file.file_size_in_bytes = 1000;
+        ColumnMetrics &id = file.metrics.emplace_back();
+        id.field_id = 1;
+        id.value_count = file.record_count;
+        id.null_value_count = 0;
+        id.lower_bound = encodeValue("long", min_id);
+        id.upper_bound = encodeValue("long", max_id);
+        return file;
+    }
+
+    std::vector<std::string> paths(const std::vector<FileScanTask> &tasks)
+    {
+        std::vector<std::string> result;
+        for (const FileScanTask &task : tasks)
+        {
+            result.push_back(task.file->file_path);
+        }
+        return result;
+    }
+
+    /**
+     * @brief A table partitioned by day(ts): one manifest per day 19000 + d holding files
+     * d0..d3 with ids 400 * d + 100 * f ... + 99. The first snapshot has day 19000 only;
+     * the second all three days and a delete manifest.
+     */
+    class TableScanTest : public testing::Test
+    {
+    protected:
+        void SetUp() override
+        {
+            std::string root = tempPath("scan_catalog");
+            std::filesystem::remove_all(root);
+            FileCatalog catalog(root);
+            catalog.createNamespace("db");
+            Schema schema = Schema::fromFields(
+                0, {{1, "id", "long", true}, {2, "ts", "timestamptz", true}, {3, "category", "string", false}});
+            PartitionSpec spec{0, {{2, 1000, "ts_day", "day"}}};
+            metadata = std::make_shared<TableMetadata>(*catalog.createTable({"db", "t"}, schema, spec).metadata);
+            std::string directory = metadata->location + "/metadata/";
+
+            std::vector<ManifestFile> manifests;
+            for (int64_t day = 0; day < 3; ++day)
+            {
+                ManifestWriter writer(directory + "m" + std::to_string(day) + ".avro", schema, spec, day == 0 ? 1 : 2);
+                for (int64_t f = 0; f < 4; ++f)
+                {
+                    int64_t min_id = 400 * day + 100 * f;
+                    std::string path = std::to_string(day) + std::to_string(f);
+                    writer.add(dataFile(path, {19000 + day}, min_id, min_id + 99));
+                }
+                manifests.push_back(writer.close());
+                if (day == 0)
+                {
+                    appendSnapshot(*metadata, manifests);
+                    manifests = readManifestList(metadata->currentSnapshot()->manifest_list);
+                }
+            }
+            ManifestWriter deletes(directory + "deletes.avro", schema, spec, 2, ManifestContent::DELETES);
+            deletes.add(dataFile("eq", {int64_t{19000}}, 0, 0, DataFileContent::EQUALITY_DELETES));
+            deletes.add(dataFile("pos", {int64_t{19001}}, 0, 0, DataFileContent::POSITION_DELETES));
+            manifests.push_back(deletes.close());
+            appendSnapshot(*metadata, manifests);
+        }
+
+        std::vector<FileScanTask> plan(std::vector<Predicate> filter, ScanPlanStats *stats = nullptr)
+        {
+            TableScanOptions options;
+            options.filter = std::move(filter);
+            options.cache = cache;
+            options.threads = 2;
+            TableScan scan(metadata, options);
+            std::vector<FileScanTask> tasks = scan.plan();
+            if (stats)
+            {
+                *stats = scan.stats();
+            }
+            return tasks;
+        }
+
+        std::shared_ptr<TableMetadata> metadata;
+        std::shared_ptr<MetadataCache> cache = std::make_shared<MetadataCache>(1 << 20);
+    };
+} // namespace
+
+TEST_F(TableScanTest, PlansAllFilesInManifestOrder)
+{
+    ScanPlanStats stats;
+    std::vector<FileScanTask> tasks = plan({}, &stats);
+    EXPECT_EQ(paths(tasks), (std::vector<std::string>{"00", "01", "02", "03", "10", "11", "12", "13", "20", "21",
+                                                       "22", "23"}));
+    EXPECT_EQ(stats.manifests, 4u);
+    EXPECT_EQ(stats.skipped_manifests, 0u);
+    EXPECT_EQ(stats.manifest_cache_hits, 0u);
+    EXPECT_EQ(stats.data_files, 12u);
+    EXPECT_EQ(stats.delete_files, 2u);
+    EXPECT_EQ(tasks[0].sequence_number, 1);
+    EXPECT_EQ(tasks[4].sequence_number, 2);
+
+    // Equality deletes apply to older data, position deletes to data of the same commit
+    EXPECT_EQ(tasks[0].deletes.size(), 1u);
+    EXPECT_EQ(tasks[0].deletes[0]->file_path, "eq");
+    EXPECT_EQ(tasks[4].deletes.size(), 1u);
+    EXPECT_EQ(tasks[4].deletes[0]->file_path, "pos");
+    EXPECT_TRUE(tasks[8].deletes.empty());
+
+    plan({}, &stats);
+    EXPECT_EQ(stats.manifest_cache_hits, 4u);
+
+    TableScanOptions options;
+    options.snapshot_id = 1;
+    options.cache = nullptr;
+    TableScan first(metadata, options);
+    EXPECT_EQ(paths(first.plan()), (std::vector<std::string>{"00", "01", "02", "03"}));
+    options.snapshot_id = 3;
+    EXPECT_THROW(TableScan(metadata, options).plan(), IcebergException);
+}
+
+TEST_F(TableScanTest, PrunesByPartitionAndMetrics)
+{
+    ScanPlanStats stats;
+    // ts on day 19001 only keeps that day's manifest (and the delete manifest)
+    int64_t day = 19001 * kMicrosPerDay;
+    std::vector<FileScanTask> tasks =
+        plan({Predicate::greaterThanOrEqual("ts", day), Predicate::lessThan("ts", day + kMicrosPerDay)}, &stats);
+    EXPECT_EQ(paths(tasks), (std::vector<std::string>{"10", "11", "12", "13"}));
+    EXPECT_EQ(stats.skipped_manifests, 2u);
+    EXPECT_EQ(stats.delete_files, 1u);
+
+    tasks = plan({Predicate::equal("id", int64_t{650})}, &stats);
+    EXPECT_EQ(paths(tasks), std::vector<std::string>{"12"});
+    EXPECT_EQ(stats.data_files, 12u);
+    EXPECT_EQ(stats.skipped_data_files, 11u);
+
+    tasks = plan({Predicate::in("id", {int64_t{5}, int64_t{1150}}), Predicate::notNull("ts")});
+    EXPECT_EQ(paths(tasks), (std::vector<std::string>{"00", "23"}));
+    EXPECT_TRUE(plan({Predicate::greaterThan("id", int64_t{1199})}).empty());
+    EXPECT_TRUE(plan({Predicate::isNull("ts")}).empty());
+    EXPECT_EQ(plan({Predicate::lessThan("ts", 19000 * kMicrosPerDay + 1)}).size(), 4u);
+
+    EXPECT_THROW(plan({Predicate::equal("missing", int64_t{1})}), IcebergException);
+    EXPECT_THROW(plan({Predicate::equal("id", std::string("x"))}), IcebergException);
+}
+
+TEST(TableScanRowGroupTest, PrunesRowGroupsAndFeedsTheScanner)
+{
+    std::string root = tempPath("row_group_catalog");
+    std::filesystem::remove_all(root);
+    FileCatalog catalog(root);
+    catalog.createNamespace("db");
+    Schema schema = Schema::fromFields(0, {{1, "id", "long", true}});
+    PartitionSpec spec{0, {}};
+    auto metadata = std::make_shared<TableMetadata>(*catalog.createTable({"db", "ids"}, schema, spec).metadata);
+
+    // Two files of 4 row groups of 100 ascending ids; the second has no field ids, so its
+    // columns are matched by name
+    ManifestWriter manifest(metadata->location + "/metadata/m.avro", schema, spec, 1);
+    for (int64_t f = 0; f < 2; ++f)
+    {
+        std::vector<SchemaElement> elements(2);
+        elements[0].name = "schema";
+        elements[0].num_children = 1;
+        elements[1].name = "id";
+        elements[1].type = AtomicType::INT64;
+        elements[1].repetition_type = FieldRepetitionType::REQUIRED;
+        if (f == 0)
+        {
+            elements[1].field_id = 1;
+        }
+        std::string path = metadata->location + "/data-" + std::to_string(f) + ".parquet";
+        ParquetFileWriter writer(path, elements, WriterOptions());
+        for (int64_t g = 0; g < 4; ++g)
+        {
+            ColumnBatch ids(AtomicType::INT64);
+            int64_t *values = ids.appendValues<int64_t>(100);
+            for (int64_t i = 0; i < 100; ++i)
+            {
+                values[i] = 400 * f + 100 * g + i;
+            }
+            writer.writeRowGroup({&ids});
+        }
+        writer.close();
+        // Loose upper bound on the first file, as left by truncated metrics
+        manifest.add(dataFile(path, {}, 400 * f, 400 * f + (f == 0 ? 450 : 399)));
+    }
+    appendSnapshot(*metadata, {manifest.close()});
+
+    TableScanOptions options;
+    options.prune_row_groups = true;
+    options.cache = std::make_shared<MetadataCache>(1 << 20);
+    options.filter = {Predicate::equal("id", int64_t{150})};
+    TableScan scan(metadata, options);
+    std::vector<FileScanTask> tasks = scan.plan();
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_EQ(tasks[0].row_groups, std::vector<size_t>{1});
+    // Only the first file is opened, the second is pruned by its metrics
+    EXPECT_EQ(scan.stats().row_groups, 4u);
+    EXPECT_EQ(scan.stats().skipped_row_groups, 3u);
+
+    auto reader = std::make_shared<ParquetFileReader>(std::make_shared<LocalFile>(tasks[0].file->file_path));
+    ParquetScanner scanner(reader, scanOptions(tasks[0]));
+    ScanBatch batch;
+    std::vector<int64_t> ids;
+    while (scanner.next(batch))
+    {
+        EXPECT_EQ(batch.row_group, 1u);
+        ids.insert(ids.end(), batch.batch->values<int64_t>(), batch.batch->values<int64_t>() + batch.batch->length());
+    }
+    ASSERT_EQ(ids.size(), 100u);
+    EXPECT_EQ(ids.front(), 100);
+    EXPECT_EQ(ids.back(), 199);
+
+    options.filter = {Predicate::greaterThanOrEqual("id", int64_t{350}), Predicate::lessThan("id", int64_t{450})};
+    tasks = TableScan(metadata, options).plan();
+    ASSERT_EQ(tasks.size(), 2u);
+    EXPECT_EQ(tasks[0].row_groups, std::vector<size_t>{3});
+    EXPECT_EQ(tasks[1].row_groups, std::vector<size_t>{0});
+
+    // The metrics of the first file allow 399 < id < 401, its row groups do not
+    options.filter = {Predicate::greaterThan("id", int64_t{399}), Predicate::lessThan("id", int64_t{401})};
+    TableScan narrow(metadata, options);
+    tasks = narrow.plan();
+    ASSERT_EQ(tasks.size(), 1u);
+    EXPECT_EQ(tasks[0].file->file_path, metadata->location + "/data-1.parquet");
+    EXPECT_EQ(narrow.stats().skipped_data_files, 1u);
+    EXPECT_EQ(narrow.stats().row_groups, 8u);
+}
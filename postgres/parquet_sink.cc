@@ -0,0 +1,679 @@
+#include "parquet_sink.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    // Type OIDs from pg_type.dat
+    constexpr uint32_t kBoolOid = 16;
+    constexpr uint32_t kByteaOid = 17;
+    constexpr uint32_t kNameOid = 19;
+    constexpr uint32_t kInt8Oid = 20;
+    constexpr uint32_t kInt2Oid = 21;
+    constexpr uint32_t kInt4Oid = 23;
+    constexpr uint32_t kTextOid = 25;
+    constexpr uint32_t kOidOid = 26;
+    constexpr uint32_t kFloat4Oid = 700;
+    constexpr uint32_t kFloat8Oid = 701;
+    constexpr uint32_t kBpcharOid = 1042;
+    constexpr uint32_t kVarcharOid = 1043;
+    constexpr uint32_t kDateOid = 1082;
+    constexpr uint32_t kTimestampOid = 1114;
+    constexpr uint32_t kTimestampTzOid = 1184;
+
+    // ConvertedType values from parquet.thrift
+    constexpr int32_t kUtf8 = 0;
+    constexpr int32_t kDate = 6;
+    constexpr int32_t kTimestampMicros = 10;
+    constexpr int32_t kInt16 = 16;
+
+    /// Days from 1970-01-01 to 2000-01-01
+    constexpr int64_t kPostgresEpochDays = 10957;
+
+    constexpr int64_t kMicrosPerSecond = 1000000;
+    constexpr int64_t kMicrosPerDay = 86400 * kMicrosPerSecond;
+
+    /**
+     * @brief Days since 1970-01-01 of a date in the proleptic Gregorian calendar.
+     */
+    int64_t daysFromCivil(int64_t year, int64_t month, int64_t day)
+    {
+        year -= month <= 2;
+        int64_t era = (year >= 0 ? year : year - 399) / 400;
+        int64_t year_of_era = year - era * 400;
+        int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+        return era * 146097 + day_of_era - 719468;
+    }
+
+    /**
+     * @brief Reads the ISO 8601 dates and times Postgres prints with DateStyle ISO.
+     */
+    class TextCursor
+    {
+    public:
+        explicit TextCursor(std::string_view text) : text_(text) {}
+
+        bool atEnd() const { return pos_ == text_.size(); }
+
+        bool skip(char c)
+        {
+            if (pos_ < text_.size() && text_[pos_] == c)
+            {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Reads between `min_digits` and `max_digits` decimal digits.
+         */
+        bool number(size_t min_digits, size_t max_digits, int64_t &value, size_t *digits = nullptr)
+        {
+            size_t start = pos_;
+            value = 0;
+            while (pos_ < text_.size() && pos_ - start < max_digits && text_[pos_] >= '0' && text_[pos_] <= '9')
+            {
+                value = value * 10 + (text_[pos_++] - '0');
+            }
+            if (digits)
+            {
+                *digits = pos_ - start;
+            }
+            return pos_ - start >= min_digits;
+        }
+
+        /// YYYY-MM-DD, as days since 1970-01-01
+        bool date(int64_t &days)
+        {
+            int64_t year, month, day;
+            if (!number(4, 7, year) || !skip('-') || !number(2, 2, month) || !skip('-') || !number(2, 2, day) ||
+                month < 1 || month > 12 || day < 1 || day > 31)
+            {
+                return false;
+            }
+            days = daysFromCivil(year, month, day);
+            return true;
+        }
+
+        /// HH:MM:SS[.ffffff], as microseconds since midnight
+        bool time(int64_t &micros)
+        {
+            int64_t hours, minutes, seconds;
+            if (!number(2, 2, hours) || !skip(':') || !number(2, 2, minutes) || !skip(':') || !number(2, 2, seconds))
+            {
+                return false;
+            }
+            micros = ((hours * 60 + minutes) * 60 + seconds) * kMicrosPerSecond;
+            if (skip('.'))
+            {
+                int64_t fraction;
+                size_t digits;
+                if (!number(1, 6, fraction, &digits))
+                {
+                    return false;
+                }
+                for (; digits < 6; ++digits)
+                {
+                    fraction *= 10;
+                }
+                micros += fraction;
+            }
+            return true;
+        }
+
+        /// +HH[:MM[:SS]] or -HH[:MM[:SS]], as microseconds east of UTC
+        bool offset(int64_t &micros)
+        {
+            int64_t sign = skip('-') ? -1 : 1;
+            if (sign > 0 && !skip('+'))
+            {
+                return false;
+            }
+            int64_t hours, minutes = 0, seconds = 0;
+            if (!number(2, 2, hours) || (skip(':') && (!number(2, 2, minutes) || (skip(':') && !number(2, 2, seconds)))))
+            {
+                return false;
+            }
+            micros = sign * ((hours * 60 + minutes) * 60 + seconds) * kMicrosPerSecond;
+            return true;
+        }
+
+    private:
+        std::string_view text_;
+        size_t pos_ = 0;
+    };
+
+    template <typename T>
+    bool parseNumber(std::string_view text, T &value)
+    {
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return error == std::errc() && end == text.data() + text.size();
+    }
+
+    /// Big endian binary send format
+    template <typename T>
+    bool readBinary(std::string_view data, T &value)
+    {
+        if (data.size() != sizeof(T))
+        {
+            return false;
+        }
+        uint8_t bytes[sizeof(T)];
+        std::reverse_copy(data.begin(), data.end(), bytes);
+        std::memcpy(&value, bytes, sizeof(T));
+        return true;
+    }
+
+    int hexDigit(char c)
+    {
+        if (c >= '0' && c <= '9')
+        {
+            return c - '0';
+        }
+        if (c >= 'a' && c <= 'f')
+        {
+            return c - 'a' + 10;
+        }
+        if (c >= 'A' && c <= 'F')
+        {
+            return c - 'A' + 10;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Decodes bytea's hex text format, \x followed by two digits per byte.
+     */
+    bool decodeHex(std::string_view text, std::string &out)
+    {
+        if (text.size() < 2 || text[0] != '\\' || text[1] != 'x' || text.size() % 2 != 0)
+        {
+            return false;
+        }
+        for (size_t i = 2; i < text.size(); i += 2)
+        {
+            int high = hexDigit(text[i]);
+            int low = hexDigit(text[i + 1]);
+            if (high < 0 || low < 0)
+            {
+                return false;
+            }
+            out.push_back(static_cast<char>(high << 4 | low));
+        }
+        return true;
+    }
+
+    bool isTextType(uint32_t oid)
+    {
+        return oid == kTextOid || oid == kVarcharOid || oid == kBpcharOid || oid == kNameOid;
+    }
+
+    AtomicType physicalType(uint32_t oid)
+    {
+        switch (oid)
+        {
+        case kBoolOid:
+            return AtomicType::BOOLEAN;
+        case kInt2Oid:
+        case kInt4Oid:
+        case kDateOid:
+            return AtomicType::INT32;
+        case kInt8Oid:
+        case kOidOid:
+        case kTimestampOid:
+        case kTimestampTzOid:
+            return AtomicType::INT64;
+        case kFloat4Oid:
+            return AtomicType::FLOAT;
+        case kFloat8Oid:
+            return AtomicType::DOUBLE;
+        default:
+            return AtomicType::BYTE_ARRAY;
+        }
+    }
+
+    std::string fileName(std::string_view name)
+    {
+        std::string result(name);
+        std::replace(result.begin(), result.end(), '/', '_');
+        return result;
+    }
+} // namespace
+
+ParquetSink::ParquetSink(std::string directory, SinkOptions options)
+    : directory_(std::move(directory)), options_(std::move(options))
+{
+}
+
+ParquetSink::~ParquetSink()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+    }
+}
+
+void ParquetSink::onBegin(const BeginMessage &message)
+{
+    lsn_ = message.final_lsn;
+    commit_time_ = message.commit_time + kPostgresEpochMicros;
+}
+
+void ParquetSink::onCommit(const CommitMessage &message)
+{
+    ++stats_.transactions;
+    last_commit_lsn_ = message.end_lsn;
+    for (auto &[oid, table] : tables_)
+    {
+        if (table.rows >= options_.row_group_rows)
+        {
+            flush(table);
+        }
+    }
+    if (buffered_rows_ == 0)
+    {
+        flushed_lsn_ = message.end_lsn;
+    }
+}
+
+void ParquetSink::onRelation(const RelationMessage &message)
+{
+    auto [it, inserted] = tables_.try_emplace(message.oid);
+    Table &table = it->second;
+    if (!inserted)
+    {
+        bool same = table.namespace_name == message.namespace_name && table.name == message.name &&
+                    table.columns.size() == message.columns.size();
+        for (size_t i = 0; same && i < table.columns.size(); ++i)
+        {
+            same = table.columns[i].name == message.columns[i].name &&
+                   table.columns[i].type_oid == message.columns[i].type_oid;
+        }
+        if (same)
+        {
+            return;
+        }
+        flush(table);
+        closeFile(table);
+    }
+
+    table.namespace_name = message.namespace_name;
+    table.name = message.name;
+    table.columns.clear();
+    table.batches.clear();
+    for (const RelationColumn &relation_column : message.columns)
+    {
+        Column column;
+        column.name = relation_column.name;
+        column.type_oid = relation_column.type_oid;
+        switch (column.type_oid)
+        {
+        case kBoolOid:
+            column.type = ValueType::kBoolean;
+            break;
+        case kInt2Oid:
+            column.type = ValueType::kInt16;
+            break;
+        case kInt4Oid:
+            column.type = ValueType::kInt32;
+            break;
+        case kInt8Oid:
+        case kOidOid:
+            column.type = ValueType::kInt64;
+            break;
+        case kFloat4Oid:
+            column.type = ValueType::kFloat;
+            break;
+        case kFloat8Oid:
+            column.type = ValueType::kDouble;
+            break;
+        case kDateOid:
+            column.type = ValueType::kDate;
+            break;
+        case kTimestampOid:
+            column.type = ValueType::kTimestamp;
+            break;
+        case kTimestampTzOid:
+            column.type = ValueType::kTimestampTz;
+            break;
+        case kByteaOid:
+            column.type = ValueType::kBytea;
+            break;
+        default:
+            column.type = ValueType::kText;
+            break;
+        }
+        table.batches.emplace_back(physicalType(column.type_oid));
+        table.columns.push_back(std::move(column));
+    }
+    table.batches.emplace_back(AtomicType::BYTE_ARRAY);
+    table.batches.emplace_back(AtomicType::INT64);
+    table.batches.emplace_back(AtomicType::INT64);
+}
+
+void ParquetSink::onInsert(const InsertMessage &message)
+{
+    appendRow(table(message.relation), 'I', message.tuple);
+    ++stats_.inserts;
+}
+
+void ParquetSink::onUpdate(const UpdateMessage &message)
+{
+    appendRow(table(message.relation), 'U', message.new_tuple);
+    ++stats_.updates;
+}
+
+void ParquetSink::onDelete(const DeleteMessage &message)
+{
+    appendRow(table(message.relation), 'D', message.old_tuple);
+    ++stats_.deletes;
+}
+
+void ParquetSink::onTruncate(const TruncateMessage &message)
+{
+    for (uint32_t relation : message.relations)
+    {
+        appendRow(table(relation), 'T', {});
+        ++stats_.truncates;
+    }
+}
+
+void ParquetSink::close()
+{
+    for (auto &[oid, table] : tables_)
+    {
+        flush(table);
+        closeFile(table);
+    }
+    flushed_lsn_ = std::max(flushed_lsn_, last_commit_lsn_);
+}
+
+std::vector<SchemaElement> ParquetSink::schema(const Table &table)
+{
+    std::vector<SchemaElement> schema(1);
+    schema[0].name = "schema";
+    schema[0].num_children = static_cast<int32_t>(table.columns.size() + 3);
+    auto add = [&](std::string name, AtomicType type, FieldRepetitionType repetition, std::optional<int32_t> converted)
+    {
+        SchemaElement &element = schema.emplace_back();
+        element.name = std::move(name);
+        element.type = type;
+        element.repetition_type = repetition;
+        element.converted_type = converted;
+    };
+    for (const Column &column : table.columns)
+    {
+        std::optional<int32_t> converted;
+        switch (column.type)
+        {
+        case ValueType::kInt16:
+            converted = kInt16;
+            break;
+        case ValueType::kDate:
+            converted = kDate;
+            break;
+        case ValueType::kTimestamp:
+        case ValueType::kTimestampTz:
+            converted = kTimestampMicros;
+            break;
+        case ValueType::kText:
+            converted = kUtf8;
+            break;
+        default:
+            break;
+        }
+        add(column.name, physicalType(column.type_oid), FieldRepetitionType::OPTIONAL, converted);
+    }
+    add("_op", AtomicType::BYTE_ARRAY, FieldRepetitionType::REQUIRED, kUtf8);
+    add("_lsn", AtomicType::INT64, FieldRepetitionType::REQUIRED, std::nullopt);
+    add("_commit_time", AtomicType::INT64, FieldRepetitionType::REQUIRED, kTimestampMicros);
+    return schema;
+}
+
+ParquetSink::Table &ParquetSink::table(uint32_t relation)
+{
+    auto it = tables_.find(relation);
+    if (it == tables_.end())
+    {
+        throw ReplicationException("Change to relation " + std::to_string(relation) + " before its Relation message");
+    }
+    return it->second;
+}
+
+void ParquetSink::appendRow(Table &table, char op, Tuple tuple)
+{
+    size_t columns = table.columns.size();
+    if (op != 'T' && tuple.size() != columns)
+    {
+        throw ReplicationException("Tuple with " + std::to_string(tuple.size()) + " values for " +
+                                   table.name + ", which has " + std::to_string(columns) + " columns");
+    }
+    // Parse the whole row first so that a bad value leaves the batches as they were
+    values_.assign(columns, Value());
+    scratch_.clear();
+    for (size_t i = 0; i < tuple.size(); ++i)
+    {
+        parseValue(table.columns[i], tuple[i], values_[i]);
+    }
+
+    for (size_t i = 0; i < columns; ++i)
+    {
+        const Value &value = values_[i];
+        ColumnBatch &batch = table.batches[i];
+        if (!value.present)
+        {
+            batch.appendNulls(1);
+            continue;
+        }
+        switch (table.columns[i].type)
+        {
+        case ValueType::kBoolean:
+            *batch.appendValues<uint8_t>(1) = static_cast<uint8_t>(value.integer);
+            break;
+        case ValueType::kInt16:
+        case ValueType::kInt32:
+        case ValueType::kDate:
+            *batch.appendValues<int32_t>(1) = static_cast<int32_t>(value.integer);
+            break;
+        case ValueType::kInt64:
+        case ValueType::kTimestamp:
+        case ValueType::kTimestampTz:
+            *batch.appendValues<int64_t>(1) = value.integer;
+            break;
+        case ValueType::kFloat:
+            *batch.appendValues<float>(1) = static_cast<float>(value.real);
+            break;
+        case ValueType::kDouble:
+            *batch.appendValues<double>(1) = value.real;
+            break;
+        case ValueType::kBytea:
+            batch.appendByteArray(reinterpret_cast<const uint8_t *>(scratch_.data()) + value.offset, value.size);
+            break;
+        case ValueType::kText:
+            batch.appendByteArray(reinterpret_cast<const uint8_t *>(value.bytes.data()), value.bytes.size());
+            break;
+        }
+    }
+    const uint8_t op_byte = static_cast<uint8_t>(op);
+    table.batches[columns].appendByteArray(&op_byte, 1);
+    *table.batches[columns + 1].appendValues<int64_t>(1) = static_cast<int64_t>(lsn_);
+    *table.batches[columns + 2].appendValues<int64_t>(1) = commit_time_;
+    ++table.rows;
+    ++buffered_rows_;
+}
+
+void ParquetSink::parseValue(const Column &column, const TupleValue &value, Value &out)
+{
+    if (value.kind == TupleValue::kNull || value.kind == TupleValue::kUnchanged)
+    {
+        return;
+    }
+    out.present = true;
+    bool binary = value.kind == TupleValue::kBinary;
+    std::string_view data = value.data;
+    bool valid = false;
+    switch (column.type)
+    {
+    case ValueType::kBoolean:
+        if (binary)
+        {
+            valid = data.size() == 1;
+            out.integer = valid && data[0] != 0;
+        }
+        else
+        {
+            valid = data == "t" || data == "f";
+            out.integer = data == "t";
+        }
+        break;
+    case ValueType::kInt16:
+    {
+        int16_t number = 0;
+        valid = binary ? readBinary(data, number) : parseNumber(data, number);
+        out.integer = number;
+        break;
+    }
+    case ValueType::kInt32:
+    {
+        int32_t number = 0;
+        valid = binary ? readBinary(data, number) : parseNumber(data, number);
+        out.integer = number;
+        break;
+    }
+    case ValueType::kInt64:
+        if (column.type_oid == kOidOid)
+        {
+            uint32_t number = 0;
+            valid = binary ? readBinary(data, number) : parseNumber(data, number);
+            out.integer = number;
+        }
+        else
+        {
+            valid = binary ? readBinary(data, out.integer) : parseNumber(data, out.integer);
+        }
+        break;
+    case ValueType::kFloat:
+    {
+        float number = 0;
+        valid = binary ? readBinary(data, number) : parseNumber(data, number);
+        out.real = number;
+        break;
+    }
+    case ValueType::kDouble:
+        valid = binary ? readBinary(data, out.real) : parseNumber(data, out.real);
+        break;
+    case ValueType::kDate:
+        if (binary)
+        {
+            int32_t days = 0;
+            valid = readBinary(data, days);
+            bool infinite = days == std::numeric_limits<int32_t>::max() || days == std::numeric_limits<int32_t>::min();
+            out.integer = infinite ? days : days + kPostgresEpochDays;
+        }
+        else if (data == "infinity" || data == "-infinity")
+        {
+            valid = true;
+            out.integer = data[0] == '-' ? std::numeric_limits<int32_t>::min() : std::numeric_limits<int32_t>::max();
+        }
+        else
+        {
+            TextCursor cursor(data);
+            valid = cursor.date(out.integer) && cursor.atEnd() &&
+                    out.integer > std::numeric_limits<int32_t>::min() && out.integer < std::numeric_limits<int32_t>::max();
+        }
+        break;
+    case ValueType::kTimestamp:
+    case ValueType::kTimestampTz:
+        if (binary)
+        {
+            valid = readBinary(data, out.integer);
+            if (out.integer != std::numeric_limits<int64_t>::max() && out.integer != std::numeric_limits<int64_t>::min())
+            {
+                out.integer += kPostgresEpochMicros;
+            }
+        }
+        else if (data == "infinity" || data == "-infinity")
+        {
+            valid = true;
+            out.integer = data[0] == '-' ? std::numeric_limits<int64_t>::min() : std::numeric_limits<int64_t>::max();
+        }
+        else
+        {
+            TextCursor cursor(data);
+            int64_t days = 0;
+            int64_t micros = 0;
+            int64_t offset = 0;
+            valid = cursor.date(days) && cursor.skip(' ') && cursor.time(micros) &&
+                    (column.type == ValueType::kTimestamp || cursor.offset(offset)) && cursor.atEnd();
+            out.integer = days * kMicrosPerDay + micros - offset;
+        }
+        break;
+    case ValueType::kBytea:
+        out.offset = scratch_.size();
+        if (binary)
+        {
+            scratch_.append(data);
+            valid = true;
+        }
+        else
+        {
+            valid = decodeHex(data, scratch_);
+        }
+        out.size = scratch_.size() - out.offset;
+        break;
+    case ValueType::kText:
+        valid = !binary || isTextType(column.type_oid);
+        out.bytes = data;
+        break;
+    }
+    if (!valid)
+    {
+        throw ReplicationException("Invalid " + std::string(binary ? "binary" : "text") + " value for column " +
+                                   column.name + " of type " + std::to_string(column.type_oid));
+    }
+}
+
+void ParquetSink::flush(Table &table)
+{
+    if (table.rows == 0)
+    {
+        return;
+    }
+    if (!table.writer)
+    {
+        std::string path = directory_ + "/" + fileName(table.namespace_name) + "." + fileName(table.name) + "." +
+                           std::to_string(table.next_file++) + ".parquet";
+        table.writer = std::make_unique<ParquetFileWriter>(path, schema(table), options_.writer);
+        files_.push_back(std::move(path));
+    }
+    std::vector<const ColumnBatch *> batches;
+    for (const ColumnBatch &batch : table.batches)
+    {
+        batches.push_back(&batch);
+    }
+    table.writer->writeRowGroup(batches);
+    for (ColumnBatch &batch : table.batches)
+    {
+        batch.clear();
+    }
+    buffered_rows_ -= table.rows;
+    table.rows = 0;
+    ++stats_.row_groups;
+}
+
+void ParquetSink::closeFile(Table &table)
+{
+    if (table.writer)
+    {
+        table.writer->close();
+        table.writer.reset();
+    }
+}
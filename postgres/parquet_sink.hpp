@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "formats/column_batch.hpp"
+#include "formats/parquet_writer.hpp"
+#include "pgoutput.hpp"
+
+struct SinkOptions
+{
+    /// A table's buffered rows are written as a row group at the first commit after they
+    /// reach this many
+    size_t row_group_rows = 128 * 1024;
+
+    WriterOptions writer;
+};
+
+struct SinkStats
+{
+    uint64_t transactions = 0;
+    uint64_t inserts = 0;
+    uint64_t updates = 0;
+    uint64_t deletes = 0;
+    uint64_t truncates = 0;
+    uint64_t row_groups = 0;
+};
+
+/**
+ * @brief A ReplicationHandler that writes the changes of every table to Parquet files in
+ * a directory, `<namespace>.<table>.<n>.parquet`.
+ *
+ * Each row is one change: the table's columns, all optional, followed by
+ *
+ * - `_op`: "I", "U", "D" or "T" (truncate, with every column null)
+ * - `_lsn`: the LSN of the transaction's commit record
+ * - `_commit_time`: the commit time as a TIMESTAMP_MICROS
+ *
+ * Rows are buffered per table in ColumnBatches and written at commit boundaries: a table's
+ * rows become a row group at the first commit after they reach row_group_rows, and at
+ * close(). A new schema for a table (after ALTER TABLE) writes out the rows buffered under
+ * the old one and starts the next file.
+ *
+ * Types map as follows; values may be in text or binary format:
+ *
+ * - bool: BOOLEAN
+ * - int2, int4: INT32 (INT_16 for int2)
+ * - int8, oid: INT64
+ * - float4, float8: FLOAT, DOUBLE
+ * - date: INT32 DATE
+ * - timestamp, timestamptz: INT64 TIMESTAMP_MICROS, in UTC for timestamptz
+ * - bytea: BYTE_ARRAY
+ * - anything else: BYTE_ARRAY UTF8 holding the text format, or the raw binary format for
+ *   text, varchar, char and name (binary format is rejected for other types)
+ *
+ * Unchanged TOASTed values of updates are written as nulls, as are the columns a delete
+ * leaves out of the old row.
+ */
+class ParquetSink : public ReplicationHandler
+{
+public:
+    /**
+     * @param directory An existing directory
+     */
+    explicit ParquetSink(std::string directory, SinkOptions options = {});
+
+    /**
+     * @brief Closes the sink if close() was not called; errors are ignored.
+     */
+    ~ParquetSink() override;
+
+    ParquetSink(const ParquetSink &) = delete;
+    ParquetSink &operator=(const ParquetSink &) = delete;
+
+    /**
+     * @throws ReplicationException for changes to unknown tables, tuples that do not match
+     * the table, and values that do not parse as their column's type
+     * @throws std::system_error on I/O errors
+     */
+    void onBegin(const BeginMessage &message) override;
+    void onCommit(const CommitMessage &message) override;
+    void onRelation(const RelationMessage &message) override;
+    void onInsert(const InsertMessage &message) override;
+    void onUpdate(const UpdateMessage &message) override;
+    void onDelete(const DeleteMessage &message) override;
+    void onTruncate(const TruncateMessage &message) override;
+
+    /**
+     * @brief Writes the buffered rows of every table and closes the files.
+     */
+    void close();
+
+    /**
+     * @brief The end LSN of the last transaction whose changes are all written to row
+     * groups, the position to confirm to the server as flushed once the files are closed.
+     */
+    Lsn flushedLsn() const noexcept { return flushed_lsn_; }
+
+    /// The paths of the files created so far
+    const std::vector<std::string> &files() const noexcept { return files_; }
+
+    const SinkStats &stats() const noexcept { return stats_; }
+
+    /// Rows buffered and not yet written
+    size_t bufferedRows() const noexcept { return buffered_rows_; }
+
+private:
+    enum class ValueType : uint8_t
+    {
+        kBoolean,
+        kInt16,
+        kInt32,
+        kInt64,
+        kFloat,
+        kDouble,
+        kDate,
+        kTimestamp,
+        kTimestampTz,
+        kBytea,
+        kText,
+    };
+
+    struct Column
+    {
+        std::string name;
+        uint32_t type_oid = 0;
+        ValueType type = ValueType::kText;
+    };
+
+    struct Table
+    {
+        std::string namespace_name;
+        std::string name;
+        std::vector<Column> columns;
+        /// One per column, then _op, _lsn and _commit_time
+        std::vector<ColumnBatch> batches;
+        std::unique_ptr<ParquetFileWriter> writer;
+        size_t rows = 0;
+        size_t next_file = 0;
+    };
+
+    /// A parsed value; text points into the stream, decoded bytea is at offset in scratch_
+    struct Value
+    {
+        bool present = false;
+        int64_t integer = 0;
+        double real = 0;
+        std::string_view bytes;
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    static std::vector<SchemaElement> schema(const Table &table);
+
+    Table &table(uint32_t relation);
+    void appendRow(Table &table, char op, Tuple tuple);
+    void parseValue(const Column &column, const TupleValue &value, Value &out);
+    void flush(Table &table);
+    void closeFile(Table &table);
+
+    std::string directory_;
+    SinkOptions options_;
+    std::unordered_map<uint32_t, Table> tables_;
+    std::vector<std::string> files_;
+    std::vector<Value> values_;
+    std::string scratch_;
+    Lsn lsn_ = 0;
+    int64_t commit_time_ = 0;
+    Lsn flushed_lsn_ = 0;
+    Lsn last_commit_lsn_ = 0;
+    size_t buffered_rows_ = 0;
+    SinkStats stats_;
+};
@@ -0,0 +1,510 @@
+#include "pgoutput.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "formats/io.hpp"
+
+namespace
+{
+    constexpr size_t kFrameHeader = 5;      // Byte1 type, Int32 length including itself
+    constexpr size_t kXLogDataHeader = 25;  // 'w', WAL start, WAL end, send time
+    constexpr size_t kKeepaliveSize = 18;   // 'k', WAL end, send time, reply requested
+
+    /**
+     * @brief Reads big endian integers and null terminated strings, checking every read
+     * against the end of the message.
+     */
+    class Reader
+    {
+    public:
+        Reader(const uint8_t *data, size_t size) : data_(data), end_(data + size) {}
+
+        uint8_t u8()
+        {
+            need(1);
+            return *data_++;
+        }
+
+        uint16_t u16()
+        {
+            need(2);
+            uint16_t value = static_cast<uint16_t>(data_[0] << 8 | data_[1]);
+            data_ += 2;
+            return value;
+        }
+
+        uint32_t u32()
+        {
+            need(4);
+            uint32_t value;
+            std::memcpy(&value, data_, 4);
+            data_ += 4;
+            return __builtin_bswap32(value);
+        }
+
+        uint64_t u64()
+        {
+            need(8);
+            uint64_t value;
+            std::memcpy(&value, data_, 8);
+            data_ += 8;
+            return __builtin_bswap64(value);
+        }
+
+        std::string_view string()
+        {
+            const void *terminator = std::memchr(data_, 0, static_cast<size_t>(end_ - data_));
+            if (!terminator)
+            {
+                throw ReplicationException("Unterminated string in pgoutput message");
+            }
+            std::string_view value(reinterpret_cast<const char *>(data_),
+                                   static_cast<size_t>(static_cast<const uint8_t *>(terminator) - data_));
+            data_ += value.size() + 1;
+            return value;
+        }
+
+        std::string_view bytes(size_t size)
+        {
+            need(size);
+            std::string_view value(reinterpret_cast<const char *>(data_), size);
+            data_ += size;
+            return value;
+        }
+
+        void expectEnd() const
+        {
+            if (data_ != end_)
+            {
+                throw ReplicationException("Trailing bytes after pgoutput message");
+            }
+        }
+
+    private:
+        void need(size_t size) const
+        {
+            if (static_cast<size_t>(end_ - data_) < size)
+            {
+                throw ReplicationException("Truncated pgoutput message");
+            }
+        }
+
+        const uint8_t *data_;
+        const uint8_t *end_;
+    };
+
+    Tuple readTuple(Reader &reader, std::vector<TupleValue> &values)
+    {
+        uint16_t count = reader.u16();
+        values.resize(count);
+        for (TupleValue &value : values)
+        {
+            auto kind = static_cast<TupleValue::Kind>(reader.u8());
+            value.kind = kind;
+            value.data = {};
+            switch (kind)
+            {
+            case TupleValue::kNull:
+            case TupleValue::kUnchanged:
+                break;
+            case TupleValue::kText:
+            case TupleValue::kBinary:
+                value.data = reader.bytes(reader.u32());
+                break;
+            default:
+                throw ReplicationException(std::string("Unknown tuple value kind '") + static_cast<char>(kind) + "'");
+            }
+        }
+        return values;
+    }
+
+    /**
+     * @brief The size of the frame starting at `data`, given that its header is there.
+     */
+    size_t frameSize(const uint8_t *data)
+    {
+        if (data[0] != 'd' && data[0] != 'c')
+        {
+            throw ReplicationException(std::string("Unexpected message '") + static_cast<char>(data[0]) +
+                                       "' in the replication stream");
+        }
+        uint32_t length;
+        std::memcpy(&length, data + 1, 4);
+        length = __builtin_bswap32(length);
+        if (length < 4)
+        {
+            throw ReplicationException("Invalid message length in the replication stream");
+        }
+        return 1 + static_cast<size_t>(length);
+    }
+} // namespace
+
+void PgOutputDecoder::feed(const uint8_t *data, size_t size)
+{
+    // Complete the frame left over from the previous chunk first
+    while (!pending_.empty() && size > 0 && !done_)
+    {
+        size_t wanted = pending_.size() < kFrameHeader ? kFrameHeader : frameSize(pending_.data());
+        size_t take = std::min(wanted - pending_.size(), size);
+        pending_.insert(pending_.end(), data, data + take);
+        data += take;
+        size -= take;
+        if (pending_.size() >= kFrameHeader && pending_.size() == frameSize(pending_.data()))
+        {
+            decodeFrame(pending_.data(), pending_.size());
+            pending_.clear();
+        }
+    }
+    while (size >= kFrameHeader && !done_)
+    {
+        size_t frame = frameSize(data);
+        if (frame > size)
+        {
+            break;
+        }
+        decodeFrame(data, frame);
+        data += frame;
+        size -= frame;
+    }
+    if (!done_)
+    {
+        pending_.insert(pending_.end(), data, data + size);
+    }
+}
+
+void PgOutputDecoder::finish() const
+{
+    if (!pending_.empty())
+    {
+        throw ReplicationException("Replication stream ends in the middle of a message");
+    }
+}
+
+void PgOutputDecoder::decodeFrame(const uint8_t *data, size_t size)
+{
+    if (data[0] == 'c')
+    {
+        done_ = true;
+        return;
+    }
+    Reader reader(data + kFrameHeader, size - kFrameHeader);
+    uint8_t type = reader.u8();
+    if (type == 'w')
+    {
+        if (size - kFrameHeader < kXLogDataHeader)
+        {
+            throw ReplicationException("Truncated XLogData message");
+        }
+        reader.u64();
+        wal_end_ = std::max(wal_end_, reader.u64());
+        decodeMessage(data + kFrameHeader + kXLogDataHeader, size - kFrameHeader - kXLogDataHeader);
+    }
+    else if (type == 'k')
+    {
+        Lsn wal_end = reader.u64();
+        reader.u64();
+        bool reply_requested = reader.u8() != 0;
+        reader.expectEnd();
+        wal_end_ = std::max(wal_end_, wal_end);
+        handler_.onKeepalive(wal_end, reply_requested);
+    }
+    else
+    {
+        throw ReplicationException(std::string("Unknown replication message '") + static_cast<char>(type) + "'");
+    }
+}
+
+void PgOutputDecoder::decodeMessage(const uint8_t *data, size_t size)
+{
+    Reader reader(data, size);
+    char type = static_cast<char>(reader.u8());
+    switch (type)
+    {
+    case 'B':
+    {
+        BeginMessage message;
+        message.final_lsn = reader.u64();
+        message.commit_time = static_cast<PgTimestamp>(reader.u64());
+        message.xid = reader.u32();
+        reader.expectEnd();
+        handler_.onBegin(message);
+        break;
+    }
+    case 'C':
+    {
+        CommitMessage message;
+        message.flags = reader.u8();
+        message.commit_lsn = reader.u64();
+        message.end_lsn = reader.u64();
+        message.commit_time = static_cast<PgTimestamp>(reader.u64());
+        reader.expectEnd();
+        handler_.onCommit(message);
+        break;
+    }
+    case 'R':
+    {
+        RelationMessage message;
+        message.oid = reader.u32();
+        message.namespace_name = reader.string();
+        message.name = reader.string();
+        message.replica_identity = static_cast<char>(reader.u8());
+        columns_.resize(reader.u16());
+        for (RelationColumn &column : columns_)
+        {
+            column.key = (reader.u8() & 1) != 0;
+            column.name = reader.string();
+            column.type_oid = reader.u32();
+            column.type_modifier = static_cast<int32_t>(reader.u32());
+        }
+        reader.expectEnd();
+        message.columns = columns_;
+        handler_.onRelation(message);
+        break;
+    }
+    case 'I':
+    {
+        InsertMessage message;
+        message.relation = reader.u32();
+        if (reader.u8() != 'N')
+        {
+            throw ReplicationException("Insert message without a new tuple");
+        }
+        message.tuple = readTuple(reader, new_values_);
+        reader.expectEnd();
+        handler_.onInsert(message);
+        break;
+    }
+    case 'U':
+    {
+        UpdateMessage message;
+        message.relation = reader.u32();
+        uint8_t marker = reader.u8();
+        if (marker == 'K' || marker == 'O')
+        {
+            message.old_kind = static_cast<char>(marker);
+            message.old_tuple = readTuple(reader, old_values_);
+            marker = reader.u8();
+        }
+        if (marker != 'N')
+        {
+            throw ReplicationException("Update message without a new tuple");
+        }
+        message.new_tuple = readTuple(reader, new_values_);
+        reader.expectEnd();
+        handler_.onUpdate(message);
+        break;
+    }
+    case 'D':
+    {
+        DeleteMessage message;
+        message.relation = reader.u32();
+        uint8_t marker = reader.u8();
+        if (marker != 'K' && marker != 'O')
+        {
+            throw ReplicationException("Delete message without an old tuple");
+        }
+        message.old_kind = static_cast<char>(marker);
+        message.old_tuple = readTuple(reader, old_values_);
+        reader.expectEnd();
+        handler_.onDelete(message);
+        break;
+    }
+    case 'T':
+    {
+        TruncateMessage message;
+        relations_.resize(reader.u32());
+        message.options = reader.u8();
+        for (uint32_t &relation : relations_)
+        {
+            relation = reader.u32();
+        }
+        reader.expectEnd();
+        message.relations = relations_;
+        handler_.onTruncate(message);
+        break;
+    }
+    case 'O': // Origin: LSN, name
+    case 'Y': // Type: OID, namespace, name
+    case 'M': // Logical decoding message: flags, LSN, prefix, length, content
+        break;
+    default:
+        throw ReplicationException(std::string("Unsupported pgoutput message '") + type + "'");
+    }
+    ++messages_;
+}
+
+void decodeStreamFile(const std::string &path, PgOutputDecoder &decoder)
+{
+    LocalFile file(path);
+    std::vector<uint8_t> chunk(1 << 20);
+    for (uint64_t offset = 0; offset < file.size() && !decoder.done();)
+    {
+        size_t size = static_cast<size_t>(std::min<uint64_t>(chunk.size(), file.size() - offset));
+        file.readAt(offset, size, chunk.data());
+        decoder.feed(chunk.data(), size);
+        offset += size;
+    }
+    decoder.finish();
+}
+
+void PgOutputWriter::begin(Lsn final_lsn, PgTimestamp commit_time, uint32_t xid)
+{
+    startMessage('B');
+    put64(final_lsn);
+    put64(static_cast<uint64_t>(commit_time));
+    put32(xid);
+    finishMessage();
+}
+
+void PgOutputWriter::commit(Lsn commit_lsn, Lsn end_lsn, PgTimestamp commit_time)
+{
+    startMessage('C');
+    put8(0);
+    put64(commit_lsn);
+    put64(end_lsn);
+    put64(static_cast<uint64_t>(commit_time));
+    finishMessage();
+}
+
+void PgOutputWriter::relation(uint32_t oid, std::string_view namespace_name, std::string_view name,
+                              std::span<const RelationColumn> columns, char replica_identity)
+{
+    startMessage('R');
+    put32(oid);
+    putString(namespace_name);
+    putString(name);
+    put8(static_cast<uint8_t>(replica_identity));
+    put16(static_cast<uint16_t>(columns.size()));
+    for (const RelationColumn &column : columns)
+    {
+        put8(column.key ? 1 : 0);
+        putString(column.name);
+        put32(column.type_oid);
+        put32(static_cast<uint32_t>(column.type_modifier));
+    }
+    finishMessage();
+}
+
+void PgOutputWriter::insert(uint32_t relation, Tuple tuple)
+{
+    startMessage('I');
+    put32(relation);
+    put8('N');
+    putTuple(tuple);
+    finishMessage();
+}
+
+void PgOutputWriter::update(uint32_t relation, Tuple new_tuple, char old_kind, Tuple old_tuple)
+{
+    startMessage('U');
+    put32(relation);
+    if (old_kind != 0)
+    {
+        put8(static_cast<uint8_t>(old_kind));
+        putTuple(old_tuple);
+    }
+    put8('N');
+    putTuple(new_tuple);
+    finishMessage();
+}
+
+void PgOutputWriter::remove(uint32_t relation, char old_kind, Tuple old_tuple)
+{
+    startMessage('D');
+    put32(relation);
+    put8(static_cast<uint8_t>(old_kind));
+    putTuple(old_tuple);
+    finishMessage();
+}
+
+void PgOutputWriter::truncate(std::span<const uint32_t> relations, uint8_t options)
+{
+    startMessage('T');
+    put32(static_cast<uint32_t>(relations.size()));
+    put8(options);
+    for (uint32_t relation : relations)
+    {
+        put32(relation);
+    }
+    finishMessage();
+}
+
+void PgOutputWriter::keepalive(Lsn wal_end, bool reply_requested)
+{
+    put8('d');
+    put32(4 + kKeepaliveSize);
+    put8('k');
+    put64(wal_end);
+    put64(0);
+    put8(reply_requested ? 1 : 0);
+}
+
+void PgOutputWriter::done()
+{
+    put8('c');
+    put32(4);
+}
+
+void PgOutputWriter::startMessage(char type)
+{
+    frame_start_ = data_.size();
+    put8('d');
+    put32(0); // Patched by finishMessage()
+    put8('w');
+    put64(lsn_);
+    put64(0); // WAL end, patched too
+    put64(0); // Send time
+    put8(static_cast<uint8_t>(type));
+}
+
+void PgOutputWriter::finishMessage()
+{
+    size_t length = data_.size() - frame_start_ - 1;
+    size_t message_size = data_.size() - frame_start_ - kFrameHeader - kXLogDataHeader;
+    uint32_t big_length = __builtin_bswap32(static_cast<uint32_t>(length));
+    std::memcpy(data_.data() + frame_start_ + 1, &big_length, 4);
+    lsn_ += message_size;
+    uint64_t wal_end = __builtin_bswap64(lsn_);
+    std::memcpy(data_.data() + frame_start_ + kFrameHeader + 9, &wal_end, 8);
+}
+
+void PgOutputWriter::putTuple(Tuple tuple)
+{
+    put16(static_cast<uint16_t>(tuple.size()));
+    for (const TupleValue &value : tuple)
+    {
+        put8(static_cast<uint8_t>(value.kind));
+        if (value.kind == TupleValue::kText || value.kind == TupleValue::kBinary)
+        {
+            put32(static_cast<uint32_t>(value.data.size()));
+            data_.insert(data_.end(), value.data.begin(), value.data.end());
+        }
+    }
+}
+
+void PgOutputWriter::put16(uint16_t value)
+{
+    put8(static_cast<uint8_t>(value >> 8));
+    put8(static_cast<uint8_t>(value));
+}
+
+void PgOutputWriter::put32(uint32_t value)
+{
+    uint32_t big = __builtin_bswap32(value);
+    auto *bytes = reinterpret_cast<const uint8_t *>(&big);
+    data_.insert(data_.end(), bytes, bytes + 4);
+}
+
+void PgOutputWriter::put64(uint64_t value)
+{
+    uint64_t big = __builtin_bswap64(value);
+    auto *bytes = reinterpret_cast<const uint8_t *>(&big);
+    data_.insert(data_.end(), bytes, bytes + 8);
+}
+
+void PgOutputWriter::putString(std::string_view value)
+{
+    data_.insert(data_.end(), value.begin(), value.end());
+    put8(0);
+}
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Decoder for the output of Postgres' pgoutput logical decoding plugin (protocol version
+// 1), as streamed by START_REPLICATION ... LOGICAL in the CopyBoth sub-protocol:
+//
+//   CopyData ('d', Int32 length) holding either
+//     XLogData ('w', Int64 WAL start, Int64 WAL end, Int64 send time) followed by one
+//       pgoutput message: Begin 'B', Commit 'C', Relation 'R', Insert 'I', Update 'U',
+//       Delete 'D', Truncate 'T', Origin 'O', Type 'Y' or logical decoding Message 'M'
+//     or a primary keepalive ('k', Int64 WAL end, Int64 send time, Byte1 reply requested)
+//   CopyDone ('c', Int32 length) at the end of the stream
+//
+// Integers are big endian and strings are null terminated. A recorded stream file holds
+// the CopyData messages back to back, exactly as the server sent them.
+
+class ReplicationException : public std::runtime_error
+{
+public:
+    explicit ReplicationException(const std::string &message)
+        : std::runtime_error(message) {}
+};
+
+/// A position in the write-ahead log
+using Lsn = uint64_t;
+
+/// Microseconds since 2000-01-01 00:00:00 UTC, the Postgres epoch
+using PgTimestamp = int64_t;
+
+/// The Postgres epoch in microseconds since the Unix epoch
+constexpr int64_t kPostgresEpochMicros = 946684800000000;
+
+struct BeginMessage
+{
+    /// The LSN of the transaction's commit record
+    Lsn final_lsn = 0;
+    PgTimestamp commit_time = 0;
+    uint32_t xid = 0;
+};
+
+struct CommitMessage
+{
+    uint8_t flags = 0;
+    Lsn commit_lsn = 0;
+    /// The end of the commit record, where replication resumes after this transaction
+    Lsn end_lsn = 0;
+    PgTimestamp commit_time = 0;
+};
+
+struct RelationColumn
+{
+    /// Part of the replica identity (usually the primary key)
+    bool key = false;
+    std::string_view name;
+    uint32_t type_oid = 0;
+    int32_t type_modifier = -1;
+};
+
+/**
+ * @brief The schema of a table, sent before the first change to it in a session and
+ * again after it changes.
+ */
+struct RelationMessage
+{
+    uint32_t oid = 0;
+    std::string_view namespace_name;
+    std::string_view name;
+    /// 'd' default (primary key), 'n' nothing, 'f' full row, 'i' index
+    char replica_identity = 'd';
+    std::span<const RelationColumn> columns;
+};
+
+/**
+ * @brief One column of a tuple: null, an unchanged TOASTed value the message leaves out,
+ * or a value in text or binary format.
+ */
+struct TupleValue
+{
+    enum Kind : char
+    {
+        kNull = 'n',
+        kUnchanged = 'u',
+        kText = 't',
+        kBinary = 'b',
+    };
+
+    Kind kind = kNull;
+    std::string_view data;
+};
+
+using Tuple = std::span<const TupleValue>;
+
+struct InsertMessage
+{
+    uint32_t relation = 0;
+    Tuple tuple;
+};
+
+struct UpdateMessage
+{
+    uint32_t relation = 0;
+    /// 'K' if old_tuple holds the old replica identity columns, 'O' the whole old row, 0
+    /// if the old row was not sent
+    char old_kind = 0;
+    Tuple old_tuple;
+    Tuple new_tuple;
+};
+
+struct DeleteMessage
+{
+    uint32_t relation = 0;
+    /// 'K' if old_tuple holds the replica identity columns, 'O' the whole row
+    char old_kind = 'K';
+    Tuple old_tuple;
+};
+
+struct TruncateMessage
+{
+    /// Bit 1: CASCADE, bit 2: RESTART IDENTITY
+    uint8_t options = 0;
+    std::span<const uint32_t> relations;
+};
+
+/**
+ * @brief Receives the decoded messages. The views in a message point into the replication
+ * stream (or the decoder's scratch space) and are only valid during the call.
+ */
+class ReplicationHandler
+{
+public:
+    virtual ~ReplicationHandler() = default;
+
+    virtual void onBegin(const BeginMessage &) {}
+    virtual void onCommit(const CommitMessage &) {}
+    virtual void onRelation(const RelationMessage &) {}
+    virtual void onInsert(const InsertMessage &) {}
+    virtual void onUpdate(const UpdateMessage &) {}
+    virtual void onDelete(const DeleteMessage &) {}
+    virtual void onTruncate(const TruncateMessage &) {}
+    virtual void onKeepalive(Lsn /*wal_end*/, bool /*reply_requested*/) {}
+};
+
+/**
+ * @brief Decodes a replication stream fed in chunks of any size.
+ *
+ * Frames that lie entirely in a chunk are parsed in place: strings and values reach the
+ * handler as views into the caller's buffer, and the arrays of tuple values and columns
+ * reuse scratch vectors, so the steady state allocates nothing. Only a frame split across
+ * two chunks is copied, to reassemble it.
+ *
+ * Origin, Type and logical decoding Message messages are skipped; the streaming and two
+ * phase commit messages of later protocol versions are rejected.
+ */
+class PgOutputDecoder
+{
+public:
+    explicit PgOutputDecoder(ReplicationHandler &handler) : handler_(handler) {}
+
+    /**
+     * @brief Decodes the complete frames of the stream so far and keeps any partial one
+     * for the next call. Bytes after CopyDone are ignored.
+     * @throws ReplicationException on malformed or unsupported messages
+     */
+    void feed(const uint8_t *data, size_t size);
+
+    /**
+     * @brief Decodes one pgoutput message, the payload of an XLogData message, for
+     * callers that read the replication protocol themselves.
+     * @throws ReplicationException on a malformed or unsupported message
+     */
+    void decodeMessage(const uint8_t *data, size_t size);
+
+    /**
+     * @brief Checks that the stream did not end in the middle of a frame.
+     * @throws ReplicationException if it did
+     */
+    void finish() const;
+
+    /**
+     * @brief The highest WAL end position seen in XLogData and keepalive messages.
+     */
+    Lsn walEnd() const noexcept { return wal_end_; }
+
+    /// The number of pgoutput messages decoded
+    uint64_t messageCount() const noexcept { return messages_; }
+
+    /// True once the stream's CopyDone was seen
+    bool done() const noexcept { return done_; }
+
+private:
+    void decodeFrame(const uint8_t *data, size_t size);
+
+    ReplicationHandler &handler_;
+    std::vector<uint8_t> pending_;
+    std::vector<TupleValue> old_values_;
+    std::vector<TupleValue> new_values_;
+    std::vector<RelationColumn> columns_;
+    std::vector<uint32_t> relations_;
+    Lsn wal_end_ = 0;
+    uint64_t messages_ = 0;
+    bool done_ = false;
+};
+
+/**
+ * @brief Feeds a recorded stream file to `decoder` and checks that it is complete.
+ * @throws std::system_error if the file cannot be read
+ * @throws ReplicationException on malformed or unsupported messages
+ */
+void decodeStreamFile(const std::string &path, PgOutputDecoder &decoder);
+
+/**
+ * @brief Encodes pgoutput messages in XLogData and CopyData frames, the way the server
+ * sends them: synthetic replication streams for tests and benchmarks.
+ *
+ * Every message is stamped with WAL start lsn() and WAL end lsn() plus its size, after
+ * which lsn() moves to that end.
+ */
+class PgOutputWriter
+{
+public:
+    explicit PgOutputWriter(Lsn start_lsn = 0x1000000) : lsn_(start_lsn) {}
+
+    void begin(Lsn final_lsn, PgTimestamp commit_time, uint32_t xid);
+    void commit(Lsn commit_lsn, Lsn end_lsn, PgTimestamp commit_time);
+    void relation(uint32_t oid, std::string_view namespace_name, std::string_view name,
+                  std::span<const RelationColumn> columns, char replica_identity = 'd');
+    void insert(uint32_t relation, Tuple tuple);
+
+    /**
+     * @param old_kind 'K' or 'O' to send `old_tuple`, 0 to leave it out
+     */
+    void update(uint32_t relation, Tuple new_tuple, char old_kind = 0, Tuple old_tuple = {});
+
+    /**
+     * @param old_kind 'K' or 'O'
+     */
+    void remove(uint32_t relation, char old_kind, Tuple old_tuple);
+
+    void truncate(std::span<const uint32_t> relations, uint8_t options = 0);
+    void keepalive(Lsn wal_end, bool reply_requested = false);
+
+    /// CopyDone, the end of the stream
+    void done();
+
+    Lsn lsn() const noexcept { return lsn_; }
+    const std::vector<uint8_t> &data() const noexcept { return data_; }
+    void clear() noexcept { data_.clear(); }
+
+private:
+    void startMessage(char type);
+    void finishMessage();
+    void putTuple(Tuple tuple);
+    void put8(uint8_t value) { data_.push_back(value); }
+    void put16(uint16_t value);
+    void put32(uint32_t value);
+    void put64(uint64_t value);
+    void putString(std::string_view value);
+
+    std::vector<uint8_t> data_;
+    size_t frame_start_ = 0;
+    Lsn lsn_;
+};
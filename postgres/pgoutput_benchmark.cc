@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "parquet_sink.hpp"
+#include "pgoutput.hpp"
+
+// Change events per second from a synthetic replication stream of 200K changes to an
+// orders table (int8, int4, text, float8, timestamptz, bool) in transactions of 10:
+// decoding alone, fed whole and in chunks the size of socket reads, and decoding into
+// Parquet files through the ParquetSink.
+
+namespace
+{
+    constexpr size_t kChanges = 200000;
+    constexpr size_t kTransactionSize = 10;
+
+    const std::vector<RelationColumn> kColumns = {
+        {true, "id", 20, -1},   {false, "customer", 23, -1}, {false, "status", 25, -1},
+        {false, "total", 701, -1}, {false, "created_at", 1184, -1}, {false, "paid", 16, -1},
+    };
+
+    std::vector<uint8_t> orderStream()
+    {
+        std::mt19937_64 rng(1);
+        const char *statuses[] = {"new", "paid", "shipped", "delivered", "cancelled"};
+        PgOutputWriter writer;
+        writer.relation(16384, "public", "orders", kColumns);
+        std::vector<std::string> fields(kColumns.size());
+        std::vector<TupleValue> tuple(kColumns.size());
+        for (size_t change = 0; change < kChanges; ++change)
+        {
+            if (change % kTransactionSize == 0)
+            {
+                writer.begin(writer.lsn() + 4096, static_cast<PgTimestamp>(change * 1000), static_cast<uint32_t>(change));
+            }
+            fields[0] = std::to_string(change);
+            fields[1] = std::to_string(rng() % 100000);
+            fields[2] = statuses[rng() % 5];
+            fields[3] = std::to_string(static_cast<double>(rng() % 1000000) / 100);
+            fields[4] = "2024-05-17 10:" + std::to_string(10 + rng() % 50) + ":" + std::to_string(10 + rng() % 50) +
+                        "." + std::to_string(100000 + rng() % 900000) + "+00";
+            fields[5] = rng() % 2 ? "t" : "f";
+            for (size_t i = 0; i < fields.size(); ++i)
+            {
+                tuple[i] = {TupleValue::kText, fields[i]};
+            }
+            if (change % 4 == 3)
+            {
+                writer.update(16384, tuple);
+            }
+            else
+            {
+                writer.insert(16384, tuple);
+            }
+            if (change % kTransactionSize == kTransactionSize - 1)
+            {
+                writer.commit(writer.lsn(), writer.lsn() + 64, static_cast<PgTimestamp>(change * 1000));
+            }
+        }
+        writer.done();
+        return writer.data();
+    }
+
+    const std::vector<uint8_t> &stream()
+    {
+        static const std::vector<uint8_t> data = orderStream();
+        return data;
+    }
+
+    class CountingHandler : public ReplicationHandler
+    {
+    public:
+        void onInsert(const InsertMessage &message) override { values += message.tuple.size(); }
+        void onUpdate(const UpdateMessage &message) override { values += message.new_tuple.size(); }
+
+        size_t values = 0;
+    };
+} // namespace
+
+static void BM_Decode(benchmark::State &state)
+{
+    const std::vector<uint8_t> &data = stream();
+    auto chunk = state.range(0) > 0 ? static_cast<size_t>(state.range(0)) : data.size();
+    for (auto _ : state)
+    {
+        CountingHandler handler;
+        PgOutputDecoder decoder(handler);
+        for (size_t offset = 0; offset < data.size(); offset += chunk)
+        {
+            decoder.feed(data.data() + offset, std::min(chunk, data.size() - offset));
+        }
+        decoder.finish();
+        benchmark::DoNotOptimize(handler.values);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(kChanges) * state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(data.size()) * state.iterations());
+}
+BENCHMARK(BM_Decode)->ArgName("chunk")->Arg(0)->Arg(64 * 1024)->Arg(4096)->Unit(benchmark::kMillisecond);
+
+static void BM_DecodeToParquet(benchmark::State &state)
+{
+    const std::vector<uint8_t> &data = stream();
+    std::string directory = std::filesystem::temp_directory_path() / "pgoutput_benchmark";
+    std::filesystem::create_directories(directory);
+    for (auto _ : state)
+    {
+        ParquetSink sink(directory);
+        PgOutputDecoder decoder(sink);
+        decoder.feed(data.data(), data.size());
+        sink.close();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(kChanges) * state.iterations());
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_DecodeToParquet)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
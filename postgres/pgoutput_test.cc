@@ -0,0 +1,362 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "formats/parquet_reader.hpp"
+#include "parquet_sink.hpp"
+#include "pgoutput.hpp"
+
+namespace
+{
+    std::string tempPath(const std::string &name)
+    {
+        return testing::TempDir() + "/" + name;
+    }
+
+    TupleValue text(std::string_view data)
+    {
+        return {TupleValue::kText, data};
+    }
+
+    TupleValue binary(std::string_view data)
+    {
+        return {TupleValue::kBinary, data};
+    }
+
+    constexpr TupleValue kNull = {TupleValue::kNull, {}};
+    constexpr TupleValue kUnchanged = {TupleValue::kUnchanged, {}};
+
+    std::string describe(Tuple tuple)
+    {
+        std::string result = "(";
+        for (const TupleValue &value : tuple)
+        {
+            result += value.kind == TupleValue::kText ? std::string(value.data) : std::string(1, value.kind);
+            result += ",";
+        }
+        return result + ")";
+    }
+
+    /// Logs every message as a line of text
+    class RecordingHandler : public ReplicationHandler
+    {
+    public:
+        void onBegin(const BeginMessage &m) override
+        {
+            log += "B " + std::to_string(m.final_lsn) + " " + std::to_string(m.commit_time) + " " +
+                   std::to_string(m.xid) + "\n";
+        }
+        void onCommit(const CommitMessage &m) override
+        {
+            log += "C " + std::to_string(m.commit_lsn) + " " + std::to_string(m.end_lsn) + "\n";
+        }
+        void onRelation(const RelationMessage &m) override
+        {
+            log += "R " + std::to_string(m.oid) + " " + std::string(m.namespace_name) + "." + std::string(m.name) +
+                   " " + m.replica_identity;
+            for (const RelationColumn &column : m.columns)
+            {
+                log += " " + std::string(column.name) + ":" + std::to_string(column.type_oid) + (column.key ? "*" : "");
+            }
+            log += "\n";
+        }
+        void onInsert(const InsertMessage &m) override
+        {
+            log += "I " + std::to_string(m.relation) + " " + describe(m.tuple) + "\n";
+        }
+        void onUpdate(const UpdateMessage &m) override
+        {
+            log += "U " + std::to_string(m.relation) + " " + (m.old_kind ? std::string(1, m.old_kind) : "-") + " " +
+                   describe(m.old_tuple) + " " + describe(m.new_tuple) + "\n";
+        }
+        void onDelete(const DeleteMessage &m) override
+        {
+            log += "D " + std::to_string(m.relation) + " " + m.old_kind + " " + describe(m.old_tuple) + "\n";
+        }
+        void onTruncate(const TruncateMessage &m) override
+        {
+            log += "T " + std::to_string(m.options);
+            for (uint32_t relation : m.relations)
+            {
+                log += " " + std::to_string(relation);
+            }
+            log += "\n";
+        }
+        void onKeepalive(Lsn wal_end, bool reply_requested) override
+        {
+            log += "K " + std::to_string(wal_end) + " " + (reply_requested ? "1" : "0") + "\n";
+        }
+
+        std::string log;
+    };
+
+    const std::vector<RelationColumn> kUsers = {
+        {true, "id", 23, -1},
+        {false, "name", 25, -1},
+        {false, "score", 701, -1},
+    };
+
+    PgOutputWriter sampleStream()
+    {
+        PgOutputWriter writer(1000);
+        writer.begin(5000, 42, 7);
+        writer.relation(16384, "public", "users", kUsers);
+        TupleValue ada[] = {text("1"), text("ada"), text("2.5")};
+        TupleValue bob[] = {text("2"), kNull, text("-1")};
+        TupleValue bob_key[] = {text("2"), kNull, kNull};
+        TupleValue renamed[] = {text("3"), kUnchanged, binary(std::string_view("\0\0", 2))};
+        writer.insert(16384, ada);
+        writer.insert(16384, bob);
+        writer.update(16384, renamed, 'K', bob_key);
+        writer.remove(16384, 'K', bob_key);
+        uint32_t truncated[] = {16384, 16390};
+        writer.truncate(truncated, 1);
+        writer.keepalive(6000, true);
+        writer.commit(5000, 5100, 42);
+        writer.done();
+        return writer;
+    }
+
+    const char *kSampleLog = "B 5000 42 7\n"
+                             "R 16384 public.users d id:23* name:25 score:701\n"
+                             "I 16384 (1,ada,2.5,)\n"
+                             "I 16384 (2,n,-1,)\n"
+                             "U 16384 K (2,n,n,) (3,u,b,)\n"
+                             "D 16384 K (2,n,n,)\n"
+                             "T 1 16384 16390\n"
+                             "K 6000 1\n"
+                             "C 5000 5100\n";
+} // namespace
+
+TEST(PgOutputDecoderTest, DecodesEveryMessageInAnyChunking)
+{
+    PgOutputWriter writer = sampleStream();
+    const std::vector<uint8_t> &stream = writer.data();
+
+    for (size_t chunk : {stream.size(), size_t(1), size_t(7), size_t(64)})
+    {
+        RecordingHandler handler;
+        PgOutputDecoder decoder(handler);
+        for (size_t offset = 0; offset < stream.size(); offset += chunk)
+        {
+            decoder.feed(stream.data() + offset, std::min(chunk, stream.size() - offset));
+        }
+        decoder.finish();
+        EXPECT_EQ(handler.log, kSampleLog) << chunk;
+        EXPECT_TRUE(decoder.done());
+        EXPECT_EQ(decoder.messageCount(), 8u);
+        EXPECT_EQ(decoder.walEnd(), std::max<Lsn>(writer.lsn(), 6000));
+    }
+
+    // A recorded stream file, with garbage after CopyDone
+    std::string path = tempPath("stream.bin");
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char *>(stream.data()), static_cast<std::streamsize>(stream.size()));
+        file << "ignored";
+    }
+    RecordingHandler handler;
+    PgOutputDecoder decoder(handler);
+    decodeStreamFile(path, decoder);
+    EXPECT_EQ(handler.log, kSampleLog);
+    std::remove(path.c_str());
+    EXPECT_THROW(decodeStreamFile(path, decoder), std::system_error);
+}
+
+TEST(PgOutputDecoderTest, RejectsMalformedStreams)
+{
+    PgOutputWriter writer = sampleStream();
+    std::vector<uint8_t> stream = writer.data();
+    RecordingHandler handler;
+
+    // Cut in the middle of a frame
+    PgOutputDecoder truncated(handler);
+    truncated.feed(stream.data(), 40);
+    EXPECT_THROW(truncated.finish(), ReplicationException);
+
+    // Not a CopyData message
+    PgOutputDecoder wrong_frame(handler);
+    uint8_t error[] = {'E', 0, 0, 0, 4};
+    EXPECT_THROW(wrong_frame.feed(error, sizeof(error)), ReplicationException);
+
+    // Messages that are cut short, have trailing bytes, or are not pgoutput v1
+    PgOutputDecoder decoder(handler);
+    uint8_t short_begin[] = {'B', 0, 0, 0};
+    EXPECT_THROW(decoder.decodeMessage(short_begin, sizeof(short_begin)), ReplicationException);
+    uint8_t long_truncate[] = {'T', 0, 0, 0, 0, 0, 1};
+    EXPECT_THROW(decoder.decodeMessage(long_truncate, sizeof(long_truncate)), ReplicationException);
+    uint8_t stream_start[] = {'S', 0, 0, 0, 1, 1};
+    EXPECT_THROW(decoder.decodeMessage(stream_start, sizeof(stream_start)), ReplicationException);
+    uint8_t bad_kind[] = {'I', 0, 0, 0, 1, 'N', 0, 1, 'x'};
+    EXPECT_THROW(decoder.decodeMessage(bad_kind, sizeof(bad_kind)), ReplicationException);
+    uint8_t unterminated[] = {'R', 0, 0, 0, 1, 'p', 'u', 'b'};
+    EXPECT_THROW(decoder.decodeMessage(unterminated, sizeof(unterminated)), ReplicationException);
+    uint8_t origin[] = {'O', 0, 0, 0, 0, 0, 0, 0, 1, 'o', 0};
+    decoder.decodeMessage(origin, sizeof(origin));
+    EXPECT_EQ(decoder.messageCount(), 1u);
+}
+
+TEST(ParquetSinkTest, WritesChangesPerTable)
+{
+    std::string directory = tempPath("sink");
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+
+    const std::vector<RelationColumn> columns = {
+        {true, "id", 20, -1},
+        {false, "flag", 16, -1},
+        {false, "small", 21, -1},
+        {false, "ratio", 700, -1},
+        {false, "day", 1082, -1},
+        {false, "at", 1184, -1},
+        {false, "blob", 17, -1},
+        {false, "note", 1043, 36},
+        {false, "amount", 1700, -1},
+    };
+    PgOutputWriter writer;
+    writer.relation(1, "public", "events", columns);
+    writer.begin(100, 1000, 1);
+    TupleValue first[] = {text("1"), text("t"), text("-7"), text("0.5"), text("2024-02-29"),
+                          text("2024-02-29 12:30:00.25+01"), text("\\xdeadBEEF"), text("hi"), text("12.50")};
+    writer.insert(1, first);
+    // Binary format: int8 2, false, int2 300, float4 1.0, date 2000-01-02, timestamptz 2000-01-01 00:00:01
+    TupleValue second[] = {binary(std::string_view("\0\0\0\0\0\0\0\2", 8)), binary(std::string_view("\0", 1)),
+                           binary("\x01\x2c"), binary(std::string_view("\x3f\x80\0\0", 4)), binary(std::string_view("\0\0\0\1", 4)),
+                           binary(std::string_view("\0\0\0\0\0\x0f\x42\x40", 8)), binary("raw"), binary("bin"),
+                           kNull};
+    writer.insert(1, second);
+    writer.commit(100, 110, 1000);
+    writer.begin(200, 2000, 2);
+    TupleValue updated[] = {text("1"), kNull, kUnchanged, kNull, kNull, kNull, kNull, text("changed"), kNull};
+    writer.update(1, updated);
+    TupleValue key[] = {text("2"), kNull, kNull, kNull, kNull, kNull, kNull, kNull, kNull};
+    writer.remove(1, 'K', key);
+    writer.commit(200, 210, 2000);
+    // ALTER TABLE events DROP COLUMN amount starts a new file
+    writer.relation(1, "public", "events", std::span(columns).first(8));
+    writer.begin(300, 3000, 3);
+    TupleValue third[] = {text("3"), kNull, kNull, kNull, kNull, kNull, kNull, kNull};
+    writer.insert(1, third);
+    uint32_t relations[] = {1};
+    writer.truncate(relations);
+    writer.commit(300, 310, 3000);
+
+    SinkOptions options;
+    options.row_group_rows = 3;
+    ParquetSink sink(directory, options);
+    PgOutputDecoder decoder(sink);
+    decoder.feed(writer.data().data(), writer.data().size());
+    EXPECT_EQ(sink.stats().transactions, 3u);
+    EXPECT_EQ(sink.stats().row_groups, 1u);
+    EXPECT_EQ(sink.bufferedRows(), 2u);
+    EXPECT_EQ(sink.flushedLsn(), 210u);
+    sink.close();
+    EXPECT_EQ(sink.flushedLsn(), 310u);
+    EXPECT_EQ(sink.stats().row_groups, 2u);
+    ASSERT_EQ(sink.files().size(), 2u);
+    EXPECT_EQ(sink.files()[0], directory + "/public.events.0.parquet");
+
+    ParquetFileReader reader(sink.files()[0]);
+    ASSERT_EQ(reader.columns().size(), 12u);
+    EXPECT_EQ(reader.columns()[9].dottedPath(), "_op");
+    EXPECT_EQ(reader.metadata().schema[6].converted_type, 10);
+    // The first transaction reached no row group on its own, so it went with the second
+    ASSERT_EQ(reader.numRowGroups(), 1u);
+    auto read = [&](ParquetFileReader &file, size_t column)
+    {
+        ColumnBatch batch(file.columns()[column].type);
+        ColumnChunkReader chunk = file.columnChunk(0, column);
+        while (chunk.readBatch(batch, kDefaultBatchSize) > 0)
+        {
+        }
+        return batch;
+    };
+
+    ColumnBatch ids = read(reader, 0);
+    ASSERT_EQ(ids.length(), 4u);
+    EXPECT_EQ(ids.value<int64_t>(1), 2);
+    ColumnBatch flags = read(reader, 1);
+    EXPECT_EQ(flags.value<uint8_t>(0), 1);
+    EXPECT_EQ(flags.value<uint8_t>(1), 0);
+    EXPECT_FALSE(flags.isValid(2));
+    ColumnBatch small = read(reader, 2);
+    EXPECT_EQ(small.value<int32_t>(0), -7);
+    EXPECT_EQ(small.value<int32_t>(1), 300);
+    EXPECT_FALSE(small.isValid(2)); // unchanged TOAST
+    ColumnBatch ratio = read(reader, 3);
+    EXPECT_EQ(ratio.value<float>(0), 0.5f);
+    EXPECT_EQ(ratio.value<float>(1), 1.0f);
+    ColumnBatch days = read(reader, 4);
+    EXPECT_EQ(days.value<int32_t>(0), 19782);
+    EXPECT_EQ(days.value<int32_t>(1), 10958);
+    ColumnBatch times = read(reader, 5);
+    EXPECT_EQ(times.value<int64_t>(0), 1709206200250000);
+    EXPECT_EQ(times.value<int64_t>(1), kPostgresEpochMicros + 1000000);
+    ColumnBatch blobs = read(reader, 6);
+    EXPECT_EQ(blobs.byteArray(0), "\xde\xad\xbe\xef");
+    EXPECT_EQ(blobs.byteArray(1), "raw");
+    ColumnBatch notes = read(reader, 7);
+    EXPECT_EQ(notes.byteArray(1), "bin");
+    EXPECT_EQ(notes.byteArray(2), "changed");
+    EXPECT_FALSE(notes.isValid(3));
+    ColumnBatch amounts = read(reader, 8);
+    EXPECT_EQ(amounts.byteArray(0), "12.50");
+    ColumnBatch ops = read(reader, 9);
+    EXPECT_EQ(ops.byteArray(0), "I");
+    EXPECT_EQ(ops.byteArray(2), "U");
+    EXPECT_EQ(ops.byteArray(3), "D");
+    ColumnBatch lsns = read(reader, 10);
+    EXPECT_EQ(lsns.value<int64_t>(1), 100);
+    EXPECT_EQ(lsns.value<int64_t>(2), 200);
+    ColumnBatch commit_times = read(reader, 11);
+    EXPECT_EQ(commit_times.value<int64_t>(3), kPostgresEpochMicros + 2000);
+
+    ParquetFileReader altered(sink.files()[1]);
+    EXPECT_EQ(altered.columns().size(), 11u);
+    ColumnBatch altered_ops = read(altered, 8);
+    ASSERT_EQ(altered_ops.length(), 2u);
+    EXPECT_EQ(altered_ops.byteArray(1), "T");
+    EXPECT_FALSE(read(altered, 0).isValid(1));
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ParquetSinkTest, RejectsBadChanges)
+{
+    std::string directory = tempPath("sink_errors");
+    std::filesystem::create_directories(directory);
+    ParquetSink sink(directory);
+    std::vector<RelationColumn> columns = {{true, "id", 23, -1}, {false, "at", 1114, -1}, {false, "j", 3802, -1}};
+    RelationMessage relation;
+    relation.oid = 5;
+    relation.namespace_name = "public";
+    relation.name = "t";
+    relation.columns = columns;
+
+    TupleValue row[] = {text("1"), text("2024-01-01 00:00:00"), text("{}")};
+    InsertMessage insert{5, row};
+    EXPECT_THROW(sink.onInsert(insert), ReplicationException);
+    sink.onRelation(relation);
+    sink.onInsert(insert);
+
+    for (TupleValue bad : {text("x"), text("2024-13-01 00:00:00"), text("2024-01-01"), text("2024-01-01 00:00:00+01")})
+    {
+        TupleValue values[] = {text("2"), bad, kNull};
+        EXPECT_THROW(sink.onInsert({5, values}), ReplicationException);
+    }
+    TupleValue overflow[] = {text("99999999999"), kNull, kNull};
+    EXPECT_THROW(sink.onInsert({5, overflow}), ReplicationException);
+    TupleValue jsonb[] = {text("3"), kNull, binary("\x01{}")};
+    EXPECT_THROW(sink.onInsert({5, jsonb}), ReplicationException);
+    TupleValue short_row[] = {text("4")};
+    EXPECT_THROW(sink.onInsert({5, short_row}), ReplicationException);
+    // The rejected rows left nothing behind
+    EXPECT_EQ(sink.bufferedRows(), 1u);
+    sink.close();
+    ParquetFileReader reader(sink.files().at(0));
+    EXPECT_EQ(reader.metadata().num_rows, 1);
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+# Runs every benchmark target under a package pattern and writes one Google Benchmark
+# JSON report per target to OUT_DIR, to be compared with compare_benchmarks.py:
+#
+#   ./run_benchmarks.sh OUT_DIR [PATTERN] [BENCHMARK_FLAGS...]
+#
+# PATTERN defaults to //...; the flags default to 5 repetitions reported as aggregates
+# (mean, median, stddev, cv). BENCHMARK_MAX_SIZE raises the largest input of the size
+# sweeps.
+set -euo pipefail
+
+if [ $# -lt 1 ]; then
+    echo "usage: $0 OUT_DIR [PATTERN] [BENCHMARK_FLAGS...]" >&2
+    exit 2
+fi
+out=$1
+pattern=${2:-//...}
+shift $(($# >= 2 ? 2 : 1))
+flags=("$@")
+if [ ${#flags[@]} -eq 0 ]; then
+    flags=(--benchmark_repetitions=5 --benchmark_report_aggregates_only=true)
+fi
+
+mkdir -p "$out"
+targets=$(bazel query "filter('_benchmark$', kind(cc_binary, $pattern))")
+bazel build -c opt $targets
+for target in $targets; do
+    name=${target#//}
+    name=${name//[:\/]/_}
+    binary=$(bazel cquery -c opt --output=files "$target" 2>/dev/null)
+    echo "Running $target" >&2
+    "$binary" --benchmark_out="$out/$name.json" --benchmark_out_format=json "${flags[@]}"
+done
@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt //basics:bplus_tree_benchmark
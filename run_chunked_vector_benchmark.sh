@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt //basics:chunked_vector_benchmark
@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt //iceberg:commit_benchmark
@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt //basics:concurrent_skip_list_benchmark
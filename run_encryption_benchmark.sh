@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt //formats:encryption_benchmark
@@ -0,0 +1,3 @@
+#!/bin/bash
+# FLAT_HASH_MAP_BENCHMARK_MAX_KEYS=100000000 extends the runs to 100M keys
+bazel run -c opt //basics:flat_hash_map_benchmark
@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt --define instrumentation=1 //formats:instrumentation_benchmark
@@ -0,0 +1,3 @@
+#!/bin/bash
+# IO_BENCHMARK_DIR selects the disk the test file is written to (default /tmp)
+bazel run -c opt //formats:io_benchmark
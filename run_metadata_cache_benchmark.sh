@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt //formats:metadata_cache_benchmark
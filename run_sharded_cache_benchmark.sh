@@ -0,0 +1,2 @@
+#!/bin/bash
+bazel run -c opt //basics:sharded_cache_benchmark
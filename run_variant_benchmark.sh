@@ -0,0 +1,3 @@
+#!/bin/bash
+# VARIANT_BENCHMARK_EVENTS sets the number of events (default 1M, ~200 bytes of JSON each)
+bazel run -c opt //formats:variant_benchmark
@@ -0,0 +1,3 @@
+#!/bin/bash
+# VARIANT_SHREDDING_BENCHMARK_EVENTS sets the number of events (default 100K, 50 fields each)
+bazel run -c opt //formats:variant_shredding_benchmark